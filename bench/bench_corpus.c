@@ -0,0 +1,15 @@
+/**
+ * @file bench_corpus.c
+ * @brief Device register maps shared by the benchmarks
+ */
+
+#include "bench_corpus.h"
+
+const uint16_t bench_power_meter[BENCH_POWER_METER_REGISTERS] = {
+    3000, 3001, 3002, 3003, 3004, 3005, 3010, 3011, 3020, 3021, 3022, 3023, 3024, 3025,
+    3028, 3029, 3036, 3037, 3054, 3055, 3056, 3057, 3058, 3059, 3060, 3061, 3076, 3077,
+    3084, 3085, 3110, 3111, 3204, 3205, 3206, 3207, 3208, 3209, 3210, 3211, 3220, 3221};
+
+const uint16_t bench_drive[BENCH_DRIVE_REGISTERS] = {
+    0,   1,   2,   3,   4,   5,   8,   9,   100, 101, 102, 103, 104, 105, 110,
+    200, 201, 202, 203, 204, 205, 206, 207, 220, 221, 222, 223, 224, 225, 226};
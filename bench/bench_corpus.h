@@ -0,0 +1,20 @@
+/**
+ * @file bench_corpus.h
+ * @brief Device register maps shared by the benchmarks
+ */
+
+#ifndef SMARTMODBUS_BENCH_CORPUS_H
+#define SMARTMODBUS_BENCH_CORPUS_H
+
+#include <stdint.h>
+
+#define BENCH_POWER_METER_REGISTERS 42
+#define BENCH_DRIVE_REGISTERS 30
+
+// Three-phase power meter: per-phase blocks with float pairs and spare words
+extern const uint16_t bench_power_meter[BENCH_POWER_METER_REGISTERS];
+
+// Variable speed drive: status words, monitoring group, fault history
+extern const uint16_t bench_drive[BENCH_DRIVE_REGISTERS];
+
+#endif  // SMARTMODBUS_BENCH_CORPUS_H
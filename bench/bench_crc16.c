@@ -0,0 +1,109 @@
+/**
+ * @file bench_crc16.c
+ * @brief CRC16 backend throughput against the baseline byte table
+ *
+ * Runs every available backend over buffers from a single RTU request up to
+ * a long gateway batch and reports bytes/cycle (rdtsc on x86, otherwise
+ * MB/s) plus the speed-up over the byte table.
+ */
+
+#include "protocol/crc16.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#endif
+
+#define BENCH_BYTES (64u * 1024u * 1024u)
+
+static uint8_t buffer[4096];
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+typedef struct {
+    double bytes_per_cycle;
+    double mb_per_s;
+    uint16_t checksum;
+} crc_result_t;
+
+static crc_result_t run_backend(size_t length) {
+    size_t iterations = BENCH_BYTES / length;
+    uint16_t acc      = 0;
+
+    double begin = now_seconds();
+#ifdef BENCH_HAVE_TSC
+    unsigned long long tsc_begin = __rdtsc();
+#endif
+    for (size_t i = 0; i < iterations; i++) {
+        // Feed the previous CRC back so calls cannot be hoisted
+        buffer[0] = (uint8_t)acc;
+        acc       = (uint16_t)(acc ^ mb_crc16(buffer, length));
+    }
+#ifdef BENCH_HAVE_TSC
+    unsigned long long tsc_end = __rdtsc();
+#endif
+    double end = now_seconds();
+
+    crc_result_t result = {0};
+    double bytes        = (double)iterations * (double)length;
+    result.mb_per_s     = bytes / (end - begin) / 1e6;
+#ifdef BENCH_HAVE_TSC
+    result.bytes_per_cycle = bytes / (double)(tsc_end - tsc_begin);
+#endif
+    result.checksum = acc;
+    return result;
+}
+
+int main(void) {
+    static const struct {
+        mb_crc16_backend_t backend;
+        const char *name;
+    } backends[] = {
+        {MB_CRC16_BACKEND_TABLE, "table"},
+        {MB_CRC16_BACKEND_SLICE4, "slice-by-4"},
+        {MB_CRC16_BACKEND_SLICE8, "slice-by-8"},
+        {MB_CRC16_BACKEND_CLMUL, "clmul"},
+    };
+    static const size_t lengths[] = {6, 8, 64, 256, 4096};
+
+    for (size_t i = 0; i < sizeof(buffer); i++) {
+        buffer[i] = (uint8_t)(i * 131u + 7u);
+    }
+
+    printf("%-12s %6s | %10s %10s %8s\n", "backend", "bytes",
+#ifdef BENCH_HAVE_TSC
+           "bytes/cyc",
+#else
+           "-",
+#endif
+           "MB/s", "speedup");
+
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+        double baseline = 0.0;
+
+        for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+            if (mb_crc16_set_backend(backends[b].backend) != 0) {
+                printf("%-12s %6zu | not available\n", backends[b].name, lengths[l]);
+                continue;
+            }
+
+            crc_result_t r = run_backend(lengths[l]);
+            if (backends[b].backend == MB_CRC16_BACKEND_TABLE) {
+                baseline = r.mb_per_s;
+            }
+
+            printf("%-12s %6zu | %10.3f %10.1f %7.2fx  (%04X)\n", backends[b].name, lengths[l],
+                   r.bytes_per_cycle, r.mb_per_s, baseline > 0.0 ? r.mb_per_s / baseline : 0.0,
+                   r.checksum);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,291 @@
+/**
+ * @file bench_latency.c
+ * @brief End-to-end poll cycle time against simulated slaves
+ *
+ * Polls a meter, a drive and a PLC on one simulated bus (see sim_slave.h)
+ * and reports the p50/p99 cycle time of mb_master_read_optimized() with
+ * each planner for a sweep of latency_chars values, next to the naive
+ * baseline of one mb_master_read_single() per contiguous block. Times are
+ * virtual: they follow from the baud rate, turnaround, jitter and loss
+ * settings, so the figures are what the line would show, and a run takes
+ * milliseconds.
+ *
+ *   bench_latency [--tcp|--ascii] [--baud N] [--turnaround US] [--jitter US]
+ *                 [--loss PERMILLE] [--exceptions PERMILLE] [--cycles N]
+ *                 [--gap CHARS] [--latency CHARS] [--csv]
+ */
+
+#include "bench_corpus.h"
+#include "sim_slave.h"
+#include "utils/block_utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_MAX_CYCLES 100000
+#define BENCH_DEVICES 3
+
+typedef struct {
+    const char *name;
+    uint8_t slave_id;
+    uint8_t fc;
+    const uint16_t *addresses;
+    uint16_t address_count;
+} device_t;
+
+typedef struct {
+    double p50_us;
+    double p99_us;
+    double mean_us;
+    double rounds;
+    uint32_t failed;
+    uint32_t wrong;
+} cycle_result_t;
+
+// PLC data block with scattered flags and counters
+static const uint16_t plc[] = {400, 402, 404, 406, 410, 411, 412, 413, 430, 431, 460,
+                               461, 462, 463, 464, 465, 466, 467, 500, 540, 541, 580};
+
+static const device_t devices[BENCH_DEVICES] = {
+    {"meter", 1, MB_FC_READ_HOLDING_REGISTERS, bench_power_meter, BENCH_POWER_METER_REGISTERS},
+    {"drive", 2, MB_FC_READ_HOLDING_REGISTERS, bench_drive, BENCH_DRIVE_REGISTERS},
+    {"plc", 3, MB_FC_READ_INPUT_REGISTERS, plc, sizeof(plc) / sizeof(plc[0])},
+};
+
+static sim_slave_t slaves[BENCH_DEVICES];
+static uint64_t cycle_us[BENCH_MAX_CYCLES];
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/**
+ * @brief Read one device the naive way: one request per contiguous block
+ */
+static int read_naive(mb_master_t *master, const device_t *device, uint16_t *data) {
+    mb_block_t blocks[64];
+    uint16_t block_count = 0;
+    int result = mb_addresses_to_blocks(device->addresses, device->address_count,
+                                        device->slave_id, device->fc, blocks, 64, &block_count);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    // Addresses are sorted, so blocks fill data in order
+    uint16_t pos = 0;
+    for (uint16_t b = 0; b < block_count; b++) {
+        result = mb_master_read_single(master, device->slave_id, device->fc,
+                                       blocks[b].start_address, blocks[b].quantity, &data[pos]);
+        if (result != MB_SUCCESS) {
+            return result;
+        }
+        pos = (uint16_t)(pos + blocks[b].quantity);
+    }
+    return MB_SUCCESS;
+}
+
+static bool values_match(const device_t *device, const uint16_t *data) {
+    for (uint16_t i = 0; i < device->address_count; i++) {
+        uint16_t expected = (uint16_t)(device->addresses[i] * 7u + device->slave_id);
+        if (data[i] != expected) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Run poll cycles over all devices
+ * @param naive true for per-block reads, false for optimized reads
+ */
+static int run_cycles(const sim_config_t *sim,
+                      uint8_t gap_chars,
+                      uint8_t latency_chars,
+                      mb_planner_t planner,
+                      bool naive,
+                      uint32_t cycles,
+                      cycle_result_t *out) {
+    static sim_bus_t bus;
+    sim_bus_init(&bus, sim);
+    for (uint8_t d = 0; d < BENCH_DEVICES; d++) {
+        const device_t *device = &devices[d];
+        sim_bus_add_slave(&bus, &slaves[d], device->slave_id);
+
+        // Readable over the device's whole span, so merged reads never fault
+        uint16_t first = device->addresses[0];
+        uint16_t last  = device->addresses[device->address_count - 1];
+        sim_slave_map(&slaves[d], first, (uint16_t)(last - first + 1));
+    }
+
+    mb_config_t config   = mb_config_default(sim->mode);
+    config.transport     = sim_bus_transport(&bus);
+    config.gap_chars     = gap_chars;
+    config.latency_chars = latency_chars;
+    config.timeout_ms    = sim->timeout_us / 1000u;
+    config.planner       = planner;
+
+    mb_master_t master;
+    int result = mb_master_init(&master, &config);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    memset(out, 0, sizeof(*out));
+    uint64_t total_us = 0;
+    for (uint32_t c = 0; c < cycles; c++) {
+        uint64_t start = sim_bus_now(&bus);
+
+        for (uint8_t d = 0; d < BENCH_DEVICES; d++) {
+            const device_t *device = &devices[d];
+            uint16_t data[64];
+            mb_read_request_t request = {
+                .slave_id      = device->slave_id,
+                .function_code = device->fc,
+                .addresses     = (uint16_t *)device->addresses,
+                .address_count = device->address_count,
+            };
+
+            result = naive ? read_naive(&master, device, data)
+                           : mb_master_read_optimized(&master, &request, data, 64);
+            if (result != MB_SUCCESS) {
+                out->failed++;
+            } else if (!values_match(device, data)) {
+                out->wrong++;
+            }
+        }
+
+        cycle_us[c] = sim_bus_now(&bus) - start;
+        total_us   += cycle_us[c];
+    }
+
+    mb_stats_t stats;
+    mb_master_get_stats(&master, &stats);
+    mb_master_cleanup(&master);
+
+    qsort(cycle_us, cycles, sizeof(cycle_us[0]), compare_u64);
+    out->p50_us  = (double)cycle_us[(cycles - 1) * 50u / 100u];
+    out->p99_us  = (double)cycle_us[(cycles - 1) * 99u / 100u];
+    out->mean_us = (double)total_us / cycles;
+    out->rounds  = (double)stats.total_requests / cycles;
+    return MB_SUCCESS;
+}
+
+static void print_result(bool csv, const char *label, int latency, const cycle_result_t *r) {
+    if (csv) {
+        printf("%s,%d,%.1f,%.0f,%.0f,%.0f,%u,%u\n", label, latency, r->rounds, r->p50_us,
+               r->p99_us, r->mean_us, r->failed, r->wrong);
+    } else {
+        printf("%-10s %8d | %6.1f %10.2f %10.2f %10.2f | %6u %6u\n", label, latency, r->rounds,
+               r->p50_us / 1000.0, r->p99_us / 1000.0, r->mean_us / 1000.0, r->failed, r->wrong);
+    }
+}
+
+static unsigned long parse_number(const char *arg) {
+    return arg != NULL ? strtoul(arg, NULL, 10) : 0;
+}
+
+int main(int argc, char **argv) {
+    mb_mode_t mode = MB_MODE_RTU;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--tcp") == 0) {
+            mode = MB_MODE_TCP;
+        } else if (strcmp(argv[i], "--ascii") == 0) {
+            mode = MB_MODE_ASCII;
+        }
+    }
+
+    sim_config_t sim     = sim_config_default(mode);
+    mb_config_t defaults = mb_config_default(mode);
+    uint32_t cycles      = 2000;
+    int gap_chars        = defaults.gap_chars;
+    int latency_chars    = -1;
+    bool csv             = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--baud") == 0) {
+            sim.baud = (uint32_t)parse_number(value);
+            i++;
+        } else if (strcmp(argv[i], "--turnaround") == 0) {
+            sim.turnaround_us = (uint32_t)parse_number(value);
+            i++;
+        } else if (strcmp(argv[i], "--jitter") == 0) {
+            sim.jitter_us = (uint32_t)parse_number(value);
+            i++;
+        } else if (strcmp(argv[i], "--loss") == 0) {
+            sim.loss_permille = (uint16_t)parse_number(value);
+            i++;
+        } else if (strcmp(argv[i], "--exceptions") == 0) {
+            sim.exception_permille = (uint16_t)parse_number(value);
+            i++;
+        } else if (strcmp(argv[i], "--cycles") == 0) {
+            cycles = (uint32_t)parse_number(value);
+            i++;
+        } else if (strcmp(argv[i], "--gap") == 0) {
+            gap_chars = (int)parse_number(value);
+            i++;
+        } else if (strcmp(argv[i], "--latency") == 0) {
+            latency_chars = (int)parse_number(value);
+            i++;
+        } else if (strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        }
+    }
+
+    if (sim.baud == 0 || cycles == 0 || cycles > BENCH_MAX_CYCLES || gap_chars > 255 ||
+        latency_chars > 255) {
+        fprintf(stderr, "invalid arguments (cycles 1..%d, chars 0..255, baud > 0)\n",
+                BENCH_MAX_CYCLES);
+        return 1;
+    }
+
+    if (csv) {
+        printf("planner,latency_chars,rounds,p50_us,p99_us,mean_us,failed,wrong\n");
+    } else {
+        printf("%s %lu baud, turnaround %lu us, jitter %lu us, loss %u/1000, exceptions "
+               "%u/1000, gap_chars %d, %lu cycles\n\n",
+               mode == MB_MODE_TCP ? "TCP" : (mode == MB_MODE_ASCII ? "ASCII" : "RTU"),
+               (unsigned long)sim.baud, (unsigned long)sim.turnaround_us,
+               (unsigned long)sim.jitter_us, sim.loss_permille, sim.exception_permille, gap_chars,
+               (unsigned long)cycles);
+        printf("%-10s %8s | %6s %10s %10s %10s | %6s %6s\n", "planner", "latency", "rounds",
+               "p50 ms", "p99 ms", "mean ms", "failed", "wrong");
+    }
+
+    cycle_result_t r;
+    int result = run_cycles(&sim, (uint8_t)gap_chars, (uint8_t)defaults.latency_chars,
+                            MB_PLANNER_GREEDY, true, cycles, &r);
+    if (result != MB_SUCCESS) {
+        fprintf(stderr, "naive run failed (%d)\n", result);
+        return 1;
+    }
+    print_result(csv, "per-block", defaults.latency_chars, &r);
+
+    // Without --latency, sweep the setting the cost model is most sensitive to
+    static const int sweep[]      = {0, 2, 8, 16, 32, 64, 128};
+    const mb_planner_t planners[] = {MB_PLANNER_GREEDY, MB_PLANNER_OPTIMAL};
+    const char *planner_names[]   = {"greedy", "optimal"};
+    size_t sweep_count = latency_chars >= 0 ? 1 : sizeof(sweep) / sizeof(sweep[0]);
+    for (size_t p = 0; p < 2; p++) {
+        for (size_t s = 0; s < sweep_count; s++) {
+            int latency = latency_chars >= 0 ? latency_chars : sweep[s];
+            result      = run_cycles(&sim, (uint8_t)gap_chars, (uint8_t)latency, planners[p],
+                                     false, cycles, &r);
+            if (result != MB_SUCCESS) {
+                fprintf(stderr, "optimized run failed (%d)\n", result);
+                return 1;
+            }
+            print_result(csv, planner_names[p], latency, &r);
+        }
+    }
+
+    if (!csv) {
+        printf("\nrounds: requests per cycle; failed: device reads that returned an error "
+               "(lost or\nexception responses); wrong: reads that returned other values than "
+               "the slave holds.\n");
+    }
+    return 0;
+}
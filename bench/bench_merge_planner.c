@@ -0,0 +1,155 @@
+/**
+ * @file bench_merge_planner.c
+ * @brief Greedy gap merge + FFD vs. optimal (DP) planner
+ *
+ * Plans a set of representative device register maps with both planners and
+ * reports round-trips, total round-trip characters, plans that exceed the
+ * FC quantity limit, and planning time.
+ */
+
+#include "bench_corpus.h"
+#include "core/char_model.h"
+#include "core/fc_policy.h"
+#include "master/request_optimizer.h"
+#include "smartmodbus/smartmodbus.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ITERATIONS 2000
+
+typedef struct {
+    const char *name;
+    uint8_t function_code;
+    const uint16_t *addresses;
+    uint16_t address_count;
+} register_map_t;
+
+// PLC data blocks sitting just around the 125-register request limit
+static uint16_t plc_blocks[260];
+
+// Sparse alarm coils scattered over two I/O cards
+static const uint16_t alarm_coils[] = {0,   1,   2,   3,   9,   17,  18,  40,  41,  42,
+                                       64,  90,  255, 256, 300, 301, 302, 303, 700, 701,
+                                       702, 703, 704, 900, 1200, 1201, 1800, 1990};
+
+// Building controller with evenly strided setpoints
+static uint16_t strided[96];
+
+static void init_generated_maps(void) {
+    uint16_t n = 0;
+
+    // 120 + 10 with a 3-register hole, then the same pattern at 300
+    for (uint16_t a = 0; a < 120; a++) {
+        plc_blocks[n++] = a;
+    }
+    for (uint16_t a = 123; a < 133; a++) {
+        plc_blocks[n++] = a;
+    }
+    for (uint16_t a = 300; a < 420; a++) {
+        plc_blocks[n++] = a;
+    }
+    for (uint16_t a = 425; a < 435; a++) {
+        plc_blocks[n++] = a;
+    }
+
+    for (uint16_t i = 0; i < 96; i++) {
+        strided[i] = (uint16_t)(1000 + i * 5);
+    }
+}
+
+typedef struct {
+    uint16_t plans;
+    uint32_t chars;
+    uint16_t over_limit;
+    double us_per_plan;
+} planner_result_t;
+
+static int run_planner(const register_map_t *map,
+                       mb_mode_t mode,
+                       mb_planner_t planner,
+                       planner_result_t *out) {
+    mb_config_t config = mb_config_default(mode);
+    config.planner     = planner;
+
+    mb_read_request_t request = {.slave_id      = 1,
+                                 .function_code = map->function_code,
+                                 .addresses     = (uint16_t *)map->addresses,
+                                 .address_count = map->address_count};
+
+    mb_request_plan_t plans[64];
+    uint16_t plan_count = 0;
+
+    clock_t begin = clock();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        int ret = mb_optimize_request(&request, &config, plans, 64, &plan_count, NULL, NULL);
+        if (ret != MB_SUCCESS) {
+            return ret;
+        }
+    }
+    clock_t end = clock();
+
+    mb_cost_params_t cost_params;
+    (void)mb_init_cost_params(mode, map->function_code, config.latency_chars, &cost_params);
+
+    mb_pdu_t pdus[64];
+    uint16_t max_quantity = mb_fc_get_max_quantity(map->function_code);
+
+    out->over_limit = 0;
+    for (uint16_t i = 0; i < plan_count; i++) {
+        pdus[i].slave_id      = plans[i].slave_id;
+        pdus[i].function_code = plans[i].function_code;
+        pdus[i].start_address = plans[i].start_address;
+        pdus[i].quantity      = plans[i].quantity;
+        if (plans[i].quantity > max_quantity) {
+            out->over_limit++;
+        }
+    }
+
+    out->plans       = plan_count;
+    out->chars       = mb_calc_plan_cost(pdus, plan_count, &cost_params);
+    out->us_per_plan = (double)(end - begin) * 1e6 / CLOCKS_PER_SEC / BENCH_ITERATIONS;
+    return MB_SUCCESS;
+}
+
+int main(void) {
+    init_generated_maps();
+
+    const register_map_t maps[] = {
+        {"power meter (FC03)", MB_FC_READ_HOLDING_REGISTERS, bench_power_meter,
+         BENCH_POWER_METER_REGISTERS},
+        {"drive (FC03)", MB_FC_READ_HOLDING_REGISTERS, bench_drive, BENCH_DRIVE_REGISTERS},
+        {"PLC blocks (FC03)", MB_FC_READ_HOLDING_REGISTERS, plc_blocks, 260},
+        {"alarm coils (FC01)", MB_FC_READ_COILS, alarm_coils,
+         (uint16_t)(sizeof(alarm_coils) / sizeof(alarm_coils[0]))},
+        {"strided setpoints (FC04)", MB_FC_READ_INPUT_REGISTERS, strided, 96},
+    };
+    const mb_mode_t modes[] = {MB_MODE_RTU, MB_MODE_TCP};
+    const char *mode_names[] = {"RTU", "TCP"};
+
+    printf("%-26s %-4s | %6s %7s %5s %8s | %6s %7s %5s %8s | %6s\n", "map", "mode", "greedy",
+           "chars", "over", "us/plan", "dp", "chars", "over", "us/plan", "saved");
+
+    for (size_t m = 0; m < sizeof(maps) / sizeof(maps[0]); m++) {
+        for (size_t k = 0; k < sizeof(modes) / sizeof(modes[0]); k++) {
+            planner_result_t greedy;
+            planner_result_t optimal;
+
+            if (run_planner(&maps[m], modes[k], MB_PLANNER_GREEDY, &greedy) != MB_SUCCESS ||
+                run_planner(&maps[m], modes[k], MB_PLANNER_OPTIMAL, &optimal) != MB_SUCCESS) {
+                printf("%-26s %-4s | planning failed\n", maps[m].name, mode_names[k]);
+                continue;
+            }
+
+            printf("%-26s %-4s | %6u %7lu %5u %8.2f | %6u %7lu %5u %8.2f | %6ld\n", maps[m].name,
+                   mode_names[k], greedy.plans, (unsigned long)greedy.chars, greedy.over_limit,
+                   greedy.us_per_plan, optimal.plans, (unsigned long)optimal.chars,
+                   optimal.over_limit, optimal.us_per_plan,
+                   (long)greedy.chars - (long)optimal.chars);
+        }
+    }
+
+    printf("\n'over' counts plans above the FC quantity limit (rejected by slaves).\n");
+    return 0;
+}
@@ -0,0 +1,354 @@
+/**
+ * @file bench_optimizer.c
+ * @brief Optimizer speed and plan quality over a corpus of device maps
+ *
+ * Replays representative register maps (sparse meters, dense PLC data
+ * blocks, coil-heavy I/O, a 20k-tag plant) through mb_optimize_batch() with
+ * each planner and reports, per call: time, heap allocations, arena peak,
+ * round-trips, characters on the wire, cost-model characters and gap bytes
+ * read without being requested. `--csv` prints the same figures in a form
+ * that can be diffed against a previous run.
+ */
+
+#include "bench_corpus.h"
+#include "core/char_model.h"
+#include "core/fc_policy.h"
+#include "master/request_optimizer.h"
+#include "smartmodbus/smartmodbus.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MAX_TAGS 20000
+#define BENCH_MIN_ITERATIONS 5
+#define BENCH_TAG_ITERATIONS 400000u
+
+#ifdef BENCH_COUNT_ALLOCS
+// Linked with --wrap=malloc/free: every heap allocation of the library
+// passes through here
+void *__real_malloc(size_t size);
+void __real_free(void *ptr);
+
+static unsigned long heap_allocations = 0;
+
+void *__wrap_malloc(size_t size) {
+    heap_allocations++;
+    return __real_malloc(size);
+}
+
+void __wrap_free(void *ptr) {
+    __real_free(ptr);
+}
+#endif
+
+typedef struct {
+    const char *name;
+    mb_tag_t *tags;
+    uint16_t tag_count;
+} device_map_t;
+
+typedef struct {
+    uint16_t rounds;
+    uint32_t wire_chars;
+    uint32_t cost_chars;
+    uint32_t gap_bytes;
+    double us_per_call;
+    double allocs_per_call;
+    size_t arena_peak;
+} bench_result_t;
+
+static mb_tag_t meters[16 * BENCH_POWER_METER_REGISTERS];
+static mb_tag_t drives[12 * BENCH_DRIVE_REGISTERS];
+static mb_tag_t plc[2000];
+static mb_tag_t io[BENCH_MAX_TAGS];
+static mb_tag_t plant[BENCH_MAX_TAGS];
+
+static mb_request_plan_t plans[BENCH_MAX_TAGS];
+static mb_scatter_entry_t scatter[BENCH_MAX_TAGS];
+static uint64_t requested[65536 / 64];
+
+static uint32_t lcg_state = 0x2545F491u;
+
+static uint32_t lcg_next(uint32_t range) {
+    lcg_state = lcg_state * 1103515245u + 12345u;
+    return (lcg_state >> 8) % range;
+}
+
+static void add_tag(mb_tag_t *tags, uint16_t *count, uint8_t slave_id, uint8_t fc, uint32_t address) {
+    if (address < 0x10000u) {
+        tags[*count].slave_id      = slave_id;
+        tags[*count].function_code = fc;
+        tags[*count].address       = (uint16_t)address;
+        (*count)++;
+    }
+}
+
+static uint16_t build_meters(void) {
+    uint16_t n = 0;
+    for (uint8_t slave = 1; slave <= 16; slave++) {
+        for (size_t i = 0; i < BENCH_POWER_METER_REGISTERS; i++) {
+            add_tag(meters, &n, slave, MB_FC_READ_HOLDING_REGISTERS, bench_power_meter[i]);
+        }
+    }
+    return n;
+}
+
+static uint16_t build_drives(void) {
+    uint16_t n = 0;
+    for (uint8_t slave = 20; slave < 32; slave++) {
+        for (size_t i = 0; i < BENCH_DRIVE_REGISTERS; i++) {
+            add_tag(drives, &n, slave, MB_FC_READ_INPUT_REGISTERS, bench_drive[i]);
+        }
+    }
+    return n;
+}
+
+static uint16_t build_plc(void) {
+    // Four data blocks of 480 registers, a spare word every 37
+    uint16_t n = 0;
+    for (uint32_t db = 0; db < 4; db++) {
+        for (uint32_t offset = 0; offset < 480; offset++) {
+            if (offset % 37 != 36) {
+                add_tag(plc, &n, 1, MB_FC_READ_HOLDING_REGISTERS, db * 1000 + offset);
+            }
+        }
+    }
+    return n;
+}
+
+static uint16_t build_io(void) {
+    // Remote I/O rack: 60 % of 8192 outputs, 30 % of 4096 inputs in use
+    uint16_t n = 0;
+    for (uint32_t a = 0; a < 8192; a++) {
+        if (lcg_next(100) < 60) {
+            add_tag(io, &n, 2, MB_FC_READ_COILS, a);
+        }
+    }
+    for (uint32_t a = 0; a < 4096; a++) {
+        if (lcg_next(100) < 30) {
+            add_tag(io, &n, 2, MB_FC_READ_DISCRETE_INPUTS, 10000 + a);
+        }
+    }
+    return n;
+}
+
+static uint16_t build_plant(void) {
+    // 32 devices, every fourth a coil-based I/O node; runs of 1..20 units
+    // separated by holes of up to 40
+    uint16_t n = 0;
+    for (uint8_t slave = 1; slave <= 32; slave++) {
+        uint8_t fc       = slave % 4 == 0 ? MB_FC_READ_COILS : MB_FC_READ_HOLDING_REGISTERS;
+        uint32_t address = lcg_next(4000);
+        uint16_t target  = (uint16_t)(slave * (BENCH_MAX_TAGS / 32));
+
+        while (n < target && address < 0x10000u) {
+            uint32_t run = 1 + lcg_next(20);
+            for (uint32_t i = 0; i < run && n < target; i++) {
+                add_tag(plant, &n, slave, fc, address++);
+            }
+            address += lcg_next(41);
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Requested units of one plan's (slave, FC) group inside the plan
+ */
+static uint32_t covered_units(const mb_request_plan_t *plan) {
+    uint32_t units = 0;
+    for (uint32_t a = plan->start_address; a < (uint32_t)plan->start_address + plan->quantity; a++) {
+        units += (uint32_t)(requested[a / 64] >> (a % 64)) & 1u;
+    }
+    return units;
+}
+
+/**
+ * @brief Wire characters and gap bytes of a plan set
+ */
+static void measure_plans(const device_map_t *map,
+                          mb_mode_t mode,
+                          uint16_t plan_count,
+                          const mb_config_t *config,
+                          bench_result_t *out) {
+    out->rounds     = plan_count;
+    out->wire_chars = 0;
+    out->cost_chars = 0;
+    out->gap_bytes  = 0;
+
+    for (uint16_t p = 0; p < plan_count; p++) {
+        const mb_request_plan_t *plan = &plans[p];
+        bool bits                     = mb_fc_get_unit_size(plan->function_code) == 1;
+        uint32_t data_bytes = bits ? (uint32_t)(plan->quantity + 7) / 8 : (uint32_t)plan->quantity * 2;
+
+        out->wire_chars += mb_calc_overhead_chars(mode, plan->function_code, 0, 0) + data_bytes;
+        out->cost_chars += mb_calc_overhead_chars(mode, plan->function_code, config->gap_chars,
+                                                  config->latency_chars) +
+                           data_bytes;
+
+        // Requested set of this plan's group
+        memset(requested, 0, sizeof(requested));
+        for (uint16_t i = 0; i < map->tag_count; i++) {
+            if (map->tags[i].slave_id == plan->slave_id &&
+                map->tags[i].function_code == plan->function_code) {
+                requested[map->tags[i].address / 64] |= 1ULL << (map->tags[i].address % 64);
+            }
+        }
+
+        uint32_t units      = covered_units(plan);
+        uint32_t need_bytes = bits ? (units + 7) / 8 : units * 2;
+        out->gap_bytes += data_bytes > need_bytes ? data_bytes - need_bytes : 0;
+    }
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int run_map(const device_map_t *map, mb_mode_t mode, mb_planner_t planner, bench_result_t *out) {
+    mb_config_t config = mb_config_default(mode);
+    config.planner     = planner;
+
+    uint32_t iterations = BENCH_TAG_ITERATIONS / map->tag_count;
+    if (iterations < BENCH_MIN_ITERATIONS) {
+        iterations = BENCH_MIN_ITERATIONS;
+    }
+
+    uint16_t plan_count = 0;
+
+    // Heap path: what an application without an arena pays per call
+#ifdef BENCH_COUNT_ALLOCS
+    unsigned long allocs_before = heap_allocations;
+#endif
+    double begin = now_seconds();
+    for (uint32_t i = 0; i < iterations; i++) {
+        int ret = mb_optimize_batch(map->tags, map->tag_count, &config, plans, BENCH_MAX_TAGS,
+                                    &plan_count, scatter, NULL);
+        if (ret != MB_SUCCESS) {
+            return ret;
+        }
+    }
+    double end = now_seconds();
+
+    out->us_per_call = (end - begin) * 1e6 / iterations;
+#ifdef BENCH_COUNT_ALLOCS
+    out->allocs_per_call = (double)(heap_allocations - allocs_before) / iterations;
+#else
+    out->allocs_per_call = -1.0;
+#endif
+
+    // Arena path: peak working memory of one call
+    size_t arena_size = mb_optimize_batch_scratch_size(map->tag_count);
+    void *arena       = malloc(arena_size);
+    if (arena == NULL) {
+        return MB_ERROR_OUT_OF_MEMORY;
+    }
+    mb_scratch_t scratch;
+    mb_scratch_init(&scratch, arena, arena_size);
+    int ret = mb_optimize_batch(map->tags, map->tag_count, &config, plans, BENCH_MAX_TAGS,
+                                &plan_count, scatter, &scratch);
+    out->arena_peak = scratch.high_water;
+    free(arena);
+    if (ret != MB_SUCCESS) {
+        return ret;
+    }
+
+    measure_plans(map, mode, plan_count, &config, out);
+    return MB_SUCCESS;
+}
+
+// Batch planning time of one map over 1, 2, 4 and 8 planner threads
+static void bench_workers(const device_map_t *map, mb_planner_t planner, const char *planner_name) {
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    config.planner     = planner;
+
+    double serial_us = 0.0;
+    for (uint8_t threads = 1; threads <= 8; threads = (uint8_t)(threads * 2)) {
+        config.planner_threads = threads;
+        uint16_t plan_count    = 0;
+
+        double begin = now_seconds();
+        for (uint32_t i = 0; i < BENCH_MIN_ITERATIONS; i++) {
+            if (mb_optimize_batch(map->tags, map->tag_count, &config, plans, BENCH_MAX_TAGS,
+                                  &plan_count, scatter, NULL) != MB_SUCCESS) {
+                printf("%-16s %-7s %7u | planning failed\n", map->name, planner_name, threads);
+                return;
+            }
+        }
+        double us = (now_seconds() - begin) * 1e6 / BENCH_MIN_ITERATIONS;
+        if (threads == 1) {
+            serial_us = us;
+        }
+        printf("%-16s %-7s %7u | %9.2f %7.2fx\n", map->name, planner_name, threads, us,
+               serial_us / us);
+    }
+}
+
+int main(int argc, char **argv) {
+    bool csv = argc > 1 && strcmp(argv[1], "--csv") == 0;
+
+    const device_map_t maps[] = {
+        {"16 power meters", meters, build_meters()},
+        {"12 drives", drives, build_drives()},
+        {"PLC data blocks", plc, build_plc()},
+        {"coil-heavy I/O", io, build_io()},
+        {"20k-tag plant", plant, build_plant()},
+    };
+    const mb_mode_t modes[]       = {MB_MODE_RTU, MB_MODE_TCP};
+    const char *mode_names[]      = {"RTU", "TCP"};
+    const mb_planner_t planners[] = {MB_PLANNER_GREEDY, MB_PLANNER_OPTIMAL};
+    const char *planner_names[]   = {"greedy", "optimal"};
+
+    if (csv) {
+        printf("map,tags,mode,planner,rounds,wire_chars,cost_chars,gap_bytes,us_per_call,"
+               "allocs_per_call,arena_peak\n");
+    } else {
+        printf("%-16s %6s %-4s %-7s | %6s %8s %8s %7s | %9s %7s %8s\n", "map", "tags", "mode",
+               "planner", "rounds", "wire", "cost", "gap B", "us/call", "allocs", "arena B");
+    }
+
+    for (size_t m = 0; m < sizeof(maps) / sizeof(maps[0]); m++) {
+        for (size_t k = 0; k < sizeof(modes) / sizeof(modes[0]); k++) {
+            for (size_t p = 0; p < sizeof(planners) / sizeof(planners[0]); p++) {
+                bench_result_t r;
+                int ret = run_map(&maps[m], modes[k], planners[p], &r);
+                if (ret != MB_SUCCESS) {
+                    printf("%-16s %6u %-4s %-7s | planning failed (%d)\n", maps[m].name,
+                           maps[m].tag_count, mode_names[k], planner_names[p], ret);
+                    continue;
+                }
+
+                const char *format = csv ? "%s,%u,%s,%s,%u,%lu,%lu,%lu,%.2f,%.1f,%lu\n"
+                                         : "%-16s %6u %-4s %-7s | %6u %8lu %8lu %7lu | %9.2f "
+                                           "%7.1f %8lu\n";
+                printf(format, maps[m].name, maps[m].tag_count, mode_names[k], planner_names[p],
+                       r.rounds, (unsigned long)r.wire_chars, (unsigned long)r.cost_chars,
+                       (unsigned long)r.gap_bytes, r.us_per_call, r.allocs_per_call,
+                       (unsigned long)r.arena_peak);
+            }
+        }
+    }
+
+    if (!csv) {
+        printf("\nwire: request + response characters; cost: wire plus gap and latency of the "
+               "cost model.\ngap B: response bytes of units nobody requested. allocs: heap "
+               "allocations per call\nwithout an arena (-1 where not counted); arena B: peak "
+               "with an arena attached.\n");
+#ifdef MB_USE_STATIC_MEMORY
+        printf("Static memory build: maps beyond MB_MAX_BLOCKS/MB_MAX_PLANS fail with "
+               "MB_ERROR_TOO_MANY_BLOCKS.\n");
+#endif
+
+        // Builds without the worker pool plan serially at every thread count
+        printf("\n%-16s %-7s %7s | %9s %8s\n", "map", "planner", "threads", "us/call",
+               "speedup");
+        for (size_t p = 0; p < sizeof(planners) / sizeof(planners[0]); p++) {
+            bench_workers(&maps[4], planners[p], planner_names[p]);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,173 @@
+/**
+ * @file bench_slave.c
+ * @brief Slave request rate: in-process frame execution and TCP over loopback
+ *
+ * The first table times mb_slave_process_frame() alone on TCP frames
+ * (FC03 of 10 and 125 registers, FC16 of 10). The second runs the epoll
+ * server on this thread against client threads that keep a window of
+ * pipelined FC03 requests in flight over 127.0.0.1, and reports requests
+ * answered per second of server time.
+ */
+
+#include "smartmodbus/smartmodbus.h"
+#include "protocol/frame_builder.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_FRAMES      2000000u
+#define BENCH_PER_CLIENT  200000u
+#define BENCH_WINDOW      16u
+#define BENCH_MAX_CLIENTS 4
+
+static MB_SLAVE_ALIGNED uint16_t holding[1024];
+static mb_slave_t slave;
+
+static mb_slave_connection_t connections[BENCH_MAX_CLIENTS];
+static mb_slave_server_t server;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint16_t read_request(uint8_t *frame, uint16_t tid, uint16_t address, uint16_t quantity) {
+    uint8_t pdu[4]  = {(uint8_t)(address >> 8), (uint8_t)address, (uint8_t)(quantity >> 8),
+                       (uint8_t)quantity};
+    uint16_t length = 0;
+    (void)mb_build_frame(1, MB_FC_READ_HOLDING_REGISTERS, pdu, 4, MB_MODE_TCP, tid, frame, 260,
+                         &length);
+    return length;
+}
+
+static void bench_frame(const char *name, const uint8_t *request, uint16_t request_length) {
+    uint8_t frame[260];
+    uint8_t response[260];
+    uint16_t response_length = 0;
+
+    double begin = now_seconds();
+    for (uint32_t i = 0; i < BENCH_FRAMES; i++) {
+        memcpy(frame, request, request_length);
+        (void)mb_slave_process_frame(&slave, MB_MODE_TCP, frame, request_length, response,
+                                     sizeof(response), &response_length);
+    }
+    double seconds = now_seconds() - begin;
+
+    printf("%-18s | %10.1f %12.0f\n", name, seconds * 1e9 / BENCH_FRAMES, BENCH_FRAMES / seconds);
+}
+
+static void *client(void *arg) {
+    (void)arg;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    (void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port   = htons(server.port);
+    (void)inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        perror("connect");
+        return NULL;
+    }
+
+    // Responses of 10 registers: 7 + 1 + 1 + 20 bytes
+    const size_t response_chars = 29;
+    uint8_t window[BENCH_WINDOW * 12];
+    uint8_t responses[BENCH_WINDOW * 29];
+    uint16_t length = 0;
+    for (uint16_t i = 0; i < BENCH_WINDOW; i++) {
+        length = read_request(&window[i * 12u], i, (uint16_t)(i * 10u), 10);
+    }
+
+    for (uint32_t sent = 0; sent < BENCH_PER_CLIENT; sent += BENCH_WINDOW) {
+        if (send(fd, window, (size_t)BENCH_WINDOW * length, 0) < 0) {
+            break;
+        }
+        size_t received = 0;
+        while (received < BENCH_WINDOW * response_chars) {
+            ssize_t n = recv(fd, &responses[received], sizeof(responses) - received, 0);
+            if (n <= 0) {
+                (void)close(fd);
+                return NULL;
+            }
+            received += (size_t)n;
+        }
+    }
+
+    (void)close(fd);
+    return NULL;
+}
+
+static void bench_server(unsigned int clients) {
+    if (mb_slave_server_open(&server, &slave, "127.0.0.1", 0, connections, BENCH_MAX_CLIENTS) !=
+        MB_SUCCESS) {
+        printf("%8u | server open failed\n", clients);
+        return;
+    }
+
+    pthread_t threads[BENCH_MAX_CLIENTS];
+    for (unsigned int i = 0; i < clients; i++) {
+        pthread_create(&threads[i], NULL, client, NULL);
+    }
+
+    uint64_t expected = (uint64_t)clients * BENCH_PER_CLIENT;
+    uint64_t served   = 0;
+    double begin      = now_seconds();
+    while (served < expected) {
+        int result = mb_slave_server_poll(&server, 100);
+        if (result < 0) {
+            break;
+        }
+        served += (uint64_t)result;
+    }
+    double seconds = now_seconds() - begin;
+
+    for (unsigned int i = 0; i < clients; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    mb_slave_server_close(&server);
+
+    printf("%8u | %12.0f %10llu\n", clients, (double)served / seconds,
+           (unsigned long long)served);
+}
+
+int main(void) {
+    for (uint16_t i = 0; i < 1024; i++) {
+        holding[i] = i;
+    }
+
+    mb_slave_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.holding = (mb_slave_regs_t){holding, 0, 1024};
+    if (mb_slave_init(&slave, &config) != MB_SUCCESS) {
+        return 1;
+    }
+
+    printf("%-18s | %10s %12s\n", "frame", "ns/req", "req/s");
+    uint8_t request[260];
+    bench_frame("FC03 x10", request, read_request(request, 1, 100, 10));
+    bench_frame("FC03 x125", request, read_request(request, 1, 100, 125));
+
+    uint8_t write_pdu[5 + 20] = {0x00, 0x64, 0x00, 0x0A, 20};
+    uint16_t write_length     = 0;
+    (void)mb_build_frame(1, MB_FC_WRITE_MULTIPLE_REGISTERS, write_pdu, sizeof(write_pdu),
+                         MB_MODE_TCP, 1, request, sizeof(request), &write_length);
+    bench_frame("FC16 x10", request, write_length);
+
+    printf("\n%8s | %12s %10s  (window %u, loopback)\n", "clients", "req/s", "requests",
+           BENCH_WINDOW);
+    for (unsigned int clients = 1; clients <= BENCH_MAX_CLIENTS; clients *= 2) {
+        bench_server(clients);
+    }
+    return 0;
+}
@@ -0,0 +1,300 @@
+/**
+ * @file sim_slave.c
+ * @brief In-process simulated Modbus slaves implementation
+ *
+ * Requests are answered when they are sent: send() advances the clock by
+ * the request's characters, decides whether the request is lost or drawn
+ * for an exception, and queues the response frame with the time its last
+ * character reaches the master. recv() then moves the clock to that time.
+ * Slaves work one request at a time, so pipelined TCP requests queue up
+ * behind each other as they would on a single-threaded device.
+ */
+
+#include "sim_slave.h"
+
+#include "protocol/frame_builder.h"
+
+#include <string.h>
+
+static uint32_t sim_random(sim_bus_t *bus) {
+    // xorshift32
+    uint32_t x = bus->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    bus->rng = x;
+    return x;
+}
+
+static bool sim_draw(sim_bus_t *bus, uint16_t permille) {
+    return permille > 0 && sim_random(bus) % 1000u < permille;
+}
+
+/**
+ * @brief Line time of a number of characters
+ */
+static uint64_t chars_us(const sim_bus_t *bus, uint32_t chars) {
+    uint64_t bits = (uint64_t)chars * bus->config.bits_per_char * 1000000u;
+    return (bits + bus->config.baud - 1) / bus->config.baud;
+}
+
+static bool readable(const sim_slave_t *slave, uint32_t start, uint32_t quantity) {
+    if (quantity == 0 || start + quantity > 65536u) {
+        return false;
+    }
+    for (uint32_t a = start; a < start + quantity; a++) {
+        if ((slave->readable[a / 64] & (1ULL << (a % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static sim_slave_t *find_slave(sim_bus_t *bus, uint8_t slave_id) {
+    for (uint8_t i = 0; i < bus->slave_count; i++) {
+        if (bus->slaves[i]->slave_id == slave_id) {
+            return bus->slaves[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Build the response PDU data (after FC) for a read request
+ * @return Response length, or 0 with *exception set
+ */
+static uint16_t answer_read(const sim_slave_t *slave,
+                            uint8_t fc,
+                            const uint8_t *pdu,
+                            uint16_t pdu_length,
+                            uint8_t *resp,
+                            uint8_t *exception) {
+    if (fc < MB_FC_READ_COILS || fc > MB_FC_READ_INPUT_REGISTERS) {
+        *exception = MB_EX_ILLEGAL_FUNCTION;
+        return 0;
+    }
+    if (pdu_length != 4) {
+        *exception = MB_EX_ILLEGAL_DATA_VALUE;
+        return 0;
+    }
+
+    uint16_t start    = (uint16_t)((pdu[0] << 8) | pdu[1]);
+    uint16_t quantity = (uint16_t)((pdu[2] << 8) | pdu[3]);
+    bool bits         = fc == MB_FC_READ_COILS || fc == MB_FC_READ_DISCRETE_INPUTS;
+
+    if (quantity == 0 || quantity > (bits ? 2000 : 125)) {
+        *exception = MB_EX_ILLEGAL_DATA_VALUE;
+        return 0;
+    }
+    if (!readable(slave, start, quantity)) {
+        *exception = MB_EX_ILLEGAL_DATA_ADDRESS;
+        return 0;
+    }
+
+    uint16_t pos = 0;
+    if (bits) {
+        uint16_t bytes = (uint16_t)((quantity + 7) / 8);
+        resp[pos++]    = (uint8_t)bytes;
+        memset(&resp[pos], 0, bytes);
+        for (uint16_t i = 0; i < quantity; i++) {
+            uint32_t a = (uint32_t)start + i;
+            if ((slave->coils[a / 64] >> (a % 64)) & 1u) {
+                resp[pos + i / 8] |= (uint8_t)(1u << (i % 8));
+            }
+        }
+        return (uint16_t)(pos + bytes);
+    }
+
+    resp[pos++] = (uint8_t)(quantity * 2);
+    for (uint16_t i = 0; i < quantity; i++) {
+        uint16_t value = slave->registers[(uint16_t)(start + i)];
+        resp[pos++]    = (uint8_t)(value >> 8);
+        resp[pos++]    = (uint8_t)(value & 0xFF);
+    }
+    return pos;
+}
+
+static int sim_send(void *ctx, const uint8_t *data, size_t len) {
+    sim_bus_t *bus = (sim_bus_t *)ctx;
+    uint8_t request[sizeof(((sim_response_t *)0)->frame)];
+
+    if (len == 0 || len > sizeof(request)) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+    if (bus->pending_count == SIM_MAX_PENDING) {
+        return MB_ERROR_TRANSPORT;
+    }
+
+    bus->now_us += chars_us(bus, (uint32_t)len);
+    bus->requests++;
+
+    // Parse a copy: ASCII frames are decoded in place
+    memcpy(request, data, len);
+    uint16_t transaction_id = 0;
+    uint8_t slave_id        = 0;
+    uint8_t fc              = 0;
+    const uint8_t *pdu      = NULL;
+    uint16_t pdu_length     = 0;
+    int result = mb_parse_frame_view(request, (uint16_t)len, bus->config.mode, &transaction_id,
+                                     &slave_id, &fc, &pdu, &pdu_length);
+
+    // Broadcasts are never answered
+    if (result == MB_SUCCESS && slave_id == 0) {
+        return (int)len;
+    }
+
+    sim_response_t *response =
+        &bus->pending[(bus->pending_head + bus->pending_count) % SIM_MAX_PENDING];
+    bus->pending_count++;
+    response->length = 0;
+    response->offset = 0;
+
+    // Corrupt frames, absent slaves and drawn losses stay silent
+    sim_slave_t *slave = result == MB_SUCCESS ? find_slave(bus, slave_id) : NULL;
+    if (slave == NULL || sim_draw(bus, bus->config.loss_permille)) {
+        bus->lost++;
+        response->ready_us = bus->now_us + bus->config.timeout_us;
+        return (int)len;
+    }
+
+    uint8_t resp[MB_MAX_PDU_CHARS];
+    uint8_t exception    = 0;
+    uint16_t resp_length = 0;
+    if (sim_draw(bus, bus->config.exception_permille)) {
+        exception = bus->config.exception_code;
+    } else {
+        resp_length = answer_read(slave, fc, pdu, pdu_length, resp, &exception);
+    }
+
+    if (exception != 0) {
+        bus->exceptions++;
+        fc          = (uint8_t)(fc | 0x80);
+        resp[0]     = exception;
+        resp_length = 1;
+    }
+
+    uint16_t frame_length = 0;
+    result = mb_build_frame(slave_id, fc, resp, resp_length, bus->config.mode, transaction_id,
+                            response->frame, sizeof(response->frame), &frame_length);
+    if (result != MB_SUCCESS) {
+        bus->pending_count--;
+        return result;
+    }
+
+    // One request at a time per bus; serial frames end with 3.5 chars of silence
+    uint64_t start = bus->now_us > bus->slave_free_us ? bus->now_us : bus->slave_free_us;
+    uint64_t jitter =
+        bus->config.jitter_us > 0 ? sim_random(bus) % (bus->config.jitter_us + 1u) : 0;
+    uint64_t ready = start + bus->config.turnaround_us + jitter + chars_us(bus, frame_length);
+    if (bus->config.mode != MB_MODE_TCP) {
+        ready += chars_us(bus, 7) / 2;
+    }
+
+    response->length   = frame_length;
+    response->ready_us = ready;
+    bus->slave_free_us = ready;
+    return (int)len;
+}
+
+static int sim_recv(void *ctx, uint8_t *buffer, size_t max_len, size_t *received) {
+    sim_bus_t *bus = (sim_bus_t *)ctx;
+    *received      = 0;
+
+    if (bus->pending_count == 0) {
+        bus->now_us += bus->config.timeout_us;
+        return MB_ERROR_TIMEOUT;
+    }
+
+    sim_response_t *response = &bus->pending[bus->pending_head];
+    if (bus->now_us < response->ready_us) {
+        bus->now_us = response->ready_us;
+    }
+
+    size_t n = (size_t)(response->length - response->offset);
+    if (n > max_len) {
+        n = max_len;
+    }
+    memcpy(buffer, &response->frame[response->offset], n);
+    response->offset = (uint16_t)(response->offset + n);
+    *received        = n;
+
+    if (response->offset == response->length) {
+        bus->pending_head = (uint8_t)((bus->pending_head + 1) % SIM_MAX_PENDING);
+        bus->pending_count--;
+    }
+    return n > 0 ? 0 : MB_ERROR_TIMEOUT;
+}
+
+static void sim_delay_chars(void *ctx, uint16_t chars) {
+    sim_bus_t *bus = (sim_bus_t *)ctx;
+    bus->now_us += chars_us(bus, chars);
+}
+
+static uint32_t sim_clock_us(void *ctx) {
+    return (uint32_t)((const sim_bus_t *)ctx)->now_us;
+}
+
+sim_config_t sim_config_default(mb_mode_t mode) {
+    sim_config_t config;
+    memset(&config, 0, sizeof(config));
+
+    config.mode           = mode;
+    config.exception_code = MB_EX_SLAVE_DEVICE_BUSY;
+    config.seed           = 0x2545F491u;
+
+    if (mode == MB_MODE_TCP) {
+        config.baud          = 100000000u;
+        config.bits_per_char = 8;
+        config.turnaround_us = 200;
+        config.timeout_us    = 100000u;
+    } else {
+        config.baud          = 19200;
+        config.bits_per_char = mode == MB_MODE_ASCII ? 10 : 11;
+        config.turnaround_us = 2000;
+        config.timeout_us    = 200000u;
+    }
+    return config;
+}
+
+void sim_bus_init(sim_bus_t *bus, const sim_config_t *config) {
+    memset(bus, 0, sizeof(*bus));
+    bus->config = *config;
+    bus->rng    = config->seed != 0 ? config->seed : 1u;
+}
+
+int sim_bus_add_slave(sim_bus_t *bus, sim_slave_t *slave, uint8_t slave_id) {
+    if (bus == NULL || slave == NULL || bus->slave_count == SIM_MAX_SLAVES) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    memset(slave, 0, sizeof(*slave));
+    slave->slave_id                 = slave_id;
+    bus->slaves[bus->slave_count++] = slave;
+    return MB_SUCCESS;
+}
+
+void sim_slave_map(sim_slave_t *slave, uint16_t start, uint16_t count) {
+    for (uint32_t a = start; a < (uint32_t)start + count && a < 65536u; a++) {
+        slave->readable[a / 64] |= 1ULL << (a % 64);
+        slave->registers[a] = (uint16_t)(a * 7u + slave->slave_id);
+        if (a % 2 == 0) {
+            slave->coils[a / 64] |= 1ULL << (a % 64);
+        }
+    }
+}
+
+mb_transport_t sim_bus_transport(sim_bus_t *bus) {
+    mb_transport_t transport;
+    memset(&transport, 0, sizeof(transport));
+
+    transport.send        = sim_send;
+    transport.recv        = sim_recv;
+    transport.delay_chars = sim_delay_chars;
+    transport.clock_us    = sim_clock_us;
+    transport.context     = bus;
+    return transport;
+}
+
+uint64_t sim_bus_now(const sim_bus_t *bus) {
+    return bus->now_us;
+}
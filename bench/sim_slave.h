@@ -0,0 +1,148 @@
+/**
+ * @file sim_slave.h
+ * @brief In-process simulated Modbus slaves behind an mb_transport_t
+ *
+ * A simulated bus answers read requests (FC01-04) from register and coil
+ * maps held in memory, on a virtual clock: every character on the wire
+ * costs its bit time at the configured baud rate, each response waits for
+ * the slave's turnaround time plus random jitter, and requests may be
+ * dropped or answered with an exception at configurable rates. Nothing
+ * sleeps, so thousands of poll cycles run in milliseconds while the clock
+ * (exposed through transport.clock_us) reports what they would have taken
+ * on a real line.
+ */
+
+#ifndef SMARTMODBUS_SIM_SLAVE_H
+#define SMARTMODBUS_SIM_SLAVE_H
+
+#include "smartmodbus/smartmodbus.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Slaves per simulated bus
+ */
+#define SIM_MAX_SLAVES 8
+
+/**
+ * @brief Requests queued on a simulated bus (pipelined TCP)
+ */
+#define SIM_MAX_PENDING MB_MAX_IN_FLIGHT
+
+/**
+ * @brief Line and slave behaviour of a simulated bus
+ */
+typedef struct {
+    mb_mode_t mode;              /**< Framing (RTU/ASCII/TCP) */
+    uint32_t baud;               /**< Line rate in bit/s */
+    uint8_t bits_per_char;       /**< Bits per character (RTU 8N2/8E1: 11, TCP: 8) */
+    uint32_t turnaround_us;      /**< Slave processing time per request */
+    uint32_t jitter_us;          /**< Uniform random extra turnaround, 0..jitter_us */
+    uint32_t timeout_us;         /**< Time the master waits for a lost response */
+    uint16_t loss_permille;      /**< Requests dropped without a response, per 1000 */
+    uint16_t exception_permille; /**< Requests answered with exception_code, per 1000 */
+    uint8_t exception_code;      /**< Injected exception (default: slave device busy) */
+    uint32_t seed;               /**< Random seed for jitter, loss and exceptions */
+} sim_config_t;
+
+/**
+ * @brief One simulated slave
+ *
+ * Addresses outside the readable ranges are answered with
+ * MB_EX_ILLEGAL_DATA_ADDRESS, so merging across a hole in the map shows
+ * up the way it does on a real device.
+ */
+typedef struct {
+    uint8_t slave_id;
+    uint16_t registers[65536];     /**< Holding and input register values */
+    uint64_t coils[65536 / 64];    /**< Coil and discrete input values */
+    uint64_t readable[65536 / 64]; /**< Addresses that may be read */
+} sim_slave_t;
+
+/**
+ * @brief Response on its way back to the master
+ */
+typedef struct {
+    uint64_t ready_us; /**< Virtual time the last character arrives */
+    uint16_t length;   /**< Frame length (0 = lost) */
+    uint16_t offset;   /**< Characters already delivered */
+    uint8_t frame[MB_MAX_PDU_CHARS * 2 + 8];
+} sim_response_t;
+
+/**
+ * @brief Simulated bus: the transport context
+ */
+typedef struct {
+    sim_config_t config;
+    sim_slave_t *slaves[SIM_MAX_SLAVES];
+    uint8_t slave_count;
+
+    uint64_t now_us;        /**< Virtual clock */
+    uint64_t slave_free_us; /**< Slaves busy with earlier requests until then */
+    uint32_t rng;
+
+    sim_response_t pending[SIM_MAX_PENDING];
+    uint8_t pending_head;
+    uint8_t pending_count;
+
+    uint32_t requests;   /**< Requests seen */
+    uint32_t lost;       /**< Requests dropped */
+    uint32_t exceptions; /**< Exception responses (injected and address errors) */
+} sim_bus_t;
+
+/**
+ * @brief Default bus behaviour for a mode
+ * @param mode Protocol mode
+ * @return 19200 baud serial or 100 Mbit/s TCP, 2 ms (TCP: 200 us) turnaround,
+ *         no jitter, loss or exceptions
+ */
+sim_config_t sim_config_default(mb_mode_t mode);
+
+/**
+ * @brief Initialize a simulated bus
+ * @param bus Bus
+ * @param config Line and slave behaviour
+ */
+void sim_bus_init(sim_bus_t *bus, const sim_config_t *config);
+
+/**
+ * @brief Attach a slave to the bus
+ * @param bus Bus
+ * @param slave Slave (zeroed map, nothing readable until sim_slave_map())
+ * @param slave_id Slave ID
+ * @return MB_SUCCESS, or MB_ERROR_INVALID_PARAM when the bus is full
+ */
+int sim_bus_add_slave(sim_bus_t *bus, sim_slave_t *slave, uint8_t slave_id);
+
+/**
+ * @brief Make a range of addresses readable
+ * @param slave Slave
+ * @param start First address
+ * @param count Number of addresses
+ *
+ * Registers in the range read as address-derived values, coils alternate.
+ */
+void sim_slave_map(sim_slave_t *slave, uint16_t start, uint16_t count);
+
+/**
+ * @brief Transport callbacks driving the bus
+ * @param bus Bus (used as the transport context)
+ * @return Transport with send, recv, delay_chars and clock_us set
+ */
+mb_transport_t sim_bus_transport(sim_bus_t *bus);
+
+/**
+ * @brief Current virtual time
+ */
+uint64_t sim_bus_now(const sim_bus_t *bus);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_SIM_SLAVE_H
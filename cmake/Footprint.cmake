@@ -0,0 +1,44 @@
+# RAM and stack footprint report for SmartModbus
+#
+# Configure time: sizes of the structures an application allocates, for the
+# current options and compiler (also when cross-compiling).
+# Build time: `footprint` target listing the deepest stack frames from
+# GCC's -fstack-usage output.
+
+include(CheckTypeSize)
+
+function(mb_footprint_report target)
+    get_target_property(definitions ${target} INTERFACE_COMPILE_DEFINITIONS)
+
+    set(CMAKE_REQUIRED_DEFINITIONS)
+    foreach(definition IN LISTS definitions)
+        list(APPEND CMAKE_REQUIRED_DEFINITIONS -D${definition})
+    endforeach()
+    set(CMAKE_REQUIRED_INCLUDES ${CMAKE_SOURCE_DIR}/include ${CMAKE_SOURCE_DIR}/src)
+    set(CMAKE_EXTRA_INCLUDE_FILES smartmodbus/smartmodbus.h master/transaction.h)
+    set(CMAKE_REQUIRED_QUIET ON)
+
+    message(STATUS "SmartModbus footprint (bytes):")
+    foreach(type mb_master_t mb_poll_plan_t mb_async_op_t mb_request_plan_t mb_block_t mb_pdu_t
+                 mb_tx_frame_t mb_rx_frame_t)
+        # Options may have changed since the last configure
+        unset(MB_SIZEOF_${type} CACHE)
+        unset(HAVE_MB_SIZEOF_${type} CACHE)
+        check_type_size(${type} MB_SIZEOF_${type})
+        message(STATUS "  ${type}: ${MB_SIZEOF_${type}}")
+    endforeach()
+
+    if(CMAKE_C_COMPILER_ID MATCHES "GNU")
+        target_compile_options(${target} PRIVATE -fstack-usage)
+        add_custom_target(footprint
+            COMMAND ${CMAKE_COMMAND}
+                -DSTACK_USAGE_DIR=${CMAKE_CURRENT_BINARY_DIR}/CMakeFiles/${target}.dir
+                -P ${CMAKE_SOURCE_DIR}/cmake/StackReport.cmake
+            DEPENDS ${target}
+            COMMENT "Stack usage of ${target}"
+            VERBATIM
+        )
+    else()
+        message(STATUS "  stack report needs GCC -fstack-usage")
+    endif()
+endfunction()
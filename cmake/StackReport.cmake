@@ -0,0 +1,53 @@
+# Print the deepest stack frames from GCC -fstack-usage (.su) files
+#
+# Usage: cmake -DSTACK_USAGE_DIR=<object dir> [-DSTACK_REPORT_TOP=20] -P StackReport.cmake
+#
+# Frame sizes are per function; a call chain needs the sum of its frames.
+
+if(NOT STACK_USAGE_DIR)
+    message(FATAL_ERROR "STACK_USAGE_DIR not set")
+endif()
+if(NOT STACK_REPORT_TOP)
+    set(STACK_REPORT_TOP 20)
+endif()
+
+file(GLOB_RECURSE su_files "${STACK_USAGE_DIR}/*.su")
+if(NOT su_files)
+    message(FATAL_ERROR "No .su files under ${STACK_USAGE_DIR}")
+endif()
+
+set(entries)
+set(dynamic)
+foreach(su_file IN LISTS su_files)
+    file(STRINGS ${su_file} lines)
+    foreach(line IN LISTS lines)
+        # <file>:<line>:<column>:<function>\t<bytes>\t<static|dynamic|bounded>
+        if(line MATCHES "^([^:]+):[0-9]+:[0-9]+:([^\t]+)\t([0-9]+)\t(.*)$")
+            get_filename_component(source ${CMAKE_MATCH_1} NAME)
+            # Zero-padded so a string sort orders by size
+            string(LENGTH "${CMAKE_MATCH_3}" digits)
+            math(EXPR padding "8 - ${digits}")
+            string(REPEAT "0" ${padding} zeros)
+            list(APPEND entries "${zeros}${CMAKE_MATCH_3} ${source}:${CMAKE_MATCH_2}")
+            if(NOT CMAKE_MATCH_4 STREQUAL "static")
+                list(APPEND dynamic "${source}:${CMAKE_MATCH_2} (${CMAKE_MATCH_4})")
+            endif()
+        endif()
+    endforeach()
+endforeach()
+
+list(SORT entries ORDER DESCENDING)
+list(LENGTH entries count)
+if(count GREATER STACK_REPORT_TOP)
+    list(SUBLIST entries 0 ${STACK_REPORT_TOP} entries)
+endif()
+
+message("Deepest stack frames (bytes, of ${count} functions):")
+foreach(entry IN LISTS entries)
+    string(REGEX MATCH "^0*([0-9]+) (.*)$" _ "${entry}")
+    message("  ${CMAKE_MATCH_1}\t${CMAKE_MATCH_2}")
+endforeach()
+
+foreach(entry IN LISTS dynamic)
+    message("  not static: ${entry}")
+endforeach()
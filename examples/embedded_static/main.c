@@ -21,9 +21,8 @@ int main(void) {
 
     printf("Memory footprint:\n");
     printf("  mb_master_t size: %zu bytes\n", sizeof(mb_master_t));
-    printf("  Block pool: %zu bytes\n", sizeof(mb_block_t) * MB_MAX_BLOCKS);
-    printf("  PDU pool: %zu bytes\n", sizeof(mb_pdu_t) * MB_MAX_PDUS);
-    printf("  Plan pool: %zu bytes\n\n", sizeof(mb_request_plan_t) * MB_MAX_PLANS);
+    printf("  Plan pool: %zu bytes\n", sizeof(mb_request_plan_t) * MB_MAX_PLANS);
+    printf("  Scatter pool: %zu bytes\n\n", sizeof(mb_scatter_entry_t) * MB_MAX_SCATTER);
 
     printf("Advantages of static memory mode:\n");
     printf("  ✓ Deterministic memory usage\n");
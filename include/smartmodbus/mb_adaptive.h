@@ -0,0 +1,155 @@
+/**
+ * @file mb_adaptive.h
+ * @brief Adaptive poll rates per tag group, driven by change detection
+ *
+ * Each group (typically one block of related tags) is read at a period
+ * between its bounds. A read in which no tag moved past its deadband
+ * doubles the group's period, up to max_period_ms; a read that reports a
+ * change snaps it back to min_period_ms. Quiet groups drift towards the
+ * slow end and stop costing bus time, but a group that starts moving is
+ * read at full rate from its next read on.
+ *
+ * mb_adaptive_poll() gathers the tags of every group that is due and reads
+ * them as one batch, so the optimizer merges only what is due in this
+ * cycle. The changes found are handed to an optional callback, so the
+ * poller doubles as a report-by-exception publisher. Storage is
+ * caller-owned; nothing is allocated.
+ */
+
+#ifndef SMARTMODBUS_MB_ADAPTIVE_H
+#define SMARTMODBUS_MB_ADAPTIVE_H
+
+#include "mb_change.h"
+#include "mb_config.h"
+#include "mb_types.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Tags read per batch (one optimizer run)
+ *
+ * Bounds the stack of mb_adaptive_poll() and the size of one group. Due
+ * groups that do not fit together are read in consecutive batches. Static
+ * memory builds also cap it at MB_MAX_SCATTER.
+ */
+#ifndef MB_ADAPTIVE_BATCH_TAGS
+#define MB_ADAPTIVE_BATCH_TAGS 128
+#endif
+
+/**
+ * @brief Change callback
+ * @param ctx User context
+ * @param group Group index
+ * @param changes Changes found by this read, in tag order
+ * @param count Number of changes (a long list arrives in several calls)
+ */
+typedef void (*mb_adaptive_change_fn)(void *ctx,
+                                      uint16_t group,
+                                      const mb_change_t *changes,
+                                      uint16_t count);
+
+/**
+ * @brief One tag group
+ */
+typedef struct {
+    mb_change_set_t changes; /**< Tags, last reported values and deadbands */
+    uint16_t *data;          /**< Latest values: data[i] belongs to tag i */
+    uint32_t min_period_ms;  /**< Period while the group moves */
+    uint32_t max_period_ms;  /**< Period of a group that stays quiet */
+
+    uint32_t period_ms; /**< Current period */
+    uint32_t due_ms;    /**< Time of the next read */
+    uint32_t reads;     /**< Reads completed */
+    uint32_t errors;    /**< Failed reads */
+} mb_adaptive_group_t;
+
+/**
+ * @brief Adaptive poller
+ */
+typedef struct {
+    mb_adaptive_group_t *groups;     /**< Caller-owned storage */
+    uint16_t group_capacity;         /**< Entries in groups */
+    uint16_t group_count;            /**< Groups added */
+    mb_adaptive_change_fn on_change; /**< Change callback (optional) */
+    void *ctx;                       /**< User context of on_change */
+
+    uint32_t batches;   /**< Batch reads issued */
+    uint32_t tags_read; /**< Tags read from the bus */
+} mb_adaptive_t;
+
+/**
+ * @brief Initialize an adaptive poller
+ * @param poller Poller
+ * @param groups Group array
+ * @param capacity Number of entries in groups
+ * @param on_change Change callback (NULL: changes only steer the rates)
+ * @param ctx User context passed to on_change
+ * @return MB_SUCCESS on success, error code otherwise
+ */
+int mb_adaptive_init(mb_adaptive_t *poller,
+                     mb_adaptive_group_t *groups,
+                     uint16_t capacity,
+                     mb_adaptive_change_fn on_change,
+                     void *ctx);
+
+/**
+ * @brief Add a tag group
+ * @param poller Poller
+ * @param tags Tags of the group (kept; must outlive the poller)
+ * @param tag_count Number of tags (1..MB_ADAPTIVE_BATCH_TAGS)
+ * @param data Storage for the latest values (tag_count entries)
+ * @param last Storage for the last reported values (tag_count entries)
+ * @param deadband Per-tag deadband (NULL: any change counts)
+ * @param min_period_ms Fastest period (> 0)
+ * @param max_period_ms Slowest period (>= min_period_ms; equal = fixed rate)
+ * @return Group index, or negative error code (MB_ERROR_TOO_MANY_BLOCKS
+ *         when the storage is full, MB_ERROR_BUFFER_TOO_SMALL when the
+ *         group does not fit one batch)
+ *
+ * Groups start polling with mb_adaptive_start().
+ */
+int mb_adaptive_add(mb_adaptive_t *poller,
+                    const mb_tag_t *tags,
+                    uint16_t tag_count,
+                    uint16_t *data,
+                    uint16_t *last,
+                    const uint16_t *deadband,
+                    uint32_t min_period_ms,
+                    uint32_t max_period_ms);
+
+/**
+ * @brief Make every group due now at its fastest rate
+ * @param poller Poller
+ * @param now_ms Current time
+ *
+ * Call once the groups are added, and again after a reconnect: the next
+ * read of each group reports all its tags.
+ */
+void mb_adaptive_start(mb_adaptive_t *poller, uint32_t now_ms);
+
+/**
+ * @brief Read every due group
+ * @param master Master context
+ * @param poller Poller
+ * @param now_ms Current time in milliseconds (any monotonic clock, may wrap)
+ * @param wait_ms Output (optional): time until the next group is due
+ *        (UINT32_MAX without groups)
+ * @return Number of groups read, or the error of the failed batch
+ *
+ * The groups of a failed batch are counted in errors and retried after
+ * their min_period_ms; batches before it keep their results.
+ */
+int mb_adaptive_poll(mb_master_t *master,
+                     mb_adaptive_t *poller,
+                     uint32_t now_ms,
+                     uint32_t *wait_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_MB_ADAPTIVE_H
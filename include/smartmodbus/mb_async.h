@@ -0,0 +1,235 @@
+/**
+ * @file mb_async.h
+ * @brief Non-blocking poll and write execution with completion callbacks
+ *
+ * An async operation runs a compiled poll plan as a state machine instead
+ * of blocking for every round-trip. The application owns the event loop:
+ * it waits for readiness (epoll/kqueue on a socket, a UART RX interrupt, a
+ * timer tick) and calls mb_async_step(), which sends and receives whatever
+ * is possible without blocking and returns. One thread can drive many
+ * masters this way, one operation per connection or RS-485 port.
+ *
+ * The transport of a master used asynchronously must not block:
+ * - send() returns the number of bytes accepted, which may be short or 0
+ * - recv() returns 0 with *received == 0 when no bytes are available
+ * A negative return from either callback fails the operation.
+ */
+
+#ifndef SMARTMODBUS_MB_ASYNC_H
+#define SMARTMODBUS_MB_ASYNC_H
+
+#include "mb_config.h"
+#include "mb_types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Receive accumulator size for an async operation
+ *
+ * Two TCP ADUs, or one ASCII ADU (513 chars).
+ */
+#define MB_ASYNC_RX_CHARS 520
+
+/**
+ * @brief Interest flags returned by mb_async_interest()
+ */
+#define MB_ASYNC_WANT_READ  0x01u /**< Waiting for response bytes */
+#define MB_ASYNC_WANT_WRITE 0x02u /**< A request is waiting to be sent */
+
+/**
+ * @brief Largest request frame an async write can carry
+ *
+ * FC16 with 123 registers in ASCII framing.
+ */
+#define MB_ASYNC_TX_CHARS 513
+
+/**
+ * @brief Async operation state
+ */
+typedef enum {
+    MB_ASYNC_IDLE = 0, /**< Not submitted, or reset by mb_async_cancel() */
+    MB_ASYNC_BUSY,     /**< Requests outstanding */
+    MB_ASYNC_DONE      /**< Completed; see mb_async_op_t::result */
+} mb_async_state_t;
+
+/**
+ * @brief Completion callback
+ * @param ctx User context given at submission
+ * @param result MB_SUCCESS, or the error that ended the operation
+ *
+ * Invoked once from inside mb_async_step(). The operation may be
+ * resubmitted from the callback.
+ */
+typedef void (*mb_async_done_fn)(void *ctx, int result);
+
+/**
+ * @brief Outstanding request of an async operation
+ */
+typedef struct {
+    uint16_t transaction_id; /**< MBAP transaction ID (TCP) */
+    uint16_t plan_index;     /**< Plan the request belongs to */
+    uint32_t deadline_ms;    /**< Response deadline (caller's clock) */
+    uint32_t sent_us;        /**< Request end on transport.clock_us (metrics only) */
+    bool in_flight;          /**< Slot in use */
+} mb_async_slot_t;
+
+/**
+ * @brief Async operation
+ *
+ * Caller-owned; holds all state of one poll or write so no allocation
+ * takes place. Treat the fields as read-only except through the API.
+ */
+typedef struct {
+    mb_master_t *master;            /**< Master the operation runs on */
+    mb_mode_t mode;                 /**< Framing of the request frames */
+    const mb_request_plan_t *plans; /**< Requests with prebuilt frames */
+    uint16_t plan_count;            /**< Number of requests */
+    mb_poll_plan_t *poll;           /**< Poll plan (NULL for a write) */
+    uint16_t *data_buffer;          /**< Output slots (poll->address_count) */
+    mb_async_done_fn on_done;
+    void *ctx;
+
+    mb_async_state_t state; /**< Current state */
+    int result;             /**< Final result once MB_ASYNC_DONE */
+
+    uint16_t next_plan;  /**< Next plan to send */
+    uint16_t completed;  /**< Plans answered */
+    uint8_t window;      /**< Requests allowed in flight (1 for RTU/ASCII) */
+    uint8_t in_flight;   /**< Requests currently outstanding */
+    uint8_t tx_slot;     /**< Slot of the request being sent */
+    bool tx_pending;     /**< A request frame is partially sent */
+    uint16_t tx_offset;  /**< Bytes of that frame already accepted */
+
+    mb_async_slot_t slots[MB_MAX_IN_FLIGHT];
+
+    size_t rx_length; /**< Bytes in rx */
+    uint8_t rx[MB_ASYNC_RX_CHARS];
+
+    // Single write request: the echo is checked against these
+    mb_request_plan_t write_plan;
+    uint16_t write_value;
+    uint8_t write_frame[MB_ASYNC_TX_CHARS];
+} mb_async_op_t;
+
+/**
+ * @brief Start executing a poll plan without blocking
+ * @param master Master context (same mode as at compile time)
+ * @param op Operation state (caller-owned, must outlive the operation)
+ * @param poll Compiled poll plan
+ * @param data_buffer Output buffer; data_buffer[i] receives the value of the
+ *                    i-th compiled address
+ * @param buffer_size Size of data buffer (must be >= poll->address_count)
+ * @param on_done Completion callback (optional)
+ * @param ctx User context passed to on_done
+ * @return MB_SUCCESS if submitted, error code otherwise
+ *
+ * Nothing is sent until the first mb_async_step(). At most one operation
+ * may run on a master at a time. TCP requests are pipelined up to
+ * `config.max_in_flight`; serial modes send one request at a time.
+ */
+int mb_master_submit_poll(mb_master_t *master,
+                          mb_async_op_t *op,
+                          mb_poll_plan_t *poll,
+                          uint16_t *data_buffer,
+                          uint16_t buffer_size,
+                          mb_async_done_fn on_done,
+                          void *ctx);
+
+/**
+ * @brief Start a write single coil (FC05) without blocking
+ * @param master Master context
+ * @param op Operation state (caller-owned, must outlive the operation)
+ * @param slave_id Slave device ID
+ * @param addr Coil address
+ * @param value Coil value
+ * @param on_done Completion callback (optional)
+ * @param ctx User context passed to on_done
+ * @return MB_SUCCESS if submitted, error code otherwise
+ *
+ * The request is encoded into op; the echo is verified on completion.
+ */
+int mb_master_submit_write_single_coil(mb_master_t *master,
+                                       mb_async_op_t *op,
+                                       uint8_t slave_id,
+                                       uint16_t addr,
+                                       bool value,
+                                       mb_async_done_fn on_done,
+                                       void *ctx);
+
+/**
+ * @brief Start a write single register (FC06) without blocking
+ * @see mb_master_submit_write_single_coil()
+ */
+int mb_master_submit_write_single_register(mb_master_t *master,
+                                           mb_async_op_t *op,
+                                           uint8_t slave_id,
+                                           uint16_t addr,
+                                           uint16_t value,
+                                           mb_async_done_fn on_done,
+                                           void *ctx);
+
+/**
+ * @brief Start a write multiple registers (FC16) without blocking
+ * @param values Register values (copied into the request frame)
+ * @see mb_master_submit_write_single_coil()
+ */
+int mb_master_submit_write_multiple_registers(mb_master_t *master,
+                                              mb_async_op_t *op,
+                                              uint8_t slave_id,
+                                              uint16_t start_addr,
+                                              uint16_t quantity,
+                                              const uint16_t *values,
+                                              mb_async_done_fn on_done,
+                                              void *ctx);
+
+/**
+ * @brief Advance an async operation as far as possible without blocking
+ * @param op Operation
+ * @param now_ms Current time in milliseconds (any monotonic clock, may wrap)
+ * @return MB_SUCCESS while in progress or once completed, negative error
+ *         code once the operation has failed
+ *
+ * Sends pending requests, drains available bytes, handles every complete
+ * response and checks `config.timeout_ms` against each outstanding request.
+ * Call it whenever the transport becomes ready or a timer fires.
+ */
+int mb_async_step(mb_async_op_t *op, uint32_t now_ms);
+
+/**
+ * @brief Readiness an event loop should wait for
+ * @param op Operation
+ * @return MB_ASYNC_WANT_READ / MB_ASYNC_WANT_WRITE flags, 0 when not busy
+ */
+unsigned mb_async_interest(const mb_async_op_t *op);
+
+/**
+ * @brief Earliest response deadline of an outstanding request
+ * @param op Operation
+ * @param deadline_ms Output: deadline on the clock passed to mb_async_step()
+ * @return true if a request is outstanding
+ *
+ * Use it to bound the event loop's wait, so timeouts are noticed.
+ */
+bool mb_async_next_deadline(const mb_async_op_t *op, uint32_t *deadline_ms);
+
+/**
+ * @brief Abandon an operation without invoking its callback
+ * @param op Operation
+ *
+ * Late responses to abandoned TCP requests are discarded by the next
+ * transaction on the same connection. On a serial line, wait out the
+ * response timeout before reusing it.
+ */
+void mb_async_cancel(mb_async_op_t *op);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_MB_ASYNC_H
@@ -0,0 +1,148 @@
+/**
+ * @file mb_bus.h
+ * @brief Rate-monotonic bus scheduler for a shared serial line
+ *
+ * Polls several groups with different periods (e.g. 10 ms alarms, 1 s
+ * analogs, 60 s configuration) over one RTU/ASCII master. Each group is a
+ * compiled poll plan released once per period; its plans are dispatched
+ * one request at a time, shorter periods first. A lower-priority request
+ * only goes on the line if its predicted occupancy fits before the next
+ * release of every faster group, so slow groups fill the idle gaps instead
+ * of delaying alarms. A job that would otherwise miss its deadline is run
+ * ahead of the faster groups, earliest deadline first.
+ *
+ * Line occupancy is predicted from mb_calc_request_cost() (characters,
+ * including gap_chars and latency_chars of the master) and the baud rate.
+ */
+
+#ifndef SMARTMODBUS_MB_BUS_H
+#define SMARTMODBUS_MB_BUS_H
+
+#include "mb_config.h"
+#include "mb_types.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief One periodic poll group
+ */
+typedef struct {
+    mb_poll_plan_t *poll;  /**< Plan executed once per period */
+    uint16_t *data_buffer; /**< Output slots */
+    uint16_t buffer_size;  /**< Size of data_buffer */
+    uint32_t period_ms;    /**< Release period (and implicit deadline) */
+    uint32_t cost_us;      /**< Predicted line occupancy per period */
+
+    uint32_t release_ms; /**< Release time of the current job */
+    uint16_t next_plan;  /**< Next plan of the current job (plan_count = done) */
+    int last_result;     /**< Result of the last executed request */
+    uint32_t completed;  /**< Jobs finished */
+    uint32_t overruns;   /**< Jobs still running at their next release */
+    uint32_t errors;     /**< Failed requests */
+} mb_bus_group_t;
+
+/**
+ * @brief Schedulability verdict of mb_bus_analyze()
+ */
+typedef enum {
+    MB_BUS_SCHEDULABLE    = 0, /**< Utilization within the rate-monotonic bound */
+    MB_BUS_AT_RISK        = 1, /**< Above the bound: deadlines may be missed */
+    MB_BUS_OVERSUBSCRIBED = 2  /**< Demand exceeds the line capacity */
+} mb_bus_verdict_t;
+
+/**
+ * @brief Predicted load of the bus
+ */
+typedef struct {
+    uint32_t utilization_permille; /**< Sum of cost/period over all groups */
+    uint32_t bound_permille;       /**< Rate-monotonic bound n(2^(1/n) - 1) */
+    uint32_t max_request_us;       /**< Longest single request (blocking time) */
+    mb_bus_verdict_t verdict;
+} mb_bus_load_t;
+
+/**
+ * @brief Bus scheduler
+ */
+typedef struct {
+    mb_master_t *master;     /**< Serial master (RTU or ASCII) */
+    mb_bus_group_t *groups;  /**< Caller-owned storage, sorted by period */
+    uint16_t group_capacity; /**< Entries in groups */
+    uint16_t group_count;    /**< Groups added */
+    uint32_t char_us;        /**< Time of one character on the line */
+} mb_bus_t;
+
+/**
+ * @brief Initialize a bus scheduler
+ * @param bus Bus scheduler
+ * @param master Serial master (RTU or ASCII mode)
+ * @param groups Group array
+ * @param capacity Number of entries in groups
+ * @param baud_rate Line speed in bit/s
+ * @return MB_SUCCESS on success, error code otherwise
+ *
+ * A character is 11 bits on the line in RTU mode and 10 bits in ASCII mode.
+ */
+int mb_bus_init(mb_bus_t *bus,
+                mb_master_t *master,
+                mb_bus_group_t *groups,
+                uint16_t capacity,
+                uint32_t baud_rate);
+
+/**
+ * @brief Add a poll group
+ * @param bus Bus scheduler
+ * @param poll Compiled poll plan
+ * @param data_buffer Output buffer (>= poll->address_count entries)
+ * @param buffer_size Size of data_buffer
+ * @param period_ms Poll period
+ * @return Priority of the group (0 = highest), or negative error code
+ *
+ * Groups are kept sorted by period, so adding a faster group shifts the
+ * priority (index) of every slower one.
+ */
+int mb_bus_add_group(mb_bus_t *bus,
+                     mb_poll_plan_t *poll,
+                     uint16_t *data_buffer,
+                     uint16_t buffer_size,
+                     uint32_t period_ms);
+
+/**
+ * @brief Predict the line load of all groups
+ * @param bus Bus scheduler
+ * @param load Output load report
+ * @return MB_SUCCESS on success, error code otherwise
+ *
+ * Call after adding the groups: MB_BUS_OVERSUBSCRIBED means the groups
+ * cannot all be polled at their periods at this baud rate.
+ */
+int mb_bus_analyze(const mb_bus_t *bus, mb_bus_load_t *load);
+
+/**
+ * @brief Release every group at the given time
+ * @param bus Bus scheduler
+ * @param now_ms Current time
+ */
+void mb_bus_start(mb_bus_t *bus, uint32_t now_ms);
+
+/**
+ * @brief Execute at most one request
+ * @param bus Bus scheduler
+ * @param now_ms Current time
+ * @param wait_ms Output: 0 if a request was executed, otherwise the time
+ *        until the next release
+ * @return Result of the executed request, or MB_SUCCESS when idle
+ *
+ * Requests are blocking transactions on the master. A failed request is
+ * counted in its group and the job moves on to its next plan.
+ */
+int mb_bus_poll(mb_bus_t *bus, uint32_t now_ms, uint32_t *wait_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_MB_BUS_H
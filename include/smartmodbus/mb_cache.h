@@ -0,0 +1,140 @@
+/**
+ * @file mb_cache.h
+ * @brief Shared read-through value cache with per-read staleness
+ *
+ * Several consumers polling overlapping tags of the same slaves can share
+ * one cache in front of a master. Each read names the oldest value it
+ * accepts (max_age_ms); tags cached more recently than that are answered
+ * without bus traffic. The stale tags of all reads passed to one
+ * mb_cache_read_many() call are deduplicated and read as a single batch,
+ * so they go through one optimizer run and are merged with each other
+ * before anything is sent.
+ *
+ * Entries are kept sorted by (slave, function code, address). When the
+ * table is full, the entry read longest ago makes room. Storage is
+ * caller-owned.
+ */
+
+#ifndef SMARTMODBUS_MB_CACHE_H
+#define SMARTMODBUS_MB_CACHE_H
+
+#include "mb_config.h"
+#include "mb_types.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Stale tags read per batch (one optimizer run)
+ *
+ * Bounds the stack of mb_cache_read_many(); more stale tags are read in
+ * consecutive batches. Static memory builds also cap it at MB_MAX_SCATTER.
+ */
+#ifndef MB_CACHE_BATCH_TAGS
+#define MB_CACHE_BATCH_TAGS 128
+#endif
+
+/**
+ * @brief One cached value
+ */
+typedef struct {
+    uint8_t slave_id;      /**< Slave device ID */
+    uint8_t function_code; /**< Read function code (01-04) */
+    uint16_t address;      /**< Coil/register address */
+    uint16_t value;        /**< Last value read */
+    bool valid;            /**< value has been read */
+    bool pending;          /**< Queued for the batch in progress */
+    uint32_t read_ms;      /**< Time value was read */
+} mb_cache_entry_t;
+
+/**
+ * @brief Value cache over caller-owned storage
+ */
+typedef struct {
+    mb_cache_entry_t *entries; /**< Caller-owned storage, sorted by key */
+    uint16_t capacity;         /**< Entries in storage */
+    uint16_t count;            /**< Entries in use */
+    uint32_t hits;             /**< Tags answered from the cache */
+    uint32_t misses;           /**< Tags read from the bus */
+    uint32_t batches;          /**< Batch reads issued */
+} mb_cache_t;
+
+/**
+ * @brief One consumer's read
+ */
+typedef struct {
+    const mb_tag_t *tags; /**< Tags to read */
+    uint16_t tag_count;   /**< Number of tags */
+    uint32_t max_age_ms;  /**< Oldest acceptable value (0: read in this call) */
+    uint16_t *data;       /**< Output: data[i] is the value of tags[i] */
+} mb_cache_read_t;
+
+/**
+ * @brief Initialize a cache
+ * @param cache Cache
+ * @param entries Entry array
+ * @param capacity Number of entries (at least 1)
+ * @return MB_SUCCESS on success, error code otherwise
+ */
+int mb_cache_init(mb_cache_t *cache, mb_cache_entry_t *entries, uint16_t capacity);
+
+/**
+ * @brief Drop every cached value
+ * @param cache Cache
+ */
+void mb_cache_clear(mb_cache_t *cache);
+
+/**
+ * @brief Drop the cached values of an address range (e.g. after a write)
+ * @param cache Cache
+ * @param slave_id Slave device ID
+ * @param fc Read function code of the address space
+ * @param first First address
+ * @param last Last address (inclusive)
+ */
+void mb_cache_invalidate(mb_cache_t *cache,
+                         uint8_t slave_id,
+                         uint8_t fc,
+                         uint16_t first,
+                         uint16_t last);
+
+/**
+ * @brief Serve several reads, fetching their stale tags together
+ * @param master Master context
+ * @param cache Cache
+ * @param reads Reads to serve
+ * @param read_count Number of reads
+ * @param now_ms Current time in milliseconds (any monotonic clock, may wrap)
+ * @return MB_SUCCESS on success, error code of the failed batch otherwise
+ *
+ * A tag is fresh for a read if it was read at most max_age_ms before
+ * now_ms. On failure the outputs are incomplete; batches read before the
+ * failed one stay cached.
+ */
+int mb_cache_read_many(mb_master_t *master,
+                       mb_cache_t *cache,
+                       const mb_cache_read_t *reads,
+                       uint16_t read_count,
+                       uint32_t now_ms);
+
+/**
+ * @brief Serve one read
+ * @see mb_cache_read_many()
+ */
+int mb_cache_read(mb_master_t *master,
+                  mb_cache_t *cache,
+                  const mb_tag_t *tags,
+                  uint16_t tag_count,
+                  uint32_t max_age_ms,
+                  uint32_t now_ms,
+                  uint16_t *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_MB_CACHE_H
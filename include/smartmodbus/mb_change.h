@@ -0,0 +1,115 @@
+/**
+ * @file mb_change.h
+ * @brief Report-by-exception change detection over poll results
+ *
+ * A change set keeps the last reported value of every tag of a read (the
+ * addresses of an mb_read_request_t, or the tags of a batch) in an array
+ * parallel to the read's data buffer. After each successful read,
+ * mb_change_set_detect() compares the fresh buffer against it and lists
+ * only the tags that moved, with their (slave, FC, address) key, so a
+ * publisher forwards deltas instead of the whole buffer.
+ *
+ * Unchanged stretches are skipped sixteen registers at a time with wide
+ * XOR compares; only stretches that differ are looked at tag by tag. Tags
+ * with a deadband are reported once they move more than the deadband away
+ * from the value last reported, so slow drift is still published.
+ *
+ * The first detection after init or mb_change_set_reset() reports every
+ * tag. Storage is caller-owned; nothing is allocated.
+ */
+
+#ifndef SMARTMODBUS_MB_CHANGE_H
+#define SMARTMODBUS_MB_CHANGE_H
+
+#include "mb_types.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief One reported change
+ */
+typedef struct {
+    uint8_t slave_id;      /**< Slave device ID */
+    uint8_t function_code; /**< Read function code */
+    uint16_t address;      /**< Coil/register address */
+    uint16_t index;        /**< Slot in the read's data buffer */
+    uint16_t value;        /**< New value */
+    uint16_t previous;     /**< Value reported before (0 on the first report) */
+} mb_change_t;
+
+/**
+ * @brief Last reported values of one read
+ */
+typedef struct {
+    const mb_read_request_t *request; /**< Keys of a single-slave read (or NULL) */
+    const mb_tag_t *tags;             /**< Keys of a batch read (or NULL) */
+    uint16_t *last;                   /**< Last reported values (count entries) */
+    const uint16_t *deadband;         /**< Per-tag deadband, NULL or 0 = any change */
+    uint16_t count;                   /**< Tags */
+    uint16_t primed;                  /**< Tags below this have been reported once */
+} mb_change_set_t;
+
+/**
+ * @brief Track the results of mb_master_read_optimized() or a poll plan
+ * @param set Change set
+ * @param request Read request (kept for the keys; must outlive the set)
+ * @param last Storage for request->address_count values
+ * @param deadband Per-address deadband (NULL: report every change)
+ * @return MB_SUCCESS on success, error code otherwise
+ */
+int mb_change_set_init(mb_change_set_t *set,
+                       const mb_read_request_t *request,
+                       uint16_t *last,
+                       const uint16_t *deadband);
+
+/**
+ * @brief Track the results of mb_master_read_batch() or a batch poll plan
+ * @param set Change set
+ * @param tags Tags (kept for the keys; must outlive the set)
+ * @param tag_count Number of tags
+ * @param last Storage for tag_count values
+ * @param deadband Per-tag deadband (NULL: report every change)
+ * @return MB_SUCCESS on success, error code otherwise
+ */
+int mb_change_set_init_tags(mb_change_set_t *set,
+                            const mb_tag_t *tags,
+                            uint16_t tag_count,
+                            uint16_t *last,
+                            const uint16_t *deadband);
+
+/**
+ * @brief Report every tag again on the next detection (e.g. after a reconnect)
+ * @param set Change set
+ */
+void mb_change_set_reset(mb_change_set_t *set);
+
+/**
+ * @brief List the tags that changed since they were last reported
+ * @param set Change set
+ * @param values Data buffer of a successful read (set->count values)
+ * @param changes Output change list, in tag order
+ * @param max_changes Entries in changes
+ * @param change_count Output: changes listed
+ * @return MB_SUCCESS, or MB_ERROR_BUFFER_TOO_SMALL if more tags changed
+ *         than fit: the first max_changes are listed and the rest are
+ *         reported by the next call with the same values
+ *
+ * A listed tag's value becomes its last reported value. With a deadband,
+ * a tag is listed when it moves more than that away from it; distances
+ * are taken modulo 2^16, so signed and unsigned registers both work.
+ */
+int mb_change_set_detect(mb_change_set_t *set,
+                         const uint16_t *values,
+                         mb_change_t *changes,
+                         uint16_t max_changes,
+                         uint16_t *change_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_MB_CHANGE_H
@@ -9,27 +9,96 @@
 #ifndef SMARTMODBUS_MB_CONFIG_H
 #define SMARTMODBUS_MB_CONFIG_H
 
+#include "mb_metrics.h"
+#include "mb_profile.h"
+#include "mb_trace.h"
 #include "mb_transport.h"
 #include "mb_types.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Upper bound for pipelined TCP requests per master
+ */
+#ifndef MB_MAX_IN_FLIGHT
+#define MB_MAX_IN_FLIGHT 16
+#endif
+
+/**
+ * @brief Plans per window of mb_master_read_optimized()
+ *
+ * Larger requests are planned and executed in consecutive windows, so this
+ * bounds the stack, not the request size.
+ */
+#ifndef MB_WINDOW_PLANS
+#define MB_WINDOW_PLANS 16
+#endif
+
+/**
+ * @brief Upper bound for mb_config_t.planner_threads
+ */
+#ifndef MB_MAX_PLANNER_THREADS
+#define MB_MAX_PLANNER_THREADS 16
+#endif
+
+/**
+ * @brief Recovery of failed plans in mb_master_read_optimized()
+ *
+ * With the default (all zero) a read stops at the first failed plan. With
+ * retries or split set, or through mb_master_read_optimized_quality(), the
+ * other plans of the call are still executed, and only the failed plan is
+ * re-sent: up to max_retries times after a timeout, CRC/LRC, framing or
+ * transport error, waiting backoff_chars (doubled per retry, at most
+ * max_backoff_chars) through transport.delay_chars. A merged plan that
+ * still fails, or that drew an exception, is re-read as the blocks it was
+ * merged from when split is set, so one bad register costs its own block.
+ */
+typedef struct {
+    uint8_t max_retries;        /**< Retries per plan (0 = none) */
+    bool split;                 /**< Re-read a failed merged plan block by block */
+    uint16_t backoff_chars;     /**< Wait before the first retry (0 = none) */
+    uint16_t max_backoff_chars; /**< Longest wait between retries (0 = no limit) */
+} mb_retry_policy_t;
+
+/**
+ * @brief Submission ring (see mb_ring.h)
+ *
+ * Requests pushed to config.urgent do not wait for a running read to
+ * finish: the master executes them at its next plan boundary, before the
+ * rest of the read, so an urgent write waits for at most one transaction.
+ */
+typedef struct mb_ring mb_ring_t;
+
 /**
  * @brief Smart Modbus configuration
  *
  * Configuration parameters for initializing a Modbus master instance.
  */
 typedef struct {
-    mb_mode_t mode;             /**< Protocol mode (RTU/ASCII/TCP) */
-    uint16_t max_pdu_chars;     /**< Maximum PDU size (default: 253) */
-    uint8_t gap_chars;          /**< Inter-frame gap (RTU/ASCII: 4, TCP: 0) */
-    uint8_t latency_chars;      /**< Network/processing latency equivalent */
-    mb_transport_t transport;   /**< Transport layer callbacks */
-    uint32_t timeout_ms;        /**< Response timeout in milliseconds */
+    mb_mode_t mode;               /**< Protocol mode (RTU/ASCII/TCP) */
+    uint16_t max_pdu_chars;       /**< Maximum PDU size (default: 253) */
+    uint8_t gap_chars;            /**< Inter-frame gap (RTU/ASCII: 4, TCP: 0) */
+    uint8_t latency_chars;        /**< Network/processing latency equivalent */
+    mb_link_t link;               /**< Line timing for time-based costs (default: characters) */
+    mb_transport_t transport;     /**< Transport layer callbacks */
+    uint32_t timeout_ms;          /**< Response timeout in milliseconds */
+    uint16_t turnaround_chars;    /**< Wait after a serial broadcast (0 = none) */
+    mb_timeout_policy_t timeouts; /**< Learned per-slave timeouts (default: off) */
+    uint8_t max_in_flight;        /**< Pipelined requests (TCP only, 1 = stop-and-wait) */
+    mb_planner_t planner;         /**< Merge planner (default: greedy) */
+    uint8_t planner_threads;      /**< Batch planning workers (0/1 = calling thread only) */
+    mb_profile_table_t *profiles; /**< Learned per-slave profiles (optional) */
+    mb_metrics_t *metrics;        /**< Per-slave/FC metrics (optional) */
+    mb_retry_policy_t retry;      /**< Failed plan recovery (default: fail fast) */
+    mb_ring_t *urgent;            /**< Requests run between the plans of a read (optional) */
+#ifdef MB_ENABLE_TRACE
+    mb_trace_t trace;             /**< Hot-path trace hooks (optional) */
+#endif
 } mb_config_t;
 
 /**
@@ -41,16 +110,13 @@ typedef struct {
     mb_config_t config;         /**< Configuration */
     uint16_t transaction_id;    /**< Transaction ID for TCP/IP */
     mb_stats_t stats;           /**< Statistics */
+    mb_scratch_t scratch;       /**< Optimizer scratch arena (see mb_master_set_scratch()) */
+    bool preempting;            /**< Running config.urgent (not preempted again) */
 
 #ifdef MB_USE_STATIC_MEMORY
-    // Static memory pools
-    mb_block_t block_pool[MB_MAX_BLOCKS];
-    mb_pdu_t pdu_pool[MB_MAX_PDUS];
+    // Batch read storage; the optimizer and frames use the stack of each call
     mb_request_plan_t plan_pool[MB_MAX_PLANS];
-    uint8_t frame_buffers[MB_MAX_PLANS][MB_MAX_PDU_CHARS + 20];  // Extra for headers
-    uint16_t block_pool_used;
-    uint16_t pdu_pool_used;
-    uint16_t plan_pool_used;
+    mb_scatter_entry_t scatter_pool[MB_MAX_SCATTER];
 #endif
 } mb_master_t;
 
@@ -35,7 +35,9 @@ typedef enum {
     MB_ERROR_TOO_MANY_BLOCKS = -15,    /**< Too many blocks (static mode) */
     MB_ERROR_PDU_TOO_LARGE = -16,      /**< PDU exceeds maximum size */
     MB_ERROR_TOO_MANY_PLANS = -17,     /**< Too many plans (exceeds max_plans) */
-    MB_ERROR_NO_MEMORY = -18           /**< Memory allocation failed */
+    MB_ERROR_NO_MEMORY = -18,          /**< Memory allocation failed */
+    MB_ERROR_PARTIAL_RESULT = -19,     /**< Some values were read, see their quality */
+    MB_ERROR_SLAVE_OFFLINE = -20       /**< Slave offline, request not sent until its next probe */
 } mb_error_t;
 
 /**
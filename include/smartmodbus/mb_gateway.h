@@ -0,0 +1,210 @@
+/**
+ * @file mb_gateway.h
+ * @brief Modbus TCP to serial gateway with cross-client read merging
+ *
+ * TCP clients are bridged onto serial lines (RTU, ASCII, or RTU-over-TCP
+ * terminal servers). Client bytes are fed in as they arrive; each complete
+ * MBAP request is queued on the port serving its unit ID. Servicing a port
+ * drains its queue in arrival order:
+ *
+ * - A run of consecutive reads (FC01-FC04) from any clients is merged into
+ *   one optimized batch (mb_master_read_batch()), so overlapping or nearby
+ *   ranges cost one bus round-trip instead of one per client. Every client
+ *   is answered with its own slice of the shared result.
+ * - Any other request is forwarded as is and answered with the slave's
+ *   response. It is a barrier: no read is merged across it, so a client
+ *   never reads a value from before its own earlier write.
+ *
+ * If a merged batch fails (an exception or a timeout on any slave), its
+ * requests are forwarded one by one, so each client sees exactly what its
+ * own request got. The gateway answers by itself only for routing and
+ * queueing problems, using exceptions 0x0A (no port for the unit), 0x06
+ * (queue full) and 0x0B (no response on the serial line).
+ *
+ * The gateway owns no sockets and no threads. Feeding, servicing and
+ * closing clients must happen on one thread, or under one lock.
+ * mb_gateway_service() blocks in the port master's transport, like any
+ * synchronous master call.
+ */
+
+#ifndef SMARTMODBUS_MB_GATEWAY_H
+#define SMARTMODBUS_MB_GATEWAY_H
+
+#include "mb_config.h"
+#include "mb_types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Largest request PDU data (without function code)
+ */
+#define MB_GATEWAY_MAX_PDU 252
+
+/**
+ * @brief Largest Modbus TCP request ADU
+ */
+#define MB_GATEWAY_MAX_ADU 260
+
+/**
+ * @brief Send a response ADU to a client
+ * @param ctx User context
+ * @param client Client index
+ * @param data MBAP frame
+ * @param len Frame length
+ * @return Number of bytes sent, or negative error code
+ */
+typedef int (*mb_gateway_send_fn)(void *ctx, uint16_t client, const uint8_t *data, size_t len);
+
+/**
+ * @brief Queued client request
+ */
+typedef struct {
+    uint16_t client;                  /**< Client index */
+    uint16_t transaction_id;          /**< MBAP transaction ID to answer with */
+    uint8_t unit_id;                  /**< Unit (slave) ID */
+    uint8_t function_code;            /**< Function code */
+    uint16_t pdu_length;              /**< Request PDU data length */
+    uint8_t pdu[MB_GATEWAY_MAX_PDU];  /**< Request PDU data (without function code) */
+} mb_gateway_request_t;
+
+/**
+ * @brief Serial port and its request queue
+ */
+typedef struct {
+    mb_master_t *master;          /**< Master driving the line */
+    uint8_t first_unit;           /**< Lowest unit ID routed to this port */
+    uint8_t last_unit;            /**< Highest unit ID routed to this port */
+    mb_gateway_request_t *queue;  /**< Queue storage (FIFO ring) */
+    uint16_t capacity;            /**< Queue capacity */
+    uint16_t head;                /**< Oldest queued request */
+    uint16_t count;               /**< Queued requests */
+} mb_gateway_port_t;
+
+/**
+ * @brief Per-client receive state
+ */
+typedef struct {
+    uint8_t rx[MB_GATEWAY_MAX_ADU]; /**< Partial request bytes */
+    uint16_t rx_length;             /**< Bytes in rx */
+    bool open;                      /**< Client connected */
+} mb_gateway_client_t;
+
+/**
+ * @brief Gateway counters
+ */
+typedef struct {
+    uint32_t requests;        /**< Requests received from clients */
+    uint32_t responses;       /**< Responses sent to clients */
+    uint32_t merged_requests; /**< Reads answered from a shared batch */
+    uint32_t batches;         /**< Merged batches executed */
+    uint32_t fallbacks;       /**< Batches that failed and were forwarded one by one */
+    uint32_t exceptions;      /**< Exceptions raised by the gateway itself */
+} mb_gateway_stats_t;
+
+/**
+ * @brief Gateway setup
+ *
+ * tags and values form the merge work area: one entry per coil or
+ * register of a batch. A read larger than the work area (or a run of one
+ * read) is forwarded without merging.
+ */
+typedef struct {
+    mb_gateway_port_t *ports;      /**< Ports (see mb_gateway_port_init()) */
+    uint16_t port_count;           /**< Number of ports */
+    mb_gateway_client_t *clients;  /**< Client slots */
+    uint16_t client_count;         /**< Number of client slots */
+    mb_tag_t *tags;                /**< Work area: batch tags */
+    uint16_t *values;              /**< Work area: batch values */
+    uint16_t work_capacity;        /**< Entries in tags and values */
+    mb_gateway_send_fn send;       /**< Response sink */
+    void *context;                 /**< Context passed to send */
+} mb_gateway_config_t;
+
+/**
+ * @brief Gateway state
+ */
+typedef struct {
+    mb_gateway_config_t config; /**< Setup */
+    mb_gateway_stats_t stats;   /**< Counters */
+} mb_gateway_t;
+
+/**
+ * @brief Initialize a port
+ * @param port Port
+ * @param master Master of the serial line (any mode; usually RTU or RTU-over-TCP)
+ * @param first_unit Lowest unit ID served
+ * @param last_unit Highest unit ID served
+ * @param queue Queue storage
+ * @param capacity Queue capacity
+ * @return MB_SUCCESS on success, error code otherwise
+ */
+int mb_gateway_port_init(mb_gateway_port_t *port,
+                         mb_master_t *master,
+                         uint8_t first_unit,
+                         uint8_t last_unit,
+                         mb_gateway_request_t *queue,
+                         uint16_t capacity);
+
+/**
+ * @brief Initialize a gateway
+ * @param gateway Gateway
+ * @param config Setup (copied)
+ * @return MB_SUCCESS on success, error code otherwise
+ *
+ * All client slots start closed.
+ */
+int mb_gateway_init(mb_gateway_t *gateway, const mb_gateway_config_t *config);
+
+/**
+ * @brief Mark a client slot connected
+ * @param gateway Gateway
+ * @param client Client index
+ * @return MB_SUCCESS on success, error code otherwise
+ */
+int mb_gateway_client_open(mb_gateway_t *gateway, uint16_t client);
+
+/**
+ * @brief Disconnect a client and drop its queued requests
+ * @param gateway Gateway
+ * @param client Client index
+ */
+void mb_gateway_client_close(mb_gateway_t *gateway, uint16_t client);
+
+/**
+ * @brief Feed bytes received from a client
+ * @param gateway Gateway
+ * @param client Client index
+ * @param data Received bytes (any segmentation)
+ * @param len Number of bytes
+ * @return Number of complete requests taken, or negative error code.
+ *         MB_ERROR_INVALID_FRAME means the stream is not Modbus TCP: its
+ *         partial data is dropped, and the connection should be closed.
+ *
+ * Requests whose unit has no port, or whose queue is full, are answered
+ * with an exception right away.
+ */
+int mb_gateway_feed(mb_gateway_t *gateway, uint16_t client, const uint8_t *data, size_t len);
+
+/**
+ * @brief Execute all requests queued on a port
+ * @param gateway Gateway
+ * @param port_index Port
+ * @return Number of responses sent, or negative error code
+ */
+int mb_gateway_service(mb_gateway_t *gateway, uint16_t port_index);
+
+/**
+ * @brief Number of requests queued on a port
+ */
+uint16_t mb_gateway_pending(const mb_gateway_t *gateway, uint16_t port_index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_MB_GATEWAY_H
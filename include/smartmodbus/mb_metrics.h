@@ -0,0 +1,213 @@
+/**
+ * @file mb_metrics.h
+ * @brief Per-slave, per-function-code transaction metrics
+ *
+ * A metrics table keeps one series per (slave, function code) pair the
+ * master talks to: request, response, exception, timeout and checksum
+ * counters, characters on the wire, the response bytes spent on units read
+ * without being requested, the round-trips merging saved, and a round-trip
+ * time histogram.
+ *
+ * The histogram uses HDR-style log buckets: values below 8 us get one
+ * bucket each, every power of two above that is split into four, so any
+ * recorded time is known to within 25 % over the whole range up to the
+ * overflow bucket (from about 29 s). An update is one bucket increment and a
+ * binary search over the series, cheap enough for every transaction.
+ *
+ * Like profile tables, the storage is caller-owned and attached through
+ * config.metrics. A table is updated by the thread that runs the master;
+ * an exporter on another thread should take mb_metrics_snapshot() under
+ * the same lock that serializes master calls.
+ */
+
+#ifndef SMARTMODBUS_MB_METRICS_H
+#define SMARTMODBUS_MB_METRICS_H
+
+#include "mb_types.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Round-trip time histogram buckets
+ */
+#define MB_METRICS_BUCKETS 96
+
+/**
+ * @brief Round-trip time argument for responses that were not timed
+ */
+#define MB_METRICS_UNTIMED UINT32_MAX
+
+/**
+ * @brief Metrics of one (slave, function code) pair
+ */
+typedef struct {
+    uint8_t slave_id;      /**< Slave device ID */
+    uint8_t function_code; /**< Request function code */
+
+    uint32_t requests;     /**< Requests sent */
+    uint32_t responses;    /**< Responses received, exceptions included */
+    uint32_t exceptions;   /**< Exception responses */
+    uint32_t timeouts;     /**< Requests without a response */
+    uint32_t crc_errors;   /**< Responses failing the CRC (RTU) or LRC (ASCII) check */
+    uint32_t frame_errors; /**< Malformed or mismatched responses */
+
+    uint64_t chars_sent;   /**< Request characters on the wire */
+    uint64_t chars_recv;   /**< Response characters on the wire */
+    uint64_t gap_bytes;    /**< Response data bytes of units nobody requested */
+    uint32_t rounds_saved; /**< Round-trips saved versus one read per contiguous run */
+
+    uint32_t rtt_count;                       /**< Timed round-trips */
+    uint32_t rtt_max_us;                      /**< Longest round-trip */
+    uint64_t rtt_sum_us;                      /**< Sum of round-trip times */
+    uint32_t rtt_buckets[MB_METRICS_BUCKETS]; /**< Round-trip histogram */
+} mb_metrics_series_t;
+
+/**
+ * @brief Metrics table, sorted by (slave, function code)
+ */
+typedef struct {
+    mb_metrics_series_t *series; /**< Caller-owned storage */
+    uint16_t capacity;           /**< Series in storage */
+    uint16_t count;              /**< Series in use */
+    uint32_t dropped;            /**< Updates lost because the table was full */
+} mb_metrics_t;
+
+/**
+ * @brief Initialize a metrics table over caller-owned storage
+ * @param metrics Metrics table
+ * @param series Series array
+ * @param capacity Number of series
+ * @return MB_SUCCESS on success, error code otherwise
+ */
+int mb_metrics_init(mb_metrics_t *metrics, mb_metrics_series_t *series, uint16_t capacity);
+
+/**
+ * @brief Clear all series
+ * @param metrics Metrics table
+ */
+void mb_metrics_reset(mb_metrics_t *metrics);
+
+/**
+ * @brief Look up a series
+ * @param metrics Metrics table (may be NULL)
+ * @param slave_id Slave device ID
+ * @param fc Request function code
+ * @return Series, or NULL if there is none
+ */
+mb_metrics_series_t *mb_metrics_find(const mb_metrics_t *metrics, uint8_t slave_id, uint8_t fc);
+
+/**
+ * @brief Look up a series, creating it if needed
+ * @param metrics Metrics table
+ * @param slave_id Slave device ID
+ * @param fc Request function code
+ * @return Series, or NULL if the table is full (counted in dropped)
+ */
+mb_metrics_series_t *mb_metrics_acquire(mb_metrics_t *metrics, uint8_t slave_id, uint8_t fc);
+
+/**
+ * @brief Record a request sent
+ * @param metrics Metrics table (may be NULL)
+ * @param slave_id Slave device ID
+ * @param fc Request function code
+ * @param chars Request frame length in characters
+ */
+void mb_metrics_record_request(mb_metrics_t *metrics,
+                               uint8_t slave_id,
+                               uint8_t fc,
+                               uint32_t chars);
+
+/**
+ * @brief Record the outcome of a request
+ * @param metrics Metrics table (may be NULL)
+ * @param slave_id Slave device ID
+ * @param fc Request function code
+ * @param result MB_SUCCESS for a response, otherwise the receive error
+ *        (MB_ERROR_TIMEOUT, MB_ERROR_CRC_MISMATCH, MB_ERROR_LRC_MISMATCH,
+ *        anything else counts as a frame error)
+ * @param exception true if the response was an exception
+ * @param chars Response characters received
+ * @param rtt_us Round-trip time, or MB_METRICS_UNTIMED
+ */
+void mb_metrics_record_response(mb_metrics_t *metrics,
+                                uint8_t slave_id,
+                                uint8_t fc,
+                                int result,
+                                bool exception,
+                                uint32_t chars,
+                                uint32_t rtt_us);
+
+/**
+ * @brief Record the merging of executed read plans
+ * @param metrics Metrics table (may be NULL)
+ * @param plans Plans that were read
+ * @param plan_count Number of plans
+ * @param scatter Scatter map of the plans (the requested units)
+ *
+ * Adds each plan's unrequested units as gap_bytes and the contiguous runs
+ * of requested units it covered, less one, as rounds_saved.
+ */
+void mb_metrics_record_plans(mb_metrics_t *metrics,
+                             const mb_request_plan_t *plans,
+                             uint16_t plan_count,
+                             const mb_scatter_entry_t *scatter);
+
+/**
+ * @brief Histogram bucket of a round-trip time
+ * @param us Round-trip time in microseconds
+ * @return Bucket index (0 to MB_METRICS_BUCKETS - 1)
+ */
+uint8_t mb_metrics_bucket(uint32_t us);
+
+/**
+ * @brief Upper bound of a histogram bucket
+ * @param bucket Bucket index
+ * @return Smallest time above the bucket, in microseconds (UINT32_MAX for
+ *         the overflow bucket); use as the Prometheus `le` bound minus one
+ */
+uint32_t mb_metrics_bucket_limit(uint8_t bucket);
+
+/**
+ * @brief Round-trip time percentile of a series
+ * @param series Series
+ * @param permille Percentile in 1/1000 (500 = median, 990 = p99)
+ * @return Upper end of the bucket holding the percentile (at most
+ *         rtt_max_us), or 0 without samples
+ */
+uint32_t mb_metrics_percentile(const mb_metrics_series_t *series, uint16_t permille);
+
+/**
+ * @brief Copy a metrics table for export
+ * @param metrics Metrics table
+ * @param series Output series
+ * @param capacity Entries in series
+ * @param count Output: series copied
+ * @return MB_SUCCESS, or MB_ERROR_BUFFER_TOO_SMALL if capacity is below
+ *         metrics->count (the first capacity series are copied)
+ */
+int mb_metrics_snapshot(const mb_metrics_t *metrics,
+                        mb_metrics_series_t *series,
+                        uint16_t capacity,
+                        uint16_t *count);
+
+/**
+ * @brief Sum series into one
+ * @param series Series
+ * @param count Number of series
+ * @param total Output: counters and histogram summed (slave_id and
+ *        function_code 0)
+ */
+void mb_metrics_total(const mb_metrics_series_t *series,
+                      uint16_t count,
+                      mb_metrics_series_t *total);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_MB_METRICS_H
@@ -0,0 +1,184 @@
+/**
+ * @file mb_ports.h
+ * @brief One thread driving many serial ports (Linux)
+ *
+ * Each RS-485 port keeps its own mb_master_t, but instead of a blocking
+ * thread per port, one mb_ports_t runs every port as a state machine over
+ * one epoll set of tty file descriptors. A port repeatedly scans its list
+ * of compiled poll plans through mb_async_step(); mb_ports_run() sleeps in
+ * epoll_wait() until a tty is readable, a response deadline passes or a
+ * line's inter-frame silence ends, and steps only the ports concerned.
+ * Ports wait for their slaves side by side, so aggregate throughput grows
+ * with the number of ports rather than being bound by one round-trip time.
+ *
+ * The port's transport is non-blocking. Its delay_chars() does not sleep:
+ * it extends the line's quiet time, and send() holds back the next frame
+ * until the line has been silent for that long. Every received byte and
+ * every frame sent arms the RTU 3.5 character silence (1750 us above
+ * 19200 baud) the same way, so frames keep their spacing without the
+ * thread ever sleeping on one port.
+ */
+
+#ifndef SMARTMODBUS_MB_PORTS_H
+#define SMARTMODBUS_MB_PORTS_H
+
+#include "mb_async.h"
+#include "mb_config.h"
+#include "mb_types.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef MB_ENABLE_SERIAL_PORTS
+
+/**
+ * @brief Entry of a port's scan list
+ */
+typedef struct {
+    mb_poll_plan_t *poll;     /**< Compiled poll plan */
+    uint16_t *data_buffer;    /**< Output slots (poll->address_count) */
+    mb_async_done_fn on_done; /**< Called after each execution (optional) */
+    void *ctx;                /**< User context of on_done */
+    uint32_t reads;           /**< Successful executions */
+    uint32_t errors;          /**< Failed executions */
+    int result;               /**< Result of the last execution */
+} mb_port_poll_t;
+
+/**
+ * @brief Non-blocking tty line
+ */
+typedef struct {
+    int fd;            /**< tty (or any stream) descriptor, non-blocking */
+    uint32_t char_us;  /**< Line time per character */
+    uint32_t gap_us;   /**< Inter-frame silence (0 in ASCII mode) */
+    uint32_t quiet_us; /**< Clock at which the line may be driven again */
+    uint16_t tx_rest;  /**< Bytes of a frame still to be written */
+    uint32_t writes;   /**< write() calls made */
+    uint32_t reads;    /**< read() calls made */
+} mb_serial_line_t;
+
+/**
+ * @brief Serial port of an mb_ports_t
+ */
+typedef struct {
+    mb_master_t *master;    /**< Master of the port */
+    mb_serial_line_t line;  /**< The port's tty */
+    mb_port_poll_t *polls;  /**< Scan list storage (caller-owned) */
+    uint16_t poll_capacity; /**< Entries in polls */
+    uint16_t poll_count;    /**< Polls added */
+    uint16_t next_poll;     /**< Poll run next */
+    mb_async_op_t op;       /**< Operation of the running poll */
+    uint32_t events;        /**< epoll events registered */
+    bool failed;            /**< The tty failed; the port is no longer run */
+    uint32_t cycles;        /**< Passes over the scan list completed */
+} mb_port_t;
+
+/**
+ * @brief Multi-port engine
+ */
+typedef struct {
+    mb_port_t *ports;  /**< Port storage (caller-owned) */
+    uint16_t capacity; /**< Entries in ports */
+    uint16_t count;    /**< Ports added */
+    int epoll_fd;      /**< epoll instance */
+    uint32_t waits;    /**< epoll_wait() calls */
+} mb_ports_t;
+
+/**
+ * @brief Open and configure a tty for Modbus
+ * @param path Device path (e.g. "/dev/ttyS1")
+ * @param link Baud rate, data bits, parity and stop bits (see mb_link_t)
+ * @param mode MB_MODE_RTU or MB_MODE_ASCII (default data bits)
+ * @param fd Output: non-blocking descriptor in raw mode
+ * @return MB_SUCCESS, MB_ERROR_INVALID_PARAM for a baud rate termios does
+ *         not know, MB_ERROR_TRANSPORT if the device cannot be set up
+ */
+int mb_serial_open(const char *path, const mb_link_t *link, mb_mode_t mode, int *fd);
+
+/**
+ * @brief Create the engine
+ * @param engine Engine
+ * @param ports Port storage
+ * @param capacity Number of entries in ports
+ * @return MB_SUCCESS on success, error code otherwise
+ */
+int mb_ports_init(mb_ports_t *engine, mb_port_t *ports, uint16_t capacity);
+
+/**
+ * @brief Add a serial port
+ * @param engine Engine
+ * @param master Master of the port (RTU or ASCII mode)
+ * @param fd Descriptor of the port (see mb_serial_open(); made non-blocking,
+ *        closed by mb_ports_close())
+ * @param link Line timing; link->bit_rate is required
+ * @param polls Scan list storage
+ * @param poll_capacity Entries in polls
+ * @return Port index, or negative error code (MB_ERROR_TOO_MANY_BLOCKS when
+ *         the storage is full)
+ *
+ * master->config.transport is replaced by the port's non-blocking tty
+ * transport, so the master must only be used through the engine.
+ */
+int mb_ports_add(mb_ports_t *engine,
+                 mb_master_t *master,
+                 int fd,
+                 const mb_link_t *link,
+                 mb_port_poll_t *polls,
+                 uint16_t poll_capacity);
+
+/**
+ * @brief Append a poll plan to a port's scan list
+ * @param engine Engine
+ * @param port Port index
+ * @param poll Compiled poll plan (compiled for the port's master)
+ * @param data_buffer Output buffer
+ * @param buffer_size Entries in data_buffer (>= poll->address_count)
+ * @param on_done Called after each execution (optional)
+ * @param ctx User context passed to on_done
+ * @return Entry index, or negative error code (MB_ERROR_TOO_MANY_BLOCKS
+ *         when the scan list is full)
+ *
+ * A port runs its polls back to back in the order added and starts over
+ * after the last one.
+ */
+int mb_ports_add_poll(mb_ports_t *engine,
+                      uint16_t port,
+                      mb_poll_plan_t *poll,
+                      uint16_t *data_buffer,
+                      uint16_t buffer_size,
+                      mb_async_done_fn on_done,
+                      void *ctx);
+
+/**
+ * @brief Wait for port activity and advance every port that can move
+ * @param engine Engine
+ * @param timeout_ms Longest wait (-1 = until activity, 0 = do not wait)
+ * @return Number of poll executions completed, or negative error code
+ *
+ * The wait also ends at the earliest response deadline or end of a line
+ * silence, so timeouts and frame spacing need no separate timer. A port
+ * whose tty fails (read/write error, hang-up) is marked failed, its
+ * running poll completes with MB_ERROR_TRANSPORT and it is left out
+ * from then on.
+ */
+int mb_ports_run(mb_ports_t *engine, int timeout_ms);
+
+/**
+ * @brief Close every port's descriptor and the epoll instance
+ * @param engine Engine
+ *
+ * Running polls are abandoned without their callbacks.
+ */
+void mb_ports_close(mb_ports_t *engine);
+
+#endif  // MB_ENABLE_SERIAL_PORTS
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_MB_PORTS_H
@@ -0,0 +1,395 @@
+/**
+ * @file mb_profile.h
+ * @brief Learned per-slave device profiles
+ *
+ * A profile table records how each slave actually behaves on the wire. The
+ * transaction engine times every stop-and-wait round-trip (when the
+ * transport provides clock_us) and fits
+ *
+ *     elapsed = latency_us + response_chars × char_us
+ *
+ * per slave by least squares over the most recent round-trips, so both the
+ * turnaround and slow inter-character timing are captured. The optimizer
+ * then uses the learned latency, expressed in that slave's character times,
+ * instead of the static latency_chars: slow devices get merged across much
+ * larger gaps than fast ones.
+ *
+ * The same round-trips drive a per-slave response timeout in the manner of
+ * TCP's retransmission timer: the turnaround (round-trip minus the
+ * response's characters) is smoothed together with its mean deviation, and
+ * a request waits the smoothed turnaround, four deviations and its own
+ * response length. Consecutive timeouts double the wait and finally put
+ * the slave offline, where it is only probed now and then instead of
+ * stalling the line on every request (mb_timeout_policy_t).
+ *
+ * Exception responses teach the table what a slave cannot serve: unmapped
+ * address holes (ILLEGAL DATA ADDRESS on a read spanning unrequested gap
+ * units) and the largest quantity it accepts (ILLEGAL DATA VALUE). The
+ * optimizer never merges across a learned hole and caps PDUs at the learned
+ * quantity.
+ *
+ * A table can live inside a profile image: a header followed by the
+ * records, usable in place. Mapping a file with the image (mmap(), or a
+ * flash region) keeps what was learned across restarts.
+ */
+
+#ifndef SMARTMODBUS_MB_PROFILE_H
+#define SMARTMODBUS_MB_PROFILE_H
+
+#include "mb_types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Round-trips kept per slave for the timing fit
+ */
+#ifndef MB_PROFILE_WINDOW
+#define MB_PROFILE_WINDOW 8
+#endif
+
+/**
+ * @brief Samples needed before the learned latency replaces latency_chars
+ */
+#define MB_PROFILE_MIN_SAMPLES 3
+
+/**
+ * @brief Unmapped address ranges remembered per slave
+ */
+#ifndef MB_PROFILE_MAX_HOLES
+#define MB_PROFILE_MAX_HOLES 8
+#endif
+
+/**
+ * @brief Resolution added to every learned timeout
+ */
+#define MB_PROFILE_TIMEOUT_GRANULARITY_US 1000u
+
+/**
+ * @brief Learned response timeouts and offline handling
+ *
+ * Active when max_ms is non-zero and the master has profiles and a
+ * transport clock_us. Until a slave has answered once its timeout is
+ * config.timeout_ms; all timeouts are kept within min_ms and max_ms.
+ */
+typedef struct {
+    uint32_t min_ms;       /**< Shortest timeout */
+    uint32_t max_ms;       /**< Longest timeout (0 = static config.timeout_ms) */
+    uint8_t offline_after; /**< Consecutive timeouts that put a slave offline (0 = never) */
+    uint32_t probe_ms;     /**< Interval between probe requests to an offline slave */
+} mb_timeout_policy_t;
+
+/**
+ * @brief Whether a slave accepts FC23 (Read/Write Multiple Registers)
+ */
+typedef enum {
+    MB_FC23_UNKNOWN     = 0, /**< Not configured: reads and writes stay separate */
+    MB_FC23_SUPPORTED   = 1, /**< Fuse a write and a read into one FC23 */
+    MB_FC23_UNSUPPORTED = 2  /**< Rejected with ILLEGAL FUNCTION */
+} mb_fc23_support_t;
+
+/**
+ * @brief Address range a slave rejected (inclusive)
+ */
+typedef struct {
+    uint16_t first;        /**< First unmapped address */
+    uint16_t last;         /**< Last unmapped address */
+    uint8_t function_code; /**< Read function code of the address space (01-04) */
+} mb_profile_hole_t;
+
+/**
+ * @brief Learned behaviour of one slave
+ */
+typedef struct {
+    uint8_t slave_id;    /**< Slave device ID */
+    uint16_t samples;    /**< Timed round-trips (saturating) */
+    uint32_t latency_us; /**< Fitted turnaround (request end to first response char) */
+    uint32_t char_us;    /**< Fitted time per response character */
+
+    uint16_t window_chars[MB_PROFILE_WINDOW]; /**< Recent response lengths */
+    uint32_t window_us[MB_PROFILE_WINDOW];    /**< Recent round-trip times */
+    uint8_t window_next;                      /**< Slot of the next sample */
+
+    uint32_t srtt_us;   /**< Smoothed turnaround (0 = no response yet) */
+    uint32_t rttvar_us; /**< Mean deviation of the turnaround */
+    uint32_t probe_us;  /**< Transport clock of the next probe while offline */
+    uint8_t timeouts;   /**< Consecutive requests without a response (saturating) */
+    uint8_t offline;    /**< Only probed until it answers again */
+
+    uint16_t max_registers;                        /**< Largest register read (0 = FC limit) */
+    uint16_t max_bits;                             /**< Largest bit read (0 = FC limit) */
+    uint8_t fc23;                                  /**< FC23 support (mb_fc23_support_t) */
+    uint8_t hole_count;                            /**< Holes in use */
+    mb_profile_hole_t holes[MB_PROFILE_MAX_HOLES]; /**< Sorted by FC, then address */
+} mb_slave_profile_t;
+
+/**
+ * @brief Profile image identification ("MBPF")
+ */
+#define MB_PROFILE_IMAGE_MAGIC 0x4650424Du
+
+/**
+ * @brief Profile image layout version
+ */
+#define MB_PROFILE_IMAGE_VERSION 2
+
+/**
+ * @brief Header of a persisted profile image, followed by the records
+ *
+ * Records use the native layout of mb_slave_profile_t, so an image is only
+ * valid for builds with the same record layout (checked via record_size
+ * and a byte-order sensitive magic).
+ */
+typedef struct {
+    uint32_t magic;       /**< MB_PROFILE_IMAGE_MAGIC */
+    uint16_t version;     /**< MB_PROFILE_IMAGE_VERSION */
+    uint16_t record_size; /**< sizeof(mb_slave_profile_t) */
+    uint16_t capacity;    /**< Records in the image */
+    uint16_t count;       /**< Records in use, sorted by slave ID */
+    uint32_t char_us;     /**< Nominal character time when last attached */
+} mb_profile_image_t;
+
+/**
+ * @brief Profile table, sorted by slave ID
+ */
+typedef struct {
+    mb_slave_profile_t *entries; /**< Caller-owned storage */
+    uint16_t capacity;           /**< Entries in storage */
+    uint16_t count;              /**< Profiles in use */
+    uint32_t char_us;            /**< Nominal character time of the link */
+    mb_profile_image_t *image;   /**< Image holding the entries (NULL if none) */
+} mb_profile_table_t;
+
+/**
+ * @brief Initialize a profile table over caller-owned storage
+ * @param table Profile table
+ * @param entries Profile array
+ * @param capacity Number of entries
+ * @param char_us Nominal time of one character on the link (e.g. 11 bits
+ *        at the baud rate for RTU; for TCP, one byte at the expected
+ *        throughput). Must be non-zero.
+ * @return MB_SUCCESS on success, error code otherwise
+ */
+int mb_profiles_init(mb_profile_table_t *table,
+                     mb_slave_profile_t *entries,
+                     uint16_t capacity,
+                     uint32_t char_us);
+
+/**
+ * @brief Bytes needed for a profile image
+ * @param capacity Number of records
+ * @return Image size
+ */
+size_t mb_profile_image_size(uint16_t capacity);
+
+/**
+ * @brief Initialize an empty profile image and a table over it
+ * @param table Profile table
+ * @param image Image storage (4-byte aligned, e.g. a mapped file)
+ * @param size Size of the storage
+ * @param char_us Nominal character time of the link (non-zero)
+ * @return MB_SUCCESS on success, error code otherwise
+ *
+ * The capacity is as many records as fit in size.
+ */
+int mb_profiles_format(mb_profile_table_t *table, void *image, size_t size, uint32_t char_us);
+
+/**
+ * @brief Use a previously written profile image in place
+ * @param table Profile table
+ * @param image Image storage (4-byte aligned, e.g. a mapped file)
+ * @param size Size of the storage
+ * @param char_us Nominal character time of the link (non-zero)
+ * @return MB_SUCCESS on success, MB_ERROR_NOT_SUPPORTED for an image of
+ *         another version or record layout, MB_ERROR_INVALID_FRAME for a
+ *         damaged image, other error code otherwise
+ *
+ * Nothing is copied: learning continues in the image, and the optimizer
+ * uses its holes, limits and latencies from the first request on. On
+ * failure the image is not modified; format it to start over.
+ */
+int mb_profiles_attach(mb_profile_table_t *table, void *image, size_t size, uint32_t char_us);
+
+/**
+ * @brief Look up a slave's profile
+ * @param table Profile table (may be NULL)
+ * @param slave_id Slave device ID
+ * @return Profile, or NULL if the slave has none
+ */
+mb_slave_profile_t *mb_profile_find(const mb_profile_table_t *table, uint8_t slave_id);
+
+/**
+ * @brief Look up a slave's profile, creating it if needed
+ * @param table Profile table
+ * @param slave_id Slave device ID
+ * @return Profile, or NULL if the table is full
+ */
+mb_slave_profile_t *mb_profile_acquire(mb_profile_table_t *table, uint8_t slave_id);
+
+/**
+ * @brief Record one timed round-trip
+ * @param table Profile table
+ * @param slave_id Slave device ID
+ * @param response_chars Length of the response frame in characters
+ * @param elapsed_us Time from the end of the request to the end of the response
+ * @return MB_SUCCESS on success, error code otherwise
+ *
+ * A response also brings an offline slave back online.
+ */
+int mb_profile_record(mb_profile_table_t *table,
+                      uint8_t slave_id,
+                      uint16_t response_chars,
+                      uint32_t elapsed_us);
+
+/**
+ * @brief Record a request that got no response
+ * @param table Profile table
+ * @param slave_id Slave device ID
+ * @param policy Timeout policy
+ * @param now_us Transport clock
+ * @return true if the slave went offline with this timeout
+ *
+ * An offline slave's next probe is scheduled policy->probe_ms from now.
+ */
+bool mb_profile_record_timeout(mb_profile_table_t *table,
+                               uint8_t slave_id,
+                               const mb_timeout_policy_t *policy,
+                               uint32_t now_us);
+
+/**
+ * @brief Admit a request to a slave
+ * @param table Profile table (may be NULL)
+ * @param slave_id Slave device ID
+ * @param policy Timeout policy
+ * @param now_us Transport clock
+ * @return false while the slave is offline and its next probe is not due
+ *
+ * Admitting the probe of an offline slave moves the next probe one
+ * interval on, so a probe that fails in some other way than a timeout
+ * does not open the line to every request.
+ */
+bool mb_profile_admit(mb_profile_table_t *table,
+                      uint8_t slave_id,
+                      const mb_timeout_policy_t *policy,
+                      uint32_t now_us);
+
+/**
+ * @brief Response timeout for a request to a slave
+ * @param table Profile table (may be NULL)
+ * @param slave_id Slave device ID
+ * @param response_chars Expected length of the response frame
+ * @param policy Timeout policy
+ * @param fallback_ms Timeout until the slave has answered (config.timeout_ms)
+ * @return Timeout in milliseconds, within policy->min_ms and policy->max_ms
+ */
+uint32_t mb_profile_timeout_ms(const mb_profile_table_t *table,
+                               uint8_t slave_id,
+                               uint16_t response_chars,
+                               const mb_timeout_policy_t *policy,
+                               uint32_t fallback_ms);
+
+/**
+ * @brief Latency to use in the cost model for a slave
+ * @param table Profile table (may be NULL)
+ * @param slave_id Slave device ID
+ * @param fallback Value used until enough samples were recorded
+ *        (normally config.latency_chars)
+ * @return Latency in the slave's own character times (0-255)
+ */
+uint8_t mb_profile_latency_chars(const mb_profile_table_t *table,
+                                 uint8_t slave_id,
+                                 uint8_t fallback);
+
+/**
+ * @brief Remember an unmapped address range
+ * @param table Profile table
+ * @param slave_id Slave device ID
+ * @param fc Read function code (01-04)
+ * @param first First address of the range
+ * @param last Last address of the range (inclusive)
+ * @return true if the hole set changed
+ *
+ * Overlapping and touching ranges are joined. When all slots are in use the
+ * range is joined with the nearest hole of the same address space, which
+ * only ever forbids more merging.
+ */
+bool mb_profile_add_hole(mb_profile_table_t *table,
+                         uint8_t slave_id,
+                         uint8_t fc,
+                         uint16_t first,
+                         uint16_t last);
+
+/**
+ * @brief Check whether a gap may be read as part of a merged request
+ * @param table Profile table (may be NULL)
+ * @param slave_id Slave device ID
+ * @param fc Read function code
+ * @param first First gap address
+ * @param last Last gap address (inclusive)
+ * @return true if the range touches a learned hole
+ */
+bool mb_profile_gap_forbidden(const mb_profile_table_t *table,
+                              uint8_t slave_id,
+                              uint8_t fc,
+                              uint16_t first,
+                              uint16_t last);
+
+/**
+ * @brief Largest quantity a slave accepts for a read function code
+ * @param table Profile table (may be NULL)
+ * @param slave_id Slave device ID
+ * @param fc Read function code
+ * @return Learned limit, or 0 if only the function code limit applies
+ */
+uint16_t mb_profile_max_quantity(const mb_profile_table_t *table, uint8_t slave_id, uint8_t fc);
+
+/**
+ * @brief Learn from an exception response to an optimized read
+ * @param table Profile table
+ * @param plan Plan that was answered with an exception
+ * @param entries Scatter entries of the plan (the requested units)
+ * @param entry_count Number of entries
+ * @param exception_code Modbus exception code
+ * @return true if the profile changed, so re-planning avoids the exception
+ *
+ * ILLEGAL DATA ADDRESS marks the plan's unrequested gap units as holes; a
+ * read of requested units only teaches nothing. ILLEGAL DATA VALUE halves
+ * the slave's accepted quantity.
+ */
+bool mb_profile_learn_exception(mb_profile_table_t *table,
+                                const mb_request_plan_t *plan,
+                                const mb_scatter_entry_t *entries,
+                                uint16_t entry_count,
+                                uint8_t exception_code);
+
+/**
+ * @brief Configure whether a slave accepts FC23
+ * @param table Profile table
+ * @param slave_id Slave device ID
+ * @param support FC23 support
+ * @return MB_SUCCESS on success, MB_ERROR_TOO_MANY_BLOCKS if the table is
+ *         full, error code otherwise
+ *
+ * A slave answering FC23 with ILLEGAL FUNCTION is marked
+ * MB_FC23_UNSUPPORTED automatically.
+ */
+int mb_profile_set_fc23(mb_profile_table_t *table, uint8_t slave_id, mb_fc23_support_t support);
+
+/**
+ * @brief FC23 support of a slave
+ * @param table Profile table (may be NULL)
+ * @param slave_id Slave device ID
+ * @return FC23 support (MB_FC23_UNKNOWN without a profile)
+ */
+mb_fc23_support_t mb_profile_fc23(const mb_profile_table_t *table, uint8_t slave_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_MB_PROFILE_H
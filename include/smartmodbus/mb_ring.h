@@ -0,0 +1,140 @@
+/**
+ * @file mb_ring.h
+ * @brief Lock-free request and completion rings for a bus thread
+ *
+ * When one thread owns a master (an RS-485 port or a TCP connection),
+ * application threads hand it requests through a bounded submission ring
+ * and get results back on a completion ring of their own:
+ *
+ *     app threads --(MPSC submit ring)--> bus thread: mb_ring_service()
+ *     bus thread --(SPSC completion ring)--> each app thread
+ *
+ * Requests are copied into preallocated ring cells, so enqueueing is a
+ * few atomic operations and never allocates, locks or waits. A full or
+ * empty ring is reported at once and left to the caller to retry.
+ *
+ * The rings use per-cell sequence numbers (Vyukov's bounded queue): a
+ * producer claims a cell with one compare-and-swap (a plain store for a
+ * single-producer ring), the consumer releases it with one store. Head and
+ * tail live on separate cache lines. Atomics are the GCC/Clang builtins;
+ * elsewhere producers and consumer must share one thread.
+ */
+
+#ifndef SMARTMODBUS_MB_RING_H
+#define SMARTMODBUS_MB_RING_H
+
+#include "mb_config.h"
+#include "mb_types.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Cache line size used to keep head and tail apart
+ */
+#ifndef MB_RING_CACHE_LINE
+#define MB_RING_CACHE_LINE 64
+#endif
+
+typedef struct mb_ring mb_ring_t;
+
+/**
+ * @brief Request handed to a bus thread, returned with its result
+ *
+ * data stays owned by the submitter and must remain valid until the
+ * completion arrives.
+ */
+typedef struct {
+    uint8_t slave_id;      /**< Slave device ID */
+    uint8_t function_code; /**< 01-04 read, 05/06/15/16 write */
+    uint16_t address;      /**< First coil/register address */
+    uint16_t quantity;     /**< Coils/registers (1 for FC05/06) */
+    int result;            /**< Completion: MB_SUCCESS or error code */
+    uint16_t *data;        /**< Read output or write values (coils as 0/1) */
+    void *user;            /**< Submitter's cookie, returned unchanged */
+    mb_ring_t *reply;      /**< Completion ring (NULL: fire and forget) */
+} mb_ring_request_t;
+
+/**
+ * @brief Ring cell
+ */
+typedef struct {
+    uint32_t sequence;         /**< Free/full state of the cell for this lap */
+    mb_ring_request_t request; /**< Payload */
+} mb_ring_cell_t;
+
+/**
+ * @brief Bounded lock-free ring over caller-owned cells
+ */
+struct mb_ring {
+    mb_ring_cell_t *cells; /**< Caller-owned, capacity entries */
+    uint32_t mask;         /**< capacity - 1 */
+    bool multi_producer;   /**< Producers claim cells with compare-and-swap */
+    uint8_t pad0[MB_RING_CACHE_LINE];
+    uint32_t tail;         /**< Next cell to produce (producers) */
+    uint8_t pad1[MB_RING_CACHE_LINE - sizeof(uint32_t)];
+    uint32_t head;         /**< Next cell to consume (consumer) */
+    uint8_t pad2[MB_RING_CACHE_LINE - sizeof(uint32_t)];
+};
+
+/**
+ * @brief Initialize a ring
+ * @param ring Ring
+ * @param cells Cell array
+ * @param capacity Number of cells (a power of two, at least 2)
+ * @param multi_producer true if several threads push (MPSC), false for SPSC
+ * @return MB_SUCCESS on success, error code otherwise
+ *
+ * Not thread-safe: initialize before any thread uses the ring.
+ */
+int mb_ring_init(mb_ring_t *ring, mb_ring_cell_t *cells, uint32_t capacity, bool multi_producer);
+
+/**
+ * @brief Enqueue a request (producer side)
+ * @param ring Ring
+ * @param request Request, copied into the ring
+ * @return true if enqueued, false if the ring is full
+ */
+bool mb_ring_push(mb_ring_t *ring, const mb_ring_request_t *request);
+
+/**
+ * @brief Dequeue a request (consumer side)
+ * @param ring Ring
+ * @param request Output request
+ * @return true if dequeued, false if the ring is empty
+ */
+bool mb_ring_pop(mb_ring_t *ring, mb_ring_request_t *request);
+
+/**
+ * @brief Look at the next request without dequeuing it (consumer side)
+ * @param ring Ring
+ * @return Request, valid until mb_ring_pop(), or NULL if the ring is empty
+ */
+const mb_ring_request_t *mb_ring_peek(const mb_ring_t *ring);
+
+/**
+ * @brief Execute queued requests on the bus thread
+ * @param master Master owned by the calling thread
+ * @param submit Submission ring (this thread is its consumer)
+ * @param max_requests Requests to execute at most (0: until empty)
+ * @param serviced Output: requests executed (may be NULL)
+ * @return MB_SUCCESS; a failed request reports its error in the completion
+ *
+ * A request whose completion ring is full stays queued and ends the call,
+ * so completions are never lost; requests behind it wait with it. Each
+ * completion ring should be filled by a single bus thread.
+ */
+int mb_ring_service(mb_master_t *master,
+                    mb_ring_t *submit,
+                    uint16_t max_requests,
+                    uint16_t *serviced);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_MB_RING_H
@@ -0,0 +1,176 @@
+/**
+ * @file mb_scheduler.h
+ * @brief Multi-connection poll scheduler
+ *
+ * Runs the compiled poll plans of many masters (typically one per Modbus
+ * TCP device) at the same time, on top of the async operations in
+ * mb_async.h. Devices are split into shards so that each worker thread
+ * drives its own subset without locking; the scheduler reports when every
+ * device has finished the current scan cycle.
+ *
+ * Threading model: a device's master, plan and buffer are only touched by
+ * the thread running its shard. Cycle bookkeeping shared between shards
+ * uses atomic operations where the compiler provides them (GCC/Clang);
+ * elsewhere run all shards from one thread.
+ */
+
+#ifndef SMARTMODBUS_MB_SCHEDULER_H
+#define SMARTMODBUS_MB_SCHEDULER_H
+
+#include "mb_async.h"
+#include "mb_config.h"
+#include "mb_types.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Upper bound for shards (worker threads) per scheduler
+ */
+#define MB_SCHED_MAX_SHARDS 64
+
+/**
+ * @brief One polled device
+ */
+typedef struct {
+    mb_master_t *master;   /**< Connection (non-blocking transport) */
+    mb_poll_plan_t *poll;  /**< Plan executed every cycle */
+    uint16_t *data_buffer; /**< Output slots */
+    uint16_t buffer_size;  /**< Size of data_buffer */
+    uint16_t shard;        /**< Shard (worker) the device runs on */
+    uint32_t weight;       /**< Estimated round-trips per cycle */
+
+    uint32_t cycle;       /**< Last cycle this device was started in */
+    int last_result;      /**< Result of the last finished cycle */
+    uint32_t started_ms;  /**< Start of the current/last execution */
+    uint32_t duration_ms; /**< Duration of the last finished execution */
+    mb_async_op_t op;     /**< Async state */
+} mb_sched_device_t;
+
+/**
+ * @brief Completion report of one scan cycle
+ */
+typedef struct {
+    uint32_t cycle;       /**< Cycle number (starts at 1) */
+    uint16_t devices;     /**< Devices polled */
+    uint16_t failed;      /**< Devices whose poll failed */
+    uint32_t started_ms;  /**< Time passed to mb_scheduler_begin_cycle() */
+    uint32_t finished_ms; /**< Time of the last device completion */
+} mb_sched_cycle_t;
+
+/**
+ * @brief Cycle completion callback
+ * @param ctx User context
+ * @param report Cycle report
+ *
+ * Runs on the worker thread that finished the last device. It may call
+ * mb_scheduler_begin_cycle() to start the next cycle immediately.
+ */
+typedef void (*mb_sched_cycle_fn)(void *ctx, const mb_sched_cycle_t *report);
+
+/**
+ * @brief Scheduler
+ */
+typedef struct {
+    mb_sched_device_t *devices; /**< Caller-owned device storage */
+    uint16_t device_capacity;   /**< Entries in devices */
+    uint16_t device_count;      /**< Devices added */
+    uint16_t shard_count;       /**< Number of shards (worker threads) */
+    mb_sched_cycle_fn on_cycle;
+    void *ctx;
+
+    uint32_t cycle;      /**< Current cycle (0 = none started) */
+    uint32_t remaining;  /**< Devices not yet finished this cycle */
+    uint32_t failed;     /**< Devices failed this cycle */
+    uint32_t started_ms; /**< Start of the current cycle */
+} mb_scheduler_t;
+
+/**
+ * @brief Initialize a scheduler over caller-owned device storage
+ * @param sched Scheduler
+ * @param devices Device array
+ * @param capacity Number of entries in devices
+ * @param shard_count Number of shards, one per worker thread
+ *        (1..MB_SCHED_MAX_SHARDS)
+ * @param on_cycle Cycle completion callback (optional)
+ * @param ctx User context passed to on_cycle
+ * @return MB_SUCCESS on success, error code otherwise
+ */
+int mb_scheduler_init(mb_scheduler_t *sched,
+                      mb_sched_device_t *devices,
+                      uint16_t capacity,
+                      uint16_t shard_count,
+                      mb_sched_cycle_fn on_cycle,
+                      void *ctx);
+
+/**
+ * @brief Add a device
+ * @param sched Scheduler
+ * @param master Connection; its transport must be non-blocking
+ * @param poll Compiled poll plan for the device
+ * @param data_buffer Output buffer (>= poll->address_count entries)
+ * @param buffer_size Size of data_buffer
+ * @param max_in_flight Pipelined requests the device accepts (TCP, 1-4 for
+ *        most PLCs); written to master->config.max_in_flight
+ * @return Device index, or negative error code
+ *
+ * Devices are spread over the shards by mb_scheduler_balance().
+ */
+int mb_scheduler_add(mb_scheduler_t *sched,
+                     mb_master_t *master,
+                     mb_poll_plan_t *poll,
+                     uint16_t *data_buffer,
+                     uint16_t buffer_size,
+                     uint8_t max_in_flight);
+
+/**
+ * @brief Assign devices to shards by estimated round-trips
+ * @param sched Scheduler (no cycle in progress)
+ *
+ * Longest-processing-time first: each device goes to the currently
+ * lightest shard, heaviest devices first. A device's weight is its plan
+ * count divided by its in-flight window, rounded up.
+ */
+void mb_scheduler_balance(mb_scheduler_t *sched);
+
+/**
+ * @brief Start a scan cycle
+ * @param sched Scheduler
+ * @param now_ms Current time
+ * @return MB_SUCCESS, or MB_ERROR_INVALID_PARAM while a cycle is running
+ *
+ * Devices are submitted by their shard on its next mb_scheduler_run_shard().
+ */
+int mb_scheduler_begin_cycle(mb_scheduler_t *sched, uint32_t now_ms);
+
+/**
+ * @brief Advance every device of one shard without blocking
+ * @param sched Scheduler
+ * @param shard Shard index
+ * @param now_ms Current time
+ * @return Number of devices of the shard still busy, or negative error code
+ *
+ * Call from the shard's worker thread whenever one of its transports is
+ * ready or a deadline from mb_scheduler_next_deadline() passes.
+ */
+int mb_scheduler_run_shard(mb_scheduler_t *sched, uint16_t shard, uint32_t now_ms);
+
+/**
+ * @brief Earliest response deadline within a shard
+ * @param sched Scheduler
+ * @param shard Shard index
+ * @param deadline_ms Output: deadline
+ * @return true if a device of the shard has a request outstanding
+ */
+bool mb_scheduler_next_deadline(const mb_scheduler_t *sched,
+                                uint16_t shard,
+                                uint32_t *deadline_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_MB_SCHEDULER_H
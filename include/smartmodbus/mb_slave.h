@@ -0,0 +1,248 @@
+/**
+ * @file mb_slave.h
+ * @brief Modbus slave (server) with a flat register store
+ *
+ * A slave serves FC01-FC06, FC15, FC16 and FC23 straight from four
+ * caller-owned tables: coils, discrete inputs, holding registers and input
+ * registers. Each table is one contiguous array covering an address range,
+ * so translating an address is a subtraction and a bounds check, and a
+ * read of N registers touches N consecutive words. Declare the arrays with
+ * MB_SLAVE_ALIGNED so that every table starts on its own cache line.
+ *
+ * Frames are decoded and encoded with the master's codecs (RTU, ASCII,
+ * TCP), in place: a request is parsed as a view and the response PDU is
+ * written directly behind the header headroom of the output frame. On
+ * Linux, mb_slave_server_t adds an epoll-driven Modbus TCP front end for
+ * many connections on one thread.
+ *
+ * A slave is not thread-safe. Tables may be read by the application at any
+ * time, but values written by a request are only guaranteed to be
+ * consistent once the call that processes it has returned.
+ */
+
+#ifndef SMARTMODBUS_MB_SLAVE_H
+#define SMARTMODBUS_MB_SLAVE_H
+
+#include "mb_config.h"
+#include "mb_types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Cache line size the register tables are aligned to
+ */
+#define MB_SLAVE_CACHE_LINE 64
+
+/**
+ * @brief Align a table declaration to a cache line
+ *
+ * @code
+ * static MB_SLAVE_ALIGNED uint16_t holding[1000];
+ * @endcode
+ */
+#ifdef __cplusplus
+#define MB_SLAVE_ALIGNED alignas(MB_SLAVE_CACHE_LINE)
+#else
+#define MB_SLAVE_ALIGNED _Alignas(MB_SLAVE_CACHE_LINE)
+#endif
+
+/**
+ * @brief Words of a bit table holding count coils or discrete inputs
+ */
+#define MB_SLAVE_BIT_WORDS(count) (((count) + 31u) / 32u)
+
+/**
+ * @brief Coil or discrete input table
+ *
+ * Bit i (address base + i) is (bits[i / 32] >> (i % 32)) & 1.
+ */
+typedef struct {
+    uint32_t *bits; /**< MB_SLAVE_BIT_WORDS(count) words, NULL = table absent */
+    uint16_t base;  /**< Address of bit 0 */
+    uint16_t count; /**< Number of bits */
+} mb_slave_bits_t;
+
+/**
+ * @brief Holding or input register table
+ */
+typedef struct {
+    uint16_t *regs; /**< count registers in host order, NULL = table absent */
+    uint16_t base;  /**< Address of regs[0] */
+    uint16_t count; /**< Number of registers */
+} mb_slave_regs_t;
+
+/**
+ * @brief Notification of a completed write request
+ * @param ctx User context
+ * @param fc Function code (coil or register write, or FC23)
+ * @param address First address written
+ * @param quantity Number of coils or registers written
+ */
+typedef void (*mb_slave_write_fn)(void *ctx, uint8_t fc, uint16_t address, uint16_t quantity);
+
+/**
+ * @brief Slave setup
+ */
+typedef struct {
+    uint8_t unit_id;                 /**< Unit ID answered (0 = any) */
+    mb_slave_bits_t coils;           /**< FC01, FC05, FC15 */
+    mb_slave_bits_t discrete_inputs; /**< FC02 */
+    mb_slave_regs_t holding;         /**< FC03, FC06, FC16, FC23 */
+    mb_slave_regs_t input;           /**< FC04 */
+    mb_slave_write_fn on_write;      /**< Called after each write (optional) */
+    void *context;                   /**< Context passed to on_write */
+} mb_slave_config_t;
+
+/**
+ * @brief Slave counters
+ */
+typedef struct {
+    uint32_t requests;   /**< Requests processed */
+    uint32_t exceptions; /**< Exception responses */
+    uint32_t ignored;    /**< Frames not answered (other unit, broadcast, bad frame) */
+} mb_slave_stats_t;
+
+/**
+ * @brief Slave state
+ */
+typedef struct {
+    mb_slave_config_t config; /**< Setup */
+    mb_slave_stats_t stats;   /**< Counters */
+} mb_slave_t;
+
+/**
+ * @brief Initialize a slave
+ * @param slave Slave
+ * @param config Setup (copied; the tables stay caller-owned)
+ * @return MB_SUCCESS on success, error code otherwise
+ *
+ * A table's address range must not wrap past 0xFFFF.
+ */
+int mb_slave_init(mb_slave_t *slave, const mb_slave_config_t *config);
+
+/**
+ * @brief Execute one request PDU
+ * @param slave Slave
+ * @param fc Request function code
+ * @param pdu Request PDU data (without function code)
+ * @param pdu_length Request PDU data length
+ * @param response_fc Output: response function code (0x80 set for an exception)
+ * @param response Output: response PDU data (at least 252 bytes)
+ * @param response_length Output: response PDU data length
+ * @return MB_SUCCESS on success (including exception responses), error code otherwise
+ */
+int mb_slave_process_pdu(mb_slave_t *slave,
+                         uint8_t fc,
+                         const uint8_t *pdu,
+                         uint16_t pdu_length,
+                         uint8_t *response_fc,
+                         uint8_t *response,
+                         uint16_t *response_length);
+
+/**
+ * @brief Execute one request frame and build the response frame
+ * @param slave Slave
+ * @param mode Framing of request and response
+ * @param request Request frame (ASCII frames are decoded in place)
+ * @param request_length Request frame length
+ * @param response Output: response frame
+ * @param buffer_size Response buffer size, at least mb_calc_frame_length(252, mode)
+ * @param response_length Output: response frame length, 0 if nothing is to be sent
+ * @return MB_SUCCESS on success, error code otherwise
+ *
+ * Frames for another unit, serial broadcasts (unit 0, executed but not
+ * answered) and frames failing their CRC/LRC produce no response, as on a
+ * real line.
+ */
+int mb_slave_process_frame(mb_slave_t *slave,
+                           mb_mode_t mode,
+                           uint8_t *request,
+                           uint16_t request_length,
+                           uint8_t *response,
+                           uint16_t buffer_size,
+                           uint16_t *response_length);
+
+#ifdef MB_ENABLE_SLAVE_SERVER
+
+/**
+ * @brief Receive and transmit buffer size per TCP connection
+ *
+ * Pipelined requests are processed in bursts: everything received in one
+ * read is answered with one send.
+ */
+#ifndef MB_SLAVE_SERVER_BUFFER
+#define MB_SLAVE_SERVER_BUFFER 4096
+#endif
+
+/**
+ * @brief TCP connection slot
+ */
+typedef struct {
+    int fd;                              /**< Socket, -1 when the slot is free */
+    uint16_t rx_length;                  /**< Bytes in rx */
+    uint16_t tx_offset;                  /**< Bytes of tx already sent */
+    uint16_t tx_length;                  /**< Bytes in tx */
+    bool writing;                        /**< Waiting for the socket to drain tx */
+    uint8_t rx[MB_SLAVE_SERVER_BUFFER];  /**< Received, not yet processed */
+    uint8_t tx[MB_SLAVE_SERVER_BUFFER];  /**< Responses not yet sent */
+} mb_slave_connection_t;
+
+/**
+ * @brief Modbus TCP server
+ */
+typedef struct {
+    mb_slave_t *slave;                  /**< Slave answering the requests */
+    mb_slave_connection_t *connections; /**< Connection slots */
+    uint16_t capacity;                  /**< Number of slots */
+    uint16_t open;                      /**< Slots in use */
+    uint16_t port;                      /**< Bound TCP port */
+    int listen_fd;                      /**< Listening socket */
+    int epoll_fd;                       /**< epoll instance */
+    uint32_t accepted;                  /**< Connections accepted */
+    uint32_t rejected;                  /**< Connections closed because all slots were busy */
+} mb_slave_server_t;
+
+/**
+ * @brief Start listening
+ * @param server Server
+ * @param slave Slave answering the requests
+ * @param bind_address IPv4 address to bind (NULL = any)
+ * @param port TCP port (0 = any free port, see server->port)
+ * @param connections Connection slots
+ * @param capacity Number of slots
+ * @return MB_SUCCESS on success, error code otherwise
+ */
+int mb_slave_server_open(mb_slave_server_t *server,
+                         mb_slave_t *slave,
+                         const char *bind_address,
+                         uint16_t port,
+                         mb_slave_connection_t *connections,
+                         uint16_t capacity);
+
+/**
+ * @brief Wait for socket activity and serve it
+ * @param server Server
+ * @param timeout_ms Longest wait (-1 = until activity, 0 = do not wait)
+ * @return Number of requests answered, or negative error code
+ */
+int mb_slave_server_poll(mb_slave_server_t *server, int timeout_ms);
+
+/**
+ * @brief Close every connection and the listening socket
+ * @param server Server
+ */
+void mb_slave_server_close(mb_slave_server_t *server);
+
+#endif  // MB_ENABLE_SLAVE_SERVER
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_MB_SLAVE_H
@@ -0,0 +1,494 @@
+/**
+ * @file mb_static_poll.hpp
+ * @brief Header-only C++20 poll plans compiled at build time
+ *
+ * For a register map fixed in firmware, the greedy planner (gap-aware merge
+ * and FFD packing, as mb_poll_plan_compile() runs them) is evaluated by the
+ * compiler. The result is constant data: plans, request frames with their
+ * CRC/LRC and the scatter map, which the linker places in flash.
+ *
+ * @code
+ * constexpr uint16_t meter_registers[] = {100, 101, 105, 106, 110, 111, 115};
+ * constexpr auto meter = smartmodbus::compile_poll(1, MB_FC_READ_HOLDING_REGISTERS,
+ *                                                  meter_registers, MB_MODE_RTU);
+ *
+ * uint16_t data[7];
+ * int result = smartmodbus::StaticPoll<meter>::execute(master, data, 7);
+ * @endcode
+ *
+ * compile_poll() is consteval: an invalid request (unsupported function
+ * code, address past 0xFFFF, too many plans) fails the build. The compiled
+ * image must be a constexpr variable with static storage duration, since
+ * StaticPoll references it as a template argument.
+ *
+ * Learned device profiles cannot be applied at build time; a static plan is
+ * never re-planned. Once a slave rejects a plan, mb_master_execute_static_poll()
+ * returns the exception and a runtime mb_poll_plan_compile() takes over.
+ */
+
+#ifndef SMARTMODBUS_MB_STATIC_POLL_HPP
+#define SMARTMODBUS_MB_STATIC_POLL_HPP
+
+#include "smartmodbus/smartmodbus.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace smartmodbus {
+
+/**
+ * @brief Planner settings used at build time (mb_config_t counterparts)
+ */
+struct PollOptions {
+    uint8_t latency_chars;  /**< config.latency_chars */
+    uint16_t max_pdu_chars; /**< config.max_pdu_chars */
+};
+
+/**
+ * @brief mb_config_default() planner settings for a mode
+ */
+constexpr PollOptions default_poll_options(mb_mode_t mode) {
+    bool serial = mode == MB_MODE_RTU || mode == MB_MODE_ASCII;
+    return PollOptions{static_cast<uint8_t>(serial ? 2 : 1), 253};
+}
+
+/**
+ * @brief Plans, frames and scatter map for N requested addresses
+ *
+ * Sized for the worst case (one plan per address); StaticPoll keeps only
+ * plan_count plans.
+ */
+template <std::size_t N>
+struct PollImage {
+    mb_mode_t mode{};
+    uint16_t plan_count = 0;
+    uint16_t frame_chars = 0;
+    std::array<mb_request_plan_t, N> plans{};
+    std::array<mb_scatter_entry_t, N> scatter{};
+    std::array<std::array<uint8_t, MB_PLAN_FRAME_CHARS>, N> frames{};
+};
+
+namespace detail {
+
+// Never defined: reaching one in a constant evaluation fails the build
+void static_poll_unsupported_function_code();
+void static_poll_unsupported_mode();
+void static_poll_address_out_of_range();
+void static_poll_too_many_plans();
+
+/**
+ * @brief Read function code rows of the fc_policy table
+ */
+struct ReadPolicy {
+    bool bits;
+    uint8_t overhead_chars; /**< req_fixed_chars + resp_fixed_chars */
+    uint16_t max_quantity;
+};
+
+consteval ReadPolicy read_policy(uint8_t fc) {
+    switch (fc) {
+        case MB_FC_READ_COILS:
+        case MB_FC_READ_DISCRETE_INPUTS:
+            return ReadPolicy{true, 6 + 5, 2000};
+        case MB_FC_READ_HOLDING_REGISTERS:
+        case MB_FC_READ_INPUT_REGISTERS:
+            return ReadPolicy{false, 6 + 5, 125};
+        default:
+            static_poll_unsupported_function_code();
+            return ReadPolicy{};
+    }
+}
+
+/**
+ * @brief Address range [start, start + quantity) of a block or PDU
+ */
+struct Span {
+    uint32_t start;
+    uint32_t quantity;
+
+    constexpr uint32_t end() const { return start + quantity; }
+};
+
+constexpr uint32_t data_bytes(const ReadPolicy &policy, uint32_t quantity) {
+    return policy.bits ? (quantity + 7) / 8 : quantity * 2;
+}
+
+/**
+ * @brief Same table as crc16.c (polynomial 0xA001), generated at compile time
+ */
+consteval std::array<uint16_t, 256> make_crc16_table() {
+    std::array<uint16_t, 256> table{};
+    for (uint32_t byte = 0; byte < 256; byte++) {
+        uint16_t crc = static_cast<uint16_t>(byte);
+        for (int bit = 0; bit < 8; bit++) {
+            crc = static_cast<uint16_t>((crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1);
+        }
+        table[byte] = crc;
+    }
+    return table;
+}
+
+inline constexpr std::array<uint16_t, 256> crc16_table = make_crc16_table();
+
+consteval uint16_t crc16(const uint8_t *data, std::size_t length) {
+    uint16_t crc = 0xFFFF;
+    for (std::size_t i = 0; i < length; i++) {
+        crc = static_cast<uint16_t>((crc >> 8) ^ crc16_table[(crc ^ data[i]) & 0xFF]);
+    }
+    return crc;
+}
+
+consteval uint16_t frame_chars(mb_mode_t mode) {
+    switch (mode) {
+        case MB_MODE_RTU:
+        case MB_MODE_RTU_OVER_TCP:
+            return 1 + 1 + 4 + 2;
+        case MB_MODE_ASCII: return 1 + 2 + 2 + 8 + 2 + 2;
+        case MB_MODE_TCP:   return 7 + 1 + 4;
+        default:
+            static_poll_unsupported_mode();
+            return 0;
+    }
+}
+
+/**
+ * @brief Response frame length for a response PDU, as mb_calc_frame_length()
+ */
+consteval uint16_t response_chars(mb_mode_t mode, uint32_t pdu_length) {
+    switch (mode) {
+        case MB_MODE_RTU:
+        case MB_MODE_RTU_OVER_TCP:
+            return static_cast<uint16_t>(1 + 1 + pdu_length + 2);
+        case MB_MODE_ASCII: return static_cast<uint16_t>(1 + 2 + 2 + pdu_length * 2 + 2 + 2);
+        default:            return static_cast<uint16_t>(7 + 1 + pdu_length);
+    }
+}
+
+/**
+ * @brief Read request frame, as mb_build_frame() with transaction ID 0
+ */
+consteval void build_read_frame(mb_mode_t mode,
+                                const mb_request_plan_t &plan,
+                                std::array<uint8_t, MB_PLAN_FRAME_CHARS> &frame) {
+    const uint8_t adu[6] = {plan.slave_id,
+                            plan.function_code,
+                            static_cast<uint8_t>(plan.start_address >> 8),
+                            static_cast<uint8_t>(plan.start_address & 0xFF),
+                            static_cast<uint8_t>(plan.quantity >> 8),
+                            static_cast<uint8_t>(plan.quantity & 0xFF)};
+
+    if (MB_MODE_FRAMING(mode) == MB_MODE_RTU) {
+        uint16_t crc = crc16(adu, sizeof(adu));
+        for (std::size_t i = 0; i < sizeof(adu); i++) {
+            frame[i] = adu[i];
+        }
+        frame[6] = static_cast<uint8_t>(crc & 0xFF);
+        frame[7] = static_cast<uint8_t>(crc >> 8);
+    } else if (mode == MB_MODE_ASCII) {
+        constexpr char hex[] = "0123456789ABCDEF";
+        uint8_t sum          = 0;
+        std::size_t pos      = 0;
+        frame[pos++]         = ':';
+        for (std::size_t i = 0; i <= sizeof(adu); i++) {
+            uint8_t byte = i < sizeof(adu) ? adu[i] : static_cast<uint8_t>(-sum);
+            sum          = static_cast<uint8_t>(sum + byte);
+            frame[pos++] = static_cast<uint8_t>(hex[byte >> 4]);
+            frame[pos++] = static_cast<uint8_t>(hex[byte & 0x0F]);
+        }
+        frame[pos++] = '\r';
+        frame[pos++] = '\n';
+    } else {
+        // MBAP: transaction ID (patched per send), protocol 0, length, unit
+        frame[4] = 0;
+        frame[5] = static_cast<uint8_t>(sizeof(adu));
+        for (std::size_t i = 0; i < sizeof(adu); i++) {
+            frame[6 + i] = adu[i];
+        }
+    }
+}
+
+}  // namespace detail
+
+/**
+ * @brief Plan a read request at compile time
+ * @param slave_id Slave device ID
+ * @param function_code FC01-FC04
+ * @param addresses Requested addresses; data[i] receives addresses[i]
+ * @param mode Protocol mode the frames are built for
+ * @param options Planner settings (defaults: mb_config_default(mode))
+ *
+ * Produces the plans mb_poll_plan_compile() would for a master with the
+ * same mode, latency_chars and max_pdu_chars, the greedy planner, no
+ * learned profiles and the character cost model (no config.link).
+ */
+template <std::size_t N>
+consteval PollImage<N> compile_poll(uint8_t slave_id,
+                                    uint8_t function_code,
+                                    const std::array<uint16_t, N> &addresses,
+                                    mb_mode_t mode,
+                                    PollOptions options) {
+    static_assert(N > 0 && N <= UINT16_MAX, "A poll needs 1 to 65535 addresses");
+
+    const detail::ReadPolicy policy = detail::read_policy(function_code);
+    PollImage<N> image;
+    image.mode        = mode;
+    image.frame_chars = detail::frame_chars(mode);
+
+    // Step 1: sorted, deduplicated runs of consecutive addresses
+    std::array<uint32_t, N> sorted{};
+    for (std::size_t i = 0; i < N; i++) {
+        std::size_t j = i;
+        while (j > 0 && sorted[j - 1] > addresses[i]) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = addresses[i];
+    }
+
+    std::array<detail::Span, N> blocks{};
+    std::size_t block_count = 0;
+    for (std::size_t i = 0; i < N; i++) {
+        if (block_count > 0 && blocks[block_count - 1].end() >= sorted[i]) {
+            if (blocks[block_count - 1].end() == sorted[i]) {
+                blocks[block_count - 1].quantity++;
+            }
+            continue;
+        }
+        blocks[block_count++] = detail::Span{sorted[i], 1};
+    }
+
+    // Step 2: gap-aware merge (mb_merge_block_array): merge while reading
+    // the gap costs fewer characters than another round-trip
+    bool serial       = mode == MB_MODE_RTU || mode == MB_MODE_ASCII;
+    uint32_t overhead = policy.overhead_chars + (serial ? 4u : 0u) + options.latency_chars;
+    std::size_t merged = 0;
+    for (std::size_t i = 0; i < block_count; i++) {
+        if (merged > 0) {
+            detail::Span &current = blocks[merged - 1];
+            uint32_t gap          = blocks[i].start - current.end();
+            if (detail::data_bytes(policy, gap) < overhead) {
+                current.quantity = blocks[i].end() - current.start;
+                continue;
+            }
+        }
+        blocks[merged++] = blocks[i];
+    }
+    block_count = merged;
+
+    // Step 3: FFD packing (mb_ffd_pack_inplace): largest block first into
+    // the neighboring PDU that grows least, else new full-size chunks
+    for (std::size_t i = 1; i < block_count; i++) {
+        detail::Span block = blocks[i];
+        std::size_t j      = i;
+        while (j > 0 && blocks[j - 1].quantity < block.quantity) {
+            blocks[j] = blocks[j - 1];
+            j--;
+        }
+        blocks[j] = block;
+    }
+
+    uint32_t limit = policy.bits ? options.max_pdu_chars * 8u : options.max_pdu_chars / 2u;
+    limit          = limit < policy.max_quantity ? limit : policy.max_quantity;
+    if (limit == 0) {
+        detail::static_poll_too_many_plans();
+    }
+
+    auto fits = [&](const detail::Span &block, const detail::Span &pdu) {
+        uint32_t start = block.start < pdu.start ? block.start : pdu.start;
+        uint32_t end   = block.end() > pdu.end() ? block.end() : pdu.end();
+        return end - start <= policy.max_quantity &&
+               detail::data_bytes(policy, end - start) <= options.max_pdu_chars;
+    };
+    auto growth = [](const detail::Span &block, const detail::Span &pdu) {
+        uint32_t start = block.start < pdu.start ? block.start : pdu.start;
+        uint32_t end   = block.end() > pdu.end() ? block.end() : pdu.end();
+        return end - start - pdu.quantity;
+    };
+
+    std::array<detail::Span, N> pdus{};
+    std::size_t pdu_count = 0;
+    for (std::size_t i = 0; i < block_count; i++) {
+        const detail::Span &block = blocks[i];
+
+        std::size_t next = 0;
+        while (next < pdu_count && pdus[next].start <= block.start) {
+            next++;
+        }
+
+        detail::Span *target = nullptr;
+        uint32_t least       = UINT32_MAX;
+        if (next > 0 && fits(block, pdus[next - 1])) {
+            target = &pdus[next - 1];
+            least  = growth(block, *target);
+        }
+        if (next < pdu_count && fits(block, pdus[next]) && growth(block, pdus[next]) < least) {
+            target = &pdus[next];
+        }
+
+        if (target != nullptr) {
+            uint32_t start   = block.start < target->start ? block.start : target->start;
+            uint32_t end     = block.end() > target->end() ? block.end() : target->end();
+            *target          = detail::Span{start, end - start};
+            continue;
+        }
+
+        std::size_t chunks = (block.quantity + limit - 1) / limit;
+        if (chunks > N - pdu_count) {
+            detail::static_poll_too_many_plans();
+        }
+        for (std::size_t k = pdu_count; k-- > next;) {
+            pdus[k + chunks] = pdus[k];
+        }
+        for (std::size_t c = 0; c < chunks; c++) {
+            uint32_t start   = block.start + static_cast<uint32_t>(c) * limit;
+            uint32_t left    = block.end() - start;
+            pdus[next + c]   = detail::Span{start, left < limit ? left : limit};
+        }
+        pdu_count += chunks;
+    }
+
+    // Step 4: plans in address order, with prebuilt frames
+    image.plan_count = static_cast<uint16_t>(pdu_count);
+    for (std::size_t p = 0; p < pdu_count; p++) {
+        mb_request_plan_t &plan       = image.plans[p];
+        plan.slave_id                 = slave_id;
+        plan.function_code            = function_code;
+        plan.start_address            = static_cast<uint16_t>(pdus[p].start);
+        plan.quantity                 = static_cast<uint16_t>(pdus[p].quantity);
+        plan.frame_data               = nullptr;
+        plan.frame_length             = image.frame_chars;
+        plan.expected_response_length = detail::response_chars(
+            mode, 1 + detail::data_bytes(policy, pdus[p].quantity));
+        detail::build_read_frame(mode, plan, image.frames[p]);
+    }
+
+    // Step 5: scatter map grouped by plan (mb_build_scatter_map)
+    auto find_plan = [&](uint32_t address) {
+        std::size_t p = pdu_count;
+        while (p > 0 && pdus[p - 1].start > address) {
+            p--;
+        }
+        while (p > 0) {
+            p--;
+            if (address < pdus[p].end()) {
+                return p;
+            }
+        }
+        detail::static_poll_address_out_of_range();
+        return pdu_count;
+    };
+
+    for (std::size_t i = 0; i < N; i++) {
+        image.plans[find_plan(addresses[i])].scatter_count++;
+    }
+    uint16_t first = 0;
+    for (std::size_t p = 0; p < pdu_count; p++) {
+        image.plans[p].scatter_first = first;
+        first                        = static_cast<uint16_t>(first + image.plans[p].scatter_count);
+    }
+    std::array<uint16_t, N> cursor{};
+    for (std::size_t i = 0; i < N; i++) {
+        std::size_t p           = find_plan(addresses[i]);
+        mb_scatter_entry_t &slot = image.scatter[image.plans[p].scatter_first + cursor[p]++];
+        slot.plan_index          = static_cast<uint16_t>(p);
+        slot.offset              = static_cast<uint16_t>(addresses[i] - pdus[p].start);
+        slot.dest_index          = static_cast<uint16_t>(i);
+    }
+
+    return image;
+}
+
+template <std::size_t N>
+consteval PollImage<N> compile_poll(uint8_t slave_id,
+                                    uint8_t function_code,
+                                    const std::array<uint16_t, N> &addresses,
+                                    mb_mode_t mode) {
+    return compile_poll(slave_id, function_code, addresses, mode, default_poll_options(mode));
+}
+
+template <std::size_t N>
+consteval PollImage<N> compile_poll(uint8_t slave_id,
+                                    uint8_t function_code,
+                                    const uint16_t (&addresses)[N],
+                                    mb_mode_t mode,
+                                    PollOptions options) {
+    std::array<uint16_t, N> list{};
+    for (std::size_t i = 0; i < N; i++) {
+        list[i] = addresses[i];
+    }
+    return compile_poll(slave_id, function_code, list, mode, options);
+}
+
+template <std::size_t N>
+consteval PollImage<N> compile_poll(uint8_t slave_id,
+                                    uint8_t function_code,
+                                    const uint16_t (&addresses)[N],
+                                    mb_mode_t mode) {
+    return compile_poll(slave_id, function_code, addresses, mode, default_poll_options(mode));
+}
+
+/**
+ * @brief Flash-resident poll plan for a compiled image
+ *
+ * Keeps exactly Image.plan_count plans and frames of the mode's length.
+ * Everything is constant data except TCP frames: they are kept in RAM
+ * (constant-initialized, no startup code) because the transaction ID is
+ * patched per send.
+ */
+template <const auto &Image>
+class StaticPoll {
+  public:
+    static constexpr uint16_t plan_count    = Image.plan_count;
+    static constexpr uint16_t address_count = static_cast<uint16_t>(Image.scatter.size());
+
+    /** @brief C view for mb_master_execute_static_poll() */
+    static constexpr const mb_static_poll_t *get() { return &poll_; }
+
+    static int execute(mb_master_t &master, uint16_t *data_buffer, uint16_t buffer_size) {
+        return mb_master_execute_static_poll(&master, &poll_, data_buffer, buffer_size);
+    }
+
+  private:
+    static constexpr std::size_t frame_chars = Image.frame_chars;
+    using Frames = std::array<uint8_t, frame_chars * plan_count>;
+
+    static constexpr Frames make_frames() {
+        Frames frames{};
+        for (std::size_t p = 0; p < plan_count; p++) {
+            for (std::size_t i = 0; i < frame_chars; i++) {
+                frames[p * frame_chars + i] = Image.frames[p][i];
+            }
+        }
+        return frames;
+    }
+
+    static constexpr Frames rom_frames_ = make_frames();
+    static inline Frames ram_frames_    = make_frames();
+
+    static constexpr uint8_t *frame_at(std::size_t p) {
+        if constexpr (Image.mode == MB_MODE_TCP) {
+            return ram_frames_.data() + p * frame_chars;
+        } else {
+            // Sent, never written
+            return const_cast<uint8_t *>(rom_frames_.data() + p * frame_chars);
+        }
+    }
+
+    static constexpr std::array<mb_request_plan_t, plan_count> make_plans() {
+        std::array<mb_request_plan_t, plan_count> plans{};
+        for (std::size_t p = 0; p < plan_count; p++) {
+            plans[p]            = Image.plans[p];
+            plans[p].frame_data = frame_at(p);
+        }
+        return plans;
+    }
+
+    static constexpr std::array<mb_request_plan_t, plan_count> plans_ = make_plans();
+    static constexpr mb_static_poll_t poll_ = {Image.mode, address_count, plan_count,
+                                               plans_.data(), Image.scatter.data()};
+};
+
+}  // namespace smartmodbus
+
+#endif  // SMARTMODBUS_MB_STATIC_POLL_HPP
@@ -0,0 +1,175 @@
+/**
+ * @file mb_tcp_client.h
+ * @brief Reference Modbus TCP client transport for Linux
+ *
+ * mb_tcp_client_t implements mb_transport_t over a TCP socket. A pipelined
+ * window handed over through send_frames() leaves in one writev() instead
+ * of one send() per request.
+ *
+ * Clients attached to an mb_tcp_uring_t do not write themselves: their
+ * frames are queued in the client and mb_tcp_uring_submit() sends the
+ * queues of every attached socket with one io_uring_enter(). An
+ * application driving many masters through mb_async_step() submits once
+ * per pass over its masters, so the transmit side of a poll cycle costs
+ * one system call regardless of the number of connections.
+ */
+
+#ifndef SMARTMODBUS_MB_TCP_CLIENT_H
+#define SMARTMODBUS_MB_TCP_CLIENT_H
+
+#include "mb_transport.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef MB_ENABLE_TCP_CLIENT
+
+/**
+ * @brief Transmit queue of a client attached to an io_uring
+ *
+ * Holds the frames queued between two mb_tcp_uring_submit() calls: a
+ * full pipelined window of FC16 requests fits the default.
+ */
+#ifndef MB_TCP_CLIENT_TX_BUFFER
+#define MB_TCP_CLIENT_TX_BUFFER 2048
+#endif
+
+/**
+ * @brief Clients one io_uring can serve (and its submission queue depth)
+ */
+#ifndef MB_TCP_URING_CLIENTS
+#define MB_TCP_URING_CLIENTS 64
+#endif
+
+typedef struct mb_tcp_uring mb_tcp_uring_t;
+
+/**
+ * @brief TCP client connection
+ */
+typedef struct {
+    int fd;                              /**< Socket, -1 when closed */
+    uint32_t timeout_ms;                 /**< recv() wait, 0 = return at once */
+    uint32_t send_calls;                 /**< send()/sendmsg() calls made */
+    uint32_t recv_calls;                 /**< poll()/recv() calls made */
+    mb_tcp_uring_t *ring;                /**< Submission ring, NULL = write directly */
+    bool queued;                         /**< In the ring's submit list */
+    uint16_t tx_offset;                  /**< Bytes of tx already sent */
+    uint16_t tx_length;                  /**< Bytes in tx */
+    uint8_t tx[MB_TCP_CLIENT_TX_BUFFER]; /**< Frames waiting for the next submit */
+} mb_tcp_client_t;
+
+/**
+ * @brief Connect to a Modbus TCP server
+ * @param client Client
+ * @param host IPv4 address of the server
+ * @param port TCP port
+ * @param timeout_ms Response timeout of recv() (0 = non-blocking, for async use)
+ * @return MB_SUCCESS on success, error code otherwise
+ */
+int mb_tcp_client_open(mb_tcp_client_t *client,
+                       const char *host,
+                       uint16_t port,
+                       uint32_t timeout_ms);
+
+/**
+ * @brief Use an already connected stream socket
+ * @param client Client
+ * @param fd Connected socket; closed by mb_tcp_client_close()
+ * @param timeout_ms Response timeout of recv() (0 = non-blocking)
+ */
+void mb_tcp_client_adopt(mb_tcp_client_t *client, int fd, uint32_t timeout_ms);
+
+/**
+ * @brief Fill in transport callbacks for a client
+ * @param client Client (becomes the transport context)
+ * @param transport Transport to fill in
+ *
+ * Sets send, send_frames, recv, set_timeout and clock_us; the other
+ * callbacks are left NULL.
+ */
+void mb_tcp_client_transport(mb_tcp_client_t *client, mb_transport_t *transport);
+
+/**
+ * @brief Close the socket
+ * @param client Client
+ *
+ * Frames still queued for an io_uring are dropped.
+ */
+void mb_tcp_client_close(mb_tcp_client_t *client);
+
+#ifdef MB_ENABLE_TCP_URING
+
+/**
+ * @brief io_uring shared by many clients
+ *
+ * The ring memory is mapped by mb_tcp_uring_init(); the fields are
+ * internal.
+ */
+struct mb_tcp_uring {
+    int fd;                                       /**< io_uring file descriptor */
+    void *sq_map;                                 /**< Submission ring mapping */
+    size_t sq_map_size;                           /**< Bytes mapped at sq_map */
+    void *cq_map;                                 /**< Completion ring mapping */
+    size_t cq_map_size;                           /**< Bytes mapped at cq_map */
+    void *sqes;                                   /**< Submission entries */
+    size_t sqes_size;                             /**< Bytes mapped at sqes */
+    uint32_t sq_off[4];                           /**< head, tail, mask, array offsets */
+    uint32_t cq_off[4];                           /**< head, tail, mask, cqes offsets */
+    uint16_t attached;                            /**< Clients attached */
+    uint16_t queued;                              /**< Entries used in queue */
+    mb_tcp_client_t *queue[MB_TCP_URING_CLIENTS]; /**< Clients with frames waiting */
+    uint32_t submits;                             /**< io_uring_enter() calls made */
+};
+
+/**
+ * @brief Set up an io_uring
+ * @param ring Ring
+ * @return MB_SUCCESS, or MB_ERROR_NOT_SUPPORTED if the kernel refuses io_uring
+ */
+int mb_tcp_uring_init(mb_tcp_uring_t *ring);
+
+/**
+ * @brief Queue a client's frames on a ring instead of writing them
+ * @param ring Ring
+ * @param client Client
+ * @return MB_SUCCESS, or MB_ERROR_NO_MEMORY once MB_TCP_URING_CLIENTS are attached
+ *
+ * The client's send() and send_frames() then only copy into client->tx.
+ * A recv() with a timeout submits the ring first, so a blocking master
+ * never waits for a response to a request that has not left.
+ */
+int mb_tcp_uring_attach(mb_tcp_uring_t *ring, mb_tcp_client_t *client);
+
+/**
+ * @brief Send the queued frames of every attached client
+ * @param ring Ring
+ * @return MB_SUCCESS, or MB_ERROR_TRANSPORT if a socket failed (the other
+ *         clients' frames are still sent; the failed client's are dropped)
+ *
+ * One io_uring_enter() submits a send per queued client and waits for all
+ * of them; only short sends cost another round.
+ */
+int mb_tcp_uring_submit(mb_tcp_uring_t *ring);
+
+/**
+ * @brief Unmap the ring
+ * @param ring Ring
+ *
+ * Detach (close) the clients first; their queued frames are not sent.
+ */
+void mb_tcp_uring_close(mb_tcp_uring_t *ring);
+
+#endif  // MB_ENABLE_TCP_URING
+
+#endif  // MB_ENABLE_TCP_CLIENT
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_MB_TCP_CLIENT_H
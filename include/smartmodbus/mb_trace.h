@@ -0,0 +1,76 @@
+/**
+ * @file mb_trace.h
+ * @brief Hot-path trace hooks
+ *
+ * Built with MB_ENABLE_TRACE, the master reports each phase of a read to
+ * a user hook with a timestamp: planning, frame encoding, the send call,
+ * the first and last chunk of the response, frame validation, and the
+ * scatter of values into the caller's buffers. Per round-trip that splits
+ * the time into
+ *
+ * - SEND_BEGIN to SEND_END: the transport's send(), including any wait
+ *   for the bus (RS-485 turnaround, a shared line, a full socket buffer)
+ * - SEND_END to RECV_FIRST: the slave's turnaround
+ * - RECV_FIRST to RECV_LAST: the response on the wire
+ * - everything else: the library's own CPU time
+ *
+ * Without MB_ENABLE_TRACE the hooks compile to nothing and mb_config_t
+ * has no trace member.
+ */
+
+#ifndef SMARTMODBUS_MB_TRACE_H
+#define SMARTMODBUS_MB_TRACE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Traced phase boundaries
+ */
+typedef enum {
+    MB_TRACE_OPTIMIZE_BEGIN = 0, /**< Planning of a request window starts */
+    MB_TRACE_OPTIMIZE_END,       /**< Plans are ready (chars: plan count) */
+    MB_TRACE_BUILD_BEGIN,        /**< Frame encoding starts (not for prebuilt frames) */
+    MB_TRACE_BUILD_END,          /**< Frame encoded */
+    MB_TRACE_SEND_BEGIN,         /**< send() called (chars: frame length) */
+    MB_TRACE_SEND_END,           /**< send() returned */
+    MB_TRACE_RECV_FIRST,         /**< First response chunk returned (chars: chunk length) */
+    MB_TRACE_RECV_LAST,          /**< Response complete (chars: frame length) */
+    MB_TRACE_PARSE_BEGIN,        /**< Frame validation starts */
+    MB_TRACE_PARSE_END,          /**< Frame validated (result: outcome) */
+    MB_TRACE_SCATTER_BEGIN,      /**< Response handler (scatter) starts */
+    MB_TRACE_SCATTER_END,        /**< Response handled (result: outcome) */
+} mb_trace_event_t;
+
+/**
+ * @brief One trace event
+ */
+typedef struct {
+    mb_trace_event_t event; /**< Phase boundary */
+    uint8_t slave_id;       /**< Slave of the transaction (0 for planning) */
+    uint8_t function_code;  /**< Request function code */
+    uint16_t chars;         /**< Event-specific character or plan count */
+    int result;             /**< MB_SUCCESS or the error ending the phase */
+    uint32_t timestamp_us;  /**< Trace clock (see mb_trace_t) */
+} mb_trace_record_t;
+
+/**
+ * @brief Trace hook configuration (config.trace)
+ *
+ * The hook runs inline on the master's thread: keep it to copying the
+ * record into a ring buffer.
+ */
+typedef struct {
+    void (*hook)(void *ctx, const mb_trace_record_t *record); /**< NULL disables tracing */
+    uint32_t (*clock_us)(void *ctx); /**< Timestamps (NULL: transport.clock_us, else 0) */
+    void *context;                   /**< Passed to hook and clock_us */
+} mb_trace_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_MB_TRACE_H
@@ -9,6 +9,7 @@
 #ifndef SMARTMODBUS_MB_TRANSPORT_H
 #define SMARTMODBUS_MB_TRANSPORT_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -16,6 +17,14 @@
 extern "C" {
 #endif
 
+/**
+ * @brief One frame of a vectored send
+ */
+typedef struct {
+    const uint8_t *data; /**< Frame bytes */
+    size_t len;          /**< Frame length in bytes */
+} mb_frame_vec_t;
+
 /**
  * @brief Transport layer callbacks
  *
@@ -59,6 +68,78 @@ typedef struct {
      * to store transport-specific state (e.g., file descriptor, UART handle).
      */
     void *context;
+
+    /**
+     * @brief Lend a TX buffer for in-place frame encoding (optional)
+     * @param ctx User context pointer
+     * @param size Output: buffer capacity in bytes
+     * @return Buffer, or NULL to fall back to the master's own buffer
+     *
+     * The request is encoded directly into this buffer and send() is then
+     * called with data pointing into it, so no copy is needed on the way out.
+     */
+    uint8_t *(*tx_buffer)(void *ctx, size_t *size);
+
+    /**
+     * @brief Receive one frame without copying (optional, RTU/ASCII only)
+     * @param ctx User context pointer
+     * @param data Output: frame inside the transport's RX buffer
+     * @param received Output: frame length in bytes
+     * @return 0 on success, negative error code on failure
+     *
+     * Used instead of recv() in serial modes when set. The buffer must stay
+     * valid and writable until the next call; ASCII frames are decoded in
+     * place. TCP always reassembles the stream through recv().
+     */
+    int (*recv_view)(void *ctx, uint8_t **data, size_t *received);
+
+    /**
+     * @brief Free-running microsecond clock (optional)
+     * @param ctx User context pointer
+     * @return Current time in microseconds (wraps)
+     *
+     * When set together with config.profiles, every stop-and-wait
+     * round-trip is timed and recorded in the slave's profile.
+     */
+    uint32_t (*clock_us)(void *ctx);
+
+    /**
+     * @brief recv() waits for max_len bytes or the end-of-frame silence (optional, RTU only)
+     *
+     * Set for transports that complete a read when max_len bytes have
+     * arrived (DMA with a transfer count, termios VMIN, a FIFO threshold).
+     * The master then asks for the 3-byte header first and then for exactly
+     * the rest of the response as given by its function code and byte count,
+     * so the read returns with the last byte instead of at the timeout.
+     * Without it the first read may return the whole frame or any part of
+     * it; the master keeps reading until the frame is complete either way.
+     */
+    bool recv_exact;
+
+    /**
+     * @brief Set the response timeout of the next recv() (optional)
+     * @param ctx User context pointer
+     * @param timeout_ms Longest wait for the response
+     *
+     * Called before every stop-and-wait response with the slave's learned
+     * timeout when config.timeouts is active (see mb_timeout_policy_t).
+     * Without it the transport keeps its own fixed timeout.
+     */
+    void (*set_timeout)(void *ctx, uint32_t timeout_ms);
+
+    /**
+     * @brief Send several frames in one call (optional, TCP pipelining)
+     * @param ctx User context pointer
+     * @param frames Frames in wire order
+     * @param count Number of frames
+     * @return 0 once every frame has been sent, negative error code otherwise
+     *
+     * With max_in_flight > 1 the master stages every request that fits the
+     * window and hands them over together, so a transport can send them
+     * with one writev() or one io_uring submission instead of one send()
+     * per frame. The frames stay valid only for the duration of the call.
+     */
+    int (*send_frames)(void *ctx, const mb_frame_vec_t *frames, size_t count);
 } mb_transport_t;
 
 #ifdef __cplusplus
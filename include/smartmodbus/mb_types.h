@@ -22,9 +22,60 @@ extern "C" {
 typedef enum {
     MB_MODE_RTU,   /**< Modbus RTU (binary) */
     MB_MODE_ASCII, /**< Modbus ASCII (hex encoded) */
-    MB_MODE_TCP    /**< Modbus TCP/IP */
+    MB_MODE_TCP,   /**< Modbus TCP/IP */
+    MB_MODE_RTU_OVER_TCP /**< RTU framing and CRC on a stream socket (terminal servers) */
 } mb_mode_t;
 
+/**
+ * @brief Frame format of a mode
+ *
+ * RTU-over-TCP frames exactly like RTU; it differs only in having no
+ * inter-frame gap on the socket (see mb_config_default()).
+ */
+#define MB_MODE_FRAMING(mode) ((mode) == MB_MODE_RTU_OVER_TCP ? MB_MODE_RTU : (mode))
+
+/**
+ * @brief Serial broadcast address
+ *
+ * On RTU, ASCII and RTU-over-TCP, writes to this slave ID reach every
+ * slave on the line and are never answered. On Modbus TCP it is an
+ * ordinary unit ID.
+ */
+#define MB_BROADCAST_ID 0
+
+/**
+ * @brief Single-mode builds (CMake MB_FIXED_MODE)
+ *
+ * MB_FIXED_MODE_RTU, _ASCII or _TCP compiles in one protocol only. Masters
+ * must then be configured for that mode, and MB_ACTIVE_MODE() turns the
+ * configured mode into a constant so mode dispatch folds at compile time.
+ * Functions taking a mode argument check MB_MODE_SUPPORTED() before folding
+ * and return MB_ERROR_NOT_SUPPORTED for any other mode.
+ */
+#if defined(MB_FIXED_MODE_RTU)
+#define MB_FIXED_MODE MB_MODE_RTU
+#elif defined(MB_FIXED_MODE_ASCII)
+#define MB_FIXED_MODE MB_MODE_ASCII
+#elif defined(MB_FIXED_MODE_TCP)
+#define MB_FIXED_MODE MB_MODE_TCP
+#endif
+
+#ifdef MB_FIXED_MODE
+#define MB_ACTIVE_MODE(mode)    ((void)(mode), MB_FIXED_MODE)
+#define MB_MODE_SUPPORTED(mode) ((mode) == MB_FIXED_MODE)
+#else
+#define MB_ACTIVE_MODE(mode)    (mode)
+#define MB_MODE_SUPPORTED(mode) true
+#endif
+
+/**
+ * @brief Merge planner selection
+ */
+typedef enum {
+    MB_PLANNER_GREEDY = 0, /**< Greedy gap merge followed by FFD packing */
+    MB_PLANNER_OPTIMAL     /**< Minimum total characters under PDU/quantity limits (DP) */
+} mb_planner_t;
+
 /**
  * @brief Modbus function codes
  */
@@ -99,6 +150,59 @@ typedef struct {
     uint16_t address_count;   /**< Number of addresses */
 } mb_read_request_t;
 
+/**
+ * @brief Single tag of a heterogeneous batch read
+ *
+ * A batch is an array of tags that may span several slaves and function
+ * codes; see mb_master_read_batch().
+ */
+typedef struct {
+    uint8_t slave_id;      /**< Slave device ID */
+    uint8_t function_code; /**< Modbus function code (01-04) */
+    uint16_t address;      /**< Coil/register address */
+} mb_tag_t;
+
+/**
+ * @brief Type of a value held in one or more registers
+ */
+typedef enum {
+    MB_VALUE_UINT16  = 0, /**< One register */
+    MB_VALUE_INT16   = 1, /**< One register, two's complement */
+    MB_VALUE_UINT32  = 2, /**< Two registers */
+    MB_VALUE_INT32   = 3, /**< Two registers, two's complement */
+    MB_VALUE_FLOAT32 = 4, /**< Two registers, IEEE 754 single */
+    MB_VALUE_UINT64  = 5, /**< Four registers */
+    MB_VALUE_INT64   = 6, /**< Four registers, two's complement */
+    MB_VALUE_FLOAT64 = 7  /**< Four registers, IEEE 754 double */
+} mb_value_type_t;
+
+/**
+ * @brief Order of a multi-register value on the wire
+ *
+ * Named after a 32-bit value with bytes A (most significant) to D; wider
+ * values follow the same word and byte rules.
+ */
+typedef enum {
+    MB_ORDER_ABCD = 0, /**< Big-endian: high word first (Modbus convention) */
+    MB_ORDER_CDAB = 1, /**< Low word first, bytes big-endian in each word */
+    MB_ORDER_BADC = 2, /**< High word first, bytes swapped in each word */
+    MB_ORDER_DCBA = 3  /**< Little-endian: low word first, bytes swapped */
+} mb_word_order_t;
+
+/**
+ * @brief Typed tag: a value in consecutive registers of one slave
+ *
+ * value points into the application's own tag table and receives the
+ * decoded host value (uint16_t, int16_t, uint32_t, int32_t, float,
+ * uint64_t, int64_t or double, as given by type).
+ */
+typedef struct {
+    uint16_t address; /**< First register of the value */
+    uint8_t type;     /**< mb_value_type_t */
+    uint8_t order;    /**< mb_word_order_t */
+    void *value;      /**< Destination of the decoded value */
+} mb_typed_tag_t;
+
 /**
  * @brief Optimized request plan (output)
  *
@@ -113,8 +217,135 @@ typedef struct {
     uint8_t *frame_data;               /**< Pre-built frame (optional) */
     uint16_t frame_length;             /**< Frame length in bytes */
     uint16_t expected_response_length; /**< Expected response length */
+    uint16_t scatter_first;            /**< First scatter map entry for this plan */
+    uint16_t scatter_count;            /**< Number of scatter map entries */
 } mb_request_plan_t;
 
+/**
+ * @brief Scatter map entry
+ *
+ * Locates one requested address inside the optimized plans, so response
+ * values can be written straight to the caller's slot. Entries are grouped
+ * by plan; each plan references its range via scatter_first/scatter_count.
+ */
+typedef struct {
+    uint16_t plan_index; /**< Plan that reads this address */
+    uint16_t offset;     /**< Offset from the plan's start address (units) */
+    uint16_t dest_index; /**< Index of the address in the request (output slot) */
+} mb_scatter_entry_t;
+
+/**
+ * @brief Caller-supplied scratch arena
+ *
+ * Bump allocator over a user buffer. The optimizer draws its working arrays
+ * from it and rewinds it before returning, so a poll cycle performs no heap
+ * allocation. Size the buffer with mb_scratch_size().
+ */
+typedef struct {
+    uint8_t *base;     /**< Arena buffer (NULL = no arena) */
+    size_t size;       /**< Buffer size in bytes */
+    size_t used;       /**< Bytes currently allocated */
+    size_t high_water; /**< Peak usage since the buffer was attached */
+} mb_scratch_t;
+
+/**
+ * @brief Largest read request frame in characters
+ *
+ * ASCII: ':' + hex(SlaveID + FC + 4 PDU bytes + LRC) + CRLF = 17.
+ */
+#define MB_PLAN_FRAME_CHARS 17
+
+/**
+ * @brief Compiled poll plan
+ *
+ * Produced once from a read request by mb_poll_plan_compile() and executed
+ * repeatedly with mb_master_execute_poll(). Holds the optimized plans with
+ * prebuilt request frames, expected response lengths and the scatter map,
+ * so an execution only sends, receives and scatters.
+ *
+ * In static memory mode the storage is embedded and the structure must not
+ * be copied after compilation (plans point into it).
+ */
+typedef struct {
+    mb_mode_t mode;           /**< Protocol mode the frames were built for */
+    uint16_t address_count;   /**< Number of requested addresses (output slots) */
+    uint16_t plan_count;      /**< Number of compiled plans */
+    bool stale;               /**< A slave rejected a plan: re-plan before reuse */
+#ifdef MB_USE_STATIC_MEMORY
+    mb_request_plan_t plans[MB_MAX_PLANS];
+    mb_scatter_entry_t scatter[MB_MAX_SCATTER];
+    uint8_t frames[MB_MAX_PLANS][MB_PLAN_FRAME_CHARS];
+#else
+    mb_request_plan_t *plans;    /**< Compiled plans */
+    mb_scatter_entry_t *scatter; /**< Scatter map (address_count entries) */
+    uint8_t *frames;             /**< Frame storage (plan_count × MB_PLAN_FRAME_CHARS) */
+#endif
+} mb_poll_plan_t;
+
+/**
+ * @brief Arrival of one plan's response in a synchronized read
+ */
+typedef struct {
+    uint32_t stamp_us; /**< transport.clock_us() when the response was received */
+    int result;        /**< MB_SUCCESS or the plan's error */
+} mb_synced_stamp_t;
+
+/**
+ * @brief Timing of a synchronized read
+ */
+typedef struct {
+    uint32_t start_us; /**< transport.clock_us() before the first request */
+    uint32_t span_us;  /**< First request to last response */
+    uint32_t skew_us;  /**< Earliest to latest successful response (arrival, not request) */
+    uint16_t answered; /**< Plans read successfully */
+} mb_synced_timing_t;
+
+/**
+ * @brief Poll plan image identification ("MBPP")
+ */
+#define MB_POLL_IMAGE_MAGIC 0x5050424Du
+
+/**
+ * @brief Poll plan image layout version
+ */
+#define MB_POLL_IMAGE_VERSION 1
+
+/**
+ * @brief Header of a poll plan snapshot
+ *
+ * Followed by plan_count plan records (slave, FC, start, quantity, frame
+ * and response lengths, scatter range: 16 bytes each), address_count
+ * mb_scatter_entry_t and plan_count frames of MB_PLAN_FRAME_CHARS bytes,
+ * padded to a multiple of 4 bytes. Fields are in native byte order; the
+ * magic reads differently on a host of the other order.
+ */
+typedef struct {
+    uint32_t magic;         /**< MB_POLL_IMAGE_MAGIC */
+    uint16_t version;       /**< MB_POLL_IMAGE_VERSION */
+    uint8_t mode;           /**< Protocol mode of the frames (mb_mode_t) */
+    uint8_t stale;          /**< Plan was stale when saved */
+    uint16_t plan_count;    /**< Plan records */
+    uint16_t address_count; /**< Scatter entries (output slots) */
+    uint32_t key;           /**< Caller's revision of the tag list and settings */
+    uint32_t checksum;      /**< FNV-1a of the bytes after the header */
+} mb_poll_image_t;
+
+/**
+ * @brief Poll plan compiled ahead of time
+ *
+ * Read-only counterpart of mb_poll_plan_t for plans generated at build time,
+ * for example by mb_static_poll.hpp, so they can live in flash. Executed
+ * with mb_master_execute_static_poll() and never re-planned. TCP frames are
+ * the exception to read-only: the MBAP transaction ID is patched per send.
+ */
+typedef struct {
+    mb_mode_t mode;                    /**< Protocol mode the frames were built for */
+    uint16_t address_count;            /**< Number of requested addresses (output slots) */
+    uint16_t plan_count;               /**< Number of plans */
+    const mb_request_plan_t *plans;    /**< Plans with prebuilt frames */
+    const mb_scatter_entry_t *scatter; /**< Scatter map (address_count entries) */
+} mb_static_poll_t;
+
 /**
  * @brief Response structure
  *
@@ -130,17 +361,47 @@ typedef struct {
     uint8_t exception_code;  /**< Exception code (if is_exception) */
 } mb_response_t;
 
+/**
+ * @brief Serial parity
+ */
+typedef enum {
+    MB_PARITY_NONE, /**< No parity bit */
+    MB_PARITY_EVEN, /**< Even parity (Modbus default) */
+    MB_PARITY_ODD   /**< Odd parity */
+} mb_parity_t;
+
+/**
+ * @brief Physical link timing for the time cost model
+ *
+ * With bit_rate 0 (the default) plans are costed in characters. Otherwise
+ * every round-trip is costed in microseconds of line time: serial
+ * characters of start + data + parity + stop bits, ASCII's two characters
+ * per byte, the RTU silent intervals, and on sockets the MBAP header plus
+ * the TCP/IP and Ethernet framing of each segment.
+ */
+typedef struct {
+    uint32_t bit_rate;    /**< Baud rate, or socket link bit rate (0 = character model) */
+    uint8_t data_bits;    /**< Serial data bits (0 = 8 for RTU, 7 for ASCII) */
+    mb_parity_t parity;   /**< Serial parity */
+    uint8_t stop_bits;    /**< Serial stop bits (0 = 2 without parity, else 1) */
+    uint32_t latency_us;  /**< Slave turnaround or network round-trip (0 = latency_chars) */
+} mb_link_t;
+
 /**
  * @brief Cost calculation parameters
  *
  * Parameters used for calculating communication costs in the character-based
- * cost model.
+ * cost model. When byte_ns is set (see mb_init_link_cost_params()), costs
+ * are microseconds of line time instead of characters.
  */
 typedef struct {
     uint8_t req_fixed_chars;  /**< Request fixed overhead (chars) */
     uint8_t resp_fixed_chars; /**< Response fixed overhead (chars) */
     uint8_t gap_chars;        /**< Inter-frame gap (RTU/ASCII: 4, TCP: 0) */
     uint8_t latency_chars;    /**< Network/processing latency (chars) */
+    uint8_t link_chars;       /**< Round-trip line chars besides both frames, gap and latency */
+    uint32_t round_trip_ns;   /**< Time model: framing, gaps and latency of one round-trip */
+    uint32_t byte_ns;         /**< Time model: line time per response data byte (0 = off) */
 } mb_cost_params_t;
 
 /**
@@ -170,8 +431,25 @@ typedef struct {
     uint32_t blocks_merged;      /**< Number of blocks merged */
     uint32_t total_chars_sent;   /**< Total characters sent */
     uint32_t total_chars_recv;   /**< Total characters received */
+    uint32_t retries;            /**< Plans re-sent after a communication error */
+    uint32_t split_plans;        /**< Failed merged plans re-read block by block */
+    uint32_t offline_skipped;    /**< Requests not sent to an offline slave */
+    uint32_t broadcasts;         /**< Serial broadcast writes sent */
+    uint32_t preemptions;        /**< Urgent requests run between the plans of a read */
 } mb_stats_t;
 
+/**
+ * @brief Quality of one value of mb_master_read_optimized_quality()
+ */
+typedef enum {
+    MB_QUALITY_GOOD = 0,      /**< Value read */
+    MB_QUALITY_NOT_READ,      /**< Not attempted (the call stopped on a fatal error) */
+    MB_QUALITY_TIMEOUT,       /**< No response, also after the retries */
+    MB_QUALITY_COMM_ERROR,    /**< CRC/LRC, framing or transport error, also after the retries */
+    MB_QUALITY_EXCEPTION,     /**< The slave answered its block with an exception */
+    MB_QUALITY_OFFLINE        /**< Not sent: the slave is offline (see mb_timeout_policy_t) */
+} mb_quality_t;
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,136 @@
+/**
+ * @file mb_write.h
+ * @brief Coalescing write queue for FC15/FC16
+ *
+ * Collects individual register and coil writes during a cycle and sends
+ * them with as few frames as possible. Writes to the same address collapse
+ * to the last value queued; physically contiguous addresses of one slave
+ * are packed into FC16 (up to 123 registers) or FC15 (up to 1968 coils)
+ * frames. A write with no neighbour goes out as FC06 or FC05, the shorter
+ * frame. Gaps are never filled: a multiple write would overwrite registers
+ * nobody asked to change.
+ *
+ * mb_master_write_read() additionally fuses register writes with the
+ * cycle's reads of the same slave into FC23 (Read/Write Multiple
+ * Registers) transactions, saving a round-trip per fused pair.
+ */
+
+#ifndef SMARTMODBUS_MB_WRITE_H
+#define SMARTMODBUS_MB_WRITE_H
+
+#include "mb_config.h"
+#include "mb_types.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Largest register run an FC23 request can write
+ */
+#define MB_FC23_MAX_WRITE 121
+
+/**
+ * @brief One queued write
+ */
+typedef struct {
+    uint8_t slave_id;      /**< Slave device ID */
+    uint8_t function_code; /**< MB_FC_WRITE_MULTIPLE_REGISTERS or _COILS (address space) */
+    uint16_t address;      /**< Register/coil address */
+    uint16_t value;        /**< Register value, or 0/1 for a coil */
+    uint16_t order;        /**< Queue position (later wins) */
+} mb_write_entry_t;
+
+/**
+ * @brief Write queue over caller-owned storage
+ */
+typedef struct {
+    mb_write_entry_t *entries; /**< Caller-owned storage */
+    uint16_t capacity;         /**< Entries in storage */
+    uint16_t count;            /**< Writes queued */
+} mb_write_queue_t;
+
+/**
+ * @brief Initialize a write queue
+ * @param queue Write queue
+ * @param entries Entry array
+ * @param capacity Number of entries
+ * @return MB_SUCCESS on success, error code otherwise
+ */
+int mb_write_queue_init(mb_write_queue_t *queue, mb_write_entry_t *entries, uint16_t capacity);
+
+/**
+ * @brief Queue a register write
+ * @param queue Write queue
+ * @param slave_id Slave device ID
+ * @param address Register address
+ * @param value Register value
+ * @return MB_SUCCESS on success, MB_ERROR_TOO_MANY_BLOCKS if the queue is
+ *         full, error code otherwise
+ */
+int mb_write_queue_register(mb_write_queue_t *queue,
+                            uint8_t slave_id,
+                            uint16_t address,
+                            uint16_t value);
+
+/**
+ * @brief Queue a coil write
+ * @see mb_write_queue_register()
+ */
+int mb_write_queue_coil(mb_write_queue_t *queue, uint8_t slave_id, uint16_t address, bool value);
+
+/**
+ * @brief Drop every queued write
+ * @param queue Write queue
+ */
+void mb_write_queue_clear(mb_write_queue_t *queue);
+
+/**
+ * @brief Send every queued write with the fewest frames
+ * @param master Master context
+ * @param queue Write queue (emptied on success)
+ * @param frame_count Output: frames sent (may be NULL)
+ * @return MB_SUCCESS on success, error code of the first failed frame
+ *         otherwise
+ *
+ * Frames go out slave by slave in address order. On failure the queue
+ * keeps exactly the writes not yet acknowledged (the failed frame and
+ * everything after it), so flushing again resumes.
+ */
+int mb_master_flush_writes(mb_master_t *master, mb_write_queue_t *queue, uint16_t *frame_count);
+
+/**
+ * @brief Send the queued writes and perform an optimized read, fusing
+ *        where the slave allows
+ * @param master Master context
+ * @param queue Write queue (emptied on success)
+ * @param request Read request of the cycle
+ * @param data_buffer Output buffer (one slot per requested address)
+ * @param buffer_size Size of data buffer
+ * @return MB_SUCCESS on success, error code otherwise
+ *
+ * Writes are applied before the read, as if mb_master_flush_writes() were
+ * followed by mb_master_read_optimized(). For an FC03 request to a slave
+ * whose profile says MB_FC23_SUPPORTED (see mb_profile_set_fc23()), each
+ * register run of up to MB_FC23_MAX_WRITE registers to that slave is sent
+ * as one FC23 transaction together with the next read plan. A slave that
+ * answers ILLEGAL FUNCTION is marked MB_FC23_UNSUPPORTED; the rejected pair
+ * then goes out as separate write and read requests in the same call.
+ *
+ * If a write fails, the queue keeps the writes not yet acknowledged and
+ * nothing more is read.
+ */
+int mb_master_write_read(mb_master_t *master,
+                         mb_write_queue_t *queue,
+                         const mb_read_request_t *request,
+                         uint16_t *data_buffer,
+                         uint16_t buffer_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_MB_WRITE_H
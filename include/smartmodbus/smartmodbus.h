@@ -35,10 +35,25 @@
 #ifndef SMARTMODBUS_H
 #define SMARTMODBUS_H
 
+#include "smartmodbus/mb_adaptive.h"
+#include "smartmodbus/mb_async.h"
+#include "smartmodbus/mb_bus.h"
+#include "smartmodbus/mb_cache.h"
+#include "smartmodbus/mb_change.h"
 #include "smartmodbus/mb_config.h"
 #include "smartmodbus/mb_error.h"
+#include "smartmodbus/mb_gateway.h"
+#include "smartmodbus/mb_metrics.h"
+#include "smartmodbus/mb_ports.h"
+#include "smartmodbus/mb_profile.h"
+#include "smartmodbus/mb_ring.h"
+#include "smartmodbus/mb_scheduler.h"
+#include "smartmodbus/mb_slave.h"
+#include "smartmodbus/mb_tcp_client.h"
+#include "smartmodbus/mb_trace.h"
 #include "smartmodbus/mb_transport.h"
 #include "smartmodbus/mb_types.h"
+#include "smartmodbus/mb_write.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -56,7 +71,8 @@ int mb_master_init(mb_master_t *master, const mb_config_t *config);
  * @brief Read data with automatic optimization
  * @param master Master context
  * @param request Read request with potentially non-contiguous addresses
- * @param data_buffer Buffer to store read data
+ * @param data_buffer Buffer to store read data; data_buffer[i] receives the value
+ *                    of request->addresses[i] (coils/inputs as 0 or 1)
  * @param buffer_size Size of data buffer in words (registers or coils)
  * @return MB_SUCCESS on success, error code otherwise
  *
@@ -65,13 +81,327 @@ int mb_master_init(mb_master_t *master, const mb_config_t *config);
  * - Merges non-contiguous blocks based on gap cost analysis
  * - Packs blocks into optimal PDU frames using FFD
  * - Executes minimal round-trips
- * - Extracts only requested data from responses
+ * - Scatters only requested data from responses via a precomputed map
+ *
+ * There is no limit on the number of PDUs: the request is planned and
+ * executed in address-ordered windows of MB_WINDOW_PLANS plans (and, in the
+ * static memory build, MB_MAX_SCATTER addresses), so a full-device snapshot
+ * of thousands of registers is one call with fixed plan storage.
  */
 int mb_master_read_optimized(mb_master_t *master,
                               const mb_read_request_t *request,
                               uint16_t *d_buffer,
                               uint16_t buffer_size);
 
+/**
+ * @brief Optimized read that returns what it could, with a quality per value
+ * @param master Master context
+ * @param request Read request with potentially non-contiguous addresses
+ * @param data_buffer As for mb_master_read_optimized()
+ * @param buffer_size Size of data buffer in words
+ * @param quality Output: quality[i] (an mb_quality_t) of data_buffer[i]
+ * @return MB_SUCCESS if every value was read, MB_ERROR_PARTIAL_RESULT if some
+ *         were, the plan error if none were, or another error code
+ *
+ * A failed plan does not end the call: the other plans are still executed
+ * and the failed one is recovered under config.retry (see
+ * mb_retry_policy_t). Values that could not be read keep their previous
+ * content and carry the reason in quality.
+ */
+int mb_master_read_optimized_quality(mb_master_t *master,
+                                     const mb_read_request_t *request,
+                                     uint16_t *data_buffer,
+                                     uint16_t buffer_size,
+                                     uint8_t *quality);
+
+/**
+ * @brief Read coils or discrete inputs with optimization into a packed bitset
+ * @param master Master context
+ * @param request Read request (FC01 or FC02)
+ * @param bits Output bitset: bit i, (bits[i / 32] >> (i % 32)) & 1, receives
+ *             the value of request->addresses[i]
+ * @param bit_capacity Size of bits in bits (>= request->address_count)
+ * @return MB_SUCCESS on success, error code otherwise
+ *
+ * Planned and executed like mb_master_read_optimized(), without a 16-bit
+ * slot per coil. Requested bits are gathered from merged responses a word
+ * at a time (BMI2 PEXT where available for sparse bits). Bits beyond
+ * address_count are left unchanged.
+ */
+int mb_master_read_optimized_bits(mb_master_t *master,
+                                  const mb_read_request_t *request,
+                                  uint32_t *bits,
+                                  uint32_t bit_capacity);
+
+/**
+ * @brief Optimized read of typed multi-register values
+ * @param master Master context
+ * @param slave_id Slave device ID
+ * @param fc Function code (FC03/04)
+ * @param tags Typed tags; each value pointer receives the decoded value
+ * @param tag_count Number of tags
+ * @return MB_SUCCESS on success, error code otherwise
+ *
+ * The registers of all tags are planned as one optimized read. Each
+ * register is converted from the response buffer straight into its tag's
+ * value in the tag's word order, without an intermediate register array.
+ * Tags may overlap. Static memory builds accept up to MB_MAX_SCATTER
+ * registers per call (MB_ERROR_TOO_MANY_BLOCKS beyond that).
+ */
+int mb_master_read_typed(mb_master_t *master,
+                         uint8_t slave_id,
+                         uint8_t fc,
+                         const mb_typed_tag_t *tags,
+                         uint16_t tag_count);
+
+/**
+ * @brief Scratch arena size for optimized reads
+ * @param address_count Largest address/tag count per read
+ * @return Bytes that cover mb_master_read_optimized() and mb_master_read_batch()
+ */
+size_t mb_scratch_size(uint16_t address_count);
+
+/**
+ * @brief Attach a caller-supplied scratch arena to a master
+ * @param master Master context
+ * @param buffer Arena buffer (NULL detaches and restores heap allocation)
+ * @param size Buffer size in bytes (see mb_scratch_size())
+ * @return MB_SUCCESS on success, error code otherwise
+ *
+ * With an arena attached, optimized and batch reads draw all working
+ * memory from it and perform no heap allocation. A read that needs more
+ * than the arena holds fails with MB_ERROR_NO_MEMORY. Static memory builds
+ * already plan from fixed pools and do not need an arena.
+ */
+int mb_master_set_scratch(mb_master_t *master, void *buffer, size_t size);
+
+/**
+ * @brief Read a heterogeneous tag list in one optimized pass
+ * @param master Master context
+ * @param tags Tags spanning any number of slaves and function codes
+ * @param tag_count Number of tags
+ * @param data_buffer Output buffer; data_buffer[i] receives the value of tags[i]
+ *                    (coils/inputs as 0 or 1)
+ * @param buffer_size Size of data buffer (must be >= tag_count)
+ * @return MB_SUCCESS on success, error code otherwise
+ *
+ * Tags are grouped by (slave, function code), each group is optimized like
+ * mb_master_read_optimized(), and all plans run as one globally ordered set
+ * interleaved across slaves. Groups are planned in parallel when
+ * config.planner_threads is above 1, with the same result.
+ */
+int mb_master_read_batch(mb_master_t *master,
+                         const mb_tag_t *tags,
+                         uint16_t tag_count,
+                         uint16_t *data_buffer,
+                         uint16_t buffer_size);
+
+/**
+ * @brief Compile a read request into a reusable poll plan
+ * @param master Master context (mode and optimizer settings are taken from it)
+ * @param request Read request
+ * @param poll Output poll plan (release with mb_poll_plan_free())
+ * @return MB_SUCCESS on success, error code otherwise
+ *
+ * Runs the optimizer once and prebuilds every request frame, so cyclic
+ * polls of the same tag list skip planning and frame construction.
+ */
+int mb_poll_plan_compile(const mb_master_t *master,
+                         const mb_read_request_t *request,
+                         mb_poll_plan_t *poll);
+
+/**
+ * @brief Compile a heterogeneous tag list into a reusable poll plan
+ * @param master Master context
+ * @param tags Tags spanning any number of slaves and function codes
+ * @param tag_count Number of tags
+ * @param poll Output poll plan (release with mb_poll_plan_free())
+ * @return MB_SUCCESS on success, error code otherwise
+ *
+ * Batch counterpart of mb_poll_plan_compile(); see mb_master_read_batch().
+ */
+int mb_poll_plan_compile_batch(const mb_master_t *master,
+                               const mb_tag_t *tags,
+                               uint16_t tag_count,
+                               mb_poll_plan_t *poll);
+
+/**
+ * @brief Execute a compiled poll plan
+ * @param master Master context (same mode as at compile time)
+ * @param poll Compiled poll plan
+ * @param data_buffer Output buffer; data_buffer[i] receives the value of the
+ *                    i-th compiled address
+ * @param buffer_size Size of data buffer (must be >= poll->address_count)
+ * @return MB_SUCCESS on success, error code otherwise
+ *
+ * Performs no optimization and no allocation while the slaves accept the
+ * plan. An exception response that teaches the master's device profiles
+ * something marks the plan stale; it is then refreshed and executed once
+ * more within the same call.
+ */
+int mb_master_execute_poll(mb_master_t *master,
+                           mb_poll_plan_t *poll,
+                           uint16_t *data_buffer,
+                           uint16_t buffer_size);
+
+/**
+ * @brief Execute a poll plan compiled ahead of time
+ * @param master Master context (same mode as the plan)
+ * @param poll Static poll plan
+ * @param data_buffer Output buffer; data_buffer[i] receives the value of the
+ *                    i-th compiled address
+ * @param buffer_size Size of data buffer (must be >= poll->address_count)
+ * @return MB_SUCCESS on success, error code otherwise
+ *
+ * Sends the prebuilt frames as they are. Exception responses still teach
+ * the master's device profiles, but the plan itself cannot be refreshed:
+ * the error is returned and the application decides whether to fall back
+ * to a runtime mb_poll_plan_compile().
+ */
+int mb_master_execute_static_poll(mb_master_t *master,
+                                  const mb_static_poll_t *poll,
+                                  uint16_t *data_buffer,
+                                  uint16_t buffer_size);
+
+/**
+ * @brief Order a poll plan to read its slaves as close together as possible
+ * @param master Master context the plan will execute on
+ * @param poll Compiled poll plan (its output layout is unchanged)
+ * @return MB_SUCCESS on success, error code otherwise
+ *
+ * Plans go in rounds, the r-th plan of every slave in round r, as
+ * mb_poll_plan_compile_batch() already does. Within a round, on a serial
+ * line or a TCP master without pipelining, the plans are ordered shortest
+ * first: the slaves sample when their request arrives, and the longest
+ * transaction then adds nothing to the spread of those instants. With
+ * config.max_in_flight above 1 they go longest first, so the slowest
+ * answers overlap the rest of the window. Costs are predicted in
+ * characters from the learned device profiles.
+ */
+int mb_poll_plan_order_synced(const mb_master_t *master, mb_poll_plan_t *poll);
+
+/**
+ * @brief Execute a poll plan as one time-synchronized read
+ * @param master Master context (transport.clock_us is required)
+ * @param poll Poll plan, ordered by mb_poll_plan_order_synced()
+ * @param data_buffer Output buffer, as for mb_master_execute_poll()
+ * @param buffer_size Size of data buffer (must be >= poll->address_count)
+ * @param stamps Output: stamps[i] times poll->plans[i]
+ * @param stamp_capacity Entries in stamps (must be >= poll->plan_count)
+ * @param timing Output: span and skew of the read (may be NULL)
+ * @return MB_SUCCESS if every plan was read, MB_ERROR_PARTIAL_RESULT if some
+ *         were, the first plan error if none were, or another error code
+ *
+ * The plans run back to back (pipelined on TCP when config.max_in_flight
+ * is above 1) and each response is stamped as it is received, so the skew
+ * between devices can be both kept small and measured. The skew is taken
+ * between response arrivals, not the request instants the ordering works
+ * on: it also holds the differences in response length and slave
+ * turnaround. A failed plan does not end the read; the plans not yet sent
+ * still run and the values of the failed one keep their previous content.
+ * Pipelined requests abandoned with it fail with the same error. Nothing is
+ * re-run or sent twice within the call, which would stretch the span: a
+ * plan a slave rejected is marked stale and is refreshed and re-ordered at
+ * the start of the next call.
+ */
+int mb_master_execute_synced(mb_master_t *master,
+                             mb_poll_plan_t *poll,
+                             uint16_t *data_buffer,
+                             uint16_t buffer_size,
+                             mb_synced_stamp_t *stamps,
+                             uint16_t stamp_capacity,
+                             mb_synced_timing_t *timing);
+
+/**
+ * @brief Re-plan a poll plan against the master's learned device profiles
+ * @param master Master context
+ * @param poll Compiled poll plan
+ * @return MB_SUCCESS on success, error code otherwise (poll is unchanged)
+ *
+ * The plan keeps its output layout: data_buffer[i] still receives the
+ * i-th compiled address. Called automatically for stale plans.
+ */
+int mb_poll_plan_refresh(const mb_master_t *master, mb_poll_plan_t *poll);
+
+/**
+ * @brief Add a tag to a compiled poll plan
+ * @param master Master context (same mode as at compile time)
+ * @param poll Compiled poll plan
+ * @param tag Tag to poll (FC01-FC04)
+ * @param slot Output: data_buffer index that receives the tag (optional)
+ * @return MB_SUCCESS on success, error code otherwise (poll is unchanged)
+ *
+ * Only the plans of the tag's slave and function code within one request's
+ * reach of its address are merged and packed again; every other plan keeps
+ * its prebuilt frame and its place in the execution order. The tag takes
+ * the next output slot, poll->address_count before the call.
+ */
+int mb_poll_plan_add(const mb_master_t *master,
+                     mb_poll_plan_t *poll,
+                     const mb_tag_t *tag,
+                     uint16_t *slot);
+
+/**
+ * @brief Remove an output slot from a compiled poll plan
+ * @param master Master context (same mode as at compile time)
+ * @param poll Compiled poll plan
+ * @param slot data_buffer index to stop polling
+ * @return MB_SUCCESS on success, error code otherwise (poll is unchanged)
+ *
+ * Re-plans the same neighbourhood as mb_poll_plan_add(). Later slots move
+ * down by one, as when erasing from an array. The last remaining slot
+ * cannot be removed; free the plan instead.
+ */
+int mb_poll_plan_remove(const mb_master_t *master, mb_poll_plan_t *poll, uint16_t slot);
+
+/**
+ * @brief Bytes of a poll plan snapshot
+ * @param poll Compiled poll plan
+ * @return Image size (a multiple of 4), or 0 if poll is NULL
+ */
+size_t mb_poll_plan_image_size(const mb_poll_plan_t *poll);
+
+/**
+ * @brief Serialize a compiled poll plan
+ * @param poll Compiled poll plan
+ * @param key Revision of the tag list and optimizer settings it was built from
+ * @param image Output buffer (4-byte aligned, e.g. a mapped file)
+ * @param size Buffer size (at least mb_poll_plan_image_size())
+ * @return MB_SUCCESS on success, error code otherwise
+ *
+ * Stores the plans with their prebuilt frames and expected response
+ * lengths and the scatter map, everything mb_master_execute_poll() needs.
+ * Images are padded to 4 bytes, so several can be written back to back.
+ */
+int mb_poll_plan_save(const mb_poll_plan_t *poll, uint32_t key, void *image, size_t size);
+
+/**
+ * @brief Load a poll plan snapshot without running the optimizer
+ * @param master Master context the plan will execute on
+ * @param poll Output poll plan (release with mb_poll_plan_free())
+ * @param image Image written by mb_poll_plan_save() (4-byte aligned)
+ * @param size Bytes available at image
+ * @param key Revision the image must have been saved with
+ * @return MB_SUCCESS on success, MB_ERROR_NOT_SUPPORTED for an image of
+ *         another version, protocol mode or key, MB_ERROR_INVALID_FRAME for
+ *         a damaged image, other error code otherwise
+ *
+ * The image is only read, so a read-only mapping works. Frames are copied
+ * as they were built; the image may be unmapped afterwards. The next image
+ * of a file holding several starts mb_poll_plan_image_size(poll) bytes on.
+ */
+int mb_poll_plan_load(const mb_master_t *master,
+                      mb_poll_plan_t *poll,
+                      const void *image,
+                      size_t size,
+                      uint32_t key);
+
+/**
+ * @brief Release a poll plan
+ * @param poll Poll plan
+ */
+void mb_poll_plan_free(mb_poll_plan_t *poll);
+
 /**
  * @brief Execute single read request (no optimization)
  * @param master Master context
@@ -127,6 +457,21 @@ int mb_master_write_multiple_registers(mb_master_t *master,
                                         uint16_t quantity,
                                         const uint16_t *values);
 
+/**
+ * @brief Write multiple coils (FC15)
+ * @param master Master context
+ * @param slave_id Slave device ID
+ * @param start_addr Starting address
+ * @param quantity Number of coils (1-1968)
+ * @param values Coil values (true = ON)
+ * @return MB_SUCCESS on success, error code otherwise
+ */
+int mb_master_write_multiple_coils(mb_master_t *master,
+                                   uint8_t slave_id,
+                                   uint16_t start_addr,
+                                   uint16_t quantity,
+                                   const bool *values);
+
 /**
  * @brief Get optimization statistics
  * @param master Master context
@@ -0,0 +1,467 @@
+/**
+ * @file smartmodbus.hpp
+ * @brief Header-only C++20 coroutine front-end over the async master API
+ *
+ * Reads and writes become awaitables built on mb_async_op_t, so a coroutine
+ * per slave suspends instead of blocking a thread for the round-trip:
+ *
+ * @code
+ * smartmodbus::Task<int> poll_meter(smartmodbus::AsyncMaster<Loop> &meter) {
+ *     uint16_t data[6];
+ *     int result = co_await meter.read_optimized(request, data, 6);
+ *     if (result == MB_SUCCESS) {
+ *         result = co_await meter.write_single_register(1, 300, data[0]);
+ *     }
+ *     co_return result;
+ * }
+ * @endcode
+ *
+ * The library does not own an event loop. A Driver connects operations to
+ * the application's executor:
+ * - watch(op): call mb_async_step(&op, now) whenever mb_async_interest(&op)
+ *   is satisfied or mb_async_next_deadline() passes, until op.state is no
+ *   longer MB_ASYNC_BUSY (then forget op)
+ * - unwatch(op): forget op early; called when an awaiting coroutine is
+ *   destroyed while suspended
+ * - post(handle): resume handle later on the executor, outside mb_async_step()
+ *
+ * With Asio, watch() maps to socket.async_wait() and post() to asio::post();
+ * with io_uring, to a poll SQE per socket and a ready queue. Loop below is a
+ * minimal single-threaded driver usable as-is or as a template.
+ */
+
+#ifndef SMARTMODBUS_HPP
+#define SMARTMODBUS_HPP
+
+#include "smartmodbus/smartmodbus.h"
+
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace smartmodbus {
+
+/**
+ * @brief Executor hook required by AsyncMaster
+ */
+template <class D>
+concept Driver = requires(D &driver, mb_async_op_t &op, std::coroutine_handle<> handle) {
+    driver.watch(op);
+    driver.unwatch(op);
+    driver.post(handle);
+};
+
+template <class T = void>
+class Task;
+
+namespace detail {
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+    bool started = false;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+
+        template <class P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> self) noexcept {
+            std::coroutine_handle<> next = self.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+};
+
+template <class T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object() noexcept;
+    void return_value(T v) { value.emplace(std::move(v)); }
+
+    T take() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return std::move(*value);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() noexcept {}
+
+    void take() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+}  // namespace detail
+
+/**
+ * @brief Lazily started coroutine returning T
+ *
+ * Awaiting a Task starts it (unless start() already did) and resumes the
+ * awaiter when it finishes. A top-level Task is started with start() and
+ * polled with done(); starting several before awaiting them runs them
+ * concurrently.
+ */
+template <class T>
+class Task {
+  public:
+    using promise_type = detail::Promise<T>;
+    using handle_type  = std::coroutine_handle<promise_type>;
+
+    explicit Task(handle_type handle) noexcept : handle_(handle) {}
+    Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task(const Task &)            = delete;
+    Task &operator=(const Task &) = delete;
+    Task &operator=(Task &&other) noexcept {
+        if (this != &other) {
+            destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    ~Task() { destroy(); }
+
+    /** @brief Run a top-level task up to its first suspension */
+    void start() {
+        if (handle_ && !handle_.promise().started) {
+            handle_.promise().started = true;
+            handle_.resume();
+        }
+    }
+
+    bool done() const noexcept { return !handle_ || handle_.done(); }
+
+    /** @brief Result of a finished top-level task (rethrows its exception) */
+    T result() { return handle_.promise().take(); }
+
+    bool await_ready() const noexcept { return done(); }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        handle_.promise().continuation = awaiter;
+
+        // Already started with start(): it resumes the awaiter when it finishes
+        if (handle_.promise().started) {
+            return std::noop_coroutine();
+        }
+        handle_.promise().started = true;
+        return handle_;
+    }
+
+    T await_resume() { return handle_.promise().take(); }
+
+  private:
+    void destroy() noexcept {
+        if (handle_) {
+            handle_.destroy();
+            handle_ = {};
+        }
+    }
+
+    handle_type handle_;
+};
+
+namespace detail {
+
+template <class T>
+Task<T> Promise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+}  // namespace detail
+
+/**
+ * @brief Owning wrapper around a compiled poll plan
+ *
+ * Not copyable or movable: in static memory mode the plans point into the
+ * embedded storage.
+ */
+class PollPlan {
+  public:
+    PollPlan() noexcept : plan_{} {}
+    PollPlan(const PollPlan &)            = delete;
+    PollPlan &operator=(const PollPlan &) = delete;
+    ~PollPlan() { mb_poll_plan_free(&plan_); }
+
+    int compile(const mb_master_t &master, const mb_read_request_t &request) noexcept {
+        mb_poll_plan_free(&plan_);
+        return mb_poll_plan_compile(&master, &request, &plan_);
+    }
+
+    int compile(const mb_master_t &master, const mb_tag_t *tags, uint16_t tag_count) noexcept {
+        mb_poll_plan_free(&plan_);
+        return mb_poll_plan_compile_batch(&master, tags, tag_count, &plan_);
+    }
+
+    mb_poll_plan_t *get() noexcept { return &plan_; }
+    uint16_t address_count() const noexcept { return plan_.address_count; }
+
+  private:
+    mb_poll_plan_t plan_;
+};
+
+/**
+ * @brief Awaitable async operation
+ * @tparam D Driver
+ * @tparam Submit Callable int(mb_async_op_t *, mb_async_done_fn, void *)
+ *
+ * Submission happens in await_ready(), once the awaitable has its final
+ * address; a submission error completes immediately without suspending.
+ * co_await yields the MB_SUCCESS / error code of the operation.
+ */
+template <Driver D, class Submit>
+class Operation {
+  public:
+    Operation(D &driver, Submit submit) : driver_(driver), submit_(std::move(submit)) {}
+    Operation(const Operation &)            = delete;
+    Operation &operator=(const Operation &) = delete;
+
+    ~Operation() {
+        // Destroyed while pending (the awaiting coroutine was torn down)
+        if (op_.state == MB_ASYNC_BUSY) {
+            driver_.unwatch(op_);
+            mb_async_cancel(&op_);
+        }
+    }
+
+    bool await_ready() {
+        result_ = submit_(&op_, &Operation::on_done, this);
+        return result_ != MB_SUCCESS;
+    }
+
+    void await_suspend(std::coroutine_handle<> awaiter) {
+        awaiter_ = awaiter;
+        driver_.watch(op_);
+    }
+
+    int await_resume() const noexcept { return result_; }
+
+  private:
+    static void on_done(void *ctx, int result) {
+        auto *self    = static_cast<Operation *>(ctx);
+        self->result_ = result;
+
+        // Resuming here would run the coroutine inside mb_async_step()
+        self->driver_.post(self->awaiter_);
+    }
+
+    D &driver_;
+    Submit submit_;
+    mb_async_op_t op_{};
+    std::coroutine_handle<> awaiter_;
+    int result_ = MB_SUCCESS;
+};
+
+/**
+ * @brief Awaitable optimized read that compiles its own poll plan
+ */
+template <Driver D>
+class ReadOptimized {
+  public:
+    ReadOptimized(D &driver,
+                  mb_master_t &master,
+                  const mb_read_request_t &request,
+                  uint16_t *data,
+                  uint16_t size)
+        : driver_(driver), master_(master), request_(request), data_(data), size_(size) {}
+    ReadOptimized(const ReadOptimized &)            = delete;
+    ReadOptimized &operator=(const ReadOptimized &) = delete;
+
+    ~ReadOptimized() {
+        if (op_.state == MB_ASYNC_BUSY) {
+            driver_.unwatch(op_);
+            mb_async_cancel(&op_);
+        }
+    }
+
+    bool await_ready() {
+        result_ = plan_.compile(master_, request_);
+        if (result_ == MB_SUCCESS) {
+            result_ = mb_master_submit_poll(&master_, &op_, plan_.get(), data_, size_,
+                                            &ReadOptimized::on_done, this);
+        }
+        return result_ != MB_SUCCESS;
+    }
+
+    void await_suspend(std::coroutine_handle<> awaiter) {
+        awaiter_ = awaiter;
+        driver_.watch(op_);
+    }
+
+    int await_resume() const noexcept { return result_; }
+
+  private:
+    static void on_done(void *ctx, int result) {
+        auto *self    = static_cast<ReadOptimized *>(ctx);
+        self->result_ = result;
+        self->driver_.post(self->awaiter_);
+    }
+
+    D &driver_;
+    mb_master_t &master_;
+    const mb_read_request_t &request_;
+    uint16_t *data_;
+    uint16_t size_;
+    PollPlan plan_;
+    mb_async_op_t op_{};
+    std::coroutine_handle<> awaiter_;
+    int result_ = MB_SUCCESS;
+};
+
+/**
+ * @brief Coroutine-facing view of one master (one connection or port)
+ *
+ * Like the C API, a master runs one operation at a time; run concurrent
+ * polls on separate masters. Referenced objects must outlive the awaits.
+ */
+template <Driver D>
+class AsyncMaster {
+  public:
+    AsyncMaster(mb_master_t &master, D &driver) noexcept : master_(master), driver_(driver) {}
+
+    mb_master_t &master() noexcept { return master_; }
+
+    /** @brief Execute a compiled poll plan (no planning, no allocation) */
+    auto execute(PollPlan &plan, uint16_t *data, uint16_t size) {
+        mb_master_t *master = &master_;
+        mb_poll_plan_t *poll = plan.get();
+        return make([=](mb_async_op_t *op, mb_async_done_fn done, void *ctx) {
+            return mb_master_submit_poll(master, op, poll, data, size, done, ctx);
+        });
+    }
+
+    /** @brief Plan and execute a read; prefer execute() for cyclic polls */
+    ReadOptimized<D> read_optimized(const mb_read_request_t &request,
+                                    uint16_t *data,
+                                    uint16_t size) {
+        return ReadOptimized<D>(driver_, master_, request, data, size);
+    }
+
+    auto write_single_coil(uint8_t slave_id, uint16_t addr, bool value) {
+        mb_master_t *master = &master_;
+        return make([=](mb_async_op_t *op, mb_async_done_fn done, void *ctx) {
+            return mb_master_submit_write_single_coil(master, op, slave_id, addr, value, done, ctx);
+        });
+    }
+
+    auto write_single_register(uint8_t slave_id, uint16_t addr, uint16_t value) {
+        mb_master_t *master = &master_;
+        return make([=](mb_async_op_t *op, mb_async_done_fn done, void *ctx) {
+            return mb_master_submit_write_single_register(master, op, slave_id, addr, value, done,
+                                                          ctx);
+        });
+    }
+
+    auto write_multiple_registers(uint8_t slave_id,
+                                  uint16_t start_addr,
+                                  uint16_t quantity,
+                                  const uint16_t *values) {
+        mb_master_t *master = &master_;
+        return make([=](mb_async_op_t *op, mb_async_done_fn done, void *ctx) {
+            return mb_master_submit_write_multiple_registers(master, op, slave_id, start_addr,
+                                                             quantity, values, done, ctx);
+        });
+    }
+
+  private:
+    template <class Submit>
+    Operation<D, Submit> make(Submit submit) {
+        return Operation<D, Submit>(driver_, std::move(submit));
+    }
+
+    mb_master_t &master_;
+    D &driver_;
+};
+
+/**
+ * @brief Minimal single-threaded driver
+ *
+ * Steps every watched operation on run_once() and resumes completed
+ * coroutines afterwards. Suited to MCU main loops and tests; on a server,
+ * call run_once() after epoll_wait()/io_uring_wait_cqe() with a timeout
+ * from next_deadline(), or write a driver that steps only ready ops.
+ */
+class Loop {
+  public:
+    void watch(mb_async_op_t &op) { watched_.push_back(&op); }
+
+    void unwatch(mb_async_op_t &op) {
+        for (size_t i = 0; i < watched_.size(); i++) {
+            if (watched_[i] == &op) {
+                watched_[i] = watched_.back();
+                watched_.pop_back();
+                return;
+            }
+        }
+    }
+
+    void post(std::coroutine_handle<> handle) { ready_.push_back(handle); }
+
+    /**
+     * @brief Step all watched operations, then resume finished coroutines
+     * @param now_ms Clock passed to mb_async_step()
+     */
+    void run_once(uint32_t now_ms) {
+        for (size_t i = 0; i < watched_.size();) {
+            mb_async_op_t *op = watched_[i];
+            mb_async_step(op, now_ms);
+            if (op->state == MB_ASYNC_BUSY) {
+                i++;
+            } else {
+                watched_[i] = watched_.back();
+                watched_.pop_back();
+            }
+        }
+
+        // Resumed coroutines may watch() or post() again
+        std::vector<std::coroutine_handle<>> ready;
+        ready.swap(ready_);
+        for (std::coroutine_handle<> handle : ready) {
+            handle.resume();
+        }
+    }
+
+    /** @brief Earliest response deadline among watched operations */
+    bool next_deadline(uint32_t &deadline_ms) const noexcept {
+        bool found = false;
+        for (const mb_async_op_t *op : watched_) {
+            uint32_t deadline = 0;
+            if (mb_async_next_deadline(op, &deadline) &&
+                (!found || static_cast<int32_t>(deadline - deadline_ms) < 0)) {
+                deadline_ms = deadline;
+                found       = true;
+            }
+        }
+        return found;
+    }
+
+    bool idle() const noexcept { return watched_.empty() && ready_.empty(); }
+
+  private:
+    std::vector<mb_async_op_t *> watched_;
+    std::vector<std::coroutine_handle<>> ready_;
+};
+
+}  // namespace smartmodbus
+
+#endif  // SMARTMODBUS_HPP
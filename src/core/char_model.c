@@ -4,13 +4,61 @@
  *
  * Implements the core cost calculation logic for the Smart Modbus optimization.
  * The cost model uses characters as the universal unit of cost, making it
- * protocol-agnostic and independent of baudrate or timing.
+ * protocol-agnostic and independent of baudrate or timing. Given the link
+ * timing, the same decisions are taken in microseconds of line time
+ * instead (see mb_init_link_cost_params()).
  */
 
 #include "char_model.h"
+#include "smartmodbus/mb_error.h"
 
 #include "fc_policy.h"
 
+/**
+ * @brief Bytes each segment carries besides its payload on a socket
+ *
+ * IPv4 (20) and TCP (20) headers plus Ethernet header, FCS, preamble and
+ * inter-frame gap (38).
+ */
+#define LINK_SEGMENT_CHARS 78
+
+/**
+ * @brief RTU silent interval above 19200 baud, in ns
+ */
+#define LINK_FIXED_T35_NS 1750000u
+
+/**
+ * @brief Line characters of a frame whose PDU has pdu_data bytes after the FC
+ */
+static uint32_t link_frame_chars(mb_mode_t mode, uint32_t pdu_data) {
+    switch (mode) {
+    case MB_MODE_ASCII:
+        return 1 + 2 * (pdu_data + 3) + 2; // ':' + hex(address, FC, data, LRC) + CRLF
+    case MB_MODE_TCP:
+        return pdu_data + 8 + LINK_SEGMENT_CHARS; // MBAP(7) + FC
+    case MB_MODE_RTU_OVER_TCP:
+        return pdu_data + 4 + LINK_SEGMENT_CHARS;
+    default:
+        return pdu_data + 4; // Address + FC + CRC(2)
+    }
+}
+
+/**
+ * @brief Bits on the line per character
+ */
+static uint32_t link_char_bits(mb_mode_t mode, const mb_link_t *link) {
+    if (mode == MB_MODE_TCP || mode == MB_MODE_RTU_OVER_TCP) {
+        return 8;
+    }
+
+    uint32_t default_data = mode == MB_MODE_ASCII ? 7u : 8u;
+    uint32_t data_bits    = link->data_bits != 0 ? link->data_bits : default_data;
+    uint32_t parity_bits  = link->parity != MB_PARITY_NONE ? 1u : 0u;
+    // Without parity the spec asks for two stop bits, keeping 11-bit RTU characters
+    uint32_t stop_bits = link->stop_bits != 0 ? link->stop_bits : (parity_bits != 0 ? 1u : 2u);
+    return 1 + data_bits + parity_bits + stop_bits;
+}
+
 uint16_t mb_calc_overhead_chars(mb_mode_t mode, uint8_t fc, uint8_t gap_chars, uint8_t latency_chars) {
     const mb_fc_policy_t *policy = mb_fc_get_policy(fc);
     if (policy == NULL) {
@@ -92,17 +140,25 @@ uint16_t mb_calc_request_cost(const mb_block_t *block,
     return overhead + data_cost;
 }
 
-void mb_init_cost_params(mb_mode_t mode,
-                         uint8_t fc,
-                         uint8_t latency_chars,
-                         mb_cost_params_t *params) {
+int mb_init_cost_params(mb_mode_t mode,
+                        uint8_t fc,
+                        uint8_t latency_chars,
+                        mb_cost_params_t *params) {
     if (params == NULL) {
-        return;
+        return MB_ERROR_INVALID_PARAM;
     }
+    // Folding another mode would quietly cost the compiled-in one
+    if (!MB_MODE_SUPPORTED(mode)) {
+        return MB_ERROR_NOT_SUPPORTED;
+    }
+
+    // Character model unless mb_init_link_cost_params() says otherwise
+    params->round_trip_ns = 0;
+    params->byte_ns       = 0;
 
     const mb_fc_policy_t *policy = mb_fc_get_policy(fc);
     if (policy == NULL) {
-        return;
+        return MB_ERROR_INVALID_FC;
     }
 
     params->req_fixed_chars  = policy->req_fixed_chars;
@@ -110,27 +166,130 @@ void mb_init_cost_params(mb_mode_t mode,
     params->latency_chars    = latency_chars;
 
     // Set gap based on mode
+    mode = MB_ACTIVE_MODE(mode);
     if (mode == MB_MODE_RTU || mode == MB_MODE_ASCII) {
-        params->gap_chars = 4; // 3.5 chars rounded up
+        params->gap_chars  = 4; // 3.5 chars rounded up
+        params->link_chars = 4; // The response ends with a silent interval as well
     } else {
-        params->gap_chars = 0; // TCP has no inter-frame gap
+        params->gap_chars  = 0; // No inter-frame gap on a socket
+        params->link_chars = 2 * LINK_SEGMENT_CHARS;
     }
+    return MB_SUCCESS;
 }
 
-int16_t mb_calc_merge_savings(uint16_t gap_units, uint8_t fc, const mb_cost_params_t *cost_params) {
+int mb_init_link_cost_params(mb_mode_t mode,
+                             uint8_t fc,
+                             uint8_t latency_chars,
+                             const mb_link_t *link,
+                             mb_cost_params_t *params) {
+    int result = mb_init_cost_params(mode, fc, latency_chars, params);
+    if (result != MB_SUCCESS || link == NULL || link->bit_rate == 0) {
+        return result;
+    }
+
+    mode             = MB_ACTIVE_MODE(mode);
+    uint64_t char_ns = (uint64_t)link_char_bits(mode, link) * 1000000000u / link->bit_rate;
+
+    // A read request carries address + quantity, its response the byte count
+    uint64_t frame_chars = (uint64_t)link_frame_chars(mode, 4) + link_frame_chars(mode, 1);
+    uint64_t round_trip  = frame_chars * char_ns;
+
+    // RTU frames end with a silent interval, requests and responses alike
+    if (mode == MB_MODE_RTU) {
+        uint64_t t35 = link->bit_rate > 19200 ? LINK_FIXED_T35_NS : char_ns * 7 / 2;
+        round_trip += 2 * t35;
+    }
+
+    round_trip += link->latency_us != 0 ? (uint64_t)link->latency_us * 1000u
+                                        : (uint64_t)latency_chars * char_ns;
+
+    uint64_t byte_ns = mode == MB_MODE_ASCII ? 2 * char_ns : char_ns;
+
+    params->round_trip_ns = round_trip < UINT32_MAX ? (uint32_t)round_trip : UINT32_MAX;
+    params->byte_ns       = byte_ns > 0 ? (uint32_t)byte_ns : 1; // Never fall back to characters
+    return MB_SUCCESS;
+}
+
+uint32_t mb_calc_round_trip_cost(const mb_cost_params_t *cost_params, uint32_t data_bytes) {
     if (cost_params == NULL) {
         return 0;
     }
 
-    // Calculate overhead cost (cost of additional round-trip)
-    uint16_t overhead_cost = cost_params->req_fixed_chars + cost_params->resp_fixed_chars +
-                             cost_params->gap_chars + cost_params->latency_chars;
+    if (cost_params->byte_ns != 0) {
+        uint64_t ns = cost_params->round_trip_ns + (uint64_t)data_bytes * cost_params->byte_ns;
+        uint64_t us = (ns + 500) / 1000;
+        return us < UINT32_MAX ? (uint32_t)us : UINT32_MAX;
+    }
+
+    return (uint32_t)cost_params->req_fixed_chars + cost_params->resp_fixed_chars +
+           cost_params->gap_chars + cost_params->latency_chars + data_bytes;
+}
+
+uint32_t mb_calc_full_round_trip_cost(const mb_cost_params_t *cost_params, uint32_t data_bytes) {
+    uint32_t cost = mb_calc_round_trip_cost(cost_params, data_bytes);
+    if (cost_params == NULL || cost_params->byte_ns != 0) {
+        return cost;
+    }
+    return cost + cost_params->link_chars;
+}
+
+int32_t mb_calc_merge_savings(uint16_t gap_units, uint8_t fc, const mb_cost_params_t *cost_params) {
+    if (cost_params == NULL) {
+        return 0;
+    }
 
     // Calculate gap cost (cost of reading extra data)
     uint16_t gap_cost = mb_calc_gap_cost(fc, gap_units);
 
+    // Time model: the round-trip saved against the line time of the gap bytes
+    if (cost_params->byte_ns != 0) {
+        int64_t saved_ns = (int64_t)cost_params->round_trip_ns -
+                           (int64_t)gap_cost * cost_params->byte_ns;
+        return (int32_t)(saved_ns / 1000);
+    }
+
+    // Calculate overhead cost (cost of additional round-trip)
+    int32_t overhead_cost = (int32_t)cost_params->req_fixed_chars + cost_params->resp_fixed_chars +
+                            cost_params->gap_chars + cost_params->latency_chars;
+
     // Savings = overhead - gap_cost
     // Positive = merging saves characters
     // Negative = merging wastes characters
-    return (int16_t)(overhead_cost - gap_cost);
+    return overhead_cost - gap_cost;
+}
+
+uint32_t mb_calc_plan_cost(const mb_pdu_t *pdus, uint16_t pdu_count, const mb_cost_params_t *cost_params) {
+    if (pdus == NULL || cost_params == NULL) {
+        return 0;
+    }
+
+    uint32_t total = 0;
+
+    for (uint16_t i = 0; i < pdu_count; i++) {
+        uint32_t data_cost = (mb_fc_get_unit_size(pdus[i].function_code) == 1)
+                                 ? ((uint32_t)pdus[i].quantity + 7) / 8
+                                 : (uint32_t)pdus[i].quantity * 2;
+        total += mb_calc_round_trip_cost(cost_params, data_cost);
+    }
+
+    return total;
+}
+
+uint32_t mb_calc_full_plan_cost(const mb_pdu_t *pdus,
+                                uint16_t pdu_count,
+                                const mb_cost_params_t *cost_params) {
+    if (pdus == NULL || cost_params == NULL) {
+        return 0;
+    }
+
+    uint32_t total = 0;
+
+    for (uint16_t i = 0; i < pdu_count; i++) {
+        uint32_t data_cost = (mb_fc_get_unit_size(pdus[i].function_code) == 1)
+                                 ? ((uint32_t)pdus[i].quantity + 7) / 8
+                                 : (uint32_t)pdus[i].quantity * 2;
+        total += mb_calc_full_round_trip_cost(cost_params, data_cost);
+    }
+
+    return total;
 }
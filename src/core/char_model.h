@@ -67,23 +67,88 @@ uint16_t mb_calc_request_cost(const mb_block_t *block,
  * @param fc Function code
  * @param latency_chars User-configured latency
  * @param params Output cost parameters
+ * @return MB_SUCCESS, MB_ERROR_NOT_SUPPORTED for a mode a single-mode build
+ *         does not have, MB_ERROR_INVALID_PARAM if params is NULL
  */
-void mb_init_cost_params(mb_mode_t mode,
-                         uint8_t fc,
-                         uint8_t latency_chars,
-                         mb_cost_params_t *params);
+int mb_init_cost_params(mb_mode_t mode,
+                        uint8_t fc,
+                        uint8_t latency_chars,
+                        mb_cost_params_t *params);
+
+/**
+ * @brief Initialize cost parameters from the physical link
+ * @param mode Protocol mode
+ * @param fc Function code
+ * @param latency_chars Latency used when link->latency_us is 0
+ * @param link Link timing (NULL or bit_rate 0 selects the character model)
+ * @param params Output cost parameters
+ * @return As for mb_init_cost_params()
+ *
+ * Fills the character parameters like mb_init_cost_params() and, for a
+ * link with a bit rate, the time model: one read round-trip costs both
+ * frames at the link's character time (11-bit RTU characters, ASCII hex,
+ * MBAP + TCP/IP + Ethernet per segment), two RTU silent intervals and the
+ * latency; every response data byte adds its line time.
+ */
+int mb_init_link_cost_params(mb_mode_t mode,
+                             uint8_t fc,
+                             uint8_t latency_chars,
+                             const mb_link_t *link,
+                             mb_cost_params_t *params);
+
+/**
+ * @brief Cost of one round-trip
+ * @param cost_params Cost parameters
+ * @param data_bytes Response data bytes carried
+ * @return Characters, or microseconds under the time model
+ */
+uint32_t mb_calc_round_trip_cost(const mb_cost_params_t *cost_params, uint32_t data_bytes);
+
+/**
+ * @brief Full line cost of one round-trip, as the optimal planner weighs it
+ * @param cost_params Cost parameters
+ * @param data_bytes Response data bytes carried
+ * @return Characters, or microseconds under the time model
+ *
+ * Adds link_chars to mb_calc_round_trip_cost() in the character model: the
+ * silent interval after the response on a serial line, the TCP/IP headers
+ * of both segments on a socket. The time model already includes them.
+ */
+uint32_t mb_calc_full_round_trip_cost(const mb_cost_params_t *cost_params, uint32_t data_bytes);
 
 /**
  * @brief Calculate savings from merging two blocks
  * @param gap_units Gap between blocks in units
  * @param fc Function code
  * @param cost_params Cost parameters
- * @return Savings in characters (positive = beneficial, negative = wasteful)
+ * @return Savings in characters, or microseconds under the time model
+ *         (positive = beneficial, negative = wasteful)
  *
  * Savings = OVERHEAD_CHAR - gap_cost
  * If positive, merging saves characters
  */
-int16_t mb_calc_merge_savings(uint16_t gap_units, uint8_t fc, const mb_cost_params_t *cost_params);
+int32_t mb_calc_merge_savings(uint16_t gap_units, uint8_t fc, const mb_cost_params_t *cost_params);
+
+/**
+ * @brief Calculate total round-trip cost of a set of PDUs
+ * @param pdus Array of PDUs
+ * @param pdu_count Number of PDUs
+ * @param cost_params Cost parameters
+ * @return Total cost in characters (overhead per PDU + data bytes), or
+ *         microseconds under the time model
+ */
+uint32_t mb_calc_plan_cost(const mb_pdu_t *pdus, uint16_t pdu_count, const mb_cost_params_t *cost_params);
+
+/**
+ * @brief Total mb_calc_full_round_trip_cost() of a set of PDUs
+ * @param pdus Array of PDUs
+ * @param pdu_count Number of PDUs
+ * @param cost_params Cost parameters
+ * @return Characters, or microseconds under the time model
+ */
+uint32_t mb_calc_full_plan_cost(const mb_pdu_t *pdus,
+                                uint16_t pdu_count,
+                                const mb_cost_params_t *cost_params);
 
 #ifdef __cplusplus
 }
@@ -3,18 +3,77 @@
  * @brief First-Fit Decreasing packing algorithm implementation
  *
  * Implements FFD bin packing to maximize PDU utilization while respecting
- * protocol constraints.
+ * protocol constraints. The open PDUs are kept sorted by (slave, FC,
+ * address), so the candidates for each block are found by binary search
+ * instead of a scan over every PDU.
  */
 
 #include "ffd_pack.h"
 
 #include "../utils/block_utils.h"
 #include "fc_policy.h"
+#include "smartmodbus/mb_config.h"
 #include "smartmodbus/mb_error.h"
 
 #include <stdlib.h>
 #include <string.h>
 
+/**
+ * @brief Largest quantity one PDU may read for a function code
+ */
+static uint16_t pdu_unit_limit(uint8_t fc, uint16_t max_pdu_chars) {
+    uint8_t unit_size = mb_fc_get_unit_size(fc);
+    uint32_t limit    = 0;
+
+    if (unit_size == 1) {
+        limit = (uint32_t)max_pdu_chars * 8;
+    } else if (unit_size == 2) {
+        limit = max_pdu_chars / 2u;
+    }
+
+    uint16_t max_quantity = mb_fc_get_max_quantity(fc);
+    return (uint16_t)(limit < max_quantity ? limit : max_quantity);
+}
+
+/**
+ * @brief Packing order key: slave, function code, start address
+ */
+static inline uint32_t order_key(uint8_t slave_id, uint8_t fc, uint16_t start_address) {
+    return ((uint32_t)slave_id << 24) | ((uint32_t)fc << 16) | start_address;
+}
+
+/**
+ * @brief Index of the first PDU ordered after the block's start (binary search)
+ */
+static uint16_t pdu_upper_bound(const mb_pdu_t *pdus, uint16_t count, const mb_block_t *block) {
+    uint32_t key = order_key(block->slave_id, block->function_code, block->start_address);
+    uint16_t lo  = 0;
+    uint16_t hi  = count;
+
+    while (lo < hi) {
+        uint16_t mid = (uint16_t)(lo + (hi - lo) / 2);
+        if (order_key(pdus[mid].slave_id, pdus[mid].function_code, pdus[mid].start_address) <=
+            key) {
+            lo = (uint16_t)(mid + 1);
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief Units a PDU grows by when the block joins it
+ */
+static uint32_t merged_growth(const mb_block_t *block, const mb_pdu_t *pdu) {
+    uint32_t start     = block->start_address < pdu->start_address ? block->start_address
+                                                                     : pdu->start_address;
+    uint32_t block_end = (uint32_t)block->start_address + block->quantity;
+    uint32_t pdu_end   = (uint32_t)pdu->start_address + pdu->quantity;
+    uint32_t end       = block_end > pdu_end ? block_end : pdu_end;
+    return end - start - pdu->quantity;
+}
+
 void mb_init_pdu(mb_pdu_t *pdu, uint8_t slave_id, uint8_t fc) {
     if (pdu == NULL) {
         return;
@@ -145,58 +204,115 @@ int mb_ffd_pack(const mb_block_t *blocks,
     }
 
     // Create a working copy of blocks for sorting
+#ifdef MB_USE_STATIC_MEMORY
+    if (block_count > MB_MAX_BLOCKS) {
+        return MB_ERROR_TOO_MANY_BLOCKS;
+    }
+    mb_block_t sorted_blocks[MB_MAX_BLOCKS];
+#else
     mb_block_t *sorted_blocks = (mb_block_t *)malloc(block_count * sizeof(mb_block_t));
     if (sorted_blocks == NULL) {
         return MB_ERROR_OUT_OF_MEMORY;
     }
+#endif
 
     memcpy(sorted_blocks, blocks, block_count * sizeof(mb_block_t));
 
-    // Sort blocks by quantity (descending) for FFD
-    mb_block_sort_by_quantity_desc(sorted_blocks, block_count);
+    int result = mb_ffd_pack_inplace(sorted_blocks, block_count, max_pdu_chars, pdus, max_pdus,
+                                     pdu_count, NULL);
 
-    // Initialize PDU count
+#ifndef MB_USE_STATIC_MEMORY
+    free(sorted_blocks);
+#endif
+
+    return result;
+}
+
+int mb_ffd_pack_inplace(mb_block_t *blocks,
+                        uint16_t block_count,
+                        uint16_t max_pdu_chars,
+                        mb_pdu_t *pdus,
+                        uint16_t max_pdus,
+                        uint16_t *pdu_count,
+                        mb_scratch_t *scratch) {
+    if (blocks == NULL || pdus == NULL || pdu_count == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (block_count == 0) {
+        *pdu_count = 0;
+        return MB_SUCCESS;
+    }
+
+    // Sort blocks by quantity (descending) for FFD, in linear time
+    mb_block_sort_by_quantity_desc_scratch(blocks, block_count, scratch);
+
+    // PDUs are kept ordered by (slave, FC, start address). A PDU only ever
+    // grows over the gap next to it, so the order survives every merge and
+    // a block can only join its predecessor or successor in that order:
+    // joining any other PDU would span one of these.
     uint16_t num_pdus = 0;
 
-    // FFD algorithm: for each block, find first PDU that fits
     for (uint16_t i = 0; i < block_count; i++) {
-        const mb_block_t *block = &sorted_blocks[i];
-        bool placed             = false;
-
-        // Try to fit in existing PDUs (first-fit)
-        for (uint16_t j = 0; j < num_pdus; j++) {
-            if (mb_block_fits_pdu(block, &pdus[j], max_pdu_chars)) {
-                // Add block to this PDU
-                int result = mb_add_block_to_pdu(block, &pdus[j]);
-                if (result != MB_SUCCESS) {
-                    free(sorted_blocks);
-                    return result;
-                }
-                placed = true;
-                break;
-            }
+        const mb_block_t *block = &blocks[i];
+
+        uint16_t limit = pdu_unit_limit(block->function_code, max_pdu_chars);
+        if (limit == 0) {
+            return MB_ERROR_INVALID_PARAM;
+        }
+
+        uint16_t next_index = pdu_upper_bound(pdus, num_pdus, block);
+
+        // Prefer the neighbor that grows least, i.e. reads the fewest gap units
+        mb_pdu_t *target = NULL;
+        uint32_t growth  = UINT32_MAX;
+        if (next_index > 0 && mb_block_fits_pdu(block, &pdus[next_index - 1], max_pdu_chars)) {
+            target = &pdus[next_index - 1];
+            growth = merged_growth(block, target);
+        }
+        if (next_index < num_pdus && mb_block_fits_pdu(block, &pdus[next_index], max_pdu_chars) &&
+            merged_growth(block, &pdus[next_index]) < growth) {
+            target = &pdus[next_index];
         }
 
-        // If not placed, create new PDU
-        if (!placed) {
-            if (num_pdus >= max_pdus) {
-                free(sorted_blocks);
-                return MB_ERROR_TOO_MANY_BLOCKS;
+        if (target != NULL) {
+            int result = mb_add_block_to_pdu(block, target);
+            if (result != MB_SUCCESS) {
+                return result;
             }
+            continue;
+        }
 
-            // Initialize new PDU with this block
-            mb_init_pdu(&pdus[num_pdus], block->slave_id, block->function_code);
-            int result = mb_add_block_to_pdu(block, &pdus[num_pdus]);
+        // No neighbor fits: new PDUs at the block's place in the order. A
+        // block larger than one PDU (a long contiguous run, or a merge
+        // across gaps) is split into full-size chunks, the last one taking
+        // the remainder
+        uint16_t chunks = (uint16_t)((block->quantity + limit - 1) / limit);
+        if (chunks > max_pdus - num_pdus) {
+            return MB_ERROR_TOO_MANY_BLOCKS;
+        }
+        memmove(&pdus[next_index + chunks], &pdus[next_index],
+                (size_t)(num_pdus - next_index) * sizeof(mb_pdu_t));
+
+        uint32_t next = block->start_address;
+        uint32_t end  = next + block->quantity;
+        for (uint16_t c = 0; c < chunks; c++) {
+            mb_block_t chunk    = *block;
+            chunk.start_address = (uint16_t)next;
+            chunk.quantity      = (uint16_t)(end - next < limit ? end - next : limit);
+
+            mb_pdu_t *pdu = &pdus[next_index + c];
+            mb_init_pdu(pdu, block->slave_id, block->function_code);
+            int result = mb_add_block_to_pdu(&chunk, pdu);
             if (result != MB_SUCCESS) {
-                free(sorted_blocks);
                 return result;
             }
-            num_pdus++;
+            next += chunk.quantity;
         }
+        num_pdus = (uint16_t)(num_pdus + chunks);
     }
 
     *pdu_count = num_pdus;
 
-    free(sorted_blocks);
     return MB_SUCCESS;
 }
@@ -31,9 +31,15 @@ extern "C" {
  * Algorithm:
  * 1. Sort blocks by data length (descending)
  * 2. For each block:
- *    - Try to fit in existing PDU (first-fit)
- *    - If no fit, create new PDU
+ *    - Try the PDUs just before and after it in address order (binary
+ *      search), taking the one that needs the smaller gap
+ *    - If neither fits, create new PDU
  * 3. Constraints: same FC, same slave, within MAX_PDU_CHAR
+ *
+ * A block larger than one PDU is split into consecutive full-size PDUs,
+ * so any block array can be packed as long as max_pdus allows. PDUs are
+ * returned sorted by slave, function code and start address and never
+ * overlap for non-overlapping blocks.
  */
 int mb_ffd_pack(const mb_block_t *blocks,
                 uint16_t block_count,
@@ -42,6 +48,28 @@ int mb_ffd_pack(const mb_block_t *blocks,
                 uint16_t max_pdus,
                 uint16_t *pdu_count);
 
+/**
+ * @brief Pack blocks into PDUs, reordering the caller's array
+ * @param blocks Array of blocks to pack (sorted by quantity on return)
+ * @param block_count Number of blocks
+ * @param max_pdu_chars Maximum PDU size in characters
+ * @param pdus Output array of PDUs
+ * @param max_pdus Maximum number of PDUs
+ * @param pdu_count Output: actual number of PDUs created
+ * @param scratch Arena for the sort buffer (NULL = heap or stack)
+ * @return 0 on success, negative error code on failure
+ *
+ * Same algorithm as mb_ffd_pack() without the working copy, for callers
+ * that own the block array and need no allocation.
+ */
+int mb_ffd_pack_inplace(mb_block_t *blocks,
+                        uint16_t block_count,
+                        uint16_t max_pdu_chars,
+                        mb_pdu_t *pdus,
+                        uint16_t max_pdus,
+                        uint16_t *pdu_count,
+                        mb_scratch_t *scratch);
+
 /**
  * @brief Check if block fits in PDU
  * @param block Block to check
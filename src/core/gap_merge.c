@@ -44,7 +44,7 @@ bool mb_should_merge_blocks(const mb_block_t *block_a,
     }
 
     // Calculate merge savings
-    int16_t savings = mb_calc_merge_savings(gap_units, block_a->function_code, cost_params);
+    int32_t savings = mb_calc_merge_savings(gap_units, block_a->function_code, cost_params);
 
     // Merge if savings are positive (gap cost < overhead cost)
     return savings > 0;
@@ -121,7 +121,9 @@ uint16_t mb_merge_blocks_greedy(mb_block_t *blocks,
 
     // Initialize cost parameters
     mb_cost_params_t cost_params;
-    mb_init_cost_params(mode, fc, latency_chars, &cost_params);
+    if (mb_init_cost_params(mode, fc, latency_chars, &cost_params) != MB_SUCCESS) {
+        return 0;
+    }
 
     // Perform merging
     int result = mb_merge_block_array(blocks, block_count, &cost_params);
@@ -0,0 +1,337 @@
+/**
+ * @file optimal_merge.c
+ * @brief Optimal merge planner implementation
+ *
+ * best[k] is the minimum cost to read blocks[0..k-1]. Each step extends the
+ * prefix with one more run ending at block j, trying every start i whose
+ * span still fits one PDU. run_start[] records the winning split points so
+ * the partition can be rebuilt backwards.
+ *
+ * In the character model a run's cost is linear in its start address
+ * (registers), or in the start's byte once its bit offset is fixed (coils),
+ * so the best start of each class is kept in a monotone queue over the
+ * sliding window of starts that fit one PDU and every step is O(1). The
+ * time model rounds each run to microseconds and scans the window.
+ */
+
+#include "optimal_merge.h"
+
+#include "../utils/block_utils.h"
+#include "char_model.h"
+#include "ffd_pack.h"
+#include "fc_policy.h"
+#include "smartmodbus/mb_config.h"
+#include "smartmodbus/mb_error.h"
+
+#include <stdbool.h>
+
+/**
+ * @brief Response data bytes for a span of units
+ */
+static uint32_t span_data_chars(bool is_bits, uint32_t quantity) {
+    return is_bits ? (quantity + 7) / 8 : quantity * 2;
+}
+
+/**
+ * @brief Cost and PDU count of a span split into limit-sized chunks
+ */
+static uint32_t span_cost(bool is_bits,
+                          uint32_t span,
+                          uint32_t limit,
+                          const mb_cost_params_t *cost_params,
+                          uint16_t *pieces) {
+    uint32_t full      = span / limit;
+    uint32_t remainder = span % limit;
+
+    *pieces = (uint16_t)(full + (remainder > 0 ? 1 : 0));
+
+    uint32_t cost =
+        full * mb_calc_full_round_trip_cost(cost_params, span_data_chars(is_bits, limit));
+    if (remainder > 0) {
+        cost += mb_calc_full_round_trip_cost(cost_params, span_data_chars(is_bits, remainder));
+    }
+    return cost;
+}
+
+/**
+ * @brief Ordering key of run start i within its queue class
+ *
+ * cost(i, j) = best[i] + data(end_j - start_i) + a term of j and the class:
+ * data is 2 × span for registers, and for coils byte(end_j) - byte(start_i)
+ * plus one when the end's bit offset lies above the start's.
+ */
+static int64_t start_key(bool is_bits, uint32_t best, uint16_t start) {
+    return (int64_t)best - (is_bits ? (int64_t)(start >> 3) : 2 * (int64_t)start);
+}
+
+/**
+ * @brief Forward pass over the window of each run end by monotone queues
+ * @param queue block_count entries, partitioned by class (start bit offset)
+ */
+static void plan_forward_queued(const mb_block_t *blocks,
+                                uint16_t block_count,
+                                bool is_bits,
+                                uint32_t limit,
+                                const mb_cost_params_t *cost_params,
+                                uint32_t *best,
+                                uint16_t *used,
+                                uint16_t *run_start,
+                                uint16_t *queue) {
+    uint8_t classes = is_bits ? 8 : 1;
+    uint16_t head[8];
+    uint16_t tail[8];
+
+    // Class c queues the starts i with start_address % 8 == c, in index order
+    uint16_t offset = 0;
+    for (uint8_t c = 0; c < classes; c++) {
+        head[c] = offset;
+        tail[c] = offset;
+        for (uint16_t i = 0; i < block_count; i++) {
+            if ((is_bits ? blocks[i].start_address & 7 : 0) == c) {
+                offset++;
+            }
+        }
+    }
+
+    best[0]     = 0;
+    used[0]     = 0;
+    uint16_t lo = 0;
+
+    for (uint16_t j = 0; j < block_count; j++) {
+        uint8_t c    = is_bits ? (uint8_t)(blocks[j].start_address & 7) : 0;
+        int64_t key  = start_key(is_bits, best[j], blocks[j].start_address);
+        uint16_t end = tail[c];
+
+        // A later start with no larger key is never worse: drop the earlier ones
+        while (end > head[c]) {
+            uint16_t back    = queue[end - 1];
+            int64_t back_key = start_key(is_bits, best[back], blocks[back].start_address);
+            if (back_key < key || (back_key == key && used[back] < used[j])) {
+                break;
+            }
+            end--;
+        }
+        queue[end] = j;
+        tail[c]    = (uint16_t)(end + 1);
+
+        uint32_t run_end = (uint32_t)blocks[j].start_address + blocks[j].quantity;
+        while (lo < j && run_end - blocks[lo].start_address > limit) {
+            lo++;
+        }
+
+        best[j + 1] = UINT32_MAX;
+        used[j + 1] = UINT16_MAX;
+
+        for (c = 0; c < classes; c++) {
+            while (head[c] < tail[c] && queue[head[c]] < lo) {
+                head[c]++;
+            }
+            if (head[c] == tail[c]) {
+                continue;
+            }
+
+            // An oversized lone block is split, as the scan does
+            uint16_t i      = queue[head[c]];
+            uint16_t pieces = 0;
+            uint32_t cost   = best[i] + span_cost(is_bits, run_end - blocks[i].start_address,
+                                                  limit, cost_params, &pieces);
+            uint16_t count  = (uint16_t)(used[i] + pieces);
+
+            // Ties go to the later start, like the scan from the right
+            if (cost < best[j + 1] || (cost == best[j + 1] && count < used[j + 1]) ||
+                (cost == best[j + 1] && count == used[j + 1] && i > run_start[j + 1])) {
+                best[j + 1]      = cost;
+                used[j + 1]      = count;
+                run_start[j + 1] = i;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Forward pass trying every start of each run end
+ */
+static void plan_forward_scan(const mb_block_t *blocks,
+                              uint16_t block_count,
+                              bool is_bits,
+                              uint32_t limit,
+                              const mb_cost_params_t *cost_params,
+                              uint32_t *best,
+                              uint16_t *used,
+                              uint16_t *run_start) {
+    best[0] = 0;
+    used[0] = 0;
+
+    for (uint16_t j = 0; j < block_count; j++) {
+        best[j + 1] = UINT32_MAX;
+        used[j + 1] = UINT16_MAX;
+
+        uint32_t end = 0;
+        for (uint16_t i = (uint16_t)(j + 1); i-- > 0;) {
+            uint32_t block_end = (uint32_t)blocks[i].start_address + blocks[i].quantity;
+            if (block_end > end) {
+                end = block_end;
+            }
+
+            // Spans only grow as i moves left; an oversized lone block is split
+            uint32_t span = end - blocks[i].start_address;
+            if (span > limit && i != j) {
+                break;
+            }
+
+            uint16_t pieces = 0;
+            uint32_t cost   = best[i] + span_cost(is_bits, span, limit, cost_params, &pieces);
+            uint16_t count  = (uint16_t)(used[i] + pieces);
+
+            if (cost < best[j + 1] || (cost == best[j + 1] && count < used[j + 1])) {
+                best[j + 1]      = cost;
+                used[j + 1]      = count;
+                run_start[j + 1] = i;
+            }
+        }
+    }
+}
+
+int mb_plan_optimal(const mb_block_t *blocks,
+                    uint16_t block_count,
+                    const mb_cost_params_t *cost_params,
+                    uint16_t max_pdu_chars,
+                    mb_pdu_t *pdus,
+                    uint16_t max_pdus,
+                    uint16_t *pdu_count,
+                    mb_scratch_t *scratch) {
+    if (blocks == NULL || cost_params == NULL || pdus == NULL || pdu_count == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    *pdu_count = 0;
+    if (block_count == 0) {
+        return MB_SUCCESS;
+    }
+
+    // All blocks must share slave and FC
+    for (uint16_t i = 1; i < block_count; i++) {
+        if (!mb_block_are_compatible(&blocks[0], &blocks[i]) ||
+            blocks[i].start_address < blocks[i - 1].start_address) {
+            return MB_ERROR_INVALID_PARAM;
+        }
+    }
+
+    uint8_t fc            = blocks[0].function_code;
+    uint8_t unit_size     = mb_fc_get_unit_size(fc);
+    uint16_t max_quantity = mb_fc_get_max_quantity(fc);
+    if (unit_size == 0 || max_quantity == 0) {
+        return MB_ERROR_INVALID_FC;
+    }
+
+    // Largest span one PDU may carry
+    bool is_bits       = (unit_size == 1);
+    uint32_t pdu_units = is_bits ? (uint32_t)max_pdu_chars * 8 : (uint32_t)max_pdu_chars / 2;
+    uint32_t limit     = (pdu_units < max_quantity) ? pdu_units : max_quantity;
+    if (limit == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    // Overlapping blocks end runs anywhere inside: only the scan handles them
+    bool queued = cost_params->byte_ns == 0;
+    for (uint16_t i = 1; i < block_count && queued; i++) {
+        queued = blocks[i].start_address >=
+                 (uint32_t)blocks[i - 1].start_address + blocks[i - 1].quantity;
+    }
+
+    uint32_t *best      = NULL;
+    uint16_t *used      = NULL;
+    uint16_t *run_start = NULL;
+    uint16_t *queue     = NULL;
+
+#ifdef MB_USE_STATIC_MEMORY
+    if (block_count > MB_MAX_BLOCKS) {
+        return MB_ERROR_TOO_MANY_BLOCKS;
+    }
+    uint32_t static_best[MB_MAX_BLOCKS + 1];
+    uint16_t static_used[MB_MAX_BLOCKS + 1];
+    uint16_t static_run_start[MB_MAX_BLOCKS + 1];
+    uint16_t static_queue[MB_MAX_BLOCKS];
+    best      = static_best;
+    used      = static_used;
+    run_start = static_run_start;
+    queue     = static_queue;
+    (void)scratch;
+#else
+    size_t mark    = mb_scratch_mark(scratch);
+    size_t entries = (size_t)block_count + 1;
+    best      = (uint32_t *)mb_scratch_acquire(scratch, entries * sizeof(uint32_t));
+    used      = (uint16_t *)mb_scratch_acquire(scratch, entries * sizeof(uint16_t));
+    run_start = (uint16_t *)mb_scratch_acquire(scratch, entries * sizeof(uint16_t));
+    queue     = (uint16_t *)mb_scratch_acquire(scratch, entries * sizeof(uint16_t));
+    if (best == NULL || used == NULL || run_start == NULL || queue == NULL) {
+        mb_scratch_release(scratch, best);
+        mb_scratch_release(scratch, used);
+        mb_scratch_release(scratch, run_start);
+        mb_scratch_release(scratch, queue);
+        mb_scratch_rewind(scratch, mark);
+        return MB_ERROR_OUT_OF_MEMORY;
+    }
+#endif
+
+    // Forward pass: best run ending at each block
+    if (queued) {
+        plan_forward_queued(blocks, block_count, is_bits, limit, cost_params, best, used,
+                            run_start, queue);
+    } else {
+        plan_forward_scan(blocks, block_count, is_bits, limit, cost_params, best, used,
+                          run_start);
+    }
+
+    uint16_t total = used[block_count];
+    int result     = MB_SUCCESS;
+
+    if (total > max_pdus) {
+        result = MB_ERROR_TOO_MANY_BLOCKS;
+    } else {
+        // Backward pass: rebuild runs from the split points
+        uint16_t pos = total;
+        uint16_t k   = block_count;
+
+        while (k > 0) {
+            uint16_t i = run_start[k];
+
+            uint32_t end = 0;
+            for (uint16_t b = i; b < k; b++) {
+                uint32_t block_end = (uint32_t)blocks[b].start_address + blocks[b].quantity;
+                if (block_end > end) {
+                    end = block_end;
+                }
+            }
+
+            uint32_t start  = blocks[i].start_address;
+            uint16_t pieces = (uint16_t)((end - start + limit - 1) / limit);
+            pos             = (uint16_t)(pos - pieces);
+
+            for (uint16_t p = 0; p < pieces; p++) {
+                uint32_t piece_start = start + (uint32_t)p * limit;
+                uint32_t piece_end   = piece_start + limit < end ? piece_start + limit : end;
+
+                mb_pdu_t *pdu = &pdus[pos + p];
+                mb_init_pdu(pdu, blocks[i].slave_id, fc);
+                pdu->start_address = (uint16_t)piece_start;
+                pdu->quantity      = (uint16_t)(piece_end - piece_start);
+                pdu->total_chars   = mb_calc_pdu_data_size(pdu);
+            }
+
+            k = i;
+        }
+
+        *pdu_count = total;
+    }
+
+#ifndef MB_USE_STATIC_MEMORY
+    mb_scratch_release(scratch, best);
+    mb_scratch_release(scratch, used);
+    mb_scratch_release(scratch, run_start);
+    mb_scratch_release(scratch, queue);
+    mb_scratch_rewind(scratch, mark);
+#endif
+
+    return result;
+}
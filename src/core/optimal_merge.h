@@ -0,0 +1,56 @@
+/**
+ * @file optimal_merge.h
+ * @brief Optimal merge planner (dynamic programming)
+ *
+ * Alternative to the greedy gap merge + FFD pipeline. Because a read request
+ * always transfers a contiguous address range, an optimal plan for sorted
+ * blocks is a partition into consecutive runs. The planner evaluates every
+ * feasible run against the character cost model and keeps the partition with
+ * the fewest total characters, honouring the FC quantity limit and
+ * MAX_PDU_CHAR while merging rather than afterwards.
+ */
+
+#ifndef SMARTMODBUS_OPTIMAL_MERGE_H
+#define SMARTMODBUS_OPTIMAL_MERGE_H
+
+#include "../utils/scratch.h"
+#include "smartmodbus/mb_types.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Plan PDUs with minimum total round-trip characters
+ * @param blocks Blocks of one slave and FC, sorted by start address
+ * @param block_count Number of blocks
+ * @param cost_params Cost calculation parameters
+ * @param max_pdu_chars Maximum response data per PDU in characters
+ * @param pdus Output array of PDUs (sorted by start address)
+ * @param max_pdus Maximum number of PDUs
+ * @param pdu_count Output: actual number of PDUs created
+ * @param scratch Arena for the DP tables (NULL = heap, or stack when static)
+ * @return 0 on success, negative error code on failure
+ *
+ * Cost of a run = mb_calc_full_round_trip_cost() of its span: every
+ * round-trip pays its whole line overhead, so a round is only added where
+ * it is cheaper than the gap it skips. Ties are broken towards fewer PDUs. A single block larger than the limit is split into
+ * full-size chunks. Runs in O(n × w), where w is the number of blocks that
+ * fit in one PDU span.
+ */
+int mb_plan_optimal(const mb_block_t *blocks,
+                    uint16_t block_count,
+                    const mb_cost_params_t *cost_params,
+                    uint16_t max_pdu_chars,
+                    mb_pdu_t *pdus,
+                    uint16_t max_pdus,
+                    uint16_t *pdu_count,
+                    mb_scratch_t *scratch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_OPTIMAL_MERGE_H
@@ -0,0 +1,204 @@
+/**
+ * @file adaptive_poll.c
+ * @brief Adaptive poll rate implementation
+ *
+ * Each mb_adaptive_poll() fills batches with the due groups in index
+ * order, first fit: a group that does not fit the current batch waits
+ * for the next one of the same call. A read group is not due again before
+ * now_ms + its period, so every call ends once each due group was read
+ * (or a batch failed).
+ */
+
+#include "smartmodbus/mb_adaptive.h"
+#include "smartmodbus/mb_error.h"
+#include "smartmodbus/smartmodbus.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+// Changes handed to on_change per call
+#define ADAPTIVE_CHANGES 16
+
+static bool is_due(const mb_adaptive_group_t *group, uint32_t now_ms) {
+    return (int32_t)(now_ms - group->due_ms) >= 0;
+}
+
+static uint16_t batch_limit(void) {
+    uint16_t limit = MB_ADAPTIVE_BATCH_TAGS;
+#ifdef MB_USE_STATIC_MEMORY
+    if (limit > MB_MAX_SCATTER) {
+        limit = MB_MAX_SCATTER;
+    }
+#endif
+    return limit;
+}
+
+/**
+ * @brief Report a fresh read of a group and pick its next period
+ */
+static void group_read(mb_adaptive_t *poller, uint16_t index, uint32_t now_ms) {
+    mb_adaptive_group_t *group = &poller->groups[index];
+    mb_change_t changes[ADAPTIVE_CHANGES];
+    bool moved = false;
+    int result;
+
+    do {
+        uint16_t count = 0;
+        result = mb_change_set_detect(&group->changes, group->data, changes, ADAPTIVE_CHANGES,
+                                      &count);
+        if (count > 0) {
+            moved = true;
+            if (poller->on_change != NULL) {
+                poller->on_change(poller->ctx, index, changes, count);
+            }
+        }
+    } while (result == MB_ERROR_BUFFER_TOO_SMALL);
+
+    // A moving group is read at full rate, a quiet one backs off exponentially
+    if (moved) {
+        group->period_ms = group->min_period_ms;
+    } else if (group->period_ms > group->max_period_ms / 2) {
+        group->period_ms = group->max_period_ms;
+    } else {
+        group->period_ms *= 2;
+    }
+
+    group->reads++;
+    group->due_ms = now_ms + group->period_ms;
+}
+
+int mb_adaptive_init(mb_adaptive_t *poller,
+                     mb_adaptive_group_t *groups,
+                     uint16_t capacity,
+                     mb_adaptive_change_fn on_change,
+                     void *ctx) {
+    if (poller == NULL || (groups == NULL && capacity > 0)) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    memset(poller, 0, sizeof(*poller));
+    poller->groups         = groups;
+    poller->group_capacity = capacity;
+    poller->on_change      = on_change;
+    poller->ctx            = ctx;
+    return MB_SUCCESS;
+}
+
+int mb_adaptive_add(mb_adaptive_t *poller,
+                    const mb_tag_t *tags,
+                    uint16_t tag_count,
+                    uint16_t *data,
+                    uint16_t *last,
+                    const uint16_t *deadband,
+                    uint32_t min_period_ms,
+                    uint32_t max_period_ms) {
+    if (poller == NULL || tags == NULL || tag_count == 0 || data == NULL || last == NULL ||
+        min_period_ms == 0 || max_period_ms < min_period_ms) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (tag_count > batch_limit()) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    if (poller->group_count >= poller->group_capacity) {
+        return MB_ERROR_TOO_MANY_BLOCKS;
+    }
+
+    mb_adaptive_group_t *group = &poller->groups[poller->group_count];
+    memset(group, 0, sizeof(*group));
+    int result = mb_change_set_init_tags(&group->changes, tags, tag_count, last, deadband);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    group->data          = data;
+    group->min_period_ms = min_period_ms;
+    group->max_period_ms = max_period_ms;
+    group->period_ms     = min_period_ms;
+    return poller->group_count++;
+}
+
+void mb_adaptive_start(mb_adaptive_t *poller, uint32_t now_ms) {
+    if (poller == NULL) {
+        return;
+    }
+
+    for (uint16_t g = 0; g < poller->group_count; g++) {
+        mb_adaptive_group_t *group = &poller->groups[g];
+        mb_change_set_reset(&group->changes);
+        group->period_ms = group->min_period_ms;
+        group->due_ms    = now_ms;
+    }
+}
+
+int mb_adaptive_poll(mb_master_t *master,
+                     mb_adaptive_t *poller,
+                     uint32_t now_ms,
+                     uint32_t *wait_ms) {
+    if (master == NULL || poller == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    mb_tag_t batch[MB_ADAPTIVE_BATCH_TAGS];
+    uint16_t values[MB_ADAPTIVE_BATCH_TAGS];
+    uint16_t members[MB_ADAPTIVE_BATCH_TAGS];
+    uint16_t limit = batch_limit();
+    int result     = MB_SUCCESS;
+    int read       = 0;
+
+    while (result == MB_SUCCESS) {
+        uint16_t count        = 0;
+        uint16_t member_count = 0;
+        for (uint16_t g = 0; g < poller->group_count; g++) {
+            const mb_adaptive_group_t *group = &poller->groups[g];
+            uint16_t tag_count               = group->changes.count;
+            if (!is_due(group, now_ms) || count + tag_count > limit) {
+                continue;
+            }
+            memcpy(&batch[count], group->changes.tags, tag_count * sizeof(mb_tag_t));
+            count                   = (uint16_t)(count + tag_count);
+            members[member_count++] = g;
+        }
+        if (member_count == 0) {
+            break;
+        }
+
+        // One optimizer run over everything due: blocks of different groups merge
+        result = mb_master_read_batch(master, batch, count, values, count);
+        poller->batches++;
+
+        uint16_t offset = 0;
+        for (uint16_t m = 0; m < member_count; m++) {
+            mb_adaptive_group_t *group = &poller->groups[members[m]];
+            uint16_t tag_count         = group->changes.count;
+            if (result == MB_SUCCESS) {
+                memcpy(group->data, &values[offset], tag_count * sizeof(uint16_t));
+                group_read(poller, members[m], now_ms);
+                read++;
+            } else {
+                group->errors++;
+                group->period_ms = group->min_period_ms;
+                group->due_ms    = now_ms + group->min_period_ms;
+            }
+            offset = (uint16_t)(offset + tag_count);
+        }
+        if (result == MB_SUCCESS) {
+            poller->tags_read += count;
+        }
+    }
+
+    if (wait_ms != NULL) {
+        uint32_t wait = UINT32_MAX;
+        for (uint16_t g = 0; g < poller->group_count; g++) {
+            const mb_adaptive_group_t *group = &poller->groups[g];
+            uint32_t until = is_due(group, now_ms) ? 0 : group->due_ms - now_ms;
+            if (until < wait) {
+                wait = until;
+            }
+        }
+        *wait_ms = wait;
+    }
+
+    return result == MB_SUCCESS ? read : result;
+}
@@ -0,0 +1,655 @@
+/**
+ * @file async.c
+ * @brief Non-blocking poll and write execution
+ *
+ * Each mb_async_step() call runs send → receive → dispatch until the
+ * transport has nothing more to give, then checks deadlines and returns.
+ * Response boundaries are found from the bytes themselves rather than from
+ * the transport: the MBAP length in TCP, the expected response length of
+ * the outstanding plan in RTU, and the CRLF trailer in ASCII.
+ */
+
+#include "smartmodbus/mb_async.h"
+#include "smartmodbus/mb_error.h"
+#include "smartmodbus/smartmodbus.h"
+#include "response_parser.h"
+#include "trace.h"
+#include "transaction.h"
+#include "../protocol/frame_builder.h"
+
+#include <string.h>
+
+/**
+ * @brief MBAP header size up to and including the length field
+ */
+#define MBAP_PREFIX_CHARS 6
+
+/**
+ * @brief RTU exception response: slave + FC + code + CRC
+ */
+#define RTU_EXCEPTION_CHARS 5
+
+/**
+ * @brief Largest RTU ADU
+ */
+#define RTU_MAX_ADU_CHARS 256
+
+/**
+ * @brief Frame format of op's mode, a constant in MB_FIXED_MODE builds
+ */
+static inline mb_mode_t op_mode(const mb_async_op_t *op) {
+    return MB_MODE_FRAMING(MB_ACTIVE_MODE(op->mode));
+}
+
+/**
+ * @brief Wrap-safe "deadline has passed" on a 32-bit millisecond clock
+ */
+static bool deadline_passed(uint32_t now_ms, uint32_t deadline_ms) {
+    return (int32_t)(now_ms - deadline_ms) >= 0;
+}
+
+/**
+ * @brief Transport clock for metrics, MB_METRICS_UNTIMED without one
+ */
+static uint32_t metrics_clock(const mb_master_t *master) {
+    if (master->config.metrics == NULL || master->config.transport.clock_us == NULL) {
+        return MB_METRICS_UNTIMED;
+    }
+    return master->config.transport.clock_us(master->config.transport.context);
+}
+
+/**
+ * @brief Record the outcome of the request in a slot
+ */
+static void metrics_outcome(mb_async_op_t *op,
+                            const mb_async_slot_t *slot,
+                            int result,
+                            bool exception,
+                            uint32_t chars) {
+    mb_master_t *master = op->master;
+    if (master->config.metrics == NULL) {
+        return;
+    }
+
+    const mb_request_plan_t *plan = &op->plans[slot->plan_index];
+    uint32_t now_us               = metrics_clock(master);
+    uint32_t rtt                  = result == MB_SUCCESS && now_us != MB_METRICS_UNTIMED
+                                        ? now_us - slot->sent_us
+                                        : MB_METRICS_UNTIMED;
+    mb_metrics_record_response(master->config.metrics, plan->slave_id, plan->function_code,
+                               result, exception, chars, rtt);
+}
+
+static int finish(mb_async_op_t *op, int result) {
+    op->state  = MB_ASYNC_DONE;
+    op->result = result;
+
+    if (result == MB_SUCCESS && op->poll != NULL) {
+        op->master->stats.optimized_requests++;
+        op->master->stats.blocks_merged +=
+            (uint32_t)(op->poll->address_count - op->plan_count);
+        mb_metrics_record_plans(op->master->config.metrics, op->plans, op->plan_count,
+                                op->poll->scatter);
+    }
+
+    // The callback may resubmit op: do not touch it afterwards
+    if (op->on_done != NULL) {
+        op->on_done(op->ctx, result);
+    }
+    return result;
+}
+
+/**
+ * @brief Slot of the single outstanding serial request, or -1
+ */
+static int serial_slot(const mb_async_op_t *op) {
+    for (uint8_t i = 0; i < op->window; i++) {
+        if (op->slots[i].in_flight) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Length of the complete response at the head of rx
+ * @return Frame length, 0 if incomplete, negative error code if malformed
+ */
+static int rx_frame_length(const mb_async_op_t *op) {
+    switch (op_mode(op)) {
+    case MB_MODE_TCP: {
+        if (op->rx_length < MBAP_PREFIX_CHARS) {
+            return 0;
+        }
+        uint16_t length    = (uint16_t)(((uint16_t)op->rx[4] << 8) | op->rx[5]);
+        size_t frame_chars = MBAP_PREFIX_CHARS + (size_t)length;
+        if (length < 2 || frame_chars > MB_TCP_MAX_ADU_CHARS) {
+            return MB_ERROR_INVALID_FRAME;
+        }
+        return op->rx_length >= frame_chars ? (int)frame_chars : 0;
+    }
+
+    case MB_MODE_RTU: {
+        int slot = serial_slot(op);
+        if (slot < 0 || op->rx_length < 2) {
+            return 0;
+        }
+        size_t frame_chars = (op->rx[1] & 0x80) != 0
+                                 ? RTU_EXCEPTION_CHARS
+                                 : op->plans[op->slots[slot].plan_index]
+                                       .expected_response_length;
+        if (frame_chars < RTU_EXCEPTION_CHARS || frame_chars > RTU_MAX_ADU_CHARS) {
+            return MB_ERROR_INVALID_FRAME;
+        }
+        return op->rx_length >= frame_chars ? (int)frame_chars : 0;
+    }
+
+    case MB_MODE_ASCII: {
+        const uint8_t *lf = (const uint8_t *)memchr(op->rx, '\n', op->rx_length);
+        return lf != NULL ? (int)(lf - op->rx) + 1 : 0;
+    }
+
+    default:
+        return MB_ERROR_INVALID_PARAM;
+    }
+}
+
+/**
+ * @brief Drop the frame at the head of rx
+ */
+static void rx_consume(mb_async_op_t *op, size_t frame_chars) {
+    op->rx_length -= frame_chars;
+    if (op->rx_length > 0) {
+        memmove(op->rx, &op->rx[frame_chars], op->rx_length);
+    }
+}
+
+/**
+ * @brief Start new requests and push pending bytes until the transport pushes back
+ */
+static int async_send(mb_async_op_t *op, uint32_t now_ms) {
+    mb_master_t *master = op->master;
+
+    for (;;) {
+        if (!op->tx_pending) {
+            if (op->in_flight >= op->window || op->next_plan >= op->plan_count) {
+                return MB_SUCCESS;
+            }
+
+            uint8_t slot = 0;
+            while (op->slots[slot].in_flight) {
+                slot++;
+            }
+
+            const mb_request_plan_t *next = &op->plans[op->next_plan];
+            uint16_t transaction_id       = master->transaction_id++;
+            uint8_t *frame                = next->frame_data;
+            if (op_mode(op) == MB_MODE_TCP) {
+                frame[0] = (uint8_t)((transaction_id >> 8) & 0xFF);
+                frame[1] = (uint8_t)(transaction_id & 0xFF);
+            }
+
+            // Deadline also bounds a send that never drains
+            uint32_t timeout_ms = mb_transaction_timeout_ms(master, next->slave_id,
+                                                            next->function_code, next->quantity);
+            op->slots[slot].transaction_id = transaction_id;
+            op->slots[slot].plan_index     = op->next_plan;
+            op->slots[slot].deadline_ms    = now_ms + timeout_ms;
+            op->slots[slot].in_flight      = true;
+            op->tx_slot                    = slot;
+            op->tx_pending                 = true;
+            op->tx_offset                  = 0;
+            op->in_flight++;
+            op->next_plan++;
+        }
+
+        mb_async_slot_t *slot         = &op->slots[op->tx_slot];
+        const mb_request_plan_t *plan = &op->plans[slot->plan_index];
+
+        if (op->tx_offset == 0) {
+            MB_TRACE(&master->config, MB_TRACE_SEND_BEGIN, plan->slave_id, plan->function_code,
+                     plan->frame_length, MB_SUCCESS);
+        }
+        int sent = master->config.transport.send(master->config.transport.context,
+                                                 &plan->frame_data[op->tx_offset],
+                                                 (size_t)(plan->frame_length - op->tx_offset));
+        if (sent < 0) {
+            MB_TRACE(&master->config, MB_TRACE_SEND_END, plan->slave_id, plan->function_code,
+                     op->tx_offset, MB_ERROR_TRANSPORT);
+            return MB_ERROR_TRANSPORT;
+        }
+
+        op->tx_offset = (uint16_t)(op->tx_offset + (uint16_t)sent);
+        if (op->tx_offset < plan->frame_length) {
+            return MB_SUCCESS; // Short write: wait for writability
+        }
+
+        // Response time is measured from the end of the request
+        MB_TRACE(&master->config, MB_TRACE_SEND_END, plan->slave_id, plan->function_code,
+                 plan->frame_length, MB_SUCCESS);
+        op->tx_pending    = false;
+        slot->deadline_ms = now_ms + mb_transaction_timeout_ms(master, plan->slave_id,
+                                                               plan->function_code,
+                                                               plan->quantity);
+        master->stats.total_requests++;
+        master->stats.total_chars_sent += plan->frame_length;
+        mb_metrics_record_request(master->config.metrics, plan->slave_id, plan->function_code,
+                                  plan->frame_length);
+        slot->sent_us = metrics_clock(master);
+    }
+}
+
+/**
+ * @brief Scatter a poll response, or verify a write echo
+ */
+static int handle_response(mb_async_op_t *op,
+                           uint16_t plan_index,
+                           uint8_t fc,
+                           const uint8_t *pdu_data,
+                           uint16_t pdu_length) {
+    if (op->poll != NULL) {
+        mb_scatter_ctx_t scatter_ctx;
+        scatter_ctx.plans       = op->plans;
+        scatter_ctx.scatter     = op->poll->scatter;
+        scatter_ctx.data_buffer = op->data_buffer;
+        scatter_ctx.profiles    = op->master->config.profiles;
+        scatter_ctx.learned     = false;
+        scatter_ctx.bits        = NULL;
+        scatter_ctx.typed_tags  = NULL;
+        scatter_ctx.routes      = NULL;
+
+        // The plan in flight stays valid; the next submit re-plans it
+        int result = mb_scatter_plan_response(&scatter_ctx, plan_index, fc, pdu_data, pdu_length);
+        if (scatter_ctx.learned) {
+            op->poll->stale = true;
+        }
+        return result;
+    }
+
+    const mb_request_plan_t *plan = &op->write_plan;
+    bool coil                     = op->write_value != 0;
+    const void *expected          = plan->function_code == MB_FC_WRITE_SINGLE_COIL
+                                        ? (const void *)&coil
+                                        : (const void *)&op->write_value;
+    return mb_parse_write_response(fc, pdu_data, pdu_length, plan->start_address, plan->quantity,
+                                   expected);
+}
+
+/**
+ * @brief Dispatch every complete response in rx
+ * @return 0 on success, negative error code on failure
+ */
+static int async_dispatch(mb_async_op_t *op) {
+    // Serial bytes with nothing outstanding cannot be framed: drop them
+    if (op_mode(op) != MB_MODE_TCP && serial_slot(op) < 0) {
+        op->rx_length = 0;
+        return MB_SUCCESS;
+    }
+
+    for (;;) {
+        int frame_chars = rx_frame_length(op);
+        if (frame_chars < 0) {
+            return frame_chars;
+        }
+        if (frame_chars == 0) {
+            // A full accumulator without a frame boundary never completes
+            return op->rx_length == sizeof(op->rx) ? MB_ERROR_INVALID_FRAME : MB_SUCCESS;
+        }
+
+        uint16_t resp_tid        = 0;
+        uint8_t resp_slave_id    = 0;
+        uint8_t resp_fc          = 0;
+        const uint8_t *resp_pdu  = NULL;
+        uint16_t resp_pdu_length = 0;
+
+        MB_TRACE(&op->master->config, MB_TRACE_RECV_LAST, 0, 0, frame_chars, MB_SUCCESS);
+        MB_TRACE(&op->master->config, MB_TRACE_PARSE_BEGIN, 0, 0, frame_chars, MB_SUCCESS);
+        int result = mb_parse_frame_view(op->rx, (uint16_t)frame_chars, op_mode(op), &resp_tid,
+                                         &resp_slave_id, &resp_fc, &resp_pdu, &resp_pdu_length);
+        MB_TRACE(&op->master->config, MB_TRACE_PARSE_END, resp_slave_id, resp_fc & 0x7F,
+                 frame_chars, result);
+        if (result != MB_SUCCESS) {
+            return result;
+        }
+
+        uint8_t slot = 0;
+        if (op_mode(op) == MB_MODE_TCP) {
+            while (slot < op->window &&
+                   !(op->slots[slot].in_flight && op->slots[slot].transaction_id == resp_tid)) {
+                slot++;
+            }
+        } else {
+            slot = (uint8_t)serial_slot(op);
+        }
+
+        // Stale or unknown transaction (or a response racing our own send): discard
+        if (slot == op->window || (op->tx_pending && slot == op->tx_slot)) {
+            rx_consume(op, (size_t)frame_chars);
+            continue;
+        }
+
+        uint16_t plan_index = op->slots[slot].plan_index;
+        if (resp_slave_id != op->plans[plan_index].slave_id) {
+            metrics_outcome(op, &op->slots[slot], MB_ERROR_INVALID_FRAME, false, 0);
+            return MB_ERROR_INVALID_FRAME;
+        }
+        metrics_outcome(op, &op->slots[slot], MB_SUCCESS, (resp_fc & 0x80) != 0,
+                        (uint32_t)frame_chars);
+
+        // The PDU view points into rx: consume only after handling it
+        const mb_request_plan_t *plan = &op->plans[plan_index];
+        MB_TRACE(&op->master->config, MB_TRACE_SCATTER_BEGIN, plan->slave_id, plan->function_code,
+                 resp_pdu_length, MB_SUCCESS);
+        result = handle_response(op, plan_index, resp_fc, resp_pdu, resp_pdu_length);
+        MB_TRACE(&op->master->config, MB_TRACE_SCATTER_END, plan->slave_id, plan->function_code,
+                 resp_pdu_length, result);
+        rx_consume(op, (size_t)frame_chars);
+        if (result != MB_SUCCESS) {
+            return result;
+        }
+
+        op->slots[slot].in_flight = false;
+        op->in_flight--;
+        op->completed++;
+
+        if (op_mode(op) != MB_MODE_TCP) {
+            op->rx_length = 0; // Nothing may follow a serial response
+            return MB_SUCCESS;
+        }
+    }
+}
+
+/**
+ * @brief Reset op for a new operation on master
+ */
+static int async_prepare(mb_master_t *master,
+                         mb_async_op_t *op,
+                         mb_async_done_fn on_done,
+                         void *ctx) {
+    if (master->config.transport.send == NULL || master->config.transport.recv == NULL) {
+        return MB_ERROR_TRANSPORT;
+    }
+
+    memset(op, 0, offsetof(mb_async_op_t, rx));
+    op->master  = master;
+    op->mode    = master->config.mode;
+    op->on_done = on_done;
+    op->ctx     = ctx;
+    op->window  = 1;
+
+    if (op_mode(op) == MB_MODE_TCP && master->config.max_in_flight > 1) {
+        op->window = master->config.max_in_flight < MB_MAX_IN_FLIGHT
+                         ? master->config.max_in_flight
+                         : MB_MAX_IN_FLIGHT;
+    }
+
+    return MB_SUCCESS;
+}
+
+int mb_master_submit_poll(mb_master_t *master,
+                          mb_async_op_t *op,
+                          mb_poll_plan_t *poll,
+                          uint16_t *data_buffer,
+                          uint16_t buffer_size,
+                          mb_async_done_fn on_done,
+                          void *ctx) {
+    if (master == NULL || op == NULL || poll == NULL || data_buffer == NULL ||
+        poll->plan_count == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    // Frames were built for a specific framing
+    if (poll->mode != master->config.mode) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (buffer_size < poll->address_count) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    int result = async_prepare(master, op, on_done, ctx);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    // Re-plan around what a slave rejected last time (keep the old plan if
+    // that fails)
+    if (poll->stale && mb_poll_plan_refresh(master, poll) == MB_SUCCESS) {
+        poll->stale = false;
+    }
+
+    op->plans       = poll->plans;
+    op->plan_count  = poll->plan_count;
+    op->poll        = poll;
+    op->data_buffer = data_buffer;
+    op->state       = MB_ASYNC_BUSY;
+    return MB_SUCCESS;
+}
+
+/**
+ * @brief Encode a write request into op and arm it
+ * @param quantity Units written (echoed back by FC15/FC16)
+ * @param value Value echoed back by FC05/FC06
+ */
+static int submit_write(mb_master_t *master,
+                        mb_async_op_t *op,
+                        uint8_t slave_id,
+                        uint8_t fc,
+                        const uint8_t *pdu_data,
+                        uint16_t pdu_length,
+                        uint16_t quantity,
+                        uint16_t value,
+                        mb_async_done_fn on_done,
+                        void *ctx) {
+    // A serial broadcast never completes; send it with the blocking write
+    if (mb_transaction_is_broadcast(master, slave_id)) {
+        return MB_ERROR_INVALID_ADDRESS;
+    }
+
+    int result = async_prepare(master, op, on_done, ctx);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    mb_request_plan_t *plan = &op->write_plan;
+    memset(plan, 0, sizeof(*plan));
+    plan->slave_id      = slave_id;
+    plan->function_code = fc;
+    plan->start_address = (uint16_t)(((uint16_t)pdu_data[0] << 8) | pdu_data[1]);
+    plan->quantity      = quantity;
+
+    result = mb_build_frame(slave_id, fc, pdu_data, pdu_length, op_mode(op), 0, op->write_frame,
+                            sizeof(op->write_frame), &plan->frame_length);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    // Every write response echoes address + value/quantity
+    plan->frame_data               = op->write_frame;
+    plan->expected_response_length = mb_calc_frame_length(4, op_mode(op));
+
+    op->write_value = value;
+    op->plans       = plan;
+    op->plan_count  = 1;
+    op->state       = MB_ASYNC_BUSY;
+    return MB_SUCCESS;
+}
+
+int mb_master_submit_write_single_coil(mb_master_t *master,
+                                       mb_async_op_t *op,
+                                       uint8_t slave_id,
+                                       uint16_t addr,
+                                       bool value,
+                                       mb_async_done_fn on_done,
+                                       void *ctx) {
+    if (master == NULL || op == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    uint8_t pdu[4];
+    pdu[0] = (uint8_t)((addr >> 8) & 0xFF);
+    pdu[1] = (uint8_t)(addr & 0xFF);
+    pdu[2] = value ? 0xFF : 0x00; // 0xFF00 for ON, 0x0000 for OFF
+    pdu[3] = 0x00;
+
+    return submit_write(master, op, slave_id, MB_FC_WRITE_SINGLE_COIL, pdu, sizeof(pdu), 1,
+                        value ? 1 : 0, on_done, ctx);
+}
+
+int mb_master_submit_write_single_register(mb_master_t *master,
+                                           mb_async_op_t *op,
+                                           uint8_t slave_id,
+                                           uint16_t addr,
+                                           uint16_t value,
+                                           mb_async_done_fn on_done,
+                                           void *ctx) {
+    if (master == NULL || op == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    uint8_t pdu[4];
+    pdu[0] = (uint8_t)((addr >> 8) & 0xFF);
+    pdu[1] = (uint8_t)(addr & 0xFF);
+    pdu[2] = (uint8_t)((value >> 8) & 0xFF);
+    pdu[3] = (uint8_t)(value & 0xFF);
+
+    return submit_write(master, op, slave_id, MB_FC_WRITE_SINGLE_REGISTER, pdu, sizeof(pdu), 1,
+                        value, on_done, ctx);
+}
+
+int mb_master_submit_write_multiple_registers(mb_master_t *master,
+                                              mb_async_op_t *op,
+                                              uint8_t slave_id,
+                                              uint16_t start_addr,
+                                              uint16_t quantity,
+                                              const uint16_t *values,
+                                              mb_async_done_fn on_done,
+                                              void *ctx) {
+    if (master == NULL || op == NULL || values == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (quantity == 0 || quantity > 123) { // Max 123 registers for FC16
+        return MB_ERROR_INVALID_QUANTITY;
+    }
+
+    uint8_t pdu[MB_MAX_PDU_DATA];
+    uint16_t pdu_length = 0;
+
+    pdu[pdu_length++] = (uint8_t)((start_addr >> 8) & 0xFF);
+    pdu[pdu_length++] = (uint8_t)(start_addr & 0xFF);
+    pdu[pdu_length++] = (uint8_t)((quantity >> 8) & 0xFF);
+    pdu[pdu_length++] = (uint8_t)(quantity & 0xFF);
+    pdu[pdu_length++] = (uint8_t)(quantity * 2);
+
+    for (uint16_t i = 0; i < quantity; i++) {
+        pdu[pdu_length++] = (uint8_t)((values[i] >> 8) & 0xFF);
+        pdu[pdu_length++] = (uint8_t)(values[i] & 0xFF);
+    }
+
+    return submit_write(master, op, slave_id, MB_FC_WRITE_MULTIPLE_REGISTERS, pdu, pdu_length,
+                        quantity, 0, on_done, ctx);
+}
+
+int mb_async_step(mb_async_op_t *op, uint32_t now_ms) {
+    if (op == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (op->state != MB_ASYNC_BUSY) {
+        return op->state == MB_ASYNC_DONE ? op->result : MB_SUCCESS;
+    }
+
+    mb_master_t *master = op->master;
+
+    for (;;) {
+        int result = async_send(op, now_ms);
+        if (result != MB_SUCCESS) {
+            return finish(op, result);
+        }
+
+        size_t received = 0;
+        if (op->in_flight > 0 && op->rx_length < sizeof(op->rx)) {
+            result = master->config.transport.recv(master->config.transport.context,
+                                                   &op->rx[op->rx_length],
+                                                   sizeof(op->rx) - op->rx_length, &received);
+            if (result < 0) {
+                return finish(op, MB_ERROR_TRANSPORT);
+            }
+            if (op->rx_length == 0 && received > 0) {
+                MB_TRACE(&master->config, MB_TRACE_RECV_FIRST, 0, 0, received, MB_SUCCESS);
+            }
+            op->rx_length += received;
+            master->stats.total_chars_recv += (uint32_t)received;
+        }
+
+        uint16_t completed = op->completed;
+        result             = async_dispatch(op);
+        if (result != MB_SUCCESS) {
+            return finish(op, result);
+        }
+
+        if (op->completed == op->plan_count) {
+            return finish(op, MB_SUCCESS);
+        }
+
+        // Transport drained and nothing unblocked: wait for the next event
+        if (received == 0 && op->completed == completed) {
+            break;
+        }
+    }
+
+    for (uint8_t i = 0; i < op->window; i++) {
+        if (op->slots[i].in_flight && deadline_passed(now_ms, op->slots[i].deadline_ms)) {
+            metrics_outcome(op, &op->slots[i], MB_ERROR_TIMEOUT, false, 0);
+            return finish(op, MB_ERROR_TIMEOUT);
+        }
+    }
+
+    return MB_SUCCESS;
+}
+
+unsigned mb_async_interest(const mb_async_op_t *op) {
+    if (op == NULL || op->state != MB_ASYNC_BUSY) {
+        return 0;
+    }
+
+    unsigned interest = 0;
+    if (op->tx_pending || (op->in_flight < op->window && op->next_plan < op->plan_count)) {
+        interest |= MB_ASYNC_WANT_WRITE;
+    }
+    if (op->in_flight > (op->tx_pending ? 1 : 0)) {
+        interest |= MB_ASYNC_WANT_READ;
+    }
+    return interest;
+}
+
+bool mb_async_next_deadline(const mb_async_op_t *op, uint32_t *deadline_ms) {
+    if (op == NULL || deadline_ms == NULL || op->state != MB_ASYNC_BUSY) {
+        return false;
+    }
+
+    bool found = false;
+    for (uint8_t i = 0; i < op->window; i++) {
+        if (!op->slots[i].in_flight) {
+            continue;
+        }
+        if (!found || deadline_passed(*deadline_ms, op->slots[i].deadline_ms)) {
+            *deadline_ms = op->slots[i].deadline_ms;
+            found        = true;
+        }
+    }
+    return found;
+}
+
+void mb_async_cancel(mb_async_op_t *op) {
+    if (op == NULL) {
+        return;
+    }
+
+    op->state      = MB_ASYNC_IDLE;
+    op->in_flight  = 0;
+    op->tx_pending = false;
+    op->rx_length  = 0;
+    memset(op->slots, 0, sizeof(op->slots));
+}
@@ -0,0 +1,306 @@
+/**
+ * @file bus_scheduler.c
+ * @brief Rate-monotonic bus scheduler implementation
+ *
+ * Scheduling is non-preemptive at request granularity: once a request is on
+ * the line it runs to completion. Each call to mb_bus_poll() updates the
+ * releases, then walks the groups in priority order and dispatches the
+ * first ready request that ends before the next release of every faster
+ * group. A job about to miss its deadline (remaining cost plus one job of
+ * every faster group exceeds the time left) preempts that order.
+ */
+
+#include "smartmodbus/mb_bus.h"
+#include "smartmodbus/mb_error.h"
+#include "smartmodbus/smartmodbus.h"
+#include "response_parser.h"
+#include "transaction.h"
+#include "../core/char_model.h"
+
+#include <string.h>
+
+// Characters on the line: start + 8 data + parity + stop / start + 7 + parity + stop
+#define BUS_RTU_CHAR_BITS   11u
+#define BUS_ASCII_CHAR_BITS 10u
+
+// Liu & Layland bound n(2^(1/n) - 1) in permille; tends to ln 2 for large n
+static const uint16_t rm_bound_permille[] = {1000, 828, 779, 756, 743, 734, 728, 724, 720, 717};
+#define BUS_RM_BOUND_LIMIT 693u
+
+static uint32_t plan_cost_us(const mb_bus_t *bus, const mb_request_plan_t *plan) {
+    mb_block_t block;
+    memset(&block, 0, sizeof(block));
+    block.slave_id      = plan->slave_id;
+    block.function_code = plan->function_code;
+    block.start_address = plan->start_address;
+    block.quantity      = plan->quantity;
+
+    const mb_config_t *config = &bus->master->config;
+    uint8_t latency = mb_profile_latency_chars(config->profiles, plan->slave_id,
+                                               config->latency_chars);
+
+    uint16_t chars = mb_calc_request_cost(&block, config->mode, config->gap_chars, latency);
+    return chars * bus->char_us;
+}
+
+static uint32_t poll_cost_us(const mb_bus_t *bus, const mb_poll_plan_t *poll) {
+    uint32_t cost = 0;
+    for (uint16_t i = 0; i < poll->plan_count; i++) {
+        cost += plan_cost_us(bus, &poll->plans[i]);
+    }
+    return cost;
+}
+
+/**
+ * @brief Release a new job, re-planning a plan a slave rejected
+ */
+static void start_job(const mb_bus_t *bus, mb_bus_group_t *group) {
+    mb_poll_plan_t *poll = group->poll;
+    if (poll->stale && mb_poll_plan_refresh(bus->master, poll) == MB_SUCCESS) {
+        poll->stale    = false;
+        group->cost_us = poll_cost_us(bus, poll);
+    }
+    group->next_plan = 0;
+}
+
+static uint32_t us_to_ms(uint32_t us) {
+    return (us + 999u) / 1000u;
+}
+
+int mb_bus_init(mb_bus_t *bus,
+                mb_master_t *master,
+                mb_bus_group_t *groups,
+                uint16_t capacity,
+                uint32_t baud_rate) {
+    if (bus == NULL || master == NULL || (groups == NULL && capacity > 0) || baud_rate == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    uint32_t bits;
+    // RTU-over-TCP: the line behind the terminal server is still serial
+    if (master->config.mode == MB_MODE_RTU || master->config.mode == MB_MODE_RTU_OVER_TCP) {
+        bits = BUS_RTU_CHAR_BITS;
+    } else if (master->config.mode == MB_MODE_ASCII) {
+        bits = BUS_ASCII_CHAR_BITS;
+    } else {
+        // TCP devices are not on a shared line; use mb_scheduler.h
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    memset(bus, 0, sizeof(*bus));
+    bus->master         = master;
+    bus->groups         = groups;
+    bus->group_capacity = capacity;
+    bus->char_us        = (uint32_t)(((uint64_t)bits * 1000000u + baud_rate - 1u) / baud_rate);
+    return MB_SUCCESS;
+}
+
+int mb_bus_add_group(mb_bus_t *bus,
+                     mb_poll_plan_t *poll,
+                     uint16_t *data_buffer,
+                     uint16_t buffer_size,
+                     uint32_t period_ms) {
+    if (bus == NULL || poll == NULL || data_buffer == NULL || poll->plan_count == 0 ||
+        period_ms == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (poll->mode != bus->master->config.mode) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (buffer_size < poll->address_count) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    if (bus->group_count >= bus->group_capacity) {
+        return MB_ERROR_TOO_MANY_BLOCKS;
+    }
+
+    // Rate-monotonic priority: insert behind every group with period <= ours
+    uint16_t index = bus->group_count;
+    while (index > 0 && bus->groups[index - 1].period_ms > period_ms) {
+        bus->groups[index] = bus->groups[index - 1];
+        index--;
+    }
+
+    mb_bus_group_t *group = &bus->groups[index];
+    memset(group, 0, sizeof(*group));
+    group->poll        = poll;
+    group->data_buffer = data_buffer;
+    group->buffer_size = buffer_size;
+    group->period_ms   = period_ms;
+    group->next_plan   = poll->plan_count;
+    group->cost_us     = poll_cost_us(bus, poll);
+
+    bus->group_count++;
+    return index;
+}
+
+int mb_bus_analyze(const mb_bus_t *bus, mb_bus_load_t *load) {
+    if (bus == NULL || load == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    memset(load, 0, sizeof(*load));
+    uint32_t shortest_period = UINT32_MAX;
+
+    for (uint16_t i = 0; i < bus->group_count; i++) {
+        const mb_bus_group_t *group = &bus->groups[i];
+
+        // cost_us / period_ms is the utilization in permille; round up
+        load->utilization_permille += (group->cost_us + group->period_ms - 1u) / group->period_ms;
+
+        for (uint16_t p = 0; p < group->poll->plan_count; p++) {
+            uint32_t cost = plan_cost_us(bus, &group->poll->plans[p]);
+            if (cost > load->max_request_us) {
+                load->max_request_us = cost;
+            }
+        }
+        if (group->period_ms < shortest_period) {
+            shortest_period = group->period_ms;
+        }
+    }
+
+    uint16_t bound_count = (uint16_t)(sizeof(rm_bound_permille) / sizeof(rm_bound_permille[0]));
+    if (bus->group_count == 0) {
+        load->bound_permille = rm_bound_permille[0];
+    } else if (bus->group_count <= bound_count) {
+        load->bound_permille = rm_bound_permille[bus->group_count - 1];
+    } else {
+        load->bound_permille = BUS_RM_BOUND_LIMIT;
+    }
+
+    if (load->utilization_permille > 1000u) {
+        load->verdict = MB_BUS_OVERSUBSCRIBED;
+    } else if (load->utilization_permille > load->bound_permille ||
+               (bus->group_count > 0 && us_to_ms(load->max_request_us) > shortest_period)) {
+        // A request longer than the fastest period blocks it on its own
+        load->verdict = MB_BUS_AT_RISK;
+    } else {
+        load->verdict = MB_BUS_SCHEDULABLE;
+    }
+
+    return MB_SUCCESS;
+}
+
+void mb_bus_start(mb_bus_t *bus, uint32_t now_ms) {
+    if (bus == NULL) {
+        return;
+    }
+
+    for (uint16_t i = 0; i < bus->group_count; i++) {
+        bus->groups[i].release_ms = now_ms;
+        start_job(bus, &bus->groups[i]);
+    }
+}
+
+/**
+ * @brief Move a group's release forward to the period containing now
+ */
+static void update_release(const mb_bus_t *bus, mb_bus_group_t *group, uint32_t now_ms) {
+    uint32_t elapsed = now_ms - group->release_ms;
+    if ((int32_t)elapsed < 0 || elapsed < group->period_ms) {
+        return;
+    }
+
+    if (group->next_plan < group->poll->plan_count) {
+        // Still running: keep going, the missed release merges into this job
+        group->overruns++;
+    } else {
+        start_job(bus, group);
+    }
+    group->release_ms += (elapsed / group->period_ms) * group->period_ms;
+}
+
+static int execute_next(mb_bus_t *bus, mb_bus_group_t *group) {
+    mb_poll_plan_t *poll = group->poll;
+    uint16_t index       = group->next_plan;
+
+    mb_scatter_ctx_t scatter_ctx;
+    scatter_ctx.plans       = &poll->plans[index];
+    scatter_ctx.scatter     = poll->scatter;
+    scatter_ctx.data_buffer = group->data_buffer;
+    scatter_ctx.profiles    = bus->master->config.profiles;
+    scatter_ctx.learned     = false;
+    scatter_ctx.bits        = NULL;
+    scatter_ctx.typed_tags  = NULL;
+    scatter_ctx.routes      = NULL;
+
+    int result = mb_transaction_execute_plans(bus->master, &poll->plans[index], 1,
+                                              mb_scatter_plan_response, &scatter_ctx);
+    group->last_result = result;
+    if (result != MB_SUCCESS) {
+        group->errors++;
+    }
+    if (scatter_ctx.learned) {
+        poll->stale = true;  // Re-planned when the next job is released
+    }
+
+    group->next_plan++;
+    if (group->next_plan == poll->plan_count) {
+        group->completed++;
+    }
+    return result;
+}
+
+int mb_bus_poll(mb_bus_t *bus, uint32_t now_ms, uint32_t *wait_ms) {
+    if (bus == NULL || wait_ms == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    // Deadline pass: a job whose slack no longer covers one job of every
+    // faster group goes first, earliest deadline wins
+    mb_bus_group_t *urgent   = NULL;
+    uint32_t urgent_deadline = UINT32_MAX;
+    uint32_t interference_us = 0;
+
+    for (uint16_t i = 0; i < bus->group_count; i++) {
+        mb_bus_group_t *group = &bus->groups[i];
+        update_release(bus, group, now_ms);
+
+        if (group->next_plan < group->poll->plan_count) {
+            uint32_t remaining_us = interference_us;
+            for (uint16_t p = group->next_plan; p < group->poll->plan_count; p++) {
+                remaining_us += plan_cost_us(bus, &group->poll->plans[p]);
+            }
+
+            uint32_t deadline = group->release_ms + group->period_ms - now_ms;
+            if (us_to_ms(remaining_us) >= deadline && deadline < urgent_deadline) {
+                urgent          = group;
+                urgent_deadline = deadline;
+            }
+        }
+        interference_us += group->cost_us;
+    }
+
+    if (urgent != NULL) {
+        *wait_ms = 0;
+        return execute_next(bus, urgent);
+    }
+
+    // Rate-monotonic pass with gap packing; horizon is the time until the
+    // earliest release of a faster group
+    uint32_t horizon = UINT32_MAX;
+
+    for (uint16_t i = 0; i < bus->group_count; i++) {
+        mb_bus_group_t *group = &bus->groups[i];
+
+        if (group->next_plan >= group->poll->plan_count) {
+            uint32_t next = group->release_ms + group->period_ms - now_ms;
+            if (next < horizon) {
+                horizon = next;
+            }
+            continue;
+        }
+
+        uint32_t cost = us_to_ms(plan_cost_us(bus, &group->poll->plans[group->next_plan]));
+        if (cost <= horizon) {
+            *wait_ms = 0;
+            return execute_next(bus, group);
+        }
+    }
+
+    *wait_ms = horizon;
+    return MB_SUCCESS;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file change_set.c
+ * @brief Report-by-exception change detection implementation
+ *
+ * Reported tags are [0, primed) and compared against their last value;
+ * tags from primed on have never been reported and are listed as they
+ * are. Both regions are walked in tag order, so a detection cut short by
+ * a full change list resumes where it stopped.
+ */
+
+#include "smartmodbus/mb_change.h"
+#include "smartmodbus/mb_error.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+// Registers compared per step of the unchanged-run skip
+#define CHANGE_STRIDE 16
+
+static inline uint64_t load64(const uint16_t *values) {
+    uint64_t word;
+    memcpy(&word, values, sizeof(word));
+    return word;
+}
+
+/**
+ * @brief Whether 16 consecutive values all equal their last reported ones
+ */
+static inline bool stride_equal(const uint16_t *values, const uint16_t *last) {
+    uint64_t diff = 0;
+    for (uint16_t k = 0; k < CHANGE_STRIDE; k += 4) {
+        diff |= load64(&values[k]) ^ load64(&last[k]);
+    }
+    return diff == 0;
+}
+
+/**
+ * @brief Distance between two register values modulo 2^16
+ */
+static inline uint16_t distance(uint16_t a, uint16_t b) {
+    uint16_t d = (uint16_t)(a - b);
+    return d > 0x8000u ? (uint16_t)(0u - d) : d;
+}
+
+static void fill_change(const mb_change_set_t *set,
+                        uint16_t index,
+                        uint16_t value,
+                        uint16_t previous,
+                        mb_change_t *change) {
+    if (set->tags != NULL) {
+        change->slave_id      = set->tags[index].slave_id;
+        change->function_code = set->tags[index].function_code;
+        change->address       = set->tags[index].address;
+    } else {
+        change->slave_id      = set->request->slave_id;
+        change->function_code = set->request->function_code;
+        change->address       = set->request->addresses[index];
+    }
+    change->index    = index;
+    change->value    = value;
+    change->previous = previous;
+}
+
+int mb_change_set_init(mb_change_set_t *set,
+                       const mb_read_request_t *request,
+                       uint16_t *last,
+                       const uint16_t *deadband) {
+    if (set == NULL || request == NULL ||
+        (request->address_count > 0 && (request->addresses == NULL || last == NULL))) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    set->request  = request;
+    set->tags     = NULL;
+    set->last     = last;
+    set->deadband = deadband;
+    set->count    = request->address_count;
+    set->primed   = 0;
+    return MB_SUCCESS;
+}
+
+int mb_change_set_init_tags(mb_change_set_t *set,
+                            const mb_tag_t *tags,
+                            uint16_t tag_count,
+                            uint16_t *last,
+                            const uint16_t *deadband) {
+    if (set == NULL || (tag_count > 0 && (tags == NULL || last == NULL))) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    set->request  = NULL;
+    set->tags     = tags;
+    set->last     = last;
+    set->deadband = deadband;
+    set->count    = tag_count;
+    set->primed   = 0;
+    return MB_SUCCESS;
+}
+
+void mb_change_set_reset(mb_change_set_t *set) {
+    if (set != NULL) {
+        set->primed = 0;
+    }
+}
+
+int mb_change_set_detect(mb_change_set_t *set,
+                         const uint16_t *values,
+                         mb_change_t *changes,
+                         uint16_t max_changes,
+                         uint16_t *change_count) {
+    if (set == NULL || change_count == NULL || (set->count > 0 && values == NULL) ||
+        (changes == NULL && max_changes > 0)) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    uint16_t *last           = set->last;
+    const uint16_t *deadband = set->deadband;
+    uint16_t n               = 0;
+    uint16_t i               = 0;
+
+    *change_count = 0;
+
+    while (i < set->primed) {
+        if (set->primed - i >= CHANGE_STRIDE && stride_equal(&values[i], &last[i])) {
+            i = (uint16_t)(i + CHANGE_STRIDE);
+            continue;
+        }
+
+        uint16_t end = set->primed - i >= CHANGE_STRIDE ? (uint16_t)(i + CHANGE_STRIDE)
+                                                        : set->primed;
+        for (; i < end; i++) {
+            if (values[i] == last[i]) {
+                continue;
+            }
+            if (deadband != NULL && distance(values[i], last[i]) <= deadband[i]) {
+                continue;
+            }
+            if (n == max_changes) {
+                *change_count = n;
+                return MB_ERROR_BUFFER_TOO_SMALL;
+            }
+
+            fill_change(set, i, values[i], last[i], &changes[n++]);
+            last[i] = values[i];
+        }
+    }
+
+    // Never reported: list unconditionally
+    for (; i < set->count; i++) {
+        if (n == max_changes) {
+            *change_count = n;
+            return MB_ERROR_BUFFER_TOO_SMALL;
+        }
+
+        fill_change(set, i, values[i], 0, &changes[n++]);
+        last[i]     = values[i];
+        set->primed = (uint16_t)(i + 1);
+    }
+
+    *change_count = n;
+    return MB_SUCCESS;
+}
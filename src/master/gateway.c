@@ -0,0 +1,398 @@
+/**
+ * @file gateway.c
+ * @brief Modbus TCP to serial gateway with cross-client read merging
+ */
+
+#include "smartmodbus/mb_gateway.h"
+#include "smartmodbus/mb_error.h"
+#include "smartmodbus/smartmodbus.h"
+#include "transaction.h"
+
+#include <string.h>
+
+/**
+ * @brief MBAP header: transaction ID, protocol ID, length, unit ID
+ */
+#define MBAP_HEADER_CHARS 7
+
+static bool is_bit_read(uint8_t fc) {
+    return fc == MB_FC_READ_COILS || fc == MB_FC_READ_DISCRETE_INPUTS;
+}
+
+static bool is_read(uint8_t fc) {
+    return is_bit_read(fc) || fc == MB_FC_READ_HOLDING_REGISTERS ||
+           fc == MB_FC_READ_INPUT_REGISTERS;
+}
+
+/**
+ * @brief Quantity of a well-formed FC01-FC04 request, or 0
+ *
+ * Malformed reads are not merged: forwarding them lets the slave answer
+ * them as it would without a gateway.
+ */
+static uint16_t read_quantity(const mb_gateway_request_t *request) {
+    if (!is_read(request->function_code) || request->pdu_length != 4) {
+        return 0;
+    }
+
+    uint16_t start    = (uint16_t)((request->pdu[0] << 8) | request->pdu[1]);
+    uint16_t quantity = (uint16_t)((request->pdu[2] << 8) | request->pdu[3]);
+    uint16_t limit    = is_bit_read(request->function_code) ? 2000 : 125;
+    if (quantity == 0 || quantity > limit || (uint32_t)start + quantity > 0x10000u) {
+        return 0;
+    }
+    return quantity;
+}
+
+static mb_gateway_request_t *queue_at(mb_gateway_port_t *port, uint16_t index) {
+    return &port->queue[(port->head + index) % port->capacity];
+}
+
+/**
+ * @brief Frame pdu as an MBAP response and send it to the request's client
+ */
+static int respond(mb_gateway_t *gateway,
+                   const mb_gateway_request_t *request,
+                   uint8_t fc,
+                   const uint8_t *pdu,
+                   uint16_t pdu_length) {
+    if (request->client >= gateway->config.client_count ||
+        !gateway->config.clients[request->client].open) {
+        return MB_SUCCESS;
+    }
+
+    uint8_t frame[MBAP_HEADER_CHARS + 1 + MB_GATEWAY_MAX_PDU];
+    uint16_t length = (uint16_t)(1 + 1 + pdu_length);
+
+    frame[0] = (uint8_t)(request->transaction_id >> 8);
+    frame[1] = (uint8_t)(request->transaction_id & 0xFF);
+    frame[2] = 0;
+    frame[3] = 0;
+    frame[4] = (uint8_t)(length >> 8);
+    frame[5] = (uint8_t)(length & 0xFF);
+    frame[6] = request->unit_id;
+    frame[7] = fc;
+    if (pdu_length > 0) {
+        memcpy(&frame[MBAP_HEADER_CHARS + 1], pdu, pdu_length);
+    }
+
+    gateway->stats.responses++;
+    int sent = gateway->config.send(gateway->config.context, request->client, frame,
+                                    (size_t)(MBAP_HEADER_CHARS + length - 1));
+    return sent < 0 ? sent : MB_SUCCESS;
+}
+
+static int respond_exception(mb_gateway_t *gateway,
+                             const mb_gateway_request_t *request,
+                             uint8_t exception) {
+    gateway->stats.exceptions++;
+    return respond(gateway, request, (uint8_t)(request->function_code | 0x80), &exception, 1);
+}
+
+/**
+ * @brief Forward one request unchanged and relay the slave's answer
+ */
+static int forward(mb_gateway_t *gateway,
+                   mb_master_t *master,
+                   const mb_gateway_request_t *request) {
+    uint8_t resp_fc = 0;
+    uint8_t resp_pdu[MB_MAX_PDU_DATA];
+    uint16_t resp_length = 0;
+
+    int result = mb_transaction_execute(master, request->unit_id, request->function_code,
+                                        request->pdu, request->pdu_length, &resp_fc, resp_pdu,
+                                        &resp_length);
+    if (result != MB_SUCCESS) {
+        return respond_exception(gateway, request, MB_EX_GATEWAY_TARGET_FAILED);
+    }
+    return respond(gateway, request, resp_fc, resp_pdu, resp_length);
+}
+
+/**
+ * @brief Answer one read of a merged batch from the shared values
+ */
+static int respond_slice(mb_gateway_t *gateway,
+                         const mb_gateway_request_t *request,
+                         const uint16_t *values,
+                         uint16_t quantity) {
+    uint8_t pdu[MB_GATEWAY_MAX_PDU];
+    uint16_t length = 1;
+
+    if (is_bit_read(request->function_code)) {
+        uint16_t bytes = (uint16_t)((quantity + 7) / 8);
+        memset(&pdu[1], 0, bytes);
+        for (uint16_t i = 0; i < quantity; i++) {
+            if (values[i] != 0) {
+                pdu[1 + i / 8] |= (uint8_t)(1u << (i % 8));
+            }
+        }
+        length = (uint16_t)(length + bytes);
+    } else {
+        for (uint16_t i = 0; i < quantity; i++) {
+            pdu[length++] = (uint8_t)(values[i] >> 8);
+            pdu[length++] = (uint8_t)(values[i] & 0xFF);
+        }
+    }
+    pdu[0] = (uint8_t)(length - 1);
+
+    gateway->stats.merged_requests++;
+    return respond(gateway, request, request->function_code, pdu, length);
+}
+
+/**
+ * @brief Execute the first `count` queued reads as one optimized batch
+ */
+static int service_batch(mb_gateway_t *gateway, mb_gateway_port_t *port, uint16_t count) {
+    mb_tag_t *tags     = gateway->config.tags;
+    uint16_t tag_count = 0;
+
+    for (uint16_t r = 0; r < count; r++) {
+        const mb_gateway_request_t *request = queue_at(port, r);
+        uint16_t start    = (uint16_t)((request->pdu[0] << 8) | request->pdu[1]);
+        uint16_t quantity = read_quantity(request);
+        for (uint16_t i = 0; i < quantity; i++) {
+            tags[tag_count].slave_id      = request->unit_id;
+            tags[tag_count].function_code = request->function_code;
+            tags[tag_count].address       = (uint16_t)(start + i);
+            tag_count++;
+        }
+    }
+
+    gateway->stats.batches++;
+    int result = mb_master_read_batch(port->master, tags, tag_count, gateway->config.values,
+                                      tag_count);
+
+    // Someone's request failed: find out whose, and give each its own answer
+    if (result != MB_SUCCESS) {
+        gateway->stats.fallbacks++;
+        for (uint16_t r = 0; r < count; r++) {
+            result = forward(gateway, port->master, queue_at(port, r));
+            if (result != MB_SUCCESS) {
+                return result;
+            }
+        }
+        return MB_SUCCESS;
+    }
+
+    const uint16_t *values = gateway->config.values;
+    for (uint16_t r = 0; r < count; r++) {
+        const mb_gateway_request_t *request = queue_at(port, r);
+        uint16_t quantity                   = read_quantity(request);
+        result = respond_slice(gateway, request, values, quantity);
+        if (result != MB_SUCCESS) {
+            return result;
+        }
+        values += quantity;
+    }
+    return MB_SUCCESS;
+}
+
+/**
+ * @brief Reads at the head of the queue that fit one batch
+ */
+static uint16_t batch_length(const mb_gateway_t *gateway, mb_gateway_port_t *port) {
+    uint32_t capacity = gateway->config.work_capacity;
+#ifdef MB_USE_STATIC_MEMORY
+    // mb_master_read_batch() plans at most MB_MAX_SCATTER tags
+    if (capacity > MB_MAX_SCATTER) {
+        capacity = MB_MAX_SCATTER;
+    }
+#endif
+
+    uint32_t tags  = 0;
+    uint16_t count = 0;
+    while (count < port->count) {
+        uint16_t quantity = read_quantity(queue_at(port, count));
+        if (quantity == 0 || tags + quantity > capacity) {
+            break;
+        }
+        tags += quantity;
+        count++;
+    }
+    return count;
+}
+
+int mb_gateway_port_init(mb_gateway_port_t *port,
+                         mb_master_t *master,
+                         uint8_t first_unit,
+                         uint8_t last_unit,
+                         mb_gateway_request_t *queue,
+                         uint16_t capacity) {
+    if (port == NULL || master == NULL || queue == NULL || capacity == 0 ||
+        first_unit > last_unit) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    memset(port, 0, sizeof(*port));
+    port->master     = master;
+    port->first_unit = first_unit;
+    port->last_unit  = last_unit;
+    port->queue      = queue;
+    port->capacity   = capacity;
+    return MB_SUCCESS;
+}
+
+int mb_gateway_init(mb_gateway_t *gateway, const mb_gateway_config_t *config) {
+    if (gateway == NULL || config == NULL || config->ports == NULL || config->port_count == 0 ||
+        config->clients == NULL || config->client_count == 0 || config->send == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (config->work_capacity > 0 && (config->tags == NULL || config->values == NULL)) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    memset(gateway, 0, sizeof(*gateway));
+    gateway->config = *config;
+    memset(config->clients, 0, config->client_count * sizeof(mb_gateway_client_t));
+    return MB_SUCCESS;
+}
+
+int mb_gateway_client_open(mb_gateway_t *gateway, uint16_t client) {
+    if (gateway == NULL || client >= gateway->config.client_count) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    mb_gateway_client_t *slot = &gateway->config.clients[client];
+    slot->rx_length           = 0;
+    slot->open                = true;
+    return MB_SUCCESS;
+}
+
+void mb_gateway_client_close(mb_gateway_t *gateway, uint16_t client) {
+    if (gateway == NULL || client >= gateway->config.client_count) {
+        return;
+    }
+
+    gateway->config.clients[client].open      = false;
+    gateway->config.clients[client].rx_length = 0;
+
+    // Compact every queue in place, keeping the order of the others
+    for (uint16_t p = 0; p < gateway->config.port_count; p++) {
+        mb_gateway_port_t *port = &gateway->config.ports[p];
+        uint16_t kept           = 0;
+        for (uint16_t i = 0; i < port->count; i++) {
+            mb_gateway_request_t *request = queue_at(port, i);
+            if (request->client != client) {
+                if (kept != i) {
+                    *queue_at(port, kept) = *request;
+                }
+                kept++;
+            }
+        }
+        port->count = kept;
+    }
+}
+
+/**
+ * @brief Route a complete request to its port's queue
+ */
+static int take_request(mb_gateway_t *gateway, uint16_t client, const uint8_t *adu) {
+    mb_gateway_request_t request;
+    request.client         = client;
+    request.transaction_id = (uint16_t)((adu[0] << 8) | adu[1]);
+    request.unit_id        = adu[6];
+    request.function_code  = adu[7];
+    request.pdu_length     = (uint16_t)((((uint16_t)adu[4] << 8) | adu[5]) - 2);
+    memcpy(request.pdu, &adu[MBAP_HEADER_CHARS + 1], request.pdu_length);
+    gateway->stats.requests++;
+
+    for (uint16_t p = 0; p < gateway->config.port_count; p++) {
+        mb_gateway_port_t *port = &gateway->config.ports[p];
+        if (request.unit_id < port->first_unit || request.unit_id > port->last_unit) {
+            continue;
+        }
+        if (port->count == port->capacity) {
+            return respond_exception(gateway, &request, MB_EX_SLAVE_DEVICE_BUSY);
+        }
+        *queue_at(port, port->count) = request;
+        port->count++;
+        return MB_SUCCESS;
+    }
+
+    return respond_exception(gateway, &request, MB_EX_GATEWAY_PATH_UNAVAILABLE);
+}
+
+int mb_gateway_feed(mb_gateway_t *gateway, uint16_t client, const uint8_t *data, size_t len) {
+    if (gateway == NULL || client >= gateway->config.client_count || (data == NULL && len > 0)) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    mb_gateway_client_t *slot = &gateway->config.clients[client];
+    if (!slot->open) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    int taken = 0;
+    while (len > 0) {
+        size_t chunk = sizeof(slot->rx) - slot->rx_length;
+        chunk        = chunk < len ? chunk : len;
+        memcpy(&slot->rx[slot->rx_length], data, chunk);
+        slot->rx_length = (uint16_t)(slot->rx_length + chunk);
+        data += chunk;
+        len -= chunk;
+
+        // Every complete request in the buffer
+        while (slot->rx_length >= MBAP_HEADER_CHARS + 1) {
+            uint16_t protocol = (uint16_t)((slot->rx[2] << 8) | slot->rx[3]);
+            uint16_t length   = (uint16_t)((slot->rx[4] << 8) | slot->rx[5]);
+            if (protocol != 0 || length < 2 || length > MB_GATEWAY_MAX_ADU - 6) {
+                slot->rx_length = 0;
+                return MB_ERROR_INVALID_FRAME;
+            }
+
+            uint16_t frame_chars = (uint16_t)(6 + length);
+            if (slot->rx_length < frame_chars) {
+                break;
+            }
+
+            int result = take_request(gateway, client, slot->rx);
+            if (result != MB_SUCCESS) {
+                return result;
+            }
+            taken++;
+
+            slot->rx_length = (uint16_t)(slot->rx_length - frame_chars);
+            memmove(slot->rx, &slot->rx[frame_chars], slot->rx_length);
+        }
+    }
+
+    return taken;
+}
+
+int mb_gateway_service(mb_gateway_t *gateway, uint16_t port_index) {
+    if (gateway == NULL || port_index >= gateway->config.port_count) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    mb_gateway_port_t *port = &gateway->config.ports[port_index];
+    uint32_t before         = gateway->stats.responses;
+
+    while (port->count > 0) {
+        uint16_t count = batch_length(gateway, port);
+        int result;
+
+        // A lone read gains nothing from planning: forward it as is
+        if (count > 1) {
+            result = service_batch(gateway, port, count);
+        } else {
+            count  = 1;
+            result = forward(gateway, port->master, queue_at(port, 0));
+        }
+
+        port->head  = (uint16_t)((port->head + count) % port->capacity);
+        port->count = (uint16_t)(port->count - count);
+        if (result != MB_SUCCESS) {
+            return result;
+        }
+    }
+
+    return (int)(gateway->stats.responses - before);
+}
+
+uint16_t mb_gateway_pending(const mb_gateway_t *gateway, uint16_t port_index) {
+    if (gateway == NULL || port_index >= gateway->config.port_count) {
+        return 0;
+    }
+    return gateway->config.ports[port_index].count;
+}
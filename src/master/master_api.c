@@ -9,7 +9,10 @@
 #include "smartmodbus/mb_error.h"
 #include "request_optimizer.h"
 #include "response_parser.h"
-#include "../protocol/frame_builder.h"
+#include "trace.h"
+#include "transaction.h"
+#include "../utils/reg_codec.h"
+#include "../utils/scratch.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -54,6 +57,10 @@ const char *mb_error_to_string(mb_error_t error) {
         return "Too many plans";
     case MB_ERROR_NO_MEMORY:
         return "No memory";
+    case MB_ERROR_PARTIAL_RESULT:
+        return "Partial result";
+    case MB_ERROR_SLAVE_OFFLINE:
+        return "Slave offline";
     default:
         return "Unknown error";
     }
@@ -66,16 +73,23 @@ mb_config_t mb_config_default(mb_mode_t mode) {
     config.mode          = mode;
     config.max_pdu_chars = 253; // Standard Modbus PDU limit
     config.timeout_ms    = 1000;
+    config.max_in_flight = 1;   // Stop-and-wait unless the slave accepts pipelining
+    config.planner       = MB_PLANNER_GREEDY;
 
     // Set gap and latency based on mode
     if (mode == MB_MODE_RTU || mode == MB_MODE_ASCII) {
         config.gap_chars     = 4; // 3.5 chars rounded up
         config.latency_chars = 2; // Default latency
     } else {
-        config.gap_chars     = 0; // TCP has no gap
+        config.gap_chars     = 0; // No gap on a socket (TCP, RTU-over-TCP)
         config.latency_chars = 1; // Lower latency for TCP
     }
 
+    // Broadcast turnaround: 100 ms at 19200 baud, the serial line default
+    if (mode != MB_MODE_TCP) {
+        config.turnaround_chars = 175;
+    }
+
     return config;
 }
 
@@ -84,413 +98,789 @@ int mb_master_init(mb_master_t *master, const mb_config_t *config) {
         return MB_ERROR_INVALID_PARAM;
     }
 
+#ifdef MB_FIXED_MODE
+    // Single-mode build: the other protocols are not compiled in
+    if (config->mode != MB_FIXED_MODE) {
+        return MB_ERROR_NOT_SUPPORTED;
+    }
+#endif
+
     // Copy configuration
     memcpy(&master->config, config, sizeof(mb_config_t));
 
     // Initialize transaction ID for TCP
     master->transaction_id = 0;
+    master->preempting     = false;
 
     // Reset statistics
     memset(&master->stats, 0, sizeof(mb_stats_t));
 
-#ifdef MB_USE_STATIC_MEMORY
-    // Initialize static memory pools
-    master->block_pool_used = 0;
-    master->pdu_pool_used   = 0;
-    master->plan_pool_used  = 0;
-#endif
+    // No scratch arena until one is attached
+    mb_scratch_init(&master->scratch, NULL, 0);
 
     return MB_SUCCESS;
 }
 
-int mb_master_read_optimized(mb_master_t *master,
-                              const mb_read_request_t *request,
-                              uint16_t *data_buffer,
-                              uint16_t buffer_size) {
-    if (master == NULL || request == NULL || data_buffer == NULL) {
+size_t mb_scratch_size(uint16_t address_count) {
+    size_t n = address_count;
+
+    // The batch path dominates: plans and scatter map plus the batch optimizer
+    return n * sizeof(mb_request_plan_t) + n * sizeof(mb_scatter_entry_t) + MB_SCRATCH_SLACK(2) +
+           mb_optimize_batch_scratch_size(address_count);
+}
+
+int mb_master_set_scratch(mb_master_t *master, void *buffer, size_t size) {
+    if (master == NULL || (buffer == NULL && size > 0)) {
         return MB_ERROR_INVALID_PARAM;
     }
 
-    if (buffer_size < request->address_count) {
-        return MB_ERROR_BUFFER_TOO_SMALL;
-    }
+    mb_scratch_init(&master->scratch, buffer, size);
+    return MB_SUCCESS;
+}
 
-    // Step 1: Optimize request into plans
-    mb_request_plan_t plans[16];  // Max 16 plans
-    uint16_t plan_count = 0;
+/**
+ * @brief Scatter of one window, remembering which plans were answered
+ */
+typedef struct {
+    mb_scatter_ctx_t *scatter_ctx; /**< Plans, scatter map and output */
+    bool *answered;                /**< Per plan of scatter_ctx->plans */
+    uint8_t *quality;              /**< Per request address (optional) */
+} read_tracker_t;
+
+static bool is_retryable(int result) {
+    return result == MB_ERROR_TIMEOUT || result == MB_ERROR_CRC_MISMATCH ||
+           result == MB_ERROR_LRC_MISMATCH || result == MB_ERROR_INVALID_FRAME ||
+           result == MB_ERROR_TRANSPORT;
+}
 
-    int result = mb_optimize_request(request, &master->config, plans, 16, &plan_count);
+/**
+ * @brief Errors confined to one plan: the rest of the read can go on
+ */
+static bool is_recoverable(int result) {
+    return is_retryable(result) || result == MB_ERROR_EXCEPTION_RESPONSE ||
+           result == MB_ERROR_SLAVE_OFFLINE;
+}
 
-    if (result != MB_SUCCESS) {
-        return result;
+static void mark_quality(uint8_t *quality,
+                         const mb_scatter_entry_t *entries,
+                         uint16_t count,
+                         int result) {
+    if (quality == NULL) {
+        return;
     }
 
-    // Step 2: Execute each plan
-    uint16_t temp_buffer[256];  // Temporary buffer for merged reads
-    uint16_t data_index = 0;
+    uint8_t value = MB_QUALITY_GOOD;
+    if (result == MB_ERROR_TIMEOUT) {
+        value = MB_QUALITY_TIMEOUT;
+    } else if (result == MB_ERROR_EXCEPTION_RESPONSE) {
+        value = MB_QUALITY_EXCEPTION;
+    } else if (result == MB_ERROR_SLAVE_OFFLINE) {
+        value = MB_QUALITY_OFFLINE;
+    } else if (result != MB_SUCCESS) {
+        value = MB_QUALITY_COMM_ERROR;
+    }
 
-    for (uint16_t i = 0; i < plan_count; i++) {
-        mb_request_plan_t *plan = &plans[i];
+    for (uint16_t i = 0; i < count; i++) {
+        quality[entries[i].dest_index] = value;
+    }
+}
 
-        // Build PDU
-        uint8_t pdu_data[4];
-        pdu_data[0] = (uint8_t)((plan->start_address >> 8) & 0xFF);
-        pdu_data[1] = (uint8_t)(plan->start_address & 0xFF);
-        pdu_data[2] = (uint8_t)((plan->quantity >> 8) & 0xFF);
-        pdu_data[3] = (uint8_t)(plan->quantity & 0xFF);
+static int tracked_response(void *ctx,
+                            uint16_t plan_index,
+                            uint8_t fc,
+                            const uint8_t *pdu_data,
+                            uint16_t pdu_length) {
+    read_tracker_t *tracker = (read_tracker_t *)ctx;
+
+    int result = mb_scatter_plan_response(tracker->scatter_ctx, plan_index, fc, pdu_data,
+                                          pdu_length);
+    if (result == MB_SUCCESS) {
+        const mb_request_plan_t *plan = &tracker->scatter_ctx->plans[plan_index];
+        tracker->answered[plan_index] = true;
+        mark_quality(tracker->quality, &tracker->scatter_ctx->scatter[plan->scatter_first],
+                     plan->scatter_count, MB_SUCCESS);
+    }
+    return result;
+}
 
-        // Build frame
-        uint8_t frame_buffer[260];
-        uint16_t frame_length = 0;
-        result = mb_build_frame(plan->slave_id, plan->function_code, pdu_data, 4, master->config.mode,
-                                frame_buffer, sizeof(frame_buffer), &frame_length);
+/**
+ * @brief Execute one plan, re-sending it after communication errors
+ * @param failed Result of the attempt already made, MB_SUCCESS if none
+ */
+static int execute_plan_retrying(mb_master_t *master,
+                                 const mb_request_plan_t *plan,
+                                 const mb_scatter_ctx_t *window_ctx,
+                                 bool *answered,
+                                 uint8_t *quality,
+                                 int failed) {
+    const mb_retry_policy_t *policy = &master->config.retry;
+
+    mb_scatter_ctx_t scatter_ctx = *window_ctx;
+    scatter_ctx.plans            = plan;
+    read_tracker_t tracker       = {&scatter_ctx, answered, quality};
+
+    int result = failed;
+    if (result == MB_SUCCESS) {
+        result = mb_transaction_execute_plans(master, plan, 1, tracked_response, &tracker);
+    }
 
-        if (result != MB_SUCCESS) {
-            master->stats.total_requests++;
-            return result;
+    uint32_t backoff = policy->backoff_chars;
+    for (uint8_t retry = 0; retry < policy->max_retries && is_retryable(result); retry++) {
+        if (backoff > 0 && master->config.transport.delay_chars != NULL) {
+            master->config.transport.delay_chars(master->config.transport.context,
+                                                 (uint16_t)backoff);
         }
-
-        // Send request
-        if (master->config.transport.send == NULL) {
-            return MB_ERROR_TRANSPORT;
+        backoff *= 2;
+        if (backoff > UINT16_MAX ||
+            (policy->max_backoff_chars > 0 && backoff > policy->max_backoff_chars)) {
+            backoff = policy->max_backoff_chars > 0 ? policy->max_backoff_chars : UINT16_MAX;
         }
 
-        int sent = master->config.transport.send(master->config.transport.context, frame_buffer, frame_length);
-        if (sent < 0) {
-            master->stats.total_requests++;
-            return MB_ERROR_TRANSPORT;
-        }
+        master->stats.retries++;
+        result = mb_transaction_execute_plans(master, plan, 1, tracked_response, &tracker);
+    }
 
-        // Receive response
-        if (master->config.transport.recv == NULL) {
-            return MB_ERROR_TRANSPORT;
+    return result;
+}
+
+/**
+ * @brief Re-read a failed plan as the blocks it was merged from
+ *
+ * Sorted by offset, the plan's scatter entries fall into runs of adjacent
+ * registers (or coils): the blocks mb_addresses_to_blocks() built before
+ * gap merging. Each run is read as a plan of its own, with its entries
+ * rebased onto the run for the time of the read.
+ *
+ * @return MB_SUCCESS if every block was read, otherwise the last block error
+ */
+static int execute_plan_split(mb_master_t *master,
+                              const mb_request_plan_t *plan,
+                              mb_scatter_entry_t *scatter,
+                              const mb_scatter_ctx_t *window_ctx,
+                              uint8_t *quality,
+                              int failed) {
+    mb_scatter_entry_t *entries = &scatter[plan->scatter_first];
+    uint16_t count              = plan->scatter_count;
+
+    // Insertion sort: entries arrive in request order, often already sorted
+    for (uint16_t i = 1; i < count; i++) {
+        mb_scatter_entry_t entry = entries[i];
+        uint16_t j               = i;
+        while (j > 0 && entries[j - 1].offset > entry.offset) {
+            entries[j] = entries[j - 1];
+            j--;
         }
+        entries[j] = entry;
+    }
+
+    // One block: nothing was merged into this plan
+    bool merged = false;
+    for (uint16_t i = 1; i < count && !merged; i++) {
+        merged = entries[i].offset - entries[i - 1].offset > 1;
+    }
+    if (!merged) {
+        mark_quality(quality, entries, count, failed);
+        return failed;
+    }
 
-        uint8_t response_buffer[260];
-        size_t received = 0;
-        int recv_result = master->config.transport.recv(master->config.transport.context, response_buffer,
-                                                         sizeof(response_buffer), &received);
+    master->stats.split_plans++;
 
-        if (recv_result < 0 || received == 0) {
-            master->stats.total_requests++;
-            return MB_ERROR_TIMEOUT;
+    int result     = MB_SUCCESS;
+    uint16_t first = 0;
+    while (first < count) {
+        uint16_t end = (uint16_t)(first + 1);
+        while (end < count && entries[end].offset - entries[end - 1].offset <= 1) {
+            end++;
         }
 
-        // Parse frame
-        uint8_t resp_slave_id, resp_fc;
-        uint8_t pdu_response[256];
-        uint16_t pdu_length = 0;
+        uint16_t base = entries[first].offset;
+        for (uint16_t i = first; i < end; i++) {
+            entries[i].offset = (uint16_t)(entries[i].offset - base);
+        }
 
-        result = mb_parse_frame(response_buffer, (uint16_t)received, master->config.mode, &resp_slave_id,
-                                &resp_fc, pdu_response, &pdu_length);
+        mb_request_plan_t block = *plan;
+        block.start_address     = (uint16_t)(plan->start_address + base);
+        block.quantity          = (uint16_t)(entries[end - 1].offset + 1);
+        block.frame_data        = NULL;
+        block.frame_length      = 0;
+        block.scatter_first     = (uint16_t)(plan->scatter_first + first);
+        block.scatter_count     = (uint16_t)(end - first);
 
-        if (result != MB_SUCCESS) {
-            master->stats.total_requests++;
-            return result;
+        bool answered    = false;
+        int block_result = execute_plan_retrying(master, &block, window_ctx, &answered, quality,
+                                                 MB_SUCCESS);
+
+        for (uint16_t i = first; i < end; i++) {
+            entries[i].offset = (uint16_t)(entries[i].offset + base);
         }
 
-        // Validate response
-        if (resp_slave_id != plan->slave_id) {
-            master->stats.total_requests++;
-            return MB_ERROR_INVALID_FRAME;
+        if (block_result != MB_SUCCESS) {
+            mark_quality(quality, &entries[first], (uint16_t)(end - first), block_result);
+            if (!is_recoverable(block_result)) {
+                return block_result;
+            }
+            result = block_result;
         }
+        first = end;
+    }
 
-        // Parse response data into temp buffer
-        result = mb_parse_read_response(resp_fc, pdu_response, pdu_length, plan->quantity, temp_buffer);
+    return result;
+}
 
-        if (result != MB_SUCCESS) {
-            master->stats.total_requests++;
-            return result;
+/**
+ * @brief Finish a window that stopped on a recoverable error
+ *
+ * Every plan not yet answered is executed on its own with the retry policy;
+ * failed_plan, the one the window's error belongs to, has already used one
+ * attempt. Requests abandoned with it get a fresh one. Failed values keep
+ * their previous content.
+ *
+ * @return MB_SUCCESS, the last recoverable plan error, or a fatal error
+ */
+static int recover_window(mb_master_t *master,
+                          const mb_request_plan_t *plans,
+                          uint16_t plan_count,
+                          mb_scatter_entry_t *scatter,
+                          const mb_scatter_ctx_t *window_ctx,
+                          bool *answered,
+                          uint8_t *quality,
+                          uint16_t failed_plan,
+                          int failed) {
+    int result = MB_SUCCESS;
+
+    for (uint16_t i = 0; i < plan_count; i++) {
+        if (answered[i]) {
+            continue;
         }
 
-        // Extract requested data from merged response
-        // For now, copy all data (TODO: map back to original addresses)
-        for (uint16_t j = 0; j < plan->quantity && data_index < buffer_size; j++) {
-            data_buffer[data_index++] = temp_buffer[j];
+        int plan_result = execute_plan_retrying(master, &plans[i], window_ctx, &answered[i],
+                                                quality, i == failed_plan ? failed : MB_SUCCESS);
+
+        if (plan_result != MB_SUCCESS && is_recoverable(plan_result)) {
+            if (master->config.retry.split) {
+                plan_result = execute_plan_split(master, &plans[i], scatter, window_ctx, quality,
+                                                 plan_result);
+            } else {
+                mark_quality(quality, &scatter[plans[i].scatter_first], plans[i].scatter_count,
+                             plan_result);
+            }
         }
 
-        // Update statistics
-        master->stats.total_requests++;
-        master->stats.total_requests++;
-        master->stats.total_chars_sent += frame_length;
-        master->stats.total_chars_recv += received;
+        if (plan_result != MB_SUCCESS) {
+            if (!is_recoverable(plan_result)) {
+                return plan_result;
+            }
+            result = plan_result;
+        }
     }
 
-    // Update optimization statistics
-    master->stats.optimized_requests++;
-    master->stats.blocks_merged += (request->address_count - plan_count);
-
-    return MB_SUCCESS;
+    return result;
 }
 
-int mb_master_read_single(mb_master_t *master,
-                          uint8_t slave_id,
-                          uint8_t fc,
-                          uint16_t start_addr,
-                          uint16_t quantity,
-                          uint16_t *data_buffer) {
-    if (master == NULL || data_buffer == NULL) {
-        return MB_ERROR_INVALID_PARAM;
+/**
+ * @brief Optimized read into the output named by sink
+ *
+ * sink supplies the output fields of the scatter context (data_buffer,
+ * bits, or typed_tags with routes); plans, scatter map and profiles are
+ * filled in per window. With a retry policy, or quality to fill, a failed
+ * plan is recovered and the read goes on; the last recoverable error is
+ * returned once every window has run.
+ */
+static int read_optimized(mb_master_t *master,
+                          const mb_read_request_t *request,
+                          const mb_scatter_ctx_t *sink,
+                          uint8_t *quality) {
+    if (request->address_count == 0) {
+        return MB_SUCCESS;
     }
 
-    // Validate function code
-    if (fc != MB_FC_READ_COILS && fc != MB_FC_READ_DISCRETE_INPUTS &&
-        fc != MB_FC_READ_HOLDING_REGISTERS && fc != MB_FC_READ_INPUT_REGISTERS) {
-        return MB_ERROR_INVALID_FC;
+    // Scatter map of one window (the whole request when memory allows)
+    mb_scatter_entry_t *scatter = NULL;
+    uint16_t max_scatter        = 0;
+
+#ifdef MB_USE_STATIC_MEMORY
+    scatter     = master->scatter_pool;
+    max_scatter = MB_MAX_SCATTER;
+#else
+    size_t mark = mb_scratch_mark(&master->scratch);
+    max_scatter = request->address_count;
+    scatter     = (mb_scatter_entry_t *)mb_scratch_acquire(
+        &master->scratch, max_scatter * sizeof(mb_scatter_entry_t));
+    if (scatter == NULL) {
+        return MB_ERROR_NO_MEMORY;
     }
+#endif
 
-    // Build PDU (address + quantity)
-    uint8_t pdu_data[4];
-    pdu_data[0] = (uint8_t)((start_addr >> 8) & 0xFF);
-    pdu_data[1] = (uint8_t)(start_addr & 0xFF);
-    pdu_data[2] = (uint8_t)((quantity >> 8) & 0xFF);
-    pdu_data[3] = (uint8_t)(quantity & 0xFF);
+    // Plan, execute and scatter one window of plans at a time, so requests
+    // of any size run in fixed plan storage
+    mb_request_plan_t plans[MB_WINDOW_PLANS];
+    bool answered[MB_WINDOW_PLANS];
+    mb_plans_report_t report;
+    uint32_t total_plans = 0;
+    uint32_t cursor      = 0;
+    int result           = MB_SUCCESS;
+    int failure          = MB_SUCCESS;
+    bool recovering      = quality != NULL || master->config.retry.max_retries > 0 ||
+                           master->config.retry.split;
+
+    while (result == MB_SUCCESS && cursor < MB_WINDOW_END) {
+        uint32_t next       = cursor;
+        uint16_t plan_count = 0;
+
+        mb_scatter_ctx_t scatter_ctx = *sink;
+        scatter_ctx.plans            = plans;
+        scatter_ctx.scatter          = scatter;
+        scatter_ctx.profiles         = master->config.profiles;
+
+        // An exception that taught the slave's profile something is planned
+        // around once, within the same call
+        for (int attempt = 0; attempt < 2; attempt++) {
+            uint16_t scatter_count = 0;
+            next                   = cursor;
+
+            MB_TRACE(&master->config, MB_TRACE_OPTIMIZE_BEGIN, request->slave_id,
+                     request->function_code, 0, MB_SUCCESS);
+            result = mb_optimize_request_window(request, &master->config, &next, plans,
+                                                MB_WINDOW_PLANS, &plan_count, scatter,
+                                                max_scatter, &scatter_count, &master->scratch);
+            MB_TRACE(&master->config, MB_TRACE_OPTIMIZE_END, request->slave_id,
+                     request->function_code, plan_count, result);
+            if (result != MB_SUCCESS) {
+                break;
+            }
+
+            // Execute plans (pipelined on TCP when max_in_flight > 1)
+            scatter_ctx.learned    = false;
+            read_tracker_t tracker = {&scatter_ctx, answered, quality};
+            memset(answered, 0, sizeof(answered));
+
+            // Each value is written straight to its slot; gap units are skipped
+            result = mb_transaction_execute_plans_report(master, plans, plan_count,
+                                                         tracked_response, &tracker, &report);
+            if (result != MB_ERROR_EXCEPTION_RESPONSE || !scatter_ctx.learned) {
+                break;
+            }
+        }
 
-    // Build frame
-    uint8_t frame_buffer[260];  // Max frame size
-    uint16_t frame_length = 0;
-    int result = mb_build_frame(slave_id, fc, pdu_data, 4, master->config.mode, frame_buffer,
-                                sizeof(frame_buffer), &frame_length);
+        if (result == MB_SUCCESS) {
+            mb_metrics_record_plans(master->config.metrics, plans, plan_count, scatter);
+        } else if (recovering && is_recoverable(result)) {
+            result = recover_window(master, plans, plan_count, scatter, &scatter_ctx, answered,
+                                    quality, report.failed_plan, result);
+            if (is_recoverable(result)) {
+                failure = result;
+                result  = MB_SUCCESS;
+            }
+        }
+        total_plans += plan_count;
+        cursor       = next;
+    }
+
+#ifndef MB_USE_STATIC_MEMORY
+    mb_scratch_release(&master->scratch, scatter);
+    mb_scratch_rewind(&master->scratch, mark);
+#endif
 
     if (result != MB_SUCCESS) {
         return result;
     }
 
-    // Send request
-    if (master->config.transport.send == NULL) {
-        return MB_ERROR_TRANSPORT;
+    // Update optimization statistics
+    master->stats.optimized_requests++;
+    if (total_plans < request->address_count) {
+        master->stats.blocks_merged += request->address_count - total_plans;
     }
 
-    int sent = master->config.transport.send(master->config.transport.context, frame_buffer, frame_length);
-    if (sent < 0) {
-        master->stats.total_requests++;
-        return MB_ERROR_TRANSPORT;
+    return failure;
+}
+
+int mb_master_read_optimized(mb_master_t *master,
+                              const mb_read_request_t *request,
+                              uint16_t *data_buffer,
+                              uint16_t buffer_size) {
+    if (master == NULL || request == NULL || data_buffer == NULL) {
+        return MB_ERROR_INVALID_PARAM;
     }
 
-    // Receive response
-    if (master->config.transport.recv == NULL) {
-        return MB_ERROR_TRANSPORT;
+    if (buffer_size < request->address_count) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
     }
 
-    uint8_t response_buffer[260];
-    size_t received = 0;
-    int recv_result = master->config.transport.recv(master->config.transport.context, response_buffer,
-                                                     sizeof(response_buffer), &received);
+    mb_scatter_ctx_t sink;
+    memset(&sink, 0, sizeof(sink));
+    sink.data_buffer = data_buffer;
+
+    return read_optimized(master, request, &sink, NULL);
+}
 
-    if (recv_result < 0 || received == 0) {
-        master->stats.total_requests++;
-        return MB_ERROR_TIMEOUT;
+int mb_master_read_optimized_quality(mb_master_t *master,
+                                     const mb_read_request_t *request,
+                                     uint16_t *data_buffer,
+                                     uint16_t buffer_size,
+                                     uint8_t *quality) {
+    if (master == NULL || request == NULL || data_buffer == NULL || quality == NULL) {
+        return MB_ERROR_INVALID_PARAM;
     }
 
-    // Parse frame
-    uint8_t resp_slave_id, resp_fc;
-    uint8_t pdu_response[256];
-    uint16_t pdu_length = 0;
+    if (buffer_size < request->address_count) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
 
-    result = mb_parse_frame(response_buffer, (uint16_t)received, master->config.mode, &resp_slave_id,
-                            &resp_fc, pdu_response, &pdu_length);
+    memset(quality, MB_QUALITY_NOT_READ, request->address_count);
 
-    if (result != MB_SUCCESS) {
-        master->stats.total_requests++;
+    mb_scatter_ctx_t sink;
+    memset(&sink, 0, sizeof(sink));
+    sink.data_buffer = data_buffer;
+
+    int result = read_optimized(master, request, &sink, quality);
+    if (!is_recoverable(result)) {
         return result;
     }
 
-    // Validate response
-    if (resp_slave_id != slave_id) {
-        master->stats.total_requests++;
-        return MB_ERROR_INVALID_FRAME;
+    // Something arrived: the caller sorts out the rest by quality
+    for (uint16_t i = 0; i < request->address_count; i++) {
+        if (quality[i] == MB_QUALITY_GOOD) {
+            return MB_ERROR_PARTIAL_RESULT;
+        }
+    }
+    return result;
+}
+
+int mb_master_read_optimized_bits(mb_master_t *master,
+                                  const mb_read_request_t *request,
+                                  uint32_t *bits,
+                                  uint32_t bit_capacity) {
+    if (master == NULL || request == NULL || bits == NULL) {
+        return MB_ERROR_INVALID_PARAM;
     }
 
-    // Parse response data
-    result = mb_parse_read_response(resp_fc, pdu_response, pdu_length, quantity, data_buffer);
+    if (request->function_code != MB_FC_READ_COILS &&
+        request->function_code != MB_FC_READ_DISCRETE_INPUTS) {
+        return MB_ERROR_INVALID_FC;
+    }
 
-    if (result != MB_SUCCESS) {
-        master->stats.total_requests++;
-        return result;
+    if (bit_capacity < request->address_count) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
     }
 
-    // Update statistics
-    master->stats.total_requests++;
-    master->stats.total_requests++;
-    master->stats.total_chars_sent += frame_length;
-    master->stats.total_chars_recv += received;
+    mb_scatter_ctx_t sink;
+    memset(&sink, 0, sizeof(sink));
+    sink.bits = bits;
 
-    return MB_SUCCESS;
+    return read_optimized(master, request, &sink, NULL);
 }
 
-int mb_master_write_single_coil(mb_master_t *master, uint8_t slave_id, uint16_t addr, bool value) {
-    if (master == NULL) {
+int mb_master_read_typed(mb_master_t *master,
+                         uint8_t slave_id,
+                         uint8_t fc,
+                         const mb_typed_tag_t *tags,
+                         uint16_t tag_count) {
+    if (master == NULL || tags == NULL) {
         return MB_ERROR_INVALID_PARAM;
     }
 
-    uint8_t fc = MB_FC_WRITE_SINGLE_COIL;
+    if (fc != MB_FC_READ_HOLDING_REGISTERS && fc != MB_FC_READ_INPUT_REGISTERS) {
+        return MB_ERROR_INVALID_FC;
+    }
 
-    // Build PDU (address + value)
-    uint8_t pdu_data[4];
-    pdu_data[0] = (uint8_t)((addr >> 8) & 0xFF);
-    pdu_data[1] = (uint8_t)(addr & 0xFF);
-    pdu_data[2] = value ? 0xFF : 0x00;  // 0xFF00 for ON, 0x0000 for OFF
-    pdu_data[3] = 0x00;
+    // Count the registers behind the tags
+    uint32_t register_count = 0;
+    for (uint16_t i = 0; i < tag_count; i++) {
+        uint8_t words = mb_value_registers((mb_value_type_t)tags[i].type);
+        if (words == 0 || tags[i].value == NULL || tags[i].order > MB_ORDER_DCBA) {
+            return MB_ERROR_INVALID_PARAM;
+        }
+        if ((uint32_t)tags[i].address + words > 0x10000u) {
+            return MB_ERROR_INVALID_ADDRESS;
+        }
+        register_count += words;
+    }
 
-    // Build frame
-    uint8_t frame_buffer[260];
-    uint16_t frame_length = 0;
-    int result = mb_build_frame(slave_id, fc, pdu_data, 4, master->config.mode, frame_buffer,
-                                sizeof(frame_buffer), &frame_length);
+    if (register_count == 0) {
+        return MB_SUCCESS;
+    }
+    if (register_count > UINT16_MAX) {
+        return MB_ERROR_INVALID_QUANTITY;
+    }
 
-    if (result != MB_SUCCESS) {
-        return result;
+    // One request address and one route per register
+    uint16_t *addresses      = NULL;
+    mb_typed_route_t *routes = NULL;
+
+#ifdef MB_USE_STATIC_MEMORY
+    uint16_t address_pool[MB_MAX_SCATTER];
+    mb_typed_route_t route_pool[MB_MAX_SCATTER];
+    if (register_count > MB_MAX_SCATTER) {
+        return MB_ERROR_TOO_MANY_BLOCKS;
     }
+    addresses = address_pool;
+    routes    = route_pool;
+#else
+    size_t mark = mb_scratch_mark(&master->scratch);
+    addresses   = (uint16_t *)mb_scratch_acquire(&master->scratch,
+                                                 register_count * sizeof(uint16_t));
+    routes      = (mb_typed_route_t *)mb_scratch_acquire(
+        &master->scratch, register_count * sizeof(mb_typed_route_t));
+    if (addresses == NULL || routes == NULL) {
+        mb_scratch_release(&master->scratch, addresses);
+        mb_scratch_release(&master->scratch, routes);
+        mb_scratch_rewind(&master->scratch, mark);
+        return MB_ERROR_NO_MEMORY;
+    }
+#endif
 
-    // Send request
-    if (master->config.transport.send == NULL) {
-        return MB_ERROR_TRANSPORT;
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < tag_count; i++) {
+        uint8_t words = mb_value_registers((mb_value_type_t)tags[i].type);
+        for (uint8_t w = 0; w < words; w++) {
+            addresses[n]        = (uint16_t)(tags[i].address + w);
+            routes[n].tag_index = i;
+            routes[n].word      = w;
+            n++;
+        }
     }
 
-    int sent = master->config.transport.send(master->config.transport.context, frame_buffer, frame_length);
-    if (sent < 0) {
-        master->stats.total_requests++;
-        return MB_ERROR_TRANSPORT;
+    mb_read_request_t request;
+    request.slave_id      = slave_id;
+    request.function_code = fc;
+    request.addresses     = addresses;
+    request.address_count = n;
+
+    mb_scatter_ctx_t sink;
+    memset(&sink, 0, sizeof(sink));
+    sink.typed_tags = tags;
+    sink.routes     = routes;
+
+    int result = read_optimized(master, &request, &sink, NULL);
+
+#ifndef MB_USE_STATIC_MEMORY
+    mb_scratch_release(&master->scratch, routes);
+    mb_scratch_release(&master->scratch, addresses);
+    mb_scratch_rewind(&master->scratch, mark);
+#endif
+
+    return result;
+}
+
+int mb_master_read_batch(mb_master_t *master,
+                         const mb_tag_t *tags,
+                         uint16_t tag_count,
+                         uint16_t *data_buffer,
+                         uint16_t buffer_size) {
+    if (master == NULL || tags == NULL || data_buffer == NULL) {
+        return MB_ERROR_INVALID_PARAM;
     }
 
-    // Receive response
-    if (master->config.transport.recv == NULL) {
-        return MB_ERROR_TRANSPORT;
+    if (buffer_size < tag_count) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    if (tag_count == 0) {
+        return MB_SUCCESS;
     }
 
-    uint8_t response_buffer[260];
-    size_t received = 0;
-    int recv_result = master->config.transport.recv(master->config.transport.context, response_buffer,
-                                                     sizeof(response_buffer), &received);
+    mb_request_plan_t *plans = NULL;
+    mb_scatter_entry_t *scatter = NULL;
+    uint16_t max_plans = 0;
 
-    if (recv_result < 0 || received == 0) {
-        master->stats.total_requests++;
-        return MB_ERROR_TIMEOUT;
+#ifdef MB_USE_STATIC_MEMORY
+    if (tag_count > MB_MAX_SCATTER) {
+        return MB_ERROR_TOO_MANY_BLOCKS;
     }
+    plans = master->plan_pool;
+    scatter = master->scatter_pool;
+    max_plans = MB_MAX_PLANS;
+#else
+    // Every plan covers at least one tag
+    size_t mark = mb_scratch_mark(&master->scratch);
+    max_plans = tag_count;
+    plans = (mb_request_plan_t *)mb_scratch_acquire(&master->scratch,
+                                                    max_plans * sizeof(mb_request_plan_t));
+    scatter = (mb_scatter_entry_t *)mb_scratch_acquire(&master->scratch,
+                                                       tag_count * sizeof(mb_scatter_entry_t));
+    if (plans == NULL || scatter == NULL) {
+        mb_scratch_release(&master->scratch, plans);
+        mb_scratch_release(&master->scratch, scatter);
+        mb_scratch_rewind(&master->scratch, mark);
+        return MB_ERROR_NO_MEMORY;
+    }
+#endif
 
-    // Parse frame
-    uint8_t resp_slave_id, resp_fc;
-    uint8_t pdu_response[256];
-    uint16_t pdu_length = 0;
+    // Step 1: Group by (slave, FC), optimize each group, order globally
+    uint16_t plan_count = 0;
+    int result = MB_SUCCESS;
 
-    result = mb_parse_frame(response_buffer, (uint16_t)received, master->config.mode, &resp_slave_id,
-                            &resp_fc, pdu_response, &pdu_length);
+    for (int attempt = 0; attempt < 2; attempt++) {
+        MB_TRACE(&master->config, MB_TRACE_OPTIMIZE_BEGIN, 0, 0, 0, MB_SUCCESS);
+        result = mb_optimize_batch(tags, tag_count, &master->config, plans, max_plans, &plan_count,
+                                   scatter, &master->scratch);
+        MB_TRACE(&master->config, MB_TRACE_OPTIMIZE_END, 0, 0, plan_count, result);
+        if (result != MB_SUCCESS) {
+            break;
+        }
 
-    if (result != MB_SUCCESS) {
-        master->stats.total_requests++;
-        return result;
+        // Step 2: Execute all plans in one pass, re-planned once after a
+        // learned exception
+        mb_scatter_ctx_t scatter_ctx;
+        scatter_ctx.plans       = plans;
+        scatter_ctx.scatter     = scatter;
+        scatter_ctx.data_buffer = data_buffer;
+        scatter_ctx.profiles    = master->config.profiles;
+        scatter_ctx.learned     = false;
+        scatter_ctx.bits        = NULL;
+        scatter_ctx.typed_tags  = NULL;
+        scatter_ctx.routes      = NULL;
+
+        result = mb_transaction_execute_plans(master, plans, plan_count, mb_scatter_plan_response,
+                                              &scatter_ctx);
+        if (result != MB_ERROR_EXCEPTION_RESPONSE || !scatter_ctx.learned) {
+            break;
+        }
     }
 
-    // Validate response
-    if (resp_slave_id != slave_id) {
-        master->stats.total_requests++;
-        return MB_ERROR_INVALID_FRAME;
+    if (result == MB_SUCCESS) {
+        mb_metrics_record_plans(master->config.metrics, plans, plan_count, scatter);
     }
 
-    // Parse write response
-    result = mb_parse_write_response(resp_fc, pdu_response, pdu_length, addr, 1, &value);
+#ifndef MB_USE_STATIC_MEMORY
+    mb_scratch_release(&master->scratch, plans);
+    mb_scratch_release(&master->scratch, scatter);
+    mb_scratch_rewind(&master->scratch, mark);
+#endif
 
     if (result != MB_SUCCESS) {
-        master->stats.total_requests++;
         return result;
     }
 
-    // Update statistics
-    master->stats.total_requests++;
-    master->stats.total_requests++;
-    master->stats.total_chars_sent += frame_length;
-    master->stats.total_chars_recv += received;
+    master->stats.optimized_requests++;
+    master->stats.blocks_merged += (uint32_t)(tag_count - plan_count);
 
     return MB_SUCCESS;
 }
 
-int mb_master_write_single_register(mb_master_t *master,
-                                     uint8_t slave_id,
-                                     uint16_t addr,
-                                     uint16_t value) {
-    if (master == NULL) {
+int mb_master_read_single(mb_master_t *master,
+                          uint8_t slave_id,
+                          uint8_t fc,
+                          uint16_t start_addr,
+                          uint16_t quantity,
+                          uint16_t *data_buffer) {
+    if (master == NULL || data_buffer == NULL) {
         return MB_ERROR_INVALID_PARAM;
     }
 
-    uint8_t fc = MB_FC_WRITE_SINGLE_REGISTER;
+    // Validate function code
+    if (fc != MB_FC_READ_COILS && fc != MB_FC_READ_DISCRETE_INPUTS &&
+        fc != MB_FC_READ_HOLDING_REGISTERS && fc != MB_FC_READ_INPUT_REGISTERS) {
+        return MB_ERROR_INVALID_FC;
+    }
 
-    // Build PDU (address + value)
-    uint8_t pdu_data[4];
-    pdu_data[0] = (uint8_t)((addr >> 8) & 0xFF);
-    pdu_data[1] = (uint8_t)(addr & 0xFF);
-    pdu_data[2] = (uint8_t)((value >> 8) & 0xFF);
-    pdu_data[3] = (uint8_t)(value & 0xFF);
+    // Build PDU (address + quantity) directly in the request frame
+    mb_io_frame_t io;
+    uint16_t capacity = 0;
+    uint8_t *pdu_data = mb_transaction_begin(master, &io.tx, &capacity);
+    if (capacity < 4) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    pdu_data[0] = (uint8_t)((start_addr >> 8) & 0xFF);
+    pdu_data[1] = (uint8_t)(start_addr & 0xFF);
+    pdu_data[2] = (uint8_t)((quantity >> 8) & 0xFF);
+    pdu_data[3] = (uint8_t)(quantity & 0xFF);
 
-    // Build frame
-    uint8_t frame_buffer[260];
-    uint16_t frame_length = 0;
-    int result = mb_build_frame(slave_id, fc, pdu_data, 4, master->config.mode, frame_buffer,
-                                sizeof(frame_buffer), &frame_length);
+    // Execute transaction; the response PDU is a view into the receive frame
+    uint8_t resp_fc;
+    const uint8_t *pdu_response = NULL;
+    uint16_t pdu_length         = 0;
 
+    int result = mb_transaction_execute_view(master, &io.tx, slave_id, fc, 4, &io.rx, &resp_fc,
+                                             &pdu_response, &pdu_length);
     if (result != MB_SUCCESS) {
         return result;
     }
 
-    // Send request
-    if (master->config.transport.send == NULL) {
-        return MB_ERROR_TRANSPORT;
-    }
+    // Parse response data
+    return mb_parse_read_response(resp_fc, pdu_response, pdu_length, quantity, data_buffer);
+}
 
-    int sent = master->config.transport.send(master->config.transport.context, frame_buffer, frame_length);
-    if (sent < 0) {
-        master->stats.total_requests++;
-        return MB_ERROR_TRANSPORT;
+int mb_master_write_single_coil(mb_master_t *master, uint8_t slave_id, uint16_t addr, bool value) {
+    if (master == NULL) {
+        return MB_ERROR_INVALID_PARAM;
     }
 
-    // Receive response
-    if (master->config.transport.recv == NULL) {
-        return MB_ERROR_TRANSPORT;
+    uint8_t fc = MB_FC_WRITE_SINGLE_COIL;
+
+    // Build PDU (address + value) directly in the request frame
+    mb_io_frame_t io;
+    uint16_t capacity = 0;
+    uint8_t *pdu_data = mb_transaction_begin(master, &io.tx, &capacity);
+    if (capacity < 4) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
     }
 
-    uint8_t response_buffer[260];
-    size_t received = 0;
-    int recv_result = master->config.transport.recv(master->config.transport.context, response_buffer,
-                                                     sizeof(response_buffer), &received);
+    pdu_data[0] = (uint8_t)((addr >> 8) & 0xFF);
+    pdu_data[1] = (uint8_t)(addr & 0xFF);
+    pdu_data[2] = value ? 0xFF : 0x00;  // 0xFF00 for ON, 0x0000 for OFF
+    pdu_data[3] = 0x00;
 
-    if (recv_result < 0 || received == 0) {
-        master->stats.total_requests++;
-        return MB_ERROR_TIMEOUT;
+    if (mb_transaction_is_broadcast(master, slave_id)) {
+        return mb_transaction_broadcast(master, &io.tx, fc, 4);
     }
 
-    // Parse frame
-    uint8_t resp_slave_id, resp_fc;
-    uint8_t pdu_response[256];
-    uint16_t pdu_length = 0;
-
-    result = mb_parse_frame(response_buffer, (uint16_t)received, master->config.mode, &resp_slave_id,
-                            &resp_fc, pdu_response, &pdu_length);
+    // Execute transaction
+    uint8_t resp_fc;
+    const uint8_t *pdu_response = NULL;
+    uint16_t pdu_length         = 0;
 
+    int result = mb_transaction_execute_view(master, &io.tx, slave_id, fc, 4, &io.rx, &resp_fc,
+                                             &pdu_response, &pdu_length);
     if (result != MB_SUCCESS) {
-        master->stats.total_requests++;
         return result;
     }
 
-    // Validate response
-    if (resp_slave_id != slave_id) {
-        master->stats.total_requests++;
-        return MB_ERROR_INVALID_FRAME;
+    // Parse write response
+    return mb_parse_write_response(resp_fc, pdu_response, pdu_length, addr, 1, &value);
+}
+
+int mb_master_write_single_register(mb_master_t *master,
+                                     uint8_t slave_id,
+                                     uint16_t addr,
+                                     uint16_t value) {
+    if (master == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    uint8_t fc = MB_FC_WRITE_SINGLE_REGISTER;
+
+    // Build PDU (address + value) directly in the request frame
+    mb_io_frame_t io;
+    uint16_t capacity = 0;
+    uint8_t *pdu_data = mb_transaction_begin(master, &io.tx, &capacity);
+    if (capacity < 4) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
     }
 
-    // Parse write response
-    result = mb_parse_write_response(resp_fc, pdu_response, pdu_length, addr, 1, &value);
+    pdu_data[0] = (uint8_t)((addr >> 8) & 0xFF);
+    pdu_data[1] = (uint8_t)(addr & 0xFF);
+    pdu_data[2] = (uint8_t)((value >> 8) & 0xFF);
+    pdu_data[3] = (uint8_t)(value & 0xFF);
+
+    if (mb_transaction_is_broadcast(master, slave_id)) {
+        return mb_transaction_broadcast(master, &io.tx, fc, 4);
+    }
+
+    // Execute transaction
+    uint8_t resp_fc;
+    const uint8_t *pdu_response = NULL;
+    uint16_t pdu_length         = 0;
 
+    int result = mb_transaction_execute_view(master, &io.tx, slave_id, fc, 4, &io.rx, &resp_fc,
+                                             &pdu_response, &pdu_length);
     if (result != MB_SUCCESS) {
-        master->stats.total_requests++;
         return result;
     }
 
-    // Update statistics
-    master->stats.total_requests++;
-    master->stats.total_requests++;
-    master->stats.total_chars_sent += frame_length;
-    master->stats.total_chars_recv += received;
-
-    return MB_SUCCESS;
+    // Parse write response
+    return mb_parse_write_response(resp_fc, pdu_response, pdu_length, addr, 1, &value);
 }
 
 int mb_master_write_multiple_registers(mb_master_t *master,
@@ -508,10 +898,16 @@ int mb_master_write_multiple_registers(mb_master_t *master,
 
     uint8_t fc = MB_FC_WRITE_MULTIPLE_REGISTERS;
 
-    // Build PDU (address + quantity + byte_count + values)
-    uint8_t pdu_data[256];
+    // Build PDU (address + quantity + byte_count + values) directly in the request frame
+    mb_io_frame_t io;
+    uint16_t capacity   = 0;
+    uint8_t *pdu_data   = mb_transaction_begin(master, &io.tx, &capacity);
     uint16_t pdu_length = 0;
 
+    if (capacity < 5 + quantity * 2) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+
     pdu_data[pdu_length++] = (uint8_t)((start_addr >> 8) & 0xFF);
     pdu_data[pdu_length++] = (uint8_t)(start_addr & 0xFF);
     pdu_data[pdu_length++] = (uint8_t)((quantity >> 8) & 0xFF);
@@ -524,76 +920,85 @@ int mb_master_write_multiple_registers(mb_master_t *master,
         pdu_data[pdu_length++] = (uint8_t)(values[i] & 0xFF);
     }
 
-    // Build frame
-    uint8_t frame_buffer[260];
-    uint16_t frame_length = 0;
-    int result = mb_build_frame(slave_id, fc, pdu_data, pdu_length, master->config.mode, frame_buffer,
-                                sizeof(frame_buffer), &frame_length);
+    if (mb_transaction_is_broadcast(master, slave_id)) {
+        return mb_transaction_broadcast(master, &io.tx, fc, pdu_length);
+    }
 
+    // Execute transaction
+    uint8_t resp_fc;
+    const uint8_t *pdu_response = NULL;
+    uint16_t pdu_resp_length    = 0;
+
+    int result = mb_transaction_execute_view(master, &io.tx, slave_id, fc, pdu_length, &io.rx,
+                                             &resp_fc, &pdu_response, &pdu_resp_length);
     if (result != MB_SUCCESS) {
         return result;
     }
 
-    // Send request
-    if (master->config.transport.send == NULL) {
-        return MB_ERROR_TRANSPORT;
-    }
+    // Parse write response
+    return mb_parse_write_response(resp_fc, pdu_response, pdu_resp_length, start_addr, quantity,
+                                   NULL);
+}
 
-    int sent = master->config.transport.send(master->config.transport.context, frame_buffer, frame_length);
-    if (sent < 0) {
-        master->stats.total_requests++;
-        return MB_ERROR_TRANSPORT;
+int mb_master_write_multiple_coils(mb_master_t *master,
+                                   uint8_t slave_id,
+                                   uint16_t start_addr,
+                                   uint16_t quantity,
+                                   const bool *values) {
+    if (master == NULL || values == NULL) {
+        return MB_ERROR_INVALID_PARAM;
     }
 
-    // Receive response
-    if (master->config.transport.recv == NULL) {
-        return MB_ERROR_TRANSPORT;
+    if (quantity == 0 || quantity > 1968) {  // Max 1968 coils for FC15
+        return MB_ERROR_INVALID_QUANTITY;
     }
 
-    uint8_t response_buffer[260];
-    size_t received = 0;
-    int recv_result = master->config.transport.recv(master->config.transport.context, response_buffer,
-                                                     sizeof(response_buffer), &received);
+    uint8_t fc          = MB_FC_WRITE_MULTIPLE_COILS;
+    uint16_t byte_count = (uint16_t)((quantity + 7) / 8);
 
-    if (recv_result < 0 || received == 0) {
-        master->stats.total_requests++;
-        return MB_ERROR_TIMEOUT;
-    }
+    // Build PDU (address + quantity + byte_count + packed coils) directly in the request frame
+    mb_io_frame_t io;
+    uint16_t capacity   = 0;
+    uint8_t *pdu_data   = mb_transaction_begin(master, &io.tx, &capacity);
+    uint16_t pdu_length = 0;
 
-    // Parse frame
-    uint8_t resp_slave_id, resp_fc;
-    uint8_t pdu_response[256];
-    uint16_t pdu_resp_length = 0;
+    if (capacity < 5 + byte_count) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
 
-    result = mb_parse_frame(response_buffer, (uint16_t)received, master->config.mode, &resp_slave_id,
-                            &resp_fc, pdu_response, &pdu_resp_length);
+    pdu_data[pdu_length++] = (uint8_t)((start_addr >> 8) & 0xFF);
+    pdu_data[pdu_length++] = (uint8_t)(start_addr & 0xFF);
+    pdu_data[pdu_length++] = (uint8_t)((quantity >> 8) & 0xFF);
+    pdu_data[pdu_length++] = (uint8_t)(quantity & 0xFF);
+    pdu_data[pdu_length++] = (uint8_t)byte_count;
 
-    if (result != MB_SUCCESS) {
-        master->stats.total_requests++;
-        return result;
+    // First coil in the LSB of the first byte
+    memset(&pdu_data[pdu_length], 0, byte_count);
+    for (uint16_t i = 0; i < quantity; i++) {
+        if (values[i]) {
+            pdu_data[pdu_length + i / 8] |= (uint8_t)(1u << (i % 8));
+        }
     }
+    pdu_length = (uint16_t)(pdu_length + byte_count);
 
-    // Validate response
-    if (resp_slave_id != slave_id) {
-        master->stats.total_requests++;
-        return MB_ERROR_INVALID_FRAME;
+    if (mb_transaction_is_broadcast(master, slave_id)) {
+        return mb_transaction_broadcast(master, &io.tx, fc, pdu_length);
     }
 
-    // Parse write response
-    result = mb_parse_write_response(resp_fc, pdu_response, pdu_resp_length, start_addr, quantity, NULL);
+    // Execute transaction
+    uint8_t resp_fc;
+    const uint8_t *pdu_response = NULL;
+    uint16_t pdu_resp_length    = 0;
 
+    int result = mb_transaction_execute_view(master, &io.tx, slave_id, fc, pdu_length, &io.rx,
+                                             &resp_fc, &pdu_response, &pdu_resp_length);
     if (result != MB_SUCCESS) {
-        master->stats.total_requests++;
         return result;
     }
 
-    // Update statistics
-    master->stats.total_requests++;
-    master->stats.total_requests++;
-    master->stats.total_chars_sent += frame_length;
-    master->stats.total_chars_recv += received;
-
-    return MB_SUCCESS;
+    // Parse write response
+    return mb_parse_write_response(resp_fc, pdu_response, pdu_resp_length, start_addr, quantity,
+                                   NULL);
 }
 
 void mb_master_get_stats(const mb_master_t *master, mb_stats_t *stats) {
@@ -617,13 +1022,8 @@ void mb_master_cleanup(mb_master_t *master) {
         return;
     }
 
-    // TODO: Free any dynamically allocated resources
-    // In static mode, just reset pool counters
-#ifdef MB_USE_STATIC_MEMORY
-    master->block_pool_used = 0;
-    master->pdu_pool_used   = 0;
-    master->plan_pool_used  = 0;
-#endif
+    // Nothing to free: the master owns no heap memory (each call releases its
+    // working memory, and the scratch arena belongs to the caller)
 }
 
 const char *mb_get_version(void) {
@@ -0,0 +1,345 @@
+/**
+ * @file metrics.c
+ * @brief Per-slave, per-function-code transaction metrics implementation
+ *
+ * Bucket i < 8 holds exactly i us. Above that, a value with its highest
+ * set bit at position e >= 3 lands in one of four buckets for that power
+ * of two, chosen by the two bits below the highest one, so a bucket spans
+ * a quarter of its power of two at most.
+ *
+ * Series are kept sorted by (slave, function code) and found by binary
+ * search, as profile table entries are.
+ */
+
+#include "smartmodbus/mb_metrics.h"
+#include "smartmodbus/mb_error.h"
+#include "../core/fc_policy.h"
+
+#include <string.h>
+
+// Values below this get a bucket each
+#define METRICS_LINEAR 8
+
+// Buckets per power of two above METRICS_LINEAR (2 sub-bucket bits)
+#define METRICS_SUB_BUCKETS 4
+
+// Largest quantity of any read function code (FC01/02)
+#define METRICS_MAX_UNITS 2000
+
+static inline uint32_t highest_bit(uint32_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 31u - (uint32_t)__builtin_clz(value);
+#else
+    uint32_t index = 0;
+    while (value >>= 1) {
+        index++;
+    }
+    return index;
+#endif
+}
+
+static inline uint32_t count_bits(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint32_t)__builtin_popcountll(value);
+#else
+    uint32_t count = 0;
+    for (; value != 0; value &= value - 1) {
+        count++;
+    }
+    return count;
+#endif
+}
+
+static inline uint16_t series_key(uint8_t slave_id, uint8_t fc) {
+    return (uint16_t)(((uint16_t)slave_id << 8) | fc);
+}
+
+/**
+ * @brief Index of the first series not ordered before (slave_id, fc)
+ */
+static uint16_t series_search(const mb_metrics_t *metrics, uint16_t key) {
+    uint16_t lo = 0;
+    uint16_t hi = metrics->count;
+
+    while (lo < hi) {
+        uint16_t mid                    = (uint16_t)(lo + (hi - lo) / 2);
+        const mb_metrics_series_t *item = &metrics->series[mid];
+        if (series_key(item->slave_id, item->function_code) < key) {
+            lo = (uint16_t)(mid + 1);
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+int mb_metrics_init(mb_metrics_t *metrics, mb_metrics_series_t *series, uint16_t capacity) {
+    if (metrics == NULL || (series == NULL && capacity > 0)) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    metrics->series   = series;
+    metrics->capacity = capacity;
+    metrics->count    = 0;
+    metrics->dropped  = 0;
+    return MB_SUCCESS;
+}
+
+void mb_metrics_reset(mb_metrics_t *metrics) {
+    if (metrics == NULL) {
+        return;
+    }
+
+    metrics->count   = 0;
+    metrics->dropped = 0;
+}
+
+mb_metrics_series_t *mb_metrics_find(const mb_metrics_t *metrics, uint8_t slave_id, uint8_t fc) {
+    if (metrics == NULL) {
+        return NULL;
+    }
+
+    uint16_t key   = series_key(slave_id, fc);
+    uint16_t index = series_search(metrics, key);
+    if (index < metrics->count &&
+        series_key(metrics->series[index].slave_id, metrics->series[index].function_code) == key) {
+        return &metrics->series[index];
+    }
+    return NULL;
+}
+
+mb_metrics_series_t *mb_metrics_acquire(mb_metrics_t *metrics, uint8_t slave_id, uint8_t fc) {
+    if (metrics == NULL) {
+        return NULL;
+    }
+
+    uint16_t key   = series_key(slave_id, fc);
+    uint16_t index = series_search(metrics, key);
+    if (index < metrics->count &&
+        series_key(metrics->series[index].slave_id, metrics->series[index].function_code) == key) {
+        return &metrics->series[index];
+    }
+
+    if (metrics->count >= metrics->capacity) {
+        metrics->dropped++;
+        return NULL;
+    }
+
+    memmove(&metrics->series[index + 1], &metrics->series[index],
+            (size_t)(metrics->count - index) * sizeof(mb_metrics_series_t));
+    metrics->count++;
+
+    mb_metrics_series_t *series = &metrics->series[index];
+    memset(series, 0, sizeof(*series));
+    series->slave_id      = slave_id;
+    series->function_code = fc;
+    return series;
+}
+
+void mb_metrics_record_request(mb_metrics_t *metrics,
+                               uint8_t slave_id,
+                               uint8_t fc,
+                               uint32_t chars) {
+    mb_metrics_series_t *series = mb_metrics_acquire(metrics, slave_id, fc);
+    if (series == NULL) {
+        return;
+    }
+
+    series->requests++;
+    series->chars_sent += chars;
+}
+
+void mb_metrics_record_response(mb_metrics_t *metrics,
+                                uint8_t slave_id,
+                                uint8_t fc,
+                                int result,
+                                bool exception,
+                                uint32_t chars,
+                                uint32_t rtt_us) {
+    mb_metrics_series_t *series = mb_metrics_acquire(metrics, slave_id, fc);
+    if (series == NULL) {
+        return;
+    }
+
+    series->chars_recv += chars;
+
+    switch (result) {
+    case MB_SUCCESS:
+        break;
+    case MB_ERROR_TIMEOUT:
+        series->timeouts++;
+        return;
+    case MB_ERROR_CRC_MISMATCH:
+    case MB_ERROR_LRC_MISMATCH:
+        series->crc_errors++;
+        return;
+    default:
+        series->frame_errors++;
+        return;
+    }
+
+    series->responses++;
+    if (exception) {
+        series->exceptions++;
+    }
+
+    if (rtt_us != MB_METRICS_UNTIMED) {
+        series->rtt_buckets[mb_metrics_bucket(rtt_us)]++;
+        series->rtt_count++;
+        series->rtt_sum_us += rtt_us;
+        if (rtt_us > series->rtt_max_us) {
+            series->rtt_max_us = rtt_us;
+        }
+    }
+}
+
+void mb_metrics_record_plans(mb_metrics_t *metrics,
+                             const mb_request_plan_t *plans,
+                             uint16_t plan_count,
+                             const mb_scatter_entry_t *scatter) {
+    if (metrics == NULL || plans == NULL || scatter == NULL) {
+        return;
+    }
+
+    uint64_t requested[(METRICS_MAX_UNITS + 63) / 64];
+
+    for (uint16_t p = 0; p < plan_count; p++) {
+        const mb_request_plan_t *plan = &plans[p];
+        uint16_t quantity = plan->quantity < METRICS_MAX_UNITS ? plan->quantity
+                                                               : METRICS_MAX_UNITS;
+        uint16_t words    = (uint16_t)((quantity + 63) / 64);
+        memset(requested, 0, words * sizeof(uint64_t));
+
+        // Duplicate addresses map to the same unit
+        for (uint16_t i = 0; i < plan->scatter_count; i++) {
+            uint16_t offset = scatter[plan->scatter_first + i].offset;
+            if (offset < quantity) {
+                requested[offset / 64] |= 1ULL << (offset % 64);
+            }
+        }
+
+        uint32_t units = 0;
+        uint32_t runs  = 0;
+        uint64_t carry = 0;
+        for (uint16_t w = 0; w < words; w++) {
+            units += count_bits(requested[w]);
+            runs  += count_bits(requested[w] & ~((requested[w] << 1) | carry));
+            carry  = requested[w] >> 63;
+        }
+
+        mb_metrics_series_t *series = mb_metrics_acquire(metrics, plan->slave_id,
+                                                         plan->function_code);
+        if (series == NULL) {
+            continue;
+        }
+
+        if (mb_fc_get_unit_size(plan->function_code) == 1) {
+            series->gap_bytes += (uint32_t)(quantity + 7) / 8 - (units + 7) / 8;
+        } else {
+            series->gap_bytes += 2u * (quantity - units);
+        }
+        if (runs > 1) {
+            series->rounds_saved += runs - 1;
+        }
+    }
+}
+
+uint8_t mb_metrics_bucket(uint32_t us) {
+    if (us < METRICS_LINEAR) {
+        return (uint8_t)us;
+    }
+
+    uint32_t e     = highest_bit(us);
+    uint32_t sub   = (us >> (e - 2)) & (METRICS_SUB_BUCKETS - 1);
+    uint32_t index = METRICS_LINEAR + (e - 3) * METRICS_SUB_BUCKETS + sub;
+    return (uint8_t)(index < MB_METRICS_BUCKETS ? index : MB_METRICS_BUCKETS - 1);
+}
+
+uint32_t mb_metrics_bucket_limit(uint8_t bucket) {
+    if (bucket < METRICS_LINEAR) {
+        return (uint32_t)bucket + 1;
+    }
+    if (bucket >= MB_METRICS_BUCKETS - 1) {
+        return UINT32_MAX;
+    }
+
+    uint32_t e   = 3u + (uint32_t)(bucket - METRICS_LINEAR) / METRICS_SUB_BUCKETS;
+    uint32_t sub = (uint32_t)(bucket - METRICS_LINEAR) % METRICS_SUB_BUCKETS;
+    return (METRICS_SUB_BUCKETS + sub + 1) << (e - 2);
+}
+
+uint32_t mb_metrics_percentile(const mb_metrics_series_t *series, uint16_t permille) {
+    if (series == NULL || series->rtt_count == 0) {
+        return 0;
+    }
+    if (permille > 1000) {
+        permille = 1000;
+    }
+
+    // Rank of the sample at the percentile, 1-based and rounded up
+    uint64_t rank = ((uint64_t)series->rtt_count * permille + 999) / 1000;
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (uint8_t b = 0; b < MB_METRICS_BUCKETS; b++) {
+        seen += series->rtt_buckets[b];
+        if (seen >= rank) {
+            uint32_t upper = mb_metrics_bucket_limit(b) - 1;
+            return upper < series->rtt_max_us ? upper : series->rtt_max_us;
+        }
+    }
+    return series->rtt_max_us;
+}
+
+int mb_metrics_snapshot(const mb_metrics_t *metrics,
+                        mb_metrics_series_t *series,
+                        uint16_t capacity,
+                        uint16_t *count) {
+    if (metrics == NULL || (series == NULL && capacity > 0) || count == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    uint16_t n = metrics->count < capacity ? metrics->count : capacity;
+    if (n > 0) {
+        memcpy(series, metrics->series, n * sizeof(mb_metrics_series_t));
+    }
+    *count = n;
+    return n == metrics->count ? MB_SUCCESS : MB_ERROR_BUFFER_TOO_SMALL;
+}
+
+void mb_metrics_total(const mb_metrics_series_t *series,
+                      uint16_t count,
+                      mb_metrics_series_t *total) {
+    if (total == NULL) {
+        return;
+    }
+
+    memset(total, 0, sizeof(*total));
+    if (series == NULL) {
+        return;
+    }
+
+    for (uint16_t i = 0; i < count; i++) {
+        const mb_metrics_series_t *s = &series[i];
+        total->requests     += s->requests;
+        total->responses    += s->responses;
+        total->exceptions   += s->exceptions;
+        total->timeouts     += s->timeouts;
+        total->crc_errors   += s->crc_errors;
+        total->frame_errors += s->frame_errors;
+        total->chars_sent   += s->chars_sent;
+        total->chars_recv   += s->chars_recv;
+        total->gap_bytes    += s->gap_bytes;
+        total->rounds_saved += s->rounds_saved;
+        total->rtt_count    += s->rtt_count;
+        total->rtt_sum_us   += s->rtt_sum_us;
+        if (s->rtt_max_us > total->rtt_max_us) {
+            total->rtt_max_us = s->rtt_max_us;
+        }
+        for (uint8_t b = 0; b < MB_METRICS_BUCKETS; b++) {
+            total->rtt_buckets[b] += s->rtt_buckets[b];
+        }
+    }
+}
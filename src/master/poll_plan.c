@@ -0,0 +1,1034 @@
+/**
+ * @file poll_plan.c
+ * @brief Compiled, reusable poll plans
+ *
+ * A poll plan runs the optimizer once and keeps everything a cyclic poll
+ * needs: plans with prebuilt request frames, expected response lengths and
+ * the scatter map. Executing it performs no optimization and no allocation.
+ * Adding or removing a tag re-plans only the plans within one request's
+ * reach of it. A compiled plan can be saved as a snapshot image and loaded
+ * at the next start without running the optimizer. A plan can also be
+ * ordered and executed as one time-synchronized read of all its slaves.
+ */
+
+#include "smartmodbus/smartmodbus.h"
+#include "smartmodbus/mb_error.h"
+#include "request_optimizer.h"
+#include "response_parser.h"
+#include "transaction.h"
+#include "../core/char_model.h"
+#include "../core/fc_policy.h"
+#include "../protocol/frame_builder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Data bytes carried by a read response for a plan
+ */
+static uint16_t read_response_data_bytes(uint8_t fc, uint16_t quantity) {
+    if (fc == MB_FC_READ_COILS || fc == MB_FC_READ_DISCRETE_INPUTS) {
+        return (uint16_t)((quantity + 7) / 8);
+    }
+    return (uint16_t)(quantity * 2);
+}
+
+static uint8_t *plan_frame_storage(mb_poll_plan_t *poll, uint16_t plan_index) {
+#ifdef MB_USE_STATIC_MEMORY
+    return poll->frames[plan_index];
+#else
+    return &poll->frames[(size_t)plan_index * MB_PLAN_FRAME_CHARS];
+#endif
+}
+
+/**
+ * @brief Reset a poll plan and reserve storage for address_count outputs
+ * @return Plan capacity, or 0 on failure (storage released)
+ */
+static uint16_t poll_plan_reserve(mb_poll_plan_t *poll, mb_mode_t mode, uint16_t address_count) {
+    memset(poll, 0, sizeof(*poll));
+    poll->mode          = mode;
+    poll->address_count = address_count;
+
+    // Every plan covers at least one requested address
+    uint16_t max_plans = address_count;
+
+#ifdef MB_USE_STATIC_MEMORY
+    if (address_count > MB_MAX_SCATTER) {
+        return 0;
+    }
+    if (max_plans > MB_MAX_PLANS) {
+        max_plans = MB_MAX_PLANS;
+    }
+#else
+    poll->plans   = (mb_request_plan_t *)malloc(max_plans * sizeof(mb_request_plan_t));
+    poll->scatter = (mb_scatter_entry_t *)malloc(address_count * sizeof(mb_scatter_entry_t));
+    if (poll->plans == NULL || poll->scatter == NULL) {
+        mb_poll_plan_free(poll);
+        return 0;
+    }
+#endif
+
+    return max_plans;
+}
+
+/**
+ * @brief Prebuild one plan's request frame and expected response length
+ */
+static int build_plan_frame(mb_poll_plan_t *poll, uint16_t plan_index) {
+    mb_request_plan_t *plan = &poll->plans[plan_index];
+    uint8_t *frame          = plan_frame_storage(poll, plan_index);
+
+    uint8_t pdu[4];
+    pdu[0] = (uint8_t)((plan->start_address >> 8) & 0xFF);
+    pdu[1] = (uint8_t)(plan->start_address & 0xFF);
+    pdu[2] = (uint8_t)((plan->quantity >> 8) & 0xFF);
+    pdu[3] = (uint8_t)(plan->quantity & 0xFF);
+
+    // TCP transaction ID is patched per send
+    uint16_t frame_length = 0;
+    int result = mb_build_frame(plan->slave_id, plan->function_code, pdu, sizeof(pdu), poll->mode,
+                                0, frame, MB_PLAN_FRAME_CHARS, &frame_length);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    // Response PDU: byte count + data
+    uint16_t data_bytes = read_response_data_bytes(plan->function_code, plan->quantity);
+
+    plan->frame_data               = frame;
+    plan->frame_length             = frame_length;
+    plan->expected_response_length = mb_calc_frame_length((uint16_t)(1 + data_bytes), poll->mode);
+    return MB_SUCCESS;
+}
+
+/**
+ * @brief Allocate frame storage for plan_count plans
+ */
+static int poll_plan_frames(mb_poll_plan_t *poll, uint16_t plan_count) {
+    poll->plan_count = plan_count;
+
+#ifndef MB_USE_STATIC_MEMORY
+    poll->frames = (uint8_t *)malloc((size_t)plan_count * MB_PLAN_FRAME_CHARS);
+    if (poll->frames == NULL) {
+        return MB_ERROR_NO_MEMORY;
+    }
+#endif
+    return MB_SUCCESS;
+}
+
+/**
+ * @brief Prebuild request frames and expected lengths for optimized plans
+ */
+static int poll_plan_finish(mb_poll_plan_t *poll, uint16_t plan_count) {
+    int result = poll_plan_frames(poll, plan_count);
+
+    for (uint16_t i = 0; result == MB_SUCCESS && i < plan_count; i++) {
+        result = build_plan_frame(poll, i);
+    }
+    return result;
+}
+
+int mb_poll_plan_compile(const mb_master_t *master,
+                         const mb_read_request_t *request,
+                         mb_poll_plan_t *poll) {
+    if (master == NULL || request == NULL || poll == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (request->addresses == NULL || request->address_count == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    uint16_t max_plans = poll_plan_reserve(poll, master->config.mode, request->address_count);
+    if (max_plans == 0) {
+#ifdef MB_USE_STATIC_MEMORY
+        return MB_ERROR_TOO_MANY_BLOCKS;
+#else
+        return MB_ERROR_NO_MEMORY;
+#endif
+    }
+
+    // Optimize once
+    uint16_t plan_count = 0;
+    int result = mb_optimize_request(request, &master->config, poll->plans, max_plans, &plan_count,
+                                     poll->scatter, NULL);
+    if (result == MB_SUCCESS) {
+        result = poll_plan_finish(poll, plan_count);
+    }
+
+    if (result != MB_SUCCESS) {
+        mb_poll_plan_free(poll);
+    }
+    return result;
+}
+
+int mb_poll_plan_compile_batch(const mb_master_t *master,
+                               const mb_tag_t *tags,
+                               uint16_t tag_count,
+                               mb_poll_plan_t *poll) {
+    if (master == NULL || tags == NULL || poll == NULL || tag_count == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    uint16_t max_plans = poll_plan_reserve(poll, master->config.mode, tag_count);
+    if (max_plans == 0) {
+#ifdef MB_USE_STATIC_MEMORY
+        return MB_ERROR_TOO_MANY_BLOCKS;
+#else
+        return MB_ERROR_NO_MEMORY;
+#endif
+    }
+
+    uint16_t plan_count = 0;
+    int result = mb_optimize_batch(tags, tag_count, &master->config, poll->plans, max_plans,
+                                   &plan_count, poll->scatter, NULL);
+    if (result == MB_SUCCESS) {
+        result = poll_plan_finish(poll, plan_count);
+    }
+
+    if (result != MB_SUCCESS) {
+        mb_poll_plan_free(poll);
+    }
+    return result;
+}
+
+/**
+ * @brief Move a freshly compiled plan into poll, releasing the old storage
+ */
+static void poll_plan_adopt(mb_poll_plan_t *poll, const mb_poll_plan_t *fresh) {
+    mb_poll_plan_free(poll);
+    *poll = *fresh;
+
+#ifdef MB_USE_STATIC_MEMORY
+    // Embedded frames moved with the structure
+    for (uint16_t i = 0; i < poll->plan_count; i++) {
+        poll->plans[i].frame_data = plan_frame_storage(poll, i);
+    }
+#endif
+}
+
+int mb_poll_plan_refresh(const mb_master_t *master, mb_poll_plan_t *poll) {
+    if (master == NULL || poll == NULL || poll->plan_count == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    // The scatter map still knows every output slot's tag
+    mb_tag_t *tags = NULL;
+#ifdef MB_USE_STATIC_MEMORY
+    mb_tag_t static_tags[MB_MAX_SCATTER];
+    tags = static_tags;
+#else
+    tags = (mb_tag_t *)malloc(poll->address_count * sizeof(mb_tag_t));
+    if (tags == NULL) {
+        return MB_ERROR_NO_MEMORY;
+    }
+#endif
+
+    for (uint16_t i = 0; i < poll->address_count; i++) {
+        const mb_scatter_entry_t *entry = &poll->scatter[i];
+        const mb_request_plan_t *plan   = &poll->plans[entry->plan_index];
+
+        tags[entry->dest_index].slave_id      = plan->slave_id;
+        tags[entry->dest_index].function_code = plan->function_code;
+        tags[entry->dest_index].address       = (uint16_t)(plan->start_address + entry->offset);
+    }
+
+    mb_poll_plan_t fresh;
+    int result = mb_poll_plan_compile_batch(master, tags, poll->address_count, &fresh);
+    if (result == MB_SUCCESS) {
+        poll_plan_adopt(poll, &fresh);
+    }
+
+#ifndef MB_USE_STATIC_MEMORY
+    free(tags);
+#endif
+    return result;
+}
+
+/**
+ * @brief Whether a plan takes part in re-planning around an address
+ *
+ * Blocks further apart than one request can carry never share a PDU, so a
+ * tag change cannot alter plans of its group beyond that reach.
+ */
+static bool in_neighbourhood(const mb_request_plan_t *plan,
+                             uint8_t slave_id,
+                             uint8_t fc,
+                             uint16_t address) {
+    uint32_t reach = mb_fc_get_max_quantity(fc);
+    uint32_t end   = (uint32_t)plan->start_address + plan->quantity;
+
+    return plan->slave_id == slave_id && plan->function_code == fc &&
+           plan->start_address < address + reach && end + reach > address;
+}
+
+/**
+ * @brief Append a plan and its scatter entries to a poll plan being rebuilt
+ * @param entries Scatter map the plan's scatter_first indexes
+ * @param slots Output slot of each dest_index, or NULL when they are slots
+ * @param removed Output slot being dropped, or UINT16_MAX
+ * @param scatter In/out: scatter entries filled so far
+ */
+static void append_plan(mb_poll_plan_t *fresh,
+                        uint16_t out,
+                        const mb_request_plan_t *plan,
+                        const mb_scatter_entry_t *entries,
+                        const uint16_t *slots,
+                        uint16_t removed,
+                        uint16_t *scatter) {
+    fresh->plans[out]               = *plan;
+    fresh->plans[out].scatter_first = *scatter;
+
+    for (uint16_t e = 0; e < plan->scatter_count; e++) {
+        mb_scatter_entry_t entry = entries[plan->scatter_first + e];
+        uint16_t slot            = slots != NULL ? slots[entry.dest_index] : entry.dest_index;
+
+        // Later slots move down over a removed one
+        entry.plan_index             = out;
+        entry.dest_index             = slot > removed ? (uint16_t)(slot - 1) : slot;
+        fresh->scatter[*scatter + e] = entry;
+    }
+    *scatter = (uint16_t)(*scatter + plan->scatter_count);
+}
+
+/**
+ * @brief Re-plan the neighbourhood of one address and splice it into poll
+ * @param adding Append address as a new output slot
+ * @param removed Output slot to drop, or UINT16_MAX
+ *
+ * The neighbourhood's addresses go through mb_optimize_request() again;
+ * every other plan, its prebuilt frame and its scatter entries are copied
+ * over unchanged. The re-planned plans take the place of the first plan
+ * they replace, so the execution order of the others is kept.
+ */
+static int poll_plan_splice(const mb_master_t *master,
+                            mb_poll_plan_t *poll,
+                            uint8_t slave_id,
+                            uint8_t fc,
+                            uint16_t address,
+                            bool adding,
+                            uint16_t removed) {
+    // Addresses of the neighbourhood, after the change
+    uint16_t sub_count  = adding ? 1 : 0;
+    uint16_t first_plan = poll->plan_count;
+    uint16_t replaced   = 0;
+    for (uint16_t i = 0; i < poll->plan_count; i++) {
+        if (in_neighbourhood(&poll->plans[i], slave_id, fc, address)) {
+            first_plan = first_plan < i ? first_plan : i;
+            sub_count  = (uint16_t)(sub_count + poll->plans[i].scatter_count);
+            replaced++;
+        }
+    }
+    if (!adding) {
+        sub_count--;
+    }
+
+    uint16_t address_count = adding ? (uint16_t)(poll->address_count + 1)
+                                    : (uint16_t)(poll->address_count - 1);
+
+    uint16_t *sub_addresses         = NULL;
+    uint16_t *sub_slots             = NULL;
+    mb_request_plan_t *sub_plans    = NULL;
+    mb_scatter_entry_t *sub_scatter = NULL;
+#ifdef MB_USE_STATIC_MEMORY
+    uint16_t static_addresses[MB_MAX_SCATTER];
+    uint16_t static_slots[MB_MAX_SCATTER];
+    mb_request_plan_t static_plans[MB_MAX_PLANS];
+    mb_scatter_entry_t static_scatter[MB_MAX_SCATTER];
+    if (sub_count > MB_MAX_SCATTER) {
+        return MB_ERROR_TOO_MANY_BLOCKS;
+    }
+    sub_addresses      = static_addresses;
+    sub_slots          = static_slots;
+    sub_plans          = static_plans;
+    sub_scatter        = static_scatter;
+    uint16_t max_plans = sub_count < MB_MAX_PLANS ? sub_count : MB_MAX_PLANS;
+#else
+    size_t entries     = sub_count > 0 ? sub_count : 1;
+    sub_addresses      = (uint16_t *)malloc(entries * sizeof(uint16_t));
+    sub_slots          = (uint16_t *)malloc(entries * sizeof(uint16_t));
+    sub_plans          = (mb_request_plan_t *)malloc(entries * sizeof(mb_request_plan_t));
+    sub_scatter        = (mb_scatter_entry_t *)malloc(entries * sizeof(mb_scatter_entry_t));
+    uint16_t max_plans = sub_count;
+    if (sub_addresses == NULL || sub_slots == NULL || sub_plans == NULL || sub_scatter == NULL) {
+        free(sub_addresses);
+        free(sub_slots);
+        free(sub_plans);
+        free(sub_scatter);
+        return MB_ERROR_NO_MEMORY;
+    }
+#endif
+
+    uint16_t k = 0;
+    for (uint16_t i = 0; i < poll->plan_count; i++) {
+        const mb_request_plan_t *plan = &poll->plans[i];
+        if (!in_neighbourhood(plan, slave_id, fc, address)) {
+            continue;
+        }
+        for (uint16_t e = 0; e < plan->scatter_count; e++) {
+            const mb_scatter_entry_t *entry = &poll->scatter[plan->scatter_first + e];
+            if (entry->dest_index == removed) {
+                continue;
+            }
+            sub_addresses[k] = (uint16_t)(plan->start_address + entry->offset);
+            sub_slots[k]     = entry->dest_index;
+            k++;
+        }
+    }
+    if (adding) {
+        sub_addresses[k] = address;
+        sub_slots[k]     = poll->address_count;
+    }
+
+    // Merge and pack the neighbourhood alone
+    uint16_t sub_plan_count = 0;
+    int result              = MB_SUCCESS;
+    if (sub_count > 0) {
+        mb_read_request_t sub = {.slave_id      = slave_id,
+                                 .function_code = fc,
+                                 .addresses     = sub_addresses,
+                                 .address_count = sub_count};
+        result = mb_optimize_request(&sub, &master->config, sub_plans, max_plans, &sub_plan_count,
+                                     sub_scatter, NULL);
+    }
+
+    mb_poll_plan_t fresh;
+    uint16_t plan_count = (uint16_t)(poll->plan_count - replaced + sub_plan_count);
+    if (result == MB_SUCCESS) {
+        uint16_t capacity = poll_plan_reserve(&fresh, poll->mode, address_count);
+        if (capacity == 0) {
+#ifdef MB_USE_STATIC_MEMORY
+            result = MB_ERROR_TOO_MANY_BLOCKS;
+#else
+            result = MB_ERROR_NO_MEMORY;
+#endif
+        } else if (plan_count > capacity) {
+            mb_poll_plan_free(&fresh);
+            result = MB_ERROR_TOO_MANY_PLANS;
+        } else {
+            result = poll_plan_frames(&fresh, plan_count);
+        }
+    }
+
+    if (result == MB_SUCCESS) {
+        uint16_t out     = 0;
+        uint16_t scatter = 0;
+        for (uint16_t i = 0; i <= poll->plan_count && result == MB_SUCCESS; i++) {
+            if (i == first_plan) {
+                for (uint16_t j = 0; j < sub_plan_count && result == MB_SUCCESS; j++, out++) {
+                    append_plan(&fresh, out, &sub_plans[j], sub_scatter, sub_slots, removed,
+                                &scatter);
+                    result = build_plan_frame(&fresh, out);
+                }
+            }
+            if (i == poll->plan_count ||
+                in_neighbourhood(&poll->plans[i], slave_id, fc, address)) {
+                continue;
+            }
+
+            // Untouched plan: same request, same frame bytes
+            append_plan(&fresh, out, &poll->plans[i], poll->scatter, NULL, removed, &scatter);
+            fresh.plans[out].frame_data = plan_frame_storage(&fresh, out);
+            memcpy(fresh.plans[out].frame_data, poll->plans[i].frame_data,
+                   poll->plans[i].frame_length);
+            out++;
+        }
+
+        if (result == MB_SUCCESS) {
+            fresh.stale = poll->stale;
+            poll_plan_adopt(poll, &fresh);
+        } else {
+            mb_poll_plan_free(&fresh);
+        }
+    }
+
+#ifndef MB_USE_STATIC_MEMORY
+    free(sub_addresses);
+    free(sub_slots);
+    free(sub_plans);
+    free(sub_scatter);
+#endif
+    return result;
+}
+
+int mb_poll_plan_add(const mb_master_t *master,
+                     mb_poll_plan_t *poll,
+                     const mb_tag_t *tag,
+                     uint16_t *slot) {
+    if (master == NULL || poll == NULL || tag == NULL || poll->plan_count == 0 ||
+        poll->mode != master->config.mode || poll->address_count == UINT16_MAX) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+    if (tag->function_code < MB_FC_READ_COILS ||
+        tag->function_code > MB_FC_READ_INPUT_REGISTERS) {
+        return MB_ERROR_INVALID_FC;
+    }
+
+    uint16_t added = poll->address_count;
+    int result     = poll_plan_splice(master, poll, tag->slave_id, tag->function_code,
+                                      tag->address, true, UINT16_MAX);
+    if (result == MB_SUCCESS && slot != NULL) {
+        *slot = added;
+    }
+    return result;
+}
+
+int mb_poll_plan_remove(const mb_master_t *master, mb_poll_plan_t *poll, uint16_t slot) {
+    if (master == NULL || poll == NULL || poll->plan_count == 0 ||
+        poll->mode != master->config.mode || slot >= poll->address_count ||
+        poll->address_count == 1) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    // Find the slot's plan; its address centres the neighbourhood
+    for (uint16_t i = 0; i < poll->address_count; i++) {
+        const mb_scatter_entry_t *entry = &poll->scatter[i];
+        if (entry->dest_index == slot) {
+            const mb_request_plan_t *plan = &poll->plans[entry->plan_index];
+            return poll_plan_splice(master, poll, plan->slave_id, plan->function_code,
+                                    (uint16_t)(plan->start_address + entry->offset), false, slot);
+        }
+    }
+    return MB_ERROR_INVALID_PARAM;
+}
+
+/**
+ * @brief Plan record of a poll plan image (the plan without its frame pointer)
+ */
+typedef struct {
+    uint8_t slave_id;
+    uint8_t function_code;
+    uint16_t start_address;
+    uint16_t quantity;
+    uint16_t frame_length;
+    uint16_t expected_response_length;
+    uint16_t scatter_first;
+    uint16_t scatter_count;
+} poll_image_plan_t;
+
+static size_t poll_image_length(uint16_t plan_count, uint16_t address_count) {
+    size_t length = sizeof(mb_poll_image_t) + plan_count * sizeof(poll_image_plan_t) +
+                    address_count * sizeof(mb_scatter_entry_t) +
+                    (size_t)plan_count * MB_PLAN_FRAME_CHARS;
+    return (length + 3u) & ~(size_t)3u;
+}
+
+/**
+ * @brief FNV-1a over an image body
+ */
+static uint32_t poll_image_checksum(const uint8_t *bytes, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+size_t mb_poll_plan_image_size(const mb_poll_plan_t *poll) {
+    if (poll == NULL) {
+        return 0;
+    }
+    return poll_image_length(poll->plan_count, poll->address_count);
+}
+
+int mb_poll_plan_save(const mb_poll_plan_t *poll, uint32_t key, void *image, size_t size) {
+    if (poll == NULL || image == NULL || poll->plan_count == 0 ||
+        ((uintptr_t)image % sizeof(uint32_t)) != 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    size_t length = poll_image_length(poll->plan_count, poll->address_count);
+    if (size < length) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    uint8_t *bytes = (uint8_t *)image;
+    memset(bytes, 0, length);
+
+    uint8_t *records = bytes + sizeof(mb_poll_image_t);
+    uint8_t *scatter = records + poll->plan_count * sizeof(poll_image_plan_t);
+    uint8_t *frames  = scatter + poll->address_count * sizeof(mb_scatter_entry_t);
+
+    for (uint16_t i = 0; i < poll->plan_count; i++) {
+        const mb_request_plan_t *plan = &poll->plans[i];
+        poll_image_plan_t record;
+        memset(&record, 0, sizeof(record));
+        record.slave_id                 = plan->slave_id;
+        record.function_code            = plan->function_code;
+        record.start_address            = plan->start_address;
+        record.quantity                 = plan->quantity;
+        record.frame_length             = plan->frame_length;
+        record.expected_response_length = plan->expected_response_length;
+        record.scatter_first            = plan->scatter_first;
+        record.scatter_count            = plan->scatter_count;
+        memcpy(records + i * sizeof(record), &record, sizeof(record));
+        memcpy(frames + (size_t)i * MB_PLAN_FRAME_CHARS, plan->frame_data, plan->frame_length);
+    }
+    memcpy(scatter, poll->scatter, poll->address_count * sizeof(mb_scatter_entry_t));
+
+    mb_poll_image_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic         = MB_POLL_IMAGE_MAGIC;
+    header.version       = MB_POLL_IMAGE_VERSION;
+    header.mode          = (uint8_t)poll->mode;
+    header.stale         = poll->stale ? 1 : 0;
+    header.plan_count    = poll->plan_count;
+    header.address_count = poll->address_count;
+    header.key           = key;
+    header.checksum      = poll_image_checksum(records, length - sizeof(mb_poll_image_t));
+    memcpy(bytes, &header, sizeof(header));
+    return MB_SUCCESS;
+}
+
+/**
+ * @brief Whether a loaded plan's scatter range and frame are usable as is
+ */
+static bool poll_image_plan_valid(const mb_poll_plan_t *poll, uint16_t plan_index) {
+    const mb_request_plan_t *plan = &poll->plans[plan_index];
+    if (plan->frame_length == 0 || plan->frame_length > MB_PLAN_FRAME_CHARS ||
+        plan->quantity == 0 || plan->scatter_first > poll->address_count ||
+        plan->scatter_count > poll->address_count - plan->scatter_first) {
+        return false;
+    }
+
+    for (uint16_t k = 0; k < plan->scatter_count; k++) {
+        const mb_scatter_entry_t *entry = &poll->scatter[plan->scatter_first + k];
+        if (entry->plan_index != plan_index || entry->offset >= plan->quantity ||
+            entry->dest_index >= poll->address_count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int mb_poll_plan_load(const mb_master_t *master,
+                      mb_poll_plan_t *poll,
+                      const void *image,
+                      size_t size,
+                      uint32_t key) {
+    if (master == NULL || poll == NULL || image == NULL ||
+        ((uintptr_t)image % sizeof(uint32_t)) != 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+    if (size < sizeof(mb_poll_image_t)) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    const uint8_t *bytes = (const uint8_t *)image;
+    mb_poll_image_t header;
+    memcpy(&header, bytes, sizeof(header));
+
+    if (header.magic != MB_POLL_IMAGE_MAGIC) {
+        return MB_ERROR_INVALID_FRAME;
+    }
+    if (header.version != MB_POLL_IMAGE_VERSION || header.mode != (uint8_t)master->config.mode ||
+        header.key != key) {
+        return MB_ERROR_NOT_SUPPORTED;
+    }
+
+    size_t length = poll_image_length(header.plan_count, header.address_count);
+    if (header.plan_count == 0 || header.plan_count > header.address_count || length > size) {
+        return MB_ERROR_INVALID_FRAME;
+    }
+
+    const uint8_t *records = bytes + sizeof(mb_poll_image_t);
+    const uint8_t *scatter = records + header.plan_count * sizeof(poll_image_plan_t);
+    const uint8_t *frames  = scatter + header.address_count * sizeof(mb_scatter_entry_t);
+    if (poll_image_checksum(records, length - sizeof(mb_poll_image_t)) != header.checksum) {
+        return MB_ERROR_INVALID_FRAME;
+    }
+
+    uint16_t max_plans = poll_plan_reserve(poll, master->config.mode, header.address_count);
+    if (max_plans == 0) {
+#ifdef MB_USE_STATIC_MEMORY
+        return MB_ERROR_TOO_MANY_BLOCKS;
+#else
+        return MB_ERROR_NO_MEMORY;
+#endif
+    }
+
+    int result = header.plan_count > max_plans ? MB_ERROR_TOO_MANY_PLANS
+                                               : poll_plan_frames(poll, header.plan_count);
+    if (result == MB_SUCCESS) {
+        memcpy(poll->scatter, scatter, header.address_count * sizeof(mb_scatter_entry_t));
+        poll->stale = header.stale != 0;
+    }
+
+    for (uint16_t i = 0; result == MB_SUCCESS && i < header.plan_count; i++) {
+        poll_image_plan_t record;
+        memcpy(&record, records + i * sizeof(record), sizeof(record));
+
+        mb_request_plan_t *plan        = &poll->plans[i];
+        plan->slave_id                 = record.slave_id;
+        plan->function_code            = record.function_code;
+        plan->start_address            = record.start_address;
+        plan->quantity                 = record.quantity;
+        plan->frame_length             = record.frame_length;
+        plan->expected_response_length = record.expected_response_length;
+        plan->scatter_first            = record.scatter_first;
+        plan->scatter_count            = record.scatter_count;
+        plan->frame_data               = plan_frame_storage(poll, i);
+        memcpy(plan->frame_data, frames + (size_t)i * MB_PLAN_FRAME_CHARS, MB_PLAN_FRAME_CHARS);
+
+        if (!poll_image_plan_valid(poll, i)) {
+            result = MB_ERROR_INVALID_FRAME;
+        }
+    }
+
+    if (result != MB_SUCCESS) {
+        mb_poll_plan_free(poll);
+    }
+    return result;
+}
+
+/**
+ * @brief Send compiled plans once and scatter their responses
+ * @param learned Set when an exception response changed a device profile
+ */
+static int execute_compiled(mb_master_t *master,
+                            const mb_request_plan_t *plans,
+                            uint16_t plan_count,
+                            const mb_scatter_entry_t *scatter,
+                            uint16_t *data_buffer,
+                            bool *learned) {
+    mb_scatter_ctx_t scatter_ctx;
+    scatter_ctx.plans       = plans;
+    scatter_ctx.scatter     = scatter;
+    scatter_ctx.data_buffer = data_buffer;
+    scatter_ctx.profiles    = master->config.profiles;
+    scatter_ctx.learned     = false;
+    scatter_ctx.bits        = NULL;
+    scatter_ctx.typed_tags  = NULL;
+    scatter_ctx.routes      = NULL;
+
+    int result = mb_transaction_execute_plans(master, plans, plan_count, mb_scatter_plan_response,
+                                              &scatter_ctx);
+    *learned = scatter_ctx.learned;
+    return result;
+}
+
+/**
+ * @brief Account a successful compiled poll
+ */
+static void record_compiled(mb_master_t *master,
+                            const mb_request_plan_t *plans,
+                            uint16_t plan_count,
+                            const mb_scatter_entry_t *scatter,
+                            uint16_t address_count) {
+    master->stats.optimized_requests++;
+    master->stats.blocks_merged += (uint32_t)(address_count - plan_count);
+    mb_metrics_record_plans(master->config.metrics, plans, plan_count, scatter);
+}
+
+int mb_master_execute_poll(mb_master_t *master,
+                           mb_poll_plan_t *poll,
+                           uint16_t *data_buffer,
+                           uint16_t buffer_size) {
+    if (master == NULL || poll == NULL || data_buffer == NULL || poll->plan_count == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    // Frames were built for a specific framing
+    if (poll->mode != master->config.mode) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (buffer_size < poll->address_count) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    int result = MB_SUCCESS;
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        // A plan that failed to refresh keeps its old layout
+        if (poll->stale && mb_poll_plan_refresh(master, poll) == MB_SUCCESS) {
+            poll->stale = false;
+        }
+
+        bool learned = false;
+        result = execute_compiled(master, poll->plans, poll->plan_count, poll->scatter,
+                                  data_buffer, &learned);
+        if (result != MB_ERROR_EXCEPTION_RESPONSE || !learned) {
+            break;
+        }
+        poll->stale = true;
+    }
+
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    record_compiled(master, poll->plans, poll->plan_count, poll->scatter, poll->address_count);
+    return MB_SUCCESS;
+}
+
+int mb_master_execute_static_poll(mb_master_t *master,
+                                  const mb_static_poll_t *poll,
+                                  uint16_t *data_buffer,
+                                  uint16_t buffer_size) {
+    if (master == NULL || poll == NULL || data_buffer == NULL || poll->plans == NULL ||
+        poll->scatter == NULL || poll->plan_count == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (poll->mode != master->config.mode) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (buffer_size < poll->address_count) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    bool learned = false;
+    int result   = execute_compiled(master, poll->plans, poll->plan_count, poll->scatter,
+                                    data_buffer, &learned);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    record_compiled(master, poll->plans, poll->plan_count, poll->scatter, poll->address_count);
+    return MB_SUCCESS;
+}
+
+/**
+ * @brief Sort key of a plan for a synchronized read: round, then cost
+ */
+static uint32_t synced_key(const mb_master_t *master,
+                           const mb_request_plan_t *plan,
+                           uint16_t round,
+                           bool longest_first) {
+    mb_block_t block;
+    memset(&block, 0, sizeof(block));
+    block.slave_id      = plan->slave_id;
+    block.function_code = plan->function_code;
+    block.start_address = plan->start_address;
+    block.quantity      = plan->quantity;
+
+    const mb_config_t *config = &master->config;
+    uint8_t latency = mb_profile_latency_chars(config->profiles, plan->slave_id,
+                                               config->latency_chars);
+
+    uint16_t cost = mb_calc_request_cost(&block, config->mode, config->gap_chars, latency);
+    if (longest_first) {
+        cost = (uint16_t)(UINT16_MAX - cost);
+    }
+    return ((uint32_t)round << 16) | cost;
+}
+
+int mb_poll_plan_order_synced(const mb_master_t *master, mb_poll_plan_t *poll) {
+    if (master == NULL || poll == NULL || poll->plan_count == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    uint16_t plan_count = poll->plan_count;
+#ifdef MB_USE_STATIC_MEMORY
+    uint32_t keys[MB_MAX_PLANS];
+#else
+    uint32_t *keys = (uint32_t *)malloc(plan_count * sizeof(uint32_t));
+    if (keys == NULL) {
+        return MB_ERROR_NO_MEMORY;
+    }
+#endif
+
+    // A slave's r-th plan belongs to round r
+    uint16_t rounds[256] = {0};
+    bool longest_first   = master->config.mode == MB_MODE_TCP && master->config.max_in_flight > 1;
+    for (uint16_t i = 0; i < plan_count; i++) {
+        const mb_request_plan_t *plan = &poll->plans[i];
+        keys[i] = synced_key(master, plan, rounds[plan->slave_id]++, longest_first);
+    }
+
+    // Stable insertion sort: equal keys keep the compiled order
+    for (uint16_t i = 1; i < plan_count; i++) {
+        uint32_t key           = keys[i];
+        mb_request_plan_t plan = poll->plans[i];
+        uint16_t j             = i;
+        while (j > 0 && keys[j - 1] > key) {
+            keys[j]        = keys[j - 1];
+            poll->plans[j] = poll->plans[j - 1];
+            j--;
+        }
+        keys[j]        = key;
+        poll->plans[j] = plan;
+    }
+
+#ifndef MB_USE_STATIC_MEMORY
+    free(keys);
+#endif
+
+    // Scatter ranges move with their plans; frames are rebuilt in their new slots
+    int result = MB_SUCCESS;
+    for (uint16_t i = 0; result == MB_SUCCESS && i < plan_count; i++) {
+        const mb_request_plan_t *plan = &poll->plans[i];
+        for (uint16_t k = 0; k < plan->scatter_count; k++) {
+            poll->scatter[plan->scatter_first + k].plan_index = i;
+        }
+        result = build_plan_frame(poll, i);
+    }
+    return result;
+}
+
+/**
+ * @brief Placeholder result of a plan not answered yet (never an error code)
+ */
+#define SYNCED_PENDING 1
+
+/**
+ * @brief Context of a synchronized read
+ */
+typedef struct {
+    mb_scatter_ctx_t scatter;        /**< Scatter over the whole poll plan */
+    const mb_transport_t *transport; /**< Clock of the stamps */
+    mb_synced_stamp_t *stamps;       /**< One per plan */
+    uint16_t offset;                 /**< Plan index of the executed array's first plan */
+} synced_ctx_t;
+
+/**
+ * @brief Stamp and scatter a response; a rejected plan does not end the read
+ */
+static int synced_response(void *ctx,
+                           uint16_t plan_index,
+                           uint8_t fc,
+                           const uint8_t *pdu_data,
+                           uint16_t pdu_length) {
+    synced_ctx_t *synced     = (synced_ctx_t *)ctx;
+    mb_synced_stamp_t *stamp = &synced->stamps[synced->offset + plan_index];
+
+    stamp->stamp_us = synced->transport->clock_us(synced->transport->context);
+    stamp->result   = mb_scatter_plan_response(&synced->scatter,
+                                               (uint16_t)(synced->offset + plan_index), fc,
+                                               pdu_data, pdu_length);
+    return MB_SUCCESS;
+}
+
+int mb_master_execute_synced(mb_master_t *master,
+                             mb_poll_plan_t *poll,
+                             uint16_t *data_buffer,
+                             uint16_t buffer_size,
+                             mb_synced_stamp_t *stamps,
+                             uint16_t stamp_capacity,
+                             mb_synced_timing_t *timing) {
+    if (master == NULL || poll == NULL || data_buffer == NULL || stamps == NULL ||
+        poll->plan_count == 0 || master->config.transport.clock_us == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (poll->mode != master->config.mode) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    // Re-planning forgets the order: put it back
+    if (poll->stale && mb_poll_plan_refresh(master, poll) == MB_SUCCESS) {
+        poll->stale = false;
+        int result  = mb_poll_plan_order_synced(master, poll);
+        if (result != MB_SUCCESS) {
+            return result;
+        }
+    }
+
+    if (buffer_size < poll->address_count || stamp_capacity < poll->plan_count) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    synced_ctx_t synced;
+    memset(&synced, 0, sizeof(synced));
+    synced.scatter.plans       = poll->plans;
+    synced.scatter.scatter     = poll->scatter;
+    synced.scatter.data_buffer = data_buffer;
+    synced.scatter.profiles    = master->config.profiles;
+    synced.transport           = &master->config.transport;
+    synced.stamps              = stamps;
+
+    for (uint16_t i = 0; i < poll->plan_count; i++) {
+        stamps[i].stamp_us = 0;
+        stamps[i].result   = SYNCED_PENDING;
+    }
+
+    const mb_transport_t *transport = &master->config.transport;
+    uint32_t start_us               = transport->clock_us(transport->context);
+
+    // An execution stops at a plan that got no usable frame. It and the
+    // requests abandoned with it (TCP pipelining) fail; the read goes on with
+    // the plans not sent yet, so no plan is sent twice
+    uint16_t next = 0;
+    while (next < poll->plan_count) {
+        mb_plans_report_t report;
+        synced.offset = next;
+        int result    = mb_transaction_execute_plans_report(master, &poll->plans[next],
+                                                            (uint16_t)(poll->plan_count - next),
+                                                            synced_response, &synced, &report);
+        if (result == MB_SUCCESS) {
+            break;
+        }
+
+        uint32_t now_us = transport->clock_us(transport->context);
+        uint16_t end    = (uint16_t)(next + report.attempted);
+        for (uint16_t i = next; i < end; i++) {
+            if (stamps[i].result == SYNCED_PENDING) {
+                stamps[i].stamp_us = now_us;
+                stamps[i].result   = result;
+            }
+        }
+        next = end;
+    }
+    uint32_t end_us = transport->clock_us(transport->context);
+
+    if (synced.scatter.learned) {
+        poll->stale = true;
+    }
+
+    uint16_t answered = 0;
+    uint32_t first_us = 0;
+    uint32_t last_us  = 0;
+    int failure       = MB_SUCCESS;
+    for (uint16_t i = 0; i < poll->plan_count; i++) {
+        if (stamps[i].result != MB_SUCCESS) {
+            if (failure == MB_SUCCESS) {
+                failure = stamps[i].result;
+            }
+            continue;
+        }
+        uint32_t since = stamps[i].stamp_us - start_us;
+        if (answered == 0 || since < first_us) {
+            first_us = since;
+        }
+        if (answered == 0 || since > last_us) {
+            last_us = since;
+        }
+        answered++;
+    }
+
+    if (timing != NULL) {
+        timing->start_us = start_us;
+        timing->span_us  = end_us - start_us;
+        timing->skew_us  = last_us - first_us;
+        timing->answered = answered;
+    }
+
+    if (failure == MB_SUCCESS) {
+        record_compiled(master, poll->plans, poll->plan_count, poll->scatter,
+                        poll->address_count);
+        return MB_SUCCESS;
+    }
+    return answered > 0 ? MB_ERROR_PARTIAL_RESULT : failure;
+}
+
+void mb_poll_plan_free(mb_poll_plan_t *poll) {
+    if (poll == NULL) {
+        return;
+    }
+
+#ifndef MB_USE_STATIC_MEMORY
+    free(poll->plans);
+    free(poll->scatter);
+    free(poll->frames);
+    poll->plans   = NULL;
+    poll->scatter = NULL;
+    poll->frames  = NULL;
+#endif
+
+    poll->plan_count    = 0;
+    poll->address_count = 0;
+}
@@ -1,24 +1,357 @@
 /**
  * @file request_optimizer.c
- * @brief Request optimization pipeline implementation (stub)
+ * @brief Request optimization pipeline implementation
  */
 
 #include "request_optimizer.h"
 
 #include "../core/char_model.h"
+#include "../core/fc_policy.h"
 #include "../core/ffd_pack.h"
 #include "../core/gap_merge.h"
+#include "../core/optimal_merge.h"
 #include "../utils/block_utils.h"
+#ifdef MB_ENABLE_PARALLEL_PLANNER
+#include "../utils/work_pool.h"
+#endif
 #include "smartmodbus/mb_config.h"
 #include "smartmodbus/mb_error.h"
 
 #include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Comparison function for sorting PDUs by start address
+ */
+static int compare_pdus_by_address(const void *a, const void *b) {
+    const mb_pdu_t *pdu_a = (const mb_pdu_t *)a;
+    const mb_pdu_t *pdu_b = (const mb_pdu_t *)b;
+
+    if (pdu_a->start_address < pdu_b->start_address) {
+        return -1;
+    } else if (pdu_a->start_address > pdu_b->start_address) {
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Find the plan that covers an address
+ * @return Plan index, or plan_count if no plan covers the address
+ */
+static uint16_t find_plan(const mb_request_plan_t *plans, uint16_t plan_count, uint16_t address) {
+    // Binary search for the last plan starting at or before the address
+    uint16_t lo = 0;
+    uint16_t hi = plan_count;
+    while (lo < hi) {
+        uint16_t mid = (uint16_t)(lo + (hi - lo) / 2);
+        if (plans[mid].start_address <= address) {
+            lo = (uint16_t)(mid + 1);
+        } else {
+            hi = mid;
+        }
+    }
+
+    // FFD may produce overlapping plans, so walk back until one covers it
+    while (lo > 0) {
+        lo--;
+        uint32_t end = (uint32_t)plans[lo].start_address + plans[lo].quantity;
+        if (address < end) {
+            return lo;
+        }
+    }
+
+    return plan_count;
+}
+
+int mb_build_scatter_map(const uint16_t *addresses,
+                         uint16_t address_count,
+                         mb_request_plan_t *plans,
+                         uint16_t plan_count,
+                         mb_scatter_entry_t *scatter) {
+    if ((addresses == NULL || scatter == NULL) && address_count > 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (plans == NULL && plan_count > 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    for (uint16_t p = 0; p < plan_count; p++) {
+        plans[p].scatter_first = 0;
+        plans[p].scatter_count = 0;
+    }
+
+    // Pass 1: count entries per plan
+    for (uint16_t i = 0; i < address_count; i++) {
+        uint16_t p = find_plan(plans, plan_count, addresses[i]);
+        if (p == plan_count) {
+            return MB_ERROR_INVALID_ADDRESS;
+        }
+        plans[p].scatter_count++;
+    }
+
+    // Prefix sum gives each plan its range in the map
+    uint16_t first = 0;
+    for (uint16_t p = 0; p < plan_count; p++) {
+        plans[p].scatter_first = first;
+        first                  = (uint16_t)(first + plans[p].scatter_count);
+    }
+
+    // Pass 2: place entries, using scatter_first as a fill cursor
+    for (uint16_t i = 0; i < address_count; i++) {
+        uint16_t p    = find_plan(plans, plan_count, addresses[i]);
+        uint16_t slot = plans[p].scatter_first++;
+
+        scatter[slot].plan_index = p;
+        scatter[slot].offset     = (uint16_t)(addresses[i] - plans[p].start_address);
+        scatter[slot].dest_index = i;
+    }
+
+    // Rewind cursors to the start of each range
+    for (uint16_t p = 0; p < plan_count; p++) {
+        plans[p].scatter_first = (uint16_t)(plans[p].scatter_first - plans[p].scatter_count);
+    }
+
+    return MB_SUCCESS;
+}
+
+/**
+ * @brief Replace an optimal plan by greedy merge + FFD where that is no worse
+ *
+ * The DP cuts runs at block boundaries only, while FFD also chunks merged
+ * runs mid-block, which can take fewer round-trips over long dense ranges.
+ * The greedy plan is built behind the optimal one and kept if its full
+ * round-trip cost is lower, or equal with fewer PDUs. Without room for it
+ * (static memory) the optimal plan stands.
+ *
+ * @return PDUs now at pdus
+ */
+static uint16_t keep_cheaper_greedy(mb_block_t *blocks,
+                                    uint16_t block_count,
+                                    const mb_cost_params_t *cost_params,
+                                    uint16_t max_pdu_chars,
+                                    mb_pdu_t *pdus,
+                                    uint16_t optimal_count,
+                                    uint16_t max_pdus,
+                                    mb_scratch_t *scratch) {
+    mb_pdu_t *greedy      = &pdus[optimal_count];
+    uint16_t greedy_count = 0;
+
+    // The blocks are not needed after planning: greedy merges them in place
+    if (mb_merge_block_array(blocks, &block_count, cost_params) != MB_SUCCESS ||
+        mb_ffd_pack_inplace(blocks, block_count, max_pdu_chars, greedy,
+                            (uint16_t)(max_pdus - optimal_count), &greedy_count,
+                            scratch) != MB_SUCCESS) {
+        return optimal_count;
+    }
+
+    uint32_t optimal_cost = mb_calc_full_plan_cost(pdus, optimal_count, cost_params);
+    uint32_t greedy_cost  = mb_calc_full_plan_cost(greedy, greedy_count, cost_params);
+    if (greedy_cost < optimal_cost ||
+        (greedy_cost == optimal_cost && greedy_count < optimal_count)) {
+        memmove(pdus, greedy, greedy_count * sizeof(mb_pdu_t));
+        return greedy_count;
+    }
+    return optimal_count;
+}
+
+size_t mb_optimize_scratch_size(uint16_t address_count) {
+    size_t n = address_count;
+
+    // Sorted address copy (or the smaller address bitmap), blocks, the PDUs
+    // of both planners (the optimal one checks against greedy) and the DP
+    // tables; the FFD sort buffer (8 bytes per block) takes the DP table share
+    return n * sizeof(uint16_t) + n * sizeof(mb_block_t) + 2 * n * sizeof(mb_pdu_t) +
+           (n + 1) * (sizeof(uint32_t) + 3 * sizeof(uint16_t)) + MB_SCRATCH_SLACK(7);
+}
+
+/**
+ * @brief Plan a request without building its scatter map
+ * @param cut_end NULL to require every PDU to fit max_plans. Otherwise the
+ *        first max_plans PDUs (by address) are kept and *cut_end receives
+ *        the end of the addresses they cover, or UINT32_MAX if all fit.
+ */
+static int plan_request(const mb_read_request_t *request,
+                        const mb_config_t *config,
+                        mb_request_plan_t *plans,
+                        uint16_t max_plans,
+                        uint16_t *plan_count,
+                        uint32_t *cut_end,
+                        mb_scratch_t *scratch) {
+
+    // Step 1: Convert addresses to blocks
+    mb_block_t *blocks = NULL;
+    mb_pdu_t *pdus = NULL;
+    uint16_t block_count = 0;
+    uint16_t pdu_count = 0;
+
+#ifdef MB_USE_STATIC_MEMORY
+    mb_block_t static_blocks[MB_MAX_BLOCKS];
+    mb_pdu_t static_pdus[MB_MAX_PDUS];
+    blocks = static_blocks;
+    pdus = static_pdus;
+    uint16_t max_blocks = MB_MAX_BLOCKS;
+    uint16_t max_pdus = MB_MAX_PDUS;
+#else
+    size_t mark = mb_scratch_mark(scratch);
+
+    // Worst case: one block per address; chunks of oversized blocks never
+    // outnumber the addresses they cover, for either planner
+    uint16_t max_blocks = request->address_count;
+    uint32_t pdu_room = request->address_count;
+    if (config->planner == MB_PLANNER_OPTIMAL) {
+        pdu_room *= 2;
+    }
+    uint16_t max_pdus = pdu_room < UINT16_MAX ? (uint16_t)pdu_room : UINT16_MAX;
+    blocks = (mb_block_t *)mb_scratch_acquire(scratch, max_blocks * sizeof(mb_block_t));
+    pdus = (mb_pdu_t *)mb_scratch_acquire(scratch, max_pdus * sizeof(mb_pdu_t));
+    if (blocks == NULL || pdus == NULL) {
+        mb_scratch_release(scratch, blocks);
+        mb_scratch_release(scratch, pdus);
+        mb_scratch_rewind(scratch, mark);
+        return MB_ERROR_NO_MEMORY;
+    }
+#endif
+
+    int result = mb_addresses_to_blocks_scratch(request->addresses, request->address_count,
+                                                request->slave_id, request->function_code, blocks,
+                                                max_blocks, &block_count, scratch);
+
+    // Step 2: Sort blocks by address (already done by mb_addresses_to_blocks)
+
+    // Step 3: Apply gap-aware merge (the optimal planner merges and packs at once)
+    // Learned turnaround of this slave replaces the static latency once known;
+    // with link timing configured the planner weighs microseconds instead
+    mb_cost_params_t cost_params;
+    uint8_t latency_chars = mb_profile_latency_chars(config->profiles, request->slave_id,
+                                                     config->latency_chars);
+    if (result == MB_SUCCESS) {
+        result = mb_init_link_cost_params(config->mode, request->function_code, latency_chars,
+                                          &config->link, &cost_params);
+    }
+
+    // A quantity the slave rejected before caps every PDU
+    uint16_t max_pdu_chars = config->max_pdu_chars;
+    uint16_t max_quantity  = mb_profile_max_quantity(config->profiles, request->slave_id,
+                                                     request->function_code);
+    if (max_quantity > 0) {
+        uint16_t limit = mb_fc_get_unit_size(request->function_code) == 1
+                             ? (uint16_t)((max_quantity + 7) / 8)
+                             : (uint16_t)(max_quantity * 2);
+        if (limit < max_pdu_chars) {
+            max_pdu_chars = limit;
+        }
+    }
+
+    // Learned holes split the sorted blocks into segments that are merged
+    // and packed independently, so no PDU ever spans one
+    uint16_t segment_start = 0;
+    while (result == MB_SUCCESS && segment_start < block_count) {
+        uint16_t segment_end = (uint16_t)(segment_start + 1);
+        while (segment_end < block_count) {
+            const mb_block_t *prev = &blocks[segment_end - 1];
+            uint32_t gap_first     = (uint32_t)prev->start_address + prev->quantity;
+            uint16_t gap_next      = blocks[segment_end].start_address;
+            if (gap_first < gap_next &&
+                mb_profile_gap_forbidden(config->profiles, request->slave_id,
+                                         request->function_code, (uint16_t)gap_first,
+                                         (uint16_t)(gap_next - 1))) {
+                break;
+            }
+            segment_end++;
+        }
+
+        mb_block_t *segment    = &blocks[segment_start];
+        uint16_t segment_count = (uint16_t)(segment_end - segment_start);
+        uint16_t segment_pdus  = 0;
+
+        if (config->planner != MB_PLANNER_OPTIMAL) {
+            result = mb_merge_block_array(segment, &segment_count, &cost_params);
+        }
+
+        // Step 4: Pack blocks into PDUs (FFD reorders our own block array, no copy)
+        if (result == MB_SUCCESS) {
+            if (config->planner == MB_PLANNER_OPTIMAL) {
+                result = mb_plan_optimal(segment, segment_count, &cost_params, max_pdu_chars,
+                                         &pdus[pdu_count], (uint16_t)(max_pdus - pdu_count),
+                                         &segment_pdus, scratch);
+                if (result == MB_SUCCESS) {
+                    segment_pdus = keep_cheaper_greedy(segment, segment_count, &cost_params,
+                                                       max_pdu_chars, &pdus[pdu_count],
+                                                       segment_pdus,
+                                                       (uint16_t)(max_pdus - pdu_count), scratch);
+                }
+            } else {
+                result = mb_ffd_pack_inplace(segment, segment_count, max_pdu_chars,
+                                             &pdus[pdu_count], (uint16_t)(max_pdus - pdu_count),
+                                             &segment_pdus, scratch);
+            }
+        }
+
+        pdu_count     = (uint16_t)(pdu_count + segment_pdus);
+        segment_start = segment_end;
+    }
+
+    // Step 5: Generate request plans from PDUs
+    if (result == MB_SUCCESS && pdu_count > max_plans && cut_end == NULL) {
+        result = MB_ERROR_TOO_MANY_PLANS;
+    }
+
+    if (result == MB_SUCCESS) {
+        // Address order keeps the wire sequence predictable and lets the
+        // scatter map locate plans by binary search
+        qsort(pdus, pdu_count, sizeof(mb_pdu_t), compare_pdus_by_address);
+
+        // Every address below the furthest end of the kept PDUs lies inside
+        // one of them: later PDUs start no earlier than the last kept one
+        if (cut_end != NULL) {
+            *cut_end = UINT32_MAX;
+            if (pdu_count > max_plans) {
+                pdu_count = max_plans;
+                *cut_end  = 0;
+                for (uint16_t i = 0; i < pdu_count; i++) {
+                    uint32_t end = (uint32_t)pdus[i].start_address + pdus[i].quantity;
+                    if (end > *cut_end) {
+                        *cut_end = end;
+                    }
+                }
+            }
+        }
+
+        for (uint16_t i = 0; i < pdu_count; i++) {
+            plans[i].slave_id = pdus[i].slave_id;
+            plans[i].function_code = pdus[i].function_code;
+            plans[i].start_address = pdus[i].start_address;
+            plans[i].quantity = pdus[i].quantity;
+            plans[i].frame_data = NULL;  // Will be built by master API
+            plans[i].frame_length = 0;
+            plans[i].expected_response_length = 0;  // Will be calculated by master API
+            plans[i].scatter_first = 0;
+            plans[i].scatter_count = 0;
+        }
+
+        *plan_count = pdu_count;
+    }
+
+#ifndef MB_USE_STATIC_MEMORY
+    mb_scratch_release(scratch, blocks);
+    mb_scratch_release(scratch, pdus);
+    mb_scratch_rewind(scratch, mark);
+#else
+    (void)scratch;
+#endif
+
+    return result;
+}
 
 int mb_optimize_request(const mb_read_request_t *request,
                         const mb_config_t *config,
                         mb_request_plan_t *plans,
                         uint16_t max_plans,
-                        uint16_t *plan_count) {
+                        uint16_t *plan_count,
+                        mb_scatter_entry_t *scatter,
+                        mb_scratch_t *scratch) {
     if (request == NULL || config == NULL || plans == NULL || plan_count == NULL) {
         return MB_ERROR_INVALID_PARAM;
     }
@@ -32,101 +365,583 @@ int mb_optimize_request(const mb_read_request_t *request,
         return MB_ERROR_INVALID_PARAM;
     }
 
-    // Step 1: Convert addresses to blocks
-    mb_block_t *blocks = NULL;
-    uint16_t block_count = 0;
+    int result = plan_request(request, config, plans, max_plans, plan_count, NULL, scratch);
+
+    // Step 6: Map each requested address to its plan and offset
+    if (result == MB_SUCCESS && scatter != NULL) {
+        result = mb_build_scatter_map(request->addresses, request->address_count, plans,
+                                      *plan_count, scatter);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Count requested addresses in [first, limit)
+ */
+static uint16_t count_in_range(const mb_read_request_t *request, uint32_t first, uint32_t limit) {
+    uint16_t count = 0;
+    for (uint16_t i = 0; i < request->address_count; i++) {
+        if (request->addresses[i] >= first && request->addresses[i] < limit) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Lowest requested address at or above first
+ * @return Address, or MB_WINDOW_END if there is none
+ */
+static uint32_t next_address(const mb_read_request_t *request, uint32_t first) {
+    uint32_t next = MB_WINDOW_END;
+    for (uint16_t i = 0; i < request->address_count; i++) {
+        if (request->addresses[i] >= first && request->addresses[i] < next) {
+            next = request->addresses[i];
+        }
+    }
+    return next;
+}
+
+/**
+ * @brief End of the largest window starting at first with at most budget addresses
+ * @return Window end (exclusive), or first if the duplicates of first alone
+ *         exceed the budget (first must be a requested address)
+ */
+static uint32_t window_limit(const mb_read_request_t *request, uint32_t first, uint16_t budget) {
+    if (count_in_range(request, first, MB_WINDOW_END) <= budget) {
+        return MB_WINDOW_END;
+    }
+
+    // Counts only grow with the limit: bisect over the address space
+    uint32_t lo = first;
+    uint32_t hi = MB_WINDOW_END;
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (count_in_range(request, first, mid) <= budget) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+int mb_optimize_request_window(const mb_read_request_t *request,
+                               const mb_config_t *config,
+                               uint32_t *cursor,
+                               mb_request_plan_t *plans,
+                               uint16_t max_plans,
+                               uint16_t *plan_count,
+                               mb_scatter_entry_t *scatter,
+                               uint16_t max_scatter,
+                               uint16_t *scatter_count,
+                               mb_scratch_t *scratch) {
+    if (request == NULL || config == NULL || cursor == NULL || plans == NULL ||
+        plan_count == NULL || scatter == NULL || scatter_count == NULL ||
+        (request->addresses == NULL && request->address_count > 0)) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    *plan_count    = 0;
+    *scatter_count = 0;
+    if (max_plans == 0 || max_scatter == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    uint32_t first = next_address(request, *cursor);
+    if (first >= MB_WINDOW_END) {
+        *cursor = MB_WINDOW_END;
+        return MB_SUCCESS;
+    }
+
+    uint16_t budget = max_scatter;
+    if (budget > request->address_count) {
+        budget = request->address_count;
+    }
+
+    // Window addresses and their positions in the request
+    uint16_t *addresses = NULL;
+    uint16_t *indices   = NULL;
 
 #ifdef MB_USE_STATIC_MEMORY
-    mb_block_t static_blocks[MB_MAX_BLOCKS];
-    blocks = static_blocks;
-    uint16_t max_blocks = MB_MAX_BLOCKS;
+    uint16_t static_addresses[MB_MAX_SCATTER];
+    uint16_t static_indices[MB_MAX_SCATTER];
+    addresses = static_addresses;
+    indices   = static_indices;
+    if (budget > MB_MAX_SCATTER) {
+        budget = MB_MAX_SCATTER;
+    }
 #else
-    uint16_t max_blocks = request->address_count;  // Worst case: one block per address
-    blocks = (mb_block_t *)malloc(max_blocks * sizeof(mb_block_t));
-    if (blocks == NULL) {
+    size_t mark = mb_scratch_mark(scratch);
+    addresses   = (uint16_t *)mb_scratch_acquire(scratch, budget * sizeof(uint16_t));
+    indices     = (uint16_t *)mb_scratch_acquire(scratch, budget * sizeof(uint16_t));
+    if ((addresses == NULL || indices == NULL) && budget > 0) {
+        mb_scratch_release(scratch, addresses);
+        mb_scratch_release(scratch, indices);
+        mb_scratch_rewind(scratch, mark);
         return MB_ERROR_NO_MEMORY;
     }
 #endif
 
-    int result = mb_addresses_to_blocks(request->slave_id, request->function_code, request->addresses,
-                                        request->address_count, blocks, max_blocks, &block_count);
+    int result = MB_SUCCESS;
+    for (;;) {
+        // The window always holds first, unless its duplicates alone
+        // exceed the budget
+        uint32_t limit = window_limit(request, first, budget);
+        if (limit == first) {
+            result = MB_ERROR_TOO_MANY_BLOCKS;
+            break;
+        }
+
+        uint16_t count = 0;
+        for (uint16_t i = 0; i < request->address_count; i++) {
+            if (request->addresses[i] >= first && request->addresses[i] < limit) {
+                addresses[count] = request->addresses[i];
+                indices[count]   = i;
+                count++;
+            }
+        }
+
+        mb_read_request_t window = *request;
+        window.addresses         = addresses;
+        window.address_count     = count;
+
+        uint32_t cut_end = UINT32_MAX;
+        result = plan_request(&window, config, plans, max_plans, plan_count, &cut_end, scratch);
+
+        // Too scattered for the fixed block/PDU pools: try half the window
+        if (result == MB_ERROR_TOO_MANY_BLOCKS && count > 1) {
+            budget = (uint16_t)(count / 2);
+            result = MB_SUCCESS;
+            continue;
+        }
+        if (result != MB_SUCCESS) {
+            break;
+        }
+
+        // Addresses past the kept plans go to the next window
+        uint32_t end = cut_end < limit ? cut_end : limit;
+        uint16_t kept = 0;
+        for (uint16_t i = 0; i < count; i++) {
+            if (addresses[i] < end) {
+                addresses[kept] = addresses[i];
+                indices[kept]   = indices[i];
+                kept++;
+            }
+        }
+
+        result = mb_build_scatter_map(addresses, kept, plans, *plan_count, scatter);
+        if (result != MB_SUCCESS) {
+            break;
+        }
+
+        // Scatter entries point at window positions: map them to the request
+        for (uint16_t i = 0; i < kept; i++) {
+            scatter[i].dest_index = indices[scatter[i].dest_index];
+        }
+
+        *scatter_count = kept;
+        *cursor        = end;
+        break;
+    }
 
-    if (result != MB_SUCCESS) {
 #ifndef MB_USE_STATIC_MEMORY
-        free(blocks);
+    mb_scratch_release(scratch, addresses);
+    mb_scratch_release(scratch, indices);
+    mb_scratch_rewind(scratch, mark);
+#else
+    (void)scratch;
 #endif
-        return result;
+
+    return result;
+}
+
+/**
+ * @brief Batch tag reduced to a single-unit block for grouping
+ */
+typedef struct {
+    mb_block_t block;   /**< Tag as a one-unit block */
+    uint16_t tag_index; /**< Position in the caller's tag array */
+} batch_key_t;
+
+/**
+ * @brief Comparison function ordering batch keys by slave, FC, address
+ */
+static int compare_batch_keys(const void *a, const void *b) {
+    const batch_key_t *key_a = (const batch_key_t *)a;
+    const batch_key_t *key_b = (const batch_key_t *)b;
+
+    if (key_a->block.slave_id != key_b->block.slave_id) {
+        return key_a->block.slave_id < key_b->block.slave_id ? -1 : 1;
+    }
+    if (key_a->block.function_code != key_b->block.function_code) {
+        return key_a->block.function_code < key_b->block.function_code ? -1 : 1;
+    }
+    if (key_a->block.start_address != key_b->block.start_address) {
+        return key_a->block.start_address < key_b->block.start_address ? -1 : 1;
     }
 
-    // Step 2: Sort blocks by address (already done by mb_addresses_to_blocks)
+    // Keep caller order for duplicate tags
+    if (key_a->tag_index < key_b->tag_index) {
+        return -1;
+    } else if (key_a->tag_index > key_b->tag_index) {
+        return 1;
+    }
+    return 0;
+}
 
-    // Step 3: Apply gap-aware merge
-    mb_cost_params_t cost_params;
-    mb_init_cost_params(config->mode, request->function_code, config->latency_chars, &cost_params);
+/**
+ * @brief Interleave slave-grouped plans round-robin across slaves
+ * @param plans Plans, contiguous per slave
+ * @param plan_count Number of plans
+ * @param scatter Scatter map (plan indices are updated, may be NULL)
+ * @param temp Scratch array of plan_count plans
+ */
+static void interleave_slaves(mb_request_plan_t *plans,
+                              uint16_t plan_count,
+                              mb_scatter_entry_t *scatter,
+                              mb_request_plan_t *temp) {
+    uint16_t out = 0;
 
-    result = mb_merge_block_array(blocks, &block_count, &cost_params);
+    // Round r takes the r-th plan of every slave run
+    for (uint16_t round = 0; out < plan_count; round++) {
+        uint16_t run_start = 0;
+        while (run_start < plan_count) {
+            uint16_t run_end = (uint16_t)(run_start + 1);
+            while (run_end < plan_count && plans[run_end].slave_id == plans[run_start].slave_id) {
+                run_end++;
+            }
 
-    if (result != MB_SUCCESS) {
-#ifndef MB_USE_STATIC_MEMORY
-        free(blocks);
+            if ((uint32_t)run_start + round < run_end) {
+                temp[out++] = plans[run_start + round];
+            }
+            run_start = run_end;
+        }
+    }
+
+    for (uint16_t p = 0; p < plan_count; p++) {
+        plans[p] = temp[p];
+
+        if (scatter != NULL) {
+            for (uint16_t k = 0; k < plans[p].scatter_count; k++) {
+                scatter[plans[p].scatter_first + k].plan_index = p;
+            }
+        }
+    }
+}
+
+#ifdef MB_ENABLE_PARALLEL_PLANNER
+/**
+ * @brief One (slave, FC) group of a parallel batch
+ *
+ * A group of n tags yields at most n plans, so it owns the slices at
+ * [first, first + size) of the staging plans, the addresses and the
+ * scatter map, and workers never share output.
+ */
+typedef struct {
+    uint16_t first;      /**< First key of the group */
+    uint16_t size;       /**< Keys in the group */
+    uint16_t plan_count; /**< Plans the group produced */
+} batch_group_t;
+
+typedef struct {
+    const batch_key_t *keys;
+    const mb_config_t *config;
+    batch_group_t *groups;
+    uint16_t *addresses;
+    mb_request_plan_t *staging;
+    mb_scatter_entry_t *scatter;
+    mb_scratch_t *arenas; /**< One arena per worker */
+} batch_work_t;
+
+static int plan_group(void *context, uint8_t worker, uint32_t job) {
+    batch_work_t *work   = (batch_work_t *)context;
+    batch_group_t *group = &work->groups[job];
+    const batch_key_t *first_key = &work->keys[group->first];
+
+    mb_read_request_t request;
+    request.slave_id      = first_key->block.slave_id;
+    request.function_code = first_key->block.function_code;
+    request.addresses     = &work->addresses[group->first];
+    request.address_count = group->size;
+    for (uint16_t i = 0; i < group->size; i++) {
+        request.addresses[i] = first_key[i].block.start_address;
+    }
+
+    mb_scatter_entry_t *scatter = (work->scatter != NULL) ? &work->scatter[group->first] : NULL;
+    return mb_optimize_request(&request, work->config, &work->staging[group->first], group->size,
+                               &group->plan_count, scatter, &work->arenas[worker]);
+}
+
+/**
+ * @brief Optimize the groups of a sorted batch on config->planner_threads workers
+ * @param planned Output: false if the batch should be planned serially instead
+ *        (one worker or one group, or no memory for the worker arenas)
+ * @return As the serial loop of mb_optimize_batch(), with identical plans
+ *
+ * Plans are collected in group order after all workers finish, so the
+ * output does not depend on which worker planned which group.
+ */
+static int optimize_groups_parallel(const batch_key_t *keys,
+                                    uint16_t tag_count,
+                                    const mb_config_t *config,
+                                    mb_request_plan_t *plans,
+                                    uint16_t max_plans,
+                                    uint16_t *plan_count,
+                                    mb_scatter_entry_t *scatter,
+                                    uint16_t *addresses,
+                                    mb_scratch_t *scratch,
+                                    bool *planned) {
+    *planned = false;
+
+    uint16_t group_count = 0;
+    uint16_t largest     = 0;
+    for (uint16_t i = 0; i < tag_count;) {
+        uint16_t end = (uint16_t)(i + 1);
+        while (end < tag_count && mb_block_are_compatible(&keys[i].block, &keys[end].block)) {
+            end++;
+        }
+        if (end - i > largest) {
+            largest = (uint16_t)(end - i);
+        }
+        group_count++;
+        i = end;
+    }
+
+    uint8_t workers = config->planner_threads;
+    if (workers > MB_MAX_PLANNER_THREADS) {
+        workers = MB_MAX_PLANNER_THREADS;
+    }
+    if (workers > group_count) {
+        workers = (uint8_t)group_count;
+    }
+    if (workers <= 1) {
+        return MB_SUCCESS;
+    }
+
+    // Each worker gets an arena for the largest group, so planning a group
+    // never touches the heap or another worker's memory
+    size_t arena_size = mb_optimize_scratch_size(largest);
+    size_t mark       = mb_scratch_mark(scratch);
+
+    batch_group_t *groups =
+        (batch_group_t *)mb_scratch_acquire(scratch, group_count * sizeof(batch_group_t));
+    mb_request_plan_t *staging =
+        (mb_request_plan_t *)mb_scratch_acquire(scratch, tag_count * sizeof(mb_request_plan_t));
+    uint8_t *arena_memory = (uint8_t *)mb_scratch_acquire(scratch, workers * arena_size);
+    mb_scratch_t arenas[MB_MAX_PLANNER_THREADS];
+
+    int result = MB_SUCCESS;
+    if (groups != NULL && staging != NULL && arena_memory != NULL) {
+        *planned = true;
+
+        uint16_t next = 0;
+        for (uint16_t g = 0; g < group_count; g++) {
+            uint16_t end = (uint16_t)(next + 1);
+            while (end < tag_count &&
+                   mb_block_are_compatible(&keys[next].block, &keys[end].block)) {
+                end++;
+            }
+            groups[g].first      = next;
+            groups[g].size       = (uint16_t)(end - next);
+            groups[g].plan_count = 0;
+            next                 = end;
+        }
+        for (uint8_t w = 0; w < workers; w++) {
+            mb_scratch_init(&arenas[w], &arena_memory[w * arena_size], arena_size);
+        }
+
+        batch_work_t work = {keys, config, groups, addresses, staging, scatter, arenas};
+        result = mb_work_run(group_count, workers, plan_group, &work);
+
+        // Collect in group order; the serial loop would have stopped at the
+        // same group, as mb_work_run() reports the lowest failed one
+        uint16_t total_plans = 0;
+        for (uint16_t g = 0; g < group_count && result == MB_SUCCESS; g++) {
+            const batch_group_t *group = &groups[g];
+            if (group->plan_count > max_plans - total_plans) {
+                result = MB_ERROR_TOO_MANY_PLANS;
+                break;
+            }
+
+            for (uint16_t p = 0; p < group->plan_count; p++) {
+                plans[total_plans + p] = staging[group->first + p];
+                plans[total_plans + p].scatter_first =
+                    (uint16_t)(plans[total_plans + p].scatter_first + group->first);
+            }
+            if (scatter != NULL) {
+                mb_scatter_entry_t *group_scatter = &scatter[group->first];
+                for (uint16_t i = 0; i < group->size; i++) {
+                    group_scatter[i].plan_index =
+                        (uint16_t)(group_scatter[i].plan_index + total_plans);
+                    group_scatter[i].dest_index =
+                        keys[group->first + group_scatter[i].dest_index].tag_index;
+                }
+            }
+            total_plans = (uint16_t)(total_plans + group->plan_count);
+        }
+        *plan_count = total_plans;
+    }
+
+    mb_scratch_release(scratch, groups);
+    mb_scratch_release(scratch, staging);
+    mb_scratch_release(scratch, arena_memory);
+    mb_scratch_rewind(scratch, mark);
+
+    return result;
+}
 #endif
-        return result;
+
+size_t mb_optimize_batch_scratch_size(uint16_t tag_count) {
+    size_t n = tag_count;
+
+    // Keys, group addresses and the reorder buffer, plus one group optimization
+    return n * sizeof(batch_key_t) + n * sizeof(uint16_t) + n * sizeof(mb_request_plan_t) +
+           MB_SCRATCH_SLACK(3) + mb_optimize_scratch_size(tag_count);
+}
+
+int mb_optimize_batch(const mb_tag_t *tags,
+                      uint16_t tag_count,
+                      const mb_config_t *config,
+                      mb_request_plan_t *plans,
+                      uint16_t max_plans,
+                      uint16_t *plan_count,
+                      mb_scatter_entry_t *scatter,
+                      mb_scratch_t *scratch) {
+    if (tags == NULL || config == NULL || plans == NULL || plan_count == NULL) {
+        return MB_ERROR_INVALID_PARAM;
     }
 
-    // Step 4: Apply FFD packing
-    mb_pdu_t *pdus = NULL;
-    uint16_t pdu_count = 0;
+    *plan_count = 0;
+    if (tag_count == 0) {
+        return MB_SUCCESS;
+    }
+
+    if (max_plans == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    batch_key_t *keys = NULL;
+    uint16_t *addresses = NULL;
+    mb_request_plan_t *temp = NULL;
 
 #ifdef MB_USE_STATIC_MEMORY
-    mb_pdu_t static_pdus[MB_MAX_PDUS];
-    pdus = static_pdus;
-    uint16_t max_pdus = MB_MAX_PDUS;
+    if (tag_count > MB_MAX_SCATTER) {
+        return MB_ERROR_TOO_MANY_BLOCKS;
+    }
+    batch_key_t static_keys[MB_MAX_SCATTER];
+    uint16_t static_addresses[MB_MAX_SCATTER];
+    mb_request_plan_t static_temp[MB_MAX_PLANS];
+    keys = static_keys;
+    addresses = static_addresses;
+    temp = static_temp;
+    if (max_plans > MB_MAX_PLANS) {
+        max_plans = MB_MAX_PLANS;
+    }
 #else
-    uint16_t max_pdus = block_count;  // Worst case: one PDU per block
-    pdus = (mb_pdu_t *)malloc(max_pdus * sizeof(mb_pdu_t));
-    if (pdus == NULL) {
-#ifndef MB_USE_STATIC_MEMORY
-        free(blocks);
-#endif
+    // A batch never yields more plans than tags, whatever max_plans allows
+    uint16_t max_temp = max_plans < tag_count ? max_plans : tag_count;
+
+    size_t mark = mb_scratch_mark(scratch);
+    keys = (batch_key_t *)mb_scratch_acquire(scratch, tag_count * sizeof(batch_key_t));
+    addresses = (uint16_t *)mb_scratch_acquire(scratch, tag_count * sizeof(uint16_t));
+    temp = (mb_request_plan_t *)mb_scratch_acquire(scratch, max_temp * sizeof(mb_request_plan_t));
+    if (keys == NULL || addresses == NULL || temp == NULL) {
+        mb_scratch_release(scratch, keys);
+        mb_scratch_release(scratch, addresses);
+        mb_scratch_release(scratch, temp);
+        mb_scratch_rewind(scratch, mark);
         return MB_ERROR_NO_MEMORY;
     }
 #endif
 
-    result = mb_ffd_pack(blocks, block_count, config->max_pdu_chars, pdus, max_pdus, &pdu_count);
-
-    if (result != MB_SUCCESS) {
-#ifndef MB_USE_STATIC_MEMORY
-        free(blocks);
-        free(pdus);
-#endif
-        return result;
+    // Step 1: Sort tags into (slave, FC) groups, addresses ascending
+    for (uint16_t i = 0; i < tag_count; i++) {
+        keys[i].block.slave_id = tags[i].slave_id;
+        keys[i].block.function_code = tags[i].function_code;
+        keys[i].block.start_address = tags[i].address;
+        keys[i].block.quantity = 1;
+        keys[i].block.is_merged = false;
+        keys[i].tag_index = i;
     }
+    qsort(keys, tag_count, sizeof(batch_key_t), compare_batch_keys);
 
-    // Step 5: Generate request plans from PDUs
-    if (pdu_count > max_plans) {
-#ifndef MB_USE_STATIC_MEMORY
-        free(blocks);
-        free(pdus);
-#endif
-        return MB_ERROR_TOO_MANY_PLANS;
+    // Step 2: Optimize each compatible group into the shared plan array
+    int result = MB_SUCCESS;
+    uint16_t total_plans = 0;
+    uint16_t group_start = 0;
+
+#ifdef MB_ENABLE_PARALLEL_PLANNER
+    bool planned = false;
+    result = optimize_groups_parallel(keys, tag_count, config, plans, max_plans, &total_plans,
+                                      scatter, addresses, scratch, &planned);
+    if (planned) {
+        group_start = tag_count;
     }
+#endif
+
+    while (group_start < tag_count && result == MB_SUCCESS) {
+        uint16_t group_end = (uint16_t)(group_start + 1);
+        while (group_end < tag_count &&
+               mb_block_are_compatible(&keys[group_start].block, &keys[group_end].block)) {
+            group_end++;
+        }
+
+        if (total_plans == max_plans) {
+            result = MB_ERROR_TOO_MANY_PLANS;
+            break;
+        }
 
-    for (uint16_t i = 0; i < pdu_count; i++) {
-        plans[i].slave_id = pdus[i].slave_id;
-        plans[i].function_code = pdus[i].function_code;
-        plans[i].start_address = pdus[i].start_address;
-        plans[i].quantity = pdus[i].quantity;
-        plans[i].frame_data = NULL;  // Will be built by master API
-        plans[i].frame_length = 0;
-        plans[i].expected_response_length = 0;  // Will be calculated by master API
+        uint16_t group_size = (uint16_t)(group_end - group_start);
+        for (uint16_t i = 0; i < group_size; i++) {
+            addresses[i] = keys[group_start + i].block.start_address;
+        }
+
+        mb_read_request_t group;
+        group.slave_id = keys[group_start].block.slave_id;
+        group.function_code = keys[group_start].block.function_code;
+        group.addresses = addresses;
+        group.address_count = group_size;
+
+        mb_scatter_entry_t *group_scatter = (scatter != NULL) ? &scatter[group_start] : NULL;
+        uint16_t group_plans = 0;
+
+        result = mb_optimize_request(&group, config, &plans[total_plans],
+                                     (uint16_t)(max_plans - total_plans), &group_plans,
+                                     group_scatter, scratch);
+        if (result != MB_SUCCESS) {
+            break;
+        }
+
+        // Rebase group-local plan and address indices onto the batch
+        if (scatter != NULL) {
+            for (uint16_t i = 0; i < group_size; i++) {
+                group_scatter[i].plan_index = (uint16_t)(group_scatter[i].plan_index + total_plans);
+                group_scatter[i].dest_index = keys[group_start + group_scatter[i].dest_index].tag_index;
+            }
+            for (uint16_t p = 0; p < group_plans; p++) {
+                plans[total_plans + p].scatter_first =
+                    (uint16_t)(plans[total_plans + p].scatter_first + group_start);
+            }
+        }
+
+        total_plans = (uint16_t)(total_plans + group_plans);
+        group_start = group_end;
     }
 
-    *plan_count = pdu_count;
+    // Step 3: Global order, one slave after another within each round
+    if (result == MB_SUCCESS) {
+        interleave_slaves(plans, total_plans, scatter, temp);
+        *plan_count = total_plans;
+    }
 
 #ifndef MB_USE_STATIC_MEMORY
-    free(blocks);
-    free(pdus);
+    mb_scratch_release(scratch, keys);
+    mb_scratch_release(scratch, addresses);
+    mb_scratch_release(scratch, temp);
+    mb_scratch_rewind(scratch, mark);
 #endif
 
-    return MB_SUCCESS;
+    return result;
 }
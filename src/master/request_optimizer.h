@@ -6,6 +6,7 @@
 #ifndef SMARTMODBUS_REQUEST_OPTIMIZER_H
 #define SMARTMODBUS_REQUEST_OPTIMIZER_H
 
+#include "../utils/scratch.h"
 #include "smartmodbus/mb_config.h"
 #include "smartmodbus/mb_types.h"
 
@@ -17,16 +18,121 @@ extern "C" {
  * @brief Main optimization pipeline
  * @param request User read request
  * @param config Configuration
- * @param plans Output array of optimized request plans
+ * @param plans Output array of optimized request plans (sorted by start address)
  * @param max_plans Maximum number of plans
  * @param plan_count Output: actual number of plans created
+ * @param scatter Output scatter map with request->address_count entries (may be NULL)
+ * @param scratch Arena for working arrays (NULL = heap, or fixed pools when static)
  * @return 0 on success, negative error code on failure
  */
 int mb_optimize_request(const mb_read_request_t *request,
                         const mb_config_t *config,
                         mb_request_plan_t *plans,
                         uint16_t max_plans,
-                        uint16_t *plan_count);
+                        uint16_t *plan_count,
+                        mb_scatter_entry_t *scatter,
+                        mb_scratch_t *scratch);
+
+/**
+ * @brief Window cursor once every address of a request has been planned
+ */
+#define MB_WINDOW_END 0x10000u
+
+/**
+ * @brief Plan the next window of a request of any size
+ * @param request User read request
+ * @param config Configuration
+ * @param cursor In: lowest address not planned yet (0 to start). Out: where
+ *        the next window starts, MB_WINDOW_END when the request is done
+ * @param plans Output array of plans for this window (sorted by start address)
+ * @param max_plans Plans per window
+ * @param plan_count Output: plans in this window
+ * @param scatter Output scatter map of this window's addresses; dest_index
+ *        refers to the position in request->addresses
+ * @param max_scatter Scatter entries per window
+ * @param scatter_count Output: entries in this window
+ * @param scratch Arena for working arrays (NULL = heap, or fixed pools when static)
+ * @return 0 on success, negative error code on failure
+ *
+ * A window takes the requested addresses from the cursor upwards, as many
+ * as max_scatter (and the static block and PDU pools) allow, and keeps the
+ * first max_plans PDUs by address. Calling it until the cursor reaches
+ * MB_WINDOW_END plans, executes and scatters an arbitrarily large request
+ * with fixed plan and scatter storage. Merging does not cross windows.
+ */
+int mb_optimize_request_window(const mb_read_request_t *request,
+                               const mb_config_t *config,
+                               uint32_t *cursor,
+                               mb_request_plan_t *plans,
+                               uint16_t max_plans,
+                               uint16_t *plan_count,
+                               mb_scatter_entry_t *scatter,
+                               uint16_t max_scatter,
+                               uint16_t *scatter_count,
+                               mb_scratch_t *scratch);
+
+/**
+ * @brief Scratch bytes mb_optimize_request() may draw for a request
+ * @param address_count Number of requested addresses
+ * @return Worst-case arena usage in bytes
+ */
+size_t mb_optimize_scratch_size(uint16_t address_count);
+
+/**
+ * @brief Batch optimization over heterogeneous tags
+ * @param tags Tags spanning any number of slaves and function codes
+ * @param tag_count Number of tags
+ * @param config Configuration
+ * @param plans Output array of optimized request plans (globally ordered)
+ * @param max_plans Maximum number of plans
+ * @param plan_count Output: actual number of plans created
+ * @param scatter Output scatter map with tag_count entries (may be NULL);
+ *                dest_index refers to the position in tags
+ * @param scratch Arena for working arrays (NULL = heap, or fixed pools when static)
+ * @return 0 on success, negative error code on failure
+ *
+ * Tags are grouped with the mb_block_are_compatible() rule (same slave and
+ * function code) and each group runs through mb_optimize_request(). The
+ * resulting plans are interleaved round-robin across slaves, so consecutive
+ * frames on a shared line address different devices where possible.
+ *
+ * With config->planner_threads > 1 (MB_ENABLE_PARALLEL_PLANNER builds) the
+ * groups are planned on a worker pool, each worker in its own arena drawn
+ * from scratch. The output is the same as the serial one; if the arena has
+ * no room for the workers the batch is planned serially.
+ */
+int mb_optimize_batch(const mb_tag_t *tags,
+                      uint16_t tag_count,
+                      const mb_config_t *config,
+                      mb_request_plan_t *plans,
+                      uint16_t max_plans,
+                      uint16_t *plan_count,
+                      mb_scatter_entry_t *scatter,
+                      mb_scratch_t *scratch);
+
+/**
+ * @brief Scratch bytes mb_optimize_batch() may draw for a batch
+ * @param tag_count Number of tags
+ * @return Worst-case arena usage in bytes
+ */
+size_t mb_optimize_batch_scratch_size(uint16_t tag_count);
+
+/**
+ * @brief Build scatter map from requested addresses to plan offsets
+ * @param addresses Requested addresses (request order)
+ * @param address_count Number of addresses
+ * @param plans Plans sorted by start address (scatter_first/count are filled in)
+ * @param plan_count Number of plans
+ * @param scatter Output array of address_count entries, grouped by plan
+ * @return 0 on success, MB_ERROR_INVALID_ADDRESS if an address is not covered
+ *
+ * Within each plan, entries keep request order.
+ */
+int mb_build_scatter_map(const uint16_t *addresses,
+                         uint16_t address_count,
+                         mb_request_plan_t *plans,
+                         uint16_t plan_count,
+                         mb_scatter_entry_t *scatter);
 
 #ifdef __cplusplus
 }
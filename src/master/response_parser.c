@@ -8,6 +8,8 @@
 #include "response_parser.h"
 
 #include "../core/fc_policy.h"
+#include "../utils/bitset.h"
+#include "../utils/reg_codec.h"
 #include "smartmodbus/mb_error.h"
 
 #include <string.h>
@@ -53,10 +55,7 @@ static int parse_read_registers_response(const uint8_t *pdu_data,
     }
 
     // Convert big-endian to host byte order
-    for (uint16_t i = 0; i < quantity; i++) {
-        uint16_t offset = 1 + (i * 2);
-        data_buffer[i] = ((uint16_t)pdu_data[offset] << 8) | pdu_data[offset + 1];
-    }
+    mb_regs_decode(data_buffer, &pdu_data[1], quantity);
 
     return MB_SUCCESS;
 }
@@ -161,6 +160,206 @@ int mb_parse_read_response(uint8_t fc,
     }
 }
 
+int mb_parse_read_response_scatter(uint8_t fc,
+                                   const uint8_t *pdu_data,
+                                   uint16_t pdu_length,
+                                   uint16_t quantity,
+                                   const mb_scatter_entry_t *entries,
+                                   uint16_t entry_count,
+                                   uint16_t *data_buffer) {
+    if (pdu_data == NULL || data_buffer == NULL || (entries == NULL && entry_count > 0)) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    // Check for exception response
+    if (fc & 0x80) {
+        if (pdu_length >= 1) {
+            return MB_ERROR_EXCEPTION_RESPONSE;
+        }
+        return MB_ERROR_INVALID_FRAME;
+    }
+
+    uint16_t expected_bytes;
+    bool is_bits;
+
+    switch (fc) {
+    case MB_FC_READ_COILS:
+    case MB_FC_READ_DISCRETE_INPUTS:
+        expected_bytes = (uint16_t)((quantity + 7) / 8);
+        is_bits        = true;
+        break;
+
+    case MB_FC_READ_HOLDING_REGISTERS:
+    case MB_FC_READ_INPUT_REGISTERS:
+    case MB_FC_READ_WRITE_MULTIPLE_REGISTERS:
+        expected_bytes = (uint16_t)(quantity * 2);
+        is_bits        = false;
+        break;
+
+    default:
+        return MB_ERROR_INVALID_FC;
+    }
+
+    if (pdu_length < 1 || pdu_data[0] != expected_bytes || pdu_length < 1 + expected_bytes) {
+        return MB_ERROR_INVALID_FRAME;
+    }
+
+    const uint8_t *payload = &pdu_data[1];
+
+    uint16_t i = 0;
+    while (i < entry_count) {
+        uint16_t offset = entries[i].offset;
+        if (offset >= quantity) {
+            return MB_ERROR_INVALID_ADDRESS;
+        }
+
+        if (is_bits) {
+            data_buffer[entries[i].dest_index] = (uint16_t)((payload[offset >> 3] >> (offset & 7)) & 1);
+            i++;
+            continue;
+        }
+
+        // Registers contiguous in the response and in the buffer: bulk decode
+        uint16_t j = (uint16_t)(i + 1);
+        while (j < entry_count && entries[j].offset == entries[j - 1].offset + 1 &&
+               entries[j].dest_index == entries[j - 1].dest_index + 1) {
+            j++;
+        }
+        if ((uint32_t)offset + (j - i) > quantity) {
+            return MB_ERROR_INVALID_ADDRESS;
+        }
+
+        mb_regs_decode(&data_buffer[entries[i].dest_index], &payload[offset * 2], (size_t)(j - i));
+        i = j;
+    }
+
+    return MB_SUCCESS;
+}
+
+int mb_parse_read_bits_scatter(uint8_t fc,
+                               const uint8_t *pdu_data,
+                               uint16_t pdu_length,
+                               uint16_t quantity,
+                               const mb_scatter_entry_t *entries,
+                               uint16_t entry_count,
+                               uint32_t *bits) {
+    if (pdu_data == NULL || bits == NULL || (entries == NULL && entry_count > 0)) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (fc & 0x80) {
+        return pdu_length >= 1 ? MB_ERROR_EXCEPTION_RESPONSE : MB_ERROR_INVALID_FRAME;
+    }
+
+    if (fc != MB_FC_READ_COILS && fc != MB_FC_READ_DISCRETE_INPUTS) {
+        return MB_ERROR_INVALID_FC;
+    }
+
+    uint16_t expected_bytes = (uint16_t)((quantity + 7) / 8);
+    if (pdu_length < 1 || pdu_data[0] != expected_bytes || pdu_length < 1 + expected_bytes) {
+        return MB_ERROR_INVALID_FRAME;
+    }
+
+    for (uint16_t i = 0; i < entry_count; i++) {
+        if (entries[i].offset >= quantity) {
+            return MB_ERROR_INVALID_ADDRESS;
+        }
+    }
+
+    mb_bits_gather(bits, &pdu_data[1], entries, entry_count);
+    return MB_SUCCESS;
+}
+
+int mb_parse_read_typed_scatter(uint8_t fc,
+                                const uint8_t *pdu_data,
+                                uint16_t pdu_length,
+                                uint16_t quantity,
+                                const mb_scatter_entry_t *entries,
+                                uint16_t entry_count,
+                                const mb_typed_tag_t *tags,
+                                const mb_typed_route_t *routes) {
+    if (pdu_data == NULL || tags == NULL || routes == NULL ||
+        (entries == NULL && entry_count > 0)) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (fc & 0x80) {
+        return pdu_length >= 1 ? MB_ERROR_EXCEPTION_RESPONSE : MB_ERROR_INVALID_FRAME;
+    }
+
+    if (fc != MB_FC_READ_HOLDING_REGISTERS && fc != MB_FC_READ_INPUT_REGISTERS &&
+        fc != MB_FC_READ_WRITE_MULTIPLE_REGISTERS) {
+        return MB_ERROR_INVALID_FC;
+    }
+
+    uint16_t expected_bytes = (uint16_t)(quantity * 2);
+    if (pdu_length < 1 || pdu_data[0] != expected_bytes || pdu_length < 1 + expected_bytes) {
+        return MB_ERROR_INVALID_FRAME;
+    }
+
+    const uint8_t *payload = &pdu_data[1];
+
+    // Each register goes straight from the RX buffer into its tag value
+    for (uint16_t i = 0; i < entry_count; i++) {
+        uint16_t offset = entries[i].offset;
+        if (offset >= quantity) {
+            return MB_ERROR_INVALID_ADDRESS;
+        }
+
+        const mb_typed_route_t *route = &routes[entries[i].dest_index];
+        const mb_typed_tag_t *tag     = &tags[route->tag_index];
+        uint16_t pos                  = (uint16_t)(offset * 2);
+        uint16_t raw = (uint16_t)(((uint16_t)payload[pos] << 8) | payload[pos + 1]);
+
+        mb_value_store_register(tag->value, (mb_value_type_t)tag->type,
+                                (mb_word_order_t)tag->order, route->word, raw);
+    }
+
+    return MB_SUCCESS;
+}
+
+int mb_scatter_plan_response(void *ctx,
+                             uint16_t plan_index,
+                             uint8_t fc,
+                             const uint8_t *pdu_data,
+                             uint16_t pdu_length) {
+    mb_scatter_ctx_t *scatter_ctx = (mb_scatter_ctx_t *)ctx;
+    if (scatter_ctx == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    const mb_request_plan_t *plan = &scatter_ctx->plans[plan_index];
+
+    // A frame of plausible length that answers another function is not data
+    if ((fc & 0x7F) != plan->function_code) {
+        return MB_ERROR_INVALID_FRAME;
+    }
+
+    if ((fc & 0x80) && scatter_ctx->profiles != NULL && pdu_data != NULL && pdu_length >= 1 &&
+        mb_profile_learn_exception(scatter_ctx->profiles, plan,
+                                   &scatter_ctx->scatter[plan->scatter_first],
+                                   plan->scatter_count, pdu_data[0])) {
+        scatter_ctx->learned = true;
+    }
+
+    if (scatter_ctx->typed_tags != NULL) {
+        return mb_parse_read_typed_scatter(fc, pdu_data, pdu_length, plan->quantity,
+                                           &scatter_ctx->scatter[plan->scatter_first],
+                                           plan->scatter_count, scatter_ctx->typed_tags,
+                                           scatter_ctx->routes);
+    }
+
+    if (scatter_ctx->bits != NULL) {
+        return mb_parse_read_bits_scatter(fc, pdu_data, pdu_length, plan->quantity,
+                                          &scatter_ctx->scatter[plan->scatter_first],
+                                          plan->scatter_count, scatter_ctx->bits);
+    }
+
+    return mb_parse_read_response_scatter(fc, pdu_data, pdu_length, plan->quantity,
+                                          &scatter_ctx->scatter[plan->scatter_first],
+                                          plan->scatter_count, scatter_ctx->data_buffer);
+}
+
 int mb_parse_write_response(uint8_t fc,
                             const uint8_t *pdu_data,
                             uint16_t pdu_length,
@@ -6,6 +6,7 @@
 #ifndef SMARTMODBUS_RESPONSE_PARSER_H
 #define SMARTMODBUS_RESPONSE_PARSER_H
 
+#include "smartmodbus/mb_profile.h"
 #include "smartmodbus/mb_types.h"
 
 #include <stdbool.h>
@@ -30,6 +31,118 @@ int mb_parse_read_response(uint8_t fc,
                            uint16_t quantity,
                            void *data_buffer);
 
+/**
+ * @brief Parse read response and scatter values to their requested slots
+ * @param fc Function code
+ * @param pdu_data PDU data (without slave ID and FC)
+ * @param pdu_length PDU length
+ * @param quantity Quantity read by the plan
+ * @param entries Scatter map entries belonging to this plan
+ * @param entry_count Number of entries
+ * @param data_buffer Output buffer indexed by entry dest_index
+ * @return 0 on success, negative error code on failure
+ *
+ * Registers are written as host-order values; coils/discrete inputs are
+ * written as 0 or 1. Gap units that no entry refers to are never decoded.
+ * An FC23 response carries its read registers like FC03.
+ */
+int mb_parse_read_response_scatter(uint8_t fc,
+                                   const uint8_t *pdu_data,
+                                   uint16_t pdu_length,
+                                   uint16_t quantity,
+                                   const mb_scatter_entry_t *entries,
+                                   uint16_t entry_count,
+                                   uint16_t *data_buffer);
+
+/**
+ * @brief Parse a coil/discrete input response into a packed bitset
+ * @param fc Function code (FC01/02)
+ * @param pdu_data PDU data (without slave ID and FC)
+ * @param pdu_length PDU length
+ * @param quantity Quantity read by the plan
+ * @param entries Scatter map entries belonging to this plan
+ * @param entry_count Number of entries
+ * @param bits Output bitset: bit dest_index receives the entry's value
+ * @return 0 on success, negative error code on failure
+ *
+ * Bits no entry refers to are left unchanged.
+ */
+int mb_parse_read_bits_scatter(uint8_t fc,
+                               const uint8_t *pdu_data,
+                               uint16_t pdu_length,
+                               uint16_t quantity,
+                               const mb_scatter_entry_t *entries,
+                               uint16_t entry_count,
+                               uint32_t *bits);
+
+/**
+ * @brief Destination of one register of a typed read
+ */
+typedef struct {
+    uint16_t tag_index; /**< Tag the register belongs to */
+    uint8_t word;       /**< Position of the register within the value */
+} mb_typed_route_t;
+
+/**
+ * @brief Parse a register response straight into typed tag values
+ * @param fc Function code (FC03/04/23)
+ * @param pdu_data PDU data (without slave ID and FC)
+ * @param pdu_length PDU length
+ * @param quantity Quantity read by the plan
+ * @param entries Scatter map entries belonging to this plan
+ * @param entry_count Number of entries
+ * @param tags Typed tags receiving the values
+ * @param routes Register routes, indexed by entry dest_index
+ * @return 0 on success, negative error code on failure
+ *
+ * Every register is stored into its half-word of the tag value, so a value
+ * whose registers arrive in different responses is complete once all of
+ * them have been parsed.
+ */
+int mb_parse_read_typed_scatter(uint8_t fc,
+                                const uint8_t *pdu_data,
+                                uint16_t pdu_length,
+                                uint16_t quantity,
+                                const mb_scatter_entry_t *entries,
+                                uint16_t entry_count,
+                                const mb_typed_tag_t *tags,
+                                const mb_typed_route_t *routes);
+
+/**
+ * @brief Scatter context shared by the optimized read paths
+ */
+typedef struct {
+    const mb_request_plan_t *plans;    /**< Executed plans */
+    const mb_scatter_entry_t *scatter; /**< Scatter map grouped by plan */
+    uint16_t *data_buffer;             /**< Output buffer (one slot per address) */
+    uint32_t *bits;                    /**< Packed bit output instead of data_buffer (or NULL) */
+    const mb_typed_tag_t *typed_tags;  /**< Typed output instead of data_buffer (or NULL) */
+    const mb_typed_route_t *routes;    /**< Register routes of typed_tags */
+    mb_profile_table_t *profiles;      /**< Learns from exceptions (may be NULL) */
+    bool learned;                      /**< Set when an exception changed a profile */
+} mb_scatter_ctx_t;
+
+/**
+ * @brief Plan response handler that scatters values via the plan's map range
+ * @param ctx Pointer to mb_scatter_ctx_t
+ * @param plan_index Index of the completed plan
+ * @param fc Response function code
+ * @param pdu_data Response PDU data
+ * @param pdu_length Response PDU length
+ * @return 0 on success, negative error code on failure
+ *
+ * Matches the transaction engine's mb_plan_response_fn signature. An
+ * exception response is still reported as MB_ERROR_EXCEPTION_RESPONSE, but
+ * first teaches ctx->profiles what the slave rejected. A response to another
+ * function code than the plan's is MB_ERROR_INVALID_FRAME, and touches
+ * neither the profiles nor the output.
+ */
+int mb_scatter_plan_response(void *ctx,
+                             uint16_t plan_index,
+                             uint8_t fc,
+                             const uint8_t *pdu_data,
+                             uint16_t pdu_length);
+
 /**
  * @brief Parse write response (FC05/06/15/16)
  * @param fc Function code
@@ -0,0 +1,190 @@
+/**
+ * @file ring.c
+ * @brief Lock-free request and completion rings implementation
+ *
+ * Cell i starts with sequence i. A producer at position pos may fill the
+ * cell once its sequence equals pos and publishes it as pos + 1; the
+ * consumer may take it at that value and frees it for the next lap as
+ * pos + capacity. The acquire/release pairs on the sequence order the
+ * payload copy, so head and tail themselves need no ordering.
+ */
+
+#include "smartmodbus/mb_ring.h"
+#include "smartmodbus/mb_error.h"
+#include "smartmodbus/smartmodbus.h"
+#include "transaction.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RING_LOAD(p)             __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define RING_LOAD_RELAXED(p)     __atomic_load_n((p), __ATOMIC_RELAXED)
+#define RING_STORE(p, v)         __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define RING_STORE_RELAXED(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define RING_CAS(p, expected, desired)                             \
+    __atomic_compare_exchange_n((p), (expected), (desired), true, \
+                                __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#else
+// Single-threaded fallback: producers and consumer on one thread
+#define RING_LOAD(p)             (*(p))
+#define RING_LOAD_RELAXED(p)     (*(p))
+#define RING_STORE(p, v)         (*(p) = (v))
+#define RING_STORE_RELAXED(p, v) (*(p) = (v))
+#define RING_CAS(p, expected, desired) \
+    (*(p) == *(expected) ? (*(p) = (desired), true) : (*(expected) = *(p), false))
+#endif
+
+// Largest FC15 write
+#define RING_MAX_COILS 1968
+
+int mb_ring_init(mb_ring_t *ring, mb_ring_cell_t *cells, uint32_t capacity, bool multi_producer) {
+    if (ring == NULL || cells == NULL || capacity < 2 || (capacity & (capacity - 1)) != 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->cells          = cells;
+    ring->mask           = capacity - 1;
+    ring->multi_producer = multi_producer;
+    for (uint32_t i = 0; i < capacity; i++) {
+        cells[i].sequence = i;
+    }
+    return MB_SUCCESS;
+}
+
+bool mb_ring_push(mb_ring_t *ring, const mb_ring_request_t *request) {
+    uint32_t pos = RING_LOAD_RELAXED(&ring->tail);
+    mb_ring_cell_t *cell;
+
+    for (;;) {
+        cell         = &ring->cells[pos & ring->mask];
+        uint32_t seq = RING_LOAD(&cell->sequence);
+        int32_t diff = (int32_t)(seq - pos);
+
+        if (diff == 0) {
+            if (!ring->multi_producer) {
+                RING_STORE_RELAXED(&ring->tail, pos + 1);
+                break;
+            }
+            if (RING_CAS(&ring->tail, &pos, pos + 1)) {
+                break;
+            }
+            // Lost the race: pos now holds the current tail
+        } else if (diff < 0) {
+            return false;  // Cell not yet consumed: full
+        } else {
+            pos = RING_LOAD_RELAXED(&ring->tail);
+        }
+    }
+
+    cell->request = *request;
+    RING_STORE(&cell->sequence, pos + 1);
+    return true;
+}
+
+const mb_ring_request_t *mb_ring_peek(const mb_ring_t *ring) {
+    uint32_t pos               = RING_LOAD_RELAXED(&ring->head);
+    const mb_ring_cell_t *cell = &ring->cells[pos & ring->mask];
+
+    if ((int32_t)(RING_LOAD(&cell->sequence) - (pos + 1)) < 0) {
+        return NULL;
+    }
+    return &cell->request;
+}
+
+bool mb_ring_pop(mb_ring_t *ring, mb_ring_request_t *request) {
+    uint32_t pos         = RING_LOAD_RELAXED(&ring->head);
+    mb_ring_cell_t *cell = &ring->cells[pos & ring->mask];
+
+    if ((int32_t)(RING_LOAD(&cell->sequence) - (pos + 1)) < 0) {
+        return false;
+    }
+
+    *request = cell->request;
+    RING_STORE(&cell->sequence, pos + ring->mask + 1);
+    RING_STORE_RELAXED(&ring->head, pos + 1);
+    return true;
+}
+
+/**
+ * @brief Whether the single producer of ring can push without failing
+ */
+static bool ring_has_space(const mb_ring_t *ring) {
+    uint32_t pos = RING_LOAD_RELAXED(&ring->tail);
+    return RING_LOAD(&ring->cells[pos & ring->mask].sequence) == pos;
+}
+
+static int ring_execute(mb_master_t *master, const mb_ring_request_t *request) {
+    if (request->data == NULL || request->quantity == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    switch (request->function_code) {
+    case MB_FC_READ_COILS:
+    case MB_FC_READ_DISCRETE_INPUTS:
+    case MB_FC_READ_HOLDING_REGISTERS:
+    case MB_FC_READ_INPUT_REGISTERS:
+        return mb_master_read_single(master, request->slave_id, request->function_code,
+                                     request->address, request->quantity, request->data);
+    case MB_FC_WRITE_SINGLE_COIL:
+        return mb_master_write_single_coil(master, request->slave_id, request->address,
+                                           request->data[0] != 0);
+    case MB_FC_WRITE_SINGLE_REGISTER:
+        return mb_master_write_single_register(master, request->slave_id, request->address,
+                                               request->data[0]);
+    case MB_FC_WRITE_MULTIPLE_REGISTERS:
+        return mb_master_write_multiple_registers(master, request->slave_id, request->address,
+                                                  request->quantity, request->data);
+    case MB_FC_WRITE_MULTIPLE_COILS: {
+        if (request->quantity > RING_MAX_COILS) {
+            return MB_ERROR_INVALID_QUANTITY;
+        }
+        bool coils[RING_MAX_COILS];
+        for (uint16_t i = 0; i < request->quantity; i++) {
+            coils[i] = request->data[i] != 0;
+        }
+        return mb_master_write_multiple_coils(master, request->slave_id, request->address,
+                                              request->quantity, coils);
+    }
+    default:
+        return MB_ERROR_INVALID_FC;
+    }
+}
+
+int mb_ring_service(mb_master_t *master,
+                    mb_ring_t *submit,
+                    uint16_t max_requests,
+                    uint16_t *serviced) {
+    if (serviced != NULL) {
+        *serviced = 0;
+    }
+    if (master == NULL || submit == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    uint16_t count = 0;
+    while (max_requests == 0 || count < max_requests) {
+        // Between two requests of another ring the urgent ring goes first
+        if (submit != master->config.urgent && mb_transaction_urgent_pending(master)) {
+            mb_transaction_run_urgent(master);
+        }
+
+        const mb_ring_request_t *next = mb_ring_peek(submit);
+        if (next == NULL || (next->reply != NULL && !ring_has_space(next->reply))) {
+            break;
+        }
+
+        mb_ring_request_t request;
+        (void)mb_ring_pop(submit, &request);
+        request.result = ring_execute(master, &request);
+        if (request.reply != NULL) {
+            (void)mb_ring_push(request.reply, &request);
+        }
+        count++;
+    }
+
+    if (serviced != NULL) {
+        *serviced = count;
+    }
+    return MB_SUCCESS;
+}
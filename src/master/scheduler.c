@@ -0,0 +1,245 @@
+/**
+ * @file scheduler.c
+ * @brief Multi-connection poll scheduler implementation
+ *
+ * Each shard walks its own devices: it submits the device's poll plan once
+ * per cycle and steps the async operation until it finishes. The only
+ * state shared between shards is the cycle number and the remaining/failed
+ * counters, updated atomically.
+ */
+
+#include "smartmodbus/mb_scheduler.h"
+#include "smartmodbus/mb_error.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SCHED_LOAD(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define SCHED_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define SCHED_INC(p)      __atomic_add_fetch((p), 1u, __ATOMIC_RELAXED)
+#define SCHED_DEC(p)      __atomic_sub_fetch((p), 1u, __ATOMIC_ACQ_REL)
+#else
+// Single-threaded fallback: run all shards from one thread
+#define SCHED_LOAD(p)     (*(p))
+#define SCHED_STORE(p, v) (*(p) = (v))
+#define SCHED_INC(p)      (++*(p))
+#define SCHED_DEC(p)      (--*(p))
+#endif
+
+int mb_scheduler_init(mb_scheduler_t *sched,
+                      mb_sched_device_t *devices,
+                      uint16_t capacity,
+                      uint16_t shard_count,
+                      mb_sched_cycle_fn on_cycle,
+                      void *ctx) {
+    if (sched == NULL || (devices == NULL && capacity > 0)) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (shard_count == 0 || shard_count > MB_SCHED_MAX_SHARDS) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    memset(sched, 0, sizeof(*sched));
+    sched->devices         = devices;
+    sched->device_capacity = capacity;
+    sched->shard_count     = shard_count;
+    sched->on_cycle        = on_cycle;
+    sched->ctx             = ctx;
+    return MB_SUCCESS;
+}
+
+int mb_scheduler_add(mb_scheduler_t *sched,
+                     mb_master_t *master,
+                     mb_poll_plan_t *poll,
+                     uint16_t *data_buffer,
+                     uint16_t buffer_size,
+                     uint8_t max_in_flight) {
+    if (sched == NULL || master == NULL || poll == NULL || data_buffer == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (poll->plan_count == 0 || max_in_flight == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (buffer_size < poll->address_count) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    if (sched->device_count >= sched->device_capacity) {
+        return MB_ERROR_TOO_MANY_BLOCKS;
+    }
+
+    master->config.max_in_flight = max_in_flight;
+
+    uint8_t window = max_in_flight;
+    if (master->config.mode != MB_MODE_TCP) {
+        window = 1;
+    } else if (window > MB_MAX_IN_FLIGHT) {
+        window = MB_MAX_IN_FLIGHT;
+    }
+
+    uint16_t index            = sched->device_count++;
+    mb_sched_device_t *device = &sched->devices[index];
+    memset(device, 0, sizeof(*device));
+    device->master      = master;
+    device->poll        = poll;
+    device->data_buffer = data_buffer;
+    device->buffer_size = buffer_size;
+    device->shard       = (uint16_t)(index % sched->shard_count);
+    device->weight      = ((uint32_t)poll->plan_count + window - 1) / window;
+
+    // Never run: the first cycle submits it
+    device->cycle = SCHED_LOAD(&sched->cycle);
+    return (int)index;
+}
+
+void mb_scheduler_balance(mb_scheduler_t *sched) {
+    if (sched == NULL) {
+        return;
+    }
+
+    uint32_t load[MB_SCHED_MAX_SHARDS];
+    memset(load, 0, sizeof(load));
+
+    // Mark all unassigned, then place heaviest first (setup-time, O(n²))
+    for (uint16_t i = 0; i < sched->device_count; i++) {
+        sched->devices[i].shard = UINT16_MAX;
+    }
+
+    for (uint16_t placed = 0; placed < sched->device_count; placed++) {
+        mb_sched_device_t *heaviest = NULL;
+        for (uint16_t i = 0; i < sched->device_count; i++) {
+            mb_sched_device_t *device = &sched->devices[i];
+            if (device->shard == UINT16_MAX &&
+                (heaviest == NULL || device->weight > heaviest->weight)) {
+                heaviest = device;
+            }
+        }
+
+        uint16_t lightest = 0;
+        for (uint16_t s = 1; s < sched->shard_count; s++) {
+            if (load[s] < load[lightest]) {
+                lightest = s;
+            }
+        }
+
+        heaviest->shard = lightest;
+        load[lightest] += heaviest->weight;
+    }
+}
+
+int mb_scheduler_begin_cycle(mb_scheduler_t *sched, uint32_t now_ms) {
+    if (sched == NULL || sched->device_count == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (SCHED_LOAD(&sched->remaining) != 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    sched->failed     = 0;
+    sched->started_ms = now_ms;
+    SCHED_STORE(&sched->remaining, (uint32_t)sched->device_count);
+
+    // Publishing the new cycle number releases the counters above
+    SCHED_STORE(&sched->cycle, sched->cycle + 1);
+    return MB_SUCCESS;
+}
+
+/**
+ * @brief Account a finished device; the last one reports the cycle
+ */
+static void device_finished(mb_scheduler_t *sched,
+                            mb_sched_device_t *device,
+                            int result,
+                            uint32_t now_ms) {
+    device->last_result = result;
+    device->duration_ms = now_ms - device->started_ms;
+
+    if (result != MB_SUCCESS) {
+        SCHED_INC(&sched->failed);
+    }
+
+    if (SCHED_DEC(&sched->remaining) != 0) {
+        return;
+    }
+
+    if (sched->on_cycle != NULL) {
+        mb_sched_cycle_t report;
+        report.cycle       = device->cycle;
+        report.devices     = sched->device_count;
+        report.failed      = (uint16_t)SCHED_LOAD(&sched->failed);
+        report.started_ms  = sched->started_ms;
+        report.finished_ms = now_ms;
+        sched->on_cycle(sched->ctx, &report);
+    }
+}
+
+int mb_scheduler_run_shard(mb_scheduler_t *sched, uint16_t shard, uint32_t now_ms) {
+    if (sched == NULL || shard >= sched->shard_count) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    uint32_t cycle = SCHED_LOAD(&sched->cycle);
+    int busy       = 0;
+
+    for (uint16_t i = 0; i < sched->device_count; i++) {
+        mb_sched_device_t *device = &sched->devices[i];
+        if (device->shard != shard) {
+            continue;
+        }
+
+        // First visit in this cycle: start the poll
+        if (device->cycle != cycle) {
+            device->cycle      = cycle;
+            device->started_ms = now_ms;
+
+            int result = mb_master_submit_poll(device->master, &device->op, device->poll,
+                                               device->data_buffer, device->buffer_size, NULL,
+                                               NULL);
+            if (result != MB_SUCCESS) {
+                device_finished(sched, device, result, now_ms);
+                continue;
+            }
+        }
+
+        if (device->op.state != MB_ASYNC_BUSY) {
+            continue;
+        }
+
+        mb_async_step(&device->op, now_ms);
+
+        if (device->op.state == MB_ASYNC_BUSY) {
+            busy++;
+        } else {
+            device_finished(sched, device, device->op.result, now_ms);
+        }
+    }
+
+    return busy;
+}
+
+bool mb_scheduler_next_deadline(const mb_scheduler_t *sched,
+                                uint16_t shard,
+                                uint32_t *deadline_ms) {
+    if (sched == NULL || deadline_ms == NULL) {
+        return false;
+    }
+
+    bool found = false;
+    for (uint16_t i = 0; i < sched->device_count; i++) {
+        const mb_sched_device_t *device = &sched->devices[i];
+        uint32_t deadline               = 0;
+
+        if (device->shard != shard || !mb_async_next_deadline(&device->op, &deadline)) {
+            continue;
+        }
+        if (!found || (int32_t)(deadline - *deadline_ms) < 0) {
+            *deadline_ms = deadline;
+            found        = true;
+        }
+    }
+    return found;
+}
@@ -0,0 +1,555 @@
+/**
+ * @file slave_profile.c
+ * @brief Learned per-slave device profiles implementation
+ *
+ * The timing fit is an exact least-squares line through the last
+ * MB_PROFILE_WINDOW samples of x (response chars) and y (elapsed us). When
+ * those responses all had about the same length, the slope cannot be told
+ * apart from the intercept and the nominal character time is assumed.
+ *
+ * Holes are kept as a small sorted interval set per slave, ordered by
+ * function code and then address, with overlapping ranges joined.
+ *
+ * An image is a header and the records back to back. The table works on
+ * the records directly and mirrors its count into the header.
+ */
+
+#include "smartmodbus/mb_profile.h"
+#include "smartmodbus/mb_error.h"
+#include "../core/fc_policy.h"
+
+#include <string.h>
+
+// Elapsed times are clamped so the sums cannot overflow
+#define PROFILE_MAX_ELAPSED_US 0xFFFFFFu
+
+// Minimum response length variance (chars²) needed to fit the slope
+#define PROFILE_MIN_VARIANCE 4
+
+int mb_profiles_init(mb_profile_table_t *table,
+                     mb_slave_profile_t *entries,
+                     uint16_t capacity,
+                     uint32_t char_us) {
+    if (table == NULL || (entries == NULL && capacity > 0) || char_us == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    table->entries  = entries;
+    table->capacity = capacity;
+    table->count    = 0;
+    table->char_us  = char_us;
+    table->image    = NULL;
+    return MB_SUCCESS;
+}
+
+size_t mb_profile_image_size(uint16_t capacity) {
+    return sizeof(mb_profile_image_t) + (size_t)capacity * sizeof(mb_slave_profile_t);
+}
+
+/**
+ * @brief Records following an image header
+ */
+static mb_slave_profile_t *image_records(mb_profile_image_t *image) {
+    return (mb_slave_profile_t *)(void *)((uint8_t *)image + sizeof(mb_profile_image_t));
+}
+
+static int image_check_storage(const mb_profile_table_t *table,
+                               const void *image,
+                               size_t size,
+                               uint32_t char_us) {
+    if (table == NULL || image == NULL || char_us == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+    if (((uintptr_t)image % sizeof(uint32_t)) != 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+    if (size < mb_profile_image_size(0)) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+    return MB_SUCCESS;
+}
+
+int mb_profiles_format(mb_profile_table_t *table, void *image, size_t size, uint32_t char_us) {
+    int result = image_check_storage(table, image, size, char_us);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    size_t records = (size - sizeof(mb_profile_image_t)) / sizeof(mb_slave_profile_t);
+    mb_profile_image_t *header = (mb_profile_image_t *)image;
+    memset(header, 0, sizeof(*header));
+    header->magic       = MB_PROFILE_IMAGE_MAGIC;
+    header->version     = MB_PROFILE_IMAGE_VERSION;
+    header->record_size = (uint16_t)sizeof(mb_slave_profile_t);
+    header->capacity    = (uint16_t)(records < UINT16_MAX ? records : UINT16_MAX);
+    header->count       = 0;
+    header->char_us     = char_us;
+
+    mb_profiles_init(table, image_records(header), header->capacity, char_us);
+    table->image = header;
+    return MB_SUCCESS;
+}
+
+int mb_profiles_attach(mb_profile_table_t *table, void *image, size_t size, uint32_t char_us) {
+    int result = image_check_storage(table, image, size, char_us);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    mb_profile_image_t *header = (mb_profile_image_t *)image;
+    if (header->magic != MB_PROFILE_IMAGE_MAGIC) {
+        return MB_ERROR_INVALID_FRAME;
+    }
+    if (header->version != MB_PROFILE_IMAGE_VERSION ||
+        header->record_size != sizeof(mb_slave_profile_t)) {
+        return MB_ERROR_NOT_SUPPORTED;
+    }
+    if (header->count > header->capacity || mb_profile_image_size(header->capacity) > size) {
+        return MB_ERROR_INVALID_FRAME;
+    }
+
+    // Every record must be usable as is: sorted IDs and in-range counters
+    const mb_slave_profile_t *records = image_records(header);
+    for (uint16_t i = 0; i < header->count; i++) {
+        const mb_slave_profile_t *profile = &records[i];
+        if ((i > 0 && records[i - 1].slave_id >= profile->slave_id) ||
+            profile->window_next >= MB_PROFILE_WINDOW ||
+            profile->hole_count > MB_PROFILE_MAX_HOLES) {
+            return MB_ERROR_INVALID_FRAME;
+        }
+    }
+
+    // Probe times belong to the clock of the previous run: start online
+    mb_slave_profile_t *entries = image_records(header);
+    for (uint16_t i = 0; i < header->count; i++) {
+        entries[i].timeouts = 0;
+        entries[i].offline  = 0;
+    }
+
+    header->char_us = char_us;
+    table->entries  = entries;
+    table->capacity = header->capacity;
+    table->count    = header->count;
+    table->char_us  = char_us;
+    table->image    = header;
+    return MB_SUCCESS;
+}
+
+/**
+ * @brief Binary search for slave_id
+ * @return Index of the profile, or of the insertion point if absent
+ */
+static uint16_t profile_search(const mb_profile_table_t *table, uint8_t slave_id) {
+    uint16_t low  = 0;
+    uint16_t high = table->count;
+
+    while (low < high) {
+        uint16_t mid = (uint16_t)((low + high) / 2);
+        if (table->entries[mid].slave_id < slave_id) {
+            low = (uint16_t)(mid + 1);
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+mb_slave_profile_t *mb_profile_find(const mb_profile_table_t *table, uint8_t slave_id) {
+    if (table == NULL) {
+        return NULL;
+    }
+
+    uint16_t index = profile_search(table, slave_id);
+    if (index < table->count && table->entries[index].slave_id == slave_id) {
+        return &table->entries[index];
+    }
+    return NULL;
+}
+
+mb_slave_profile_t *mb_profile_acquire(mb_profile_table_t *table, uint8_t slave_id) {
+    if (table == NULL) {
+        return NULL;
+    }
+
+    uint16_t index = profile_search(table, slave_id);
+    if (index < table->count && table->entries[index].slave_id == slave_id) {
+        return &table->entries[index];
+    }
+
+    if (table->count >= table->capacity) {
+        return NULL;
+    }
+
+    memmove(&table->entries[index + 1], &table->entries[index],
+            (size_t)(table->count - index) * sizeof(mb_slave_profile_t));
+    table->count++;
+    if (table->image != NULL) {
+        table->image->count = table->count;
+    }
+
+    mb_slave_profile_t *profile = &table->entries[index];
+    memset(profile, 0, sizeof(*profile));
+    profile->slave_id = slave_id;
+    profile->char_us  = table->char_us;
+    return profile;
+}
+
+int mb_profile_record(mb_profile_table_t *table,
+                      uint8_t slave_id,
+                      uint16_t response_chars,
+                      uint32_t elapsed_us) {
+    if (table == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    mb_slave_profile_t *profile = mb_profile_acquire(table, slave_id);
+    if (profile == NULL) {
+        return MB_ERROR_TOO_MANY_BLOCKS;
+    }
+
+    uint32_t elapsed = elapsed_us < PROFILE_MAX_ELAPSED_US ? elapsed_us : PROFILE_MAX_ELAPSED_US;
+
+    profile->window_chars[profile->window_next] = response_chars;
+    profile->window_us[profile->window_next]    = elapsed;
+    profile->window_next = (uint8_t)((profile->window_next + 1u) % MB_PROFILE_WINDOW);
+    if (profile->samples < UINT16_MAX) {
+        profile->samples++;
+    }
+
+    int64_t n      = profile->samples < MB_PROFILE_WINDOW ? profile->samples : MB_PROFILE_WINDOW;
+    int64_t sum_x  = 0;
+    int64_t sum_y  = 0;
+    int64_t sum_xx = 0;
+    int64_t sum_xy = 0;
+    for (int64_t i = 0; i < n; i++) {
+        int64_t x = profile->window_chars[i];
+        int64_t y = profile->window_us[i];
+        sum_x += x;
+        sum_y += y;
+        sum_xx += x * x;
+        sum_xy += x * y;
+    }
+
+    // Slope from the fit when response lengths varied enough; nothing
+    // arrives faster than the line allows
+    int64_t denom   = n * sum_xx - sum_x * sum_x;
+    int64_t slope   = table->char_us;
+    int64_t latency = (sum_y - slope * sum_x) / n;
+
+    if (denom >= PROFILE_MIN_VARIANCE * n * n) {
+        int64_t fitted = (n * sum_xy - sum_x * sum_y) / denom;
+        if (fitted > slope) {
+            slope   = fitted;
+            latency = (sum_y * sum_xx - sum_x * sum_xy) / denom;
+        }
+    }
+
+    profile->char_us    = (uint32_t)slope;
+    profile->latency_us = (uint32_t)(latency > 0 ? latency : 0);
+
+    // Turnaround of this response, smoothed as RFC 6298 smooths round-trips
+    int64_t sample = (int64_t)elapsed - slope * response_chars;
+    sample         = sample > 1 ? sample : 1;
+    if (profile->srtt_us == 0) {
+        profile->srtt_us   = (uint32_t)sample;
+        profile->rttvar_us = (uint32_t)(sample / 2);
+    } else {
+        int64_t delta      = sample > profile->srtt_us ? sample - profile->srtt_us
+                                                       : profile->srtt_us - sample;
+        profile->rttvar_us = (uint32_t)((3 * (int64_t)profile->rttvar_us + delta) / 4);
+        profile->srtt_us   = (uint32_t)((7 * (int64_t)profile->srtt_us + sample) / 8);
+    }
+
+    profile->timeouts = 0;
+    profile->offline  = 0;
+    return MB_SUCCESS;
+}
+
+/**
+ * @brief Clock ticks between probes; the wrap-safe comparison allows half the clock range
+ */
+static uint32_t probe_interval_us(const mb_timeout_policy_t *policy) {
+    uint32_t limit_ms = (uint32_t)INT32_MAX / 1000u;
+    return (policy->probe_ms < limit_ms ? policy->probe_ms : limit_ms) * 1000u;
+}
+
+bool mb_profile_record_timeout(mb_profile_table_t *table,
+                               uint8_t slave_id,
+                               const mb_timeout_policy_t *policy,
+                               uint32_t now_us) {
+    mb_slave_profile_t *profile = mb_profile_acquire(table, slave_id);
+    if (profile == NULL || policy == NULL) {
+        return false;
+    }
+
+    if (profile->timeouts < UINT8_MAX) {
+        profile->timeouts++;
+    }
+    if (policy->offline_after == 0 || profile->timeouts < policy->offline_after) {
+        return false;
+    }
+
+    bool demoted      = profile->offline == 0;
+    profile->offline  = 1;
+    profile->probe_us = now_us + probe_interval_us(policy);
+    return demoted;
+}
+
+bool mb_profile_admit(mb_profile_table_t *table,
+                      uint8_t slave_id,
+                      const mb_timeout_policy_t *policy,
+                      uint32_t now_us) {
+    mb_slave_profile_t *profile = mb_profile_find(table, slave_id);
+    if (profile == NULL || profile->offline == 0 || policy == NULL) {
+        return true;
+    }
+
+    if ((int32_t)(now_us - profile->probe_us) < 0) {
+        return false;
+    }
+
+    profile->probe_us = now_us + probe_interval_us(policy);
+    return true;
+}
+
+uint32_t mb_profile_timeout_ms(const mb_profile_table_t *table,
+                               uint8_t slave_id,
+                               uint16_t response_chars,
+                               const mb_timeout_policy_t *policy,
+                               uint32_t fallback_ms) {
+    const mb_slave_profile_t *profile = mb_profile_find(table, slave_id);
+    uint64_t timeout_us               = (uint64_t)fallback_ms * 1000u;
+
+    if (profile != NULL && profile->srtt_us > 0) {
+        uint64_t spread = 4u * (uint64_t)profile->rttvar_us;
+        if (spread < MB_PROFILE_TIMEOUT_GRANULARITY_US) {
+            spread = MB_PROFILE_TIMEOUT_GRANULARITY_US;
+        }
+        timeout_us = profile->srtt_us + spread + (uint64_t)response_chars * profile->char_us;
+    }
+
+    // Back off after each timeout in a row, as TCP does
+    if (profile != NULL) {
+        timeout_us <<= profile->timeouts < 16 ? profile->timeouts : 16;
+    }
+
+    uint64_t timeout_ms = (timeout_us + 999u) / 1000u;
+    if (policy != NULL && timeout_ms < policy->min_ms) {
+        timeout_ms = policy->min_ms;
+    }
+    if (policy != NULL && policy->max_ms > 0 && timeout_ms > policy->max_ms) {
+        timeout_ms = policy->max_ms;
+    }
+    return (uint32_t)(timeout_ms < UINT32_MAX ? timeout_ms : UINT32_MAX);
+}
+
+uint8_t mb_profile_latency_chars(const mb_profile_table_t *table,
+                                 uint8_t slave_id,
+                                 uint8_t fallback) {
+    const mb_slave_profile_t *profile = mb_profile_find(table, slave_id);
+    if (profile == NULL || profile->samples < MB_PROFILE_MIN_SAMPLES || profile->char_us == 0) {
+        return fallback;
+    }
+
+    // In the slave's own character times: merged gap units arrive at that
+    // rate, so the merge trade-off is latency against slow characters
+    uint32_t chars = (profile->latency_us + profile->char_us / 2) / profile->char_us;
+    return (uint8_t)(chars < UINT8_MAX ? chars : UINT8_MAX);
+}
+
+static bool hole_before(const mb_profile_hole_t *hole, uint8_t fc, uint16_t first) {
+    return hole->function_code < fc || (hole->function_code == fc && hole->first < first);
+}
+
+bool mb_profile_add_hole(mb_profile_table_t *table,
+                         uint8_t slave_id,
+                         uint8_t fc,
+                         uint16_t first,
+                         uint16_t last) {
+    mb_slave_profile_t *profile = mb_profile_acquire(table, slave_id);
+    if (profile == NULL || first > last) {
+        return false;
+    }
+
+    // Already covered: nothing new
+    for (uint8_t i = 0; i < profile->hole_count; i++) {
+        const mb_profile_hole_t *hole = &profile->holes[i];
+        if (hole->function_code == fc && hole->first <= first && last <= hole->last) {
+            return false;
+        }
+    }
+
+    // Absorb every hole that overlaps or touches the new range
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < profile->hole_count; i++) {
+        mb_profile_hole_t hole = profile->holes[i];
+        if (hole.function_code == fc && (uint32_t)hole.first <= (uint32_t)last + 1u &&
+            (uint32_t)first <= (uint32_t)hole.last + 1u) {
+            first = hole.first < first ? hole.first : first;
+            last  = hole.last > last ? hole.last : last;
+            continue;
+        }
+        profile->holes[kept++] = hole;
+    }
+    profile->hole_count = kept;
+
+    if (profile->hole_count == MB_PROFILE_MAX_HOLES) {
+        // Full: widen the nearest hole of this address space instead
+        uint8_t nearest   = MB_PROFILE_MAX_HOLES;
+        uint32_t distance = UINT32_MAX;
+        for (uint8_t i = 0; i < profile->hole_count; i++) {
+            const mb_profile_hole_t *hole = &profile->holes[i];
+            if (hole->function_code != fc) {
+                continue;
+            }
+            uint32_t d = hole->last < first ? (uint32_t)(first - hole->last)
+                                            : (uint32_t)(hole->first - last);
+            if (d < distance) {
+                distance = d;
+                nearest  = i;
+            }
+        }
+        if (nearest == MB_PROFILE_MAX_HOLES) {
+            return false;
+        }
+
+        first = profile->holes[nearest].first < first ? profile->holes[nearest].first : first;
+        last  = profile->holes[nearest].last > last ? profile->holes[nearest].last : last;
+        memmove(&profile->holes[nearest], &profile->holes[nearest + 1],
+                (size_t)(profile->hole_count - nearest - 1) * sizeof(mb_profile_hole_t));
+        profile->hole_count--;
+    }
+
+    uint8_t index = 0;
+    while (index < profile->hole_count && hole_before(&profile->holes[index], fc, first)) {
+        index++;
+    }
+    memmove(&profile->holes[index + 1], &profile->holes[index],
+            (size_t)(profile->hole_count - index) * sizeof(mb_profile_hole_t));
+    profile->holes[index].first         = first;
+    profile->holes[index].last          = last;
+    profile->holes[index].function_code = fc;
+    profile->hole_count++;
+    return true;
+}
+
+bool mb_profile_gap_forbidden(const mb_profile_table_t *table,
+                              uint8_t slave_id,
+                              uint8_t fc,
+                              uint16_t first,
+                              uint16_t last) {
+    const mb_slave_profile_t *profile = mb_profile_find(table, slave_id);
+    if (profile == NULL) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < profile->hole_count; i++) {
+        const mb_profile_hole_t *hole = &profile->holes[i];
+        if (hole->function_code == fc && hole->first <= last && first <= hole->last) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint16_t mb_profile_max_quantity(const mb_profile_table_t *table, uint8_t slave_id, uint8_t fc) {
+    const mb_slave_profile_t *profile = mb_profile_find(table, slave_id);
+    if (profile == NULL) {
+        return 0;
+    }
+    return mb_fc_get_unit_size(fc) == 1 ? profile->max_bits : profile->max_registers;
+}
+
+int mb_profile_set_fc23(mb_profile_table_t *table, uint8_t slave_id, mb_fc23_support_t support) {
+    if (table == NULL || support > MB_FC23_UNSUPPORTED) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    mb_slave_profile_t *profile = mb_profile_acquire(table, slave_id);
+    if (profile == NULL) {
+        return MB_ERROR_TOO_MANY_BLOCKS;
+    }
+
+    profile->fc23 = (uint8_t)support;
+    return MB_SUCCESS;
+}
+
+mb_fc23_support_t mb_profile_fc23(const mb_profile_table_t *table, uint8_t slave_id) {
+    const mb_slave_profile_t *profile = mb_profile_find(table, slave_id);
+    if (profile == NULL || profile->fc23 > MB_FC23_UNSUPPORTED) {
+        return MB_FC23_UNKNOWN;
+    }
+    return (mb_fc23_support_t)profile->fc23;
+}
+
+bool mb_profile_learn_exception(mb_profile_table_t *table,
+                                const mb_request_plan_t *plan,
+                                const mb_scatter_entry_t *entries,
+                                uint16_t entry_count,
+                                uint8_t exception_code) {
+    if (table == NULL || plan == NULL || (entries == NULL && entry_count > 0)) {
+        return false;
+    }
+
+    uint16_t max_quantity = mb_fc_get_max_quantity(plan->function_code);
+    if (plan->quantity == 0 || plan->quantity > max_quantity) {
+        return false;
+    }
+
+    if (exception_code == MB_EX_ILLEGAL_DATA_VALUE) {
+        if (plan->quantity < 2) {
+            return false;
+        }
+
+        mb_slave_profile_t *profile = mb_profile_acquire(table, plan->slave_id);
+        if (profile == NULL) {
+            return false;
+        }
+
+        uint16_t *limit = mb_fc_get_unit_size(plan->function_code) == 1 ? &profile->max_bits
+                                                                        : &profile->max_registers;
+        uint16_t halved = (uint16_t)(plan->quantity / 2);
+        if (*limit != 0 && *limit <= halved) {
+            return false;
+        }
+        *limit = halved;
+        return true;
+    }
+
+    if (exception_code != MB_EX_ILLEGAL_DATA_ADDRESS) {
+        return false;
+    }
+
+    // Which units of the span were actually requested
+    uint8_t requested[(2000 + 7) / 8];
+    memset(requested, 0, sizeof(requested));
+    for (uint16_t i = 0; i < entry_count; i++) {
+        uint16_t offset = entries[i].offset;
+        if (offset < plan->quantity) {
+            requested[offset / 8] = (uint8_t)(requested[offset / 8] | (1u << (offset % 8)));
+        }
+    }
+
+    // Every unrequested run is a suspect
+    bool learned   = false;
+    uint16_t offset = 0;
+    while (offset < plan->quantity) {
+        if (requested[offset / 8] & (1u << (offset % 8))) {
+            offset++;
+            continue;
+        }
+
+        uint16_t run_end = offset;
+        while (run_end + 1u < plan->quantity &&
+               !(requested[(run_end + 1u) / 8] & (1u << ((run_end + 1u) % 8)))) {
+            run_end++;
+        }
+
+        learned |= mb_profile_add_hole(table, plan->slave_id, plan->function_code,
+                                       (uint16_t)(plan->start_address + offset),
+                                       (uint16_t)(plan->start_address + run_end));
+        offset = (uint16_t)(run_end + 1u);
+    }
+
+    return learned;
+}
@@ -0,0 +1,67 @@
+/**
+ * @file trace.h
+ * @brief Trace hook emission
+ *
+ * MB_TRACE() expands to nothing unless the library is built with
+ * MB_ENABLE_TRACE, so trace points cost nothing in a normal build. With
+ * it, an unset hook costs one branch per point.
+ */
+
+#ifndef SMARTMODBUS_TRACE_H
+#define SMARTMODBUS_TRACE_H
+
+#include "smartmodbus/mb_config.h"
+#include "smartmodbus/mb_trace.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef MB_ENABLE_TRACE
+
+static inline void mb_trace_emit(const mb_config_t *config,
+                                 mb_trace_event_t event,
+                                 uint8_t slave_id,
+                                 uint8_t fc,
+                                 uint32_t chars,
+                                 int result) {
+    const mb_trace_t *trace = &config->trace;
+    if (trace->hook == NULL) {
+        return;
+    }
+
+    mb_trace_record_t record;
+    record.event         = event;
+    record.slave_id      = slave_id;
+    record.function_code = fc;
+    record.chars         = (uint16_t)(chars < UINT16_MAX ? chars : UINT16_MAX);
+    record.result        = result;
+    if (trace->clock_us != NULL) {
+        record.timestamp_us = trace->clock_us(trace->context);
+    } else if (config->transport.clock_us != NULL) {
+        record.timestamp_us = config->transport.clock_us(config->transport.context);
+    } else {
+        record.timestamp_us = 0;
+    }
+    trace->hook(trace->context, &record);
+}
+
+#define MB_TRACE(config, event, slave_id, fc, chars, result) \
+    mb_trace_emit((config), (event), (slave_id), (fc), (uint32_t)(chars), (result))
+
+#else
+
+// Arguments are referenced but never evaluated
+#define MB_TRACE(config, event, slave_id, fc, chars, result)                            \
+    ((void)sizeof(config), (void)sizeof(event), (void)sizeof(slave_id), (void)sizeof(fc), \
+     (void)sizeof(chars), (void)sizeof(result))
+
+#endif  // MB_ENABLE_TRACE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_TRACE_H
@@ -0,0 +1,1120 @@
+/**
+ * @file transaction.c
+ * @brief Request/response transaction engine implementation
+ *
+ * Serial modes (RTU/ASCII) run strictly stop-and-wait. TCP responses are
+ * reassembled from the byte stream using the MBAP length field and matched
+ * to outstanding requests by transaction ID.
+ */
+
+#include "transaction.h"
+#include "trace.h"
+
+#include "../core/fc_policy.h"
+#include "../protocol/frame_builder.h"
+#ifdef MB_ENABLE_RTU
+#include "../protocol/rtu_frame.h"
+#endif
+#include "smartmodbus/mb_error.h"
+#include "smartmodbus/mb_ring.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * @brief MBAP header size up to and including the length field
+ */
+#define MBAP_PREFIX_CHARS 6
+
+/**
+ * @brief RTU response bytes that determine the frame length
+ */
+#define RTU_HEADER_CHARS 3
+
+/**
+ * @brief Outstanding pipelined request
+ */
+typedef struct {
+    uint16_t transaction_id;
+    uint16_t plan_index;
+    uint32_t sent_us;
+    bool in_flight;
+    uint8_t frame[MB_PLAN_FRAME_CHARS]; /**< Staged request of a plan without a prebuilt frame */
+} inflight_slot_t;
+
+/**
+ * @brief Requests staged for one send_frames() call
+ */
+typedef struct {
+    mb_frame_vec_t frames[MB_MAX_IN_FLIGHT];
+    uint16_t plan_index[MB_MAX_IN_FLIGHT];
+    uint8_t count;
+} send_batch_t;
+
+/**
+ * @brief Frame format of master's mode, a constant in MB_FIXED_MODE builds
+ */
+static inline mb_mode_t master_mode(const mb_master_t *master) {
+    return MB_MODE_FRAMING(MB_ACTIVE_MODE(master->config.mode));
+}
+
+static uint16_t next_transaction_id(mb_master_t *master) {
+    return master->transaction_id++;
+}
+
+static int transport_send(mb_master_t *master,
+                          uint8_t slave_id,
+                          uint8_t fc,
+                          const uint8_t *frame,
+                          uint16_t frame_length) {
+    if (master->config.transport.send == NULL) {
+        return MB_ERROR_TRANSPORT;
+    }
+
+    MB_TRACE(&master->config, MB_TRACE_SEND_BEGIN, slave_id, fc, frame_length, MB_SUCCESS);
+    int sent = master->config.transport.send(master->config.transport.context, frame, frame_length);
+    MB_TRACE(&master->config, MB_TRACE_SEND_END, slave_id, fc, frame_length,
+             sent < 0 ? MB_ERROR_TRANSPORT : MB_SUCCESS);
+    if (sent < 0) {
+        return MB_ERROR_TRANSPORT;
+    }
+
+    master->stats.total_requests++;
+    master->stats.total_chars_sent += frame_length;
+    mb_metrics_record_request(master->config.metrics, slave_id, fc, frame_length);
+    return MB_SUCCESS;
+}
+
+/**
+ * @brief Hand every staged request to send_frames() in one call
+ */
+static int transport_send_batch(mb_master_t *master,
+                                const mb_request_plan_t *plans,
+                                send_batch_t *batch) {
+    if (batch->count == 0) {
+        return MB_SUCCESS;
+    }
+
+    for (uint8_t i = 0; i < batch->count; i++) {
+        const mb_request_plan_t *plan = &plans[batch->plan_index[i]];
+        MB_TRACE(&master->config, MB_TRACE_SEND_BEGIN, plan->slave_id, plan->function_code,
+                 batch->frames[i].len, MB_SUCCESS);
+    }
+    int sent = master->config.transport.send_frames(master->config.transport.context,
+                                                    batch->frames, batch->count);
+    for (uint8_t i = 0; i < batch->count; i++) {
+        const mb_request_plan_t *plan = &plans[batch->plan_index[i]];
+        MB_TRACE(&master->config, MB_TRACE_SEND_END, plan->slave_id, plan->function_code,
+                 batch->frames[i].len, sent < 0 ? MB_ERROR_TRANSPORT : MB_SUCCESS);
+    }
+
+    uint8_t count = batch->count;
+    batch->count  = 0;
+    if (sent < 0) {
+        return MB_ERROR_TRANSPORT;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        const mb_request_plan_t *plan = &plans[batch->plan_index[i]];
+        uint16_t frame_length         = (uint16_t)batch->frames[i].len;
+        master->stats.total_requests++;
+        master->stats.total_chars_sent += frame_length;
+        mb_metrics_record_request(master->config.metrics, plan->slave_id, plan->function_code,
+                                  frame_length);
+    }
+    return MB_SUCCESS;
+}
+
+static int transport_recv(mb_master_t *master, uint8_t *buffer, size_t max_len, size_t *received) {
+    if (master->config.transport.recv == NULL) {
+        return MB_ERROR_TRANSPORT;
+    }
+
+    *received  = 0;
+    int result = master->config.transport.recv(master->config.transport.context, buffer, max_len,
+                                               received);
+    if (result < 0 || *received == 0) {
+        return MB_ERROR_TIMEOUT;
+    }
+
+    master->stats.total_chars_recv += (uint32_t)*received;
+    return MB_SUCCESS;
+}
+
+/**
+ * @brief Read more bytes from the TCP stream into the accumulator
+ */
+static int tcp_rx_fill(mb_master_t *master, mb_tcp_rx_t *rx) {
+    size_t received = 0;
+    int result = transport_recv(master, &rx->buffer[rx->length], sizeof(rx->buffer) - rx->length,
+                                &received);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    rx->length += received;
+    return MB_SUCCESS;
+}
+
+/**
+ * @brief Get length of the complete frame at the head of the accumulator
+ * @return Frame length, 0 if incomplete, negative error code if malformed
+ */
+static int tcp_rx_peek(const mb_tcp_rx_t *rx) {
+    if (rx->length < MBAP_PREFIX_CHARS) {
+        return 0;
+    }
+
+    uint16_t length    = (uint16_t)(((uint16_t)rx->buffer[4] << 8) | rx->buffer[5]);
+    size_t frame_chars = MBAP_PREFIX_CHARS + (size_t)length;
+
+    // Unit ID + FC at minimum, never more than one ADU
+    if (length < 2 || frame_chars > MB_TCP_MAX_ADU_CHARS) {
+        return MB_ERROR_INVALID_FRAME;
+    }
+
+    if (rx->length < frame_chars) {
+        return 0;
+    }
+
+    return (int)frame_chars;
+}
+
+/**
+ * @brief Drop the frame at the head of the accumulator
+ */
+static void tcp_rx_consume(mb_tcp_rx_t *rx, size_t frame_chars) {
+    rx->length -= frame_chars;
+    if (rx->length > 0) {
+        memmove(rx->buffer, &rx->buffer[frame_chars], rx->length);
+    }
+}
+
+/**
+ * @brief Current time for round-trip timing, 0 when nothing records it
+ */
+static uint32_t round_trip_clock(const mb_master_t *master) {
+    if ((master->config.profiles == NULL && master->config.metrics == NULL) ||
+        master->config.transport.clock_us == NULL) {
+        return 0;
+    }
+    return master->config.transport.clock_us(master->config.transport.context);
+}
+
+/**
+ * @brief Learned timeouts need a policy, profiles to learn in and a clock
+ */
+static bool adaptive_timeouts(const mb_master_t *master) {
+    return master->config.timeouts.max_ms > 0 && master->config.profiles != NULL &&
+           master->config.transport.clock_us != NULL;
+}
+
+/**
+ * @brief Length of the response frame to a request, the largest frame if unknown
+ */
+static uint16_t response_chars(const mb_master_t *master, uint8_t fc, uint16_t quantity) {
+    uint16_t data_chars = MB_MAX_PDU_DATA;
+
+    switch (fc) {
+    case MB_FC_READ_COILS:
+    case MB_FC_READ_DISCRETE_INPUTS:
+        data_chars = (uint16_t)(1 + (quantity + 7) / 8);
+        break;
+    case MB_FC_READ_HOLDING_REGISTERS:
+    case MB_FC_READ_INPUT_REGISTERS:
+    case MB_FC_READ_WRITE_MULTIPLE_REGISTERS:
+        data_chars = (uint16_t)(1 + 2 * quantity);
+        break;
+    case MB_FC_WRITE_SINGLE_COIL:
+    case MB_FC_WRITE_SINGLE_REGISTER:
+    case MB_FC_WRITE_MULTIPLE_COILS:
+    case MB_FC_WRITE_MULTIPLE_REGISTERS:
+        data_chars = 4;
+        break;
+    default:
+        break;
+    }
+
+    if (data_chars > MB_MAX_PDU_DATA) {
+        data_chars = MB_MAX_PDU_DATA;
+    }
+    return mb_calc_frame_length(data_chars, master_mode(master));
+}
+
+/**
+ * @brief Quantity field of a request PDU (reads and FC23 read part), 0 otherwise
+ */
+static uint16_t request_quantity(uint8_t fc, const uint8_t *pdu_data, uint16_t pdu_length) {
+    if (pdu_data == NULL || pdu_length < 4 ||
+        (fc > MB_FC_READ_INPUT_REGISTERS && fc != MB_FC_READ_WRITE_MULTIPLE_REGISTERS)) {
+        return 0;
+    }
+    return (uint16_t)((pdu_data[2] << 8) | pdu_data[3]);
+}
+
+uint32_t mb_transaction_timeout_ms(const mb_master_t *master,
+                                   uint8_t slave_id,
+                                   uint8_t fc,
+                                   uint16_t quantity) {
+    if (!adaptive_timeouts(master)) {
+        return master->config.timeout_ms;
+    }
+    return mb_profile_timeout_ms(master->config.profiles, slave_id,
+                                 response_chars(master, fc, quantity), &master->config.timeouts,
+                                 master->config.timeout_ms);
+}
+
+/**
+ * @brief Admit a request to the line and hand its timeout to the transport
+ * @return MB_SUCCESS, MB_ERROR_INVALID_ADDRESS for a serial broadcast (it
+ *         would never be answered), or MB_ERROR_SLAVE_OFFLINE while the
+ *         slave waits for its next probe
+ */
+static int prepare_request(mb_master_t *master, uint8_t slave_id, uint8_t fc, uint16_t quantity) {
+    if (mb_transaction_is_broadcast(master, slave_id)) {
+        return MB_ERROR_INVALID_ADDRESS;
+    }
+    if (!adaptive_timeouts(master)) {
+        return MB_SUCCESS;
+    }
+
+    uint32_t now_us = master->config.transport.clock_us(master->config.transport.context);
+    if (!mb_profile_admit(master->config.profiles, slave_id, &master->config.timeouts, now_us)) {
+        master->stats.offline_skipped++;
+        return MB_ERROR_SLAVE_OFFLINE;
+    }
+
+    if (master->config.transport.set_timeout != NULL) {
+        master->config.transport.set_timeout(master->config.transport.context,
+                                             mb_transaction_timeout_ms(master, slave_id, fc,
+                                                                       quantity));
+    }
+    return MB_SUCCESS;
+}
+
+/**
+ * @brief Slave waiting for an answer to its probes
+ */
+static bool slave_offline(const mb_master_t *master, uint8_t slave_id) {
+    const mb_slave_profile_t *profile =
+        adaptive_timeouts(master) ? mb_profile_find(master->config.profiles, slave_id) : NULL;
+    return profile != NULL && profile->offline != 0;
+}
+
+/**
+ * @brief A slave answered a pipelined request (those are not timed into its profile)
+ */
+static void record_alive(mb_master_t *master, uint8_t slave_id) {
+    mb_slave_profile_t *profile =
+        adaptive_timeouts(master) ? mb_profile_find(master->config.profiles, slave_id) : NULL;
+    if (profile != NULL) {
+        profile->timeouts = 0;
+        profile->offline  = 0;
+    }
+}
+
+/**
+ * @brief Count a request without a response towards putting its slave offline
+ */
+static void record_timeout(mb_master_t *master, uint8_t slave_id) {
+    if (adaptive_timeouts(master)) {
+        (void)mb_profile_record_timeout(
+            master->config.profiles, slave_id, &master->config.timeouts,
+            master->config.transport.clock_us(master->config.transport.context));
+    }
+}
+
+/**
+ * @brief Record the outcome of a stop-and-wait round-trip
+ * @param result receive_response() result
+ * @param exception The response was an exception
+ * @param start_us round_trip_clock() right after the request was sent
+ * @param chars_before stats.total_chars_recv at that time
+ *
+ * Completed round-trips are timed into the slave's profile; every outcome
+ * goes to the metrics.
+ */
+static void round_trip_done(mb_master_t *master,
+                            uint8_t slave_id,
+                            uint8_t fc,
+                            int result,
+                            bool exception,
+                            uint32_t start_us,
+                            uint32_t chars_before) {
+    bool timed = master->config.transport.clock_us != NULL;
+    if (!timed && master->config.metrics == NULL) {
+        return;
+    }
+
+    uint32_t elapsed = timed ? round_trip_clock(master) - start_us : 0;
+    uint32_t chars   = master->stats.total_chars_recv - chars_before;
+
+    if (result == MB_SUCCESS && timed && master->config.profiles != NULL) {
+        (void)mb_profile_record(master->config.profiles, slave_id,
+                                (uint16_t)(chars < UINT16_MAX ? chars : UINT16_MAX), elapsed);
+    } else if (result == MB_ERROR_TIMEOUT) {
+        record_timeout(master, slave_id);
+    }
+    mb_metrics_record_response(master->config.metrics, slave_id, fc, result, exception, chars,
+                               timed ? elapsed : MB_METRICS_UNTIMED);
+}
+
+/**
+ * @brief Count every outstanding pipelined request as failed
+ *
+ * A timeout is counted once towards putting the slave offline, as one
+ * silent connection, not once per request it swallowed.
+ */
+static void abandon_in_flight(mb_master_t *master,
+                              const mb_request_plan_t *plans,
+                              const inflight_slot_t *slots,
+                              uint8_t window,
+                              int result) {
+    bool counted = result != MB_ERROR_TIMEOUT;
+
+    for (uint8_t i = 0; i < window; i++) {
+        if (!slots[i].in_flight) {
+            continue;
+        }
+
+        const mb_request_plan_t *plan = &plans[slots[i].plan_index];
+        if (!counted) {
+            record_timeout(master, plan->slave_id);
+            counted = true;
+        }
+        if (master->config.metrics != NULL) {
+            mb_metrics_record_response(master->config.metrics, plan->slave_id,
+                                       plan->function_code, result, false, 0, MB_METRICS_UNTIMED);
+        }
+    }
+}
+
+/**
+ * @brief Plan of the oldest outstanding request, the one a receive error hits
+ */
+static uint16_t oldest_in_flight(const inflight_slot_t *slots, uint8_t window, uint16_t none) {
+    uint16_t oldest = none;
+    for (uint8_t i = 0; i < window; i++) {
+        if (slots[i].in_flight && slots[i].plan_index < oldest) {
+            oldest = slots[i].plan_index;
+        }
+    }
+    return oldest;
+}
+
+static int plans_stopped(mb_plans_report_t *report,
+                         uint16_t failed_plan,
+                         uint16_t attempted,
+                         int result) {
+    report->failed_plan = failed_plan;
+    report->attempted   = attempted;
+    return result;
+}
+
+static void build_read_pdu(const mb_request_plan_t *plan, uint8_t *pdu_data) {
+    pdu_data[0] = (uint8_t)((plan->start_address >> 8) & 0xFF);
+    pdu_data[1] = (uint8_t)(plan->start_address & 0xFF);
+    pdu_data[2] = (uint8_t)((plan->quantity >> 8) & 0xFF);
+    pdu_data[3] = (uint8_t)(plan->quantity & 0xFF);
+}
+
+uint8_t *mb_transaction_begin(mb_master_t *master, mb_tx_frame_t *tx, uint16_t *pdu_capacity) {
+    tx->frame    = NULL;
+    tx->capacity = 0;
+
+    if (master->config.transport.tx_buffer != NULL) {
+        size_t size   = 0;
+        uint8_t *lent = master->config.transport.tx_buffer(master->config.transport.context, &size);
+        if (lent != NULL && size > mb_frame_pdu_offset(master_mode(master))) {
+            tx->frame    = lent;
+            tx->capacity = (uint16_t)(size < UINT16_MAX ? size : UINT16_MAX);
+        }
+    }
+
+    if (tx->frame == NULL) {
+        tx->frame    = tx->storage;
+        tx->capacity = sizeof(tx->storage);
+    }
+
+    uint16_t offset = mb_frame_pdu_offset(master_mode(master));
+    if (pdu_capacity != NULL) {
+        *pdu_capacity = (uint16_t)(tx->capacity - offset);
+    }
+    return &tx->frame[offset];
+}
+
+/**
+ * @brief Encode the frame around the PDU already in place and send it
+ */
+static int send_frame(mb_master_t *master,
+                      mb_tx_frame_t *tx,
+                      uint8_t slave_id,
+                      uint8_t fc,
+                      uint16_t pdu_length,
+                      uint16_t transaction_id) {
+    uint16_t frame_length = 0;
+
+    MB_TRACE(&master->config, MB_TRACE_BUILD_BEGIN, slave_id, fc, pdu_length, MB_SUCCESS);
+    int result = mb_encode_frame_inplace(slave_id, fc, pdu_length, master_mode(master),
+                                         transaction_id, tx->frame, tx->capacity, &frame_length);
+    MB_TRACE(&master->config, MB_TRACE_BUILD_END, slave_id, fc, frame_length, result);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    return transport_send(master, slave_id, fc, tx->frame, frame_length);
+}
+
+static int send_request(mb_master_t *master,
+                        uint8_t slave_id,
+                        uint8_t fc,
+                        const uint8_t *pdu_data,
+                        uint16_t pdu_length,
+                        uint16_t transaction_id) {
+    mb_tx_frame_t tx;
+    uint16_t capacity = 0;
+    uint8_t *pdu      = mb_transaction_begin(master, &tx, &capacity);
+
+    if (pdu_length > capacity) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+    if (pdu_data != NULL && pdu_length > 0) {
+        memcpy(pdu, pdu_data, pdu_length);
+    }
+
+    return send_frame(master, &tx, slave_id, fc, pdu_length, transaction_id);
+}
+
+/**
+ * @brief Send the request for a plan, using its prebuilt frame when present
+ */
+static int send_plan(mb_master_t *master, const mb_request_plan_t *plan, uint16_t transaction_id) {
+    if (plan->frame_data != NULL && plan->frame_length > 0) {
+        if (master_mode(master) == MB_MODE_TCP) {
+            // Only the MBAP transaction ID changes between executions
+            plan->frame_data[0] = (uint8_t)((transaction_id >> 8) & 0xFF);
+            plan->frame_data[1] = (uint8_t)(transaction_id & 0xFF);
+        }
+        return transport_send(master, plan->slave_id, plan->function_code, plan->frame_data,
+                              plan->frame_length);
+    }
+
+    // Read request PDU goes straight into the frame buffer
+    mb_tx_frame_t tx;
+    build_read_pdu(plan, mb_transaction_begin(master, &tx, NULL));
+    return send_frame(master, &tx, plan->slave_id, plan->function_code, 4, transaction_id);
+}
+
+/**
+ * @brief Stage a plan's TCP request for a vectored send
+ * @param storage Frame buffer of the plan's in-flight slot, used when the
+ *        plan has no prebuilt frame
+ */
+static int stage_plan(const mb_request_plan_t *plan,
+                      uint16_t transaction_id,
+                      uint8_t *storage,
+                      mb_frame_vec_t *frame) {
+    if (plan->frame_data != NULL && plan->frame_length > 0) {
+        plan->frame_data[0] = (uint8_t)((transaction_id >> 8) & 0xFF);
+        plan->frame_data[1] = (uint8_t)(transaction_id & 0xFF);
+        frame->data         = plan->frame_data;
+        frame->len          = plan->frame_length;
+        return MB_SUCCESS;
+    }
+
+    uint16_t frame_length = 0;
+    build_read_pdu(plan, &storage[mb_frame_pdu_offset(MB_MODE_TCP)]);
+    int result = mb_encode_frame_inplace(plan->slave_id, plan->function_code, 4, MB_MODE_TCP,
+                                         transaction_id, storage, MB_PLAN_FRAME_CHARS,
+                                         &frame_length);
+    frame->data = storage;
+    frame->len  = frame_length;
+    return result;
+}
+
+#ifdef MB_ENABLE_RTU
+/**
+ * @brief Read an RTU response into the stream until it is complete
+ *
+ * The frame is complete once the length given by its header has arrived.
+ * A read ending short of that (recv() timed out after data) or a frame
+ * whose length the header does not give ends at the silence, and is left
+ * to mb_rtu_stream_end() to validate.
+ */
+static int rtu_rx_fill(mb_master_t *master,
+                       uint8_t slave_id,
+                       uint8_t fc,
+                       mb_rtu_stream_t *stream) {
+    bool exact = master->config.transport.recv_exact;
+
+    for (;;) {
+        int expected = mb_rtu_stream_expected(stream);
+        if (expected > 0 && stream->length >= (uint16_t)expected) {
+            return MB_SUCCESS;
+        }
+        if (expected < 0 && stream->length > 0) {
+            return MB_SUCCESS;
+        }
+
+        size_t space  = 0;
+        uint8_t *tail = mb_rtu_stream_tail(stream, &space);
+        if (space == 0) {
+            return MB_SUCCESS;
+        }
+
+        // Header first, then exactly the rest: every byte count is known
+        if (exact && expected == 0) {
+            space = RTU_HEADER_CHARS - stream->length;
+        } else if (exact && expected > 0 && (size_t)expected - stream->length < space) {
+            space = (size_t)expected - stream->length;
+        }
+
+        size_t received = 0;
+        int result      = transport_recv(master, tail, space, &received);
+        if (result != MB_SUCCESS) {
+            return stream->length > 0 ? MB_SUCCESS : result;
+        }
+
+        if (stream->length == 0) {
+            MB_TRACE(&master->config, MB_TRACE_RECV_FIRST, slave_id, fc, received, MB_SUCCESS);
+        }
+
+        result = mb_rtu_stream_commit(stream, received);
+        if (result != MB_SUCCESS) {
+            return result;
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Receive and validate the response to an outstanding request
+ *
+ * On success resp_pdu points into rx (or into the transport's RX buffer)
+ * and stays valid until rx is reused.
+ */
+static int receive_response(mb_master_t *master,
+                            uint16_t transaction_id,
+                            uint8_t slave_id,
+                            uint8_t fc,
+                            mb_rx_frame_t *rx,
+                            uint8_t *resp_fc,
+                            const uint8_t **resp_pdu,
+                            uint16_t *resp_pdu_length) {
+    uint8_t resp_slave_id = 0;
+    int result;
+
+    if (master_mode(master) == MB_MODE_TCP) {
+        rx->tcp.length = 0;
+
+        // Keep reading until the response for this transaction shows up
+        for (;;) {
+            int frame_chars = tcp_rx_peek(&rx->tcp);
+            if (frame_chars < 0) {
+                return frame_chars;
+            }
+
+            if (frame_chars == 0) {
+                size_t before = rx->tcp.length;
+                result        = tcp_rx_fill(master, &rx->tcp);
+                if (result != MB_SUCCESS) {
+                    return result;
+                }
+                if (before == 0) {
+                    MB_TRACE(&master->config, MB_TRACE_RECV_FIRST, slave_id, fc, rx->tcp.length,
+                             MB_SUCCESS);
+                }
+                continue;
+            }
+
+            uint16_t resp_tid = 0;
+            MB_TRACE(&master->config, MB_TRACE_RECV_LAST, slave_id, fc, frame_chars, MB_SUCCESS);
+            MB_TRACE(&master->config, MB_TRACE_PARSE_BEGIN, slave_id, fc, frame_chars, MB_SUCCESS);
+            result = mb_parse_frame_view(rx->tcp.buffer, (uint16_t)frame_chars, MB_MODE_TCP,
+                                         &resp_tid, &resp_slave_id, resp_fc, resp_pdu,
+                                         resp_pdu_length);
+            MB_TRACE(&master->config, MB_TRACE_PARSE_END, slave_id, fc, frame_chars, result);
+            if (result != MB_SUCCESS) {
+                return result;
+            }
+
+            // Leave the matching frame at the head so the view stays valid
+            if (resp_tid == transaction_id) {
+                break;
+            }
+
+            // Stale response from an earlier transaction: discard it
+            tcp_rx_consume(&rx->tcp, (size_t)frame_chars);
+        }
+    } else if (master->config.transport.recv_view != NULL) {
+        // Serial frame lent by the transport: parse it where it lies
+        uint8_t *frame  = NULL;
+        size_t received = 0;
+
+        result = master->config.transport.recv_view(master->config.transport.context, &frame,
+                                                    &received);
+        if (result < 0 || frame == NULL || received == 0) {
+            return MB_ERROR_TIMEOUT;
+        }
+        master->stats.total_chars_recv += (uint32_t)received;
+
+        // The frame arrives whole: its first character is not seen separately
+        MB_TRACE(&master->config, MB_TRACE_RECV_FIRST, slave_id, fc, received, MB_SUCCESS);
+        MB_TRACE(&master->config, MB_TRACE_RECV_LAST, slave_id, fc, received, MB_SUCCESS);
+        MB_TRACE(&master->config, MB_TRACE_PARSE_BEGIN, slave_id, fc, received, MB_SUCCESS);
+        result = mb_parse_frame_view(frame, (uint16_t)received, master_mode(master), NULL,
+                                     &resp_slave_id, resp_fc, resp_pdu, resp_pdu_length);
+        MB_TRACE(&master->config, MB_TRACE_PARSE_END, slave_id, fc, received, result);
+        if (result != MB_SUCCESS) {
+            return result;
+        }
+#ifdef MB_ENABLE_RTU
+    } else if (master_mode(master) == MB_MODE_RTU) {
+        // Receive straight into the stream so the CRC is checked on arrival
+        mb_rtu_stream_t *stream = &rx->rtu;
+        mb_rtu_stream_reset(stream);
+
+        result = rtu_rx_fill(master, slave_id, fc, stream);
+        if (result != MB_SUCCESS) {
+            return result;
+        }
+
+        // The CRC ran as bytes arrived; only the frame end is left to check
+        MB_TRACE(&master->config, MB_TRACE_RECV_LAST, slave_id, fc, stream->length, MB_SUCCESS);
+        MB_TRACE(&master->config, MB_TRACE_PARSE_BEGIN, slave_id, fc, stream->length, MB_SUCCESS);
+        int frame_length = mb_rtu_stream_end(stream);
+        MB_TRACE(&master->config, MB_TRACE_PARSE_END, slave_id, fc, stream->length,
+                 frame_length < 0 ? frame_length : MB_SUCCESS);
+        if (frame_length < 0) {
+            return frame_length;
+        }
+
+        resp_slave_id    = stream->frame[0];
+        *resp_fc         = stream->frame[1];
+        *resp_pdu        = &stream->frame[MB_RTU_PDU_OFFSET];
+        *resp_pdu_length = (uint16_t)(frame_length - 4);
+#endif
+    } else {
+        size_t received = 0;
+
+        result = transport_recv(master, rx->serial, sizeof(rx->serial), &received);
+        if (result != MB_SUCCESS) {
+            return result;
+        }
+
+        MB_TRACE(&master->config, MB_TRACE_RECV_FIRST, slave_id, fc, received, MB_SUCCESS);
+        MB_TRACE(&master->config, MB_TRACE_RECV_LAST, slave_id, fc, received, MB_SUCCESS);
+        MB_TRACE(&master->config, MB_TRACE_PARSE_BEGIN, slave_id, fc, received, MB_SUCCESS);
+        result = mb_parse_frame_view(rx->serial, (uint16_t)received, master_mode(master), NULL,
+                                     &resp_slave_id, resp_fc, resp_pdu, resp_pdu_length);
+        MB_TRACE(&master->config, MB_TRACE_PARSE_END, slave_id, fc, received, result);
+        if (result != MB_SUCCESS) {
+            return result;
+        }
+    }
+
+    if (resp_slave_id != slave_id) {
+        return MB_ERROR_INVALID_FRAME;
+    }
+
+    return MB_SUCCESS;
+}
+
+int mb_transaction_execute(mb_master_t *master,
+                           uint8_t slave_id,
+                           uint8_t fc,
+                           const uint8_t *pdu_data,
+                           uint16_t pdu_length,
+                           uint8_t *resp_fc,
+                           uint8_t *resp_pdu,
+                           uint16_t *resp_pdu_length) {
+    if (master == NULL || resp_fc == NULL || resp_pdu == NULL || resp_pdu_length == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    int result = prepare_request(master, slave_id, fc, request_quantity(fc, pdu_data, pdu_length));
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    uint16_t transaction_id = next_transaction_id(master);
+
+    result = send_request(master, slave_id, fc, pdu_data, pdu_length, transaction_id);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    mb_rx_frame_t rx;
+    const uint8_t *view   = NULL;
+    uint32_t start_us     = round_trip_clock(master);
+    uint32_t chars_before = master->stats.total_chars_recv;
+
+    result = receive_response(master, transaction_id, slave_id, fc, &rx, resp_fc, &view,
+                              resp_pdu_length);
+    round_trip_done(master, slave_id, fc, result, result == MB_SUCCESS && (*resp_fc & 0x80) != 0,
+                    start_us, chars_before);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    if (*resp_pdu_length > 0) {
+        memcpy(resp_pdu, view, *resp_pdu_length);
+    }
+    return MB_SUCCESS;
+}
+
+int mb_transaction_execute_view(mb_master_t *master,
+                                mb_tx_frame_t *tx,
+                                uint8_t slave_id,
+                                uint8_t fc,
+                                uint16_t pdu_length,
+                                mb_rx_frame_t *rx,
+                                uint8_t *resp_fc,
+                                const uint8_t **resp_pdu,
+                                uint16_t *resp_pdu_length) {
+    if (master == NULL || tx == NULL || tx->frame == NULL || rx == NULL || resp_fc == NULL ||
+        resp_pdu == NULL || resp_pdu_length == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    const uint8_t *pdu = &tx->frame[mb_frame_pdu_offset(master_mode(master))];
+    int result = prepare_request(master, slave_id, fc, request_quantity(fc, pdu, pdu_length));
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    uint16_t transaction_id = next_transaction_id(master);
+
+    result = send_frame(master, tx, slave_id, fc, pdu_length, transaction_id);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    uint32_t start_us     = round_trip_clock(master);
+    uint32_t chars_before = master->stats.total_chars_recv;
+
+    result = receive_response(master, transaction_id, slave_id, fc, rx, resp_fc, resp_pdu,
+                              resp_pdu_length);
+    round_trip_done(master, slave_id, fc, result, result == MB_SUCCESS && (*resp_fc & 0x80) != 0,
+                    start_us, chars_before);
+    return result;
+}
+
+int mb_transaction_broadcast(mb_master_t *master,
+                             mb_tx_frame_t *tx,
+                             uint8_t fc,
+                             uint16_t pdu_length) {
+    if (master == NULL || tx == NULL || tx->frame == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+    if (!mb_transaction_is_broadcast(master, MB_BROADCAST_ID)) {
+        return MB_ERROR_NOT_SUPPORTED;
+    }
+    if (!mb_fc_is_write(fc)) {
+        return MB_ERROR_INVALID_FC;
+    }
+
+    int result = send_frame(master, tx, MB_BROADCAST_ID, fc, pdu_length, 0);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+    master->stats.broadcasts++;
+
+    // Every slave executes the write silently; keep the line idle meanwhile
+    if (master->config.turnaround_chars > 0 && master->config.transport.delay_chars != NULL) {
+        master->config.transport.delay_chars(master->config.transport.context,
+                                             master->config.turnaround_chars);
+    }
+    return MB_SUCCESS;
+}
+
+bool mb_transaction_urgent_pending(const mb_master_t *master) {
+    return master->config.urgent != NULL && !master->preempting &&
+           mb_ring_peek(master->config.urgent) != NULL;
+}
+
+void mb_transaction_run_urgent(mb_master_t *master) {
+    uint16_t serviced = 0;
+
+    master->preempting = true;
+    (void)mb_ring_service(master, master->config.urgent,
+                          (uint16_t)(master->config.urgent->mask + 1), &serviced);
+    master->preempting = false;
+    master->stats.preemptions += serviced;
+}
+
+/**
+ * @brief Execute plans one at a time in array order
+ */
+static int execute_plans_sequential(mb_master_t *master,
+                                    const mb_request_plan_t *plans,
+                                    uint16_t plan_count,
+                                    mb_plan_response_fn on_response,
+                                    void *ctx,
+                                    mb_plans_report_t *report) {
+    mb_rx_frame_t rx;
+
+    for (uint16_t i = 0; i < plan_count; i++) {
+        uint8_t resp_fc          = 0;
+        const uint8_t *resp_pdu  = NULL;
+        uint16_t resp_pdu_length = 0;
+
+        // The line is idle between two plans: urgent requests go first
+        if (mb_transaction_urgent_pending(master)) {
+            mb_transaction_run_urgent(master);
+        }
+
+        int result = prepare_request(master, plans[i].slave_id, plans[i].function_code,
+                                     plans[i].quantity);
+        if (result != MB_SUCCESS) {
+            return plans_stopped(report, i, (uint16_t)(i + 1), result);
+        }
+
+        uint16_t transaction_id = next_transaction_id(master);
+
+        result = send_plan(master, &plans[i], transaction_id);
+        if (result != MB_SUCCESS) {
+            return plans_stopped(report, i, (uint16_t)(i + 1), result);
+        }
+
+        uint32_t start_us     = round_trip_clock(master);
+        uint32_t chars_before = master->stats.total_chars_recv;
+
+        result = receive_response(master, transaction_id, plans[i].slave_id,
+                                  plans[i].function_code, &rx, &resp_fc, &resp_pdu,
+                                  &resp_pdu_length);
+        round_trip_done(master, plans[i].slave_id, plans[i].function_code, result,
+                        result == MB_SUCCESS && (resp_fc & 0x80) != 0, start_us, chars_before);
+        if (result != MB_SUCCESS) {
+            return plans_stopped(report, i, (uint16_t)(i + 1), result);
+        }
+
+        MB_TRACE(&master->config, MB_TRACE_SCATTER_BEGIN, plans[i].slave_id,
+                 plans[i].function_code, resp_pdu_length, MB_SUCCESS);
+        result = on_response(ctx, i, resp_fc, resp_pdu, resp_pdu_length);
+        MB_TRACE(&master->config, MB_TRACE_SCATTER_END, plans[i].slave_id,
+                 plans[i].function_code, resp_pdu_length, result);
+        if (result != MB_SUCCESS) {
+            return plans_stopped(report, i, (uint16_t)(i + 1), result);
+        }
+    }
+
+    return MB_SUCCESS;
+}
+
+/**
+ * @brief Execute TCP plans with up to `window` requests outstanding
+ */
+static int execute_plans_pipelined(mb_master_t *master,
+                                   const mb_request_plan_t *plans,
+                                   uint16_t plan_count,
+                                   uint8_t window,
+                                   mb_plan_response_fn on_response,
+                                   void *ctx,
+                                   mb_plans_report_t *report) {
+    inflight_slot_t slots[MB_MAX_IN_FLIGHT];
+    memset(slots, 0, sizeof(slots));
+
+    mb_tcp_rx_t rx;
+    rx.length = 0;
+
+    uint16_t next_plan = 0;
+    uint16_t completed = 0;
+    uint8_t in_flight  = 0;
+
+    // With send_frames() every window fill leaves in one call
+    send_batch_t batch;
+    batch.count   = 0;
+    bool vectored = master->config.transport.send_frames != NULL;
+
+    while (completed < plan_count) {
+        // Urgent requests stop the window from refilling and go out once it is empty
+        bool urgent = mb_transaction_urgent_pending(master);
+        if (urgent && in_flight == 0) {
+            mb_transaction_run_urgent(master);
+            urgent = false;
+        }
+
+        // Fill the window with back-to-back requests
+        while (!urgent && in_flight < window && next_plan < plan_count) {
+            uint8_t slot = 0;
+            while (slots[slot].in_flight) {
+                slot++;
+            }
+
+            // An offline slave's probe goes out alone: its answer decides the rest
+            const mb_request_plan_t *plan = &plans[next_plan];
+            if (in_flight > 0 && slave_offline(master, plan->slave_id)) {
+                break;
+            }
+
+            int result = prepare_request(master, plan->slave_id, plan->function_code,
+                                         plan->quantity);
+            if (result != MB_SUCCESS) {
+                // Requests already staged go out as they would have one by one
+                (void)transport_send_batch(master, plans, &batch);
+                abandon_in_flight(master, plans, slots, window, result);
+                return plans_stopped(report, next_plan, (uint16_t)(next_plan + 1), result);
+            }
+
+            uint16_t transaction_id = next_transaction_id(master);
+
+            if (vectored) {
+                result = stage_plan(plan, transaction_id, slots[slot].frame,
+                                    &batch.frames[batch.count]);
+                if (result == MB_SUCCESS) {
+                    batch.plan_index[batch.count++] = next_plan;
+                } else {
+                    // Requests already staged go out as they would have one by one
+                    (void)transport_send_batch(master, plans, &batch);
+                }
+            } else {
+                result = send_plan(master, plan, transaction_id);
+            }
+            if (result != MB_SUCCESS) {
+                abandon_in_flight(master, plans, slots, window, result);
+                return plans_stopped(report, next_plan, (uint16_t)(next_plan + 1), result);
+            }
+
+            slots[slot].transaction_id = transaction_id;
+            slots[slot].plan_index     = next_plan;
+            slots[slot].sent_us        = round_trip_clock(master);
+            slots[slot].in_flight      = true;
+            in_flight++;
+            next_plan++;
+        }
+
+        // A failed batch is charged to its first request, the one that did not leave
+        uint16_t first_staged = batch.count > 0 ? batch.plan_index[0] : next_plan;
+        int flushed           = transport_send_batch(master, plans, &batch);
+        if (flushed != MB_SUCCESS) {
+            abandon_in_flight(master, plans, slots, window, flushed);
+            return plans_stopped(report, first_staged, next_plan, flushed);
+        }
+
+        int frame_chars = tcp_rx_peek(&rx);
+        if (frame_chars < 0) {
+            uint16_t oldest = oldest_in_flight(slots, window, next_plan);
+            abandon_in_flight(master, plans, slots, window, frame_chars);
+            return plans_stopped(report, oldest, next_plan, frame_chars);
+        }
+
+        if (frame_chars == 0) {
+            size_t before = rx.length;
+            int result    = tcp_rx_fill(master, &rx);
+            if (result != MB_SUCCESS) {
+                uint16_t oldest = oldest_in_flight(slots, window, next_plan);
+                abandon_in_flight(master, plans, slots, window, result);
+                return plans_stopped(report, oldest, next_plan, result);
+            }
+            // Not yet known which transaction the bytes belong to
+            if (before == 0) {
+                MB_TRACE(&master->config, MB_TRACE_RECV_FIRST, 0, 0, rx.length, MB_SUCCESS);
+            }
+            continue;
+        }
+
+        uint16_t resp_tid        = 0;
+        uint8_t resp_slave_id    = 0;
+        uint8_t resp_fc          = 0;
+        const uint8_t *resp_pdu  = NULL;
+        uint16_t resp_pdu_length = 0;
+
+        // The PDU view points into the accumulator: consume only after the handler ran
+        MB_TRACE(&master->config, MB_TRACE_RECV_LAST, 0, 0, frame_chars, MB_SUCCESS);
+        MB_TRACE(&master->config, MB_TRACE_PARSE_BEGIN, 0, 0, frame_chars, MB_SUCCESS);
+        int result = mb_parse_frame_view(rx.buffer, (uint16_t)frame_chars, MB_MODE_TCP, &resp_tid,
+                                         &resp_slave_id, &resp_fc, &resp_pdu, &resp_pdu_length);
+        MB_TRACE(&master->config, MB_TRACE_PARSE_END, resp_slave_id, resp_fc & 0x7F, frame_chars,
+                 result);
+        if (result != MB_SUCCESS) {
+            uint16_t oldest = oldest_in_flight(slots, window, next_plan);
+            abandon_in_flight(master, plans, slots, window, result);
+            return plans_stopped(report, oldest, next_plan, result);
+        }
+
+        // Match the response to its outstanding request
+        uint8_t slot = 0;
+        while (slot < window && !(slots[slot].in_flight && slots[slot].transaction_id == resp_tid)) {
+            slot++;
+        }
+
+        if (slot == window) {
+            tcp_rx_consume(&rx, (size_t)frame_chars);
+            continue; // Stale or unknown transaction: discard
+        }
+
+        uint16_t plan_index = slots[slot].plan_index;
+        slots[slot].in_flight = false;
+        in_flight--;
+        completed++;
+
+        const mb_request_plan_t *plan = &plans[plan_index];
+        result = resp_slave_id == plan->slave_id ? MB_SUCCESS : MB_ERROR_INVALID_FRAME;
+        if (result == MB_SUCCESS) {
+            record_alive(master, plan->slave_id);
+        }
+        if (master->config.metrics != NULL) {
+            uint32_t rtt = master->config.transport.clock_us != NULL
+                               ? round_trip_clock(master) - slots[slot].sent_us
+                               : MB_METRICS_UNTIMED;
+            mb_metrics_record_response(master->config.metrics, plan->slave_id,
+                                       plan->function_code, result,
+                                       result == MB_SUCCESS && (resp_fc & 0x80) != 0,
+                                       (uint32_t)frame_chars, rtt);
+        }
+        if (result != MB_SUCCESS) {
+            abandon_in_flight(master, plans, slots, window, result);
+            return plans_stopped(report, plan_index, next_plan, result);
+        }
+
+        MB_TRACE(&master->config, MB_TRACE_SCATTER_BEGIN, plan->slave_id, plan->function_code,
+                 resp_pdu_length, MB_SUCCESS);
+        result = on_response(ctx, plan_index, resp_fc, resp_pdu, resp_pdu_length);
+        MB_TRACE(&master->config, MB_TRACE_SCATTER_END, plan->slave_id, plan->function_code,
+                 resp_pdu_length, result);
+        tcp_rx_consume(&rx, (size_t)frame_chars);
+        if (result != MB_SUCCESS) {
+            abandon_in_flight(master, plans, slots, window, result);
+            return plans_stopped(report, plan_index, next_plan, result);
+        }
+    }
+
+    return MB_SUCCESS;
+}
+
+int mb_transaction_execute_plans(mb_master_t *master,
+                                 const mb_request_plan_t *plans,
+                                 uint16_t plan_count,
+                                 mb_plan_response_fn on_response,
+                                 void *ctx) {
+    mb_plans_report_t report;
+    return mb_transaction_execute_plans_report(master, plans, plan_count, on_response, ctx,
+                                               &report);
+}
+
+int mb_transaction_execute_plans_report(mb_master_t *master,
+                                        const mb_request_plan_t *plans,
+                                        uint16_t plan_count,
+                                        mb_plan_response_fn on_response,
+                                        void *ctx,
+                                        mb_plans_report_t *report) {
+    if (master == NULL || (plans == NULL && plan_count > 0) || on_response == NULL ||
+        report == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+    report->failed_plan = plan_count;
+    report->attempted   = plan_count;
+
+    uint8_t window = master->config.max_in_flight;
+    if (window > MB_MAX_IN_FLIGHT) {
+        window = MB_MAX_IN_FLIGHT;
+    }
+
+    if (master_mode(master) == MB_MODE_TCP && window > 1) {
+        return execute_plans_pipelined(master, plans, plan_count, window, on_response, ctx,
+                                       report);
+    }
+
+    return execute_plans_sequential(master, plans, plan_count, on_response, ctx, report);
+}
@@ -0,0 +1,273 @@
+/**
+ * @file transaction.h
+ * @brief Request/response transaction engine
+ *
+ * Sends request frames through the configured transport and matches the
+ * responses back to their requests. In TCP mode, up to
+ * `config.max_in_flight` requests are pipelined and matched by MBAP
+ * transaction ID, so responses may arrive in any order.
+ */
+
+#ifndef SMARTMODBUS_TRANSACTION_H
+#define SMARTMODBUS_TRANSACTION_H
+
+#include "smartmodbus/mb_config.h"
+#include "smartmodbus/mb_types.h"
+#ifdef MB_ENABLE_RTU
+#include "../protocol/rtu_stream.h"
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Largest application data unit for the enabled protocols
+ *
+ * ASCII doubles the PDU in hex plus ':' and CRLF, so it dominates when enabled.
+ */
+#ifdef MB_ENABLE_ASCII
+#define MB_MAX_ADU_CHARS 513
+#else
+#define MB_MAX_ADU_CHARS 260
+#endif
+
+/**
+ * @brief Largest PDU payload (excluding function code)
+ */
+#define MB_MAX_PDU_DATA 252
+
+/**
+ * @brief Largest Modbus TCP ADU
+ */
+#define MB_TCP_MAX_ADU_CHARS 260
+
+/**
+ * @brief Request frame under construction
+ *
+ * Points at the transport's lent TX buffer when it offers one, otherwise at
+ * the local storage. The PDU is written at its final position in the frame.
+ */
+typedef struct {
+    uint8_t *frame;                    /**< Frame buffer in use */
+    uint16_t capacity;                 /**< Size of frame */
+    uint8_t storage[MB_MAX_ADU_CHARS]; /**< Fallback buffer */
+} mb_tx_frame_t;
+
+/**
+ * @brief TCP receive accumulator
+ *
+ * Holds bytes received from the stream until one or more complete
+ * MBAP frames are available.
+ */
+typedef struct {
+    uint8_t buffer[2 * MB_TCP_MAX_ADU_CHARS];
+    size_t length;
+} mb_tcp_rx_t;
+
+/**
+ * @brief Receive storage a response view points into
+ */
+typedef union {
+    mb_tcp_rx_t tcp; /**< TCP stream accumulator */
+#ifdef MB_ENABLE_RTU
+    mb_rtu_stream_t rtu; /**< RTU frame with running CRC */
+#endif
+    uint8_t serial[MB_MAX_ADU_CHARS]; /**< ASCII frame, decoded in place */
+} mb_rx_frame_t;
+
+/**
+ * @brief Storage of one stop-and-wait transaction
+ *
+ * The request frame is dead once send() returns, so the response is
+ * received over it: pass &io.tx and &io.rx to mb_transaction_execute_view().
+ */
+typedef union {
+    mb_tx_frame_t tx; /**< Request under construction */
+    mb_rx_frame_t rx; /**< Response, after the request was sent */
+} mb_io_frame_t;
+
+/**
+ * @brief Response handler invoked once per completed plan
+ * @param ctx User context
+ * @param plan_index Index of the plan in the executed array
+ * @param fc Response function code (bit 7 set for exceptions)
+ * @param pdu_data Response PDU data (without function code)
+ * @param pdu_length Response PDU length
+ * @return 0 to continue, negative error code to abort execution
+ */
+typedef int (*mb_plan_response_fn)(void *ctx,
+                                   uint16_t plan_index,
+                                   uint8_t fc,
+                                   const uint8_t *pdu_data,
+                                   uint16_t pdu_length);
+
+/**
+ * @brief Execute a single request/response transaction
+ * @param master Master context
+ * @param slave_id Slave device ID
+ * @param fc Function code
+ * @param pdu_data Request PDU data (without function code)
+ * @param pdu_length Request PDU length
+ * @param resp_fc Output: response function code
+ * @param resp_pdu Output: response PDU data (at least MB_MAX_PDU_DATA bytes)
+ * @param resp_pdu_length Output: response PDU length
+ * @return 0 on success, negative error code on failure
+ *
+ * The response slave ID (and transaction ID in TCP mode) is validated
+ * against the request. Stale TCP responses from earlier timed-out
+ * transactions are discarded.
+ */
+int mb_transaction_execute(mb_master_t *master,
+                           uint8_t slave_id,
+                           uint8_t fc,
+                           const uint8_t *pdu_data,
+                           uint16_t pdu_length,
+                           uint8_t *resp_fc,
+                           uint8_t *resp_pdu,
+                           uint16_t *resp_pdu_length);
+
+/**
+ * @brief Start a zero-copy request
+ * @param master Master context
+ * @param tx Frame state (caller-owned, typically on the stack)
+ * @param pdu_capacity Output: bytes available for the PDU data
+ * @return Where to write the request PDU data (without function code)
+ */
+uint8_t *mb_transaction_begin(mb_master_t *master, mb_tx_frame_t *tx, uint16_t *pdu_capacity);
+
+/**
+ * @brief Encode the request in place, send it and receive a response view
+ * @param master Master context
+ * @param tx Frame state from mb_transaction_begin()
+ * @param slave_id Slave device ID
+ * @param fc Function code
+ * @param pdu_length Request PDU length written at the begin pointer
+ * @param rx Receive storage; the response view points into it (or into the
+ *        transport's RX buffer when it provides recv_view). May overlay tx
+ *        (see mb_io_frame_t).
+ * @param resp_fc Output: response function code
+ * @param resp_pdu Output: response PDU data (without function code)
+ * @param resp_pdu_length Output: response PDU length
+ * @return 0 on success, negative error code on failure
+ */
+int mb_transaction_execute_view(mb_master_t *master,
+                                mb_tx_frame_t *tx,
+                                uint8_t slave_id,
+                                uint8_t fc,
+                                uint16_t pdu_length,
+                                mb_rx_frame_t *rx,
+                                uint8_t *resp_fc,
+                                const uint8_t **resp_pdu,
+                                uint16_t *resp_pdu_length);
+
+/**
+ * @brief Whether a request to a slave ID is a serial broadcast
+ */
+static inline bool mb_transaction_is_broadcast(const mb_master_t *master, uint8_t slave_id) {
+    return slave_id == MB_BROADCAST_ID && MB_ACTIVE_MODE(master->config.mode) != MB_MODE_TCP;
+}
+
+/**
+ * @brief Encode a write in place and broadcast it
+ * @param master Master context (RTU, ASCII or RTU-over-TCP)
+ * @param tx Frame state from mb_transaction_begin()
+ * @param fc Write function code
+ * @param pdu_length Request PDU length written at the begin pointer
+ * @return 0 on success, negative error code on failure
+ *
+ * Nobody answers a broadcast, so no response is awaited. Instead the line
+ * is held idle for `config.turnaround_chars` through transport.delay_chars
+ * so every slave has executed the write before the next frame goes out.
+ * The execute functions reject MB_BROADCAST_ID on serial masters.
+ */
+int mb_transaction_broadcast(mb_master_t *master,
+                             mb_tx_frame_t *tx,
+                             uint8_t fc,
+                             uint16_t pdu_length);
+
+/**
+ * @brief Execute an array of read plans
+ * @param master Master context
+ * @param plans Plans to execute
+ * @param plan_count Number of plans
+ * @param on_response Handler called for each response
+ * @param ctx User context passed to the handler
+ * @return 0 on success, negative error code on failure
+ *
+ * RTU/ASCII plans run stop-and-wait in array order. TCP plans are sent
+ * back-to-back up to `config.max_in_flight` at a time and the handler is
+ * called in arrival order. Requests waiting on config.urgent run before
+ * each plan; a TCP window first drains, so they go out alone.
+ */
+int mb_transaction_execute_plans(mb_master_t *master,
+                                 const mb_request_plan_t *plans,
+                                 uint16_t plan_count,
+                                 mb_plan_response_fn on_response,
+                                 void *ctx);
+
+/**
+ * @brief Where mb_transaction_execute_plans_report() stopped
+ */
+typedef struct {
+    uint16_t failed_plan; /**< Plan the returned error belongs to (plan_count on success) */
+    uint16_t attempted;   /**< Plans [0, attempted) were sent or failed; the rest never left */
+} mb_plans_report_t;
+
+/**
+ * @brief Execute an array of read plans and report which plan failed
+ * @param report Output: the failing plan and how far execution got
+ * @return As mb_transaction_execute_plans()
+ *
+ * A pipelined error is charged to the plan it belongs to: a send error to
+ * the request being sent, a receive error to the oldest outstanding
+ * request, a wrong slave ID or handler error to the matched response.
+ * Outstanding requests below `attempted` that were not answered were
+ * abandoned with the same error; none of them is re-sent.
+ */
+int mb_transaction_execute_plans_report(mb_master_t *master,
+                                        const mb_request_plan_t *plans,
+                                        uint16_t plan_count,
+                                        mb_plan_response_fn on_response,
+                                        void *ctx,
+                                        mb_plans_report_t *report);
+
+/**
+ * @brief Response timeout for a request
+ * @param master Master context
+ * @param slave_id Slave device ID
+ * @param fc Request function code
+ * @param quantity Units read (reads and FC23), sizes the expected response
+ * @return The slave's learned timeout when config.timeouts is active,
+ *         config.timeout_ms otherwise
+ */
+uint32_t mb_transaction_timeout_ms(const mb_master_t *master,
+                                   uint8_t slave_id,
+                                   uint8_t fc,
+                                   uint16_t quantity);
+
+/**
+ * @brief Whether config.urgent has requests waiting for a plan boundary
+ * @param master Master context
+ * @return false while they are being run (no nested preemption)
+ */
+bool mb_transaction_urgent_pending(const mb_master_t *master);
+
+/**
+ * @brief Run the requests waiting on config.urgent
+ * @param master Master context (must be the urgent ring's consumer thread)
+ *
+ * Runs at most one ring's worth, so producers that keep pushing cannot
+ * stall the preempted read. Results go to each request's reply ring.
+ */
+void mb_transaction_run_urgent(mb_master_t *master);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_TRANSACTION_H
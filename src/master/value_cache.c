@@ -0,0 +1,262 @@
+/**
+ * @file value_cache.c
+ * @brief Shared read-through value cache implementation
+ *
+ * mb_cache_read_many() walks the tags of all reads in rounds. The first
+ * walk of a round answers fresh tags and queues each distinct stale tag,
+ * pinning its entry (pending) so eviction cannot take it, until the batch
+ * or the table is full. After the batch read, a second walk over the same
+ * tags copies the refreshed values out.
+ */
+
+#include "smartmodbus/mb_cache.h"
+#include "smartmodbus/mb_error.h"
+#include "smartmodbus/smartmodbus.h"
+
+#include <string.h>
+
+static inline uint32_t cache_key(uint8_t slave_id, uint8_t fc, uint16_t address) {
+    return ((uint32_t)slave_id << 24) | ((uint32_t)fc << 16) | address;
+}
+
+static inline uint32_t entry_key(const mb_cache_entry_t *entry) {
+    return cache_key(entry->slave_id, entry->function_code, entry->address);
+}
+
+static inline bool is_fresh(const mb_cache_entry_t *entry, uint32_t max_age_ms, uint32_t now_ms) {
+    return entry->valid && (uint32_t)(now_ms - entry->read_ms) <= max_age_ms;
+}
+
+/**
+ * @brief Index of the first entry not ordered before key
+ */
+static uint16_t cache_search(const mb_cache_t *cache, uint32_t key) {
+    uint16_t lo = 0;
+    uint16_t hi = cache->count;
+
+    while (lo < hi) {
+        uint16_t mid = (uint16_t)(lo + (hi - lo) / 2);
+        if (entry_key(&cache->entries[mid]) < key) {
+            lo = (uint16_t)(mid + 1);
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static mb_cache_entry_t *cache_find(const mb_cache_t *cache, const mb_tag_t *tag) {
+    uint32_t key   = cache_key(tag->slave_id, tag->function_code, tag->address);
+    uint16_t index = cache_search(cache, key);
+    if (index < cache->count && entry_key(&cache->entries[index]) == key) {
+        return &cache->entries[index];
+    }
+    return NULL;
+}
+
+static void cache_remove(mb_cache_t *cache, uint16_t index) {
+    memmove(&cache->entries[index], &cache->entries[index + 1],
+            (size_t)(cache->count - index - 1) * sizeof(mb_cache_entry_t));
+    cache->count--;
+}
+
+/**
+ * @brief Make room by dropping the entry read longest ago
+ * @return false if every entry is pinned by the batch in progress
+ */
+static bool cache_evict(mb_cache_t *cache, uint32_t now_ms) {
+    uint16_t victim = cache->count;
+    uint32_t oldest = 0;
+
+    for (uint16_t i = 0; i < cache->count; i++) {
+        const mb_cache_entry_t *entry = &cache->entries[i];
+        if (entry->pending) {
+            continue;
+        }
+        // Never-read entries are the oldest of all
+        uint32_t age = entry->valid ? (uint32_t)(now_ms - entry->read_ms) : UINT32_MAX;
+        if (victim == cache->count || age > oldest) {
+            victim = i;
+            oldest = age;
+        }
+    }
+
+    if (victim == cache->count) {
+        return false;
+    }
+    cache_remove(cache, victim);
+    return true;
+}
+
+static mb_cache_entry_t *cache_insert(mb_cache_t *cache, const mb_tag_t *tag, uint32_t now_ms) {
+    if (cache->count == cache->capacity && !cache_evict(cache, now_ms)) {
+        return NULL;
+    }
+
+    uint32_t key   = cache_key(tag->slave_id, tag->function_code, tag->address);
+    uint16_t index = cache_search(cache, key);
+    memmove(&cache->entries[index + 1], &cache->entries[index],
+            (size_t)(cache->count - index) * sizeof(mb_cache_entry_t));
+    cache->count++;
+
+    mb_cache_entry_t *entry = &cache->entries[index];
+    memset(entry, 0, sizeof(*entry));
+    entry->slave_id      = tag->slave_id;
+    entry->function_code = tag->function_code;
+    entry->address       = tag->address;
+    return entry;
+}
+
+int mb_cache_init(mb_cache_t *cache, mb_cache_entry_t *entries, uint16_t capacity) {
+    if (cache == NULL || entries == NULL || capacity == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    memset(cache, 0, sizeof(*cache));
+    cache->entries  = entries;
+    cache->capacity = capacity;
+    return MB_SUCCESS;
+}
+
+void mb_cache_clear(mb_cache_t *cache) {
+    if (cache != NULL) {
+        cache->count = 0;
+    }
+}
+
+void mb_cache_invalidate(mb_cache_t *cache,
+                         uint8_t slave_id,
+                         uint8_t fc,
+                         uint16_t first,
+                         uint16_t last) {
+    if (cache == NULL || first > last) {
+        return;
+    }
+
+    uint16_t begin = cache_search(cache, cache_key(slave_id, fc, first));
+    uint16_t end   = begin;
+    while (end < cache->count && entry_key(&cache->entries[end]) <= cache_key(slave_id, fc, last)) {
+        end++;
+    }
+
+    memmove(&cache->entries[begin], &cache->entries[end],
+            (size_t)(cache->count - end) * sizeof(mb_cache_entry_t));
+    cache->count = (uint16_t)(cache->count - (end - begin));
+}
+
+int mb_cache_read_many(mb_master_t *master,
+                       mb_cache_t *cache,
+                       const mb_cache_read_t *reads,
+                       uint16_t read_count,
+                       uint32_t now_ms) {
+    if (master == NULL || cache == NULL || (reads == NULL && read_count > 0)) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+    for (uint16_t r = 0; r < read_count; r++) {
+        if (reads[r].tag_count > 0 && (reads[r].tags == NULL || reads[r].data == NULL)) {
+            return MB_ERROR_INVALID_PARAM;
+        }
+    }
+
+    mb_tag_t batch[MB_CACHE_BATCH_TAGS];
+    uint16_t values[MB_CACHE_BATCH_TAGS];
+    uint16_t limit = MB_CACHE_BATCH_TAGS;
+#ifdef MB_USE_STATIC_MEMORY
+    if (limit > MB_MAX_SCATTER) {
+        limit = MB_MAX_SCATTER;
+    }
+#endif
+
+    // Round start and end, as (read, tag) cursors
+    uint16_t first_read = 0;
+    uint16_t first_tag  = 0;
+
+    while (first_read < read_count) {
+        uint16_t r     = first_read;
+        uint16_t t     = first_tag;
+        uint16_t count = 0;
+        bool full      = false;
+
+        for (; r < read_count && !full; r++, t = 0) {
+            const mb_cache_read_t *read = &reads[r];
+            for (; t < read->tag_count; t++) {
+                const mb_tag_t *tag     = &read->tags[t];
+                mb_cache_entry_t *entry = cache_find(cache, tag);
+
+                if (entry != NULL && is_fresh(entry, read->max_age_ms, now_ms)) {
+                    read->data[t] = entry->value;
+                    cache->hits++;
+                    continue;
+                }
+                if (entry != NULL && entry->pending) {
+                    continue;
+                }
+                if (count == limit ||
+                    (entry == NULL && (entry = cache_insert(cache, tag, now_ms)) == NULL)) {
+                    full = true;
+                    break;
+                }
+
+                entry->pending = true;
+                batch[count++] = *tag;
+            }
+            if (full) {
+                break;
+            }
+        }
+
+        if (count > 0) {
+            int result = mb_master_read_batch(master, batch, count, values, count);
+            cache->batches++;
+
+            for (uint16_t i = 0; i < count; i++) {
+                mb_cache_entry_t *entry = cache_find(cache, &batch[i]);
+                entry->pending          = false;
+                if (result == MB_SUCCESS) {
+                    entry->value   = values[i];
+                    entry->valid   = true;
+                    entry->read_ms = now_ms;
+                }
+            }
+            if (result != MB_SUCCESS) {
+                return result;
+            }
+            cache->misses += count;
+        }
+
+        // Copy the refreshed values to every tag of the round that wanted them
+        for (uint16_t cr = first_read, ct = first_tag; cr < read_count; cr++, ct = 0) {
+            const mb_cache_read_t *read = &reads[cr];
+            uint16_t end                = cr == r ? t : read->tag_count;
+            for (; ct < end; ct++) {
+                const mb_cache_entry_t *entry = cache_find(cache, &read->tags[ct]);
+                if (entry != NULL && is_fresh(entry, read->max_age_ms, now_ms)) {
+                    read->data[ct] = entry->value;
+                }
+            }
+            if (cr == r) {
+                break;
+            }
+        }
+
+        first_read = r;
+        first_tag  = t;
+    }
+
+    return MB_SUCCESS;
+}
+
+int mb_cache_read(mb_master_t *master,
+                  mb_cache_t *cache,
+                  const mb_tag_t *tags,
+                  uint16_t tag_count,
+                  uint32_t max_age_ms,
+                  uint32_t now_ms,
+                  uint16_t *data) {
+    mb_cache_read_t read;
+    read.tags       = tags;
+    read.tag_count  = tag_count;
+    read.max_age_ms = max_age_ms;
+    read.data       = data;
+    return mb_cache_read_many(master, cache, &read, 1, now_ms);
+}
@@ -0,0 +1,430 @@
+/**
+ * @file write_queue.c
+ * @brief Coalescing write queue implementation
+ *
+ * Writes are appended in O(1). A flush sorts them by (slave, address space,
+ * address, order), keeps the last write per address and cuts the result
+ * into runs of consecutive addresses no longer than the function code
+ * allows; each run is one frame built straight into the request buffer.
+ *
+ * mb_master_write_read() sends the same runs, but a register run of the
+ * slave being read travels in an FC23 frame together with one of the
+ * read's plans when the slave's profile permits it.
+ */
+
+#include "smartmodbus/mb_write.h"
+#include "smartmodbus/mb_error.h"
+#include "request_optimizer.h"
+#include "response_parser.h"
+#include "transaction.h"
+#include "../core/fc_policy.h"
+#include "../utils/scratch.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+int mb_write_queue_init(mb_write_queue_t *queue, mb_write_entry_t *entries, uint16_t capacity) {
+    if (queue == NULL || (entries == NULL && capacity > 0)) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    queue->entries  = entries;
+    queue->capacity = capacity;
+    queue->count    = 0;
+    return MB_SUCCESS;
+}
+
+static int queue_append(mb_write_queue_t *queue,
+                        uint8_t slave_id,
+                        uint8_t fc,
+                        uint16_t address,
+                        uint16_t value) {
+    if (queue == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (queue->count >= queue->capacity) {
+        return MB_ERROR_TOO_MANY_BLOCKS;
+    }
+
+    mb_write_entry_t *entry = &queue->entries[queue->count];
+    entry->slave_id         = slave_id;
+    entry->function_code    = fc;
+    entry->address          = address;
+    entry->value            = value;
+    entry->order            = queue->count;
+    queue->count++;
+    return MB_SUCCESS;
+}
+
+int mb_write_queue_register(mb_write_queue_t *queue,
+                            uint8_t slave_id,
+                            uint16_t address,
+                            uint16_t value) {
+    return queue_append(queue, slave_id, MB_FC_WRITE_MULTIPLE_REGISTERS, address, value);
+}
+
+int mb_write_queue_coil(mb_write_queue_t *queue, uint8_t slave_id, uint16_t address, bool value) {
+    return queue_append(queue, slave_id, MB_FC_WRITE_MULTIPLE_COILS, address, value ? 1 : 0);
+}
+
+void mb_write_queue_clear(mb_write_queue_t *queue) {
+    if (queue != NULL) {
+        queue->count = 0;
+    }
+}
+
+/**
+ * @brief Comparison function ordering writes by slave, space, address, order
+ */
+static int compare_writes(const void *a, const void *b) {
+    const mb_write_entry_t *write_a = (const mb_write_entry_t *)a;
+    const mb_write_entry_t *write_b = (const mb_write_entry_t *)b;
+
+    if (write_a->slave_id != write_b->slave_id) {
+        return write_a->slave_id < write_b->slave_id ? -1 : 1;
+    }
+    if (write_a->function_code != write_b->function_code) {
+        return write_a->function_code < write_b->function_code ? -1 : 1;
+    }
+    if (write_a->address != write_b->address) {
+        return write_a->address < write_b->address ? -1 : 1;
+    }
+    if (write_a->order != write_b->order) {
+        return write_a->order < write_b->order ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Sort the queue and keep the last write per address
+ */
+static void queue_coalesce(mb_write_queue_t *queue) {
+    qsort(queue->entries, queue->count, sizeof(mb_write_entry_t), compare_writes);
+
+    uint16_t kept = 0;
+    for (uint16_t i = 0; i < queue->count; i++) {
+        const mb_write_entry_t *entry = &queue->entries[i];
+        const mb_write_entry_t *next  = i + 1u < queue->count ? entry + 1 : NULL;
+
+        // Equal addresses are adjacent, the latest last
+        if (next == NULL || next->slave_id != entry->slave_id ||
+            next->function_code != entry->function_code || next->address != entry->address) {
+            queue->entries[kept]       = *entry;
+            queue->entries[kept].order = kept;
+            kept++;
+        }
+    }
+    queue->count = kept;
+}
+
+/**
+ * @brief Send one run of consecutive writes as a single frame
+ */
+static int send_run(mb_master_t *master, const mb_write_entry_t *run, uint16_t quantity) {
+    bool coils         = run[0].function_code == MB_FC_WRITE_MULTIPLE_COILS;
+    uint16_t address   = run[0].address;
+    uint16_t data_size = coils ? (uint16_t)((quantity + 7) / 8) : (uint16_t)(quantity * 2);
+    uint8_t fc         = run[0].function_code;
+
+    mb_io_frame_t io;
+    uint16_t capacity   = 0;
+    uint8_t *pdu_data   = mb_transaction_begin(master, &io.tx, &capacity);
+    uint16_t pdu_length = 0;
+
+    pdu_data[pdu_length++] = (uint8_t)((address >> 8) & 0xFF);
+    pdu_data[pdu_length++] = (uint8_t)(address & 0xFF);
+
+    // A lone write: FC05/FC06 carry the value in place of the quantity
+    uint16_t single_value = coils ? (run[0].value ? 0xFF00 : 0x0000) : run[0].value;
+    if (quantity == 1) {
+        if (capacity < 4) {
+            return MB_ERROR_BUFFER_TOO_SMALL;
+        }
+        fc                     = coils ? MB_FC_WRITE_SINGLE_COIL : MB_FC_WRITE_SINGLE_REGISTER;
+        pdu_data[pdu_length++] = (uint8_t)((single_value >> 8) & 0xFF);
+        pdu_data[pdu_length++] = (uint8_t)(single_value & 0xFF);
+    } else {
+        if (capacity < 5 + data_size) {
+            return MB_ERROR_BUFFER_TOO_SMALL;
+        }
+        pdu_data[pdu_length++] = (uint8_t)((quantity >> 8) & 0xFF);
+        pdu_data[pdu_length++] = (uint8_t)(quantity & 0xFF);
+        pdu_data[pdu_length++] = (uint8_t)data_size;
+
+        uint8_t *data = &pdu_data[pdu_length];
+        if (coils) {
+            // First coil in the LSB of the first byte
+            memset(data, 0, data_size);
+            for (uint16_t i = 0; i < quantity; i++) {
+                if (run[i].value) {
+                    data[i / 8] |= (uint8_t)(1u << (i % 8));
+                }
+            }
+        } else {
+            for (uint16_t i = 0; i < quantity; i++) {
+                data[2 * i]     = (uint8_t)((run[i].value >> 8) & 0xFF);
+                data[2 * i + 1] = (uint8_t)(run[i].value & 0xFF);
+            }
+        }
+        pdu_length = (uint16_t)(pdu_length + data_size);
+    }
+
+    if (mb_transaction_is_broadcast(master, run[0].slave_id)) {
+        return mb_transaction_broadcast(master, &io.tx, fc, pdu_length);
+    }
+
+    uint8_t resp_fc;
+    const uint8_t *pdu_response = NULL;
+    uint16_t pdu_resp_length    = 0;
+
+    int result = mb_transaction_execute_view(master, &io.tx, run[0].slave_id, fc, pdu_length,
+                                             &io.rx, &resp_fc, &pdu_response, &pdu_resp_length);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    bool coil_value = run[0].value != 0;
+    const void *expected =
+        fc == MB_FC_WRITE_SINGLE_COIL ? (const void *)&coil_value : (const void *)&run[0].value;
+    return mb_parse_write_response(resp_fc, pdu_response, pdu_resp_length, address, quantity,
+                                   expected);
+}
+
+/**
+ * @brief Length of the frame-sized run of consecutive writes starting at first
+ */
+static uint16_t run_length(const mb_write_queue_t *queue, uint16_t first) {
+    const mb_write_entry_t *run = &queue->entries[first];
+    uint16_t max_quantity       = mb_fc_get_max_quantity(run->function_code);
+
+    uint16_t quantity = 1;
+    while (first + quantity < queue->count && quantity < max_quantity &&
+           run[quantity].slave_id == run->slave_id &&
+           run[quantity].function_code == run->function_code &&
+           (uint32_t)run[quantity].address == (uint32_t)run->address + quantity) {
+        quantity++;
+    }
+    return quantity;
+}
+
+/**
+ * @brief Drop the first sent writes, keeping the rest in order
+ */
+static void queue_consume(mb_write_queue_t *queue, uint16_t sent) {
+    memmove(queue->entries, &queue->entries[sent],
+            (size_t)(queue->count - sent) * sizeof(mb_write_entry_t));
+    queue->count = (uint16_t)(queue->count - sent);
+    for (uint16_t i = 0; i < queue->count; i++) {
+        queue->entries[i].order = i;
+    }
+}
+
+int mb_master_flush_writes(mb_master_t *master, mb_write_queue_t *queue, uint16_t *frame_count) {
+    if (master == NULL || queue == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (frame_count != NULL) {
+        *frame_count = 0;
+    }
+
+    queue_coalesce(queue);
+
+    int result    = MB_SUCCESS;
+    uint16_t sent = 0;
+    while (sent < queue->count) {
+        uint16_t quantity = run_length(queue, sent);
+
+        result = send_run(master, &queue->entries[sent], quantity);
+        if (result != MB_SUCCESS) {
+            break;
+        }
+
+        sent = (uint16_t)(sent + quantity);
+        if (frame_count != NULL) {
+            (*frame_count)++;
+        }
+    }
+
+    // Keep what was not acknowledged
+    queue_consume(queue, sent);
+    return result;
+}
+
+/**
+ * @brief Write a register run and read a plan in one FC23 transaction
+ * @param exception Output: exception code of an exception response
+ */
+static int send_fused(mb_master_t *master,
+                      const mb_write_entry_t *run,
+                      uint16_t quantity,
+                      const mb_request_plan_t *plan,
+                      const mb_scatter_entry_t *scatter,
+                      uint16_t *data_buffer,
+                      uint8_t *exception) {
+    mb_io_frame_t io;
+    uint16_t capacity   = 0;
+    uint8_t *pdu_data   = mb_transaction_begin(master, &io.tx, &capacity);
+    uint16_t pdu_length = 0;
+
+    if (capacity < 9 + quantity * 2) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    // Read range, write range, byte count, values; the slave writes first
+    pdu_data[pdu_length++] = (uint8_t)((plan->start_address >> 8) & 0xFF);
+    pdu_data[pdu_length++] = (uint8_t)(plan->start_address & 0xFF);
+    pdu_data[pdu_length++] = (uint8_t)((plan->quantity >> 8) & 0xFF);
+    pdu_data[pdu_length++] = (uint8_t)(plan->quantity & 0xFF);
+    pdu_data[pdu_length++] = (uint8_t)((run->address >> 8) & 0xFF);
+    pdu_data[pdu_length++] = (uint8_t)(run->address & 0xFF);
+    pdu_data[pdu_length++] = (uint8_t)((quantity >> 8) & 0xFF);
+    pdu_data[pdu_length++] = (uint8_t)(quantity & 0xFF);
+    pdu_data[pdu_length++] = (uint8_t)(quantity * 2);
+    for (uint16_t i = 0; i < quantity; i++) {
+        pdu_data[pdu_length++] = (uint8_t)((run[i].value >> 8) & 0xFF);
+        pdu_data[pdu_length++] = (uint8_t)(run[i].value & 0xFF);
+    }
+
+    uint8_t resp_fc;
+    const uint8_t *pdu_response = NULL;
+    uint16_t pdu_resp_length    = 0;
+
+    int result = mb_transaction_execute_view(master, &io.tx, plan->slave_id,
+                                             MB_FC_READ_WRITE_MULTIPLE_REGISTERS, pdu_length, &io.rx,
+                                             &resp_fc, &pdu_response, &pdu_resp_length);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    if (resp_fc & 0x80) {
+        *exception = mb_get_exception_code(pdu_response, pdu_resp_length);
+    }
+    return mb_parse_read_response_scatter(resp_fc, pdu_response, pdu_resp_length, plan->quantity,
+                                          &scatter[plan->scatter_first], plan->scatter_count,
+                                          data_buffer);
+}
+
+int mb_master_write_read(mb_master_t *master,
+                         mb_write_queue_t *queue,
+                         const mb_read_request_t *request,
+                         uint16_t *data_buffer,
+                         uint16_t buffer_size) {
+    if (master == NULL || queue == NULL || request == NULL || data_buffer == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (buffer_size < request->address_count) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    // Scatter map: one entry per requested address
+    mb_scatter_entry_t *scatter = NULL;
+
+#ifdef MB_USE_STATIC_MEMORY
+    if (request->address_count > MB_MAX_SCATTER) {
+        return MB_ERROR_TOO_MANY_BLOCKS;
+    }
+    scatter = master->scatter_pool;
+#else
+    size_t mark = mb_scratch_mark(&master->scratch);
+    if (request->address_count > 0) {
+        scatter = (mb_scatter_entry_t *)mb_scratch_acquire(
+            &master->scratch, request->address_count * sizeof(mb_scatter_entry_t));
+        if (scatter == NULL) {
+            return MB_ERROR_NO_MEMORY;
+        }
+    }
+#endif
+
+    mb_request_plan_t plans[16];
+    uint16_t plan_count = 0;
+    int result = mb_optimize_request(request, &master->config, plans, 16, &plan_count, scatter,
+                                     &master->scratch);
+
+    // Register runs of the read's slave ride along with its read plans
+    mb_profile_table_t *profiles = master->config.profiles;
+    bool fusable = request->function_code == MB_FC_READ_HOLDING_REGISTERS &&
+                   mb_profile_fc23(profiles, request->slave_id) == MB_FC23_SUPPORTED;
+    bool fused[16];
+    memset(fused, 0, sizeof(fused));
+    uint16_t next_plan = 0;
+
+    if (result == MB_SUCCESS) {
+        queue_coalesce(queue);
+    }
+
+    // Step 1: Writes first, each fused with the next read plan if possible
+    uint16_t sent = 0;
+    while (result == MB_SUCCESS && sent < queue->count) {
+        const mb_write_entry_t *run = &queue->entries[sent];
+        uint16_t quantity           = run_length(queue, sent);
+
+        if (fusable && next_plan < plan_count && run->slave_id == request->slave_id &&
+            run->function_code == MB_FC_WRITE_MULTIPLE_REGISTERS &&
+            quantity <= MB_FC23_MAX_WRITE) {
+            uint8_t exception = 0;
+            result = send_fused(master, run, quantity, &plans[next_plan], scatter, data_buffer,
+                                &exception);
+            if (result == MB_SUCCESS) {
+                fused[next_plan++] = true;
+                sent               = (uint16_t)(sent + quantity);
+                continue;
+            }
+            if (result != MB_ERROR_EXCEPTION_RESPONSE) {
+                break;
+            }
+
+            // Rejected: this write and read go out separately
+            if (exception == MB_EX_ILLEGAL_FUNCTION) {
+                mb_profile_set_fc23(profiles, request->slave_id, MB_FC23_UNSUPPORTED);
+                fusable = false;
+            }
+        }
+
+        result = send_run(master, run, quantity);
+        if (result == MB_SUCCESS) {
+            sent = (uint16_t)(sent + quantity);
+        }
+    }
+
+    queue_consume(queue, sent);
+
+    // Step 2: The read plans that carried no write
+    if (result == MB_SUCCESS) {
+        uint16_t remaining = 0;
+        for (uint16_t i = 0; i < plan_count; i++) {
+            if (!fused[i]) {
+                plans[remaining++] = plans[i];  // Keeps its scatter range
+            }
+        }
+
+        mb_scatter_ctx_t scatter_ctx;
+        scatter_ctx.plans       = plans;
+        scatter_ctx.scatter     = scatter;
+        scatter_ctx.data_buffer = data_buffer;
+        scatter_ctx.profiles    = profiles;
+        scatter_ctx.learned     = false;
+        scatter_ctx.bits        = NULL;
+        scatter_ctx.typed_tags  = NULL;
+        scatter_ctx.routes      = NULL;
+
+        result = mb_transaction_execute_plans(master, plans, remaining, mb_scatter_plan_response,
+                                              &scatter_ctx);
+    }
+
+#ifndef MB_USE_STATIC_MEMORY
+    mb_scratch_release(&master->scratch, scatter);
+    mb_scratch_rewind(&master->scratch, mark);
+#endif
+
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    master->stats.optimized_requests++;
+    master->stats.blocks_merged += (uint32_t)(request->address_count - plan_count);
+
+    return MB_SUCCESS;
+}
@@ -11,47 +11,107 @@
 #include "lrc.h"
 #include "smartmodbus/mb_error.h"
 
-#include <ctype.h>
-#include <string.h>
+/**
+ * @brief Hex digit pair of every byte value, upper case
+ */
+static const char hex_pairs[512 + 1] =
+    "000102030405060708090A0B0C0D0E0F"
+    "101112131415161718191A1B1C1D1E1F"
+    "202122232425262728292A2B2C2D2E2F"
+    "303132333435363738393A3B3C3D3E3F"
+    "404142434445464748494A4B4C4D4E4F"
+    "505152535455565758595A5B5C5D5E5F"
+    "606162636465666768696A6B6C6D6E6F"
+    "707172737475767778797A7B7C7D7E7F"
+    "808182838485868788898A8B8C8D8E8F"
+    "909192939495969798999A9B9C9D9E9F"
+    "A0A1A2A3A4A5A6A7A8A9AAABACADAEAF"
+    "B0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+    "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECF"
+    "D0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+    "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEF"
+    "F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+/**
+ * @brief Nibble value of every character, tagged with HEX_VALID (0 = not hex)
+ */
+#define HEX_VALID 0x10u
+#define HEX_DIGIT(c, v) [c] = (uint8_t)(HEX_VALID | (v))
+
+static const uint8_t hex_nibbles[256] = {
+    HEX_DIGIT('0', 0x0), HEX_DIGIT('1', 0x1), HEX_DIGIT('2', 0x2), HEX_DIGIT('3', 0x3),
+    HEX_DIGIT('4', 0x4), HEX_DIGIT('5', 0x5), HEX_DIGIT('6', 0x6), HEX_DIGIT('7', 0x7),
+    HEX_DIGIT('8', 0x8), HEX_DIGIT('9', 0x9), HEX_DIGIT('A', 0xA), HEX_DIGIT('B', 0xB),
+    HEX_DIGIT('C', 0xC), HEX_DIGIT('D', 0xD), HEX_DIGIT('E', 0xE), HEX_DIGIT('F', 0xF),
+    HEX_DIGIT('a', 0xA), HEX_DIGIT('b', 0xB), HEX_DIGIT('c', 0xC), HEX_DIGIT('d', 0xD),
+    HEX_DIGIT('e', 0xE), HEX_DIGIT('f', 0xF),
+};
 
 /**
  * @brief Convert byte to 2 ASCII hex characters
  */
-static void byte_to_hex(uint8_t byte, char *hex) {
-    const char hex_chars[] = "0123456789ABCDEF";
-    hex[0] = hex_chars[(byte >> 4) & 0x0F];
-    hex[1] = hex_chars[byte & 0x0F];
+static inline void byte_to_hex(uint8_t byte, uint8_t *hex) {
+    hex[0] = (uint8_t)hex_pairs[2 * byte];
+    hex[1] = (uint8_t)hex_pairs[2 * byte + 1];
 }
 
 /**
  * @brief Convert 2 ASCII hex characters to byte
  */
-static int hex_to_byte(const char *hex, uint8_t *byte) {
-    uint8_t high, low;
-
-    // Convert high nibble
-    if (hex[0] >= '0' && hex[0] <= '9') {
-        high = hex[0] - '0';
-    } else if (hex[0] >= 'A' && hex[0] <= 'F') {
-        high = hex[0] - 'A' + 10;
-    } else if (hex[0] >= 'a' && hex[0] <= 'f') {
-        high = hex[0] - 'a' + 10;
-    } else {
+static inline int hex_to_byte(const uint8_t *hex, uint8_t *byte) {
+    uint8_t high = hex_nibbles[hex[0]];
+    uint8_t low  = hex_nibbles[hex[1]];
+
+    if ((high & low & HEX_VALID) == 0) {
         return -1;
     }
 
-    // Convert low nibble
-    if (hex[1] >= '0' && hex[1] <= '9') {
-        low = hex[1] - '0';
-    } else if (hex[1] >= 'A' && hex[1] <= 'F') {
-        low = hex[1] - 'A' + 10;
-    } else if (hex[1] >= 'a' && hex[1] <= 'f') {
-        low = hex[1] - 'a' + 10;
-    } else {
-        return -1;
+    *byte = (uint8_t)((high << 4) | (low & 0x0F));
+    return 0;
+}
+
+/**
+ * @brief Encode bytes as hex and add them to the running LRC in one pass
+ * @return Updated LRC state
+ */
+static uint8_t hex_encode_lrc(uint8_t *hex, const uint8_t *data, uint16_t count, uint8_t lrc) {
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t byte = data[i];
+        byte_to_hex(byte, &hex[2 * i]);
+        lrc = (uint8_t)(lrc + byte);
+    }
+    return lrc;
+}
+
+/**
+ * @brief Decode hex pairs and add the bytes to the running LRC in one pass
+ * @param data Output bytes (NULL to only check and sum); may alias hex
+ *        at the same or a lower address
+ * @return 0 on success, -1 if any character is not a hex digit
+ *
+ * Validity is accumulated across the run and tested once at the end, so
+ * the loop has no data-dependent branch.
+ */
+static int hex_decode_lrc(uint8_t *data, const uint8_t *hex, uint16_t count, uint8_t *lrc) {
+    uint8_t valid = HEX_VALID;
+    uint8_t sum   = *lrc;
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t high = hex_nibbles[hex[2 * i]];
+        uint8_t low  = hex_nibbles[hex[2 * i + 1]];
+        uint8_t byte = (uint8_t)((high << 4) | (low & 0x0F));
+
+        valid &= (uint8_t)(high & low);
+        sum = (uint8_t)(sum + byte);
+        if (data != NULL) {
+            data[i] = byte;
+        }
     }
 
-    *byte = (high << 4) | low;
+    if ((valid & HEX_VALID) == 0) {
+        return -1;
+    }
+    *lrc = sum;
     return 0;
 }
 
@@ -77,36 +137,24 @@ int mb_ascii_build_frame(uint8_t slave_id,
     // 1. Start character
     frame_buffer[pos++] = ':';
 
-    // 2. Slave ID (2 hex chars)
-    byte_to_hex(slave_id, (char *)&frame_buffer[pos]);
-    pos += 2;
-
-    // 3. Function code (2 hex chars)
-    byte_to_hex(fc, (char *)&frame_buffer[pos]);
-    pos += 2;
-
-    // 4. PDU data (2 hex chars per byte)
-    for (uint16_t i = 0; i < pdu_length; i++) {
-        byte_to_hex(pdu_data[i], (char *)&frame_buffer[pos]);
-        pos += 2;
-    }
+    // 2. Slave ID and function code (2 hex chars each)
+    byte_to_hex(slave_id, &frame_buffer[pos]);
+    byte_to_hex(fc, &frame_buffer[pos + 2]);
+    pos += 4;
 
-    // 5. Calculate LRC on binary data (slave_id + fc + pdu_data)
-    uint8_t lrc_data[256];
-    uint16_t lrc_len = 0;
-    lrc_data[lrc_len++] = slave_id;
-    lrc_data[lrc_len++] = fc;
+    // 3. PDU data (2 hex chars per byte), LRC summed in the same pass
+    uint8_t lrc = mb_lrc_update_byte(mb_lrc_update_byte(mb_lrc_init(), slave_id), fc);
     if (pdu_data != NULL && pdu_length > 0) {
-        memcpy(&lrc_data[lrc_len], pdu_data, pdu_length);
-        lrc_len += pdu_length;
+        lrc = hex_encode_lrc(&frame_buffer[pos], pdu_data, pdu_length, lrc);
+        pos = (uint16_t)(pos + 2 * pdu_length);
     }
-    uint8_t lrc = mb_lrc(lrc_data, lrc_len);
+    lrc = mb_lrc_final(lrc);
 
-    // 6. Append LRC (2 hex chars)
-    byte_to_hex(lrc, (char *)&frame_buffer[pos]);
+    // 4. Append LRC (2 hex chars)
+    byte_to_hex(lrc, &frame_buffer[pos]);
     pos += 2;
 
-    // 7. CR LF
+    // 5. CR LF
     frame_buffer[pos++] = '\r';
     frame_buffer[pos++] = '\n';
 
@@ -141,13 +189,13 @@ int mb_ascii_parse_frame(const uint8_t *frame_data,
     uint16_t pos = 1; // Skip ':'
 
     // Parse slave ID
-    if (hex_to_byte((const char *)&frame_data[pos], slave_id) != 0) {
+    if (hex_to_byte(&frame_data[pos], slave_id) != 0) {
         return MB_ERROR_INVALID_FRAME;
     }
     pos += 2;
 
     // Parse function code
-    if (hex_to_byte((const char *)&frame_data[pos], fc) != 0) {
+    if (hex_to_byte(&frame_data[pos], fc) != 0) {
         return MB_ERROR_INVALID_FRAME;
     }
     pos += 2;
@@ -156,39 +204,108 @@ int mb_ascii_parse_frame(const uint8_t *frame_data,
     uint16_t pdu_hex_len = frame_length - 1 - 2 - 2 - 2 - 2;
     *pdu_length = pdu_hex_len / 2;
 
-    // Parse PDU data
-    if (pdu_data != NULL && *pdu_length > 0) {
-        for (uint16_t i = 0; i < *pdu_length; i++) {
-            if (hex_to_byte((const char *)&frame_data[pos], &pdu_data[i]) != 0) {
-                return MB_ERROR_INVALID_FRAME;
-            }
-            pos += 2;
-        }
-    } else {
-        pos += pdu_hex_len;
+    // Running LRC over every decoded byte, including the LRC itself
+    uint8_t lrc = mb_lrc_update_byte(mb_lrc_update_byte(mb_lrc_init(), *slave_id), *fc);
+
+    // Parse PDU data, summing the LRC as it is decoded
+    if (hex_decode_lrc(pdu_data, &frame_data[pos], *pdu_length, &lrc) != 0) {
+        return MB_ERROR_INVALID_FRAME;
     }
+    pos = (uint16_t)(pos + 2 * *pdu_length);
 
     // Parse LRC
     uint8_t frame_lrc;
-    if (hex_to_byte((const char *)&frame_data[pos], &frame_lrc) != 0) {
+    if (hex_to_byte(&frame_data[pos], &frame_lrc) != 0) {
+        return MB_ERROR_INVALID_FRAME;
+    }
+
+    // Sum of data + LRC is zero for an intact frame
+    if (mb_lrc_update_byte(lrc, frame_lrc) != 0) {
+        return MB_ERROR_LRC_MISMATCH;
+    }
+
+    return MB_SUCCESS;
+}
+
+int mb_ascii_encode_inplace(uint8_t slave_id,
+                            uint8_t fc,
+                            uint16_t pdu_length,
+                            uint8_t *frame_buffer,
+                            uint16_t buffer_size) {
+    if (frame_buffer == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (buffer_size < mb_ascii_calc_frame_length(pdu_length)) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    // 1. Expand the PDU back to front: byte i lands at 5 + 2i, never ahead of
+    //    unread input. The byte sum does not depend on order, so the LRC is
+    //    accumulated in the same pass.
+    uint8_t lrc = mb_lrc_update_byte(mb_lrc_update_byte(mb_lrc_init(), slave_id), fc);
+    for (uint16_t i = pdu_length; i-- > 0;) {
+        uint8_t byte = frame_buffer[MB_ASCII_PDU_OFFSET + i];
+        byte_to_hex(byte, &frame_buffer[MB_ASCII_PDU_OFFSET + 2 * i]);
+        lrc = (uint8_t)(lrc + byte);
+    }
+
+    // 2. Trailer: LRC + CR LF
+    uint16_t pos = (uint16_t)(MB_ASCII_PDU_OFFSET + 2 * pdu_length);
+    byte_to_hex(mb_lrc_final(lrc), &frame_buffer[pos]);
+    frame_buffer[pos + 2] = '\r';
+    frame_buffer[pos + 3] = '\n';
+
+    // 3. Header
+    frame_buffer[0] = ':';
+    byte_to_hex(slave_id, &frame_buffer[1]);
+    byte_to_hex(fc, &frame_buffer[3]);
+
+    return (int)(pos + 4);
+}
+
+int mb_ascii_parse_view(uint8_t *frame_data,
+                        uint16_t frame_length,
+                        uint8_t *slave_id,
+                        uint8_t *fc,
+                        const uint8_t **pdu_data,
+                        uint16_t *pdu_length) {
+    if (frame_data == NULL || slave_id == NULL || fc == NULL || pdu_data == NULL ||
+        pdu_length == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    // Minimum frame: ':'(1) + SlaveID(2) + FC(2) + LRC(2) + CRLF(2) = 9 bytes
+    if (frame_length < 9 || frame_data[0] != ':' || frame_data[frame_length - 2] != '\r' ||
+        frame_data[frame_length - 1] != '\n') {
+        return MB_ERROR_INVALID_FRAME;
+    }
+
+    if (hex_to_byte(&frame_data[1], slave_id) != 0 ||
+        hex_to_byte(&frame_data[3], fc) != 0) {
+        return MB_ERROR_INVALID_FRAME;
+    }
+
+    uint8_t lrc = mb_lrc_update_byte(mb_lrc_update_byte(mb_lrc_init(), *slave_id), *fc);
+    uint16_t count = (uint16_t)((frame_length - 9) / 2);
+
+    // Decode front to back: byte i is written at 5 + i, behind the hex still to read
+    if (hex_decode_lrc(&frame_data[MB_ASCII_PDU_OFFSET], &frame_data[MB_ASCII_PDU_OFFSET], count,
+                       &lrc) != 0) {
         return MB_ERROR_INVALID_FRAME;
     }
 
-    // Verify LRC
-    uint8_t lrc_data[256];
-    uint16_t lrc_len = 0;
-    lrc_data[lrc_len++] = *slave_id;
-    lrc_data[lrc_len++] = *fc;
-    if (pdu_data != NULL && *pdu_length > 0) {
-        memcpy(&lrc_data[lrc_len], pdu_data, *pdu_length);
-        lrc_len += *pdu_length;
+    uint8_t frame_lrc;
+    if (hex_to_byte(&frame_data[MB_ASCII_PDU_OFFSET + 2 * count], &frame_lrc) != 0) {
+        return MB_ERROR_INVALID_FRAME;
     }
-    uint8_t calculated_lrc = mb_lrc(lrc_data, lrc_len);
 
-    if (calculated_lrc != frame_lrc) {
+    if (mb_lrc_update_byte(lrc, frame_lrc) != 0) {
         return MB_ERROR_LRC_MISMATCH;
     }
 
+    *pdu_data   = &frame_data[MB_ASCII_PDU_OFFSET];
+    *pdu_length = count;
     return MB_SUCCESS;
 }
 
@@ -12,6 +12,11 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Offset of the binary PDU data (after ':', SlaveID and FC) for in-place encoding
+ */
+#define MB_ASCII_PDU_OFFSET 5
+
 /**
  * @brief Build ASCII frame
  * @param slave_id Slave device ID
@@ -46,6 +51,40 @@ int mb_ascii_parse_frame(const uint8_t *frame_data,
                          uint8_t *pdu_data,
                          uint16_t *pdu_length);
 
+/**
+ * @brief Finish an ASCII frame whose binary PDU data is already in the buffer
+ * @param slave_id Slave device ID
+ * @param fc Function code
+ * @param pdu_length Binary PDU length at frame_buffer + MB_ASCII_PDU_OFFSET
+ * @param frame_buffer Frame buffer holding the PDU data
+ * @param buffer_size Buffer size
+ * @return Frame length on success, negative error code on failure
+ *
+ * The PDU is hex-expanded in place, so no second buffer is needed.
+ */
+int mb_ascii_encode_inplace(uint8_t slave_id,
+                            uint8_t fc,
+                            uint16_t pdu_length,
+                            uint8_t *frame_buffer,
+                            uint16_t buffer_size);
+
+/**
+ * @brief Parse ASCII frame by decoding the PDU in place
+ * @param frame_data Frame data (overwritten with the decoded PDU)
+ * @param frame_length Frame length
+ * @param slave_id Output: slave ID
+ * @param fc Output: function code
+ * @param pdu_data Output: pointer to the decoded PDU inside frame_data
+ * @param pdu_length Output: PDU length
+ * @return 0 on success, negative error code on failure
+ */
+int mb_ascii_parse_view(uint8_t *frame_data,
+                        uint16_t frame_length,
+                        uint8_t *slave_id,
+                        uint8_t *fc,
+                        const uint8_t **pdu_data,
+                        uint16_t *pdu_length);
+
 /**
  * @brief Calculate ASCII frame length
  * @param pdu_length PDU length
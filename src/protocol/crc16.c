@@ -7,6 +7,9 @@
 
 #include "crc16.h"
 
+#include "crc16_kernels.h"
+#include "smartmodbus/mb_error.h"
+
 #include <stdbool.h>
 
 /**
@@ -39,9 +42,7 @@ static const uint16_t crc16_table[256] = {
     0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641, 0x8201, 0x42C0, 0x4380, 0x8341,
     0x4100, 0x81C1, 0x8081, 0x4040};
 
-uint16_t mb_crc16(const uint8_t *data, size_t length) {
-    uint16_t crc = 0xFFFF;
-
+uint16_t mb_crc16_table_update(uint16_t crc, const uint8_t *data, size_t length) {
     for (size_t i = 0; i < length; i++) {
         uint8_t index = (uint8_t)(crc ^ data[i]);
         crc           = (crc >> 8) ^ crc16_table[index];
@@ -50,6 +51,87 @@ uint16_t mb_crc16(const uint8_t *data, size_t length) {
     return crc;
 }
 
+/**
+ * @brief Active backend; resolved to the fastest available on first use
+ */
+static mb_crc16_backend_t active_backend = MB_CRC16_BACKEND_AUTO;
+static mb_crc16_kernel_t active_kernel   = NULL;
+
+static mb_crc16_kernel_t backend_kernel(mb_crc16_backend_t backend) {
+    switch (backend) {
+        case MB_CRC16_BACKEND_TABLE:
+            return mb_crc16_table_update;
+#ifdef MB_CRC16_SLICING
+        case MB_CRC16_BACKEND_SLICE4:
+            return mb_crc16_slice4_update;
+        case MB_CRC16_BACKEND_SLICE8:
+            return mb_crc16_slice8_update;
+#endif
+#ifdef MB_CRC16_CLMUL
+        case MB_CRC16_BACKEND_CLMUL:
+            return mb_crc16_clmul_supported() ? mb_crc16_clmul_kernel() : NULL;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+bool mb_crc16_backend_available(mb_crc16_backend_t backend) {
+    return backend == MB_CRC16_BACKEND_AUTO || backend_kernel(backend) != NULL;
+}
+
+int mb_crc16_set_backend(mb_crc16_backend_t backend) {
+    if (backend == MB_CRC16_BACKEND_AUTO) {
+        // Fastest first; the table is always there
+        static const mb_crc16_backend_t preference[] = {
+            MB_CRC16_BACKEND_CLMUL, MB_CRC16_BACKEND_SLICE8, MB_CRC16_BACKEND_SLICE4,
+            MB_CRC16_BACKEND_TABLE};
+
+        for (size_t i = 0; i < sizeof(preference) / sizeof(preference[0]); i++) {
+            if (backend_kernel(preference[i]) != NULL) {
+                backend = preference[i];
+                break;
+            }
+        }
+    }
+
+    mb_crc16_kernel_t kernel = backend_kernel(backend);
+    if (kernel == NULL) {
+        return MB_ERROR_NOT_SUPPORTED;
+    }
+
+    active_backend = backend;
+    active_kernel  = kernel;
+    return MB_SUCCESS;
+}
+
+mb_crc16_backend_t mb_crc16_get_backend(void) {
+    if (active_kernel == NULL) {
+        (void)mb_crc16_set_backend(MB_CRC16_BACKEND_AUTO);
+    }
+    return active_backend;
+}
+
+uint16_t mb_crc16_init(void) {
+    return MB_CRC16_INIT;
+}
+
+uint16_t mb_crc16_update(uint16_t crc, const uint8_t *data, size_t length) {
+    if (active_kernel == NULL) {
+        (void)mb_crc16_set_backend(MB_CRC16_BACKEND_AUTO);
+    }
+    return active_kernel(crc, data, length);
+}
+
+uint16_t mb_crc16_final(uint16_t crc) {
+    // CRC16-MODBUS has no final XOR
+    return crc;
+}
+
+uint16_t mb_crc16(const uint8_t *data, size_t length) {
+    return mb_crc16_final(mb_crc16_update(mb_crc16_init(), data, length));
+}
+
 bool mb_crc16_verify(const uint8_t *frame, size_t length) {
     if (frame == NULL || length < 4) {
         return false;
@@ -3,6 +3,11 @@
  * @brief CRC16 calculation for Modbus RTU
  *
  * Implements the CRC16-MODBUS algorithm used in Modbus RTU frames.
+ *
+ * Several interchangeable backends are available. The byte table is always
+ * built; slicing tables (MB_CRC16_SLICING) and carry-less multiply kernels
+ * (MB_CRC16_CLMUL) are build options. By default the fastest backend the
+ * running CPU supports is picked on first use.
  */
 
 #ifndef SMARTMODBUS_CRC16_H
@@ -16,6 +21,72 @@
 extern "C" {
 #endif
 
+/**
+ * @brief CRC16 backend selection
+ */
+typedef enum {
+    MB_CRC16_BACKEND_AUTO = 0, /**< Fastest available backend */
+    MB_CRC16_BACKEND_TABLE,    /**< Byte-at-a-time 256-entry table */
+    MB_CRC16_BACKEND_SLICE4,   /**< Slice-by-4 tables */
+    MB_CRC16_BACKEND_SLICE8,   /**< Slice-by-8 tables */
+    MB_CRC16_BACKEND_CLMUL     /**< PCLMULQDQ (x86) / PMULL (ARMv8) folding */
+} mb_crc16_backend_t;
+
+/**
+ * @brief Check whether a backend is compiled in and supported by this CPU
+ * @param backend Backend to query
+ * @return true if mb_crc16_set_backend() would accept it
+ */
+bool mb_crc16_backend_available(mb_crc16_backend_t backend);
+
+/**
+ * @brief Select the backend used by mb_crc16() and mb_crc16_verify()
+ * @param backend Backend, or MB_CRC16_BACKEND_AUTO for the fastest available
+ * @return 0 on success, MB_ERROR_NOT_SUPPORTED if the backend is unavailable
+ *
+ * Not thread-safe against concurrent CRC calls; select once at startup.
+ */
+int mb_crc16_set_backend(mb_crc16_backend_t backend);
+
+/**
+ * @brief Get the backend currently in use (resolves AUTO)
+ * @return Active backend, never MB_CRC16_BACKEND_AUTO
+ */
+mb_crc16_backend_t mb_crc16_get_backend(void);
+
+/**
+ * @brief Initial CRC16-MODBUS register value
+ */
+#define MB_CRC16_INIT 0xFFFF
+
+/**
+ * @brief Start an incremental CRC16 computation
+ * @return Initial CRC state
+ */
+uint16_t mb_crc16_init(void);
+
+/**
+ * @brief Feed more bytes into an incremental CRC16 computation
+ * @param crc State from mb_crc16_init() or a previous update
+ * @param data Data buffer
+ * @param length Data length in bytes
+ * @return Updated CRC state
+ *
+ * Chunks may have any size, so bytes can be fed as they arrive (per byte,
+ * per DMA half-buffer, ...). Uses the active backend.
+ */
+uint16_t mb_crc16_update(uint16_t crc, const uint8_t *data, size_t length);
+
+/**
+ * @brief Finish an incremental CRC16 computation
+ * @param crc Final state
+ * @return CRC16 value, identical to mb_crc16() over the concatenated chunks
+ *
+ * Feeding a frame *including* its two CRC bytes leaves a state of 0 when the
+ * frame is intact, so receivers can validate without a second pass.
+ */
+uint16_t mb_crc16_final(uint16_t crc);
+
 /**
  * @brief Calculate CRC16 for Modbus RTU
  * @param data Data buffer
@@ -0,0 +1,210 @@
+/**
+ * @file crc16_clmul.c
+ * @brief Carry-less multiply CRC16-MODBUS kernels (PCLMULQDQ / PMULL)
+ *
+ * The bit-reflected message is folded 128 bits at a time: for a block
+ * X = H·x^64 + L followed by n more bits, X·x^n ≡ H·(x^(n+64) mod P) +
+ * L·(x^n mod P), which two 64x64 carry-less multiplies compute. Four
+ * independent accumulators hide the multiply latency on long inputs. The
+ * last 128-bit remainder is reduced with the table kernel, which costs 16
+ * lookups and avoids a Barrett step for a 16-bit polynomial.
+ *
+ * Constants are reflected 64-bit values of x^(k-1) mod 0x18005; the extra
+ * x^-1 absorbs the one-bit shift of a reflected carry-less product.
+ */
+
+#include "crc16_kernels.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define CRC16_CLMUL_X86 1
+#elif defined(__aarch64__) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES))
+#define CRC16_CLMUL_ARM 1
+#endif
+
+#if defined(CRC16_CLMUL_X86) || defined(CRC16_CLMUL_ARM)
+
+#define CRC16_K127 0xC100000000000000ULL  // x^127 mod P, fold by 128 (low half)
+#define CRC16_K191 0xCCD0000000000000ULL  // x^191 mod P, fold by 128 (high half)
+#define CRC16_K511 0x8101000000000000ULL  // x^511 mod P, fold by 512 (low half)
+#define CRC16_K575 0xC450000000000000ULL  // x^575 mod P, fold by 512 (high half)
+
+// Below this, setup and the final 16-byte reduction outweigh the folding
+#define CRC16_CLMUL_MIN_LENGTH 128
+
+/**
+ * @brief Inputs too short to fold: run the best table kernel directly
+ */
+static uint16_t crc16_clmul_finish_short(uint16_t crc, const uint8_t *data, size_t length) {
+#ifdef MB_CRC16_SLICING
+    return mb_crc16_slice8_update(crc, data, length);
+#else
+    return mb_crc16_table_update(crc, data, length);
+#endif
+}
+
+/**
+ * @brief Reduce the folded 16-byte remainder and any tail
+ */
+static uint16_t crc16_clmul_finish(const uint8_t folded[16], const uint8_t *data, size_t length) {
+    return crc16_clmul_finish_short(crc16_clmul_finish_short(0, folded, 16), data, length);
+}
+
+#endif
+
+#if defined(CRC16_CLMUL_X86)
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+__attribute__((target("pclmul,sse2"))) static inline __m128i crc16_fold(__m128i x, __m128i k) {
+    __m128i lo = _mm_clmulepi64_si128(x, k, 0x00);
+    __m128i hi = _mm_clmulepi64_si128(x, k, 0x11);
+    return _mm_xor_si128(lo, hi);
+}
+
+__attribute__((target("pclmul,sse2"))) static uint16_t crc16_pclmul_update(uint16_t crc,
+                                                                          const uint8_t *data,
+                                                                          size_t length) {
+    if (length < CRC16_CLMUL_MIN_LENGTH) {
+        return crc16_clmul_finish_short(crc, data, length);
+    }
+
+    const __m128i k128 = _mm_set_epi64x((long long)CRC16_K127, (long long)CRC16_K191);
+    __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(const void *)data),
+                              _mm_cvtsi32_si128((int)crc));
+    data += 16;
+    length -= 16;
+
+    if (length >= 112) {
+        const __m128i k512 = _mm_set_epi64x((long long)CRC16_K511, (long long)CRC16_K575);
+        __m128i x1 = _mm_loadu_si128((const __m128i *)(const void *)(data + 0));
+        __m128i x2 = _mm_loadu_si128((const __m128i *)(const void *)(data + 16));
+        __m128i x3 = _mm_loadu_si128((const __m128i *)(const void *)(data + 32));
+        data += 48;
+        length -= 48;
+
+        while (length >= 64) {
+            x  = _mm_xor_si128(crc16_fold(x, k512),
+                               _mm_loadu_si128((const __m128i *)(const void *)(data + 0)));
+            x1 = _mm_xor_si128(crc16_fold(x1, k512),
+                               _mm_loadu_si128((const __m128i *)(const void *)(data + 16)));
+            x2 = _mm_xor_si128(crc16_fold(x2, k512),
+                               _mm_loadu_si128((const __m128i *)(const void *)(data + 32)));
+            x3 = _mm_xor_si128(crc16_fold(x3, k512),
+                               _mm_loadu_si128((const __m128i *)(const void *)(data + 48)));
+            data += 64;
+            length -= 64;
+        }
+
+        // Collapse the four lanes into one
+        x = _mm_xor_si128(crc16_fold(x, k128), x1);
+        x = _mm_xor_si128(crc16_fold(x, k128), x2);
+        x = _mm_xor_si128(crc16_fold(x, k128), x3);
+    }
+
+    while (length >= 16) {
+        x = _mm_xor_si128(crc16_fold(x, k128),
+                          _mm_loadu_si128((const __m128i *)(const void *)data));
+        data += 16;
+        length -= 16;
+    }
+
+    uint8_t folded[16];
+    _mm_storeu_si128((__m128i *)(void *)folded, x);
+    return crc16_clmul_finish(folded, data, length);
+}
+
+#elif defined(CRC16_CLMUL_ARM)
+
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#ifndef HWCAP_PMULL
+#define HWCAP_PMULL (1 << 4)
+#endif
+#endif
+
+static inline uint64x2_t crc16_fold(uint64x2_t x, poly64_t k_lo, poly64_t k_hi) {
+    poly128_t lo = vmull_p64((poly64_t)vgetq_lane_u64(x, 0), k_hi);
+    poly128_t hi = vmull_p64((poly64_t)vgetq_lane_u64(x, 1), k_lo);
+    return veorq_u64(vreinterpretq_u64_p128(lo), vreinterpretq_u64_p128(hi));
+}
+
+static inline uint64x2_t crc16_load(const uint8_t *data) {
+    return vreinterpretq_u64_u8(vld1q_u8(data));
+}
+
+static uint16_t crc16_pmull_update(uint16_t crc, const uint8_t *data, size_t length) {
+    if (length < CRC16_CLMUL_MIN_LENGTH) {
+        return crc16_clmul_finish_short(crc, data, length);
+    }
+
+    uint64x2_t x = veorq_u64(crc16_load(data), vcombine_u64(vcreate_u64(crc), vcreate_u64(0)));
+    data += 16;
+    length -= 16;
+
+    if (length >= 112) {
+        uint64x2_t x1 = crc16_load(data + 0);
+        uint64x2_t x2 = crc16_load(data + 16);
+        uint64x2_t x3 = crc16_load(data + 32);
+        data += 48;
+        length -= 48;
+
+        while (length >= 64) {
+            x  = veorq_u64(crc16_fold(x, CRC16_K511, CRC16_K575), crc16_load(data + 0));
+            x1 = veorq_u64(crc16_fold(x1, CRC16_K511, CRC16_K575), crc16_load(data + 16));
+            x2 = veorq_u64(crc16_fold(x2, CRC16_K511, CRC16_K575), crc16_load(data + 32));
+            x3 = veorq_u64(crc16_fold(x3, CRC16_K511, CRC16_K575), crc16_load(data + 48));
+            data += 64;
+            length -= 64;
+        }
+
+        x = veorq_u64(crc16_fold(x, CRC16_K127, CRC16_K191), x1);
+        x = veorq_u64(crc16_fold(x, CRC16_K127, CRC16_K191), x2);
+        x = veorq_u64(crc16_fold(x, CRC16_K127, CRC16_K191), x3);
+    }
+
+    while (length >= 16) {
+        x = veorq_u64(crc16_fold(x, CRC16_K127, CRC16_K191), crc16_load(data));
+        data += 16;
+        length -= 16;
+    }
+
+    uint8_t folded[16];
+    vst1q_u8(folded, vreinterpretq_u8_u64(x));
+    return crc16_clmul_finish(folded, data, length);
+}
+
+#endif
+
+mb_crc16_kernel_t mb_crc16_clmul_kernel(void) {
+#if defined(CRC16_CLMUL_X86)
+    return crc16_pclmul_update;
+#elif defined(CRC16_CLMUL_ARM)
+    return crc16_pmull_update;
+#else
+    return NULL;
+#endif
+}
+
+bool mb_crc16_clmul_supported(void) {
+#if defined(CRC16_CLMUL_X86)
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+
+    // CPUID leaf 1: ECX bit 1 = PCLMULQDQ, EDX bit 26 = SSE2
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0) {
+        return false;
+    }
+    return (ecx & (1u << 1)) != 0 && (edx & (1u << 26)) != 0;
+#elif defined(CRC16_CLMUL_ARM) && defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_PMULL) != 0;
+#elif defined(CRC16_CLMUL_ARM)
+    // Built with the crypto extension enabled: assume the target has it
+    return true;
+#else
+    return false;
+#endif
+}
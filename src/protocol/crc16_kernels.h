@@ -0,0 +1,59 @@
+/**
+ * @file crc16_kernels.h
+ * @brief CRC16-MODBUS backend kernels (internal)
+ *
+ * Every kernel continues a running CRC over more data, so kernels can hand
+ * tails to each other. mb_crc16() dispatches to one of them; see crc16.h.
+ */
+
+#ifndef SMARTMODBUS_CRC16_KERNELS_H
+#define SMARTMODBUS_CRC16_KERNELS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Kernel signature: continue @p crc over @p length bytes
+ */
+typedef uint16_t (*mb_crc16_kernel_t)(uint16_t crc, const uint8_t *data, size_t length);
+
+/**
+ * @brief Byte-at-a-time 256-entry table (baseline, always built)
+ */
+uint16_t mb_crc16_table_update(uint16_t crc, const uint8_t *data, size_t length);
+
+#ifdef MB_CRC16_SLICING
+/**
+ * @brief Slice-by-4: four bytes per round from 4 x 256 tables
+ */
+uint16_t mb_crc16_slice4_update(uint16_t crc, const uint8_t *data, size_t length);
+
+/**
+ * @brief Slice-by-8: eight bytes per round from 8 x 256 tables
+ */
+uint16_t mb_crc16_slice8_update(uint16_t crc, const uint8_t *data, size_t length);
+#endif
+
+#ifdef MB_CRC16_CLMUL
+/**
+ * @brief Carry-less multiply kernel (PCLMULQDQ or PMULL), NULL if not built
+ * @return Kernel, or NULL when no carry-less multiply kernel was compiled
+ */
+mb_crc16_kernel_t mb_crc16_clmul_kernel(void);
+
+/**
+ * @brief Check whether the running CPU supports the compiled CLMUL kernel
+ */
+bool mb_crc16_clmul_supported(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_CRC16_KERNELS_H
@@ -3,6 +3,7 @@
  * @brief Frame builder orchestrator implementation
  *
  * Dispatches frame building to appropriate protocol-specific builder.
+ * RTU-over-TCP frames exactly like RTU.
  */
 
 #include "frame_builder.h"
@@ -17,6 +18,7 @@ int mb_build_frame(uint8_t slave_id,
                    const uint8_t *pdu_data,
                    uint16_t pdu_length,
                    mb_mode_t mode,
+                   uint16_t transaction_id,
                    uint8_t *frame_buffer,
                    uint16_t buffer_size,
                    uint16_t *frame_length) {
@@ -24,11 +26,14 @@ int mb_build_frame(uint8_t slave_id,
         return MB_ERROR_INVALID_PARAM;
     }
 
+    (void)transaction_id; // Only used in TCP mode
+
     int result;
 
     switch (mode) {
 #ifdef MB_ENABLE_RTU
     case MB_MODE_RTU:
+    case MB_MODE_RTU_OVER_TCP:
         result = mb_rtu_build_frame(slave_id, fc, pdu_data, pdu_length, frame_buffer, buffer_size);
         break;
 #endif
@@ -41,8 +46,8 @@ int mb_build_frame(uint8_t slave_id,
 
 #ifdef MB_ENABLE_TCP
     case MB_MODE_TCP:
-        // For TCP, use transaction_id = 0 (will be set by master)
-        result = mb_tcp_build_frame(0, slave_id, fc, pdu_data, pdu_length, frame_buffer, buffer_size);
+        result = mb_tcp_build_frame(transaction_id, slave_id, fc, pdu_data, pdu_length, frame_buffer,
+                                    buffer_size);
         break;
 #endif
 
@@ -61,6 +66,7 @@ int mb_build_frame(uint8_t slave_id,
 int mb_parse_frame(const uint8_t *frame_data,
                    uint16_t frame_length,
                    mb_mode_t mode,
+                   uint16_t *transaction_id,
                    uint8_t *slave_id,
                    uint8_t *fc,
                    uint8_t *pdu_data,
@@ -69,9 +75,12 @@ int mb_parse_frame(const uint8_t *frame_data,
         return MB_ERROR_INVALID_PARAM;
     }
 
+    (void)transaction_id; // Only used in TCP mode
+
     switch (mode) {
 #ifdef MB_ENABLE_RTU
     case MB_MODE_RTU:
+    case MB_MODE_RTU_OVER_TCP:
         return mb_rtu_parse_frame(frame_data, frame_length, slave_id, fc, pdu_data, pdu_length);
 #endif
 
@@ -82,9 +91,129 @@ int mb_parse_frame(const uint8_t *frame_data,
 
 #ifdef MB_ENABLE_TCP
     case MB_MODE_TCP: {
-        uint16_t transaction_id;
-        return mb_tcp_parse_frame(frame_data, frame_length, &transaction_id, slave_id, fc, pdu_data,
-                                  pdu_length);
+        uint16_t tid;
+        int result = mb_tcp_parse_frame(frame_data, frame_length, &tid, slave_id, fc, pdu_data,
+                                        pdu_length);
+        if (result == MB_SUCCESS && transaction_id != NULL) {
+            *transaction_id = tid;
+        }
+        return result;
+    }
+#endif
+
+    default:
+        return MB_ERROR_NOT_SUPPORTED;
+    }
+}
+
+uint16_t mb_frame_pdu_offset(mb_mode_t mode) {
+    switch (mode) {
+#ifdef MB_ENABLE_RTU
+    case MB_MODE_RTU:
+    case MB_MODE_RTU_OVER_TCP:
+        return MB_RTU_PDU_OFFSET;
+#endif
+
+#ifdef MB_ENABLE_ASCII
+    case MB_MODE_ASCII:
+        return MB_ASCII_PDU_OFFSET;
+#endif
+
+#ifdef MB_ENABLE_TCP
+    case MB_MODE_TCP:
+        return MB_TCP_PDU_OFFSET;
+#endif
+
+    default:
+        return 0;
+    }
+}
+
+int mb_encode_frame_inplace(uint8_t slave_id,
+                            uint8_t fc,
+                            uint16_t pdu_length,
+                            mb_mode_t mode,
+                            uint16_t transaction_id,
+                            uint8_t *frame_buffer,
+                            uint16_t buffer_size,
+                            uint16_t *frame_length) {
+    if (frame_buffer == NULL || frame_length == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    (void)transaction_id; // Only used in TCP mode
+
+    int result;
+
+    switch (mode) {
+#ifdef MB_ENABLE_RTU
+    case MB_MODE_RTU:
+    case MB_MODE_RTU_OVER_TCP:
+        result = mb_rtu_encode_inplace(slave_id, fc, pdu_length, frame_buffer, buffer_size);
+        break;
+#endif
+
+#ifdef MB_ENABLE_ASCII
+    case MB_MODE_ASCII:
+        result = mb_ascii_encode_inplace(slave_id, fc, pdu_length, frame_buffer, buffer_size);
+        break;
+#endif
+
+#ifdef MB_ENABLE_TCP
+    case MB_MODE_TCP:
+        result = mb_tcp_encode_inplace(transaction_id, slave_id, fc, pdu_length, frame_buffer,
+                                       buffer_size);
+        break;
+#endif
+
+    default:
+        return MB_ERROR_NOT_SUPPORTED;
+    }
+
+    if (result > 0) {
+        *frame_length = (uint16_t)result;
+        return MB_SUCCESS;
+    }
+
+    return result;
+}
+
+int mb_parse_frame_view(uint8_t *frame_data,
+                        uint16_t frame_length,
+                        mb_mode_t mode,
+                        uint16_t *transaction_id,
+                        uint8_t *slave_id,
+                        uint8_t *fc,
+                        const uint8_t **pdu_data,
+                        uint16_t *pdu_length) {
+    if (frame_data == NULL || slave_id == NULL || fc == NULL || pdu_data == NULL ||
+        pdu_length == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    (void)transaction_id; // Only used in TCP mode
+
+    switch (mode) {
+#ifdef MB_ENABLE_RTU
+    case MB_MODE_RTU:
+    case MB_MODE_RTU_OVER_TCP:
+        return mb_rtu_parse_view(frame_data, frame_length, slave_id, fc, pdu_data, pdu_length);
+#endif
+
+#ifdef MB_ENABLE_ASCII
+    case MB_MODE_ASCII:
+        return mb_ascii_parse_view(frame_data, frame_length, slave_id, fc, pdu_data, pdu_length);
+#endif
+
+#ifdef MB_ENABLE_TCP
+    case MB_MODE_TCP: {
+        uint16_t tid;
+        int result = mb_tcp_parse_view(frame_data, frame_length, &tid, slave_id, fc, pdu_data,
+                                       pdu_length);
+        if (result == MB_SUCCESS && transaction_id != NULL) {
+            *transaction_id = tid;
+        }
+        return result;
     }
 #endif
 
@@ -97,6 +226,7 @@ uint16_t mb_calc_frame_length(uint16_t pdu_length, mb_mode_t mode) {
     switch (mode) {
 #ifdef MB_ENABLE_RTU
     case MB_MODE_RTU:
+    case MB_MODE_RTU_OVER_TCP:
         return mb_rtu_calc_frame_length(pdu_length);
 #endif
 
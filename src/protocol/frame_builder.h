@@ -8,6 +8,11 @@
 
 #include "smartmodbus/mb_types.h"
 
+#ifdef MB_FIXED_MODE
+// Single-mode build: inline calls instead of the mode dispatch below
+#include "frame_fixed.h"
+#else
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -19,6 +24,7 @@ extern "C" {
  * @param pdu_data PDU data
  * @param pdu_length PDU length
  * @param mode Protocol mode
+ * @param transaction_id MBAP transaction ID (TCP only, ignored otherwise)
  * @param frame_buffer Output frame buffer
  * @param buffer_size Buffer size
  * @param frame_length Output: actual frame length
@@ -29,6 +35,7 @@ int mb_build_frame(uint8_t slave_id,
                    const uint8_t *pdu_data,
                    uint16_t pdu_length,
                    mb_mode_t mode,
+                   uint16_t transaction_id,
                    uint8_t *frame_buffer,
                    uint16_t buffer_size,
                    uint16_t *frame_length);
@@ -38,6 +45,7 @@ int mb_build_frame(uint8_t slave_id,
  * @param frame_data Frame data
  * @param frame_length Frame length
  * @param mode Protocol mode
+ * @param transaction_id Output: MBAP transaction ID (TCP only, may be NULL)
  * @param slave_id Output: slave ID
  * @param fc Output: function code
  * @param pdu_data Output: PDU data
@@ -47,11 +55,66 @@ int mb_build_frame(uint8_t slave_id,
 int mb_parse_frame(const uint8_t *frame_data,
                    uint16_t frame_length,
                    mb_mode_t mode,
+                   uint16_t *transaction_id,
                    uint8_t *slave_id,
                    uint8_t *fc,
                    uint8_t *pdu_data,
                    uint16_t *pdu_length);
 
+/**
+ * @brief Headroom in front of the PDU data for in-place encoding
+ * @param mode Protocol mode
+ * @return Offset where the PDU data (after FC) must be written
+ *
+ * RTU: SlaveID + FC (2), ASCII: ':' + hex SlaveID + hex FC (5),
+ * TCP: MBAP header + FC (8).
+ */
+uint16_t mb_frame_pdu_offset(mb_mode_t mode);
+
+/**
+ * @brief Encode a frame around PDU data already written at mb_frame_pdu_offset()
+ * @param slave_id Slave device ID
+ * @param fc Function code
+ * @param pdu_length PDU length
+ * @param mode Protocol mode
+ * @param transaction_id MBAP transaction ID (TCP only, ignored otherwise)
+ * @param frame_buffer Frame buffer holding the PDU data (e.g. a transport TX buffer)
+ * @param buffer_size Buffer size
+ * @param frame_length Output: actual frame length
+ * @return 0 on success, negative error code on failure
+ */
+int mb_encode_frame_inplace(uint8_t slave_id,
+                            uint8_t fc,
+                            uint16_t pdu_length,
+                            mb_mode_t mode,
+                            uint16_t transaction_id,
+                            uint8_t *frame_buffer,
+                            uint16_t buffer_size,
+                            uint16_t *frame_length);
+
+/**
+ * @brief Parse a frame and return a view of its PDU instead of a copy
+ * @param frame_data Frame data (ASCII frames are decoded in place)
+ * @param frame_length Frame length
+ * @param mode Protocol mode
+ * @param transaction_id Output: MBAP transaction ID (TCP only, may be NULL)
+ * @param slave_id Output: slave ID
+ * @param fc Output: function code
+ * @param pdu_data Output: pointer to the PDU data inside frame_data
+ * @param pdu_length Output: PDU length
+ * @return 0 on success, negative error code on failure
+ *
+ * The view is valid as long as frame_data is.
+ */
+int mb_parse_frame_view(uint8_t *frame_data,
+                        uint16_t frame_length,
+                        mb_mode_t mode,
+                        uint16_t *transaction_id,
+                        uint8_t *slave_id,
+                        uint8_t *fc,
+                        const uint8_t **pdu_data,
+                        uint16_t *pdu_length);
+
 /**
  * @brief Calculate frame length for any protocol
  * @param pdu_length PDU length
@@ -64,4 +127,6 @@ uint16_t mb_calc_frame_length(uint16_t pdu_length, mb_mode_t mode);
 }
 #endif
 
+#endif  // MB_FIXED_MODE
+
 #endif  // SMARTMODBUS_FRAME_BUILDER_H
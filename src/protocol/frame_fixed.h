@@ -0,0 +1,162 @@
+/**
+ * @file frame_fixed.h
+ * @brief Frame builder for single-mode builds (MB_FIXED_MODE)
+ *
+ * Replaces the mode dispatch of frame_builder.c with inline calls into the
+ * one protocol compiled in. Callers passing MB_ACTIVE_MODE() get no mode
+ * test at all; any other mode is rejected with MB_ERROR_NOT_SUPPORTED.
+ * Included by frame_builder.h only.
+ */
+
+#ifndef SMARTMODBUS_FRAME_FIXED_H
+#define SMARTMODBUS_FRAME_FIXED_H
+
+#include "smartmodbus/mb_error.h"
+#include "smartmodbus/mb_types.h"
+
+#if defined(MB_FIXED_MODE_RTU)
+#include "rtu_frame.h"
+#define FIXED_PDU_OFFSET MB_RTU_PDU_OFFSET
+#define FIXED_BUILD(tid, slave, fc, pdu, len, buf, size) \
+    ((void)(tid), mb_rtu_build_frame(slave, fc, pdu, len, buf, size))
+#define FIXED_ENCODE(tid, slave, fc, len, buf, size) \
+    ((void)(tid), mb_rtu_encode_inplace(slave, fc, len, buf, size))
+#define FIXED_PARSE(data, length, tid, slave, fc, pdu, len) \
+    ((void)(tid), mb_rtu_parse_frame(data, length, slave, fc, pdu, len))
+#define FIXED_VIEW(data, length, tid, slave, fc, pdu, len) \
+    ((void)(tid), mb_rtu_parse_view(data, length, slave, fc, pdu, len))
+#define FIXED_LENGTH(len) mb_rtu_calc_frame_length(len)
+#elif defined(MB_FIXED_MODE_ASCII)
+#include "ascii_frame.h"
+#define FIXED_PDU_OFFSET MB_ASCII_PDU_OFFSET
+#define FIXED_BUILD(tid, slave, fc, pdu, len, buf, size) \
+    ((void)(tid), mb_ascii_build_frame(slave, fc, pdu, len, buf, size))
+#define FIXED_ENCODE(tid, slave, fc, len, buf, size) \
+    ((void)(tid), mb_ascii_encode_inplace(slave, fc, len, buf, size))
+#define FIXED_PARSE(data, length, tid, slave, fc, pdu, len) \
+    ((void)(tid), mb_ascii_parse_frame(data, length, slave, fc, pdu, len))
+#define FIXED_VIEW(data, length, tid, slave, fc, pdu, len) \
+    ((void)(tid), mb_ascii_parse_view(data, length, slave, fc, pdu, len))
+#define FIXED_LENGTH(len) mb_ascii_calc_frame_length(len)
+#elif defined(MB_FIXED_MODE_TCP)
+#include "tcp_frame.h"
+#define FIXED_PDU_OFFSET MB_TCP_PDU_OFFSET
+#define FIXED_BUILD(tid, slave, fc, pdu, len, buf, size) \
+    mb_tcp_build_frame(tid, slave, fc, pdu, len, buf, size)
+#define FIXED_ENCODE(tid, slave, fc, len, buf, size) \
+    mb_tcp_encode_inplace(tid, slave, fc, len, buf, size)
+#define FIXED_PARSE(data, length, tid, slave, fc, pdu, len) \
+    mb_tcp_parse_frame(data, length, tid, slave, fc, pdu, len)
+#define FIXED_VIEW(data, length, tid, slave, fc, pdu, len) \
+    mb_tcp_parse_view(data, length, tid, slave, fc, pdu, len)
+#define FIXED_LENGTH(len) mb_tcp_calc_frame_length(len)
+#endif
+
+/**
+ * @brief Frame length from a protocol builder result
+ */
+static inline int fixed_frame_result(int result, uint16_t *frame_length) {
+    if (result > 0) {
+        *frame_length = (uint16_t)result;
+        return MB_SUCCESS;
+    }
+    return result;
+}
+
+static inline int mb_build_frame(uint8_t slave_id,
+                                 uint8_t fc,
+                                 const uint8_t *pdu_data,
+                                 uint16_t pdu_length,
+                                 mb_mode_t mode,
+                                 uint16_t transaction_id,
+                                 uint8_t *frame_buffer,
+                                 uint16_t buffer_size,
+                                 uint16_t *frame_length) {
+    if (frame_buffer == NULL || frame_length == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+    if (mode != MB_FIXED_MODE) {
+        return MB_ERROR_NOT_SUPPORTED;
+    }
+
+    return fixed_frame_result(FIXED_BUILD(transaction_id, slave_id, fc, pdu_data, pdu_length,
+                                          frame_buffer, buffer_size),
+                              frame_length);
+}
+
+static inline int mb_parse_frame(const uint8_t *frame_data,
+                                 uint16_t frame_length,
+                                 mb_mode_t mode,
+                                 uint16_t *transaction_id,
+                                 uint8_t *slave_id,
+                                 uint8_t *fc,
+                                 uint8_t *pdu_data,
+                                 uint16_t *pdu_length) {
+    if (frame_data == NULL || slave_id == NULL || fc == NULL || pdu_length == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+    if (mode != MB_FIXED_MODE) {
+        return MB_ERROR_NOT_SUPPORTED;
+    }
+
+    uint16_t tid = 0;
+    int result = FIXED_PARSE(frame_data, frame_length, &tid, slave_id, fc, pdu_data, pdu_length);
+    if (result == MB_SUCCESS && transaction_id != NULL) {
+        *transaction_id = tid;
+    }
+    return result;
+}
+
+static inline uint16_t mb_frame_pdu_offset(mb_mode_t mode) {
+    return mode == MB_FIXED_MODE ? FIXED_PDU_OFFSET : 0;
+}
+
+static inline int mb_encode_frame_inplace(uint8_t slave_id,
+                                          uint8_t fc,
+                                          uint16_t pdu_length,
+                                          mb_mode_t mode,
+                                          uint16_t transaction_id,
+                                          uint8_t *frame_buffer,
+                                          uint16_t buffer_size,
+                                          uint16_t *frame_length) {
+    if (frame_buffer == NULL || frame_length == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+    if (mode != MB_FIXED_MODE) {
+        return MB_ERROR_NOT_SUPPORTED;
+    }
+
+    return fixed_frame_result(
+        FIXED_ENCODE(transaction_id, slave_id, fc, pdu_length, frame_buffer, buffer_size),
+        frame_length);
+}
+
+static inline int mb_parse_frame_view(uint8_t *frame_data,
+                                      uint16_t frame_length,
+                                      mb_mode_t mode,
+                                      uint16_t *transaction_id,
+                                      uint8_t *slave_id,
+                                      uint8_t *fc,
+                                      const uint8_t **pdu_data,
+                                      uint16_t *pdu_length) {
+    if (frame_data == NULL || slave_id == NULL || fc == NULL || pdu_data == NULL ||
+        pdu_length == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+    if (mode != MB_FIXED_MODE) {
+        return MB_ERROR_NOT_SUPPORTED;
+    }
+
+    uint16_t tid = 0;
+    int result = FIXED_VIEW(frame_data, frame_length, &tid, slave_id, fc, pdu_data, pdu_length);
+    if (result == MB_SUCCESS && transaction_id != NULL) {
+        *transaction_id = tid;
+    }
+    return result;
+}
+
+static inline uint16_t mb_calc_frame_length(uint16_t pdu_length, mb_mode_t mode) {
+    return mode == MB_FIXED_MODE ? FIXED_LENGTH(pdu_length) : 0;
+}
+
+#endif  // SMARTMODBUS_FRAME_FIXED_H
@@ -13,17 +13,29 @@ uint8_t mb_lrc(const uint8_t *data, size_t length) {
         return 0;
     }
 
-    uint8_t lrc = 0;
+    return mb_lrc_final(mb_lrc_update(mb_lrc_init(), data, length));
+}
+
+uint8_t mb_lrc_init(void) {
+    return 0;
+}
 
+uint8_t mb_lrc_update(uint8_t sum, const uint8_t *data, size_t length) {
     // Sum all bytes
     for (size_t i = 0; i < length; i++) {
-        lrc += data[i];
+        sum = (uint8_t)(sum + data[i]);
     }
 
-    // Two's complement
-    lrc = (uint8_t)(-((int8_t)lrc));
+    return sum;
+}
+
+uint8_t mb_lrc_update_byte(uint8_t sum, uint8_t byte) {
+    return (uint8_t)(sum + byte);
+}
 
-    return lrc;
+uint8_t mb_lrc_final(uint8_t sum) {
+    // Two's complement
+    return (uint8_t)(-((int8_t)sum));
 }
 
 bool mb_lrc_verify(const uint8_t *frame, size_t length) {
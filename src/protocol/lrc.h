@@ -16,6 +16,38 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Start an incremental LRC computation
+ * @return Initial LRC state (running byte sum)
+ */
+uint8_t mb_lrc_init(void);
+
+/**
+ * @brief Feed more bytes into an incremental LRC computation
+ * @param sum State from mb_lrc_init() or a previous update
+ * @param data Data buffer
+ * @param length Data length in bytes
+ * @return Updated LRC state
+ */
+uint8_t mb_lrc_update(uint8_t sum, const uint8_t *data, size_t length);
+
+/**
+ * @brief Feed a single byte into an incremental LRC computation
+ * @param sum Current state
+ * @param byte Byte to add
+ * @return Updated LRC state
+ */
+uint8_t mb_lrc_update_byte(uint8_t sum, uint8_t byte);
+
+/**
+ * @brief Finish an incremental LRC computation
+ * @param sum Final state
+ * @return LRC value, identical to mb_lrc() over the concatenated chunks
+ *
+ * Feeding the LRC byte itself as well leaves a state of 0 for an intact frame.
+ */
+uint8_t mb_lrc_final(uint8_t sum);
+
 /**
  * @brief Calculate LRC for Modbus ASCII
  * @param data Data buffer
@@ -23,29 +23,39 @@ int mb_rtu_build_frame(uint8_t slave_id,
         return MB_ERROR_INVALID_PARAM;
     }
 
-    // Calculate required buffer size: SlaveID(1) + FC(1) + PDU + CRC(2)
-    uint16_t required_size = 1 + 1 + pdu_length + 2;
-
-    if (buffer_size < required_size) {
+    if (buffer_size < mb_rtu_calc_frame_length(pdu_length)) {
         return MB_ERROR_BUFFER_TOO_SMALL;
     }
 
-    // Build frame
-    uint16_t pos = 0;
+    if (pdu_data != NULL && pdu_length > 0) {
+        memcpy(&frame_buffer[MB_RTU_PDU_OFFSET], pdu_data, pdu_length);
+    }
 
-    // 1. Write slave ID
-    frame_buffer[pos++] = slave_id;
+    return mb_rtu_encode_inplace(slave_id, fc, pdu_length, frame_buffer, buffer_size);
+}
 
-    // 2. Write function code
-    frame_buffer[pos++] = fc;
+int mb_rtu_encode_inplace(uint8_t slave_id,
+                          uint8_t fc,
+                          uint16_t pdu_length,
+                          uint8_t *frame_buffer,
+                          uint16_t buffer_size) {
+    if (frame_buffer == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
 
-    // 3. Write PDU data
-    if (pdu_data != NULL && pdu_length > 0) {
-        memcpy(&frame_buffer[pos], pdu_data, pdu_length);
-        pos += pdu_length;
+    // Calculate required buffer size: SlaveID(1) + FC(1) + PDU + CRC(2)
+    uint16_t required_size = mb_rtu_calc_frame_length(pdu_length);
+
+    if (buffer_size < required_size) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
     }
 
-    // 4. Calculate and append CRC16 (little-endian)
+    // 1. Slave ID and function code in front of the PDU already in place
+    frame_buffer[0] = slave_id;
+    frame_buffer[1] = fc;
+
+    // 2. Calculate and append CRC16 (little-endian)
+    uint16_t pos = (uint16_t)(MB_RTU_PDU_OFFSET + pdu_length);
     uint16_t crc = mb_crc16(frame_buffer, pos);
     frame_buffer[pos++] = (uint8_t)(crc & 0xFF);        // CRC low byte
     frame_buffer[pos++] = (uint8_t)((crc >> 8) & 0xFF); // CRC high byte
@@ -59,7 +69,29 @@ int mb_rtu_parse_frame(const uint8_t *frame_data,
                        uint8_t *fc,
                        uint8_t *pdu_data,
                        uint16_t *pdu_length) {
-    if (frame_data == NULL || slave_id == NULL || fc == NULL || pdu_length == NULL) {
+    const uint8_t *pdu_view = NULL;
+
+    int result = mb_rtu_parse_view(frame_data, frame_length, slave_id, fc, &pdu_view, pdu_length);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    // Copy PDU data if buffer provided
+    if (pdu_data != NULL && *pdu_length > 0) {
+        memcpy(pdu_data, pdu_view, *pdu_length);
+    }
+
+    return MB_SUCCESS;
+}
+
+int mb_rtu_parse_view(const uint8_t *frame_data,
+                      uint16_t frame_length,
+                      uint8_t *slave_id,
+                      uint8_t *fc,
+                      const uint8_t **pdu_data,
+                      uint16_t *pdu_length) {
+    if (frame_data == NULL || slave_id == NULL || fc == NULL || pdu_data == NULL ||
+        pdu_length == NULL) {
         return MB_ERROR_INVALID_PARAM;
     }
 
@@ -78,12 +110,8 @@ int mb_rtu_parse_frame(const uint8_t *frame_data,
     *fc = frame_data[1];
 
     // PDU length = frame_length - SlaveID(1) - FC(1) - CRC(2)
-    *pdu_length = frame_length - 4;
-
-    // Copy PDU data if buffer provided
-    if (pdu_data != NULL && *pdu_length > 0) {
-        memcpy(pdu_data, &frame_data[2], *pdu_length);
-    }
+    *pdu_length = (uint16_t)(frame_length - 4);
+    *pdu_data   = &frame_data[MB_RTU_PDU_OFFSET];
 
     return MB_SUCCESS;
 }
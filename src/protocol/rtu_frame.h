@@ -12,6 +12,11 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Offset of the PDU data (after SlaveID and FC) in an RTU frame
+ */
+#define MB_RTU_PDU_OFFSET 2
+
 /**
  * @brief Build RTU frame
  * @param slave_id Slave device ID
@@ -29,6 +34,21 @@ int mb_rtu_build_frame(uint8_t slave_id,
                        uint8_t *frame_buffer,
                        uint16_t buffer_size);
 
+/**
+ * @brief Finish an RTU frame whose PDU data is already in the buffer
+ * @param slave_id Slave device ID
+ * @param fc Function code
+ * @param pdu_length PDU length at frame_buffer + MB_RTU_PDU_OFFSET
+ * @param frame_buffer Frame buffer holding the PDU data
+ * @param buffer_size Buffer size
+ * @return Frame length on success, negative error code on failure
+ */
+int mb_rtu_encode_inplace(uint8_t slave_id,
+                          uint8_t fc,
+                          uint16_t pdu_length,
+                          uint8_t *frame_buffer,
+                          uint16_t buffer_size);
+
 /**
  * @brief Parse RTU frame
  * @param frame_data Frame data
@@ -46,6 +66,23 @@ int mb_rtu_parse_frame(const uint8_t *frame_data,
                        uint8_t *pdu_data,
                        uint16_t *pdu_length);
 
+/**
+ * @brief Parse RTU frame without copying the PDU
+ * @param frame_data Frame data
+ * @param frame_length Frame length
+ * @param slave_id Output: slave ID
+ * @param fc Output: function code
+ * @param pdu_data Output: pointer to the PDU data inside frame_data
+ * @param pdu_length Output: PDU length
+ * @return 0 on success, negative error code on failure
+ */
+int mb_rtu_parse_view(const uint8_t *frame_data,
+                      uint16_t frame_length,
+                      uint8_t *slave_id,
+                      uint8_t *fc,
+                      const uint8_t **pdu_data,
+                      uint16_t *pdu_length);
+
 /**
  * @brief Calculate RTU frame length
  * @param pdu_length PDU length
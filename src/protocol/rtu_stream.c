@@ -0,0 +1,149 @@
+/**
+ * @file rtu_stream.c
+ * @brief Streaming RTU frame receiver implementation
+ *
+ * The CRC register is advanced over each chunk as it is committed. A frame
+ * followed by its own CRC (low byte first) drives the CRC16-MODBUS register
+ * to zero, so end-of-frame validation is a single comparison.
+ */
+
+#include "rtu_stream.h"
+
+#include "crc16.h"
+#include "smartmodbus/mb_error.h"
+#include "smartmodbus/mb_types.h"
+
+#include <string.h>
+
+void mb_rtu_stream_reset(mb_rtu_stream_t *stream) {
+    if (stream == NULL) {
+        return;
+    }
+
+    stream->length   = 0;
+    stream->crc      = mb_crc16_init();
+    stream->overflow = false;
+}
+
+int mb_rtu_stream_push(mb_rtu_stream_t *stream, const uint8_t *data, size_t length) {
+    if (stream == NULL || (data == NULL && length > 0)) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    size_t space = 0;
+    uint8_t *tail = mb_rtu_stream_tail(stream, &space);
+
+    if (length > space) {
+        // Keep what fits so the caller can still inspect the header
+        memcpy(tail, data, space);
+        (void)mb_rtu_stream_commit(stream, space);
+        stream->overflow = true;
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    memcpy(tail, data, length);
+    return mb_rtu_stream_commit(stream, length);
+}
+
+uint8_t *mb_rtu_stream_tail(mb_rtu_stream_t *stream, size_t *space) {
+    if (stream == NULL || space == NULL) {
+        return NULL;
+    }
+
+    *space = sizeof(stream->frame) - stream->length;
+    return &stream->frame[stream->length];
+}
+
+int mb_rtu_stream_commit(mb_rtu_stream_t *stream, size_t length) {
+    if (stream == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (length > sizeof(stream->frame) - stream->length) {
+        stream->overflow = true;
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    stream->crc = mb_crc16_update(stream->crc, &stream->frame[stream->length], length);
+    stream->length = (uint16_t)(stream->length + length);
+    return MB_SUCCESS;
+}
+
+int mb_rtu_stream_expected(const mb_rtu_stream_t *stream) {
+    if (stream == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (stream->length < 2) {
+        return 0;
+    }
+
+    uint8_t fc = stream->frame[1];
+    if ((fc & 0x80) != 0) {
+        return 5;  // SlaveID + FC + exception code + CRC
+    }
+
+    switch (fc) {
+    case MB_FC_READ_COILS:
+    case MB_FC_READ_DISCRETE_INPUTS:
+    case MB_FC_READ_HOLDING_REGISTERS:
+    case MB_FC_READ_INPUT_REGISTERS:
+    case MB_FC_READ_WRITE_MULTIPLE_REGISTERS:
+        // SlaveID + FC + byte count + data + CRC
+        return stream->length < 3 ? 0 : 5 + (int)stream->frame[2];
+
+    case MB_FC_WRITE_SINGLE_COIL:
+    case MB_FC_WRITE_SINGLE_REGISTER:
+    case MB_FC_WRITE_MULTIPLE_COILS:
+    case MB_FC_WRITE_MULTIPLE_REGISTERS:
+        return 8;  // Echo of address and value/quantity
+
+    case MB_FC_MASK_WRITE_REGISTER:
+        return 10;  // Echo of address, AND mask and OR mask
+
+    default:
+        return MB_ERROR_NOT_SUPPORTED;
+    }
+}
+
+int mb_rtu_stream_end(const mb_rtu_stream_t *stream) {
+    if (stream == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    // Minimum frame: SlaveID(1) + FC(1) + CRC(2) = 4 bytes
+    if (stream->overflow || stream->length < 4) {
+        return MB_ERROR_INVALID_FRAME;
+    }
+
+    if (mb_crc16_final(stream->crc) != 0) {
+        return MB_ERROR_CRC_MISMATCH;
+    }
+
+    return (int)stream->length;
+}
+
+int mb_rtu_stream_parse(const mb_rtu_stream_t *stream,
+                        uint8_t *slave_id,
+                        uint8_t *fc,
+                        uint8_t *pdu_data,
+                        uint16_t *pdu_length) {
+    if (slave_id == NULL || fc == NULL || pdu_length == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    int frame_length = mb_rtu_stream_end(stream);
+    if (frame_length < 0) {
+        return frame_length;
+    }
+
+    *slave_id   = stream->frame[0];
+    *fc         = stream->frame[1];
+    *pdu_length = (uint16_t)(frame_length - 4);
+
+    if (pdu_data != NULL && *pdu_length > 0) {
+        memcpy(pdu_data, &stream->frame[2], *pdu_length);
+    }
+
+    return MB_SUCCESS;
+}
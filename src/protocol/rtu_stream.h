@@ -0,0 +1,115 @@
+/**
+ * @file rtu_stream.h
+ * @brief Streaming RTU frame receiver
+ *
+ * Accumulates an RTU frame as it arrives (per byte from a UART ISR, per DMA
+ * half-buffer, or per transport read) and keeps the CRC up to date on every
+ * chunk. When the 3.5-character silence ends the frame, mb_rtu_stream_end()
+ * validates it from the running CRC alone, without another pass.
+ *
+ * For responses whose length follows from the header (function code and,
+ * for reads, the byte count), mb_rtu_stream_expected() tells when the last
+ * byte arrived, so the frame can be closed without waiting for the silence.
+ */
+
+#ifndef SMARTMODBUS_RTU_STREAM_H
+#define SMARTMODBUS_RTU_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Largest RTU ADU: SlaveID(1) + PDU(253) + CRC(2)
+ */
+#define MB_RTU_MAX_ADU 256
+
+/**
+ * @brief Streaming receiver state
+ */
+typedef struct {
+    uint8_t frame[MB_RTU_MAX_ADU]; /**< Bytes received so far */
+    uint16_t length;               /**< Valid bytes in frame[] */
+    uint16_t crc;                  /**< Running CRC over frame[0..length) */
+    bool overflow;                 /**< More than MB_RTU_MAX_ADU bytes arrived */
+} mb_rtu_stream_t;
+
+/**
+ * @brief Discard any partial frame and start a new one
+ * @param stream Receiver state
+ */
+void mb_rtu_stream_reset(mb_rtu_stream_t *stream);
+
+/**
+ * @brief Append received bytes
+ * @param stream Receiver state
+ * @param data Received bytes
+ * @param length Number of bytes
+ * @return 0 on success, MB_ERROR_BUFFER_TOO_SMALL once the frame overflows
+ */
+int mb_rtu_stream_push(mb_rtu_stream_t *stream, const uint8_t *data, size_t length);
+
+/**
+ * @brief Free space for receiving directly into the stream (e.g. DMA)
+ * @param stream Receiver state
+ * @param space Output: bytes that may be written at the returned pointer
+ * @return Write position inside the frame buffer
+ *
+ * Bytes written there become part of the frame after mb_rtu_stream_commit().
+ */
+uint8_t *mb_rtu_stream_tail(mb_rtu_stream_t *stream, size_t *space);
+
+/**
+ * @brief Account for bytes written at mb_rtu_stream_tail()
+ * @param stream Receiver state
+ * @param length Number of bytes written
+ * @return 0 on success, MB_ERROR_BUFFER_TOO_SMALL if length exceeds the space
+ */
+int mb_rtu_stream_commit(mb_rtu_stream_t *stream, size_t length);
+
+/**
+ * @brief Length of the response frame being received
+ * @param stream Receiver state
+ * @return Total frame length including CRC, 0 while the header bytes that
+ *         determine it are still missing, MB_ERROR_NOT_SUPPORTED if the
+ *         function code does not determine it (the frame ends at the silence)
+ *
+ * Exception responses are 5 bytes; reads (01-04, 23) carry their byte count
+ * in the third byte; write responses have a fixed length.
+ */
+int mb_rtu_stream_expected(const mb_rtu_stream_t *stream);
+
+/**
+ * @brief Close the frame at the end-of-frame silence and validate it
+ * @param stream Receiver state
+ * @return Frame length on success, MB_ERROR_INVALID_FRAME if too short or
+ *         overflowed, MB_ERROR_CRC_MISMATCH if the CRC does not match
+ */
+int mb_rtu_stream_end(const mb_rtu_stream_t *stream);
+
+/**
+ * @brief Validate the completed frame and extract its fields
+ * @param stream Receiver state
+ * @param slave_id Output: slave ID
+ * @param fc Output: function code
+ * @param pdu_data Output: PDU data buffer (may be NULL)
+ * @param pdu_length Output: PDU length
+ * @return 0 on success, negative error code on failure
+ *
+ * Equivalent to mb_rtu_parse_frame() on the received bytes, minus the CRC pass.
+ */
+int mb_rtu_stream_parse(const mb_rtu_stream_t *stream,
+                        uint8_t *slave_id,
+                        uint8_t *fc,
+                        uint8_t *pdu_data,
+                        uint16_t *pdu_length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_RTU_STREAM_H
@@ -24,8 +24,30 @@ int mb_tcp_build_frame(uint16_t transaction_id,
         return MB_ERROR_INVALID_PARAM;
     }
 
+    if (buffer_size < mb_tcp_calc_frame_length(pdu_length)) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    if (pdu_data != NULL && pdu_length > 0) {
+        memcpy(&frame_buffer[MB_TCP_PDU_OFFSET], pdu_data, pdu_length);
+    }
+
+    return mb_tcp_encode_inplace(transaction_id, unit_id, fc, pdu_length, frame_buffer,
+                                 buffer_size);
+}
+
+int mb_tcp_encode_inplace(uint16_t transaction_id,
+                          uint8_t unit_id,
+                          uint8_t fc,
+                          uint16_t pdu_length,
+                          uint8_t *frame_buffer,
+                          uint16_t buffer_size) {
+    if (frame_buffer == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
     // Calculate required size: MBAP header(7) + FC(1) + PDU
-    uint16_t required_size = 7 + 1 + pdu_length;
+    uint16_t required_size = mb_tcp_calc_frame_length(pdu_length);
 
     if (buffer_size < required_size) {
         return MB_ERROR_BUFFER_TOO_SMALL;
@@ -42,23 +64,17 @@ int mb_tcp_build_frame(uint16_t transaction_id,
     frame_buffer[pos++] = 0x00;
 
     // 3. Length field (2 bytes, big-endian): UnitID(1) + FC(1) + PDU length
-    uint16_t length = 1 + 1 + pdu_length;
+    uint16_t length = (uint16_t)(1 + 1 + pdu_length);
     frame_buffer[pos++] = (uint8_t)((length >> 8) & 0xFF);
     frame_buffer[pos++] = (uint8_t)(length & 0xFF);
 
     // 4. Unit ID (1 byte)
     frame_buffer[pos++] = unit_id;
 
-    // 5. Function code (1 byte)
+    // 5. Function code (1 byte); the PDU data follows in place
     frame_buffer[pos++] = fc;
 
-    // 6. PDU data
-    if (pdu_data != NULL && pdu_length > 0) {
-        memcpy(&frame_buffer[pos], pdu_data, pdu_length);
-        pos += pdu_length;
-    }
-
-    return (int)pos;
+    return (int)(pos + pdu_length);
 }
 
 int mb_tcp_parse_frame(const uint8_t *frame_data,
@@ -68,8 +84,31 @@ int mb_tcp_parse_frame(const uint8_t *frame_data,
                        uint8_t *fc,
                        uint8_t *pdu_data,
                        uint16_t *pdu_length) {
+    const uint8_t *pdu_view = NULL;
+
+    int result = mb_tcp_parse_view(frame_data, frame_length, transaction_id, unit_id, fc,
+                                   &pdu_view, pdu_length);
+    if (result != MB_SUCCESS) {
+        return result;
+    }
+
+    // Copy PDU data if buffer provided
+    if (pdu_data != NULL && *pdu_length > 0) {
+        memcpy(pdu_data, pdu_view, *pdu_length);
+    }
+
+    return MB_SUCCESS;
+}
+
+int mb_tcp_parse_view(const uint8_t *frame_data,
+                      uint16_t frame_length,
+                      uint16_t *transaction_id,
+                      uint8_t *unit_id,
+                      uint8_t *fc,
+                      const uint8_t **pdu_data,
+                      uint16_t *pdu_length) {
     if (frame_data == NULL || transaction_id == NULL || unit_id == NULL ||
-        fc == NULL || pdu_length == NULL) {
+        fc == NULL || pdu_data == NULL || pdu_length == NULL) {
         return MB_ERROR_INVALID_PARAM;
     }
 
@@ -81,18 +120,18 @@ int mb_tcp_parse_frame(const uint8_t *frame_data,
     uint16_t pos = 0;
 
     // 1. Parse transaction ID (big-endian)
-    *transaction_id = ((uint16_t)frame_data[pos] << 8) | frame_data[pos + 1];
+    *transaction_id = (uint16_t)(((uint16_t)frame_data[pos] << 8) | frame_data[pos + 1]);
     pos += 2;
 
     // 2. Parse protocol ID (should be 0x0000)
-    uint16_t protocol_id = ((uint16_t)frame_data[pos] << 8) | frame_data[pos + 1];
+    uint16_t protocol_id = (uint16_t)(((uint16_t)frame_data[pos] << 8) | frame_data[pos + 1]);
     pos += 2;
     if (protocol_id != 0x0000) {
         return MB_ERROR_INVALID_FRAME;
     }
 
     // 3. Parse length field (big-endian)
-    uint16_t length = ((uint16_t)frame_data[pos] << 8) | frame_data[pos + 1];
+    uint16_t length = (uint16_t)(((uint16_t)frame_data[pos] << 8) | frame_data[pos + 1]);
     pos += 2;
 
     // Verify length matches frame
@@ -106,13 +145,9 @@ int mb_tcp_parse_frame(const uint8_t *frame_data,
     // 5. Parse function code
     *fc = frame_data[pos++];
 
-    // 6. Calculate PDU length: length - UnitID(1) - FC(1)
-    *pdu_length = length - 2;
-
-    // 7. Copy PDU data if buffer provided
-    if (pdu_data != NULL && *pdu_length > 0) {
-        memcpy(pdu_data, &frame_data[pos], *pdu_length);
-    }
+    // 6. PDU length: length - UnitID(1) - FC(1)
+    *pdu_length = (uint16_t)(length - 2);
+    *pdu_data   = &frame_data[pos];
 
     return MB_SUCCESS;
 }
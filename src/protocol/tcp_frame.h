@@ -12,6 +12,11 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Offset of the PDU data (after MBAP header and FC) in a TCP frame
+ */
+#define MB_TCP_PDU_OFFSET 8
+
 /**
  * @brief Build TCP frame with MBAP header
  * @param transaction_id Transaction ID
@@ -31,6 +36,23 @@ int mb_tcp_build_frame(uint16_t transaction_id,
                        uint8_t *frame_buffer,
                        uint16_t buffer_size);
 
+/**
+ * @brief Finish a TCP frame whose PDU data is already in the buffer
+ * @param transaction_id Transaction ID
+ * @param unit_id Unit ID (slave ID)
+ * @param fc Function code
+ * @param pdu_length PDU length at frame_buffer + MB_TCP_PDU_OFFSET
+ * @param frame_buffer Frame buffer holding the PDU data
+ * @param buffer_size Buffer size
+ * @return Frame length on success, negative error code on failure
+ */
+int mb_tcp_encode_inplace(uint16_t transaction_id,
+                          uint8_t unit_id,
+                          uint8_t fc,
+                          uint16_t pdu_length,
+                          uint8_t *frame_buffer,
+                          uint16_t buffer_size);
+
 /**
  * @brief Parse TCP frame
  * @param frame_data Frame data
@@ -50,6 +72,25 @@ int mb_tcp_parse_frame(const uint8_t *frame_data,
                        uint8_t *pdu_data,
                        uint16_t *pdu_length);
 
+/**
+ * @brief Parse TCP frame without copying the PDU
+ * @param frame_data Frame data
+ * @param frame_length Frame length
+ * @param transaction_id Output: transaction ID
+ * @param unit_id Output: unit ID
+ * @param fc Output: function code
+ * @param pdu_data Output: pointer to the PDU data inside frame_data
+ * @param pdu_length Output: PDU length
+ * @return 0 on success, negative error code on failure
+ */
+int mb_tcp_parse_view(const uint8_t *frame_data,
+                      uint16_t frame_length,
+                      uint16_t *transaction_id,
+                      uint8_t *unit_id,
+                      uint8_t *fc,
+                      const uint8_t **pdu_data,
+                      uint16_t *pdu_length);
+
 /**
  * @brief Calculate TCP frame length
  * @param pdu_length PDU length
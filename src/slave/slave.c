@@ -0,0 +1,433 @@
+/**
+ * @file slave.c
+ * @brief Modbus slave request execution over a flat register store
+ *
+ * Every table is addressed by offset = address - base, checked once per
+ * request against the table size. Register runs are converted between
+ * host order and the wire with the bulk codec, coil runs with word-wide
+ * bit moves, so a request costs one pass over the bytes it carries.
+ */
+
+#include "smartmodbus/mb_slave.h"
+#include "smartmodbus/mb_error.h"
+#include "../protocol/frame_builder.h"
+#include "../utils/bitset.h"
+#include "../utils/reg_codec.h"
+
+#include <string.h>
+
+/**
+ * @brief Largest response PDU data (without function code)
+ */
+#define SLAVE_MAX_PDU 252
+
+/**
+ * @brief Quantity limits of the read and write requests
+ */
+#define SLAVE_MAX_READ_BITS  2000
+#define SLAVE_MAX_READ_REGS  125
+#define SLAVE_MAX_WRITE_BITS 1968
+#define SLAVE_MAX_WRITE_REGS 123
+#define SLAVE_MAX_RW_REGS    121
+
+static uint16_t get_u16(const uint8_t *data) {
+    return (uint16_t)((data[0] << 8) | data[1]);
+}
+
+/**
+ * @brief Offset of [address, address + quantity) in a table, or -1
+ */
+static int32_t table_offset(const void *data,
+                            uint16_t base,
+                            uint16_t count,
+                            uint16_t address,
+                            uint16_t quantity) {
+    if (data == NULL || address < base) {
+        return -1;
+    }
+
+    uint32_t offset = (uint32_t)address - base;
+    return offset + quantity <= count ? (int32_t)offset : -1;
+}
+
+/**
+ * @brief Pack count bits starting at bit first into response bytes, LSB first
+ */
+static void pack_bits(uint8_t *dst, const uint32_t *bits, uint32_t first, uint16_t count) {
+    const uint32_t *words = &bits[first / 32];
+    uint32_t shift        = first % 32;
+    uint32_t word_count   = (shift + count + 31) / 32;
+    uint16_t bytes        = (uint16_t)((count + 7) / 8);
+
+    for (uint16_t b = 0; b < bytes; b++) {
+        uint32_t bit  = shift + 8u * b;
+        uint32_t w    = bit / 32;
+        uint32_t s    = bit % 32;
+        uint32_t byte = words[w] >> s;
+        if (s > 24 && w + 1 < word_count) {
+            byte |= words[w + 1] << (32 - s);
+        }
+        dst[b] = (uint8_t)byte;
+    }
+
+    if (count % 8 != 0) {
+        dst[bytes - 1] &= (uint8_t)((1u << (count % 8)) - 1);
+    }
+}
+
+static void notify(const mb_slave_t *slave, uint8_t fc, uint16_t address, uint16_t quantity) {
+    if (slave->config.on_write != NULL) {
+        slave->config.on_write(slave->config.context, fc, address, quantity);
+    }
+}
+
+static uint8_t read_bits(const mb_slave_bits_t *table,
+                         const uint8_t *pdu,
+                         uint16_t pdu_length,
+                         uint8_t *out,
+                         uint16_t *out_length) {
+    if (pdu_length != 4) {
+        return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+    uint16_t address  = get_u16(pdu);
+    uint16_t quantity = get_u16(&pdu[2]);
+    if (quantity == 0 || quantity > SLAVE_MAX_READ_BITS) {
+        return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+    int32_t offset = table_offset(table->bits, table->base, table->count, address, quantity);
+    if (offset < 0) {
+        return MB_EX_ILLEGAL_DATA_ADDRESS;
+    }
+
+    out[0] = (uint8_t)((quantity + 7) / 8);
+    pack_bits(&out[1], table->bits, (uint32_t)offset, quantity);
+    *out_length = (uint16_t)(1 + out[0]);
+    return 0;
+}
+
+static uint8_t read_regs(const mb_slave_regs_t *table,
+                         const uint8_t *pdu,
+                         uint16_t pdu_length,
+                         uint8_t *out,
+                         uint16_t *out_length) {
+    if (pdu_length != 4) {
+        return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+    uint16_t address  = get_u16(pdu);
+    uint16_t quantity = get_u16(&pdu[2]);
+    if (quantity == 0 || quantity > SLAVE_MAX_READ_REGS) {
+        return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+    int32_t offset = table_offset(table->regs, table->base, table->count, address, quantity);
+    if (offset < 0) {
+        return MB_EX_ILLEGAL_DATA_ADDRESS;
+    }
+
+    out[0] = (uint8_t)(quantity * 2);
+    mb_regs_encode(&out[1], &table->regs[offset], quantity);
+    *out_length = (uint16_t)(1 + out[0]);
+    return 0;
+}
+
+static uint8_t write_coil(mb_slave_t *slave,
+                          const uint8_t *pdu,
+                          uint16_t pdu_length,
+                          uint8_t *out,
+                          uint16_t *out_length) {
+    const mb_slave_bits_t *table = &slave->config.coils;
+    if (pdu_length != 4) {
+        return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+    uint16_t address = get_u16(pdu);
+    uint16_t value   = get_u16(&pdu[2]);
+    if (value != 0xFF00 && value != 0x0000) {
+        return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+    int32_t offset = table_offset(table->bits, table->base, table->count, address, 1);
+    if (offset < 0) {
+        return MB_EX_ILLEGAL_DATA_ADDRESS;
+    }
+
+    uint32_t mask = 1u << (offset % 32);
+    if (value != 0) {
+        table->bits[offset / 32] |= mask;
+    } else {
+        table->bits[offset / 32] &= ~mask;
+    }
+
+    memcpy(out, pdu, 4);
+    *out_length = 4;
+    notify(slave, MB_FC_WRITE_SINGLE_COIL, address, 1);
+    return 0;
+}
+
+static uint8_t write_register(mb_slave_t *slave,
+                              const uint8_t *pdu,
+                              uint16_t pdu_length,
+                              uint8_t *out,
+                              uint16_t *out_length) {
+    const mb_slave_regs_t *table = &slave->config.holding;
+    if (pdu_length != 4) {
+        return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+    uint16_t address = get_u16(pdu);
+    int32_t offset   = table_offset(table->regs, table->base, table->count, address, 1);
+    if (offset < 0) {
+        return MB_EX_ILLEGAL_DATA_ADDRESS;
+    }
+
+    table->regs[offset] = get_u16(&pdu[2]);
+
+    memcpy(out, pdu, 4);
+    *out_length = 4;
+    notify(slave, MB_FC_WRITE_SINGLE_REGISTER, address, 1);
+    return 0;
+}
+
+static uint8_t write_coils(mb_slave_t *slave,
+                           const uint8_t *pdu,
+                           uint16_t pdu_length,
+                           uint8_t *out,
+                           uint16_t *out_length) {
+    const mb_slave_bits_t *table = &slave->config.coils;
+    if (pdu_length < 5) {
+        return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+    uint16_t address  = get_u16(pdu);
+    uint16_t quantity = get_u16(&pdu[2]);
+    if (quantity == 0 || quantity > SLAVE_MAX_WRITE_BITS || pdu[4] != (quantity + 7) / 8 ||
+        pdu_length != 5 + pdu[4]) {
+        return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+    int32_t offset = table_offset(table->bits, table->base, table->count, address, quantity);
+    if (offset < 0) {
+        return MB_EX_ILLEGAL_DATA_ADDRESS;
+    }
+
+    mb_bits_copy(table->bits, (uint32_t)offset, &pdu[5], 0, quantity);
+
+    memcpy(out, pdu, 4);
+    *out_length = 4;
+    notify(slave, MB_FC_WRITE_MULTIPLE_COILS, address, quantity);
+    return 0;
+}
+
+static uint8_t write_registers(mb_slave_t *slave,
+                               const uint8_t *pdu,
+                               uint16_t pdu_length,
+                               uint8_t *out,
+                               uint16_t *out_length) {
+    const mb_slave_regs_t *table = &slave->config.holding;
+    if (pdu_length < 5) {
+        return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+    uint16_t address  = get_u16(pdu);
+    uint16_t quantity = get_u16(&pdu[2]);
+    if (quantity == 0 || quantity > SLAVE_MAX_WRITE_REGS || pdu[4] != quantity * 2 ||
+        pdu_length != 5 + pdu[4]) {
+        return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+    int32_t offset = table_offset(table->regs, table->base, table->count, address, quantity);
+    if (offset < 0) {
+        return MB_EX_ILLEGAL_DATA_ADDRESS;
+    }
+
+    mb_regs_decode(&table->regs[offset], &pdu[5], quantity);
+
+    memcpy(out, pdu, 4);
+    *out_length = 4;
+    notify(slave, MB_FC_WRITE_MULTIPLE_REGISTERS, address, quantity);
+    return 0;
+}
+
+static uint8_t read_write_registers(mb_slave_t *slave,
+                                    const uint8_t *pdu,
+                                    uint16_t pdu_length,
+                                    uint8_t *out,
+                                    uint16_t *out_length) {
+    const mb_slave_regs_t *table = &slave->config.holding;
+    if (pdu_length < 9) {
+        return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+    uint16_t read_address   = get_u16(pdu);
+    uint16_t read_quantity  = get_u16(&pdu[2]);
+    uint16_t write_address  = get_u16(&pdu[4]);
+    uint16_t write_quantity = get_u16(&pdu[6]);
+    if (read_quantity == 0 || read_quantity > SLAVE_MAX_READ_REGS || write_quantity == 0 ||
+        write_quantity > SLAVE_MAX_RW_REGS || pdu[8] != write_quantity * 2 ||
+        pdu_length != 9 + pdu[8]) {
+        return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+    int32_t read_offset =
+        table_offset(table->regs, table->base, table->count, read_address, read_quantity);
+    int32_t write_offset =
+        table_offset(table->regs, table->base, table->count, write_address, write_quantity);
+    if (read_offset < 0 || write_offset < 0) {
+        return MB_EX_ILLEGAL_DATA_ADDRESS;
+    }
+
+    // The write is performed before the read
+    mb_regs_decode(&table->regs[write_offset], &pdu[9], write_quantity);
+    out[0] = (uint8_t)(read_quantity * 2);
+    mb_regs_encode(&out[1], &table->regs[read_offset], read_quantity);
+    *out_length = (uint16_t)(1 + out[0]);
+    notify(slave, MB_FC_READ_WRITE_MULTIPLE_REGISTERS, write_address, write_quantity);
+    return 0;
+}
+
+/**
+ * @brief Execute a request
+ * @return 0, or the Modbus exception code to answer with
+ */
+static uint8_t execute(mb_slave_t *slave,
+                       uint8_t fc,
+                       const uint8_t *pdu,
+                       uint16_t pdu_length,
+                       uint8_t *out,
+                       uint16_t *out_length) {
+    switch (fc) {
+    case MB_FC_READ_COILS:
+        return read_bits(&slave->config.coils, pdu, pdu_length, out, out_length);
+    case MB_FC_READ_DISCRETE_INPUTS:
+        return read_bits(&slave->config.discrete_inputs, pdu, pdu_length, out, out_length);
+    case MB_FC_READ_HOLDING_REGISTERS:
+        return read_regs(&slave->config.holding, pdu, pdu_length, out, out_length);
+    case MB_FC_READ_INPUT_REGISTERS:
+        return read_regs(&slave->config.input, pdu, pdu_length, out, out_length);
+    case MB_FC_WRITE_SINGLE_COIL:
+        return write_coil(slave, pdu, pdu_length, out, out_length);
+    case MB_FC_WRITE_SINGLE_REGISTER:
+        return write_register(slave, pdu, pdu_length, out, out_length);
+    case MB_FC_WRITE_MULTIPLE_COILS:
+        return write_coils(slave, pdu, pdu_length, out, out_length);
+    case MB_FC_WRITE_MULTIPLE_REGISTERS:
+        return write_registers(slave, pdu, pdu_length, out, out_length);
+    case MB_FC_READ_WRITE_MULTIPLE_REGISTERS:
+        return read_write_registers(slave, pdu, pdu_length, out, out_length);
+    default:
+        return MB_EX_ILLEGAL_FUNCTION;
+    }
+}
+
+/**
+ * @brief Execute a request and turn a failure into an exception response
+ */
+static uint8_t respond(mb_slave_t *slave,
+                       uint8_t fc,
+                       const uint8_t *pdu,
+                       uint16_t pdu_length,
+                       uint8_t *out,
+                       uint16_t *out_length) {
+    slave->stats.requests++;
+
+    uint8_t exception = execute(slave, fc, pdu, pdu_length, out, out_length);
+    if (exception == 0) {
+        return fc;
+    }
+
+    slave->stats.exceptions++;
+    out[0]      = exception;
+    *out_length = 1;
+    return (uint8_t)(fc | 0x80);
+}
+
+static bool valid_table(const void *data, uint16_t base, uint16_t count) {
+    return data == NULL || (uint32_t)base + count <= 0x10000u;
+}
+
+int mb_slave_init(mb_slave_t *slave, const mb_slave_config_t *config) {
+    if (slave == NULL || config == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (!valid_table(config->coils.bits, config->coils.base, config->coils.count) ||
+        !valid_table(config->discrete_inputs.bits, config->discrete_inputs.base,
+                     config->discrete_inputs.count) ||
+        !valid_table(config->holding.regs, config->holding.base, config->holding.count) ||
+        !valid_table(config->input.regs, config->input.base, config->input.count)) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    memset(slave, 0, sizeof(*slave));
+    slave->config = *config;
+    return MB_SUCCESS;
+}
+
+int mb_slave_process_pdu(mb_slave_t *slave,
+                         uint8_t fc,
+                         const uint8_t *pdu,
+                         uint16_t pdu_length,
+                         uint8_t *response_fc,
+                         uint8_t *response,
+                         uint16_t *response_length) {
+    if (slave == NULL || (pdu == NULL && pdu_length > 0) || response_fc == NULL ||
+        response == NULL || response_length == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    *response_fc = respond(slave, fc, pdu, pdu_length, response, response_length);
+    return MB_SUCCESS;
+}
+
+int mb_slave_process_frame(mb_slave_t *slave,
+                           mb_mode_t mode,
+                           uint8_t *request,
+                           uint16_t request_length,
+                           uint8_t *response,
+                           uint16_t buffer_size,
+                           uint16_t *response_length) {
+    if (slave == NULL || request == NULL || response == NULL || response_length == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    *response_length = 0;
+    if (buffer_size < mb_calc_frame_length(SLAVE_MAX_PDU, mode)) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    uint16_t transaction_id = 0;
+    uint8_t unit            = 0;
+    uint8_t fc              = 0;
+    const uint8_t *pdu      = NULL;
+    uint16_t pdu_length     = 0;
+    int result = mb_parse_frame_view(request, request_length, mode, &transaction_id, &unit, &fc,
+                                     &pdu, &pdu_length);
+    if (result != MB_SUCCESS) {
+        slave->stats.ignored++;
+        return result;
+    }
+
+    // Serial unit 0 is a broadcast; on TCP it is just another unit ID
+    bool tcp       = MB_ACTIVE_MODE(mode) == MB_MODE_TCP;
+    bool broadcast = !tcp && unit == 0;
+    if (!broadcast && slave->config.unit_id != 0 && unit != slave->config.unit_id &&
+        !(tcp && unit == 0xFF)) {
+        slave->stats.ignored++;
+        return MB_SUCCESS;
+    }
+
+    // The response PDU goes straight into its place in the output frame
+    uint16_t out_length = 0;
+    uint8_t response_fc =
+        respond(slave, fc, pdu, pdu_length, &response[mb_frame_pdu_offset(mode)], &out_length);
+    if (broadcast) {
+        slave->stats.ignored++;
+        return MB_SUCCESS;
+    }
+
+    return mb_encode_frame_inplace(unit, response_fc, out_length, mode, transaction_id, response,
+                                   buffer_size, response_length);
+}
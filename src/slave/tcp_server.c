@@ -0,0 +1,324 @@
+/**
+ * @file tcp_server.c
+ * @brief epoll-driven Modbus TCP front end for a slave
+ *
+ * All sockets are non-blocking and level-triggered. Each readable event
+ * costs one recv() into the connection's buffer; every complete request in
+ * it is answered into the transmit buffer, and the whole burst leaves in
+ * one send(). A client that pipelines requests is therefore served at a
+ * few system calls per burst, not per request. When a client stops
+ * reading its responses, the connection waits for EPOLLOUT and takes no
+ * new requests until its transmit buffer has drained.
+ */
+
+// accept4()
+#define _GNU_SOURCE
+
+#include "smartmodbus/mb_slave.h"
+#include "smartmodbus/mb_error.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * @brief epoll events handled per mb_slave_server_poll()
+ */
+#define SERVER_EVENTS 64
+
+/**
+ * @brief MBAP header: transaction ID, protocol ID, length, unit ID
+ */
+#define MBAP_HEADER_CHARS 7
+
+/**
+ * @brief Largest Modbus TCP response frame
+ */
+#define MAX_RESPONSE_CHARS 260
+
+static void close_connection(mb_slave_server_t *server, mb_slave_connection_t *connection) {
+    (void)epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+    (void)close(connection->fd);
+    connection->fd = -1;
+    server->open--;
+}
+
+static bool watch(mb_slave_server_t *server, mb_slave_connection_t *connection, bool writing) {
+    if (connection->writing == writing) {
+        return true;
+    }
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events   = writing ? EPOLLOUT : EPOLLIN;
+    event.data.ptr = connection;
+    connection->writing = writing;
+    return epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, connection->fd, &event) == 0;
+}
+
+/**
+ * @brief Send as much of tx as the socket takes
+ * @return false if the connection failed
+ */
+static bool flush(mb_slave_connection_t *connection) {
+    while (connection->tx_offset < connection->tx_length) {
+        ssize_t sent = send(connection->fd, &connection->tx[connection->tx_offset],
+                            (size_t)(connection->tx_length - connection->tx_offset), MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection->tx_offset = (uint16_t)(connection->tx_offset + sent);
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && errno == EAGAIN) {
+            return true;
+        } else {
+            return false;
+        }
+    }
+
+    connection->tx_offset = 0;
+    connection->tx_length = 0;
+    return true;
+}
+
+/**
+ * @brief Answer the complete requests in rx while tx has room for a response
+ * @return Number of responses queued, or -1 if the stream is not Modbus TCP
+ */
+static int process(mb_slave_server_t *server, mb_slave_connection_t *connection) {
+    uint16_t pos = 0;
+    int queued   = 0;
+
+    while (connection->rx_length - pos >= MBAP_HEADER_CHARS) {
+        const uint8_t *header = &connection->rx[pos];
+        uint16_t protocol     = (uint16_t)((header[2] << 8) | header[3]);
+        uint16_t length       = (uint16_t)((header[4] << 8) | header[5]);
+        if (protocol != 0 || length < 2 || length > MAX_RESPONSE_CHARS - 6) {
+            return -1;
+        }
+
+        uint16_t frame_chars = (uint16_t)(6 + length);
+        if (connection->rx_length - pos < frame_chars ||
+            sizeof(connection->tx) - connection->tx_length < MAX_RESPONSE_CHARS) {
+            break;
+        }
+
+        uint16_t response_length = 0;
+        int result = mb_slave_process_frame(server->slave, MB_MODE_TCP, &connection->rx[pos],
+                                            frame_chars, &connection->tx[connection->tx_length],
+                                            (uint16_t)(sizeof(connection->tx) -
+                                                       connection->tx_length),
+                                            &response_length);
+        if (result == MB_SUCCESS && response_length > 0) {
+            connection->tx_length = (uint16_t)(connection->tx_length + response_length);
+            queued++;
+        }
+        pos = (uint16_t)(pos + frame_chars);
+    }
+
+    connection->rx_length = (uint16_t)(connection->rx_length - pos);
+    memmove(connection->rx, &connection->rx[pos], connection->rx_length);
+    return queued;
+}
+
+/**
+ * @brief Answer and send until rx holds no complete request or the socket is full
+ * @return Number of responses queued, or -1 to close the connection
+ */
+static int drain(mb_slave_server_t *server, mb_slave_connection_t *connection) {
+    int served = 0;
+    int queued;
+
+    do {
+        queued = process(server, connection);
+        if (queued < 0 || !flush(connection)) {
+            return -1;
+        }
+        served += queued;
+    } while (queued > 0 && connection->tx_length == 0);
+
+    return watch(server, connection, connection->tx_length > 0) ? served : -1;
+}
+
+static int service(mb_slave_server_t *server, mb_slave_connection_t *connection, uint32_t events) {
+    if (connection->writing) {
+        if ((events & (EPOLLERR | EPOLLHUP)) != 0 || !flush(connection)) {
+            return -1;
+        }
+        return connection->tx_length > 0 ? 0 : drain(server, connection);
+    }
+
+    ssize_t received = recv(connection->fd, &connection->rx[connection->rx_length],
+                            sizeof(connection->rx) - connection->rx_length, 0);
+    if (received == 0) {
+        return -1;
+    }
+    if (received < 0) {
+        return errno == EAGAIN || errno == EINTR ? 0 : -1;
+    }
+
+    connection->rx_length = (uint16_t)(connection->rx_length + received);
+    return drain(server, connection);
+}
+
+static void accept_connections(mb_slave_server_t *server) {
+    for (;;) {
+        int fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+
+        mb_slave_connection_t *connection = NULL;
+        for (uint16_t i = 0; i < server->capacity && connection == NULL; i++) {
+            if (server->connections[i].fd < 0) {
+                connection = &server->connections[i];
+            }
+        }
+        if (connection == NULL) {
+            (void)close(fd);
+            server->rejected++;
+            continue;
+        }
+
+        // Responses are small and latency-bound: never wait for a full segment
+        int one = 1;
+        (void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events   = EPOLLIN;
+        event.data.ptr = connection;
+        if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            (void)close(fd);
+            server->rejected++;
+            continue;
+        }
+
+        connection->fd        = fd;
+        connection->rx_length = 0;
+        connection->tx_offset = 0;
+        connection->tx_length = 0;
+        connection->writing   = false;
+        server->open++;
+        server->accepted++;
+    }
+}
+
+int mb_slave_server_open(mb_slave_server_t *server,
+                         mb_slave_t *slave,
+                         const char *bind_address,
+                         uint16_t port,
+                         mb_slave_connection_t *connections,
+                         uint16_t capacity) {
+    if (server == NULL || slave == NULL || connections == NULL || capacity == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind_address != NULL && inet_pton(AF_INET, bind_address, &address.sin_addr) != 1) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    memset(server, 0, sizeof(*server));
+    server->slave       = slave;
+    server->connections = connections;
+    server->capacity    = capacity;
+    server->epoll_fd    = -1;
+    for (uint16_t i = 0; i < capacity; i++) {
+        connections[i].fd = -1;
+    }
+
+    server->listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (server->listen_fd < 0) {
+        return MB_ERROR_TRANSPORT;
+    }
+
+    int one = 1;
+    (void)setsockopt(server->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    socklen_t length = sizeof(address);
+    if (bind(server->listen_fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(server->listen_fd, SOMAXCONN) != 0 ||
+        getsockname(server->listen_fd, (struct sockaddr *)&address, &length) != 0) {
+        mb_slave_server_close(server);
+        return MB_ERROR_TRANSPORT;
+    }
+    server->port = ntohs(address.sin_port);
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events   = EPOLLIN;
+    event.data.ptr = NULL;
+    server->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (server->epoll_fd < 0 ||
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->listen_fd, &event) != 0) {
+        mb_slave_server_close(server);
+        return MB_ERROR_TRANSPORT;
+    }
+
+    return MB_SUCCESS;
+}
+
+int mb_slave_server_poll(mb_slave_server_t *server, int timeout_ms) {
+    if (server == NULL || server->epoll_fd < 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    struct epoll_event events[SERVER_EVENTS];
+    int ready = epoll_wait(server->epoll_fd, events, SERVER_EVENTS, timeout_ms);
+    if (ready < 0) {
+        return errno == EINTR ? 0 : MB_ERROR_TRANSPORT;
+    }
+
+    int served = 0;
+    for (int i = 0; i < ready; i++) {
+        mb_slave_connection_t *connection = events[i].data.ptr;
+        if (connection == NULL) {
+            accept_connections(server);
+            continue;
+        }
+
+        // A connection closed earlier in this batch may still have an event
+        if (connection->fd < 0) {
+            continue;
+        }
+
+        int result = service(server, connection, events[i].events);
+        if (result < 0) {
+            close_connection(server, connection);
+        } else {
+            served += result;
+        }
+    }
+
+    return served;
+}
+
+void mb_slave_server_close(mb_slave_server_t *server) {
+    if (server == NULL) {
+        return;
+    }
+
+    for (uint16_t i = 0; i < server->capacity; i++) {
+        if (server->connections[i].fd >= 0) {
+            close_connection(server, &server->connections[i]);
+        }
+    }
+
+    if (server->epoll_fd >= 0) {
+        (void)close(server->epoll_fd);
+        server->epoll_fd = -1;
+    }
+    if (server->listen_fd >= 0) {
+        (void)close(server->listen_fd);
+        server->listen_fd = -1;
+    }
+}
@@ -0,0 +1,511 @@
+/**
+ * @file serial_ports.c
+ * @brief epoll-driven multi-port serial engine for Linux
+ *
+ * Every port is registered once, level-triggered, and its interest is
+ * changed only when it differs from what the port's operation needs:
+ * EPOLLIN while a response is outstanding, EPOLLOUT while a frame is
+ * stuck behind a full tty buffer. A frame held back by the line silence
+ * is not registered at all; the silence bounds the epoll_wait() instead,
+ * like the response deadlines. A pass therefore only steps the ports that
+ * had an event or whose timer ran out.
+ */
+
+// cfmakeraw()
+#define _GNU_SOURCE
+
+#include "smartmodbus/mb_ports.h"
+#include "smartmodbus/mb_error.h"
+#include "smartmodbus/smartmodbus.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief epoll events handled per mb_ports_run()
+ */
+#define PORT_EVENTS 64
+
+/**
+ * @brief RTU inter-frame silence above 19200 baud (fixed by the spec)
+ */
+#define RTU_FAST_GAP_US 1750u
+
+static uint64_t clock_now_us(void) {
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000u + (uint64_t)now.tv_nsec / 1000u;
+}
+
+static bool line_quiet(const mb_serial_line_t *line, uint32_t now_us) {
+    return (int32_t)(now_us - line->quiet_us) >= 0;
+}
+
+/**
+ * @brief Keep the line silent until at least until_us
+ */
+static void line_hold(mb_serial_line_t *line, uint32_t until_us) {
+    if ((int32_t)(until_us - line->quiet_us) > 0) {
+        line->quiet_us = until_us;
+    }
+}
+
+static int line_send(void *ctx, const uint8_t *data, size_t len) {
+    mb_serial_line_t *line = (mb_serial_line_t *)ctx;
+    uint32_t now_us        = (uint32_t)clock_now_us();
+
+    // A new frame waits for the silence; the rest of a started one must not
+    if (line->tx_rest == 0 && !line_quiet(line, now_us)) {
+        return 0;
+    }
+
+    line->writes++;
+    ssize_t written = write(line->fd, data, len);
+    if (written < 0) {
+        return errno == EAGAIN || errno == EINTR ? 0 : MB_ERROR_TRANSPORT;
+    }
+
+    // The bytes occupy the line while they shift out, then the silence follows
+    line->tx_rest = (uint16_t)(len - (size_t)written);
+    line_hold(line, now_us + (uint32_t)written * line->char_us + line->gap_us);
+    return (int)written;
+}
+
+static int line_recv(void *ctx, uint8_t *buffer, size_t max_len, size_t *received) {
+    mb_serial_line_t *line = (mb_serial_line_t *)ctx;
+
+    *received = 0;
+    line->reads++;
+    ssize_t got = read(line->fd, buffer, max_len);
+    if (got > 0) {
+        *received = (size_t)got;
+        line_hold(line, (uint32_t)clock_now_us() + line->gap_us);
+        return MB_SUCCESS;
+    }
+    if (got < 0 && (errno == EAGAIN || errno == EINTR)) {
+        return MB_SUCCESS;
+    }
+    // 0 = hang-up
+    return MB_ERROR_TRANSPORT;
+}
+
+static void line_delay_chars(void *ctx, uint16_t chars) {
+    mb_serial_line_t *line = (mb_serial_line_t *)ctx;
+    line_hold(line, (uint32_t)clock_now_us() + (uint32_t)chars * line->char_us);
+}
+
+static uint32_t line_clock_us(void *ctx) {
+    (void)ctx;
+    return (uint32_t)clock_now_us();
+}
+
+/**
+ * @brief Character format, with the defaults of the time cost model
+ */
+static uint32_t link_data_bits(mb_mode_t mode, const mb_link_t *link) {
+    return link->data_bits != 0 ? link->data_bits : (mode == MB_MODE_ASCII ? 7u : 8u);
+}
+
+static uint32_t link_stop_bits(const mb_link_t *link) {
+    return link->stop_bits != 0 ? link->stop_bits : (link->parity != MB_PARITY_NONE ? 1u : 2u);
+}
+
+static uint32_t link_char_bits(mb_mode_t mode, const mb_link_t *link) {
+    uint32_t parity_bits = link->parity != MB_PARITY_NONE ? 1u : 0u;
+    return 1 + link_data_bits(mode, link) + parity_bits + link_stop_bits(link);
+}
+
+static speed_t baud_speed(uint32_t bit_rate) {
+    switch (bit_rate) {
+    case 1200:
+        return B1200;
+    case 2400:
+        return B2400;
+    case 4800:
+        return B4800;
+    case 9600:
+        return B9600;
+    case 19200:
+        return B19200;
+    case 38400:
+        return B38400;
+    case 57600:
+        return B57600;
+    case 115200:
+        return B115200;
+    case 230400:
+        return B230400;
+    case 460800:
+        return B460800;
+    case 921600:
+        return B921600;
+    default:
+        return B0;
+    }
+}
+
+int mb_serial_open(const char *path, const mb_link_t *link, mb_mode_t mode, int *fd) {
+    if (path == NULL || link == NULL || fd == NULL ||
+        (mode != MB_MODE_RTU && mode != MB_MODE_ASCII)) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    speed_t speed = baud_speed(link->bit_rate);
+    if (speed == B0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    int tty = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (tty < 0) {
+        return MB_ERROR_TRANSPORT;
+    }
+
+    struct termios tio;
+    if (tcgetattr(tty, &tio) != 0) {
+        (void)close(tty);
+        return MB_ERROR_TRANSPORT;
+    }
+
+    cfmakeraw(&tio);
+    tio.c_cflag &= (tcflag_t) ~(CSIZE | PARENB | PARODD | CSTOPB);
+    tio.c_cflag |= CLOCAL | CREAD | (link_data_bits(mode, link) == 7 ? CS7 : CS8);
+    if (link->parity != MB_PARITY_NONE) {
+        tio.c_cflag |= PARENB | (link->parity == MB_PARITY_ODD ? PARODD : 0);
+    }
+    if (link_stop_bits(link) == 2) {
+        tio.c_cflag |= CSTOPB;
+    }
+    // Non-blocking reads return what has arrived, EAGAIN when nothing has
+    tio.c_cc[VMIN]  = 1;
+    tio.c_cc[VTIME] = 0;
+
+    if (cfsetispeed(&tio, speed) != 0 || cfsetospeed(&tio, speed) != 0 ||
+        tcsetattr(tty, TCSANOW, &tio) != 0) {
+        (void)close(tty);
+        return MB_ERROR_TRANSPORT;
+    }
+    (void)tcflush(tty, TCIOFLUSH);
+
+    *fd = tty;
+    return MB_SUCCESS;
+}
+
+int mb_ports_init(mb_ports_t *engine, mb_port_t *ports, uint16_t capacity) {
+    if (engine == NULL || (ports == NULL && capacity > 0)) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    memset(engine, 0, sizeof(*engine));
+    engine->ports    = ports;
+    engine->capacity = capacity;
+    engine->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    return engine->epoll_fd >= 0 ? MB_SUCCESS : MB_ERROR_TRANSPORT;
+}
+
+int mb_ports_add(mb_ports_t *engine,
+                 mb_master_t *master,
+                 int fd,
+                 const mb_link_t *link,
+                 mb_port_poll_t *polls,
+                 uint16_t poll_capacity) {
+    if (engine == NULL || engine->epoll_fd < 0 || master == NULL || fd < 0 || link == NULL ||
+        link->bit_rate == 0 || (polls == NULL && poll_capacity > 0)) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    mb_mode_t mode = master->config.mode;
+    if (mode != MB_MODE_RTU && mode != MB_MODE_ASCII) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (engine->count >= engine->capacity) {
+        return MB_ERROR_TOO_MANY_BLOCKS;
+    }
+
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+        return MB_ERROR_TRANSPORT;
+    }
+
+    mb_port_t *port = &engine->ports[engine->count];
+    memset(port, 0, sizeof(*port));
+    port->master        = master;
+    port->polls         = polls;
+    port->poll_capacity = poll_capacity;
+
+    uint64_t bits       = link_char_bits(mode, link);
+    port->line.fd       = fd;
+    port->line.char_us  = (uint32_t)((bits * 1000000u + link->bit_rate - 1u) / link->bit_rate);
+    port->line.quiet_us = (uint32_t)clock_now_us();
+    if (mode == MB_MODE_RTU) {
+        port->line.gap_us = link->bit_rate > 19200 ? RTU_FAST_GAP_US
+                                                   : (port->line.char_us * 7 + 1) / 2;
+    }
+
+    // Level-triggered, no interest until an operation needs some
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.data.ptr = port;
+    if (epoll_ctl(engine->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        return MB_ERROR_TRANSPORT;
+    }
+
+    mb_transport_t *transport = &master->config.transport;
+    memset(transport, 0, sizeof(*transport));
+    transport->send        = line_send;
+    transport->recv        = line_recv;
+    transport->delay_chars = line_delay_chars;
+    transport->clock_us    = line_clock_us;
+    transport->context     = &port->line;
+    return engine->count++;
+}
+
+int mb_ports_add_poll(mb_ports_t *engine,
+                      uint16_t port,
+                      mb_poll_plan_t *poll,
+                      uint16_t *data_buffer,
+                      uint16_t buffer_size,
+                      mb_async_done_fn on_done,
+                      void *ctx) {
+    if (engine == NULL || port >= engine->count || poll == NULL || data_buffer == NULL ||
+        poll->plan_count == 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    mb_port_t *target = &engine->ports[port];
+    if (poll->mode != target->master->config.mode) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+    if (buffer_size < poll->address_count) {
+        return MB_ERROR_BUFFER_TOO_SMALL;
+    }
+    if (target->poll_count >= target->poll_capacity) {
+        return MB_ERROR_TOO_MANY_BLOCKS;
+    }
+
+    mb_port_poll_t *entry = &target->polls[target->poll_count];
+    memset(entry, 0, sizeof(*entry));
+    entry->poll        = poll;
+    entry->data_buffer = data_buffer;
+    entry->on_done     = on_done;
+    entry->ctx         = ctx;
+    return target->poll_count++;
+}
+
+/**
+ * @brief Record the end of the running poll and move to the next one
+ */
+static void complete(mb_ports_t *engine, mb_port_t *port, int result) {
+    mb_port_poll_t *entry = &port->polls[port->next_poll];
+    entry->result         = result;
+    if (result == MB_SUCCESS) {
+        entry->reads++;
+    } else {
+        entry->errors++;
+    }
+
+    if (++port->next_poll == port->poll_count) {
+        port->next_poll = 0;
+        port->cycles++;
+    }
+
+    if (result == MB_ERROR_TRANSPORT) {
+        port->failed = true;
+        port->events = 0;
+        (void)epoll_ctl(engine->epoll_fd, EPOLL_CTL_DEL, port->line.fd, NULL);
+    }
+
+    if (entry->on_done != NULL) {
+        entry->on_done(entry->ctx, result);
+    }
+}
+
+/**
+ * @brief Advance a port, starting polls until one has to wait
+ * @return Poll executions completed
+ *
+ * At most one pass over the scan list, so a line that fails every poll at
+ * once cannot hold the thread.
+ */
+static int service(mb_ports_t *engine, mb_port_t *port, uint32_t now_ms) {
+    int completed    = 0;
+    uint16_t started = 0;
+
+    while (!port->failed) {
+        if (port->op.state != MB_ASYNC_BUSY) {
+            if (started == port->poll_count) {
+                break;
+            }
+            mb_port_poll_t *entry = &port->polls[port->next_poll];
+            int result = mb_master_submit_poll(port->master, &port->op, entry->poll,
+                                               entry->data_buffer, entry->poll->address_count,
+                                               NULL, NULL);
+            started++;
+            if (result != MB_SUCCESS) {
+                complete(engine, port, result);
+                completed++;
+                continue;
+            }
+        }
+
+        (void)mb_async_step(&port->op, now_ms);
+        if (port->op.state != MB_ASYNC_DONE) {
+            break;
+        }
+        complete(engine, port, port->op.result);
+        completed++;
+    }
+
+    return completed;
+}
+
+/**
+ * @brief Whether a port can move without an event
+ */
+static bool timer_due(const mb_port_t *port, uint32_t now_ms, uint32_t now_us) {
+    if (port->failed) {
+        return false;
+    }
+    if (port->op.state != MB_ASYNC_BUSY) {
+        return port->poll_count > 0;
+    }
+
+    uint32_t deadline_ms = 0;
+    if (mb_async_next_deadline(&port->op, &deadline_ms) && (int32_t)(now_ms - deadline_ms) >= 0) {
+        return true;
+    }
+    return (mb_async_interest(&port->op) & MB_ASYNC_WANT_WRITE) != 0 && port->line.tx_rest == 0 &&
+           line_quiet(&port->line, now_us);
+}
+
+/**
+ * @brief Register what the port waits for; return how long it may wait
+ */
+static int watch(mb_ports_t *engine, mb_port_t *port, uint32_t now_ms, uint32_t now_us) {
+    unsigned interest = mb_async_interest(&port->op);
+    bool held         = (interest & MB_ASYNC_WANT_WRITE) != 0 && port->line.tx_rest == 0 &&
+                !line_quiet(&port->line, now_us);
+
+    uint32_t events = 0;
+    if ((interest & MB_ASYNC_WANT_READ) != 0) {
+        events |= EPOLLIN;
+    }
+    if ((interest & MB_ASYNC_WANT_WRITE) != 0 && !held) {
+        events |= EPOLLOUT;
+    }
+    if (events != port->events) {
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events   = events;
+        event.data.ptr = port;
+        if (epoll_ctl(engine->epoll_fd, EPOLL_CTL_MOD, port->line.fd, &event) == 0) {
+            port->events = events;
+        }
+    }
+
+    int wait = -1;
+    if (held) {
+        wait = (int)((port->line.quiet_us - now_us + 999u) / 1000u);
+    }
+    uint32_t deadline_ms = 0;
+    if (mb_async_next_deadline(&port->op, &deadline_ms)) {
+        int until = (int32_t)(deadline_ms - now_ms) > 0 ? (int)(deadline_ms - now_ms) : 0;
+        if (wait < 0 || until < wait) {
+            wait = until;
+        }
+    }
+    return wait;
+}
+
+int mb_ports_run(mb_ports_t *engine, int timeout_ms) {
+    if (engine == NULL || engine->epoll_fd < 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    uint64_t now  = clock_now_us();
+    int completed = 0;
+    int wait      = timeout_ms;
+    for (uint16_t i = 0; i < engine->count; i++) {
+        mb_port_t *port = &engine->ports[i];
+        if (timer_due(port, (uint32_t)(now / 1000u), (uint32_t)now)) {
+            completed += service(engine, port, (uint32_t)(now / 1000u));
+        }
+        if (!port->failed) {
+            int until = watch(engine, port, (uint32_t)(now / 1000u), (uint32_t)now);
+            if (until >= 0 && (wait < 0 || until < wait)) {
+                wait = until;
+            }
+        }
+    }
+
+    // Report finished polls promptly; only collect events that are already there
+    if (completed > 0) {
+        wait = 0;
+    }
+
+    struct epoll_event events[PORT_EVENTS];
+    int ready = epoll_wait(engine->epoll_fd, events, PORT_EVENTS, wait);
+    engine->waits++;
+    if (ready < 0) {
+        return errno == EINTR ? completed : MB_ERROR_TRANSPORT;
+    }
+
+    now = clock_now_us();
+    for (int i = 0; i < ready; i++) {
+        mb_port_t *port = events[i].data.ptr;
+        if (port->failed) {
+            continue;
+        }
+
+        // Hang-up with nothing outstanding would otherwise never be read
+        if ((events[i].events & (EPOLLERR | EPOLLHUP)) != 0 &&
+            (events[i].events & EPOLLIN) == 0) {
+            if (port->op.state == MB_ASYNC_BUSY) {
+                mb_async_cancel(&port->op);
+                complete(engine, port, MB_ERROR_TRANSPORT);
+                completed++;
+            } else {
+                port->failed = true;
+                port->events = 0;
+                (void)epoll_ctl(engine->epoll_fd, EPOLL_CTL_DEL, port->line.fd, NULL);
+            }
+            continue;
+        }
+        completed += service(engine, port, (uint32_t)(now / 1000u));
+    }
+
+    for (uint16_t i = 0; i < engine->count; i++) {
+        mb_port_t *port = &engine->ports[i];
+        if (timer_due(port, (uint32_t)(now / 1000u), (uint32_t)now)) {
+            completed += service(engine, port, (uint32_t)(now / 1000u));
+        }
+    }
+
+    return completed;
+}
+
+void mb_ports_close(mb_ports_t *engine) {
+    if (engine == NULL) {
+        return;
+    }
+
+    for (uint16_t i = 0; i < engine->count; i++) {
+        mb_port_t *port = &engine->ports[i];
+        mb_async_cancel(&port->op);
+        if (port->line.fd >= 0) {
+            (void)close(port->line.fd);
+            port->line.fd = -1;
+        }
+    }
+    engine->count = 0;
+
+    if (engine->epoll_fd >= 0) {
+        (void)close(engine->epoll_fd);
+        engine->epoll_fd = -1;
+    }
+}
@@ -0,0 +1,509 @@
+/**
+ * @file tcp_client.c
+ * @brief Reference Modbus TCP client transport for Linux
+ *
+ * Without a ring, send() is one send() and send_frames() is one sendmsg()
+ * over an iovec of the frames (writev() semantics, but with MSG_NOSIGNAL
+ * so a closed peer is an error and not SIGPIPE). Short writes advance the
+ * iovec and write the rest.
+ *
+ * With a ring, both only copy into the client's transmit queue and
+ * mb_tcp_uring_submit() turns every non-empty queue into one
+ * IORING_OP_SEND entry. The ring is driven through the raw system calls
+ * so the library does not depend on liburing.
+ */
+
+// syscall(), MAP_POPULATE, clock_gettime()
+#define _GNU_SOURCE
+
+#include "smartmodbus/mb_tcp_client.h"
+#include "smartmodbus/mb_error.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef MB_ENABLE_TCP_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+/**
+ * @brief Frames per sendmsg() call (a full default window)
+ */
+#define CLIENT_IOVECS 16
+
+#ifdef MB_ENABLE_TCP_URING
+
+#define RING_HEAD  0
+#define RING_TAIL  1
+#define RING_MASK  2
+#define RING_ARRAY 3 /**< sq: index array, cq: completion entries */
+
+static uint32_t *ring_word(void *map, uint32_t offset) {
+    return (uint32_t *)((uint8_t *)map + offset);
+}
+
+static int uring_enter(int fd, uint32_t submit, uint32_t wait) {
+    return (int)syscall(__NR_io_uring_enter, fd, submit, wait, IORING_ENTER_GETEVENTS, NULL, 0);
+}
+
+/**
+ * @brief Copy frames into the client's queue; submit first if they do not fit
+ */
+static int queue_frame(mb_tcp_client_t *client, const uint8_t *data, size_t len) {
+    mb_tcp_uring_t *ring = client->ring;
+
+    if (client->tx_length + len > sizeof(client->tx)) {
+        int flushed = mb_tcp_uring_submit(ring);
+        if (flushed != MB_SUCCESS) {
+            return flushed;
+        }
+        if (len > sizeof(client->tx)) {
+            return MB_ERROR_BUFFER_TOO_SMALL;
+        }
+    }
+
+    memcpy(&client->tx[client->tx_length], data, len);
+    client->tx_length = (uint16_t)(client->tx_length + len);
+    if (!client->queued) {
+        ring->queue[ring->queued++] = client;
+        client->queued              = true;
+    }
+    return MB_SUCCESS;
+}
+
+/**
+ * @brief Take a client out of its ring's submit list
+ */
+static void unqueue(mb_tcp_client_t *client) {
+    mb_tcp_uring_t *ring = client->ring;
+    for (uint16_t i = 0; client->queued && i < ring->queued; i++) {
+        if (ring->queue[i] == client) {
+            ring->queue[i] = ring->queue[--ring->queued];
+            client->queued = false;
+        }
+    }
+    client->tx_offset = 0;
+    client->tx_length = 0;
+}
+
+#endif  // MB_ENABLE_TCP_URING
+
+static int client_send(void *ctx, const uint8_t *data, size_t len) {
+    mb_tcp_client_t *client = (mb_tcp_client_t *)ctx;
+
+#ifdef MB_ENABLE_TCP_URING
+    if (client->ring != NULL) {
+        int queued = queue_frame(client, data, len);
+        return queued == MB_SUCCESS ? (int)len : queued;
+    }
+#endif
+
+    // Non-blocking clients report what the socket took (mb_async_step() contract)
+    int flags   = MSG_NOSIGNAL | (client->timeout_ms == 0 ? MSG_DONTWAIT : 0);
+    size_t done = 0;
+    while (done < len) {
+        ssize_t sent = send(client->fd, &data[done], len - done, flags);
+        client->send_calls++;
+        if (sent > 0) {
+            done += (size_t)sent;
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && errno == EAGAIN && client->timeout_ms == 0) {
+            break;
+        } else {
+            return MB_ERROR_TRANSPORT;
+        }
+    }
+    return (int)done;
+}
+
+static int client_send_frames(void *ctx, const mb_frame_vec_t *frames, size_t count) {
+    mb_tcp_client_t *client = (mb_tcp_client_t *)ctx;
+
+#ifdef MB_ENABLE_TCP_URING
+    if (client->ring != NULL) {
+        for (size_t i = 0; i < count; i++) {
+            int queued = queue_frame(client, frames[i].data, frames[i].len);
+            if (queued != MB_SUCCESS) {
+                return queued;
+            }
+        }
+        return MB_SUCCESS;
+    }
+#endif
+
+    struct iovec iov[CLIENT_IOVECS];
+    size_t next = 0;
+    while (next < count) {
+        size_t pending = 0;
+        while (pending < CLIENT_IOVECS && next < count) {
+            iov[pending].iov_base = (void *)frames[next].data;
+            iov[pending].iov_len  = frames[next].len;
+            pending++;
+            next++;
+        }
+
+        struct msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov    = iov;
+        message.msg_iovlen = pending;
+        while (message.msg_iovlen > 0) {
+            ssize_t sent = sendmsg(client->fd, &message, MSG_NOSIGNAL);
+            client->send_calls++;
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sent <= 0) {
+                return MB_ERROR_TRANSPORT;
+            }
+
+            // Short write: drop the frames that left, trim the one cut in half
+            size_t left = (size_t)sent;
+            while (message.msg_iovlen > 0 && left >= message.msg_iov->iov_len) {
+                left -= message.msg_iov->iov_len;
+                message.msg_iov++;
+                message.msg_iovlen--;
+            }
+            if (message.msg_iovlen > 0) {
+                message.msg_iov->iov_base = (uint8_t *)message.msg_iov->iov_base + left;
+                message.msg_iov->iov_len -= left;
+            }
+        }
+    }
+    return MB_SUCCESS;
+}
+
+static int client_recv(void *ctx, uint8_t *buffer, size_t max_len, size_t *received) {
+    mb_tcp_client_t *client = (mb_tcp_client_t *)ctx;
+    *received               = 0;
+
+#ifdef MB_ENABLE_TCP_URING
+    // A blocking wait must not be for a request still sitting in the queue
+    if (client->ring != NULL && client->tx_length > 0 && client->timeout_ms > 0) {
+        int flushed = mb_tcp_uring_submit(client->ring);
+        if (flushed != MB_SUCCESS) {
+            return flushed;
+        }
+    }
+#endif
+
+    if (client->timeout_ms > 0) {
+        struct pollfd readable = {.fd = client->fd, .events = POLLIN, .revents = 0};
+        int ready;
+        do {
+            ready = poll(&readable, 1, (int)client->timeout_ms);
+            client->recv_calls++;
+        } while (ready < 0 && errno == EINTR);
+        if (ready < 0) {
+            return MB_ERROR_TRANSPORT;
+        }
+        if (ready == 0) {
+            return MB_SUCCESS;
+        }
+    }
+
+    ssize_t got;
+    do {
+        got = recv(client->fd, buffer, max_len, MSG_DONTWAIT);
+        client->recv_calls++;
+    } while (got < 0 && errno == EINTR);
+
+    if (got > 0) {
+        *received = (size_t)got;
+        return MB_SUCCESS;
+    }
+    if (got < 0 && errno == EAGAIN) {
+        return MB_SUCCESS;
+    }
+    // 0 = the server closed the connection
+    return MB_ERROR_TRANSPORT;
+}
+
+static void client_set_timeout(void *ctx, uint32_t timeout_ms) {
+    ((mb_tcp_client_t *)ctx)->timeout_ms = timeout_ms;
+}
+
+static uint32_t client_clock_us(void *ctx) {
+    (void)ctx;
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000u + (uint64_t)now.tv_nsec / 1000u);
+}
+
+int mb_tcp_client_open(mb_tcp_client_t *client,
+                       const char *host,
+                       uint16_t port,
+                       uint32_t timeout_ms) {
+    if (client == NULL || host == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port   = htons(port);
+    if (inet_pton(AF_INET, host, &address.sin_addr) != 1) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return MB_ERROR_TRANSPORT;
+    }
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        (void)close(fd);
+        return MB_ERROR_TRANSPORT;
+    }
+
+    mb_tcp_client_adopt(client, fd, timeout_ms);
+    return MB_SUCCESS;
+}
+
+void mb_tcp_client_adopt(mb_tcp_client_t *client, int fd, uint32_t timeout_ms) {
+    if (client == NULL) {
+        return;
+    }
+
+    // Requests are small: never wait for a full segment (fails harmlessly on non-TCP sockets)
+    int one = 1;
+    (void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    client->fd         = fd;
+    client->timeout_ms = timeout_ms;
+    client->send_calls = 0;
+    client->recv_calls = 0;
+    client->ring       = NULL;
+    client->queued     = false;
+    client->tx_offset  = 0;
+    client->tx_length  = 0;
+}
+
+void mb_tcp_client_transport(mb_tcp_client_t *client, mb_transport_t *transport) {
+    if (client == NULL || transport == NULL) {
+        return;
+    }
+
+    memset(transport, 0, sizeof(*transport));
+    transport->send        = client_send;
+    transport->send_frames = client_send_frames;
+    transport->recv        = client_recv;
+    transport->set_timeout = client_set_timeout;
+    transport->clock_us    = client_clock_us;
+    transport->context     = client;
+}
+
+void mb_tcp_client_close(mb_tcp_client_t *client) {
+    if (client == NULL) {
+        return;
+    }
+
+#ifdef MB_ENABLE_TCP_URING
+    if (client->ring != NULL) {
+        unqueue(client);
+        client->ring->attached--;
+        client->ring = NULL;
+    }
+#endif
+
+    if (client->fd >= 0) {
+        (void)close(client->fd);
+        client->fd = -1;
+    }
+}
+
+#ifdef MB_ENABLE_TCP_URING
+
+int mb_tcp_uring_init(mb_tcp_uring_t *ring) {
+    if (ring == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->sq_map = MAP_FAILED;
+    ring->cq_map = MAP_FAILED;
+    ring->sqes   = MAP_FAILED;
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring->fd = (int)syscall(__NR_io_uring_setup, MB_TCP_URING_CLIENTS, &params);
+    if (ring->fd < 0) {
+        return MB_ERROR_NOT_SUPPORTED;
+    }
+
+    ring->sq_off[RING_HEAD]  = params.sq_off.head;
+    ring->sq_off[RING_TAIL]  = params.sq_off.tail;
+    ring->sq_off[RING_MASK]  = params.sq_off.ring_mask;
+    ring->sq_off[RING_ARRAY] = params.sq_off.array;
+    ring->cq_off[RING_HEAD]  = params.cq_off.head;
+    ring->cq_off[RING_TAIL]  = params.cq_off.tail;
+    ring->cq_off[RING_MASK]  = params.cq_off.ring_mask;
+    ring->cq_off[RING_ARRAY] = params.cq_off.cqes;
+
+    ring->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    ring->cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_size   = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    // Kernels since 5.4 map both rings with one mmap()
+    bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single && ring->cq_map_size > ring->sq_map_size) {
+        ring->sq_map_size = ring->cq_map_size;
+    }
+
+    ring->sq_map = mmap(NULL, ring->sq_map_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_map != MAP_FAILED) {
+        ring->cq_map = single ? ring->sq_map
+                              : mmap(NULL, ring->cq_map_size, PROT_READ | PROT_WRITE,
+                                     MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    }
+    if (ring->cq_map != MAP_FAILED) {
+        ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    }
+    if (ring->sqes == MAP_FAILED) {
+        mb_tcp_uring_close(ring);
+        return MB_ERROR_NOT_SUPPORTED;
+    }
+
+    return MB_SUCCESS;
+}
+
+int mb_tcp_uring_attach(mb_tcp_uring_t *ring, mb_tcp_client_t *client) {
+    if (ring == NULL || client == NULL || client->ring != NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+    if (ring->attached >= MB_TCP_URING_CLIENTS) {
+        return MB_ERROR_NO_MEMORY;
+    }
+
+    client->ring      = ring;
+    client->queued    = false;
+    client->tx_offset = 0;
+    client->tx_length = 0;
+    ring->attached++;
+    return MB_SUCCESS;
+}
+
+/**
+ * @brief Apply every completion posted so far
+ * @return Number of completions reaped
+ */
+static uint32_t reap(mb_tcp_uring_t *ring, int *result) {
+    uint32_t *head_word = ring_word(ring->cq_map, ring->cq_off[RING_HEAD]);
+    uint32_t mask       = *ring_word(ring->cq_map, ring->cq_off[RING_MASK]);
+    uint32_t tail       = __atomic_load_n(ring_word(ring->cq_map, ring->cq_off[RING_TAIL]),
+                                          __ATOMIC_ACQUIRE);
+    const struct io_uring_cqe *cqes =
+        (const struct io_uring_cqe *)((uint8_t *)ring->cq_map + ring->cq_off[RING_ARRAY]);
+
+    uint32_t head = *head_word;
+    uint32_t done = 0;
+    for (; head != tail; head++, done++) {
+        const struct io_uring_cqe *cqe = &cqes[head & mask];
+        mb_tcp_client_t *client        = ring->queue[cqe->user_data];
+        if (cqe->res > 0) {
+            client->tx_offset = (uint16_t)(client->tx_offset + cqe->res);
+        } else {
+            // The socket failed: its frames cannot be delivered any more
+            client->tx_offset = client->tx_length;
+            *result           = MB_ERROR_TRANSPORT;
+        }
+    }
+    __atomic_store_n(head_word, head, __ATOMIC_RELEASE);
+    return done;
+}
+
+int mb_tcp_uring_submit(mb_tcp_uring_t *ring) {
+    if (ring == NULL || ring->fd < 0) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    uint32_t *sq_head = ring_word(ring->sq_map, ring->sq_off[RING_HEAD]);
+    uint32_t *sq_tail = ring_word(ring->sq_map, ring->sq_off[RING_TAIL]);
+    uint32_t sq_mask  = *ring_word(ring->sq_map, ring->sq_off[RING_MASK]);
+    uint32_t *array   = ring_word(ring->sq_map, ring->sq_off[RING_ARRAY]);
+    struct io_uring_sqe *sqes = (struct io_uring_sqe *)ring->sqes;
+
+    int result = MB_SUCCESS;
+    while (ring->queued > 0) {
+        // One send per queued client; the entry index is the queue slot
+        uint32_t tail = *sq_tail;
+        for (uint16_t i = 0; i < ring->queued; i++) {
+            mb_tcp_client_t *client  = ring->queue[i];
+            uint32_t index           = (tail + i) & sq_mask;
+            struct io_uring_sqe *sqe = &sqes[index];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode    = IORING_OP_SEND;
+            sqe->fd        = client->fd;
+            sqe->addr      = (uint64_t)(uintptr_t)&client->tx[client->tx_offset];
+            sqe->len       = (uint32_t)(client->tx_length - client->tx_offset);
+            sqe->msg_flags = MSG_NOSIGNAL;
+            sqe->user_data = i;
+            array[index]   = index;
+        }
+        __atomic_store_n(sq_tail, tail + ring->queued, __ATOMIC_RELEASE);
+
+        // Submit and wait in one call; an interrupted wait is resumed
+        uint32_t completed = 0;
+        while (completed < ring->queued) {
+            uint32_t unsubmitted = *sq_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+            int entered = uring_enter(ring->fd, unsubmitted, ring->queued - completed);
+            ring->submits++;
+            if (entered < 0 && errno != EINTR) {
+                return MB_ERROR_TRANSPORT;
+            }
+            completed += reap(ring, &result);
+        }
+
+        // Clients whose send was short go round again
+        uint16_t kept = 0;
+        for (uint16_t i = 0; i < ring->queued; i++) {
+            mb_tcp_client_t *client = ring->queue[i];
+            if (client->tx_offset < client->tx_length) {
+                ring->queue[kept++] = client;
+            } else {
+                client->queued    = false;
+                client->tx_offset = 0;
+                client->tx_length = 0;
+            }
+        }
+        ring->queued = kept;
+    }
+    return result;
+}
+
+void mb_tcp_uring_close(mb_tcp_uring_t *ring) {
+    if (ring == NULL) {
+        return;
+    }
+
+    if (ring->sqes != MAP_FAILED) {
+        (void)munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->cq_map != MAP_FAILED && ring->cq_map != ring->sq_map) {
+        (void)munmap(ring->cq_map, ring->cq_map_size);
+    }
+    if (ring->sq_map != MAP_FAILED) {
+        (void)munmap(ring->sq_map, ring->sq_map_size);
+    }
+    if (ring->fd >= 0) {
+        (void)close(ring->fd);
+    }
+    ring->sq_map = MAP_FAILED;
+    ring->cq_map = MAP_FAILED;
+    ring->sqes   = MAP_FAILED;
+    ring->fd     = -1;
+    ring->queued = 0;
+}
+
+#endif  // MB_ENABLE_TCP_URING
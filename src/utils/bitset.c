@@ -0,0 +1,172 @@
+/**
+ * @file bitset.c
+ * @brief Packed bit copy and gather implementation
+ *
+ * A window of response bits is loaded as one 64-bit value from the bytes
+ * that hold it, so at most 57 bits past an arbitrary start bit fit. The
+ * requested offsets inside the window form an extract mask; PEXT (or the
+ * portable loop over the mask's set bits) compacts them into consecutive
+ * destination bits, which are then stored with at most two word updates.
+ */
+
+#include "bitset.h"
+
+#if defined(MB_BITS_PEXT) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BITS_PEXT_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Widest window one 64-bit load covers past an unaligned start bit
+ */
+#define BITS_WINDOW 57
+
+/**
+ * @brief Contiguous runs at least this long are copied instead of extracted
+ */
+#define BITS_RUN_MIN 32
+
+typedef uint64_t (*bits_extract_fn)(uint64_t value, uint64_t mask);
+
+/**
+ * @brief Load count (<= BITS_WINDOW) bits starting at bit of src
+ */
+static uint64_t load_bits(const uint8_t *src, uint32_t bit, uint32_t count) {
+    const uint8_t *bytes = &src[bit >> 3];
+    uint32_t shift       = bit & 7;
+    uint32_t length      = (shift + count + 7) / 8;
+    uint64_t value       = 0;
+
+    for (uint32_t i = 0; i < length; i++) {
+        value |= (uint64_t)bytes[i] << (8 * i);
+    }
+
+    value >>= shift;
+    return count < 64 ? value & ((1ULL << count) - 1) : value;
+}
+
+/**
+ * @brief Store count (<= 32) bits at bit of dst, leaving other bits unchanged
+ */
+static void store_bits(uint32_t *dst, uint32_t bit, uint32_t value, uint32_t count) {
+    uint32_t word  = bit >> 5;
+    uint32_t shift = bit & 31;
+    uint64_t mask  = ((1ULL << count) - 1) << shift;
+    uint64_t bits  = ((uint64_t)value << shift) & mask;
+
+    dst[word] = (dst[word] & ~(uint32_t)mask) | (uint32_t)bits;
+    if ((mask >> 32) != 0) {
+        dst[word + 1] = (dst[word + 1] & ~(uint32_t)(mask >> 32)) | (uint32_t)(bits >> 32);
+    }
+}
+
+static uint64_t extract_portable(uint64_t value, uint64_t mask) {
+    uint64_t result = 0;
+    for (uint64_t out = 1; mask != 0; out <<= 1) {
+        uint64_t lowest = mask & (~mask + 1);
+        if ((value & lowest) != 0) {
+            result |= out;
+        }
+        mask ^= lowest;
+    }
+    return result;
+}
+
+#ifdef BITS_PEXT_X86
+__attribute__((target("bmi2"))) static uint64_t extract_pext(uint64_t value, uint64_t mask) {
+    return _pext_u64(value, mask);
+}
+
+static bool pext_supported(void) {
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+
+    // CPUID leaf 7, sub-leaf 0: EBX bit 8 = BMI2
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) == 0) {
+        return false;
+    }
+    return (ebx & (1u << 8)) != 0;
+}
+#endif
+
+/**
+ * @brief Active extract kernel; resolved on first use
+ */
+static bits_extract_fn active_extract = NULL;
+
+bool mb_bits_use_pext(bool enable) {
+    active_extract = extract_portable;
+#ifdef BITS_PEXT_X86
+    if (enable && pext_supported()) {
+        active_extract = extract_pext;
+    }
+#else
+    (void)enable;
+#endif
+    return active_extract != extract_portable;
+}
+
+void mb_bits_copy(uint32_t *dst,
+                  uint32_t dst_bit,
+                  const uint8_t *src,
+                  uint32_t src_bit,
+                  uint32_t count) {
+    while (count > 0) {
+        // Fill up to the next destination word boundary per step
+        uint32_t take = 32 - (dst_bit & 31);
+        if (take > count) {
+            take = count;
+        }
+
+        store_bits(dst, dst_bit, (uint32_t)load_bits(src, src_bit, take), take);
+        dst_bit += take;
+        src_bit += take;
+        count -= take;
+    }
+}
+
+void mb_bits_gather(uint32_t *dst,
+                    const uint8_t *src,
+                    const mb_scatter_entry_t *entries,
+                    uint16_t entry_count) {
+    if (active_extract == NULL) {
+        (void)mb_bits_use_pext(true);
+    }
+
+    uint16_t i = 0;
+    while (i < entry_count) {
+        uint16_t base = entries[i].offset;
+        uint16_t dest = entries[i].dest_index;
+
+        // Contiguous in the response and in the bitset: word copy
+        uint16_t j = (uint16_t)(i + 1);
+        while (j < entry_count && entries[j].offset == entries[j - 1].offset + 1 &&
+               entries[j].dest_index == entries[j - 1].dest_index + 1) {
+            j++;
+        }
+        if (j - i >= BITS_RUN_MIN) {
+            mb_bits_copy(dst, dest, src, base, (uint32_t)(j - i));
+            i = j;
+            continue;
+        }
+
+        // Increasing offsets within one window: a single extract
+        uint64_t mask = 1;
+        j             = (uint16_t)(i + 1);
+        while (j < entry_count && j - i < 32 &&
+               entries[j].dest_index == entries[j - 1].dest_index + 1 &&
+               entries[j].offset > entries[j - 1].offset &&
+               entries[j].offset - base < BITS_WINDOW) {
+            mask |= 1ULL << (entries[j].offset - base);
+            j++;
+        }
+
+        uint32_t span   = (uint32_t)(entries[j - 1].offset - base) + 1;
+        uint64_t window = load_bits(src, base, span);
+        store_bits(dst, dest, (uint32_t)active_extract(window, mask), (uint32_t)(j - i));
+        i = j;
+    }
+}
@@ -0,0 +1,67 @@
+/**
+ * @file bitset.h
+ * @brief Packed bit copy and gather for coil/discrete input responses
+ *
+ * Bitsets are arrays of uint32_t words, bit i at (words[i / 32] >> (i % 32))
+ * & 1. Source bits are Modbus response bytes, LSB first. Runs of requested
+ * bits are moved a word at a time; sparse bits within a 64-bit window go
+ * through a parallel bit extract (BMI2 PEXT when the CPU has it).
+ */
+
+#ifndef SMARTMODBUS_BITSET_H
+#define SMARTMODBUS_BITSET_H
+
+#include "smartmodbus/mb_types.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Copy a run of bits from response bytes into a bitset
+ * @param dst Destination bitset
+ * @param dst_bit First destination bit
+ * @param src Source bytes, LSB first
+ * @param src_bit First source bit
+ * @param count Number of bits
+ *
+ * Destination bits outside the run are left unchanged. Only the source
+ * bytes holding the run are read.
+ */
+void mb_bits_copy(uint32_t *dst,
+                  uint32_t dst_bit,
+                  const uint8_t *src,
+                  uint32_t src_bit,
+                  uint32_t count);
+
+/**
+ * @brief Gather the requested bits of one response into a bitset
+ * @param dst Destination bitset, indexed by entry dest_index
+ * @param src Response data bytes, LSB first
+ * @param entries Scatter entries of the plan (offsets below the plan quantity)
+ * @param entry_count Number of entries
+ *
+ * Entries with consecutive destinations are handled together: contiguous
+ * offsets as a word copy, increasing offsets within 64 bits as one extract.
+ */
+void mb_bits_gather(uint32_t *dst,
+                    const uint8_t *src,
+                    const mb_scatter_entry_t *entries,
+                    uint16_t entry_count);
+
+/**
+ * @brief Select the extract kernel
+ * @param enable true for BMI2 PEXT where the CPU supports it, false for
+ *        the portable kernel
+ * @return true if PEXT is in use
+ */
+bool mb_bits_use_pext(bool enable);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_BITSET_H
@@ -6,11 +6,17 @@
 #include "block_utils.h"
 
 #include "../core/fc_policy.h"
+#include "smartmodbus/mb_config.h"
 #include "smartmodbus/mb_error.h"
 
 #include <stdlib.h>
 #include <string.h>
 
+/**
+ * @brief Blocks up to this count are sorted by insertion instead of radix
+ */
+#define SORT_INSERTION_MAX 16
+
 /**
  * @brief Comparison function for sorting blocks by address
  */
@@ -27,32 +33,123 @@ static int compare_blocks_by_address(const void *a, const void *b) {
 }
 
 /**
- * @brief Comparison function for sorting blocks by quantity (descending)
+ * @brief Comparison function for sorting addresses
  */
-static int compare_blocks_by_quantity_desc(const void *a, const void *b) {
-    const mb_block_t *block_a = (const mb_block_t *)a;
-    const mb_block_t *block_b = (const mb_block_t *)b;
+static int compare_addresses(const void *a, const void *b) {
+    uint16_t addr_a = *(const uint16_t *)a;
+    uint16_t addr_b = *(const uint16_t *)b;
+    return (addr_a > addr_b) - (addr_a < addr_b);
+}
 
-    if (block_a->quantity > block_b->quantity) {
-        return -1;
-    } else if (block_a->quantity < block_b->quantity) {
-        return 1;
+/**
+ * @brief Index of the lowest set bit (value must be non-zero)
+ */
+static inline uint32_t lowest_bit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint32_t)__builtin_ctzll(value);
+#else
+    uint32_t index = 0;
+    while ((value & 1u) == 0) {
+        value >>= 1;
+        index++;
     }
-    return 0;
+    return index;
+#endif
 }
 
 void mb_block_sort_by_address(mb_block_t *blocks, uint16_t count) {
     if (blocks == NULL || count == 0) {
         return;
     }
+
+    // Blocks from mb_addresses_to_blocks() arrive sorted: one linear check
+    uint16_t i = 1;
+    while (i < count && blocks[i - 1].start_address <= blocks[i].start_address) {
+        i++;
+    }
+    if (i == count) {
+        return;
+    }
+
     qsort(blocks, count, sizeof(mb_block_t), compare_blocks_by_address);
 }
 
+/**
+ * @brief Stable insertion sort by quantity (descending)
+ */
+static void insertion_sort_by_quantity_desc(mb_block_t *blocks, uint16_t count) {
+    for (uint16_t i = 1; i < count; i++) {
+        mb_block_t block = blocks[i];
+        uint16_t j       = i;
+        while (j > 0 && blocks[j - 1].quantity < block.quantity) {
+            blocks[j] = blocks[j - 1];
+            j--;
+        }
+        blocks[j] = block;
+    }
+}
+
 void mb_block_sort_by_quantity_desc(mb_block_t *blocks, uint16_t count) {
+    mb_block_sort_by_quantity_desc_scratch(blocks, count, NULL);
+}
+
+void mb_block_sort_by_quantity_desc_scratch(mb_block_t *blocks,
+                                            uint16_t count,
+                                            mb_scratch_t *scratch) {
     if (blocks == NULL || count == 0) {
         return;
     }
-    qsort(blocks, count, sizeof(mb_block_t), compare_blocks_by_quantity_desc);
+
+    size_t mark      = mb_scratch_mark(scratch);
+    mb_block_t *temp = NULL;
+    if (count > SORT_INSERTION_MAX) {
+        temp = (mb_block_t *)mb_scratch_acquire(scratch, count * sizeof(mb_block_t));
+    }
+
+    if (temp == NULL) {
+        insertion_sort_by_quantity_desc(blocks, count);
+        mb_scratch_rewind(scratch, mark);
+        return;
+    }
+
+    // LSD radix sort on the 16-bit quantity, one stable counting pass per
+    // byte; buckets are laid out high to low for descending order
+    mb_block_t *src = blocks;
+    mb_block_t *dst = temp;
+
+    for (uint32_t shift = 0; shift < 16; shift += 8) {
+        uint16_t counts[256];
+        memset(counts, 0, sizeof(counts));
+        for (uint16_t i = 0; i < count; i++) {
+            counts[(src[i].quantity >> shift) & 0xFF]++;
+        }
+
+        // All blocks share this byte: the pass would not move anything
+        if (counts[(src[0].quantity >> shift) & 0xFF] == count) {
+            continue;
+        }
+
+        uint16_t next = 0;
+        for (uint32_t key = 256; key-- > 0;) {
+            uint16_t bucket = counts[key];
+            counts[key]     = next;
+            next            = (uint16_t)(next + bucket);
+        }
+        for (uint16_t i = 0; i < count; i++) {
+            dst[counts[(src[i].quantity >> shift) & 0xFF]++] = src[i];
+        }
+
+        mb_block_t *swap = src;
+        src              = dst;
+        dst              = swap;
+    }
+
+    if (src != blocks) {
+        memcpy(blocks, src, count * sizeof(mb_block_t));
+    }
+
+    mb_scratch_release(scratch, temp);
+    mb_scratch_rewind(scratch, mark);
 }
 
 bool mb_block_are_adjacent(const mb_block_t *a, const mb_block_t *b) {
@@ -185,6 +282,109 @@ int mb_block_validate(const mb_block_t *block) {
     return MB_SUCCESS;
 }
 
+/**
+ * @brief Append one block, or fail once max_blocks are in use
+ */
+static int emit_block(mb_block_t *blocks,
+                      uint16_t max_blocks,
+                      uint16_t *num_blocks,
+                      uint8_t slave_id,
+                      uint8_t fc,
+                      uint32_t start,
+                      uint32_t end) {
+    if (*num_blocks >= max_blocks) {
+        return MB_ERROR_TOO_MANY_BLOCKS;
+    }
+
+    mb_block_t *block    = &blocks[(*num_blocks)++];
+    block->slave_id      = slave_id;
+    block->function_code = fc;
+    block->start_address = (uint16_t)start;
+    block->quantity      = (uint16_t)(end - start);
+    block->is_merged     = false;
+    return MB_SUCCESS;
+}
+
+/**
+ * @brief Emit the runs of set bits of an address bitmap as blocks
+ * @param map Bitmap words, bit b of word k standing for address 64 * (base + k) + b
+ */
+static int blocks_from_bitmap(const uint64_t *map,
+                              uint32_t base,
+                              uint32_t words,
+                              uint8_t slave_id,
+                              uint8_t fc,
+                              mb_block_t *blocks,
+                              uint16_t max_blocks,
+                              uint16_t *num_blocks) {
+    bool in_run        = false;
+    uint32_t run_start = 0;
+
+    for (uint32_t k = 0; k < words; k++) {
+        uint64_t bits  = map[k];
+        uint32_t first = (base + k) * 64;
+        uint32_t pos   = 0;
+
+        // Alternate between the next set bit (run start) and the next clear
+        // bit (run end); a run may continue into the following word
+        while (pos < 64) {
+            uint64_t rest = (in_run ? ~bits : bits) >> pos;
+            if (rest == 0) {
+                break;
+            }
+            pos += lowest_bit(rest);
+
+            if (in_run) {
+                int result = emit_block(blocks, max_blocks, num_blocks, slave_id, fc, run_start,
+                                        first + pos);
+                if (result != MB_SUCCESS) {
+                    return result;
+                }
+            } else {
+                run_start = first + pos;
+            }
+            in_run = !in_run;
+        }
+    }
+
+    if (in_run) {
+        return emit_block(blocks, max_blocks, num_blocks, slave_id, fc, run_start,
+                          (base + words) * 64);
+    }
+    return MB_SUCCESS;
+}
+
+/**
+ * @brief Emit the runs of a sorted address array as blocks, skipping duplicates
+ */
+static int blocks_from_sorted(const uint16_t *sorted,
+                              uint16_t count,
+                              uint8_t slave_id,
+                              uint8_t fc,
+                              mb_block_t *blocks,
+                              uint16_t max_blocks,
+                              uint16_t *num_blocks) {
+    uint32_t run_start = sorted[0];
+    uint32_t run_end   = (uint32_t)sorted[0] + 1;
+
+    for (uint16_t i = 1; i < count; i++) {
+        if (sorted[i] < run_end) {
+            continue;
+        }
+        if (sorted[i] != run_end) {
+            int result = emit_block(blocks, max_blocks, num_blocks, slave_id, fc, run_start,
+                                    run_end);
+            if (result != MB_SUCCESS) {
+                return result;
+            }
+            run_start = sorted[i];
+        }
+        run_end = (uint32_t)sorted[i] + 1;
+    }
+
+    return emit_block(blocks, max_blocks, num_blocks, slave_id, fc, run_start, run_end);
+}
+
 int mb_addresses_to_blocks(const uint16_t *addresses,
                            uint16_t count,
                            uint8_t slave_id,
@@ -192,6 +392,18 @@ int mb_addresses_to_blocks(const uint16_t *addresses,
                            mb_block_t *blocks,
                            uint16_t max_blocks,
                            uint16_t *block_count) {
+    return mb_addresses_to_blocks_scratch(addresses, count, slave_id, fc, blocks, max_blocks,
+                                          block_count, NULL);
+}
+
+int mb_addresses_to_blocks_scratch(const uint16_t *addresses,
+                                   uint16_t count,
+                                   uint8_t slave_id,
+                                   uint8_t fc,
+                                   mb_block_t *blocks,
+                                   uint16_t max_blocks,
+                                   uint16_t *block_count,
+                                   mb_scratch_t *scratch) {
     if (addresses == NULL || blocks == NULL || block_count == NULL) {
         return MB_ERROR_INVALID_PARAM;
     }
@@ -205,69 +417,76 @@ int mb_addresses_to_blocks(const uint16_t *addresses,
         return MB_ERROR_INVALID_FC;
     }
 
-    // Create a sorted copy of addresses
-    uint16_t *sorted_addresses = (uint16_t *)malloc(count * sizeof(uint16_t));
-    if (sorted_addresses == NULL) {
-        return MB_ERROR_OUT_OF_MEMORY;
+    uint16_t lowest  = addresses[0];
+    uint16_t highest = addresses[0];
+    for (uint16_t i = 1; i < count; i++) {
+        lowest  = addresses[i] < lowest ? addresses[i] : lowest;
+        highest = addresses[i] > highest ? addresses[i] : highest;
     }
 
-    memcpy(sorted_addresses, addresses, count * sizeof(uint16_t));
+    uint32_t base  = (uint32_t)lowest / 64;
+    uint32_t words = (uint32_t)highest / 64 - base + 1;
+
+    uint16_t num_blocks = 0;
+    size_t mark         = mb_scratch_mark(scratch);
+    int result;
+
+    // Dense requests: one bit per address in the span, no larger than the
+    // sorted copy it replaces. Runs come out sorted and deduplicated.
+    if (words * sizeof(uint64_t) <= count * sizeof(uint16_t)) {
+        uint64_t *map = (uint64_t *)mb_scratch_acquire(scratch, words * sizeof(uint64_t));
+        if (map != NULL) {
+            memset(map, 0, words * sizeof(uint64_t));
+            for (uint16_t i = 0; i < count; i++) {
+                uint32_t bit = addresses[i] - base * 64;
+                map[bit / 64] |= 1ULL << (bit % 64);
+            }
 
-    // Simple bubble sort for addresses
-    for (uint16_t i = 0; i < count - 1; i++) {
-        for (uint16_t j = 0; j < count - i - 1; j++) {
-            if (sorted_addresses[j] > sorted_addresses[j + 1]) {
-                uint16_t temp          = sorted_addresses[j];
-                sorted_addresses[j]     = sorted_addresses[j + 1];
-                sorted_addresses[j + 1] = temp;
+            result = blocks_from_bitmap(map, base, words, slave_id, fc, blocks, max_blocks,
+                                        &num_blocks);
+            mb_scratch_release(scratch, map);
+            mb_scratch_rewind(scratch, mark);
+            if (result == MB_SUCCESS) {
+                *block_count = num_blocks;
             }
+            return result;
         }
     }
 
-    // Group consecutive addresses into blocks
-    uint16_t num_blocks     = 0;
-    uint16_t block_start    = sorted_addresses[0];
-    uint16_t block_quantity = 1;
+    // Sparse requests: sort a copy of the addresses
+    uint16_t *sorted_addresses = (uint16_t *)mb_scratch_acquire(scratch, count * sizeof(uint16_t));
 
-    for (uint16_t i = 1; i < count; i++) {
-        // Check if current address is consecutive
-        if (sorted_addresses[i] == sorted_addresses[i - 1] + 1) {
-            block_quantity++;
-        } else {
-            // Save current block
-            if (num_blocks >= max_blocks) {
-                free(sorted_addresses);
-                return MB_ERROR_TOO_MANY_BLOCKS;
-            }
-
-            blocks[num_blocks].slave_id      = slave_id;
-            blocks[num_blocks].function_code = fc;
-            blocks[num_blocks].start_address = block_start;
-            blocks[num_blocks].quantity      = block_quantity;
-            blocks[num_blocks].is_merged     = false;
-            num_blocks++;
-
-            // Start new block
-            block_start    = sorted_addresses[i];
-            block_quantity = 1;
+#ifdef MB_USE_STATIC_MEMORY
+    uint16_t static_sorted[MB_MAX_SCATTER];
+    if (sorted_addresses == NULL) {
+        if (count > MB_MAX_SCATTER) {
+            return MB_ERROR_TOO_MANY_BLOCKS;
         }
+        sorted_addresses = static_sorted;
     }
+#endif
 
-    // Save last block
-    if (num_blocks >= max_blocks) {
-        free(sorted_addresses);
-        return MB_ERROR_TOO_MANY_BLOCKS;
+    if (sorted_addresses == NULL) {
+        return MB_ERROR_OUT_OF_MEMORY;
     }
 
-    blocks[num_blocks].slave_id      = slave_id;
-    blocks[num_blocks].function_code = fc;
-    blocks[num_blocks].start_address = block_start;
-    blocks[num_blocks].quantity      = block_quantity;
-    blocks[num_blocks].is_merged     = false;
-    num_blocks++;
+    memcpy(sorted_addresses, addresses, count * sizeof(uint16_t));
+    qsort(sorted_addresses, count, sizeof(uint16_t), compare_addresses);
 
-    *block_count = num_blocks;
+    result = blocks_from_sorted(sorted_addresses, count, slave_id, fc, blocks, max_blocks,
+                                &num_blocks);
 
-    free(sorted_addresses);
-    return MB_SUCCESS;
+#ifdef MB_USE_STATIC_MEMORY
+    if (sorted_addresses != static_sorted) {
+        mb_scratch_release(scratch, sorted_addresses);
+    }
+#else
+    mb_scratch_release(scratch, sorted_addresses);
+#endif
+    mb_scratch_rewind(scratch, mark);
+
+    if (result == MB_SUCCESS) {
+        *block_count = num_blocks;
+    }
+    return result;
 }
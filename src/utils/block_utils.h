@@ -8,6 +8,7 @@
 #ifndef SMARTMODBUS_BLOCK_UTILS_H
 #define SMARTMODBUS_BLOCK_UTILS_H
 
+#include "scratch.h"
 #include "smartmodbus/mb_types.h"
 
 #include <stdbool.h>
@@ -21,6 +22,8 @@ extern "C" {
  * @brief Sort blocks by start address (ascending)
  * @param blocks Array of blocks
  * @param count Number of blocks
+ *
+ * Already sorted input is detected in one pass and left untouched.
  */
 void mb_block_sort_by_address(mb_block_t *blocks, uint16_t count);
 
@@ -31,6 +34,20 @@ void mb_block_sort_by_address(mb_block_t *blocks, uint16_t count);
  */
 void mb_block_sort_by_quantity_desc(mb_block_t *blocks, uint16_t count);
 
+/**
+ * @brief Sort blocks by quantity (descending) using scratch memory
+ * @param blocks Array of blocks
+ * @param count Number of blocks
+ * @param scratch Arena for the radix sort buffer (NULL = heap or stack)
+ *
+ * Stable: blocks of equal quantity keep their order. Runs in linear time
+ * with a buffer of count blocks; without one (static builds without an
+ * arena) it falls back to insertion sort.
+ */
+void mb_block_sort_by_quantity_desc_scratch(mb_block_t *blocks,
+                                            uint16_t count,
+                                            mb_scratch_t *scratch);
+
 /**
  * @brief Check if two blocks are adjacent (no gap)
  * @param a First block
@@ -97,6 +114,32 @@ int mb_addresses_to_blocks(const uint16_t *addresses,
                            uint16_t max_blocks,
                            uint16_t *block_count);
 
+/**
+ * @brief Convert array of addresses to blocks using scratch memory
+ * @param addresses Array of addresses
+ * @param count Number of addresses
+ * @param slave_id Slave device ID
+ * @param fc Function code
+ * @param blocks Output array of blocks
+ * @param max_blocks Maximum number of blocks
+ * @param block_count Output: actual number of blocks created
+ * @param scratch Arena for the address bitmap or sorted copy (NULL = heap or stack)
+ * @return 0 on success, negative error code on failure
+ *
+ * Blocks come out sorted by address, with duplicate addresses merged.
+ * Dense requests (span of at most 16 addresses per requested address) are
+ * bucketed in a bitmap whose runs are scanned with count-trailing-zeros,
+ * in time linear in the count plus the span; sparse ones sort a copy.
+ */
+int mb_addresses_to_blocks_scratch(const uint16_t *addresses,
+                                   uint16_t count,
+                                   uint8_t slave_id,
+                                   uint8_t fc,
+                                   mb_block_t *blocks,
+                                   uint16_t max_blocks,
+                                   uint16_t *block_count,
+                                   mb_scratch_t *scratch);
+
 #ifdef __cplusplus
 }
 #endif
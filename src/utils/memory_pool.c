@@ -4,6 +4,11 @@
  *
  * Provides simple fixed-size memory pools for embedded systems
  * that cannot use dynamic memory allocation.
+ *
+ * The typed pools share one free-list core. The link of a free slot is
+ * stored in its first bytes with memcpy, so slots of any type and alignment
+ * work. used[] is only consulted on free, to ignore foreign pointers and
+ * double frees in constant time.
  */
 
 #include "memory_pool.h"
@@ -12,14 +17,81 @@
 
 #ifdef MB_USE_STATIC_MEMORY
 
+static void pool_init(mb_pool_state_t *state,
+                      void *slots,
+                      size_t slot_size,
+                      bool *used,
+                      uint16_t capacity) {
+    uint8_t *base = (uint8_t *)slots;
+
+    // Chain every slot to the next; the last one links to capacity (none)
+    for (uint16_t i = 0; i < capacity; i++) {
+        uint16_t next = (uint16_t)(i + 1);
+        memcpy(base + (size_t)i * slot_size, &next, sizeof(next));
+        used[i] = false;
+    }
+
+    state->free_head  = 0;
+    state->count      = 0;
+    state->high_water = 0;
+}
+
+static void *pool_alloc(mb_pool_state_t *state,
+                        void *slots,
+                        size_t slot_size,
+                        bool *used,
+                        uint16_t capacity) {
+    if (state->free_head >= capacity) {
+        return NULL;  // Pool is full
+    }
+
+    uint16_t index = state->free_head;
+    uint8_t *slot  = (uint8_t *)slots + (size_t)index * slot_size;
+
+    memcpy(&state->free_head, slot, sizeof(state->free_head));
+    used[index] = true;
+    state->count++;
+    if (state->count > state->high_water) {
+        state->high_water = state->count;
+    }
+
+    memset(slot, 0, slot_size);
+    return slot;
+}
+
+static void pool_free(mb_pool_state_t *state,
+                      void *slots,
+                      size_t slot_size,
+                      bool *used,
+                      uint16_t capacity,
+                      const void *ptr) {
+    uintptr_t base    = (uintptr_t)slots;
+    uintptr_t address = (uintptr_t)ptr;
+
+    if (address < base || address - base >= (uintptr_t)capacity * slot_size ||
+        (address - base) % slot_size != 0) {
+        return;  // Not a slot of this pool
+    }
+
+    uint16_t index = (uint16_t)((address - base) / slot_size);
+    if (!used[index]) {
+        return;  // Already free
+    }
+
+    memcpy((uint8_t *)slots + (size_t)index * slot_size, &state->free_head,
+           sizeof(state->free_head));
+    state->free_head = index;
+    used[index]      = false;
+    state->count--;
+}
+
 // Block pool functions
 void mb_block_pool_init(mb_block_pool_t *pool) {
     if (pool == NULL) {
         return;
     }
 
-    memset(pool->used, 0, sizeof(pool->used));
-    pool->count = 0;
+    pool_init(&pool->state, pool->blocks, sizeof(mb_block_t), pool->used, MB_MAX_BLOCKS);
 }
 
 mb_block_t *mb_block_pool_alloc(mb_block_pool_t *pool) {
@@ -27,17 +99,8 @@ mb_block_t *mb_block_pool_alloc(mb_block_pool_t *pool) {
         return NULL;
     }
 
-    // Find first free slot
-    for (uint16_t i = 0; i < MB_MAX_BLOCKS; i++) {
-        if (!pool->used[i]) {
-            pool->used[i] = true;
-            pool->count++;
-            memset(&pool->blocks[i], 0, sizeof(mb_block_t));
-            return &pool->blocks[i];
-        }
-    }
-
-    return NULL;  // Pool is full
+    return (mb_block_t *)pool_alloc(&pool->state, pool->blocks, sizeof(mb_block_t), pool->used,
+                                    MB_MAX_BLOCKS);
 }
 
 void mb_block_pool_free(mb_block_pool_t *pool, mb_block_t *block) {
@@ -45,16 +108,7 @@ void mb_block_pool_free(mb_block_pool_t *pool, mb_block_t *block) {
         return;
     }
 
-    // Find block in pool
-    for (uint16_t i = 0; i < MB_MAX_BLOCKS; i++) {
-        if (&pool->blocks[i] == block) {
-            pool->used[i] = false;
-            if (pool->count > 0) {
-                pool->count--;
-            }
-            return;
-        }
-    }
+    pool_free(&pool->state, pool->blocks, sizeof(mb_block_t), pool->used, MB_MAX_BLOCKS, block);
 }
 
 uint16_t mb_block_pool_available(const mb_block_pool_t *pool) {
@@ -62,7 +116,11 @@ uint16_t mb_block_pool_available(const mb_block_pool_t *pool) {
         return 0;
     }
 
-    return MB_MAX_BLOCKS - pool->count;
+    return (uint16_t)(MB_MAX_BLOCKS - pool->state.count);
+}
+
+uint16_t mb_block_pool_high_water(const mb_block_pool_t *pool) {
+    return pool != NULL ? pool->state.high_water : 0;
 }
 
 // PDU pool functions
@@ -71,8 +129,7 @@ void mb_pdu_pool_init(mb_pdu_pool_t *pool) {
         return;
     }
 
-    memset(pool->used, 0, sizeof(pool->used));
-    pool->count = 0;
+    pool_init(&pool->state, pool->pdus, sizeof(mb_pdu_t), pool->used, MB_MAX_PDUS);
 }
 
 mb_pdu_t *mb_pdu_pool_alloc(mb_pdu_pool_t *pool) {
@@ -80,17 +137,8 @@ mb_pdu_t *mb_pdu_pool_alloc(mb_pdu_pool_t *pool) {
         return NULL;
     }
 
-    // Find first free slot
-    for (uint16_t i = 0; i < MB_MAX_PDUS; i++) {
-        if (!pool->used[i]) {
-            pool->used[i] = true;
-            pool->count++;
-            memset(&pool->pdus[i], 0, sizeof(mb_pdu_t));
-            return &pool->pdus[i];
-        }
-    }
-
-    return NULL;  // Pool is full
+    return (mb_pdu_t *)pool_alloc(&pool->state, pool->pdus, sizeof(mb_pdu_t), pool->used,
+                                  MB_MAX_PDUS);
 }
 
 void mb_pdu_pool_free(mb_pdu_pool_t *pool, mb_pdu_t *pdu) {
@@ -98,16 +146,7 @@ void mb_pdu_pool_free(mb_pdu_pool_t *pool, mb_pdu_t *pdu) {
         return;
     }
 
-    // Find PDU in pool
-    for (uint16_t i = 0; i < MB_MAX_PDUS; i++) {
-        if (&pool->pdus[i] == pdu) {
-            pool->used[i] = false;
-            if (pool->count > 0) {
-                pool->count--;
-            }
-            return;
-        }
-    }
+    pool_free(&pool->state, pool->pdus, sizeof(mb_pdu_t), pool->used, MB_MAX_PDUS, pdu);
 }
 
 uint16_t mb_pdu_pool_available(const mb_pdu_pool_t *pool) {
@@ -115,7 +154,11 @@ uint16_t mb_pdu_pool_available(const mb_pdu_pool_t *pool) {
         return 0;
     }
 
-    return MB_MAX_PDUS - pool->count;
+    return (uint16_t)(MB_MAX_PDUS - pool->state.count);
+}
+
+uint16_t mb_pdu_pool_high_water(const mb_pdu_pool_t *pool) {
+    return pool != NULL ? pool->state.high_water : 0;
 }
 
 // Plan pool functions
@@ -124,8 +167,7 @@ void mb_plan_pool_init(mb_plan_pool_t *pool) {
         return;
     }
 
-    memset(pool->used, 0, sizeof(pool->used));
-    pool->count = 0;
+    pool_init(&pool->state, pool->plans, sizeof(mb_request_plan_t), pool->used, MB_MAX_PLANS);
 }
 
 mb_request_plan_t *mb_plan_pool_alloc(mb_plan_pool_t *pool) {
@@ -133,17 +175,8 @@ mb_request_plan_t *mb_plan_pool_alloc(mb_plan_pool_t *pool) {
         return NULL;
     }
 
-    // Find first free slot
-    for (uint16_t i = 0; i < MB_MAX_PLANS; i++) {
-        if (!pool->used[i]) {
-            pool->used[i] = true;
-            pool->count++;
-            memset(&pool->plans[i], 0, sizeof(mb_request_plan_t));
-            return &pool->plans[i];
-        }
-    }
-
-    return NULL;  // Pool is full
+    return (mb_request_plan_t *)pool_alloc(&pool->state, pool->plans, sizeof(mb_request_plan_t),
+                                           pool->used, MB_MAX_PLANS);
 }
 
 void mb_plan_pool_free(mb_plan_pool_t *pool, mb_request_plan_t *plan) {
@@ -151,16 +184,8 @@ void mb_plan_pool_free(mb_plan_pool_t *pool, mb_request_plan_t *plan) {
         return;
     }
 
-    // Find plan in pool
-    for (uint16_t i = 0; i < MB_MAX_PLANS; i++) {
-        if (&pool->plans[i] == plan) {
-            pool->used[i] = false;
-            if (pool->count > 0) {
-                pool->count--;
-            }
-            return;
-        }
-    }
+    pool_free(&pool->state, pool->plans, sizeof(mb_request_plan_t), pool->used, MB_MAX_PLANS,
+              plan);
 }
 
 uint16_t mb_plan_pool_available(const mb_plan_pool_t *pool) {
@@ -168,7 +193,11 @@ uint16_t mb_plan_pool_available(const mb_plan_pool_t *pool) {
         return 0;
     }
 
-    return MB_MAX_PLANS - pool->count;
+    return (uint16_t)(MB_MAX_PLANS - pool->state.count);
+}
+
+uint16_t mb_plan_pool_high_water(const mb_plan_pool_t *pool) {
+    return pool != NULL ? pool->state.high_water : 0;
 }
 
 #endif  // MB_USE_STATIC_MEMORY
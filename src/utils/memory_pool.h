@@ -4,6 +4,11 @@
  *
  * Provides fixed-size memory pools for blocks, PDUs, and plans
  * when MB_USE_STATIC_MEMORY is defined.
+ *
+ * Each pool threads an intrusive free list through its free slots (a free
+ * slot holds the index of the next one), so alloc and free take constant
+ * time whatever the pool size or occupancy. The peak number of slots in
+ * use is kept to help size MB_MAX_BLOCKS, MB_MAX_PDUS and MB_MAX_PLANS.
  */
 
 #ifndef SMARTMODBUS_MEMORY_POOL_H
@@ -20,13 +25,22 @@ extern "C" {
 
 #ifdef MB_USE_STATIC_MEMORY
 
+/**
+ * @brief Free-list state shared by all pool types
+ */
+typedef struct {
+    uint16_t free_head;  /**< First free slot (capacity: pool is full) */
+    uint16_t count;      /**< Slots in use */
+    uint16_t high_water; /**< Peak slots in use since init */
+} mb_pool_state_t;
+
 /**
  * @brief Memory pool for blocks
  */
 typedef struct {
     mb_block_t blocks[MB_MAX_BLOCKS];
     bool used[MB_MAX_BLOCKS];
-    uint16_t count;
+    mb_pool_state_t state;
 } mb_block_pool_t;
 
 /**
@@ -35,7 +49,7 @@ typedef struct {
 typedef struct {
     mb_pdu_t pdus[MB_MAX_PDUS];
     bool used[MB_MAX_PDUS];
-    uint16_t count;
+    mb_pool_state_t state;
 } mb_pdu_pool_t;
 
 /**
@@ -44,7 +58,7 @@ typedef struct {
 typedef struct {
     mb_request_plan_t plans[MB_MAX_PLANS];
     bool used[MB_MAX_PLANS];
-    uint16_t count;
+    mb_pool_state_t state;
 } mb_plan_pool_t;
 
 /**
@@ -63,7 +77,7 @@ mb_block_t *mb_block_pool_alloc(mb_block_pool_t *pool);
 /**
  * @brief Free a block back to pool
  * @param pool Block pool
- * @param block Block to free
+ * @param block Block to free (pointers not allocated from pool are ignored)
  */
 void mb_block_pool_free(mb_block_pool_t *pool, mb_block_t *block);
 
@@ -74,6 +88,13 @@ void mb_block_pool_free(mb_block_pool_t *pool, mb_block_t *block);
  */
 uint16_t mb_block_pool_available(const mb_block_pool_t *pool);
 
+/**
+ * @brief Get peak number of blocks in use since init
+ * @param pool Block pool
+ * @return High-water mark
+ */
+uint16_t mb_block_pool_high_water(const mb_block_pool_t *pool);
+
 /**
  * @brief Initialize PDU pool
  * @param pool PDU pool to initialize
@@ -90,7 +111,7 @@ mb_pdu_t *mb_pdu_pool_alloc(mb_pdu_pool_t *pool);
 /**
  * @brief Free a PDU back to pool
  * @param pool PDU pool
- * @param pdu PDU to free
+ * @param pdu PDU to free (pointers not allocated from pool are ignored)
  */
 void mb_pdu_pool_free(mb_pdu_pool_t *pool, mb_pdu_t *pdu);
 
@@ -101,6 +122,13 @@ void mb_pdu_pool_free(mb_pdu_pool_t *pool, mb_pdu_t *pdu);
  */
 uint16_t mb_pdu_pool_available(const mb_pdu_pool_t *pool);
 
+/**
+ * @brief Get peak number of PDUs in use since init
+ * @param pool PDU pool
+ * @return High-water mark
+ */
+uint16_t mb_pdu_pool_high_water(const mb_pdu_pool_t *pool);
+
 /**
  * @brief Initialize plan pool
  * @param pool Plan pool to initialize
@@ -115,8 +143,9 @@ void mb_plan_pool_init(mb_plan_pool_t *pool);
 mb_request_plan_t *mb_plan_pool_alloc(mb_plan_pool_t *pool);
 
 /**
- * @brief Free a plan back to poolam pool Plan pool
- * @param plan Plan to free
+ * @brief Free a plan back to pool
+ * @param pool Plan pool
+ * @param plan Plan to free (pointers not allocated from pool are ignored)
  */
 void mb_plan_pool_free(mb_plan_pool_t *pool, mb_request_plan_t *plan);
 
@@ -127,6 +156,13 @@ void mb_plan_pool_free(mb_plan_pool_t *pool, mb_request_plan_t *plan);
  */
 uint16_t mb_plan_pool_available(const mb_plan_pool_t *pool);
 
+/**
+ * @brief Get peak number of plans in use since init
+ * @param pool Plan pool
+ * @return High-water mark
+ */
+uint16_t mb_plan_pool_high_water(const mb_plan_pool_t *pool);
+
 #endif  // MB_USE_STATIC_MEMORY
 
 #ifdef __cplusplus
@@ -0,0 +1,188 @@
+/**
+ * @file reg_codec.c
+ * @brief Bulk register decoding and typed value assembly implementation
+ *
+ * On a little-endian host decoding is a byte swap within every 16-bit
+ * lane: PSHUFB with a fixed lane-swap mask (x86, SSSE3 detected at run
+ * time), VREV16 (AArch64, always present), or shifts and masks over 64-bit
+ * words. Big-endian hosts copy the payload unchanged.
+ *
+ * A typed value is assembled by placing each register, after the optional
+ * in-word byte swap, at the half-word of the host value given by its
+ * significance. Host floats share the integer byte order on every
+ * supported target, so the same rule covers IEEE 754 values.
+ */
+
+#include "reg_codec.h"
+
+#include <string.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define REGS_HOST_BIG_ENDIAN 1
+#elif defined(MB_REGS_SIMD) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define REGS_SIMD_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#elif defined(MB_REGS_SIMD) && defined(__aarch64__) && defined(__ARM_NEON)
+#define REGS_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+typedef void (*regs_decode_fn)(uint16_t *dst, const uint8_t *src, size_t count);
+
+/**
+ * @brief Swap the bytes of every 16-bit lane of a 64-bit word
+ */
+static inline uint64_t swap_lanes(uint64_t x) {
+    return ((x >> 8) & 0x00FF00FF00FF00FFULL) | ((x & 0x00FF00FF00FF00FFULL) << 8);
+}
+
+static void decode_portable(uint16_t *dst, const uint8_t *src, size_t count) {
+#ifdef REGS_HOST_BIG_ENDIAN
+    memcpy(dst, src, count * 2);
+#else
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint64_t lanes;
+        memcpy(&lanes, &src[i * 2], sizeof(lanes));
+        lanes = swap_lanes(lanes);
+        memcpy(&dst[i], &lanes, sizeof(lanes));
+    }
+    for (; i < count; i++) {
+        dst[i] = (uint16_t)(((uint16_t)src[i * 2] << 8) | src[i * 2 + 1]);
+    }
+#endif
+}
+
+#if defined(REGS_SIMD_X86)
+__attribute__((target("ssse3"))) static void decode_ssse3(uint16_t *dst,
+                                                          const uint8_t *src,
+                                                          size_t count) {
+    const __m128i swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i lanes = _mm_loadu_si128((const __m128i *)(const void *)&src[i * 2]);
+        _mm_storeu_si128((__m128i *)(void *)&dst[i], _mm_shuffle_epi8(lanes, swap));
+    }
+    decode_portable(&dst[i], &src[i * 2], count - i);
+}
+
+static bool simd_supported(void) {
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+
+    // CPUID leaf 1: ECX bit 9 = SSSE3
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0) {
+        return false;
+    }
+    return (ecx & (1u << 9)) != 0;
+}
+
+#define REGS_SIMD_KERNEL decode_ssse3
+#elif defined(REGS_SIMD_NEON)
+static void decode_neon(uint16_t *dst, const uint8_t *src, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        vst1q_u8((uint8_t *)&dst[i], vrev16q_u8(vld1q_u8(&src[i * 2])));
+    }
+    decode_portable(&dst[i], &src[i * 2], count - i);
+}
+
+static bool simd_supported(void) {
+    return true;
+}
+
+#define REGS_SIMD_KERNEL decode_neon
+#endif
+
+/**
+ * @brief Active decode kernel; resolved on first use
+ */
+static regs_decode_fn active_decode = NULL;
+
+bool mb_regs_use_simd(bool enable) {
+    active_decode = decode_portable;
+#ifdef REGS_SIMD_KERNEL
+    if (enable && simd_supported()) {
+        active_decode = REGS_SIMD_KERNEL;
+    }
+#else
+    (void)enable;
+#endif
+    return active_decode != decode_portable;
+}
+
+void mb_regs_decode(uint16_t *dst, const uint8_t *src, size_t count) {
+    if (active_decode == NULL) {
+        (void)mb_regs_use_simd(true);
+    }
+    active_decode(dst, src, count);
+}
+
+void mb_regs_encode(uint8_t *dst, const uint16_t *src, size_t count) {
+#ifdef REGS_HOST_BIG_ENDIAN
+    memcpy(dst, src, count * 2);
+#else
+    // The lane swap is its own inverse; count is small enough that the
+    // SWAR kernel is all a response needs
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint64_t lanes;
+        memcpy(&lanes, &src[i], sizeof(lanes));
+        lanes = swap_lanes(lanes);
+        memcpy(&dst[i * 2], &lanes, sizeof(lanes));
+    }
+    for (; i < count; i++) {
+        dst[i * 2]     = (uint8_t)(src[i] >> 8);
+        dst[i * 2 + 1] = (uint8_t)(src[i] & 0xFF);
+    }
+#endif
+}
+
+uint8_t mb_value_registers(mb_value_type_t type) {
+    switch (type) {
+    case MB_VALUE_UINT16:
+    case MB_VALUE_INT16:
+        return 1;
+    case MB_VALUE_UINT32:
+    case MB_VALUE_INT32:
+    case MB_VALUE_FLOAT32:
+        return 2;
+    case MB_VALUE_UINT64:
+    case MB_VALUE_INT64:
+    case MB_VALUE_FLOAT64:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+void mb_value_store_register(void *value,
+                             mb_value_type_t type,
+                             mb_word_order_t order,
+                             uint8_t word,
+                             uint16_t raw) {
+    uint8_t words = mb_value_registers(type);
+    if (value == NULL || word >= words) {
+        return;
+    }
+
+    bool low_first = order == MB_ORDER_CDAB || order == MB_ORDER_DCBA;
+    bool swapped   = order == MB_ORDER_BADC || order == MB_ORDER_DCBA;
+
+    uint16_t half = swapped ? (uint16_t)((raw >> 8) | (raw << 8)) : raw;
+
+    // Significance 0 is the least significant half-word of the value
+    uint8_t significance = low_first ? word : (uint8_t)(words - 1 - word);
+#ifdef REGS_HOST_BIG_ENDIAN
+    uint8_t slot = (uint8_t)(words - 1 - significance);
+#else
+    uint8_t slot = significance;
+#endif
+
+    memcpy((uint8_t *)value + 2 * slot, &half, sizeof(half));
+}
@@ -0,0 +1,78 @@
+/**
+ * @file reg_codec.h
+ * @brief Bulk big-endian register decoding and typed value assembly
+ *
+ * Register payloads are big-endian 16-bit words. Runs of them are swapped
+ * to host order 16 bytes at a time (SSSE3 PSHUFB, NEON VREV16) or 8 bytes
+ * at a time with a portable SWAR kernel. Multi-register values are built
+ * in place: each register is stored straight into its half-word of the
+ * destination value, so no staging buffer or second pass is needed and a
+ * value split across two responses still comes out whole.
+ */
+
+#ifndef SMARTMODBUS_REG_CODEC_H
+#define SMARTMODBUS_REG_CODEC_H
+
+#include "smartmodbus/mb_types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Decode big-endian registers to host order
+ * @param dst Output registers
+ * @param src Response payload (2 bytes per register, any alignment)
+ * @param count Number of registers
+ */
+void mb_regs_decode(uint16_t *dst, const uint8_t *src, size_t count);
+
+/**
+ * @brief Select the decode kernel
+ * @param enable true for the SIMD kernel where the CPU supports it, false
+ *        for the portable kernel
+ * @return true if a SIMD kernel is in use
+ */
+bool mb_regs_use_simd(bool enable);
+
+/**
+ * @brief Encode host-order registers as a big-endian payload
+ * @param dst Payload (2 bytes per register, any alignment)
+ * @param src Registers
+ * @param count Number of registers
+ */
+void mb_regs_encode(uint8_t *dst, const uint16_t *src, size_t count);
+
+/**
+ * @brief Registers occupied by a value type
+ * @param type Value type
+ * @return 1, 2 or 4, or 0 for an unknown type
+ */
+uint8_t mb_value_registers(mb_value_type_t type);
+
+/**
+ * @brief Store one register of a typed value
+ * @param value Destination value (may be unaligned)
+ * @param type Value type
+ * @param order Word/byte order of the value on the wire
+ * @param word Position of the register within the value (0 = first on the wire)
+ * @param raw Register as received, already in host order
+ *
+ * Once every register of the value has been stored, value holds the host
+ * representation (two's complement integer or IEEE 754 float).
+ */
+void mb_value_store_register(void *value,
+                             mb_value_type_t type,
+                             mb_word_order_t order,
+                             uint8_t word,
+                             uint16_t raw);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_REG_CODEC_H
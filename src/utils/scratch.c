@@ -0,0 +1,73 @@
+/**
+ * @file scratch.c
+ * @brief Scratch arena allocator implementation
+ */
+
+#include "scratch.h"
+
+#include <stdlib.h>
+
+static int scratch_attached(const mb_scratch_t *scratch) {
+    return scratch != NULL && scratch->base != NULL;
+}
+
+void mb_scratch_init(mb_scratch_t *scratch, void *buffer, size_t size) {
+    if (scratch == NULL) {
+        return;
+    }
+
+    scratch->base       = (uint8_t *)buffer;
+    scratch->size       = (buffer != NULL) ? size : 0;
+    scratch->used       = 0;
+    scratch->high_water = 0;
+}
+
+void *mb_scratch_acquire(mb_scratch_t *scratch, size_t size) {
+    if (!scratch_attached(scratch)) {
+#ifdef MB_USE_STATIC_MEMORY
+        (void)size;
+        return NULL;
+#else
+        return malloc(size > 0 ? size : 1);
+#endif
+    }
+
+    // Align relative to the buffer address so any caller buffer works
+    uintptr_t address = (uintptr_t)(scratch->base + scratch->used);
+    size_t padding    = (size_t)((MB_SCRATCH_ALIGN - address % MB_SCRATCH_ALIGN) % MB_SCRATCH_ALIGN);
+
+    if (scratch->size - scratch->used < padding ||
+        scratch->size - scratch->used - padding < size) {
+        return NULL;
+    }
+
+    void *ptr = scratch->base + scratch->used + padding;
+    scratch->used += padding + size;
+    if (scratch->used > scratch->high_water) {
+        scratch->high_water = scratch->used;
+    }
+
+    return ptr;
+}
+
+void mb_scratch_release(mb_scratch_t *scratch, void *ptr) {
+    if (scratch_attached(scratch)) {
+        return;
+    }
+
+#ifndef MB_USE_STATIC_MEMORY
+    free(ptr);
+#else
+    (void)ptr;
+#endif
+}
+
+size_t mb_scratch_mark(const mb_scratch_t *scratch) {
+    return scratch_attached(scratch) ? scratch->used : 0;
+}
+
+void mb_scratch_rewind(mb_scratch_t *scratch, size_t mark) {
+    if (scratch_attached(scratch) && mark <= scratch->used) {
+        scratch->used = mark;
+    }
+}
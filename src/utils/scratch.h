@@ -0,0 +1,80 @@
+/**
+ * @file scratch.h
+ * @brief Scratch arena allocator for the optimizer pipeline
+ *
+ * A bump allocator over a caller-supplied buffer. Pipeline stages acquire
+ * their working arrays from the arena and rewind it on exit, so repeated
+ * polls perform no heap traffic. Without an attached arena, acquisitions
+ * fall back to the heap (dynamic memory build only).
+ */
+
+#ifndef SMARTMODBUS_SCRATCH_H
+#define SMARTMODBUS_SCRATCH_H
+
+#include "smartmodbus/mb_types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Alignment of every arena allocation in bytes
+ */
+#define MB_SCRATCH_ALIGN 8
+
+/**
+ * @brief Worst-case bytes lost to alignment for n allocations
+ */
+#define MB_SCRATCH_SLACK(n) ((size_t)(n) * (MB_SCRATCH_ALIGN - 1))
+
+/**
+ * @brief Attach a buffer to an arena
+ * @param scratch Arena to initialize
+ * @param buffer Backing buffer (NULL detaches)
+ * @param size Buffer size in bytes
+ */
+void mb_scratch_init(mb_scratch_t *scratch, void *buffer, size_t size);
+
+/**
+ * @brief Acquire working memory
+ * @param scratch Arena (may be NULL or detached)
+ * @param size Requested size in bytes
+ * @return Aligned memory, or NULL if the arena is exhausted or no memory
+ *         source is available
+ *
+ * Draws from the arena when one is attached, otherwise from the heap in the
+ * dynamic memory build. Static builds without an arena get NULL.
+ */
+void *mb_scratch_acquire(mb_scratch_t *scratch, size_t size);
+
+/**
+ * @brief Release memory obtained from mb_scratch_acquire()
+ * @param scratch Arena passed to the matching acquire
+ * @param ptr Memory to release (NULL is ignored)
+ *
+ * Heap memory is freed; arena memory is reclaimed by mb_scratch_rewind().
+ */
+void mb_scratch_release(mb_scratch_t *scratch, void *ptr);
+
+/**
+ * @brief Current arena position
+ * @param scratch Arena (may be NULL)
+ * @return Mark to pass to mb_scratch_rewind()
+ */
+size_t mb_scratch_mark(const mb_scratch_t *scratch);
+
+/**
+ * @brief Reclaim everything acquired since a mark
+ * @param scratch Arena (may be NULL)
+ * @param mark Value from mb_scratch_mark()
+ */
+void mb_scratch_rewind(mb_scratch_t *scratch, size_t mark);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_SCRATCH_H
@@ -0,0 +1,181 @@
+/**
+ * @file work_pool.c
+ * @brief Work-stealing pool implementation
+ *
+ * Each range is guarded by its own mutex: the owner pops one job from the
+ * front, a thief moves the back half of the range into its own. Jobs are
+ * coarse (a whole optimizer run), so a lock per pop costs nothing
+ * measurable and keeps the stealing rule obvious.
+ */
+
+#include "work_pool.h"
+
+#include "smartmodbus/mb_config.h"
+#include "smartmodbus/mb_error.h"
+
+#include <pthread.h>
+
+/**
+ * @brief Jobs [next, end) still queued for one worker
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    uint32_t next;
+    uint32_t end;
+} work_range_t;
+
+typedef struct {
+    work_range_t ranges[MB_MAX_PLANNER_THREADS];
+    uint8_t workers;
+    mb_work_fn_t fn;
+    void *context;
+
+    pthread_mutex_t failure_lock;
+    uint32_t failed_job; /**< Lowest failed job (UINT32_MAX = none) */
+    int failed_result;
+} work_pool_t;
+
+typedef struct {
+    work_pool_t *pool;
+    uint8_t index;
+} work_worker_t;
+
+/**
+ * @brief Pop the front job of a worker's own range
+ */
+static int take_own(work_range_t *range, uint32_t *job) {
+    int found = 0;
+    pthread_mutex_lock(&range->lock);
+    if (range->next < range->end) {
+        *job  = range->next++;
+        found = 1;
+    }
+    pthread_mutex_unlock(&range->lock);
+    return found;
+}
+
+/**
+ * @brief Move the back half of another worker's range into our own
+ */
+static int steal(work_pool_t *pool, uint8_t thief) {
+    for (uint8_t k = 1; k < pool->workers; k++) {
+        work_range_t *victim = &pool->ranges[(thief + k) % pool->workers];
+
+        pthread_mutex_lock(&victim->lock);
+        uint32_t queued = victim->end - victim->next;
+        uint32_t end    = victim->end;
+        uint32_t first  = end - (queued + 1) / 2;
+        if (queued > 0) {
+            victim->end = first;
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        if (queued > 0) {
+            work_range_t *own = &pool->ranges[thief];
+            pthread_mutex_lock(&own->lock);
+            own->next = first;
+            own->end  = end;
+            pthread_mutex_unlock(&own->lock);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void run_job(work_pool_t *pool, uint8_t worker, uint32_t job) {
+    // A job past the lowest failure cannot change the result
+    pthread_mutex_lock(&pool->failure_lock);
+    uint32_t failed_job = pool->failed_job;
+    pthread_mutex_unlock(&pool->failure_lock);
+    if (job > failed_job) {
+        return;
+    }
+
+    int result = pool->fn(pool->context, worker, job);
+    if (result != MB_SUCCESS) {
+        pthread_mutex_lock(&pool->failure_lock);
+        if (job < pool->failed_job) {
+            pool->failed_job    = job;
+            pool->failed_result = result;
+        }
+        pthread_mutex_unlock(&pool->failure_lock);
+    }
+}
+
+static void *worker_main(void *arg) {
+    const work_worker_t *worker = (const work_worker_t *)arg;
+    work_pool_t *pool           = worker->pool;
+    uint32_t job                = 0;
+
+    do {
+        while (take_own(&pool->ranges[worker->index], &job)) {
+            run_job(pool, worker->index, job);
+        }
+    } while (steal(pool, worker->index));
+
+    return NULL;
+}
+
+int mb_work_run(uint32_t job_count, uint8_t workers, mb_work_fn_t fn, void *context) {
+    if (fn == NULL) {
+        return MB_ERROR_INVALID_PARAM;
+    }
+
+    if (workers > MB_MAX_PLANNER_THREADS) {
+        workers = MB_MAX_PLANNER_THREADS;
+    }
+    if (workers > job_count) {
+        workers = (uint8_t)job_count;
+    }
+
+    // Nothing to share: run in order on the calling thread
+    if (workers <= 1) {
+        for (uint32_t job = 0; job < job_count; job++) {
+            int result = fn(context, 0, job);
+            if (result != MB_SUCCESS) {
+                return result;
+            }
+        }
+        return MB_SUCCESS;
+    }
+
+    work_pool_t pool;
+    pool.workers       = workers;
+    pool.fn            = fn;
+    pool.context       = context;
+    pool.failed_job    = UINT32_MAX;
+    pool.failed_result = MB_SUCCESS;
+    pthread_mutex_init(&pool.failure_lock, NULL);
+
+    for (uint8_t w = 0; w < workers; w++) {
+        pthread_mutex_init(&pool.ranges[w].lock, NULL);
+        pool.ranges[w].next = (uint32_t)((uint64_t)job_count * w / workers);
+        pool.ranges[w].end  = (uint32_t)((uint64_t)job_count * (w + 1u) / workers);
+    }
+
+    work_worker_t contexts[MB_MAX_PLANNER_THREADS];
+    pthread_t threads[MB_MAX_PLANNER_THREADS];
+    int started[MB_MAX_PLANNER_THREADS] = {0};
+    for (uint8_t w = 0; w < workers; w++) {
+        contexts[w].pool  = &pool;
+        contexts[w].index = w;
+        if (w > 0) {
+            started[w] = pthread_create(&threads[w], NULL, worker_main, &contexts[w]) == 0;
+        }
+    }
+
+    (void)worker_main(&contexts[0]);
+
+    for (uint8_t w = 1; w < workers; w++) {
+        if (started[w]) {
+            pthread_join(threads[w], NULL);
+        }
+    }
+
+    for (uint8_t w = 0; w < workers; w++) {
+        pthread_mutex_destroy(&pool.ranges[w].lock);
+    }
+    pthread_mutex_destroy(&pool.failure_lock);
+
+    return pool.failed_result;
+}
@@ -0,0 +1,52 @@
+/**
+ * @file work_pool.h
+ * @brief Work-stealing pool for independent indexed jobs
+ *
+ * Jobs 0..n-1 are split into one contiguous range per worker. A worker
+ * takes jobs from the front of its own range; once that is empty it steals
+ * the back half of another worker's range. The calling thread is worker 0,
+ * the others are POSIX threads that live for one mb_work_run() call.
+ * Only built with MB_ENABLE_PARALLEL_PLANNER (dynamic memory builds with
+ * threads); callers keep a serial path for every other build.
+ */
+
+#ifndef SMARTMODBUS_WORK_POOL_H
+#define SMARTMODBUS_WORK_POOL_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Job callback
+ * @param context Caller context
+ * @param worker Index of the worker running the job (0..workers-1)
+ * @param job Job index
+ * @return 0 on success, negative error code on failure
+ *
+ * Jobs of one run execute concurrently and in no particular order, so the
+ * callback must only write state owned by its job or its worker.
+ */
+typedef int (*mb_work_fn_t)(void *context, uint8_t worker, uint32_t job);
+
+/**
+ * @brief Run every job on a pool of workers
+ * @param job_count Number of jobs
+ * @param workers Worker count including the calling thread (0 or 1 = serial)
+ * @param fn Job callback
+ * @param context Passed to every call of fn
+ * @return 0 when every job succeeded, otherwise the error of the lowest
+ *         failed job index (the same job a serial loop would stop at)
+ *
+ * Returns once all jobs have finished. Workers that cannot be started
+ * leave their range to be stolen, so every job still runs exactly once.
+ */
+int mb_work_run(uint32_t job_count, uint8_t workers, mb_work_fn_t fn, void *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SMARTMODBUS_WORK_POOL_H
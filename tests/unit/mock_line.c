@@ -0,0 +1,161 @@
+/**
+ * @file mock_line.c
+ * @brief Mock Modbus line shared by the master-level unit tests
+ */
+
+#include "mock_line.h"
+#include "unity.h"
+#include "protocol/frame_builder.h"
+
+#include <string.h>
+
+void mock_line_attach(mock_line_t *line, mb_config_t *config) {
+    config->transport.send    = mock_line_send;
+    config->transport.recv    = mock_line_recv;
+    config->transport.context = line;
+}
+
+static void frame_response(mock_line_t *line, uint8_t fc, const uint8_t *data, uint16_t length) {
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_build_frame(line->unit, fc, data, length, line->mode, line->tid,
+                                     line->response, sizeof(line->response),
+                                     &line->response_length));
+}
+
+void mock_line_exception(mock_line_t *line, uint8_t code) {
+    frame_response(line, (uint8_t)(line->fc | 0x80), &code, 1);
+}
+
+static uint16_t value_of(mock_line_t *line, uint16_t address) {
+    return line->value != NULL ? line->value(line, address) : address;
+}
+
+static void answer(mock_line_t *line) {
+    uint8_t resp[252];
+    uint16_t pos = 0;
+
+    if (line->fc <= MB_FC_READ_DISCRETE_INPUTS) {
+        resp[pos++] = (uint8_t)((line->quantity + 7) / 8);
+        memset(&resp[1], 0, resp[0]);
+        for (uint16_t i = 0; i < line->quantity; i++) {
+            if (value_of(line, (uint16_t)(line->start + i)) & 1) {
+                resp[1 + i / 8] |= (uint8_t)(1u << (i % 8));
+            }
+        }
+        pos = (uint16_t)(pos + resp[0]);
+    } else if (line->fc <= MB_FC_READ_INPUT_REGISTERS ||
+               line->fc == MB_FC_READ_WRITE_MULTIPLE_REGISTERS) {
+        resp[pos++] = (uint8_t)(line->quantity * 2);
+        for (uint16_t i = 0; i < line->quantity; i++) {
+            uint16_t value = value_of(line, (uint16_t)(line->start + i));
+            resp[pos++]    = (uint8_t)(value >> 8);
+            resp[pos++]    = (uint8_t)value;
+        }
+    } else {
+        // Write responses echo address and value/quantity
+        memcpy(resp, line->pdu, 4);
+        pos = 4;
+    }
+    frame_response(line, line->fc, resp, pos);
+}
+
+void mock_line_deliver(mock_line_t *line, const uint8_t *frame, uint16_t len) {
+    TEST_ASSERT_TRUE(line->rx_length + len <= sizeof(line->rx));
+    TEST_ASSERT_TRUE(line->frame_count < MOCK_LINE_FRAMES);
+    memcpy(&line->rx[line->rx_length], frame, len);
+    line->rx_length += len;
+    line->frame_lengths[line->frame_count++] = len;
+}
+
+int mock_line_send(void *ctx, const uint8_t *data, size_t len) {
+    mock_line_t *line = (mock_line_t *)ctx;
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_parse_frame(data, (uint16_t)len, line->mode, &line->tid,
+                                                 &line->unit, &line->fc, line->pdu,
+                                                 &line->pdu_length));
+    line->start    = (uint16_t)((line->pdu[0] << 8) | line->pdu[1]);
+    line->quantity = (uint16_t)((line->pdu[2] << 8) | line->pdu[3]);
+    if (line->requests < MOCK_LINE_LOG) {
+        line->units[line->requests]  = line->unit;
+        line->fcs[line->requests]    = line->fc;
+        line->starts[line->requests] = line->start;
+        line->tids[line->requests]   = line->tid;
+    }
+    line->requests++;
+    if (line->fc == MB_FC_READ_HOLDING_REGISTERS || line->fc == MB_FC_READ_INPUT_REGISTERS) {
+        line->registers_read = (uint16_t)(line->registers_read + line->quantity);
+    }
+
+    line->response_length = 0;
+    if (line->respond == NULL || !line->respond(line, data, len)) {
+        answer(line);
+    }
+    if (line->silent) {
+        line->response_length = 0;
+    }
+    if (line->sent != NULL) {
+        line->sent(line, len);
+    }
+
+    if (!line->queue) {
+        line->rx_length   = 0;
+        line->frame_count = 0;
+    }
+    if (line->response_length > 0) {
+        mock_line_deliver(line, line->response, line->response_length);
+    }
+    return (int)len;
+}
+
+/**
+ * @brief Drop n bytes from the head of the receive stream
+ */
+static void consume(mock_line_t *line, size_t n) {
+    line->rx_length -= n;
+    memmove(line->rx, &line->rx[n], line->rx_length);
+
+    uint16_t done = 0;
+    while (n > 0) {
+        size_t part = n < line->frame_lengths[done] ? n : line->frame_lengths[done];
+        line->frame_lengths[done] = (uint16_t)(line->frame_lengths[done] - part);
+        n -= part;
+        if (line->frame_lengths[done] == 0) {
+            done++;
+        }
+    }
+    line->frame_count = (uint16_t)(line->frame_count - done);
+    memmove(line->frame_lengths, &line->frame_lengths[done],
+            line->frame_count * sizeof(line->frame_lengths[0]));
+}
+
+int mock_line_recv(void *ctx, uint8_t *buffer, size_t max_len, size_t *received) {
+    mock_line_t *line = (mock_line_t *)ctx;
+
+    if (line->receiving != NULL) {
+        line->receiving(line, max_len);
+    }
+
+    size_t n = line->rx_length < max_len ? line->rx_length : max_len;
+    if (line->chunk > 0 && n > line->chunk) {
+        n = line->chunk;
+    }
+    if (line->split_frames && line->frame_count > 0 && n > line->frame_lengths[0]) {
+        n = line->frame_lengths[0];
+    }
+
+    if (line->received != NULL) {
+        line->received(line, n);
+    }
+    memcpy(buffer, line->rx, n);
+    consume(line, n);
+    *received = n;
+    return n > 0 || line->nonblocking ? 0 : MB_ERROR_TIMEOUT;
+}
+
+uint32_t mock_line_clock(void *ctx) {
+    return ((mock_line_t *)ctx)->clock_us;
+}
+
+void mock_line_set_timeout(void *ctx, uint32_t timeout_ms) {
+    ((mock_line_t *)ctx)->timeout_ms = timeout_ms;
+}
@@ -0,0 +1,113 @@
+/**
+ * @file mock_line.h
+ * @brief Mock Modbus line shared by the master-level unit tests
+ *
+ * send() parses the request and frames the response in the line's mode
+ * (RTU by default, ASCII or TCP/MBAP with the request's transaction ID).
+ * The response then goes to the receive stream that recv() reads from. By
+ * default it replaces whatever was left unread, the way a blocking slave
+ * answers one request at a time, and a recv() with nothing to return times
+ * out. With queue set it is appended instead, as from a pipelining TCP
+ * slave; chunk, split_frames and nonblocking shape delivery.
+ *
+ * Unless a test hooks in, the slaves answer register reads (FC23 included)
+ * with value() of each address, bit reads with its lowest bit, and echo the address and
+ * value/quantity of writes. Faults, timing, reordering and other
+ * test-specific behaviour go in the hooks.
+ */
+
+#ifndef SMARTMODBUS_MOCK_LINE_H
+#define SMARTMODBUS_MOCK_LINE_H
+
+#include "smartmodbus/smartmodbus.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Requests whose unit, function code, address and transaction ID
+ *        are logged
+ */
+#define MOCK_LINE_LOG 64
+
+/**
+ * @brief Frames the receive stream holds
+ */
+#define MOCK_LINE_FRAMES 32
+
+typedef struct mock_line mock_line_t;
+
+struct mock_line {
+    mb_mode_t mode; /**< Framing (MB_MODE_RTU when zeroed) */
+
+    // Last request
+    uint8_t unit;
+    uint8_t fc;
+    uint16_t tid;      /**< Transaction ID (TCP) */
+    uint16_t start;    /**< Starting address */
+    uint16_t quantity; /**< Quantity, or the value of a single write */
+    uint8_t pdu[252];  /**< Request PDU data after the function code */
+    uint16_t pdu_length;
+
+    // Traffic so far
+    uint16_t requests;
+    uint16_t registers_read;        /**< Quantities of all register reads */
+    uint8_t units[MOCK_LINE_LOG];   /**< Unit of each request */
+    uint8_t fcs[MOCK_LINE_LOG];     /**< Function code of each request */
+    uint16_t starts[MOCK_LINE_LOG]; /**< Starting address of each request */
+    uint16_t tids[MOCK_LINE_LOG];   /**< Transaction ID of each request */
+
+    // Response to the last request, delivered after the sent() hook
+    uint8_t response[600];
+    uint16_t response_length; /**< 0 = no response */
+    bool silent;              /**< Leave every request unanswered */
+
+    // Receive stream
+    uint8_t rx[4096];
+    size_t rx_length;
+    uint16_t frame_lengths[MOCK_LINE_FRAMES]; /**< Unread bytes of each frame in rx */
+    uint16_t frame_count;
+    bool queue;        /**< Append responses instead of replacing the unread ones */
+    size_t chunk;      /**< Most bytes per recv() (0 = no limit) */
+    bool split_frames; /**< recv() never returns bytes of two frames */
+    bool nonblocking;  /**< An empty recv() returns 0 bytes instead of timing out */
+
+    uint32_t clock_us;   /**< Read by mock_line_clock() */
+    uint32_t timeout_ms; /**< Written by mock_line_set_timeout() */
+
+    /** Register value of an address (NULL = the address) */
+    uint16_t (*value)(mock_line_t *line, uint16_t address);
+    /** Answer the request instead of the slaves; false = answer as usual */
+    bool (*respond)(mock_line_t *line, const uint8_t *frame, size_t len);
+    /** Called once the response is framed, e.g. to drop, hold or corrupt it */
+    void (*sent)(mock_line_t *line, size_t len);
+    /** Called by recv() before it reads the stream, e.g. to release held frames */
+    void (*receiving)(mock_line_t *line, size_t max_len);
+    /** Called by recv() with the bytes it returns (0 when the stream is empty) */
+    void (*received)(mock_line_t *line, size_t len);
+};
+
+/**
+ * @brief Route config's send/recv through a (zeroed) line
+ *
+ * clock_us and set_timeout are left to the tests that want them.
+ */
+void mock_line_attach(mock_line_t *line, mb_config_t *config);
+
+int mock_line_send(void *ctx, const uint8_t *data, size_t len);
+int mock_line_recv(void *ctx, uint8_t *buffer, size_t max_len, size_t *received);
+uint32_t mock_line_clock(void *ctx);
+void mock_line_set_timeout(void *ctx, uint32_t timeout_ms);
+
+/**
+ * @brief Frame an exception response to the last request
+ */
+void mock_line_exception(mock_line_t *line, uint8_t code);
+
+/**
+ * @brief Append a frame to the receive stream
+ */
+void mock_line_deliver(mock_line_t *line, const uint8_t *frame, uint16_t len);
+
+#endif  // SMARTMODBUS_MOCK_LINE_H
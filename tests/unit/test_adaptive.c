@@ -0,0 +1,206 @@
+/**
+ * @file test_adaptive.c
+ * @brief Unit tests for deadband-driven adaptive poll rates
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+#include "mock_line.h"
+
+#include <string.h>
+
+static mock_line_t line;
+static uint16_t drift;
+static mb_master_t master;
+static mb_adaptive_group_t groups[4];
+static mb_adaptive_t poller;
+
+static uint16_t reported_groups[8];
+static uint16_t reported_changes;
+static uint16_t report_calls;
+
+// Slaves answer FC03 with slave * 1000 + address + drift
+static uint16_t drifting_value(mock_line_t *l, uint16_t address) {
+    return (uint16_t)(l->unit * 1000 + address + drift);
+}
+
+static void on_change(void *ctx, uint16_t group, const mb_change_t *changes, uint16_t count) {
+    (void)ctx;
+    (void)changes;
+    if (report_calls < 8) {
+        reported_groups[report_calls] = group;
+    }
+    report_calls++;
+    reported_changes = (uint16_t)(reported_changes + count);
+}
+
+void setUp(void) {
+    memset(&line, 0, sizeof(line));
+    line.value = drifting_value;
+    drift      = 0;
+    memset(reported_groups, 0, sizeof(reported_groups));
+    reported_changes = 0;
+    report_calls     = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_adaptive_init(&poller, groups, 4, on_change, NULL));
+
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    mock_line_attach(&line, &config);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+}
+
+void tearDown(void) {
+    mb_master_cleanup(&master);
+}
+
+static const mb_tag_t meter[] = {{1, MB_FC_READ_HOLDING_REGISTERS, 10},
+                                 {1, MB_FC_READ_HOLDING_REGISTERS, 11},
+                                 {1, MB_FC_READ_HOLDING_REGISTERS, 12}};
+static const mb_tag_t drive[] = {{1, MB_FC_READ_HOLDING_REGISTERS, 13},
+                                 {1, MB_FC_READ_HOLDING_REGISTERS, 14}};
+
+void test_quiet_group_backs_off_to_max_period(void) {
+    uint16_t data[3];
+    uint16_t last[3];
+    uint32_t wait = 0;
+    TEST_ASSERT_EQUAL(0, mb_adaptive_add(&poller, meter, 3, data, last, NULL, 100, 400));
+    mb_adaptive_start(&poller, 0);
+
+    // The first read reports every tag and keeps the fast rate
+    TEST_ASSERT_EQUAL(1, mb_adaptive_poll(&master, &poller, 0, &wait));
+    TEST_ASSERT_EQUAL_UINT16(1011, data[1]);
+    TEST_ASSERT_EQUAL_UINT16(3, reported_changes);
+    TEST_ASSERT_EQUAL_UINT32(100, wait);
+
+    // Not due yet: no traffic
+    TEST_ASSERT_EQUAL(0, mb_adaptive_poll(&master, &poller, 99, &wait));
+    TEST_ASSERT_EQUAL_UINT16(1, line.requests);
+    TEST_ASSERT_EQUAL_UINT32(1, wait);
+
+    TEST_ASSERT_EQUAL(1, mb_adaptive_poll(&master, &poller, 100, &wait));
+    TEST_ASSERT_EQUAL_UINT32(200, wait);
+    TEST_ASSERT_EQUAL(1, mb_adaptive_poll(&master, &poller, 300, &wait));
+    TEST_ASSERT_EQUAL_UINT32(400, wait);
+    TEST_ASSERT_EQUAL(1, mb_adaptive_poll(&master, &poller, 700, &wait));
+    TEST_ASSERT_EQUAL_UINT32(400, wait);
+    TEST_ASSERT_EQUAL_UINT16(4, line.requests);
+    TEST_ASSERT_EQUAL_UINT16(3, reported_changes);
+    TEST_ASSERT_EQUAL_UINT32(4, groups[0].reads);
+}
+
+void test_change_past_deadband_restores_min_period(void) {
+    uint16_t data[3];
+    uint16_t last[3];
+    const uint16_t deadband[3] = {3, 3, 3};
+    uint32_t wait              = 0;
+    TEST_ASSERT_EQUAL(0, mb_adaptive_add(&poller, meter, 3, data, last, deadband, 100, 800));
+    mb_adaptive_start(&poller, 0);
+
+    TEST_ASSERT_EQUAL(1, mb_adaptive_poll(&master, &poller, 0, &wait));
+    TEST_ASSERT_EQUAL(1, mb_adaptive_poll(&master, &poller, 100, &wait));
+    TEST_ASSERT_EQUAL_UINT32(200, wait);
+
+    // Within the deadband: values are stored, the rate keeps backing off
+    drift = 2;
+    TEST_ASSERT_EQUAL(1, mb_adaptive_poll(&master, &poller, 300, &wait));
+    TEST_ASSERT_EQUAL_UINT16(1012, data[0]);
+    TEST_ASSERT_EQUAL_UINT32(400, wait);
+    TEST_ASSERT_EQUAL_UINT16(3, reported_changes);
+
+    drift = 5;
+    TEST_ASSERT_EQUAL(1, mb_adaptive_poll(&master, &poller, 700, &wait));
+    TEST_ASSERT_EQUAL_UINT32(100, wait);
+    TEST_ASSERT_EQUAL_UINT16(6, reported_changes);
+    TEST_ASSERT_EQUAL_UINT32(100, groups[0].period_ms);
+
+    // A restart reports everything again
+    mb_adaptive_start(&poller, 750);
+    TEST_ASSERT_EQUAL(1, mb_adaptive_poll(&master, &poller, 750, &wait));
+    TEST_ASSERT_EQUAL_UINT16(9, reported_changes);
+}
+
+void test_due_groups_share_one_batch(void) {
+    uint16_t a[3];
+    uint16_t a_last[3];
+    uint16_t b[2];
+    uint16_t b_last[2];
+    uint32_t wait = 0;
+    TEST_ASSERT_EQUAL(0, mb_adaptive_add(&poller, meter, 3, a, a_last, NULL, 100, 100));
+    TEST_ASSERT_EQUAL(1, mb_adaptive_add(&poller, drive, 2, b, b_last, NULL, 50, 50));
+    mb_adaptive_start(&poller, 0);
+
+    // 10-14 of both groups merge into one request
+    TEST_ASSERT_EQUAL(2, mb_adaptive_poll(&master, &poller, 0, &wait));
+    TEST_ASSERT_EQUAL_UINT16(1, line.requests);
+    TEST_ASSERT_EQUAL_UINT32(1, poller.batches);
+    TEST_ASSERT_EQUAL_UINT32(5, poller.tags_read);
+    TEST_ASSERT_EQUAL_UINT16(1012, a[2]);
+    TEST_ASSERT_EQUAL_UINT16(1014, b[1]);
+    TEST_ASSERT_EQUAL_UINT16(2, report_calls);
+    TEST_ASSERT_EQUAL_UINT16(0, reported_groups[0]);
+    TEST_ASSERT_EQUAL_UINT16(1, reported_groups[1]);
+    TEST_ASSERT_EQUAL_UINT32(50, wait);
+
+    // Only the faster group is due
+    TEST_ASSERT_EQUAL(1, mb_adaptive_poll(&master, &poller, 50, &wait));
+    TEST_ASSERT_EQUAL_UINT32(7, poller.tags_read);
+    TEST_ASSERT_EQUAL_UINT32(2, groups[1].reads);
+    TEST_ASSERT_EQUAL_UINT32(1, groups[0].reads);
+    TEST_ASSERT_EQUAL_UINT32(50, wait);
+}
+
+void test_failed_batch_retries_at_min_period(void) {
+    uint16_t data[3];
+    uint16_t last[3];
+    uint32_t wait = 0;
+    TEST_ASSERT_EQUAL(0, mb_adaptive_add(&poller, meter, 3, data, last, NULL, 100, 400));
+    mb_adaptive_start(&poller, 0);
+    TEST_ASSERT_EQUAL(1, mb_adaptive_poll(&master, &poller, 0, &wait));
+    TEST_ASSERT_EQUAL(1, mb_adaptive_poll(&master, &poller, 100, &wait));
+    TEST_ASSERT_EQUAL_UINT32(200, groups[0].period_ms);
+
+    line.silent = true;
+    TEST_ASSERT_EQUAL(MB_ERROR_TIMEOUT, mb_adaptive_poll(&master, &poller, 300, &wait));
+    TEST_ASSERT_EQUAL_UINT32(1, groups[0].errors);
+    TEST_ASSERT_EQUAL_UINT32(2, groups[0].reads);
+    TEST_ASSERT_EQUAL_UINT32(100, wait);
+
+    line.silent = false;
+    TEST_ASSERT_EQUAL(1, mb_adaptive_poll(&master, &poller, 400, &wait));
+    TEST_ASSERT_EQUAL_UINT16(3, reported_changes);
+}
+
+void test_add_rejects_bad_groups(void) {
+    uint16_t data[3];
+    uint16_t last[3];
+
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_adaptive_add(&poller, meter, 3, data, last, NULL, 0, 100));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_adaptive_add(&poller, meter, 3, data, last, NULL, 200, 100));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_adaptive_add(&poller, meter, 0, data, last, NULL, 100, 100));
+
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(i, mb_adaptive_add(&poller, meter, 3, data, last, NULL, 100, 100));
+    }
+    TEST_ASSERT_EQUAL(MB_ERROR_TOO_MANY_BLOCKS,
+                      mb_adaptive_add(&poller, meter, 3, data, last, NULL, 100, 100));
+
+    // No groups: nothing to wait for
+    uint32_t wait = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_adaptive_init(&poller, groups, 4, NULL, NULL));
+    TEST_ASSERT_EQUAL(0, mb_adaptive_poll(&master, &poller, 0, &wait));
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, wait);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_quiet_group_backs_off_to_max_period);
+    RUN_TEST(test_change_past_deadband_restores_min_period);
+    RUN_TEST(test_due_groups_share_one_batch);
+    RUN_TEST(test_failed_batch_retries_at_min_period);
+    RUN_TEST(test_add_rejects_bad_groups);
+
+    return UNITY_END();
+}
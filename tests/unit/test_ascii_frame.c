@@ -7,6 +7,8 @@
 #include "protocol/ascii_frame.h"
 #include "smartmodbus/mb_error.h"
 
+#include <string.h>
+
 void setUp(void) {
 }
 
@@ -80,6 +82,79 @@ void test_ascii_calc_frame_length(void) {
     TEST_ASSERT_EQUAL_UINT16(17, length);
 }
 
+void test_ascii_encode_inplace_matches_build(void) {
+    uint8_t pdu[] = {0x00, 0x6B, 0x00, 0x03, 0xFE};
+    uint8_t expected[32];
+    uint8_t frame[32];
+
+    int built = mb_ascii_build_frame(0x11, 0x03, pdu, 5, expected, sizeof(expected));
+
+    memcpy(&frame[MB_ASCII_PDU_OFFSET], pdu, 5);
+    int encoded = mb_ascii_encode_inplace(0x11, 0x03, 5, frame, sizeof(frame));
+
+    TEST_ASSERT_EQUAL(built, encoded);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, frame, (size_t)built);
+}
+
+void test_ascii_parse_view_decodes_in_place(void) {
+    uint8_t frame[] = ":010300000002FA\r\n";
+    uint8_t slave_id, fc;
+    const uint8_t *pdu = NULL;
+    uint16_t pdu_length;
+
+    int result = mb_ascii_parse_view(frame, 17, &slave_id, &fc, &pdu, &pdu_length);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, result);
+    TEST_ASSERT_EQUAL_UINT8(0x01, slave_id);
+    TEST_ASSERT_EQUAL_UINT8(0x03, fc);
+    TEST_ASSERT_EQUAL_PTR(&frame[MB_ASCII_PDU_OFFSET], pdu);
+    TEST_ASSERT_EQUAL_UINT16(4, pdu_length);
+    TEST_ASSERT_EQUAL_HEX8(0x02, pdu[3]);
+
+    uint8_t bad[] = ":010300000002FB\r\n";
+    TEST_ASSERT_EQUAL(MB_ERROR_LRC_MISMATCH,
+                      mb_ascii_parse_view(bad, 17, &slave_id, &fc, &pdu, &pdu_length));
+}
+
+void test_ascii_round_trips_full_pdu(void) {
+    uint8_t pdu[252];
+    uint8_t frame[520];
+    for (uint16_t i = 0; i < 252; i++) {
+        pdu[i] = (uint8_t)(i + 4);
+    }
+
+    int built = mb_ascii_build_frame(0x00, 0x03, pdu, 252, frame, sizeof(frame));
+    TEST_ASSERT_EQUAL(mb_ascii_calc_frame_length(252), built);
+
+    uint8_t slave_id, fc;
+    uint8_t decoded[252];
+    uint16_t pdu_length;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_ascii_parse_frame(frame, (uint16_t)built, &slave_id, &fc,
+                                                       decoded, &pdu_length));
+    TEST_ASSERT_EQUAL_UINT16(252, pdu_length);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(pdu, decoded, 252);
+}
+
+void test_ascii_parse_accepts_lower_case_and_rejects_non_hex(void) {
+    uint8_t lower[] = ":010300fe0002fc\r\n";
+    uint8_t slave_id, fc;
+    uint8_t pdu[8];
+    uint16_t pdu_length;
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_ascii_parse_frame(lower, 17, &slave_id, &fc, pdu, &pdu_length));
+    TEST_ASSERT_EQUAL_HEX8(0xFE, pdu[1]);
+
+    // A non-hex character anywhere in the PDU or LRC
+    for (uint16_t pos = 5; pos < 15; pos++) {
+        uint8_t bad[sizeof(lower)];
+        memcpy(bad, lower, sizeof(lower));
+        bad[pos] = 'G';
+        TEST_ASSERT_EQUAL(MB_ERROR_INVALID_FRAME,
+                          mb_ascii_parse_frame(bad, 17, &slave_id, &fc, pdu, &pdu_length));
+    }
+}
+
 int main(void) {
     UNITY_BEGIN();
 
@@ -89,6 +164,10 @@ int main(void) {
     RUN_TEST(test_ascii_parse_frame_invalid_lrc);
     RUN_TEST(test_ascii_parse_frame_missing_start);
     RUN_TEST(test_ascii_calc_frame_length);
+    RUN_TEST(test_ascii_encode_inplace_matches_build);
+    RUN_TEST(test_ascii_parse_view_decodes_in_place);
+    RUN_TEST(test_ascii_round_trips_full_pdu);
+    RUN_TEST(test_ascii_parse_accepts_lower_case_and_rejects_non_hex);
 
     return UNITY_END();
 }
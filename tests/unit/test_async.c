@@ -0,0 +1,286 @@
+/**
+ * @file test_async.c
+ * @brief Unit tests for non-blocking poll execution
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+#include "mock_line.h"
+
+#include <string.h>
+
+/**
+ * @brief Non-blocking slave answering reads with register value == address
+ *
+ * send() accepts at most send_limit bytes per call and the line's chunk
+ * caps each recv(), so frames cross step boundaries. With hold set, TCP
+ * responses are withheld until `hold` requests arrived and then released
+ * in reverse order.
+ */
+typedef struct {
+    size_t send_limit;
+    bool exception; // Answer everything but writes with exception 0x02
+    uint16_t hold;
+
+    uint8_t request[64];
+    size_t request_length;
+
+    uint8_t held[8][260];
+    uint16_t held_length[8];
+    uint16_t held_count;
+} async_slave_t;
+
+static mock_line_t line;
+static async_slave_t slave;
+
+static size_t request_frame_chars(mb_mode_t mode) {
+    return mode == MB_MODE_TCP ? 12 : (mode == MB_MODE_RTU ? 8 : 17);
+}
+
+static bool answer_exception(mock_line_t *l, const uint8_t *frame, size_t len) {
+    (void)frame;
+    (void)len;
+    if (!slave.exception || l->fc == MB_FC_WRITE_SINGLE_REGISTER) {
+        return false;
+    }
+    mock_line_exception(l, 0x02);
+    return true;
+}
+
+static void hold_response(mock_line_t *l, size_t len) {
+    (void)len;
+    if (slave.hold == 0 || l->response_length == 0) {
+        return;
+    }
+
+    memcpy(slave.held[slave.held_count], l->response, l->response_length);
+    slave.held_length[slave.held_count++] = l->response_length;
+    l->response_length                    = 0;
+    if (slave.held_count == slave.hold) {
+        while (slave.held_count > 0) {
+            slave.held_count--;
+            mock_line_deliver(l, slave.held[slave.held_count],
+                              slave.held_length[slave.held_count]);
+        }
+    }
+}
+
+static int mock_send(void *ctx, const uint8_t *data, size_t len) {
+    size_t n = len < slave.send_limit ? len : slave.send_limit;
+
+    memcpy(&slave.request[slave.request_length], data, n);
+    slave.request_length += n;
+    if (slave.request_length == request_frame_chars(line.mode)) {
+        mock_line_send(ctx, slave.request, slave.request_length);
+        slave.request_length = 0;
+    }
+    return (int)n;
+}
+
+static mb_master_t master;
+static mb_poll_plan_t poll;
+static mb_async_op_t op;
+
+static int done_calls;
+static int done_result;
+
+static void on_done(void *ctx, int result) {
+    TEST_ASSERT_EQUAL_PTR(&op, ctx);
+    done_calls++;
+    done_result = result;
+}
+
+static uint16_t addresses[] = {2000, 1, 0, 1000, 1001, 2};
+static const mb_read_request_t request = {.slave_id      = 1,
+                                          .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                          .addresses     = addresses,
+                                          .address_count = 6};
+
+static void init_master(mb_mode_t mode, uint8_t max_in_flight) {
+    line.mode                = mode;
+    mb_config_t config       = mb_config_default(mode);
+    mock_line_attach(&line, &config);
+    config.transport.send    = mock_send;
+    config.timeout_ms        = 1000;
+    config.max_in_flight     = max_in_flight;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile(&master, &request, &poll));
+}
+
+/**
+ * @brief Step at a fixed time until done, bounded to catch livelock
+ */
+static int run_to_completion(uint32_t now_ms) {
+    int result = MB_SUCCESS;
+    for (int i = 0; i < 1000 && op.state == MB_ASYNC_BUSY; i++) {
+        result = mb_async_step(&op, now_ms);
+    }
+    return result;
+}
+
+void setUp(void) {
+    memset(&line, 0, sizeof(line));
+    memset(&slave, 0, sizeof(slave));
+    line.queue       = true;
+    line.nonblocking = true;
+    line.respond     = answer_exception;
+    line.sent        = hold_response;
+    slave.send_limit = 1024;
+    done_calls       = 0;
+    done_result      = 1;
+}
+
+void tearDown(void) {
+    mb_poll_plan_free(&poll);
+}
+
+void test_rtu_poll_survives_short_writes_and_split_reads(void) {
+    init_master(MB_MODE_RTU, 1);
+    slave.send_limit = 5;
+    line.chunk       = 3;
+
+    uint16_t data[6];
+    memset(data, 0, sizeof(data));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_submit_poll(&master, &op, &poll, data, 6, on_done, &op));
+    TEST_ASSERT_EQUAL(MB_ASYNC_BUSY, op.state);
+    TEST_ASSERT_EQUAL(MB_ASYNC_WANT_WRITE, mb_async_interest(&op));
+    TEST_ASSERT_EQUAL(0, line.requests);
+
+    // First request: 5 of 8 bytes accepted, 3 response bytes per step
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_async_step(&op, 0));
+    TEST_ASSERT_EQUAL(MB_ASYNC_WANT_WRITE, mb_async_interest(&op) & MB_ASYNC_WANT_WRITE);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, run_to_completion(0));
+    TEST_ASSERT_EQUAL(MB_ASYNC_DONE, op.state);
+    TEST_ASSERT_EQUAL(1, done_calls);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, done_result);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 6);
+    TEST_ASSERT_EQUAL(3, line.requests);
+    TEST_ASSERT_EQUAL(0, mb_async_interest(&op));
+    TEST_ASSERT_EQUAL_UINT32(1, master.stats.optimized_requests);
+    TEST_ASSERT_EQUAL_UINT32(3, master.stats.total_requests);
+}
+
+void test_tcp_pipelines_and_matches_out_of_order_responses(void) {
+    init_master(MB_MODE_TCP, 4);
+    TEST_ASSERT_EQUAL_UINT16(3, poll.plan_count);
+    slave.hold = 3;
+
+    uint16_t data[6];
+    memset(data, 0, sizeof(data));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_submit_poll(&master, &op, &poll, data, 6, on_done, &op));
+
+    // All three requests leave in one step; responses come back reversed
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_async_step(&op, 0));
+    TEST_ASSERT_EQUAL(3, line.requests);
+    TEST_ASSERT_EQUAL(MB_ASYNC_DONE, op.state);
+    TEST_ASSERT_EQUAL(1, done_calls);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, done_result);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 6);
+}
+
+void test_ascii_poll_frames_on_crlf(void) {
+    init_master(MB_MODE_ASCII, 1);
+    line.chunk = 1;
+
+    uint16_t data[6];
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_submit_poll(&master, &op, &poll, data, 6, NULL, NULL));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, run_to_completion(0));
+    TEST_ASSERT_EQUAL(MB_ASYNC_DONE, op.state);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 6);
+}
+
+void test_silent_slave_times_out_at_deadline(void) {
+    init_master(MB_MODE_RTU, 1);
+    line.silent = true;
+
+    uint16_t data[6];
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_submit_poll(&master, &op, &poll, data, 6, on_done, &op));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_async_step(&op, 0xFFFFFF00u));
+    TEST_ASSERT_EQUAL(MB_ASYNC_WANT_READ, mb_async_interest(&op));
+
+    // Deadline wraps past zero
+    uint32_t deadline = 0;
+    TEST_ASSERT_TRUE(mb_async_next_deadline(&op, &deadline));
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFF00u + 1000u, deadline);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_async_step(&op, deadline - 1));
+    TEST_ASSERT_EQUAL(0, done_calls);
+    TEST_ASSERT_EQUAL(MB_ERROR_TIMEOUT, mb_async_step(&op, deadline));
+    TEST_ASSERT_EQUAL(1, done_calls);
+    TEST_ASSERT_EQUAL(MB_ERROR_TIMEOUT, done_result);
+
+    // Finished operations stay finished
+    TEST_ASSERT_EQUAL(MB_ERROR_TIMEOUT, mb_async_step(&op, deadline + 1));
+    TEST_ASSERT_EQUAL(1, done_calls);
+    TEST_ASSERT_EQUAL(1, line.requests);
+}
+
+void test_rtu_exception_is_framed_by_its_own_length(void) {
+    init_master(MB_MODE_RTU, 1);
+    slave.exception = true;
+    line.chunk      = 2;
+
+    uint16_t data[6];
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_submit_poll(&master, &op, &poll, data, 6, on_done, &op));
+    TEST_ASSERT_EQUAL(MB_ERROR_EXCEPTION_RESPONSE, run_to_completion(0));
+    TEST_ASSERT_EQUAL(1, done_calls);
+    TEST_ASSERT_EQUAL(MB_ERROR_EXCEPTION_RESPONSE, done_result);
+}
+
+void test_write_register_verifies_echo(void) {
+    init_master(MB_MODE_RTU, 1);
+    line.chunk = 3;
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_submit_write_single_register(&master, &op, 1, 40, 0x1234,
+                                                                         on_done, &op));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, run_to_completion(0));
+    TEST_ASSERT_EQUAL(1, done_calls);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, done_result);
+    TEST_ASSERT_EQUAL(1, line.requests);
+    TEST_ASSERT_EQUAL_UINT32(0, master.stats.optimized_requests);
+
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_QUANTITY,
+                      mb_master_submit_write_multiple_registers(&master, &op, 1, 0, 124, addresses,
+                                                                NULL, NULL));
+}
+
+void test_submit_validates_and_cancel_resets(void) {
+    init_master(MB_MODE_RTU, 1);
+
+    uint16_t data[6];
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_master_submit_poll(&master, NULL, &poll, data, 6, NULL, NULL));
+    TEST_ASSERT_EQUAL(MB_ERROR_BUFFER_TOO_SMALL,
+                      mb_master_submit_poll(&master, &op, &poll, data, 5, NULL, NULL));
+
+    master.config.mode = MB_MODE_TCP;
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_master_submit_poll(&master, &op, &poll, data, 6, NULL, NULL));
+    master.config.mode = MB_MODE_RTU;
+
+    line.silent = true;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_submit_poll(&master, &op, &poll, data, 6, on_done, &op));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_async_step(&op, 0));
+    mb_async_cancel(&op);
+
+    uint32_t deadline = 0;
+    TEST_ASSERT_EQUAL(MB_ASYNC_IDLE, op.state);
+    TEST_ASSERT_FALSE(mb_async_next_deadline(&op, &deadline));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_async_step(&op, 5000));
+    TEST_ASSERT_EQUAL(0, done_calls);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_rtu_poll_survives_short_writes_and_split_reads);
+    RUN_TEST(test_tcp_pipelines_and_matches_out_of_order_responses);
+    RUN_TEST(test_ascii_poll_frames_on_crlf);
+    RUN_TEST(test_silent_slave_times_out_at_deadline);
+    RUN_TEST(test_rtu_exception_is_framed_by_its_own_length);
+    RUN_TEST(test_write_register_verifies_echo);
+    RUN_TEST(test_submit_validates_and_cancel_resets);
+
+    return UNITY_END();
+}
@@ -0,0 +1,123 @@
+/**
+ * @file test_bitset.c
+ * @brief Unit tests for packed bit copy and gather
+ */
+
+#include "unity.h"
+#include "utils/bitset.h"
+
+#include <string.h>
+
+static uint8_t response[250];
+
+/**
+ * @brief Response bit at offset, as the per-bit scatter reads it
+ */
+static uint32_t response_bit(uint16_t offset) {
+    return (uint32_t)(response[offset >> 3] >> (offset & 7)) & 1u;
+}
+
+static uint32_t bitset_bit(const uint32_t *bits, uint32_t index) {
+    return (bits[index >> 5] >> (index & 31)) & 1u;
+}
+
+void setUp(void) {
+    // Deterministic, irregular bit pattern
+    uint32_t state = 0x12345678u;
+    for (size_t i = 0; i < sizeof(response); i++) {
+        state       = state * 1103515245u + 12345u;
+        response[i] = (uint8_t)(state >> 16);
+    }
+}
+
+void tearDown(void) {
+    (void)mb_bits_use_pext(true);
+}
+
+void test_copy_keeps_bits_outside_the_run(void) {
+    for (uint32_t src_bit = 0; src_bit < 9; src_bit++) {
+        for (uint32_t dst_bit = 0; dst_bit < 40; dst_bit += 3) {
+            uint32_t bits[8];
+            memset(bits, 0xA5, sizeof(bits));
+            uint32_t before[8];
+            memcpy(before, bits, sizeof(bits));
+
+            mb_bits_copy(bits, dst_bit, response, src_bit, 150);
+
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t expected = (i >= dst_bit && i < dst_bit + 150)
+                                        ? response_bit((uint16_t)(src_bit + i - dst_bit))
+                                        : bitset_bit(before, i);
+                TEST_ASSERT_EQUAL_UINT32(expected, bitset_bit(bits, i));
+            }
+        }
+    }
+}
+
+/**
+ * @brief Gather with both kernels and compare with the per-bit definition
+ */
+static void check_gather(const mb_scatter_entry_t *entries, uint16_t count) {
+    const bool kernels[] = {false, true};
+
+    for (size_t k = 0; k < 2; k++) {
+        (void)mb_bits_use_pext(kernels[k]);
+
+        uint32_t bits[64];
+        memset(bits, 0, sizeof(bits));
+        mb_bits_gather(bits, response, entries, count);
+
+        for (uint16_t i = 0; i < count; i++) {
+            TEST_ASSERT_EQUAL_UINT32(response_bit(entries[i].offset),
+                                     bitset_bit(bits, entries[i].dest_index));
+        }
+    }
+}
+
+void test_gather_contiguous_run(void) {
+    mb_scatter_entry_t entries[300];
+    for (uint16_t i = 0; i < 300; i++) {
+        entries[i].plan_index = 0;
+        entries[i].offset     = (uint16_t)(5 + i);
+        entries[i].dest_index = (uint16_t)(33 + i);
+    }
+    check_gather(entries, 300);
+}
+
+void test_gather_sparse_bits(void) {
+    // Every third coil, and a stride that crosses the 57-bit window
+    mb_scatter_entry_t entries[200];
+    for (uint16_t i = 0; i < 100; i++) {
+        entries[i].plan_index = 0;
+        entries[i].offset     = (uint16_t)(i * 3 + 1);
+        entries[i].dest_index = (uint16_t)(7 + i);
+    }
+    for (uint16_t i = 100; i < 200; i++) {
+        entries[i].plan_index = 0;
+        entries[i].offset     = (uint16_t)(1000 + (i - 100) * 9);
+        entries[i].dest_index = (uint16_t)(107 + i);
+    }
+    check_gather(entries, 200);
+}
+
+void test_gather_unordered_destinations(void) {
+    // Request order unrelated to the response layout
+    mb_scatter_entry_t entries[64];
+    for (uint16_t i = 0; i < 64; i++) {
+        entries[i].plan_index = 0;
+        entries[i].offset     = (uint16_t)((i * 37) % 500);
+        entries[i].dest_index = (uint16_t)((i * 11) % 64);
+    }
+    check_gather(entries, 64);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_copy_keeps_bits_outside_the_run);
+    RUN_TEST(test_gather_contiguous_run);
+    RUN_TEST(test_gather_sparse_bits);
+    RUN_TEST(test_gather_unordered_destinations);
+
+    return UNITY_END();
+}
@@ -57,6 +57,89 @@ void test_addresses_to_blocks_unsorted(void) {
     TEST_ASSERT_EQUAL_UINT16(2, block_count);
 }
 
+void test_addresses_to_blocks_merges_duplicates(void) {
+    uint16_t addresses[] = {7, 5, 6, 5, 7, 9};
+    mb_block_t blocks[10];
+    uint16_t block_count = 0;
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_addresses_to_blocks(addresses, 6, 1,
+                                                         MB_FC_READ_HOLDING_REGISTERS, blocks,
+                                                         10, &block_count));
+    TEST_ASSERT_EQUAL_UINT16(2, block_count);
+    TEST_ASSERT_EQUAL_UINT16(5, blocks[0].start_address);
+    TEST_ASSERT_EQUAL_UINT16(3, blocks[0].quantity);
+    TEST_ASSERT_EQUAL_UINT16(9, blocks[1].start_address);
+    TEST_ASSERT_EQUAL_UINT16(1, blocks[1].quantity);
+}
+
+void test_addresses_to_blocks_dense_runs_cross_words(void) {
+    // Dense enough for the bitmap: runs ending on, before and past 64-bit
+    // word boundaries, up to the top of the address space
+    static uint16_t addresses[2000];
+    uint16_t count = 0;
+    for (uint32_t a = 65535; a >= 64000; a--) {
+        if (a % 100 != 63 && a % 100 != 64) {
+            addresses[count++] = (uint16_t)a;
+        }
+    }
+
+    // Static builds take a request this large only with an arena
+    static uint8_t arena[4096];
+    mb_scratch_t scratch;
+    mb_scratch_init(&scratch, arena, sizeof(arena));
+
+    static mb_block_t blocks[100];
+    uint16_t block_count = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_addresses_to_blocks_scratch(addresses, count, 1,
+                                                                 MB_FC_READ_HOLDING_REGISTERS,
+                                                                 blocks, 100, &block_count,
+                                                                 &scratch));
+
+    // Rebuild the address set from the blocks and compare
+    uint32_t covered = 0;
+    for (uint16_t i = 0; i < block_count; i++) {
+        if (i > 0) {
+            TEST_ASSERT_TRUE((uint32_t)blocks[i - 1].start_address + blocks[i - 1].quantity <
+                             blocks[i].start_address);
+        }
+        for (uint32_t a = blocks[i].start_address;
+             a < (uint32_t)blocks[i].start_address + blocks[i].quantity; a++) {
+            TEST_ASSERT_TRUE(a % 100 != 63 && a % 100 != 64);
+            covered++;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(count, covered);
+    TEST_ASSERT_EQUAL_UINT16(65535, blocks[block_count - 1].start_address +
+                                        blocks[block_count - 1].quantity - 1);
+
+    TEST_ASSERT_EQUAL(MB_ERROR_TOO_MANY_BLOCKS,
+                      mb_addresses_to_blocks_scratch(addresses, count, 1,
+                                                     MB_FC_READ_HOLDING_REGISTERS, blocks, 10,
+                                                     &block_count, &scratch));
+}
+
+void test_sort_by_quantity_is_stable(void) {
+    mb_block_t blocks[40];
+    for (uint16_t i = 0; i < 40; i++) {
+        blocks[i].slave_id      = 1;
+        blocks[i].function_code = MB_FC_READ_COILS;
+        blocks[i].start_address = i;
+        blocks[i].quantity      = (uint16_t)((i % 4) * 300 + 1);
+        blocks[i].is_merged     = false;
+    }
+
+    mb_block_sort_by_quantity_desc(blocks, 40);
+
+    for (uint16_t i = 1; i < 40; i++) {
+        TEST_ASSERT_TRUE(blocks[i - 1].quantity >= blocks[i].quantity);
+        if (blocks[i - 1].quantity == blocks[i].quantity) {
+            TEST_ASSERT_TRUE(blocks[i - 1].start_address < blocks[i].start_address);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT16(901, blocks[0].quantity);
+    TEST_ASSERT_EQUAL_UINT16(3, blocks[0].start_address);
+}
+
 void test_calc_gap_between_blocks(void) {
     mb_block_t block_a = {.start_address = 100, .quantity = 3};
     mb_block_t block_b = {.start_address = 105, .quantity = 3};
@@ -95,6 +178,9 @@ int main(void) {
     RUN_TEST(test_addresses_to_blocks_contiguous);
     RUN_TEST(test_addresses_to_blocks_non_contiguous);
     RUN_TEST(test_addresses_to_blocks_unsorted);
+    RUN_TEST(test_addresses_to_blocks_merges_duplicates);
+    RUN_TEST(test_addresses_to_blocks_dense_runs_cross_words);
+    RUN_TEST(test_sort_by_quantity_is_stable);
     RUN_TEST(test_calc_gap_between_blocks);
     RUN_TEST(test_calc_gap_between_blocks_adjacent);
     RUN_TEST(test_blocks_are_compatible_same_slave_fc);
@@ -0,0 +1,182 @@
+/**
+ * @file test_bus_scheduler.c
+ * @brief Unit tests for the rate-monotonic bus scheduler
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+#include "mock_line.h"
+
+#include <string.h>
+
+#define BAUD    19200u
+#define CHAR_US 573u  // 11 bits at 19200 bit/s, rounded up
+
+static mock_line_t line;
+
+/**
+ * @brief Advance the simulated clock by the line occupancy of a transaction:
+ *        request + response + gap (4) + latency (2) characters
+ */
+static void occupy_line(mock_line_t *l, size_t len) {
+    l->clock_us += (uint32_t)(len + l->response_length + 6u) * CHAR_US;
+}
+
+static mb_master_t master;
+static mb_bus_t bus;
+static mb_bus_group_t groups[3];
+static mb_poll_plan_t fast_poll;
+static mb_poll_plan_t slow_poll;
+static uint16_t fast_data[1];
+static uint16_t slow_data[40];
+
+// One register and two 20-register blocks. The cost model predicts 19 and
+// 57 chars (11 ms, 33 ms); the mock line takes 21 and 59 (13 ms, 34 ms).
+static uint16_t fast_addresses[1] = {0};
+static uint16_t slow_addresses[40];
+
+static void compile(mb_poll_plan_t *poll, uint16_t *addresses, uint16_t count) {
+    mb_read_request_t request = {.slave_id      = 1,
+                                 .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                 .addresses     = addresses,
+                                 .address_count = count};
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile(&master, &request, poll));
+}
+
+/**
+ * @brief Drive the bus on the simulated clock until end_ms
+ */
+static void run_until(uint32_t end_ms) {
+    for (int i = 0; i < 10000; i++) {
+        uint32_t now = line.clock_us / 1000u;
+        if (now >= end_ms) {
+            return;
+        }
+        uint32_t wait = 0;
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_bus_poll(&bus, now, &wait));
+        line.clock_us += wait * 1000u;
+    }
+    TEST_FAIL_MESSAGE("bus did not reach end time");
+}
+
+void setUp(void) {
+    memset(&line, 0, sizeof(line));
+    for (uint16_t i = 0; i < 20; i++) {
+        slow_addresses[i]      = (uint16_t)(100 + i);
+        slow_addresses[20 + i] = (uint16_t)(300 + i);
+    }
+
+    line.sent = occupy_line;
+
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    mock_line_attach(&line, &config);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_bus_init(&bus, &master, groups, 3, BAUD));
+
+    compile(&fast_poll, fast_addresses, 1);
+    compile(&slow_poll, slow_addresses, 40);
+    TEST_ASSERT_EQUAL_UINT16(2, slow_poll.plan_count);
+}
+
+void tearDown(void) {
+    mb_poll_plan_free(&fast_poll);
+    mb_poll_plan_free(&slow_poll);
+}
+
+void test_groups_are_prioritized_by_period(void) {
+    TEST_ASSERT_EQUAL(0, mb_bus_add_group(&bus, &slow_poll, slow_data, 40, 500));
+    TEST_ASSERT_EQUAL(0, mb_bus_add_group(&bus, &fast_poll, fast_data, 1, 50));
+
+    TEST_ASSERT_EQUAL_PTR(&fast_poll, groups[0].poll);
+    TEST_ASSERT_EQUAL_PTR(&slow_poll, groups[1].poll);
+    TEST_ASSERT_EQUAL_UINT32(19 * CHAR_US, groups[0].cost_us);
+    TEST_ASSERT_EQUAL_UINT32(2 * 57 * CHAR_US, groups[1].cost_us);
+}
+
+void test_analyze_predicts_line_load(void) {
+    mb_bus_load_t load;
+    mb_bus_add_group(&bus, &fast_poll, fast_data, 1, 50);
+    mb_bus_add_group(&bus, &slow_poll, slow_data, 40, 500);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_bus_analyze(&bus, &load));
+    TEST_ASSERT_EQUAL_UINT32(218 + 131, load.utilization_permille);
+    TEST_ASSERT_EQUAL_UINT32(828, load.bound_permille);
+    TEST_ASSERT_EQUAL_UINT32(57 * CHAR_US, load.max_request_us);
+    TEST_ASSERT_EQUAL(MB_BUS_SCHEDULABLE, load.verdict);
+
+    // The slow plan polled every 40 ms alone needs 2 × 33 ms per period
+    mb_bus_add_group(&bus, &slow_poll, slow_data, 40, 40);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_bus_analyze(&bus, &load));
+    TEST_ASSERT_EQUAL(MB_BUS_OVERSUBSCRIBED, load.verdict);
+}
+
+void test_slow_reads_fill_idle_gaps(void) {
+    mb_bus_add_group(&bus, &fast_poll, fast_data, 1, 50);
+    mb_bus_add_group(&bus, &slow_poll, slow_data, 40, 500);
+
+    mb_bus_start(&bus, 0);
+    run_until(1000);
+
+    // 0: alarm, 13: first slow block fits the 37 ms gap, 47: the second
+    // does not fit before the release at 50, so the alarm goes first
+    TEST_ASSERT_EQUAL_UINT16(0, line.starts[0]);
+    TEST_ASSERT_EQUAL_UINT16(100, line.starts[1]);
+    TEST_ASSERT_EQUAL_UINT16(0, line.starts[2]);
+    TEST_ASSERT_EQUAL_UINT16(300, line.starts[3]);
+
+    TEST_ASSERT_EQUAL_UINT32(20, groups[0].completed);
+    TEST_ASSERT_EQUAL_UINT32(0, groups[0].overruns);
+    TEST_ASSERT_EQUAL_UINT32(2, groups[1].completed);
+    TEST_ASSERT_EQUAL_UINT32(0, groups[1].overruns);
+    TEST_ASSERT_EQUAL_UINT32(0, groups[1].errors);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(slow_addresses, slow_data, 40);
+}
+
+void test_starved_group_runs_before_its_deadline(void) {
+    mb_bus_load_t load;
+    mb_bus_add_group(&bus, &fast_poll, fast_data, 1, 20);
+    mb_bus_add_group(&bus, &slow_poll, slow_data, 40, 200);
+
+    // A 33 ms request can never fit the 7 ms gaps of a 20 ms group
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_bus_analyze(&bus, &load));
+    TEST_ASSERT_EQUAL(MB_BUS_AT_RISK, load.verdict);
+
+    mb_bus_start(&bus, 0);
+    run_until(200);
+
+    TEST_ASSERT_EQUAL_UINT32(1, groups[1].completed);
+    TEST_ASSERT_EQUAL_UINT32(0, groups[1].overruns);
+    TEST_ASSERT_TRUE(groups[0].overruns > 0);
+}
+
+void test_rejects_invalid_configuration(void) {
+    uint32_t wait = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_bus_poll(&bus, 0, &wait));
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, wait);
+
+    TEST_ASSERT_EQUAL(MB_ERROR_BUFFER_TOO_SMALL,
+                      mb_bus_add_group(&bus, &slow_poll, slow_data, 39, 100));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_bus_add_group(&bus, &fast_poll, fast_data, 1, 0));
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(i, mb_bus_add_group(&bus, &fast_poll, fast_data, 1, 100));
+    }
+    TEST_ASSERT_EQUAL(MB_ERROR_TOO_MANY_BLOCKS, mb_bus_add_group(&bus, &fast_poll, fast_data, 1, 100));
+
+    mb_master_t tcp;
+    mb_config_t config = mb_config_default(MB_MODE_TCP);
+    config.transport   = master.config.transport;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&tcp, &config));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_bus_init(&bus, &tcp, groups, 3, BAUD));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_groups_are_prioritized_by_period);
+    RUN_TEST(test_analyze_predicts_line_load);
+    RUN_TEST(test_slow_reads_fill_idle_gaps);
+    RUN_TEST(test_starved_group_runs_before_its_deadline);
+    RUN_TEST(test_rejects_invalid_configuration);
+
+    return UNITY_END();
+}
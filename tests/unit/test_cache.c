@@ -0,0 +1,157 @@
+/**
+ * @file test_cache.c
+ * @brief Unit tests for the shared read-through value cache
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+#include "mock_line.h"
+
+#include <string.h>
+
+static mock_line_t line;
+static mb_master_t master;
+static mb_cache_entry_t entries[8];
+static mb_cache_t cache;
+
+// Slaves answer FC03 with slave * 1000 + address
+static uint16_t slave_value(mock_line_t *l, uint16_t address) {
+    return (uint16_t)(l->unit * 1000 + address);
+}
+
+void setUp(void) {
+    memset(&line, 0, sizeof(line));
+    line.value = slave_value;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_cache_init(&cache, entries, 8));
+
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    mock_line_attach(&line, &config);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+}
+
+void tearDown(void) {
+    mb_master_cleanup(&master);
+}
+
+static const mb_tag_t meter[] = {{1, MB_FC_READ_HOLDING_REGISTERS, 10},
+                                 {1, MB_FC_READ_HOLDING_REGISTERS, 11},
+                                 {1, MB_FC_READ_HOLDING_REGISTERS, 12}};
+
+void test_fresh_values_cost_no_bus_traffic(void) {
+    uint16_t data[3];
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_cache_read(&master, &cache, meter, 3, 1000, 5000, data));
+    TEST_ASSERT_EQUAL_UINT16(1, line.requests);
+    TEST_ASSERT_EQUAL_UINT16(1011, data[1]);
+
+    memset(data, 0, sizeof(data));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_cache_read(&master, &cache, meter, 3, 1000, 6000, data));
+    TEST_ASSERT_EQUAL_UINT16(1, line.requests);
+    TEST_ASSERT_EQUAL_UINT16(1010, data[0]);
+    TEST_ASSERT_EQUAL_UINT16(1012, data[2]);
+    TEST_ASSERT_EQUAL_UINT32(3, cache.hits);
+    TEST_ASSERT_EQUAL_UINT32(3, cache.misses);
+
+    // One millisecond past the allowed age
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_cache_read(&master, &cache, meter, 3, 1000, 6001, data));
+    TEST_ASSERT_EQUAL_UINT16(2, line.requests);
+}
+
+void test_stale_tags_of_all_reads_are_merged(void) {
+    const mb_tag_t drive[] = {{1, MB_FC_READ_HOLDING_REGISTERS, 14},
+                              {1, MB_FC_READ_HOLDING_REGISTERS, 12},
+                              {1, MB_FC_READ_HOLDING_REGISTERS, 13},
+                              {2, MB_FC_READ_HOLDING_REGISTERS, 10}};
+    uint16_t a[3];
+    uint16_t b[4];
+    mb_cache_read_t reads[] = {{meter, 3, 100, a}, {drive, 4, 100, b}};
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_cache_read_many(&master, &cache, reads, 2, 0));
+
+    // 10-14 on slave 1 in one frame (12 once), slave 2 in another
+    TEST_ASSERT_EQUAL_UINT32(1, cache.batches);
+    TEST_ASSERT_EQUAL_UINT16(2, line.requests);
+    TEST_ASSERT_EQUAL_UINT16(6, line.registers_read);
+    TEST_ASSERT_EQUAL_UINT16(1012, a[2]);
+    TEST_ASSERT_EQUAL_UINT16(1014, b[0]);
+    TEST_ASSERT_EQUAL_UINT16(1012, b[1]);
+    TEST_ASSERT_EQUAL_UINT16(2010, b[3]);
+
+    // Same ages later: only the read with the tight max-age goes to the bus
+    reads[0].max_age_ms = 1000;
+    reads[1].max_age_ms = 10;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_cache_read_many(&master, &cache, reads, 2, 50));
+    TEST_ASSERT_EQUAL_UINT16(4, line.requests);
+    TEST_ASSERT_EQUAL_UINT32(3, cache.hits);
+}
+
+void test_full_cache_evicts_the_oldest_entry(void) {
+    mb_tag_t tags[12];
+    uint16_t data[12];
+    for (uint16_t i = 0; i < 12; i++) {
+        tags[i].slave_id      = 3;
+        tags[i].function_code = MB_FC_READ_HOLDING_REGISTERS;
+        tags[i].address       = (uint16_t)(100 + i);
+    }
+
+    // More stale tags than entries: read in two batches
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_cache_read(&master, &cache, tags, 12, 100, 0, data));
+    TEST_ASSERT_EQUAL_UINT32(2, cache.batches);
+    for (uint16_t i = 0; i < 12; i++) {
+        TEST_ASSERT_EQUAL_UINT16(3100 + i, data[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT16(8, cache.count);
+
+    // The meter displaces entries read earlier
+    uint16_t m[3];
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_cache_read(&master, &cache, meter, 3, 100, 10, m));
+    TEST_ASSERT_EQUAL_UINT16(8, cache.count);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_cache_read(&master, &cache, meter, 3, 100, 20, m));
+    TEST_ASSERT_EQUAL_UINT32(3, cache.hits);
+    for (uint16_t i = 1; i < cache.count; i++) {
+        TEST_ASSERT_TRUE(entries[i - 1].slave_id < entries[i].slave_id ||
+                         (entries[i - 1].slave_id == entries[i].slave_id &&
+                          entries[i - 1].address < entries[i].address));
+    }
+}
+
+void test_invalidate_forces_a_reread(void) {
+    uint16_t data[3];
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_cache_read(&master, &cache, meter, 3, 1000, 0, data));
+
+    mb_cache_invalidate(&cache, 1, MB_FC_READ_HOLDING_REGISTERS, 11, 12);
+    TEST_ASSERT_EQUAL_UINT16(1, cache.count);
+
+    line.registers_read = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_cache_read(&master, &cache, meter, 3, 1000, 1, data));
+    TEST_ASSERT_EQUAL_UINT16(2, line.registers_read);
+    TEST_ASSERT_EQUAL_UINT16(1011, data[1]);
+}
+
+void test_failed_read_caches_nothing(void) {
+    uint16_t data[3];
+    line.silent = true;
+    TEST_ASSERT_EQUAL(MB_ERROR_TIMEOUT, mb_cache_read(&master, &cache, meter, 3, 1000, 0, data));
+    for (uint16_t i = 0; i < cache.count; i++) {
+        TEST_ASSERT_FALSE(entries[i].valid);
+        TEST_ASSERT_FALSE(entries[i].pending);
+    }
+
+    line.silent   = false;
+    line.requests = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_cache_read(&master, &cache, meter, 3, 1000, 1, data));
+    TEST_ASSERT_EQUAL_UINT16(1, line.requests);
+    TEST_ASSERT_EQUAL_UINT16(1010, data[0]);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_fresh_values_cost_no_bus_traffic);
+    RUN_TEST(test_stale_tags_of_all_reads_are_merged);
+    RUN_TEST(test_full_cache_evicts_the_oldest_entry);
+    RUN_TEST(test_invalidate_forces_a_reread);
+    RUN_TEST(test_failed_read_caches_nothing);
+
+    return UNITY_END();
+}
@@ -0,0 +1,176 @@
+/**
+ * @file test_change.c
+ * @brief Unit tests for report-by-exception change detection
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+
+#include <string.h>
+
+#define TAGS 37  // Two full 16-register strides and a tail
+
+static uint16_t addresses[TAGS];
+static uint16_t values[TAGS];
+static uint16_t last[TAGS];
+static mb_read_request_t request;
+static mb_change_set_t set;
+static mb_change_t changes[TAGS];
+
+void setUp(void) {
+    for (uint16_t i = 0; i < TAGS; i++) {
+        addresses[i] = (uint16_t)(100 + 2 * i);
+        values[i]    = (uint16_t)(i * 10);
+    }
+    request.slave_id      = 4;
+    request.function_code = MB_FC_READ_INPUT_REGISTERS;
+    request.addresses     = addresses;
+    request.address_count = TAGS;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_change_set_init(&set, &request, last, NULL));
+}
+
+void tearDown(void) {
+}
+
+static uint16_t detect(void) {
+    uint16_t count = 0xFFFF;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_change_set_detect(&set, values, changes, TAGS, &count));
+    return count;
+}
+
+void test_first_detection_reports_every_tag(void) {
+    TEST_ASSERT_EQUAL_UINT16(TAGS, detect());
+    for (uint16_t i = 0; i < TAGS; i++) {
+        TEST_ASSERT_EQUAL_UINT16(i, changes[i].index);
+        TEST_ASSERT_EQUAL_UINT8(4, changes[i].slave_id);
+        TEST_ASSERT_EQUAL_UINT8(MB_FC_READ_INPUT_REGISTERS, changes[i].function_code);
+        TEST_ASSERT_EQUAL_UINT16(addresses[i], changes[i].address);
+        TEST_ASSERT_EQUAL_UINT16(values[i], changes[i].value);
+    }
+
+    TEST_ASSERT_EQUAL_UINT16(0, detect());
+}
+
+void test_only_changed_tags_are_listed(void) {
+    detect();
+
+    // Ends of strides, the start of the next one and the tail
+    const uint16_t moved[] = {0, 15, 16, 31, 32, 36};
+    for (uint16_t k = 0; k < 6; k++) {
+        values[moved[k]]++;
+    }
+
+    TEST_ASSERT_EQUAL_UINT16(6, detect());
+    for (uint16_t k = 0; k < 6; k++) {
+        TEST_ASSERT_EQUAL_UINT16(moved[k], changes[k].index);
+        TEST_ASSERT_EQUAL_UINT16(values[moved[k]], changes[k].value);
+        TEST_ASSERT_EQUAL_UINT16((uint16_t)(values[moved[k]] - 1), changes[k].previous);
+    }
+    TEST_ASSERT_EQUAL_UINT16(0, detect());
+}
+
+void test_deadband_reports_drift_against_last_report(void) {
+    uint16_t deadband[TAGS];
+    for (uint16_t i = 0; i < TAGS; i++) {
+        deadband[i] = 5;
+    }
+    deadband[1] = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_change_set_init(&set, &request, last, deadband));
+    detect();
+
+    // Tag 1 has no deadband; tag 2 creeps up by 3 per cycle
+    values[1]++;
+    values[2] += 3;
+    TEST_ASSERT_EQUAL_UINT16(1, detect());
+    TEST_ASSERT_EQUAL_UINT16(1, changes[0].index);
+
+    values[2] += 3;
+    TEST_ASSERT_EQUAL_UINT16(1, detect());
+    TEST_ASSERT_EQUAL_UINT16(2, changes[0].index);
+    TEST_ASSERT_EQUAL_UINT16(20, changes[0].previous);
+    TEST_ASSERT_EQUAL_UINT16(26, changes[0].value);
+
+    // Signed values crossing zero are close, not 65535 apart
+    values[0] = 0xFFFE;  // -2 from 0
+    TEST_ASSERT_EQUAL_UINT16(0, detect());
+    values[0] = 0xFFF0;  // -16
+    TEST_ASSERT_EQUAL_UINT16(1, detect());
+}
+
+void test_full_change_list_resumes_on_next_call(void) {
+    uint16_t count = 0;
+    TEST_ASSERT_EQUAL(MB_ERROR_BUFFER_TOO_SMALL,
+                      mb_change_set_detect(&set, values, changes, 20, &count));
+    TEST_ASSERT_EQUAL_UINT16(20, count);
+    TEST_ASSERT_EQUAL_UINT16(19, changes[19].index);
+
+    // The rest of the first report, plus a change among the reported tags
+    values[3]++;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_change_set_detect(&set, values, changes, 20, &count));
+    TEST_ASSERT_EQUAL_UINT16(1 + TAGS - 20, count);
+    TEST_ASSERT_EQUAL_UINT16(3, changes[0].index);
+    TEST_ASSERT_EQUAL_UINT16(20, changes[1].index);
+    TEST_ASSERT_EQUAL_UINT16(TAGS - 1, changes[count - 1].index);
+
+    for (uint16_t i = 0; i < TAGS; i += 3) {
+        values[i]++;
+    }
+    TEST_ASSERT_EQUAL(MB_ERROR_BUFFER_TOO_SMALL,
+                      mb_change_set_detect(&set, values, changes, 5, &count));
+    TEST_ASSERT_EQUAL_UINT16(5, count);
+    TEST_ASSERT_EQUAL_UINT16(12, changes[4].index);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_change_set_detect(&set, values, changes, 20, &count));
+    TEST_ASSERT_EQUAL_UINT16((TAGS + 2) / 3 - 5, count);
+    TEST_ASSERT_EQUAL_UINT16(15, changes[0].index);
+}
+
+void test_batch_tags_supply_keys_and_reset_reports_all(void) {
+    const mb_tag_t tags[] = {{1, MB_FC_READ_HOLDING_REGISTERS, 10},
+                             {2, MB_FC_READ_COILS, 7},
+                             {1, MB_FC_READ_INPUT_REGISTERS, 30}};
+    uint16_t tag_values[] = {5, 1, 9};
+    uint16_t tag_last[3];
+    uint16_t count = 0;
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_change_set_init_tags(&set, tags, 3, tag_last, NULL));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_change_set_detect(&set, tag_values, changes, 3, &count));
+    TEST_ASSERT_EQUAL_UINT16(3, count);
+
+    tag_values[1] = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_change_set_detect(&set, tag_values, changes, 3, &count));
+    TEST_ASSERT_EQUAL_UINT16(1, count);
+    TEST_ASSERT_EQUAL_UINT8(2, changes[0].slave_id);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_READ_COILS, changes[0].function_code);
+    TEST_ASSERT_EQUAL_UINT16(7, changes[0].address);
+    TEST_ASSERT_EQUAL_UINT16(1, changes[0].previous);
+
+    mb_change_set_reset(&set);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_change_set_detect(&set, tag_values, changes, 3, &count));
+    TEST_ASSERT_EQUAL_UINT16(3, count);
+}
+
+void test_invalid_parameters(void) {
+    uint16_t count = 0;
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_change_set_init(&set, NULL, last, NULL));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_change_set_init(&set, &request, NULL, NULL));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_change_set_init_tags(&set, NULL, 3, last, NULL));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_change_set_init(&set, &request, last, NULL));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_change_set_detect(&set, NULL, changes, TAGS, &count));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_change_set_detect(&set, values, changes, TAGS, NULL));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_first_detection_reports_every_tag);
+    RUN_TEST(test_only_changed_tags_are_listed);
+    RUN_TEST(test_deadband_reports_drift_against_last_report);
+    RUN_TEST(test_full_change_list_resumes_on_next_call);
+    RUN_TEST(test_batch_tags_supply_keys_and_reset_reports_all);
+    RUN_TEST(test_invalid_parameters);
+
+    return UNITY_END();
+}
@@ -0,0 +1,243 @@
+/**
+ * @file test_coro.cpp
+ * @brief Unit tests for the C++20 coroutine front-end
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.hpp"
+#include "protocol/frame_builder.h"
+
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief Non-blocking RTU slave: register value == address, writes echoed
+ *
+ * Each master gets its own instance as transport context, so several
+ * coroutines can be in flight on one Loop.
+ */
+struct MockSlave {
+    bool silent = false;
+    uint8_t request[64];
+    size_t request_length = 0;
+    uint16_t requests     = 0;
+    uint16_t last_write   = 0;
+    uint8_t out[300];
+    size_t out_length = 0;
+
+    void answer() {
+        uint8_t unit = 0;
+        uint8_t fc   = 0;
+        uint8_t pdu[252];
+        uint16_t pdu_length = 0;
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_parse_frame(request, static_cast<uint16_t>(request_length),
+                                                     MB_MODE_RTU, nullptr, &unit, &fc, pdu,
+                                                     &pdu_length));
+        requests++;
+        if (silent) {
+            return;
+        }
+
+        uint8_t resp[252];
+        uint16_t pos = 0;
+        if (fc == MB_FC_WRITE_SINGLE_REGISTER) {
+            std::memcpy(resp, pdu, 4);
+            pos        = 4;
+            last_write = static_cast<uint16_t>((pdu[2] << 8) | pdu[3]);
+        } else {
+            uint16_t start = static_cast<uint16_t>((pdu[0] << 8) | pdu[1]);
+            uint16_t qty   = static_cast<uint16_t>((pdu[2] << 8) | pdu[3]);
+            resp[pos++]    = static_cast<uint8_t>(qty * 2);
+            for (uint16_t i = 0; i < qty; i++) {
+                uint16_t value = static_cast<uint16_t>(start + i);
+                resp[pos++]    = static_cast<uint8_t>(value >> 8);
+                resp[pos++]    = static_cast<uint8_t>(value & 0xFF);
+            }
+        }
+
+        uint16_t length = 0;
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_build_frame(unit, fc, resp, pos, MB_MODE_RTU, 0, out,
+                                                     sizeof(out), &length));
+        out_length = length;
+    }
+
+    static int send(void *ctx, const uint8_t *data, size_t len) {
+        auto *self = static_cast<MockSlave *>(ctx);
+        std::memcpy(&self->request[self->request_length], data, len);
+        self->request_length += len;
+        if (self->request_length == 8) {
+            self->answer();
+            self->request_length = 0;
+        }
+        return static_cast<int>(len);
+    }
+
+    // Hands out the response two bytes at a time
+    static int recv(void *ctx, uint8_t *buffer, size_t max_len, size_t *received) {
+        auto *self = static_cast<MockSlave *>(ctx);
+        size_t n   = self->out_length < 2 ? self->out_length : 2;
+        n          = n < max_len ? n : max_len;
+        std::memcpy(buffer, self->out, n);
+        self->out_length -= n;
+        std::memmove(self->out, &self->out[n], self->out_length);
+        *received = n;
+        return 0;
+    }
+};
+
+MockSlave slaves[2];
+mb_master_t masters[2];
+
+uint16_t addresses[]            = {2000, 1, 0, 1000, 1001, 2};
+const mb_read_request_t request = {1, MB_FC_READ_HOLDING_REGISTERS, addresses, 6};
+
+void init_master(int index) {
+    slaves[index]            = MockSlave{};
+    mb_config_t config       = mb_config_default(MB_MODE_RTU);
+    config.transport.send    = &MockSlave::send;
+    config.transport.recv    = &MockSlave::recv;
+    config.transport.context = &slaves[index];
+    config.timeout_ms        = 100;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&masters[index], &config));
+}
+
+template <class T>
+void run(smartmodbus::Loop &loop, smartmodbus::Task<T> &task, uint32_t step_ms = 0) {
+    task.start();
+    uint32_t now = 0;
+    for (int i = 0; i < 1000 && !task.done(); i++) {
+        loop.run_once(now);
+        now += step_ms;
+    }
+    TEST_ASSERT_TRUE(task.done());
+    TEST_ASSERT_TRUE(loop.idle());
+}
+
+smartmodbus::Task<int> read_then_write(smartmodbus::AsyncMaster<smartmodbus::Loop> &master,
+                                       uint16_t *data) {
+    int result = co_await master.read_optimized(request, data, 6);
+    if (result != MB_SUCCESS) {
+        co_return result;
+    }
+    co_return co_await master.write_single_register(1, 300, static_cast<uint16_t>(data[0] + 1));
+}
+
+smartmodbus::Task<int> poll_three_times(smartmodbus::AsyncMaster<smartmodbus::Loop> &master,
+                                        smartmodbus::PollPlan &plan,
+                                        uint16_t *data) {
+    for (int i = 0; i < 3; i++) {
+        int result = co_await master.execute(plan, data, 6);
+        if (result != MB_SUCCESS) {
+            co_return result;
+        }
+    }
+    co_return MB_SUCCESS;
+}
+
+smartmodbus::Task<void> both(smartmodbus::AsyncMaster<smartmodbus::Loop> &a,
+                             smartmodbus::AsyncMaster<smartmodbus::Loop> &b,
+                             uint16_t *data_a,
+                             uint16_t *data_b,
+                             int *results) {
+    // Start both before awaiting either, so they overlap on the loop
+    smartmodbus::Task<int> first  = read_then_write(a, data_a);
+    smartmodbus::Task<int> second = read_then_write(b, data_b);
+    first.start();
+    second.start();
+    results[1] = co_await second;
+    results[0] = co_await first;
+}
+
+}  // namespace
+
+void setUp(void) {
+    init_master(0);
+    init_master(1);
+}
+
+void tearDown(void) {
+}
+
+void test_awaits_read_then_write(void) {
+    smartmodbus::Loop loop;
+    smartmodbus::AsyncMaster<smartmodbus::Loop> master(masters[0], loop);
+
+    uint16_t data[6] = {};
+    smartmodbus::Task<int> task = read_then_write(master, data);
+    run(loop, task);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, task.result());
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 6);
+    TEST_ASSERT_EQUAL_UINT16(2001, slaves[0].last_write);
+    TEST_ASSERT_EQUAL(4, slaves[0].requests);
+}
+
+void test_two_masters_share_one_loop(void) {
+    smartmodbus::Loop loop;
+    smartmodbus::AsyncMaster<smartmodbus::Loop> a(masters[0], loop);
+    smartmodbus::AsyncMaster<smartmodbus::Loop> b(masters[1], loop);
+
+    uint16_t data_a[6] = {};
+    uint16_t data_b[6] = {};
+    int results[2]     = {1, 1};
+    smartmodbus::Task<void> task = both(a, b, data_a, data_b, results);
+    run(loop, task);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, results[0]);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, results[1]);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data_a, 6);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data_b, 6);
+    TEST_ASSERT_EQUAL_INT(4, (int)slaves[0].requests);
+    TEST_ASSERT_EQUAL_INT(4, (int)slaves[1].requests);
+    TEST_ASSERT_EQUAL_UINT16(2001, slaves[0].last_write);
+}
+
+void test_compiled_plan_is_reused(void) {
+    smartmodbus::Loop loop;
+    smartmodbus::AsyncMaster<smartmodbus::Loop> master(masters[0], loop);
+    smartmodbus::PollPlan plan;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, plan.compile(masters[0], request));
+
+    uint16_t data[6] = {};
+    smartmodbus::Task<int> task = poll_three_times(master, plan, data);
+    run(loop, task);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, task.result());
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 6);
+    TEST_ASSERT_EQUAL(9, slaves[0].requests);
+    TEST_ASSERT_EQUAL_UINT32(3, masters[0].stats.optimized_requests);
+}
+
+void test_timeout_and_submit_errors_resume_with_code(void) {
+    smartmodbus::Loop loop;
+    smartmodbus::AsyncMaster<smartmodbus::Loop> master(masters[0], loop);
+    slaves[0].silent = true;
+
+    uint16_t data[6] = {};
+    smartmodbus::Task<int> task = read_then_write(master, data);
+    run(loop, task, 10);
+    TEST_ASSERT_EQUAL(MB_ERROR_TIMEOUT, task.result());
+
+    // Rejected at submission: completes without suspending
+    smartmodbus::PollPlan plan;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, plan.compile(masters[0], request));
+    auto too_small = [&]() -> smartmodbus::Task<int> {
+        co_return co_await master.execute(plan, data, 5);
+    };
+    smartmodbus::Task<int> rejected = too_small();
+    rejected.start();
+    TEST_ASSERT_TRUE(rejected.done());
+    TEST_ASSERT_EQUAL(MB_ERROR_BUFFER_TOO_SMALL, rejected.result());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_awaits_read_then_write);
+    RUN_TEST(test_two_masters_share_one_loop);
+    RUN_TEST(test_compiled_plan_is_reused);
+    RUN_TEST(test_timeout_and_submit_errors_resume_with_code);
+
+    return UNITY_END();
+}
@@ -1,6 +1,6 @@
 /**
  * @file test_cost_model.c
- * @brief Unit tests for character-based cost model
+ * @brief Unit tests for the character- and time-based cost models
  */
 
 #include "unity.h"
@@ -85,6 +85,63 @@ void test_calc_merge_savings_not_beneficial(void) {
     TEST_ASSERT_LESS_THAN(0, savings);
 }
 
+void test_link_rtu_characters_are_eleven_bits(void) {
+    mb_cost_params_t params;
+    mb_link_t link = {.bit_rate = 19200, .parity = MB_PARITY_EVEN};
+
+    // 8E1: start + 8 data + parity + stop = 11 bits of 52.08 us
+    mb_init_link_cost_params(MB_MODE_RTU, MB_FC_READ_HOLDING_REGISTERS, 2, &link, &params);
+    TEST_ASSERT_EQUAL_UINT32(572916, params.byte_ns);
+
+    // Frames of 8 + 5 characters, two 3.5-character silences, 2 latency characters
+    TEST_ASSERT_EQUAL_UINT32(13 * 572916 + 2 * 2005206 + 2 * 572916, params.round_trip_ns);
+    TEST_ASSERT_EQUAL_UINT32(12604, mb_calc_round_trip_cost(&params, 0));
+
+    // No parity defaults to two stop bits; 8N1 must be asked for
+    link.parity = MB_PARITY_NONE;
+    mb_init_link_cost_params(MB_MODE_RTU, MB_FC_READ_HOLDING_REGISTERS, 2, &link, &params);
+    TEST_ASSERT_EQUAL_UINT32(572916, params.byte_ns);
+    link.stop_bits = 1;
+    mb_init_link_cost_params(MB_MODE_RTU, MB_FC_READ_HOLDING_REGISTERS, 2, &link, &params);
+    TEST_ASSERT_EQUAL_UINT32(520833, params.byte_ns);
+}
+
+void test_link_ascii_bytes_cost_two_characters(void) {
+    mb_cost_params_t params;
+    mb_link_t link = {.bit_rate = 9600, .parity = MB_PARITY_EVEN};
+
+    // 7E1 characters, two per data byte, frames of 17 + 11 characters
+    mb_init_link_cost_params(MB_MODE_ASCII, MB_FC_READ_HOLDING_REGISTERS, 2, &link, &params);
+    TEST_ASSERT_EQUAL_UINT32(2 * 1041666, params.byte_ns);
+    TEST_ASSERT_EQUAL_UINT32(30 * 1041666, params.round_trip_ns);
+
+    // A 7-register gap is 14 bytes = 28 characters, still under one round-trip
+    TEST_ASSERT_GREATER_THAN(0, mb_calc_merge_savings(7, MB_FC_READ_HOLDING_REGISTERS, &params));
+    TEST_ASSERT_LESS_THAN(0, mb_calc_merge_savings(8, MB_FC_READ_HOLDING_REGISTERS, &params));
+}
+
+void test_link_tcp_merges_across_cheap_bytes(void) {
+    mb_cost_params_t chars;
+    mb_cost_params_t time;
+    mb_link_t link = {.bit_rate = 100000000, .latency_us = 5000};
+
+    mb_init_cost_params(MB_MODE_TCP, MB_FC_READ_HOLDING_REGISTERS, 1, &chars);
+    mb_init_link_cost_params(MB_MODE_TCP, MB_FC_READ_HOLDING_REGISTERS, 1, &link, &time);
+
+    // 100 registers are 200 bytes: many characters, but 16 us against a 5 ms round-trip
+    TEST_ASSERT_LESS_THAN(0, mb_calc_merge_savings(100, MB_FC_READ_HOLDING_REGISTERS, &chars));
+    TEST_ASSERT_EQUAL_INT32(4998, mb_calc_merge_savings(100, MB_FC_READ_HOLDING_REGISTERS, &time));
+}
+
+void test_link_without_bit_rate_keeps_character_model(void) {
+    mb_cost_params_t params;
+    mb_link_t link = {.latency_us = 5000};
+
+    mb_init_link_cost_params(MB_MODE_RTU, MB_FC_READ_HOLDING_REGISTERS, 2, &link, &params);
+    TEST_ASSERT_EQUAL_UINT32(0, params.byte_ns);
+    TEST_ASSERT_EQUAL_UINT32(17 + 20, mb_calc_round_trip_cost(&params, 20));
+}
+
 int main(void) {
     UNITY_BEGIN();
 
@@ -97,6 +154,10 @@ int main(void) {
     RUN_TEST(test_init_cost_params);
     RUN_TEST(test_calc_merge_savings_beneficial);
     RUN_TEST(test_calc_merge_savings_not_beneficial);
+    RUN_TEST(test_link_rtu_characters_are_eleven_bits);
+    RUN_TEST(test_link_ascii_bytes_cost_two_characters);
+    RUN_TEST(test_link_tcp_merges_across_cheap_bytes);
+    RUN_TEST(test_link_without_bit_rate_keeps_character_model);
 
     return UNITY_END();
 }
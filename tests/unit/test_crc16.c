@@ -11,7 +11,7 @@ void setUp(void) {
 }
 
 void tearDown(void) {
-    // Clean up after each test
+    mb_crc16_set_backend(MB_CRC16_BACKEND_AUTO);
 }
 
 void test_crc16_empty_data(void) {
@@ -80,6 +80,66 @@ void test_crc16_all_ones(void) {
     TEST_ASSERT_NOT_EQUAL(0xFFFF, crc);
 }
 
+void test_crc16_backends_match_table(void) {
+    static const mb_crc16_backend_t backends[] = {MB_CRC16_BACKEND_SLICE4,
+                                                  MB_CRC16_BACKEND_SLICE8,
+                                                  MB_CRC16_BACKEND_CLMUL};
+    static uint8_t data[1100];
+    static uint16_t expected[1024];
+    uint32_t seed = 12345;
+
+    for (size_t i = 0; i < sizeof(data); i++) {
+        seed    = seed * 1103515245u + 12345u;
+        data[i] = (uint8_t)(seed >> 16);
+    }
+
+    // Reference: baseline table over every length, at an odd offset
+    TEST_ASSERT_EQUAL(0, mb_crc16_set_backend(MB_CRC16_BACKEND_TABLE));
+    for (size_t len = 0; len < 1024; len++) {
+        expected[len] = mb_crc16(data + 3, len);
+    }
+
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+        if (!mb_crc16_backend_available(backends[b])) {
+            continue;
+        }
+        TEST_ASSERT_EQUAL(0, mb_crc16_set_backend(backends[b]));
+        TEST_ASSERT_EQUAL(backends[b], mb_crc16_get_backend());
+
+        for (size_t len = 0; len < 1024; len++) {
+            TEST_ASSERT_EQUAL_HEX16(expected[len], mb_crc16(data + 3, len));
+        }
+        TEST_ASSERT_EQUAL_HEX16(0x0BC4, mb_crc16((const uint8_t *)"\x01\x03\x00\x00\x00\x02", 6));
+    }
+}
+
+void test_crc16_incremental_matches_one_shot(void) {
+    uint8_t frame[] = {0x11, 0x03, 0x00, 0x6B, 0x00, 0x03, 0x76, 0x87};
+
+    // Byte at a time
+    uint16_t crc = mb_crc16_init();
+    for (size_t i = 0; i < 6; i++) {
+        crc = mb_crc16_update(crc, &frame[i], 1);
+    }
+    TEST_ASSERT_EQUAL_HEX16(0x8776, mb_crc16_final(crc));
+
+    // Uneven chunks through the CRC bytes leave a zero residue
+    crc = mb_crc16_update(mb_crc16_init(), frame, 5);
+    crc = mb_crc16_update(crc, &frame[5], 3);
+    TEST_ASSERT_EQUAL_HEX16(0x0000, mb_crc16_final(crc));
+}
+
+void test_crc16_backend_selection(void) {
+    TEST_ASSERT_TRUE(mb_crc16_backend_available(MB_CRC16_BACKEND_TABLE));
+    TEST_ASSERT_EQUAL(0, mb_crc16_set_backend(MB_CRC16_BACKEND_AUTO));
+    TEST_ASSERT_NOT_EQUAL(MB_CRC16_BACKEND_AUTO, mb_crc16_get_backend());
+
+    if (!mb_crc16_backend_available(MB_CRC16_BACKEND_CLMUL)) {
+        TEST_ASSERT_NOT_EQUAL(0, mb_crc16_set_backend(MB_CRC16_BACKEND_CLMUL));
+    }
+    TEST_ASSERT_NOT_EQUAL(0, mb_crc16_set_backend((mb_crc16_backend_t)99));
+}
+
 int main(void) {
     UNITY_BEGIN();
 
@@ -92,6 +152,9 @@ int main(void) {
     RUN_TEST(test_crc16_verify_too_short);
     RUN_TEST(test_crc16_all_zeros);
     RUN_TEST(test_crc16_all_ones);
+    RUN_TEST(test_crc16_backends_match_table);
+    RUN_TEST(test_crc16_incremental_matches_one_shot);
+    RUN_TEST(test_crc16_backend_selection);
 
     return UNITY_END();
 }
@@ -80,6 +80,93 @@ void test_ffd_pack_exceeds_max_pdu(void) {
     TEST_ASSERT_EQUAL_UINT16(2, pdu_count);  // Each block in separate PDU
 }
 
+void test_ffd_pack_splits_oversized_block(void) {
+    mb_block_t blocks[] = {
+        {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS,
+         .start_address = 1000, .quantity = 300, .is_merged = false},
+        {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS,
+         .start_address = 1400, .quantity = 10, .is_merged = false}
+    };
+    mb_pdu_t pdus[10];
+    uint16_t pdu_count = 0;
+
+    int ret = mb_ffd_pack(blocks, 2, 253, pdus, 10, &pdu_count);
+
+    // 125 + 125 + 50; the small block is too far away to join the remainder
+    TEST_ASSERT_EQUAL(MB_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_UINT16(4, pdu_count);
+    TEST_ASSERT_EQUAL_UINT16(1000, pdus[0].start_address);
+    TEST_ASSERT_EQUAL_UINT16(125, pdus[0].quantity);
+    TEST_ASSERT_EQUAL_UINT16(1125, pdus[1].start_address);
+    TEST_ASSERT_EQUAL_UINT16(125, pdus[1].quantity);
+    TEST_ASSERT_EQUAL_UINT16(1250, pdus[2].start_address);
+    TEST_ASSERT_EQUAL_UINT16(50, pdus[2].quantity);
+    TEST_ASSERT_EQUAL_UINT16(1400, pdus[3].start_address);
+
+    TEST_ASSERT_EQUAL(MB_ERROR_TOO_MANY_BLOCKS, mb_ffd_pack(blocks, 2, 253, pdus, 2, &pdu_count));
+}
+
+void test_ffd_pack_joins_nearest_neighbor(void) {
+    // Two anchors too far apart to share a PDU, and a small block that fits
+    // either but lies closer to the second one
+    mb_block_t blocks[] = {
+        {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS,
+         .start_address = 0, .quantity = 60, .is_merged = false},
+        {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS,
+         .start_address = 130, .quantity = 10, .is_merged = false},
+        {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS,
+         .start_address = 100, .quantity = 2, .is_merged = false}
+    };
+    mb_pdu_t pdus[10];
+    uint16_t pdu_count = 0;
+
+    // First fit would have stretched the first PDU over 40 gap registers
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_ffd_pack(blocks, 3, 253, pdus, 10, &pdu_count));
+    TEST_ASSERT_EQUAL_UINT16(2, pdu_count);
+    TEST_ASSERT_EQUAL_UINT16(0, pdus[0].start_address);
+    TEST_ASSERT_EQUAL_UINT16(60, pdus[0].quantity);
+    TEST_ASSERT_EQUAL_UINT16(100, pdus[1].start_address);
+    TEST_ASSERT_EQUAL_UINT16(40, pdus[1].quantity);
+}
+
+void test_ffd_pack_orders_large_multi_slave_batch(void) {
+    // Interleaved slaves, blocks every 50 registers
+    static mb_block_t blocks[600];
+    for (uint16_t i = 0; i < 600; i++) {
+        blocks[i].slave_id      = (uint8_t)(1 + i % 3);
+        blocks[i].function_code = MB_FC_READ_HOLDING_REGISTERS;
+        blocks[i].start_address = (uint16_t)((i / 3) * 50);
+        blocks[i].quantity      = (uint16_t)(1 + i % 7);
+        blocks[i].is_merged     = false;
+    }
+    static mb_pdu_t pdus[600];
+    uint16_t pdu_count = 0;
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_ffd_pack_inplace(blocks, 600, 253, pdus, 600, &pdu_count, NULL));
+
+    // Sorted, disjoint, and every block covered by a PDU of its slave
+    for (uint16_t i = 1; i < pdu_count; i++) {
+        if (pdus[i].slave_id == pdus[i - 1].slave_id) {
+            TEST_ASSERT_TRUE((uint32_t)pdus[i - 1].start_address + pdus[i - 1].quantity <=
+                             pdus[i].start_address);
+        } else {
+            TEST_ASSERT_TRUE(pdus[i].slave_id > pdus[i - 1].slave_id);
+        }
+    }
+    for (uint16_t i = 0; i < 600; i++) {
+        bool covered = false;
+        for (uint16_t j = 0; j < pdu_count && !covered; j++) {
+            covered = pdus[j].slave_id == blocks[i].slave_id &&
+                      pdus[j].start_address <= blocks[i].start_address &&
+                      (uint32_t)pdus[j].start_address + pdus[j].quantity >=
+                          (uint32_t)blocks[i].start_address + blocks[i].quantity;
+        }
+        TEST_ASSERT_TRUE(covered);
+    }
+    TEST_ASSERT_TRUE(pdu_count < 600);
+}
+
 int main(void) {
     UNITY_BEGIN();
 
@@ -87,6 +174,9 @@ int main(void) {
     RUN_TEST(test_ffd_pack_multiple_blocks_fit_one_pdu);
     RUN_TEST(test_ffd_pack_different_slaves);
     RUN_TEST(test_ffd_pack_exceeds_max_pdu);
+    RUN_TEST(test_ffd_pack_splits_oversized_block);
+    RUN_TEST(test_ffd_pack_joins_nearest_neighbor);
+    RUN_TEST(test_ffd_pack_orders_large_multi_slave_batch);
 
     return UNITY_END();
 }
@@ -5,6 +5,7 @@
 
 #include "unity.h"
 #include "core/gap_merge.h"
+#include "core/char_model.h"
 #include "smartmodbus/mb_types.h"
 #include "smartmodbus/mb_error.h"
 
@@ -89,6 +90,30 @@ void test_merge_block_array(void) {
     TEST_ASSERT_EQUAL_UINT16(2, count);  // First two merged, third separate
 }
 
+void test_cost_params_refuse_modes_not_compiled_in(void) {
+    const mb_mode_t modes[] = {MB_MODE_RTU, MB_MODE_ASCII, MB_MODE_TCP};
+    const mb_link_t link    = {.bit_rate = 19200};
+    mb_cost_params_t params;
+
+    // A single-mode build must not cost another mode as its own
+    for (int i = 0; i < 3; i++) {
+        int expected = MB_MODE_SUPPORTED(modes[i]) ? MB_SUCCESS : MB_ERROR_NOT_SUPPORTED;
+        TEST_ASSERT_EQUAL(expected,
+                          mb_init_cost_params(modes[i], MB_FC_READ_HOLDING_REGISTERS, 2, &params));
+        TEST_ASSERT_EQUAL(expected, mb_init_link_cost_params(
+                                        modes[i], MB_FC_READ_HOLDING_REGISTERS, 2, &link, &params));
+    }
+
+#ifdef MB_FIXED_MODE
+    const mb_mode_t mode = MB_FIXED_MODE;
+#else
+    const mb_mode_t mode = MB_MODE_RTU;
+#endif
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_FC, mb_init_cost_params(mode, 0x2B, 2, &params));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_init_cost_params(mode, MB_FC_READ_HOLDING_REGISTERS, 2, NULL));
+}
+
 int main(void) {
     UNITY_BEGIN();
 
@@ -97,6 +122,7 @@ int main(void) {
     RUN_TEST(test_should_merge_blocks_different_slaves);
     RUN_TEST(test_merge_two_blocks);
     RUN_TEST(test_merge_block_array);
+    RUN_TEST(test_cost_params_refuse_modes_not_compiled_in);
 
     return UNITY_END();
 }
@@ -0,0 +1,313 @@
+/**
+ * @file test_gateway.c
+ * @brief Unit tests for the TCP to serial gateway and RTU-over-TCP mode
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+#include "protocol/frame_builder.h"
+#include "mock_line.h"
+
+#include <string.h>
+
+/**
+ * @brief Responses captured from the gateway
+ */
+typedef struct {
+    uint16_t count;
+    uint16_t client[16];
+    uint8_t frame[16][260];
+    uint16_t length[16];
+} mock_clients_t;
+
+static mock_line_t line;
+static mock_clients_t sent;
+static mb_master_t master;
+
+static mb_gateway_request_t queue[8];
+static mb_gateway_port_t port;
+static mb_gateway_client_t clients[2];
+static mb_tag_t tags[64];
+static uint16_t values[64];
+static mb_gateway_t gateway;
+
+// Slave 1 keeps the line's registers and coils; reads at or above 1000 are
+// illegal addresses
+static bool check_range(mock_line_t *l, const uint8_t *frame, size_t len) {
+    (void)frame;
+    (void)len;
+    if (l->fc > MB_FC_READ_INPUT_REGISTERS || l->start + l->quantity <= 1000) {
+        return false;
+    }
+    mock_line_exception(l, MB_EX_ILLEGAL_DATA_ADDRESS);
+    return true;
+}
+
+static int client_send(void *ctx, uint16_t client, const uint8_t *data, size_t len) {
+    mock_clients_t *c = (mock_clients_t *)ctx;
+
+    TEST_ASSERT_TRUE(c->count < 16);
+    c->client[c->count] = client;
+    c->length[c->count] = (uint16_t)len;
+    memcpy(c->frame[c->count], data, len);
+    c->count++;
+    return (int)len;
+}
+
+void setUp(void) {
+    memset(&line, 0, sizeof(line));
+    line.respond = check_range;
+    memset(&sent, 0, sizeof(sent));
+
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    mock_line_attach(&line, &config);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_gateway_port_init(&port, &master, 1, 1, queue, 8));
+
+    mb_gateway_config_t setup = {
+        .ports         = &port,
+        .port_count    = 1,
+        .clients       = clients,
+        .client_count  = 2,
+        .tags          = tags,
+        .values        = values,
+        .work_capacity = 64,
+        .send          = client_send,
+        .context       = &sent,
+    };
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_gateway_init(&gateway, &setup));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_gateway_client_open(&gateway, 0));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_gateway_client_open(&gateway, 1));
+}
+
+void tearDown(void) {
+    mb_master_cleanup(&master);
+}
+
+/**
+ * @brief Build an MBAP request with a 4-byte PDU (address, quantity or value)
+ */
+static uint16_t make_request(uint8_t *frame,
+                             uint16_t tid,
+                             uint8_t unit,
+                             uint8_t fc,
+                             uint16_t address,
+                             uint16_t quantity) {
+    uint8_t pdu[4] = {(uint8_t)(address >> 8), (uint8_t)address, (uint8_t)(quantity >> 8),
+                      (uint8_t)quantity};
+    uint16_t length = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_build_frame(unit, fc, pdu, 4, MB_MODE_TCP, tid, frame, 260, &length));
+    return length;
+}
+
+static int feed_request(uint16_t client,
+                        uint16_t tid,
+                        uint8_t unit,
+                        uint8_t fc,
+                        uint16_t address,
+                        uint16_t quantity) {
+    uint8_t frame[260];
+    uint16_t length = make_request(frame, tid, unit, fc, address, quantity);
+    return mb_gateway_feed(&gateway, client, frame, length);
+}
+
+static uint16_t response_tid(uint16_t index) {
+    return (uint16_t)((sent.frame[index][0] << 8) | sent.frame[index][1]);
+}
+
+static uint16_t response_register(uint16_t index, uint16_t i) {
+    const uint8_t *data = &sent.frame[index][9 + 2 * i];
+    return (uint16_t)((data[0] << 8) | data[1]);
+}
+
+void test_init_rejects_bad_setup(void) {
+    mb_gateway_t other;
+    mb_gateway_config_t setup = gateway.config;
+    setup.send                = NULL;
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_gateway_init(&other, &setup));
+
+    setup      = gateway.config;
+    setup.tags = NULL;
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_gateway_init(&other, &setup));
+
+    mb_gateway_port_t bad;
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_gateway_port_init(&bad, &master, 5, 4, queue, 8));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_gateway_port_init(&bad, &master, 1, 1, queue, 0));
+}
+
+void test_overlapping_reads_share_one_round_trip(void) {
+    TEST_ASSERT_EQUAL(1, feed_request(0, 0x1111, 1, MB_FC_READ_HOLDING_REGISTERS, 10, 5));
+    TEST_ASSERT_EQUAL(1, feed_request(1, 0x2222, 1, MB_FC_READ_HOLDING_REGISTERS, 12, 6));
+    TEST_ASSERT_EQUAL_UINT16(2, mb_gateway_pending(&gateway, 0));
+
+    TEST_ASSERT_EQUAL(2, mb_gateway_service(&gateway, 0));
+    TEST_ASSERT_EQUAL_UINT16(1, line.requests);
+    TEST_ASSERT_EQUAL_UINT16(0, mb_gateway_pending(&gateway, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, gateway.stats.batches);
+    TEST_ASSERT_EQUAL_UINT32(2, gateway.stats.merged_requests);
+
+    TEST_ASSERT_EQUAL_UINT16(2, sent.count);
+    TEST_ASSERT_EQUAL_UINT16(0, sent.client[0]);
+    TEST_ASSERT_EQUAL_UINT16(0x1111, response_tid(0));
+    TEST_ASSERT_EQUAL_UINT16(9 + 10, sent.length[0]);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_READ_HOLDING_REGISTERS, sent.frame[0][7]);
+    TEST_ASSERT_EQUAL_UINT8(10, sent.frame[0][8]);
+    for (uint16_t i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_UINT16(10 + i, response_register(0, i));
+    }
+
+    TEST_ASSERT_EQUAL_UINT16(1, sent.client[1]);
+    TEST_ASSERT_EQUAL_UINT16(0x2222, response_tid(1));
+    TEST_ASSERT_EQUAL_UINT8(12, sent.frame[1][8]);
+    for (uint16_t i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_UINT16(12 + i, response_register(1, i));
+    }
+}
+
+void test_merged_coil_reads_are_repacked(void) {
+    TEST_ASSERT_EQUAL(1, feed_request(0, 1, 1, MB_FC_READ_COILS, 0, 10));
+    TEST_ASSERT_EQUAL(1, feed_request(1, 2, 1, MB_FC_READ_COILS, 3, 3));
+
+    TEST_ASSERT_EQUAL(2, mb_gateway_service(&gateway, 0));
+    TEST_ASSERT_EQUAL_UINT16(1, line.requests);
+
+    // Odd addresses are set: 0..9 -> 0xAA 0x02, 3..5 -> bits 0 and 2
+    TEST_ASSERT_EQUAL_UINT8(2, sent.frame[0][8]);
+    TEST_ASSERT_EQUAL_HEX8(0xAA, sent.frame[0][9]);
+    TEST_ASSERT_EQUAL_HEX8(0x02, sent.frame[0][10]);
+    TEST_ASSERT_EQUAL_UINT8(1, sent.frame[1][8]);
+    TEST_ASSERT_EQUAL_HEX8(0x05, sent.frame[1][9]);
+}
+
+void test_write_is_a_barrier(void) {
+    TEST_ASSERT_EQUAL(1, feed_request(0, 1, 1, MB_FC_READ_HOLDING_REGISTERS, 0, 2));
+    TEST_ASSERT_EQUAL(1, feed_request(1, 2, 1, MB_FC_WRITE_SINGLE_REGISTER, 1, 99));
+    TEST_ASSERT_EQUAL(1, feed_request(0, 3, 1, MB_FC_READ_HOLDING_REGISTERS, 0, 2));
+
+    TEST_ASSERT_EQUAL(3, mb_gateway_service(&gateway, 0));
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+    TEST_ASSERT_EQUAL_UINT32(0, gateway.stats.batches);
+
+    // Responses keep arrival order
+    TEST_ASSERT_EQUAL_UINT16(1, response_tid(0));
+    TEST_ASSERT_EQUAL_UINT16(2, response_tid(1));
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_WRITE_SINGLE_REGISTER, sent.frame[1][7]);
+    TEST_ASSERT_EQUAL_UINT16(3, response_tid(2));
+}
+
+void test_unknown_unit_gets_path_unavailable(void) {
+    TEST_ASSERT_EQUAL(1, feed_request(0, 7, 9, MB_FC_READ_HOLDING_REGISTERS, 0, 1));
+    TEST_ASSERT_EQUAL_UINT16(0, mb_gateway_pending(&gateway, 0));
+
+    TEST_ASSERT_EQUAL_UINT16(1, sent.count);
+    TEST_ASSERT_EQUAL_UINT16(7, response_tid(0));
+    TEST_ASSERT_EQUAL_UINT8(9, sent.frame[0][6]);
+    TEST_ASSERT_EQUAL_HEX8(0x83, sent.frame[0][7]);
+    TEST_ASSERT_EQUAL_HEX8(MB_EX_GATEWAY_PATH_UNAVAILABLE, sent.frame[0][8]);
+    TEST_ASSERT_EQUAL_UINT32(1, gateway.stats.exceptions);
+}
+
+void test_failed_batch_falls_back_per_request(void) {
+    TEST_ASSERT_EQUAL(1, feed_request(0, 1, 1, MB_FC_READ_HOLDING_REGISTERS, 0, 4));
+    TEST_ASSERT_EQUAL(1, feed_request(1, 2, 1, MB_FC_READ_HOLDING_REGISTERS, 998, 4));
+
+    TEST_ASSERT_EQUAL(2, mb_gateway_service(&gateway, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, gateway.stats.fallbacks);
+
+    // The good read still gets its data, the bad one the slave's exception
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_READ_HOLDING_REGISTERS, sent.frame[0][7]);
+    TEST_ASSERT_EQUAL_UINT16(3, response_register(0, 3));
+    TEST_ASSERT_EQUAL_HEX8(0x83, sent.frame[1][7]);
+    TEST_ASSERT_EQUAL_HEX8(MB_EX_ILLEGAL_DATA_ADDRESS, sent.frame[1][8]);
+    TEST_ASSERT_EQUAL_UINT32(0, gateway.stats.exceptions);
+}
+
+void test_close_purges_queued_requests(void) {
+    TEST_ASSERT_EQUAL(1, feed_request(0, 1, 1, MB_FC_READ_HOLDING_REGISTERS, 0, 1));
+    TEST_ASSERT_EQUAL(1, feed_request(1, 2, 1, MB_FC_READ_HOLDING_REGISTERS, 5, 1));
+    TEST_ASSERT_EQUAL(1, feed_request(0, 3, 1, MB_FC_READ_HOLDING_REGISTERS, 9, 1));
+
+    mb_gateway_client_close(&gateway, 0);
+    TEST_ASSERT_EQUAL_UINT16(1, mb_gateway_pending(&gateway, 0));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      feed_request(0, 4, 1, MB_FC_READ_HOLDING_REGISTERS, 0, 1));
+
+    TEST_ASSERT_EQUAL(1, mb_gateway_service(&gateway, 0));
+    TEST_ASSERT_EQUAL_UINT16(1, sent.count);
+    TEST_ASSERT_EQUAL_UINT16(1, sent.client[0]);
+    TEST_ASSERT_EQUAL_UINT16(5, response_register(0, 0));
+}
+
+void test_full_queue_answers_busy(void) {
+    for (uint16_t i = 0; i < 8; i++) {
+        TEST_ASSERT_EQUAL(1, feed_request(0, i, 1, MB_FC_READ_HOLDING_REGISTERS, i, 1));
+    }
+    TEST_ASSERT_EQUAL(1, feed_request(1, 99, 1, MB_FC_READ_HOLDING_REGISTERS, 0, 1));
+
+    TEST_ASSERT_EQUAL_UINT16(1, sent.count);
+    TEST_ASSERT_EQUAL_UINT16(99, response_tid(0));
+    TEST_ASSERT_EQUAL_HEX8(MB_EX_SLAVE_DEVICE_BUSY, sent.frame[0][8]);
+}
+
+void test_feed_reassembles_segmented_stream(void) {
+    uint8_t stream[520];
+    uint16_t first = make_request(stream, 1, 1, MB_FC_READ_INPUT_REGISTERS, 0, 2);
+    uint16_t total =
+        (uint16_t)(first + make_request(&stream[first], 2, 1, MB_FC_READ_INPUT_REGISTERS, 4, 2));
+
+    // Byte by byte up to the middle of the second request, then the rest
+    int taken = 0;
+    for (uint16_t i = 0; i < first + 3; i++) {
+        taken += mb_gateway_feed(&gateway, 0, &stream[i], 1);
+    }
+    TEST_ASSERT_EQUAL(1, taken);
+    TEST_ASSERT_EQUAL(1, mb_gateway_feed(&gateway, 0, &stream[first + 3], total - first - 3));
+    TEST_ASSERT_EQUAL_UINT16(2, mb_gateway_pending(&gateway, 0));
+
+    // Two requests in one segment
+    TEST_ASSERT_EQUAL(2, mb_gateway_feed(&gateway, 1, stream, total));
+    TEST_ASSERT_EQUAL_UINT16(4, mb_gateway_pending(&gateway, 0));
+}
+
+void test_feed_rejects_non_modbus_stream(void) {
+    const uint8_t junk[] = {'G', 'E', 'T', ' ', '/', ' ', 'H', 'T', 'T', 'P'};
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_FRAME, mb_gateway_feed(&gateway, 0, junk, sizeof(junk)));
+    TEST_ASSERT_EQUAL_UINT16(0, clients[0].rx_length);
+}
+
+void test_rtu_over_tcp_defaults_and_framing(void) {
+    mb_config_t config = mb_config_default(MB_MODE_RTU_OVER_TCP);
+    TEST_ASSERT_EQUAL_UINT8(0, config.gap_chars);
+
+    uint8_t pdu[4] = {0x00, 0x10, 0x00, 0x02};
+    uint8_t rtu[16];
+    uint8_t tunneled[16];
+    uint16_t rtu_length      = 0;
+    uint16_t tunneled_length = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_build_frame(1, MB_FC_READ_HOLDING_REGISTERS, pdu, 4,
+                                                 MB_MODE_RTU, 0, rtu, 16, &rtu_length));
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_build_frame(1, MB_FC_READ_HOLDING_REGISTERS, pdu, 4, MB_MODE_RTU_OVER_TCP,
+                                     0, tunneled, 16, &tunneled_length));
+    TEST_ASSERT_EQUAL_UINT16(rtu_length, tunneled_length);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(rtu, tunneled, rtu_length);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_init_rejects_bad_setup);
+    RUN_TEST(test_overlapping_reads_share_one_round_trip);
+    RUN_TEST(test_merged_coil_reads_are_repacked);
+    RUN_TEST(test_write_is_a_barrier);
+    RUN_TEST(test_unknown_unit_gets_path_unavailable);
+    RUN_TEST(test_failed_batch_falls_back_per_request);
+    RUN_TEST(test_close_purges_queued_requests);
+    RUN_TEST(test_full_queue_answers_busy);
+    RUN_TEST(test_feed_reassembles_segmented_stream);
+    RUN_TEST(test_feed_rejects_non_modbus_stream);
+    RUN_TEST(test_rtu_over_tcp_defaults_and_framing);
+
+    return UNITY_END();
+}
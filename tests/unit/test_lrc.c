@@ -62,6 +62,20 @@ void test_lrc_sequential(void) {
     TEST_ASSERT_EQUAL_HEX8(0xF1, lrc);
 }
 
+void test_lrc_incremental_matches_one_shot(void) {
+    uint8_t data[] = {0x01, 0x03, 0x00, 0x00, 0x00, 0x0A, 0x7F, 0x80};
+
+    uint8_t sum = mb_lrc_init();
+    sum         = mb_lrc_update(sum, data, 3);
+    sum         = mb_lrc_update_byte(sum, data[3]);
+    sum         = mb_lrc_update(sum, &data[4], 4);
+
+    TEST_ASSERT_EQUAL_HEX8(mb_lrc(data, sizeof(data)), mb_lrc_final(sum));
+
+    // Adding the LRC itself leaves a zero sum
+    TEST_ASSERT_EQUAL_HEX8(0x00, mb_lrc_update_byte(sum, mb_lrc_final(sum)));
+}
+
 int main(void) {
     UNITY_BEGIN();
 
@@ -72,6 +86,7 @@ int main(void) {
     RUN_TEST(test_lrc_all_ones);
     RUN_TEST(test_lrc_overflow);
     RUN_TEST(test_lrc_sequential);
+    RUN_TEST(test_lrc_incremental_matches_one_shot);
 
     return UNITY_END();
 }
@@ -0,0 +1,105 @@
+/**
+ * @file test_memory_pool.c
+ * @brief Unit tests for the static memory pools (MB_USE_STATIC_MEMORY)
+ */
+
+#include "unity.h"
+#include "utils/memory_pool.h"
+
+#include <string.h>
+
+static mb_block_pool_t blocks;
+static mb_pdu_pool_t pdus;
+static mb_plan_pool_t plans;
+
+void setUp(void) {
+    mb_block_pool_init(&blocks);
+    mb_pdu_pool_init(&pdus);
+    mb_plan_pool_init(&plans);
+}
+
+void tearDown(void) {}
+
+void test_alloc_until_full(void) {
+    mb_block_t *taken[MB_MAX_BLOCKS];
+
+    for (uint16_t i = 0; i < MB_MAX_BLOCKS; i++) {
+        taken[i] = mb_block_pool_alloc(&blocks);
+        TEST_ASSERT_NOT_NULL(taken[i]);
+        taken[i]->start_address = i;
+    }
+    TEST_ASSERT_NULL(mb_block_pool_alloc(&blocks));
+    TEST_ASSERT_EQUAL_UINT16(0, mb_block_pool_available(&blocks));
+
+    // Every slot handed out exactly once
+    for (uint16_t i = 0; i < MB_MAX_BLOCKS; i++) {
+        TEST_ASSERT_EQUAL_UINT16(i, taken[i]->start_address);
+    }
+}
+
+void test_freed_slots_are_reused_and_zeroed(void) {
+    mb_pdu_t *a = mb_pdu_pool_alloc(&pdus);
+    mb_pdu_t *b = mb_pdu_pool_alloc(&pdus);
+    mb_pdu_t *c = mb_pdu_pool_alloc(&pdus);
+    TEST_ASSERT_TRUE(a != b && b != c && a != c);
+    b->quantity = 77;
+
+    mb_pdu_pool_free(&pdus, b);
+    mb_pdu_pool_free(&pdus, a);
+    TEST_ASSERT_EQUAL_UINT16(MB_MAX_PDUS - 1, mb_pdu_pool_available(&pdus));
+
+    // Most recently freed first
+    TEST_ASSERT_EQUAL_PTR(a, mb_pdu_pool_alloc(&pdus));
+    mb_pdu_t *again = mb_pdu_pool_alloc(&pdus);
+    TEST_ASSERT_EQUAL_PTR(b, again);
+    TEST_ASSERT_EQUAL_UINT16(0, again->quantity);
+}
+
+void test_foreign_and_double_free_are_ignored(void) {
+    mb_request_plan_t *plan = mb_plan_pool_alloc(&plans);
+    mb_request_plan_t outside;
+
+    mb_plan_pool_free(&plans, &outside);
+    mb_plan_pool_free(&plans, (mb_request_plan_t *)((uint8_t *)plan + 1));
+    TEST_ASSERT_EQUAL_UINT16(MB_MAX_PLANS - 1, mb_plan_pool_available(&plans));
+
+    mb_plan_pool_free(&plans, plan);
+    mb_plan_pool_free(&plans, plan);
+    TEST_ASSERT_EQUAL_UINT16(MB_MAX_PLANS, mb_plan_pool_available(&plans));
+
+    // The free list is intact: the whole pool can be taken again
+    for (uint16_t i = 0; i < MB_MAX_PLANS; i++) {
+        TEST_ASSERT_NOT_NULL(mb_plan_pool_alloc(&plans));
+    }
+    TEST_ASSERT_NULL(mb_plan_pool_alloc(&plans));
+}
+
+void test_high_water_tracks_peak_use(void) {
+    mb_block_t *taken[3];
+
+    TEST_ASSERT_EQUAL_UINT16(0, mb_block_pool_high_water(&blocks));
+    for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < 3; i++) {
+            taken[i] = mb_block_pool_alloc(&blocks);
+        }
+        for (int i = 0; i < 3; i++) {
+            mb_block_pool_free(&blocks, taken[i]);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT16(3, mb_block_pool_high_water(&blocks));
+    TEST_ASSERT_EQUAL_UINT16(MB_MAX_BLOCKS, mb_block_pool_available(&blocks));
+
+    mb_block_pool_init(&blocks);
+    TEST_ASSERT_EQUAL_UINT16(0, mb_block_pool_high_water(&blocks));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_alloc_until_full);
+    RUN_TEST(test_freed_slots_are_reused_and_zeroed);
+    RUN_TEST(test_foreign_and_double_free_are_ignored);
+    RUN_TEST(test_high_water_tracks_peak_use);
+
+    return UNITY_END();
+}
@@ -0,0 +1,225 @@
+/**
+ * @file test_metrics.c
+ * @brief Unit tests for per-slave, per-function-code metrics
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+#include "mock_line.h"
+
+#include <string.h>
+
+#define TURNAROUND_US 1500u  // Added by every recv()
+
+typedef enum { REPLY_DATA, REPLY_EXCEPTION, REPLY_SILENT, REPLY_BAD_CRC } reply_t;
+
+static mock_line_t line;
+static reply_t reply;
+static mb_master_t master;
+static mb_metrics_t metrics;
+static mb_metrics_series_t series[4];
+
+static bool busy(mock_line_t *l, const uint8_t *frame, size_t len) {
+    (void)frame;
+    (void)len;
+    if (reply != REPLY_EXCEPTION) {
+        return false;
+    }
+    mock_line_exception(l, MB_EX_SLAVE_DEVICE_BUSY);
+    return true;
+}
+
+static void damage(mock_line_t *l, size_t len) {
+    (void)len;
+    if (reply == REPLY_SILENT) {
+        l->response_length = 0;
+    } else if (reply == REPLY_BAD_CRC) {
+        l->response[l->response_length - 1] ^= 0xFF;
+    }
+}
+
+static void turnaround(mock_line_t *l, size_t len) {
+    (void)len;
+    l->clock_us += TURNAROUND_US;
+}
+
+void setUp(void) {
+    memset(&line, 0, sizeof(line));
+    line.respond  = busy;
+    line.sent     = damage;
+    line.received = turnaround;
+    reply         = REPLY_DATA;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_metrics_init(&metrics, series, 4));
+
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    mock_line_attach(&line, &config);
+    config.transport.clock_us = mock_line_clock;
+    config.metrics            = &metrics;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+}
+
+void tearDown(void) {
+    mb_master_cleanup(&master);
+}
+
+void test_buckets_are_contiguous_and_log_spaced(void) {
+    TEST_ASSERT_EQUAL_UINT8(0, mb_metrics_bucket(0));
+    TEST_ASSERT_EQUAL_UINT8(7, mb_metrics_bucket(7));
+    TEST_ASSERT_EQUAL_UINT8(8, mb_metrics_bucket(8));
+    TEST_ASSERT_EQUAL_UINT8(8, mb_metrics_bucket(9));
+    TEST_ASSERT_EQUAL_UINT8(11, mb_metrics_bucket(15));
+    TEST_ASSERT_EQUAL_UINT8(12, mb_metrics_bucket(16));
+    TEST_ASSERT_EQUAL_UINT8(MB_METRICS_BUCKETS - 1, mb_metrics_bucket(UINT32_MAX));
+
+    uint32_t lower = 0;
+    for (uint8_t b = 0; b < MB_METRICS_BUCKETS - 1; b++) {
+        uint32_t limit = mb_metrics_bucket_limit(b);
+        TEST_ASSERT_TRUE(limit > lower);
+        TEST_ASSERT_EQUAL_UINT8(b, mb_metrics_bucket(lower));
+        TEST_ASSERT_EQUAL_UINT8(b, mb_metrics_bucket(limit - 1));
+        TEST_ASSERT_EQUAL_UINT8(b + 1, mb_metrics_bucket(limit));
+
+        // Never wider than a quarter of the bucket's lower end
+        if (lower >= 8) {
+            TEST_ASSERT_TRUE(limit - lower <= lower / 4);
+        }
+        lower = limit;
+    }
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, mb_metrics_bucket_limit(MB_METRICS_BUCKETS - 1));
+}
+
+void test_percentiles_follow_the_histogram(void) {
+    for (uint32_t us = 1; us <= 1000; us++) {
+        mb_metrics_record_response(&metrics, 1, 3, MB_SUCCESS, false, 0, us * 10);
+    }
+
+    mb_metrics_series_t *s = mb_metrics_find(&metrics, 1, 3);
+    TEST_ASSERT_NOT_NULL(s);
+    TEST_ASSERT_EQUAL_UINT32(1000, s->rtt_count);
+    TEST_ASSERT_EQUAL_UINT32(10000, s->rtt_max_us);
+
+    uint32_t p50 = mb_metrics_percentile(s, 500);
+    uint32_t p99 = mb_metrics_percentile(s, 990);
+    TEST_ASSERT_TRUE(p50 >= 5000 && p50 <= 5000 + 5000 / 4);
+    TEST_ASSERT_TRUE(p99 >= 9900 && p99 <= 10000);
+    TEST_ASSERT_EQUAL_UINT32(10000, mb_metrics_percentile(s, 1000));
+}
+
+void test_series_are_sorted_and_bounded(void) {
+    TEST_ASSERT_NOT_NULL(mb_metrics_acquire(&metrics, 2, 3));
+    TEST_ASSERT_NOT_NULL(mb_metrics_acquire(&metrics, 1, 4));
+    TEST_ASSERT_NOT_NULL(mb_metrics_acquire(&metrics, 1, 3));
+    TEST_ASSERT_NOT_NULL(mb_metrics_acquire(&metrics, 9, 1));
+    TEST_ASSERT_NULL(mb_metrics_acquire(&metrics, 5, 3));
+    TEST_ASSERT_EQUAL_UINT32(1, metrics.dropped);
+
+    TEST_ASSERT_EQUAL_UINT8(1, series[0].slave_id);
+    TEST_ASSERT_EQUAL_UINT8(3, series[0].function_code);
+    TEST_ASSERT_EQUAL_UINT8(1, series[1].slave_id);
+    TEST_ASSERT_EQUAL_UINT8(4, series[1].function_code);
+    TEST_ASSERT_EQUAL_UINT8(2, series[2].slave_id);
+    TEST_ASSERT_EQUAL_UINT8(9, series[3].slave_id);
+
+    mb_metrics_series_t copy[2];
+    uint16_t count = 0;
+    TEST_ASSERT_EQUAL(MB_ERROR_BUFFER_TOO_SMALL, mb_metrics_snapshot(&metrics, copy, 2, &count));
+    TEST_ASSERT_EQUAL_UINT16(2, count);
+}
+
+void test_plans_count_gap_bytes_and_saved_rounds(void) {
+    mb_request_plan_t plans[2];
+    memset(plans, 0, sizeof(plans));
+    plans[0].slave_id      = 1;
+    plans[0].function_code = MB_FC_READ_HOLDING_REGISTERS;
+    plans[0].start_address = 100;
+    plans[0].quantity      = 10;
+    plans[0].scatter_first = 0;
+    plans[0].scatter_count = 5;
+    plans[1].slave_id      = 1;
+    plans[1].function_code = MB_FC_READ_COILS;
+    plans[1].quantity      = 20;
+    plans[1].scatter_first = 5;
+    plans[1].scatter_count = 2;
+
+    // Registers 100, 101, 105, 109 (twice); coils 0 and 19
+    const mb_scatter_entry_t scatter[] = {{0, 0, 0}, {0, 1, 1}, {0, 5, 2}, {0, 9, 3},
+                                          {0, 9, 4}, {1, 0, 5}, {1, 19, 6}};
+    mb_metrics_record_plans(&metrics, plans, 2, scatter);
+
+    mb_metrics_series_t *regs = mb_metrics_find(&metrics, 1, MB_FC_READ_HOLDING_REGISTERS);
+    TEST_ASSERT_NOT_NULL(regs);
+    TEST_ASSERT_EQUAL_UINT64(12, regs->gap_bytes);
+    TEST_ASSERT_EQUAL_UINT32(2, regs->rounds_saved);
+
+    mb_metrics_series_t *coils = mb_metrics_find(&metrics, 1, MB_FC_READ_COILS);
+    TEST_ASSERT_NOT_NULL(coils);
+    TEST_ASSERT_EQUAL_UINT64(2, coils->gap_bytes);
+    TEST_ASSERT_EQUAL_UINT32(1, coils->rounds_saved);
+}
+
+void test_transactions_update_counters_once(void) {
+    uint16_t data[4];
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_single(&master, 1, 3, 10, 2, data));
+
+    reply = REPLY_EXCEPTION;
+    TEST_ASSERT_EQUAL(MB_ERROR_EXCEPTION_RESPONSE, mb_master_read_single(&master, 1, 3, 10, 2,
+                                                                         data));
+    reply = REPLY_SILENT;
+    TEST_ASSERT_EQUAL(MB_ERROR_TIMEOUT, mb_master_read_single(&master, 1, 3, 10, 2, data));
+    reply = REPLY_BAD_CRC;
+    TEST_ASSERT_EQUAL(MB_ERROR_CRC_MISMATCH, mb_master_read_single(&master, 1, 3, 10, 2, data));
+
+    mb_metrics_series_t *s = mb_metrics_find(&metrics, 1, 3);
+    TEST_ASSERT_NOT_NULL(s);
+    TEST_ASSERT_EQUAL_UINT32(4, s->requests);
+    TEST_ASSERT_EQUAL_UINT32(2, s->responses);
+    TEST_ASSERT_EQUAL_UINT32(1, s->exceptions);
+    TEST_ASSERT_EQUAL_UINT32(1, s->timeouts);
+    TEST_ASSERT_EQUAL_UINT32(1, s->crc_errors);
+    TEST_ASSERT_EQUAL_UINT64(4 * 8, s->chars_sent);
+    TEST_ASSERT_EQUAL_UINT32(2, s->rtt_count);
+    TEST_ASSERT_EQUAL_UINT32(1500, s->rtt_max_us);
+
+    mb_stats_t stats;
+    mb_master_get_stats(&master, &stats);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.total_requests);
+}
+
+void test_optimized_read_records_merging(void) {
+    uint16_t addresses[] = {0, 1, 2, 4};
+    uint16_t data[4];
+    mb_read_request_t request = {
+        .slave_id      = 1,
+        .function_code = MB_FC_READ_HOLDING_REGISTERS,
+        .addresses     = addresses,
+        .address_count = 4,
+    };
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request, data, 4));
+    TEST_ASSERT_EQUAL_UINT16(4, data[3]);
+
+    mb_metrics_series_t total;
+    mb_metrics_total(series, metrics.count, &total);
+    TEST_ASSERT_EQUAL_UINT32(1, total.requests);
+    TEST_ASSERT_EQUAL_UINT32(1, total.responses);
+    TEST_ASSERT_EQUAL_UINT64(2, total.gap_bytes);
+    TEST_ASSERT_EQUAL_UINT32(1, total.rounds_saved);
+
+    mb_stats_t stats;
+    mb_master_get_stats(&master, &stats);
+    TEST_ASSERT_EQUAL_UINT32(total.requests, stats.total_requests);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_buckets_are_contiguous_and_log_spaced);
+    RUN_TEST(test_percentiles_follow_the_histogram);
+    RUN_TEST(test_series_are_sorted_and_bounded);
+    RUN_TEST(test_plans_count_gap_bytes_and_saved_rounds);
+    RUN_TEST(test_transactions_update_counters_once);
+    RUN_TEST(test_optimized_read_records_merging);
+
+    return UNITY_END();
+}
@@ -0,0 +1,137 @@
+/**
+ * @file test_optimal_merge.c
+ * @brief Unit tests for the optimal (DP) merge planner
+ */
+
+#include "unity.h"
+#include "core/char_model.h"
+#include "core/optimal_merge.h"
+#include "smartmodbus/mb_error.h"
+
+static mb_cost_params_t rtu_fc03;
+
+static mb_block_t reg_block(uint16_t start, uint16_t quantity) {
+    mb_block_t block = {.slave_id      = 1,
+                        .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                        .start_address = start,
+                        .quantity      = quantity,
+                        .is_merged     = false};
+    return block;
+}
+
+void setUp(void) {
+    // RTU overhead: 6 + 5 + 4 + 2 = 17 chars
+    mb_init_cost_params(MB_MODE_RTU, MB_FC_READ_HOLDING_REGISTERS, 2, &rtu_fc03);
+}
+
+void tearDown(void) {
+}
+
+void test_merges_small_gaps_like_greedy(void) {
+    mb_block_t blocks[] = {reg_block(0, 2), reg_block(5, 2), reg_block(100, 1)};
+    mb_pdu_t pdus[3];
+    uint16_t pdu_count = 0;
+
+    int ret = mb_plan_optimal(blocks, 3, &rtu_fc03, 253, pdus, 3, &pdu_count, NULL);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_UINT16(2, pdu_count);
+    TEST_ASSERT_EQUAL_UINT16(0, pdus[0].start_address);
+    TEST_ASSERT_EQUAL_UINT16(7, pdus[0].quantity);
+    TEST_ASSERT_EQUAL_UINT16(100, pdus[1].start_address);
+    TEST_ASSERT_EQUAL_UINT16(1, pdus[1].quantity);
+}
+
+void test_respects_fc_quantity_limit_while_merging(void) {
+    // Greedy merges these into 133 registers, over the FC03 limit of 125
+    mb_block_t blocks[] = {reg_block(0, 120), reg_block(123, 10)};
+    mb_pdu_t pdus[2];
+    uint16_t pdu_count = 0;
+
+    int ret = mb_plan_optimal(blocks, 2, &rtu_fc03, 253, pdus, 2, &pdu_count, NULL);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_UINT16(2, pdu_count);
+    TEST_ASSERT_EQUAL_UINT16(120, pdus[0].quantity);
+    TEST_ASSERT_EQUAL_UINT16(123, pdus[1].start_address);
+    TEST_ASSERT_EQUAL_UINT16(10, pdus[1].quantity);
+}
+
+void test_picks_cheapest_partition_under_limit(void) {
+    // Either the first or the last gap can be bridged, not both
+    mb_block_t blocks[] = {reg_block(0, 60), reg_block(62, 60), reg_block(128, 2)};
+    mb_pdu_t pdus[3];
+    uint16_t pdu_count = 0;
+
+    int ret = mb_plan_optimal(blocks, 3, &rtu_fc03, 253, pdus, 3, &pdu_count, NULL);
+
+    // {0..121} + {128..129}: 17+244 + 17+4 = 282 beats {0..59} + {62..129}
+    TEST_ASSERT_EQUAL(MB_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_UINT16(2, pdu_count);
+    TEST_ASSERT_EQUAL_UINT16(122, pdus[0].quantity);
+    TEST_ASSERT_EQUAL_UINT16(128, pdus[1].start_address);
+    TEST_ASSERT_EQUAL_UINT32(282, mb_calc_plan_cost(pdus, pdu_count, &rtu_fc03));
+}
+
+void test_respects_pdu_char_limit(void) {
+    // 20 chars = 10 registers per PDU
+    mb_block_t blocks[] = {reg_block(0, 6), reg_block(7, 6)};
+    mb_pdu_t pdus[2];
+    uint16_t pdu_count = 0;
+
+    int ret = mb_plan_optimal(blocks, 2, &rtu_fc03, 20, pdus, 2, &pdu_count, NULL);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_UINT16(2, pdu_count);
+}
+
+void test_splits_oversized_block(void) {
+    mb_block_t blocks[] = {reg_block(0, 300)};
+    mb_pdu_t pdus[4];
+    uint16_t pdu_count = 0;
+
+    int ret = mb_plan_optimal(blocks, 1, &rtu_fc03, 253, pdus, 4, &pdu_count, NULL);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_UINT16(3, pdu_count);
+    TEST_ASSERT_EQUAL_UINT16(125, pdus[0].quantity);
+    TEST_ASSERT_EQUAL_UINT16(125, pdus[1].start_address);
+    TEST_ASSERT_EQUAL_UINT16(125, pdus[1].quantity);
+    TEST_ASSERT_EQUAL_UINT16(250, pdus[2].start_address);
+    TEST_ASSERT_EQUAL_UINT16(50, pdus[2].quantity);
+}
+
+void test_rejects_mixed_blocks(void) {
+    mb_block_t blocks[] = {reg_block(0, 1), reg_block(2, 1)};
+    blocks[1].slave_id = 2;
+    mb_pdu_t pdus[2];
+    uint16_t pdu_count = 0;
+
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_plan_optimal(blocks, 2, &rtu_fc03, 253, pdus, 2, &pdu_count, NULL));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_plan_optimal(NULL, 2, &rtu_fc03, 253, pdus, 2, &pdu_count, NULL));
+}
+
+void test_reports_too_many_pdus(void) {
+    mb_block_t blocks[] = {reg_block(0, 1), reg_block(1000, 1)};
+    mb_pdu_t pdus[1];
+    uint16_t pdu_count = 0;
+
+    TEST_ASSERT_EQUAL(MB_ERROR_TOO_MANY_BLOCKS,
+                      mb_plan_optimal(blocks, 2, &rtu_fc03, 253, pdus, 1, &pdu_count, NULL));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_merges_small_gaps_like_greedy);
+    RUN_TEST(test_respects_fc_quantity_limit_while_merging);
+    RUN_TEST(test_picks_cheapest_partition_under_limit);
+    RUN_TEST(test_respects_pdu_char_limit);
+    RUN_TEST(test_splits_oversized_block);
+    RUN_TEST(test_rejects_mixed_blocks);
+    RUN_TEST(test_reports_too_many_pdus);
+
+    return UNITY_END();
+}
@@ -0,0 +1,532 @@
+/**
+ * @file test_poll_plan.c
+ * @brief Unit tests for compiled poll plans
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+#include "protocol/frame_builder.h"
+#include "mock_line.h"
+
+#include <string.h>
+
+static mock_line_t line;
+static uint8_t silent_unit; /**< Slave that never answers (0 = none) */
+
+// The clock advances 10 us per register sent back
+static void answer_in_time(mock_line_t *l, size_t len) {
+    (void)len;
+    l->clock_us += 10u * l->quantity;
+    if (l->unit == silent_unit) {
+        l->response_length = 0;
+    }
+}
+
+static mb_master_t master;
+
+static void init_master(mb_mode_t mode) {
+    line.mode          = mode;
+    mb_config_t config = mb_config_default(mode);
+    mock_line_attach(&line, &config);
+    config.transport.clock_us = mock_line_clock;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+}
+
+void setUp(void) {
+    memset(&line, 0, sizeof(line));
+    line.sent   = answer_in_time;
+    silent_unit = 0;
+}
+
+void tearDown(void) {
+}
+
+static uint16_t addresses[] = {2000, 1, 0, 1000, 1001, 2};
+static const mb_read_request_t request = {.slave_id      = 1,
+                                          .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                          .addresses     = addresses,
+                                          .address_count = 6};
+
+void test_compile_prebuilds_request_frames(void) {
+    init_master(MB_MODE_RTU);
+
+    static mb_poll_plan_t poll;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile(&master, &request, &poll));
+    TEST_ASSERT_EQUAL_UINT16(3, poll.plan_count);
+    TEST_ASSERT_EQUAL_UINT16(6, poll.address_count);
+
+    for (uint16_t i = 0; i < poll.plan_count; i++) {
+        const mb_request_plan_t *plan = &poll.plans[i];
+        uint8_t expected[MB_PLAN_FRAME_CHARS];
+        uint16_t expected_length = 0;
+        uint8_t pdu[4] = {(uint8_t)(plan->start_address >> 8), (uint8_t)plan->start_address,
+                          (uint8_t)(plan->quantity >> 8), (uint8_t)plan->quantity};
+
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_build_frame(1, MB_FC_READ_HOLDING_REGISTERS, pdu, 4,
+                                                     MB_MODE_RTU, 0, expected, sizeof(expected),
+                                                     &expected_length));
+        TEST_ASSERT_NOT_NULL(plan->frame_data);
+        TEST_ASSERT_EQUAL_UINT16(expected_length, plan->frame_length);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, plan->frame_data, expected_length);
+
+        // SlaveID + FC + byte count + data + CRC
+        TEST_ASSERT_EQUAL_UINT16(5 + plan->quantity * 2, plan->expected_response_length);
+    }
+
+    mb_poll_plan_free(&poll);
+}
+
+void test_execute_repeatedly_scatters_in_request_order(void) {
+    init_master(MB_MODE_RTU);
+
+    static mb_poll_plan_t poll;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile(&master, &request, &poll));
+
+    for (int cycle = 0; cycle < 3; cycle++) {
+        uint16_t data[6];
+        memset(data, 0xFF, sizeof(data));
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_execute_poll(&master, &poll, data, 6));
+        TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 6);
+    }
+
+    TEST_ASSERT_EQUAL_UINT16(9, line.requests);
+    TEST_ASSERT_EQUAL_UINT32(9, master.stats.total_requests);
+
+    mb_poll_plan_free(&poll);
+}
+
+void test_execute_patches_tcp_transaction_id(void) {
+    init_master(MB_MODE_TCP);
+
+    static mb_poll_plan_t poll;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile(&master, &request, &poll));
+
+    uint16_t data[6];
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_execute_poll(&master, &poll, data, 6));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_execute_poll(&master, &poll, data, 6));
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 6);
+
+    // Transaction IDs keep counting across executions of the same frames
+    TEST_ASSERT_EQUAL_UINT16(6, line.requests);
+    for (uint16_t i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_UINT16(i, line.tids[i]);
+    }
+
+    mb_poll_plan_free(&poll);
+}
+
+void test_execute_rejects_small_buffer_and_mode_mismatch(void) {
+    init_master(MB_MODE_RTU);
+
+    static mb_poll_plan_t poll;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile(&master, &request, &poll));
+
+    uint16_t data[6];
+    TEST_ASSERT_EQUAL(MB_ERROR_BUFFER_TOO_SMALL, mb_master_execute_poll(&master, &poll, data, 5));
+
+    master.config.mode = MB_MODE_TCP;
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_master_execute_poll(&master, &poll, data, 6));
+    TEST_ASSERT_EQUAL_UINT16(0, line.requests);
+
+    mb_poll_plan_free(&poll);
+}
+
+void test_compile_invalid_params(void) {
+    init_master(MB_MODE_RTU);
+
+    static mb_poll_plan_t poll;
+    mb_read_request_t empty = {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                               .addresses = addresses, .address_count = 0};
+
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_poll_plan_compile(NULL, &request, &poll));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_poll_plan_compile(&master, NULL, &poll));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_poll_plan_compile(&master, &empty, &poll));
+}
+
+void test_compile_batch_executes_across_slaves(void) {
+    init_master(MB_MODE_RTU);
+
+    mb_tag_t tags[] = {
+        {.slave_id = 3, .function_code = MB_FC_READ_HOLDING_REGISTERS, .address = 40},
+        {.slave_id = 1, .function_code = MB_FC_READ_INPUT_REGISTERS, .address = 7},
+        {.slave_id = 3, .function_code = MB_FC_READ_HOLDING_REGISTERS, .address = 41},
+    };
+
+    static mb_poll_plan_t poll;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile_batch(&master, tags, 3, &poll));
+    TEST_ASSERT_EQUAL_UINT16(2, poll.plan_count);
+
+    uint16_t data[3];
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_execute_poll(&master, &poll, data, 3));
+    TEST_ASSERT_EQUAL_UINT16(40, data[0]);
+    TEST_ASSERT_EQUAL_UINT16(7, data[1]);
+    TEST_ASSERT_EQUAL_UINT16(41, data[2]);
+
+    mb_poll_plan_free(&poll);
+}
+
+void test_add_replans_only_the_neighbourhood(void) {
+    init_master(MB_MODE_RTU);
+
+    static mb_poll_plan_t poll;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile(&master, &request, &poll));
+    TEST_ASSERT_EQUAL_UINT16(3, poll.plan_count);
+
+    uint8_t first[MB_PLAN_FRAME_CHARS];
+    uint8_t last[MB_PLAN_FRAME_CHARS];
+    memcpy(first, poll.plans[0].frame_data, poll.plans[0].frame_length);
+    memcpy(last, poll.plans[2].frame_data, poll.plans[2].frame_length);
+
+    // 1003 joins the 1000-1001 plan; 0-2 and 2000 are out of reach
+    mb_tag_t tag  = {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS, .address = 1003};
+    uint16_t slot = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_add(&master, &poll, &tag, &slot));
+    TEST_ASSERT_EQUAL_UINT16(6, slot);
+    TEST_ASSERT_EQUAL_UINT16(7, poll.address_count);
+    TEST_ASSERT_EQUAL_UINT16(3, poll.plan_count);
+    TEST_ASSERT_EQUAL_UINT16(1000, poll.plans[1].start_address);
+    TEST_ASSERT_EQUAL_UINT16(4, poll.plans[1].quantity);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(first, poll.plans[0].frame_data, poll.plans[0].frame_length);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(last, poll.plans[2].frame_data, poll.plans[2].frame_length);
+
+    uint16_t data[7];
+    uint16_t expected[7] = {2000, 1, 0, 1000, 1001, 2, 1003};
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_execute_poll(&master, &poll, data, 7));
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, data, 7);
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+
+    mb_poll_plan_free(&poll);
+}
+
+void test_add_outside_every_group_appends_a_plan(void) {
+    init_master(MB_MODE_RTU);
+
+    static mb_poll_plan_t poll;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile(&master, &request, &poll));
+
+    mb_tag_t far   = {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS, .address = 5000};
+    mb_tag_t other = {.slave_id = 2, .function_code = MB_FC_READ_INPUT_REGISTERS, .address = 1};
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_add(&master, &poll, &far, NULL));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_add(&master, &poll, &other, NULL));
+    TEST_ASSERT_EQUAL_UINT16(5, poll.plan_count);
+    TEST_ASSERT_EQUAL_UINT16(5000, poll.plans[3].start_address);
+    TEST_ASSERT_EQUAL_UINT8(2, poll.plans[4].slave_id);
+
+    uint16_t data[8];
+    uint16_t expected[8] = {2000, 1, 0, 1000, 1001, 2, 5000, 1};
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_execute_poll(&master, &poll, data, 8));
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, data, 8);
+
+    mb_poll_plan_free(&poll);
+}
+
+void test_remove_moves_later_slots_down(void) {
+    init_master(MB_MODE_RTU);
+
+    static mb_poll_plan_t poll;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile(&master, &request, &poll));
+
+    // 2000 was alone in its plan
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_remove(&master, &poll, 0));
+    TEST_ASSERT_EQUAL_UINT16(2, poll.plan_count);
+    TEST_ASSERT_EQUAL_UINT16(5, poll.address_count);
+
+    // Address 0 goes, its plan shrinks to 1-2
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_remove(&master, &poll, 1));
+    TEST_ASSERT_EQUAL_UINT16(2, poll.plan_count);
+    TEST_ASSERT_EQUAL_UINT16(1, poll.plans[0].start_address);
+    TEST_ASSERT_EQUAL_UINT16(2, poll.plans[0].quantity);
+
+    uint16_t data[4];
+    uint16_t expected[4] = {1, 1000, 1001, 2};
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_execute_poll(&master, &poll, data, 4));
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, data, 4);
+
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_poll_plan_remove(&master, &poll, 4));
+    for (uint16_t i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_remove(&master, &poll, 0));
+    }
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_poll_plan_remove(&master, &poll, 0));
+    TEST_ASSERT_EQUAL_UINT16(1, poll.address_count);
+    TEST_ASSERT_EQUAL_UINT16(2, poll.plans[0].start_address);
+
+    mb_poll_plan_free(&poll);
+}
+
+void test_snapshot_round_trip_executes_without_planning(void) {
+    init_master(MB_MODE_TCP);
+
+    static mb_poll_plan_t compiled;
+    static mb_poll_plan_t loaded;
+    static uint32_t image[64];
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile(&master, &request, &compiled));
+
+    size_t size = mb_poll_plan_image_size(&compiled);
+    TEST_ASSERT_EQUAL_UINT32(0, size % 4);
+    TEST_ASSERT_TRUE(size <= sizeof(image));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_save(&compiled, 7, image, size));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_load(&master, &loaded, image, size, 7));
+
+    TEST_ASSERT_EQUAL_UINT16(compiled.plan_count, loaded.plan_count);
+    TEST_ASSERT_EQUAL_UINT16(compiled.address_count, loaded.address_count);
+    TEST_ASSERT_EQUAL_UINT32(size, mb_poll_plan_image_size(&loaded));
+    for (uint16_t i = 0; i < loaded.plan_count; i++) {
+        const mb_request_plan_t *a = &compiled.plans[i];
+        const mb_request_plan_t *b = &loaded.plans[i];
+        TEST_ASSERT_EQUAL_UINT16(a->start_address, b->start_address);
+        TEST_ASSERT_EQUAL_UINT16(a->quantity, b->quantity);
+        TEST_ASSERT_EQUAL_UINT16(a->expected_response_length, b->expected_response_length);
+        TEST_ASSERT_EQUAL_UINT16(a->frame_length, b->frame_length);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(a->frame_data, b->frame_data, a->frame_length);
+    }
+
+    // The image may go away once loaded
+    memset(image, 0, sizeof(image));
+    mb_poll_plan_free(&compiled);
+
+    uint16_t data[6];
+    uint16_t expected[6] = {2000, 1, 0, 1000, 1001, 2};
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_execute_poll(&master, &loaded, data, 6));
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, data, 6);
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+
+    mb_poll_plan_free(&loaded);
+}
+
+void test_snapshot_images_stack_back_to_back(void) {
+    init_master(MB_MODE_RTU);
+
+    mb_tag_t tags[] = {
+        {.slave_id = 2, .function_code = MB_FC_READ_HOLDING_REGISTERS, .address = 10},
+        {.slave_id = 3, .function_code = MB_FC_READ_HOLDING_REGISTERS, .address = 20},
+    };
+    static mb_poll_plan_t first;
+    static mb_poll_plan_t second;
+    static uint32_t image[64];
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile(&master, &request, &first));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile_batch(&master, tags, 2, &second));
+
+    size_t first_size = mb_poll_plan_image_size(&first);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_save(&first, 1, image, sizeof(image)));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_save(&second, 1, &image[first_size / 4],
+                                                    sizeof(image) - first_size));
+    mb_poll_plan_free(&first);
+    mb_poll_plan_free(&second);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_load(&master, &first, image, sizeof(image), 1));
+    size_t offset = mb_poll_plan_image_size(&first);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_load(&master, &second, &image[offset / 4],
+                                                    sizeof(image) - offset, 1));
+    TEST_ASSERT_EQUAL_UINT16(3, first.plan_count);
+    TEST_ASSERT_EQUAL_UINT16(2, second.plan_count);
+    TEST_ASSERT_EQUAL_UINT8(3, second.plans[1].slave_id);
+
+    mb_poll_plan_free(&first);
+    mb_poll_plan_free(&second);
+}
+
+void test_snapshot_rejects_foreign_and_damaged_images(void) {
+    init_master(MB_MODE_RTU);
+
+    static mb_poll_plan_t poll;
+    static uint32_t image[64];
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile(&master, &request, &poll));
+    size_t size = mb_poll_plan_image_size(&poll);
+
+    TEST_ASSERT_EQUAL(MB_ERROR_BUFFER_TOO_SMALL, mb_poll_plan_save(&poll, 1, image, size - 4));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_poll_plan_save(&poll, 1, (uint8_t *)image + 2, size));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_save(&poll, 1, image, size));
+    mb_poll_plan_free(&poll);
+
+    // Another tag list revision, another framing
+    TEST_ASSERT_EQUAL(MB_ERROR_NOT_SUPPORTED, mb_poll_plan_load(&master, &poll, image, size, 2));
+    init_master(MB_MODE_TCP);
+    TEST_ASSERT_EQUAL(MB_ERROR_NOT_SUPPORTED, mb_poll_plan_load(&master, &poll, image, size, 1));
+    init_master(MB_MODE_RTU);
+
+    // Truncated, then one flipped frame byte
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_FRAME,
+                      mb_poll_plan_load(&master, &poll, image, size - 4, 1));
+    ((uint8_t *)image)[size - 8] ^= 0x01;
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_FRAME, mb_poll_plan_load(&master, &poll, image, size, 1));
+    ((uint8_t *)image)[size - 8] ^= 0x01;
+
+    image[0] = 0;
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_FRAME, mb_poll_plan_load(&master, &poll, image, size, 1));
+    TEST_ASSERT_EQUAL(MB_ERROR_BUFFER_TOO_SMALL, mb_poll_plan_load(&master, &poll, image, 8, 1));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_poll_plan_load(&master, &poll, NULL, size, 1));
+}
+
+// Round 0: slave 1 (40 registers), slave 2 (1), slave 3 (10); round 1: slave 1 at 1000
+static mb_tag_t meters[52];
+
+static void compile_meters(mb_poll_plan_t *poll) {
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < 40; i++) {
+        meters[n++] = (mb_tag_t){1, MB_FC_READ_HOLDING_REGISTERS, i};
+    }
+    meters[n++] = (mb_tag_t){1, MB_FC_READ_HOLDING_REGISTERS, 1000};
+    meters[n++] = (mb_tag_t){2, MB_FC_READ_HOLDING_REGISTERS, 5};
+    for (uint16_t i = 0; i < 10; i++) {
+        meters[n++] = (mb_tag_t){3, MB_FC_READ_HOLDING_REGISTERS, (uint16_t)(100 + i)};
+    }
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile_batch(&master, meters, n, poll));
+    TEST_ASSERT_EQUAL_UINT16(4, poll->plan_count);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_order_synced(&master, poll));
+}
+
+void test_synced_order_puts_the_longest_read_last_on_serial(void) {
+    init_master(MB_MODE_RTU);
+    static mb_poll_plan_t poll;
+    compile_meters(&poll);
+
+    mb_synced_stamp_t stamps[4];
+    mb_synced_timing_t timing;
+    uint16_t data[52];
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_master_execute_synced(&master, &poll, data, 52, stamps, 4, &timing));
+
+    const uint8_t order[] = {2, 3, 1, 1};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(order, line.units, 4);
+    TEST_ASSERT_EQUAL_UINT16(39, data[39]);
+    TEST_ASSERT_EQUAL_UINT16(1000, data[40]);
+    TEST_ASSERT_EQUAL_UINT16(5, data[41]);
+    TEST_ASSERT_EQUAL_UINT16(109, data[51]);
+
+    // Each response is stamped when it is received
+    const uint32_t arrivals[] = {10, 110, 510, 520};
+    for (uint16_t i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_INT(MB_SUCCESS, stamps[i].result);
+        TEST_ASSERT_EQUAL_UINT32(arrivals[i], stamps[i].stamp_us);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, timing.start_us);
+    TEST_ASSERT_EQUAL_UINT32(520, timing.span_us);
+    TEST_ASSERT_EQUAL_UINT32(510, timing.skew_us);
+    TEST_ASSERT_EQUAL_UINT16(4, timing.answered);
+
+    mb_poll_plan_free(&poll);
+}
+
+void test_synced_order_puts_the_longest_read_first_when_pipelined(void) {
+    line.mode          = MB_MODE_TCP;
+    mb_config_t config = mb_config_default(MB_MODE_TCP);
+    mock_line_attach(&line, &config);
+    config.max_in_flight = 4;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+
+    static mb_poll_plan_t poll;
+    compile_meters(&poll);
+
+    const uint8_t order[] = {1, 3, 2, 1};
+    for (uint16_t i = 0; i < 4; i++) {
+        const mb_request_plan_t *plan = &poll.plans[i];
+        TEST_ASSERT_EQUAL_UINT8(order[i], plan->slave_id);
+        TEST_ASSERT_EQUAL_UINT8(order[i], plan->frame_data[6]);  // MBAP unit ID
+        for (uint16_t k = 0; k < plan->scatter_count; k++) {
+            TEST_ASSERT_EQUAL_UINT16(i, poll.scatter[plan->scatter_first + k].plan_index);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT16(1000, poll.plans[3].start_address);
+
+    mb_poll_plan_free(&poll);
+}
+
+void test_synced_read_goes_on_past_a_silent_slave(void) {
+    init_master(MB_MODE_RTU);
+    static mb_poll_plan_t poll;
+    compile_meters(&poll);
+    silent_unit = 3;
+
+    mb_synced_stamp_t stamps[4];
+    mb_synced_timing_t timing;
+    uint16_t data[52];
+    memset(data, 0xFF, sizeof(data));
+    TEST_ASSERT_EQUAL(MB_ERROR_PARTIAL_RESULT,
+                      mb_master_execute_synced(&master, &poll, data, 52, stamps, 4, &timing));
+
+    TEST_ASSERT_EQUAL_UINT16(4, line.requests);
+    TEST_ASSERT_EQUAL_INT(MB_SUCCESS, stamps[0].result);
+    TEST_ASSERT_EQUAL_INT(MB_ERROR_TIMEOUT, stamps[1].result);
+    TEST_ASSERT_EQUAL_INT(MB_SUCCESS, stamps[2].result);
+    TEST_ASSERT_EQUAL_INT(MB_SUCCESS, stamps[3].result);
+    TEST_ASSERT_EQUAL_UINT16(3, timing.answered);
+    TEST_ASSERT_EQUAL_UINT16(5, data[41]);
+    TEST_ASSERT_EQUAL_UINT16(0xFFFF, data[42]);
+    TEST_ASSERT_EQUAL_UINT16(39, data[39]);
+
+    mb_poll_plan_free(&poll);
+}
+
+void test_synced_read_does_not_resend_an_abandoned_window(void) {
+    line.mode          = MB_MODE_TCP;
+    mb_config_t config = mb_config_default(MB_MODE_TCP);
+    mock_line_attach(&line, &config);
+    config.transport.clock_us = mock_line_clock;
+    config.max_in_flight      = 4;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+
+    static mb_poll_plan_t poll;
+    compile_meters(&poll);
+
+    // The line holds one response: of the window only the last request is answered
+    mb_synced_stamp_t stamps[4];
+    mb_synced_timing_t timing;
+    uint16_t data[52];
+    TEST_ASSERT_EQUAL(MB_ERROR_PARTIAL_RESULT,
+                      mb_master_execute_synced(&master, &poll, data, 52, stamps, 4, &timing));
+
+    TEST_ASSERT_EQUAL_UINT16(4, line.requests);
+    TEST_ASSERT_EQUAL_INT(MB_ERROR_TIMEOUT, stamps[0].result);
+    TEST_ASSERT_EQUAL_INT(MB_ERROR_TIMEOUT, stamps[1].result);
+    TEST_ASSERT_EQUAL_INT(MB_ERROR_TIMEOUT, stamps[2].result);
+    TEST_ASSERT_EQUAL_INT(MB_SUCCESS, stamps[3].result);
+    TEST_ASSERT_EQUAL_UINT16(1, timing.answered);
+    TEST_ASSERT_EQUAL_UINT16(1000, data[40]);
+
+    mb_poll_plan_free(&poll);
+}
+
+void test_synced_read_rejects_missing_clock_and_small_stamps(void) {
+    init_master(MB_MODE_RTU);
+    static mb_poll_plan_t poll;
+    compile_meters(&poll);
+
+    mb_synced_stamp_t stamps[4];
+    uint16_t data[52];
+    TEST_ASSERT_EQUAL(MB_ERROR_BUFFER_TOO_SMALL,
+                      mb_master_execute_synced(&master, &poll, data, 52, stamps, 3, NULL));
+    TEST_ASSERT_EQUAL(MB_ERROR_BUFFER_TOO_SMALL,
+                      mb_master_execute_synced(&master, &poll, data, 51, stamps, 4, NULL));
+
+    master.config.transport.clock_us = NULL;
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_master_execute_synced(&master, &poll, data, 52, stamps, 4, NULL));
+    TEST_ASSERT_EQUAL_UINT16(0, line.requests);
+
+    mb_poll_plan_free(&poll);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_compile_prebuilds_request_frames);
+    RUN_TEST(test_execute_repeatedly_scatters_in_request_order);
+    RUN_TEST(test_execute_patches_tcp_transaction_id);
+    RUN_TEST(test_execute_rejects_small_buffer_and_mode_mismatch);
+    RUN_TEST(test_compile_invalid_params);
+    RUN_TEST(test_compile_batch_executes_across_slaves);
+    RUN_TEST(test_add_replans_only_the_neighbourhood);
+    RUN_TEST(test_add_outside_every_group_appends_a_plan);
+    RUN_TEST(test_remove_moves_later_slots_down);
+    RUN_TEST(test_snapshot_round_trip_executes_without_planning);
+    RUN_TEST(test_snapshot_images_stack_back_to_back);
+    RUN_TEST(test_snapshot_rejects_foreign_and_damaged_images);
+    RUN_TEST(test_synced_order_puts_the_longest_read_last_on_serial);
+    RUN_TEST(test_synced_order_puts_the_longest_read_first_when_pipelined);
+    RUN_TEST(test_synced_read_goes_on_past_a_silent_slave);
+    RUN_TEST(test_synced_read_does_not_resend_an_abandoned_window);
+    RUN_TEST(test_synced_read_rejects_missing_clock_and_small_stamps);
+
+    return UNITY_END();
+}
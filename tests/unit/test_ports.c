@@ -0,0 +1,320 @@
+/**
+ * @file test_ports.c
+ * @brief Unit tests for the one-thread multi-port serial engine
+ *
+ * Each port is one end of a socketpair; the test answers the requests on
+ * the other end with an mb_slave, between calls to mb_ports_run().
+ */
+
+// clock_gettime(), posix_openpt(), ptsname()
+#define _GNU_SOURCE
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PORTS 4
+
+typedef struct {
+    int fd;
+    uint8_t rx[64];
+    uint16_t rx_length;
+    uint16_t requests;
+} peer_t;
+
+static peer_t peers[PORTS];
+static mb_master_t masters[PORTS];
+static mb_poll_plan_t polls[PORTS];
+static mb_port_poll_t scans[PORTS][2];
+static mb_port_t ports[PORTS];
+static mb_ports_t engine;
+static mb_slave_t slave;
+static MB_SLAVE_ALIGNED uint16_t holding[1600];
+static uint16_t done_calls;
+
+// Two blocks far apart: two requests per poll
+static uint16_t addresses[] = {0, 1, 1500};
+static const mb_read_request_t request = {.slave_id      = 1,
+                                          .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                          .addresses     = addresses,
+                                          .address_count = 3};
+
+static uint64_t now_us(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000u + (uint64_t)now.tv_nsec / 1000u;
+}
+
+static void on_done(void *ctx, int result) {
+    (void)ctx;
+    (void)result;
+    done_calls++;
+}
+
+/**
+ * @brief Answer every complete FC03 request waiting on a peer
+ */
+static bool serve(peer_t *peer) {
+    ssize_t got = recv(peer->fd, &peer->rx[peer->rx_length], sizeof(peer->rx) - peer->rx_length,
+                       MSG_DONTWAIT);
+    if (got > 0) {
+        peer->rx_length = (uint16_t)(peer->rx_length + got);
+    }
+
+    bool answered = false;
+    while (peer->rx_length >= 8) {
+        uint8_t response[260];
+        uint16_t length = 0;
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_slave_process_frame(&slave, MB_MODE_RTU, peer->rx, 8,
+                                                             response, sizeof(response), &length));
+        TEST_ASSERT_EQUAL_INT(length, (int)write(peer->fd, response, length));
+        peer->rx_length = (uint16_t)(peer->rx_length - 8);
+        memmove(peer->rx, &peer->rx[8], peer->rx_length);
+        peer->requests++;
+        answered = true;
+    }
+    return answered;
+}
+
+/**
+ * @brief Add a port on a fresh socketpair with one poll in its scan list
+ */
+static int add_port(int i, uint32_t bit_rate, uint32_t timeout_ms) {
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    peers[i].fd = fds[1];
+
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    config.timeout_ms  = timeout_ms;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&masters[i], &config));
+
+    mb_link_t link = {.bit_rate = bit_rate, .parity = MB_PARITY_EVEN};
+    int port       = mb_ports_add(&engine, &masters[i], fds[0], &link, scans[i], 2);
+    TEST_ASSERT_EQUAL(i, port);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile(&masters[i], &request, &polls[i]));
+    TEST_ASSERT_EQUAL_UINT16(2, polls[i].plan_count);
+    return port;
+}
+
+void setUp(void) {
+    memset(peers, 0, sizeof(peers));
+    memset(polls, 0, sizeof(polls));
+    memset(masters, 0, sizeof(masters));
+    done_calls = 0;
+    for (int i = 0; i < PORTS; i++) {
+        peers[i].fd = -1;
+    }
+    for (uint16_t i = 0; i < 1600; i++) {
+        holding[i] = (uint16_t)(7000 + i);
+    }
+
+    mb_slave_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.unit_id = 1;
+    config.holding = (mb_slave_regs_t){holding, 0, 1600};
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_slave_init(&slave, &config));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_ports_init(&engine, ports, PORTS));
+}
+
+void tearDown(void) {
+    mb_ports_close(&engine);
+    for (int i = 0; i < PORTS; i++) {
+        if (peers[i].fd >= 0) {
+            close(peers[i].fd);
+        }
+        mb_poll_plan_free(&polls[i]);
+        mb_master_cleanup(&masters[i]);
+    }
+}
+
+void test_one_thread_scans_every_port(void) {
+    uint16_t data[PORTS][3];
+    for (int i = 0; i < PORTS; i++) {
+        add_port(i, 115200, 500);
+        TEST_ASSERT_EQUAL(0, mb_ports_add_poll(&engine, (uint16_t)i, &polls[i], data[i], 3,
+                                               on_done, NULL));
+    }
+
+    int completed = 0;
+    for (int round = 0; round < 1000 && completed < 3 * PORTS; round++) {
+        int result = mb_ports_run(&engine, 2);
+        TEST_ASSERT_TRUE(result >= 0);
+        completed += result;
+        for (int i = 0; i < PORTS; i++) {
+            serve(&peers[i]);
+        }
+    }
+
+    TEST_ASSERT_TRUE(completed >= 3 * PORTS);
+    TEST_ASSERT_EQUAL_UINT16(completed, done_calls);
+    for (int i = 0; i < PORTS; i++) {
+        TEST_ASSERT_TRUE(scans[i][0].reads >= 1);
+        TEST_ASSERT_EQUAL_UINT32(0, scans[i][0].errors);
+        TEST_ASSERT_EQUAL_UINT32(scans[i][0].reads, ports[i].cycles);
+        TEST_ASSERT_EQUAL_UINT16(7000, data[i][0]);
+        TEST_ASSERT_EQUAL_UINT16(7001, data[i][1]);
+        TEST_ASSERT_EQUAL_UINT16(8500, data[i][2]);
+    }
+}
+
+void test_next_frame_waits_for_line_silence(void) {
+    uint16_t data[3];
+    add_port(0, 9600, 500);
+    TEST_ASSERT_EQUAL(0, mb_ports_add_poll(&engine, 0, &polls[0], data, 3, NULL, NULL));
+
+    // 11-bit characters at 9600 baud, 3.5 of them between frames
+    TEST_ASSERT_EQUAL_UINT32(1146, ports[0].line.char_us);
+    TEST_ASSERT_EQUAL_UINT32(4011, ports[0].line.gap_us);
+
+    // First request out, answered at once
+    TEST_ASSERT_EQUAL(0, mb_ports_run(&engine, 0));
+    TEST_ASSERT_EQUAL_UINT16(0, peers[0].requests);
+    while (!serve(&peers[0])) {
+        TEST_ASSERT_TRUE(mb_ports_run(&engine, 1) >= 0);
+    }
+    uint64_t answered_us = now_us();
+
+    // The second request only leaves once the response has been silent for 3.5 characters
+    while (peers[0].requests < 2) {
+        TEST_ASSERT_TRUE(mb_ports_run(&engine, 10) >= 0);
+        if (serve(&peers[0]) && peers[0].requests == 2) {
+            break;
+        }
+    }
+    TEST_ASSERT_TRUE(now_us() - answered_us >= 4011);
+    while (scans[0][0].reads == 0) {
+        TEST_ASSERT_TRUE(mb_ports_run(&engine, 10) >= 0);
+    }
+    TEST_ASSERT_EQUAL_UINT16(8500, data[2]);
+
+    // delay_chars() arms the same timer instead of sleeping
+    mb_transport_t *transport = &masters[0].config.transport;
+    static const uint8_t frame[8] = {1, 3, 0, 0, 0, 1, 0x84, 0x0A};
+    transport->delay_chars(transport->context, 1000);
+    TEST_ASSERT_EQUAL_INT(0, transport->send(transport->context, frame, sizeof(frame)));
+
+    // The rest of a frame that was started is never held back
+    ports[0].line.tx_rest = 4;
+    TEST_ASSERT_EQUAL_INT(4, transport->send(transport->context, &frame[4], 4));
+    TEST_ASSERT_EQUAL_UINT16(0, ports[0].line.tx_rest);
+}
+
+void test_timeout_then_hang_up_stops_the_port(void) {
+    uint16_t data[3];
+    (void)signal(SIGPIPE, SIG_IGN);
+    add_port(0, 115200, 20);
+    TEST_ASSERT_EQUAL(0, mb_ports_add_poll(&engine, 0, &polls[0], data, 3, NULL, NULL));
+
+    // Unanswered: the wait ends at the response deadline
+    uint64_t start = now_us();
+    int completed  = 0;
+    while (completed == 0) {
+        completed = mb_ports_run(&engine, 1000);
+        TEST_ASSERT_TRUE(completed >= 0);
+    }
+    TEST_ASSERT_TRUE(now_us() - start < 500000);
+    TEST_ASSERT_EQUAL(MB_ERROR_TIMEOUT, scans[0][0].result);
+    TEST_ASSERT_EQUAL_UINT32(1, scans[0][0].errors);
+
+    close(peers[0].fd);
+    peers[0].fd = -1;
+    for (int round = 0; round < 10 && !ports[0].failed; round++) {
+        TEST_ASSERT_TRUE(mb_ports_run(&engine, 100) >= 0);
+    }
+    TEST_ASSERT_TRUE(ports[0].failed);
+    TEST_ASSERT_EQUAL(MB_ERROR_TRANSPORT, scans[0][0].result);
+
+    // A failed port is left alone
+    TEST_ASSERT_EQUAL(0, mb_ports_run(&engine, 0));
+}
+
+void test_add_rejects_bad_ports(void) {
+    mb_link_t link     = {.bit_rate = 19200};
+    mb_config_t config = mb_config_default(MB_MODE_TCP);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&masters[3], &config));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_ports_add(&engine, &masters[3], 0, &link, NULL, 0));
+
+    mb_ports_t small;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_ports_init(&small, ports, 0));
+    config = mb_config_default(MB_MODE_RTU);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&masters[1], &config));
+    TEST_ASSERT_EQUAL(MB_ERROR_TOO_MANY_BLOCKS,
+                      mb_ports_add(&small, &masters[1], 0, &link, NULL, 0));
+    mb_ports_close(&small);
+
+    // A poll compiled for another framing, and a full scan list
+    uint16_t data[3];
+    add_port(0, 19200, 100);
+    mb_poll_plan_t tcp_poll;
+    memset(&tcp_poll, 0, sizeof(tcp_poll));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile(&masters[3], &request, &tcp_poll));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_ports_add_poll(&engine, 0, &tcp_poll, data, 3, NULL, NULL));
+    mb_poll_plan_free(&tcp_poll);
+    TEST_ASSERT_EQUAL(MB_ERROR_BUFFER_TOO_SMALL,
+                      mb_ports_add_poll(&engine, 0, &polls[0], data, 2, NULL, NULL));
+    TEST_ASSERT_EQUAL(0, mb_ports_add_poll(&engine, 0, &polls[0], data, 3, NULL, NULL));
+    TEST_ASSERT_EQUAL(1, mb_ports_add_poll(&engine, 0, &polls[0], data, 3, NULL, NULL));
+    TEST_ASSERT_EQUAL(MB_ERROR_TOO_MANY_BLOCKS,
+                      mb_ports_add_poll(&engine, 0, &polls[0], data, 3, NULL, NULL));
+}
+
+void test_serial_open_sets_up_a_tty(void) {
+    int pty = posix_openpt(O_RDWR | O_NOCTTY);
+    if (pty < 0 || grantpt(pty) != 0 || unlockpt(pty) != 0) {
+        TEST_IGNORE_MESSAGE("no pseudo terminals");
+    }
+
+    int fd         = -1;
+    mb_link_t link = {.bit_rate = 12345};
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_serial_open(ptsname(pty), &link, MB_MODE_RTU, &fd));
+
+    link.bit_rate = 19200;
+    link.parity   = MB_PARITY_EVEN;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_serial_open(ptsname(pty), &link, MB_MODE_RTU, &fd));
+
+    // Parity and character size are not observable on a pty, which always reports CS8
+    struct termios tio;
+    TEST_ASSERT_EQUAL_INT(0, tcgetattr(fd, &tio));
+    TEST_ASSERT_EQUAL(B19200, cfgetospeed(&tio));
+    TEST_ASSERT_TRUE((tio.c_lflag & (ICANON | ECHO)) == 0);
+    TEST_ASSERT_EQUAL_UINT8(1, tio.c_cc[VMIN]);
+    TEST_ASSERT_TRUE((fcntl(fd, F_GETFL) & O_NONBLOCK) != 0);
+
+    // Raw: bytes pass unchanged, and nothing waiting is EAGAIN, not a hang-up
+    static const uint8_t frame[4] = {0x01, 0x0D, 0x0A, 0x03};
+    uint8_t got[8];
+    TEST_ASSERT_EQUAL_INT(-1, (int)read(fd, got, sizeof(got)));
+    TEST_ASSERT_EQUAL_INT(4, (int)write(pty, frame, sizeof(frame)));
+    usleep(10000);
+    TEST_ASSERT_EQUAL_INT(4, (int)read(fd, got, sizeof(got)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frame, got, 4);
+    close(fd);
+
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_serial_open(ptsname(pty), &link, MB_MODE_TCP, &fd));
+    close(pty);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_one_thread_scans_every_port);
+    RUN_TEST(test_next_frame_waits_for_line_silence);
+    RUN_TEST(test_timeout_then_hang_up_stops_the_port);
+    RUN_TEST(test_add_rejects_bad_ports);
+    RUN_TEST(test_serial_open_sets_up_a_tty);
+
+    return UNITY_END();
+}
@@ -0,0 +1,489 @@
+/**
+ * @file test_profile.c
+ * @brief Unit tests for learned per-slave profiles
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+#include "mock_line.h"
+
+#include <string.h>
+
+#define CHAR_US 1146u  // 11 bits at 9600 bit/s
+
+/**
+ * @brief Two slaves of different turnaround behind the mock line
+ *
+ * recv() advances the clock by the slave's latency plus the response's
+ * wire time, as seen by a blocking master.
+ */
+typedef struct {
+    uint32_t latency_us[3];
+
+    // Slave 1 capabilities: unmapped registers and the largest read
+    uint16_t hole_first;
+    uint16_t hole_last;
+    uint16_t max_quantity;
+
+    // Silent slave; a timed-out recv() waits the timeout set by the master
+    uint8_t dead;
+} slaves_t;
+
+static mock_line_t line;
+static slaves_t slaves;
+
+static bool check_request(mock_line_t *l, const uint8_t *frame, size_t len) {
+    (void)frame;
+    (void)len;
+    if (l->unit == slaves.dead) {
+        return true;
+    }
+    if (l->unit == 1 && slaves.max_quantity > 0 && l->quantity > slaves.max_quantity) {
+        mock_line_exception(l, MB_EX_ILLEGAL_DATA_VALUE);
+        return true;
+    }
+    if (l->unit == 1 && slaves.hole_first <= slaves.hole_last && l->start <= slaves.hole_last &&
+        slaves.hole_first < l->start + l->quantity) {
+        mock_line_exception(l, MB_EX_ILLEGAL_DATA_ADDRESS);
+        return true;
+    }
+    return false;
+}
+
+static void response_time(mock_line_t *l, size_t len) {
+    l->clock_us += len > 0 ? slaves.latency_us[l->unit] + (uint32_t)len * CHAR_US
+                           : l->timeout_ms * 1000u;
+}
+
+static mb_slave_profile_t entries[4];
+static mb_profile_table_t profiles;
+static mb_master_t master;
+
+void setUp(void) {
+    memset(&line, 0, sizeof(line));
+    line.clock_us = 0xFFFF0000u;  // Wraps during the test
+    line.respond  = check_request;
+    line.received = response_time;
+
+    memset(&slaves, 0, sizeof(slaves));
+    slaves.latency_us[1] = 1000;
+    slaves.latency_us[2] = 80000;
+    slaves.hole_first    = 1;  // No hole
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_profiles_init(&profiles, entries, 4, CHAR_US));
+
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    mock_line_attach(&line, &config);
+    config.transport.clock_us    = mock_line_clock;
+    config.transport.set_timeout = mock_line_set_timeout;
+    config.profiles              = &profiles;
+    config.planner               = MB_PLANNER_OPTIMAL;  // Merges purely on cost
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+}
+
+void tearDown(void) {
+}
+
+void test_fit_separates_latency_from_char_time(void) {
+    // Slow inter-character timing: 2000 us per char after a 6 ms turnaround
+    static const uint16_t lengths[] = {7, 45, 7, 85, 25, 7};
+    for (int i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL(MB_SUCCESS,
+                          mb_profile_record(&profiles, 9, lengths[i], 6000u + lengths[i] * 2000u));
+    }
+
+    const mb_slave_profile_t *profile = mb_profile_find(&profiles, 9);
+    TEST_ASSERT_NOT_NULL(profile);
+    TEST_ASSERT_EQUAL_UINT16(6, profile->samples);
+    TEST_ASSERT_UINT32_WITHIN(1, 2000, profile->char_us);
+    TEST_ASSERT_UINT32_WITHIN(2, 6000, profile->latency_us);
+
+    // 6 ms in the slave's 2 ms characters
+    TEST_ASSERT_EQUAL_UINT8(3, mb_profile_latency_chars(&profiles, 9, 2));
+}
+
+void test_constant_length_assumes_nominal_char_time(void) {
+    for (int i = 0; i < 4; i++) {
+        mb_profile_record(&profiles, 3, 9, 20000u + 9u * CHAR_US);
+    }
+
+    const mb_slave_profile_t *profile = mb_profile_find(&profiles, 3);
+    TEST_ASSERT_EQUAL_UINT32(CHAR_US, profile->char_us);
+    TEST_ASSERT_UINT32_WITHIN(2, 20000, profile->latency_us);
+    TEST_ASSERT_EQUAL_UINT8(17, mb_profile_latency_chars(&profiles, 3, 2));
+}
+
+void test_fallback_until_enough_samples(void) {
+    TEST_ASSERT_EQUAL_UINT8(2, mb_profile_latency_chars(NULL, 1, 2));
+    TEST_ASSERT_EQUAL_UINT8(2, mb_profile_latency_chars(&profiles, 1, 2));
+
+    mb_profile_record(&profiles, 1, 7, 50000);
+    mb_profile_record(&profiles, 1, 7, 50000);
+    TEST_ASSERT_EQUAL_UINT8(2, mb_profile_latency_chars(&profiles, 1, 2));
+    mb_profile_record(&profiles, 1, 7, 50000);
+    TEST_ASSERT_EQUAL_UINT8(37, mb_profile_latency_chars(&profiles, 1, 2));
+}
+
+void test_timeout_tracks_turnaround_and_backs_off(void) {
+    mb_timeout_policy_t policy = {5, 100, 0, 0};
+
+    // Unknown slave: the static timeout, within the limits
+    TEST_ASSERT_EQUAL_UINT32(100, mb_profile_timeout_ms(&profiles, 5, 10, &policy, 1000));
+    TEST_ASSERT_EQUAL_UINT32(5, mb_profile_timeout_ms(&profiles, 5, 10, &policy, 3));
+
+    // First sample: srtt 20 ms, deviation 10 ms; plus 10 response chars
+    mb_profile_record(&profiles, 5, 10, 20000u + 10u * CHAR_US);
+    TEST_ASSERT_EQUAL_UINT32(72, mb_profile_timeout_ms(&profiles, 5, 10, &policy, 1000));
+
+    // A steady turnaround shrinks the deviation
+    mb_profile_record(&profiles, 5, 10, 20000u + 10u * CHAR_US);
+    TEST_ASSERT_EQUAL_UINT32(20000, mb_profile_find(&profiles, 5)->srtt_us);
+    TEST_ASSERT_EQUAL_UINT32(7500, mb_profile_find(&profiles, 5)->rttvar_us);
+    TEST_ASSERT_EQUAL_UINT32(62, mb_profile_timeout_ms(&profiles, 5, 10, &policy, 1000));
+
+    // Each timeout in a row doubles the wait, up to the ceiling
+    TEST_ASSERT_FALSE(mb_profile_record_timeout(&profiles, 5, &policy, 0));
+    TEST_ASSERT_EQUAL_UINT32(100, mb_profile_timeout_ms(&profiles, 5, 10, &policy, 1000));
+    policy.max_ms = 1000;
+    TEST_ASSERT_EQUAL_UINT32(123, mb_profile_timeout_ms(&profiles, 5, 10, &policy, 1000));
+
+    // An answer resets the back-off
+    mb_profile_record(&profiles, 5, 10, 20000u + 10u * CHAR_US);
+    TEST_ASSERT_EQUAL_UINT8(0, mb_profile_find(&profiles, 5)->timeouts);
+}
+
+void test_learned_timeout_is_passed_to_transport(void) {
+    master.config.timeouts = (mb_timeout_policy_t){5, 500, 0, 0};
+    uint16_t value         = 0;
+
+    // Nothing learned yet: config.timeout_ms, capped
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_master_read_single(&master, 2, MB_FC_READ_HOLDING_REGISTERS, 0, 1, &value));
+    TEST_ASSERT_EQUAL_UINT32(500, line.timeout_ms);
+
+    for (int i = 0; i < 16; i++) {
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_single(&master, 2,
+                                                            MB_FC_READ_HOLDING_REGISTERS, 0, 1,
+                                                            &value));
+    }
+
+    // 80 ms turnaround, a settled deviation and 7 response chars
+    TEST_ASSERT_UINT32_WITHIN(4, 90, line.timeout_ms);
+
+    // The fast slave gets its own, much shorter timeout
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_master_read_single(&master, 1, MB_FC_READ_HOLDING_REGISTERS, 0, 1, &value));
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_master_read_single(&master, 1, MB_FC_READ_HOLDING_REGISTERS, 0, 1, &value));
+    TEST_ASSERT_TRUE(line.timeout_ms < 20);
+}
+
+void test_dead_slave_goes_offline_and_is_probed(void) {
+    master.config.timeouts = (mb_timeout_policy_t){5, 200, 3, 1000};
+    uint16_t value         = 0;
+    slaves.dead              = 2;
+
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(MB_ERROR_TIMEOUT, mb_master_read_single(&master, 2,
+                                                                  MB_FC_READ_HOLDING_REGISTERS,
+                                                                  0, 1, &value));
+    }
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+    TEST_ASSERT_EQUAL_UINT8(1, mb_profile_find(&profiles, 2)->offline);
+
+    // Offline: nothing goes on the line, other slaves are unaffected
+    TEST_ASSERT_EQUAL(MB_ERROR_SLAVE_OFFLINE,
+                      mb_master_read_single(&master, 2, MB_FC_READ_HOLDING_REGISTERS, 0, 1, &value));
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+    TEST_ASSERT_EQUAL_UINT32(1, master.stats.offline_skipped);
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_master_read_single(&master, 1, MB_FC_READ_HOLDING_REGISTERS, 0, 1, &value));
+    TEST_ASSERT_EQUAL_UINT16(4, line.requests);
+
+    // One probe per interval
+    line.clock_us += 1000000u;
+    TEST_ASSERT_EQUAL(MB_ERROR_TIMEOUT,
+                      mb_master_read_single(&master, 2, MB_FC_READ_HOLDING_REGISTERS, 0, 1, &value));
+    TEST_ASSERT_EQUAL(MB_ERROR_SLAVE_OFFLINE,
+                      mb_master_read_single(&master, 2, MB_FC_READ_HOLDING_REGISTERS, 0, 1, &value));
+    TEST_ASSERT_EQUAL_UINT16(5, line.requests);
+
+    // An answered probe brings the slave back
+    slaves.dead = 0;
+    line.clock_us += 1000000u;
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_master_read_single(&master, 2, MB_FC_READ_HOLDING_REGISTERS, 0, 1, &value));
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_master_read_single(&master, 2, MB_FC_READ_HOLDING_REGISTERS, 0, 1, &value));
+    TEST_ASSERT_EQUAL_UINT8(0, mb_profile_find(&profiles, 2)->offline);
+    TEST_ASSERT_EQUAL_STRING("Slave offline", mb_error_to_string(MB_ERROR_SLAVE_OFFLINE));
+}
+
+void test_table_is_sorted_and_bounded(void) {
+    static const uint8_t ids[] = {40, 7, 200, 1};
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_NOT_NULL(mb_profile_acquire(&profiles, ids[i]));
+    }
+    TEST_ASSERT_EQUAL_UINT16(4, profiles.count);
+    TEST_ASSERT_EQUAL_UINT8(1, entries[0].slave_id);
+    TEST_ASSERT_EQUAL_UINT8(7, entries[1].slave_id);
+    TEST_ASSERT_EQUAL_UINT8(40, entries[2].slave_id);
+    TEST_ASSERT_EQUAL_UINT8(200, entries[3].slave_id);
+
+    TEST_ASSERT_EQUAL_PTR(&entries[2], mb_profile_acquire(&profiles, 40));
+    TEST_ASSERT_NULL(mb_profile_acquire(&profiles, 41));
+    TEST_ASSERT_EQUAL(MB_ERROR_TOO_MANY_BLOCKS, mb_profile_record(&profiles, 41, 7, 1000));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_profiles_init(&profiles, entries, 4, 0));
+}
+
+/**
+ * @brief Read {0, 21} (a 20-register gap) and return the number of plans
+ */
+static uint16_t plans_for_gap(uint8_t slave_id) {
+    static uint16_t gap_addresses[] = {0, 21};
+    mb_read_request_t request       = {.slave_id      = slave_id,
+                                       .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                       .addresses     = gap_addresses,
+                                       .address_count = 2};
+    static mb_poll_plan_t poll;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile(&master, &request, &poll));
+    uint16_t count = poll.plan_count;
+    mb_poll_plan_free(&poll);
+    return count;
+}
+
+void test_slow_slave_learns_aggressive_merging(void) {
+    // 40 gap chars outweigh the default 17-char round-trip overhead
+    TEST_ASSERT_EQUAL_UINT16(2, plans_for_gap(1));
+    TEST_ASSERT_EQUAL_UINT16(2, plans_for_gap(2));
+
+    // Short and long reads train both slaves
+    static uint16_t one[]  = {0};
+    static uint16_t many[30];
+    for (uint16_t i = 0; i < 30; i++) {
+        many[i] = i;
+    }
+    uint16_t data[30];
+    for (uint8_t slave = 1; slave <= 2; slave++) {
+        for (int i = 0; i < 4; i++) {
+            mb_read_request_t request = {.slave_id      = slave,
+                                         .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                         .addresses     = (i & 1) ? many : one,
+                                         .address_count = (uint16_t)((i & 1) ? 30 : 1)};
+            TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request, data, 30));
+        }
+    }
+
+    const mb_slave_profile_t *fast = mb_profile_find(&profiles, 1);
+    const mb_slave_profile_t *slow = mb_profile_find(&profiles, 2);
+    TEST_ASSERT_EQUAL_UINT16(4, fast->samples);
+    TEST_ASSERT_UINT32_WITHIN(2, CHAR_US, fast->char_us);
+    TEST_ASSERT_UINT32_WITHIN(20, 1000, fast->latency_us);
+    TEST_ASSERT_UINT32_WITHIN(20, 80000, slow->latency_us);
+
+    // Fast slave: 1 char of latency, still not worth it. Slow slave: 70 chars
+    TEST_ASSERT_EQUAL_UINT8(1, mb_profile_latency_chars(&profiles, 1, 2));
+    TEST_ASSERT_EQUAL_UINT8(70, mb_profile_latency_chars(&profiles, 2, 2));
+    TEST_ASSERT_EQUAL_UINT16(2, plans_for_gap(1));
+    TEST_ASSERT_EQUAL_UINT16(1, plans_for_gap(2));
+}
+
+void test_holes_are_joined_and_bounded(void) {
+    TEST_ASSERT_TRUE(mb_profile_add_hole(&profiles, 5, MB_FC_READ_HOLDING_REGISTERS, 10, 19));
+    TEST_ASSERT_TRUE(mb_profile_add_hole(&profiles, 5, MB_FC_READ_HOLDING_REGISTERS, 20, 24));
+    TEST_ASSERT_FALSE(mb_profile_add_hole(&profiles, 5, MB_FC_READ_HOLDING_REGISTERS, 12, 15));
+    TEST_ASSERT_TRUE(mb_profile_add_hole(&profiles, 5, MB_FC_READ_COILS, 10, 19));
+
+    const mb_slave_profile_t *profile = mb_profile_find(&profiles, 5);
+    TEST_ASSERT_EQUAL_UINT8(2, profile->hole_count);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_READ_COILS, profile->holes[0].function_code);
+    TEST_ASSERT_EQUAL_UINT16(10, profile->holes[1].first);
+    TEST_ASSERT_EQUAL_UINT16(24, profile->holes[1].last);
+
+    TEST_ASSERT_TRUE(
+        mb_profile_gap_forbidden(&profiles, 5, MB_FC_READ_HOLDING_REGISTERS, 0, 10));
+    TEST_ASSERT_FALSE(
+        mb_profile_gap_forbidden(&profiles, 5, MB_FC_READ_HOLDING_REGISTERS, 25, 40));
+    TEST_ASSERT_FALSE(mb_profile_gap_forbidden(&profiles, 5, MB_FC_READ_INPUT_REGISTERS, 10, 19));
+    TEST_ASSERT_FALSE(mb_profile_gap_forbidden(NULL, 5, MB_FC_READ_HOLDING_REGISTERS, 10, 19));
+
+    // A full set widens the nearest hole rather than forgetting one
+    for (uint16_t i = 0; i < MB_PROFILE_MAX_HOLES; i++) {
+        mb_profile_add_hole(&profiles, 5, MB_FC_READ_HOLDING_REGISTERS, (uint16_t)(100 + 10 * i),
+                            (uint16_t)(101 + 10 * i));
+    }
+    TEST_ASSERT_EQUAL_UINT8(MB_PROFILE_MAX_HOLES, profile->hole_count);
+    TEST_ASSERT_TRUE(
+        mb_profile_gap_forbidden(&profiles, 5, MB_FC_READ_HOLDING_REGISTERS, 160, 161));
+}
+
+void test_exception_learns_hole_and_replans(void) {
+    static uint16_t addresses[] = {0, 1, 2, 3, 4, 10, 11, 12, 13, 14};
+    mb_read_request_t request   = {.slave_id      = 1,
+                                   .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                   .addresses     = addresses,
+                                   .address_count = 10};
+    uint16_t data[10];
+    slaves.hole_first = 5;
+    slaves.hole_last  = 9;
+
+    // The merged read is rejected once, then the two blocks are read apart
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request, data, 10));
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 10);
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+
+    const mb_slave_profile_t *profile = mb_profile_find(&profiles, 1);
+    TEST_ASSERT_EQUAL_UINT8(1, profile->hole_count);
+    TEST_ASSERT_EQUAL_UINT16(5, profile->holes[0].first);
+    TEST_ASSERT_EQUAL_UINT16(9, profile->holes[0].last);
+
+    // Later cycles never see the exception
+    line.requests = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request, data, 10));
+    TEST_ASSERT_EQUAL_UINT16(2, line.requests);
+
+    // Only unrequested units are suspects
+    mb_request_plan_t plan = {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                              .start_address = 50, .quantity = 1};
+    mb_scatter_entry_t entry = {.plan_index = 0, .offset = 0, .dest_index = 0};
+    TEST_ASSERT_FALSE(
+        mb_profile_learn_exception(&profiles, &plan, &entry, 1, MB_EX_ILLEGAL_DATA_ADDRESS));
+}
+
+void test_poll_plan_is_refreshed_after_exception(void) {
+    static uint16_t addresses[] = {0, 1, 2, 3, 4, 10, 11, 12, 13, 14};
+    mb_read_request_t request   = {.slave_id      = 1,
+                                   .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                   .addresses     = addresses,
+                                   .address_count = 10};
+    static mb_poll_plan_t poll;
+    uint16_t data[10];
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile(&master, &request, &poll));
+    TEST_ASSERT_EQUAL_UINT16(1, poll.plan_count);
+
+    slaves.hole_first = 5;
+    slaves.hole_last  = 9;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_execute_poll(&master, &poll, data, 10));
+    TEST_ASSERT_EQUAL_UINT16(2, poll.plan_count);
+    TEST_ASSERT_FALSE(poll.stale);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 10);
+
+    line.requests = 0;
+    memset(data, 0, sizeof(data));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_execute_poll(&master, &poll, data, 10));
+    TEST_ASSERT_EQUAL_UINT16(2, line.requests);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 10);
+
+    mb_poll_plan_free(&poll);
+}
+
+void test_illegal_value_halves_quantity(void) {
+    static uint16_t addresses[60];
+    for (uint16_t i = 0; i < 60; i++) {
+        addresses[i] = i;
+    }
+    mb_read_request_t request = {.slave_id      = 1,
+                                 .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                 .addresses     = addresses,
+                                 .address_count = 60};
+    uint16_t data[60];
+    slaves.max_quantity = 40;
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request, data, 60));
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 60);
+    TEST_ASSERT_EQUAL_UINT16(
+        30, mb_profile_max_quantity(&profiles, 1, MB_FC_READ_HOLDING_REGISTERS));
+    TEST_ASSERT_EQUAL_UINT16(0, mb_profile_max_quantity(&profiles, 1, MB_FC_READ_COILS));
+
+    // Other exceptions teach nothing
+    mb_request_plan_t plan = {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                              .start_address = 0, .quantity = 20};
+    TEST_ASSERT_FALSE(
+        mb_profile_learn_exception(&profiles, &plan, NULL, 0, MB_EX_SLAVE_DEVICE_FAILURE));
+}
+
+#define IMAGE_WORDS ((sizeof(mb_profile_image_t) + 4 * sizeof(mb_slave_profile_t)) / 4)
+
+void test_image_survives_restart(void) {
+    static uint32_t image[IMAGE_WORDS];
+    static uint32_t restarted[IMAGE_WORDS];
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_profiles_format(&profiles, image, sizeof(image), CHAR_US));
+    TEST_ASSERT_EQUAL_UINT16(4, profiles.capacity);
+
+    static uint16_t addresses[] = {0, 1, 2, 3, 4, 10, 11, 12, 13, 14};
+    mb_read_request_t request   = {.slave_id      = 1,
+                                   .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                   .addresses     = addresses,
+                                   .address_count = 10};
+    uint16_t data[10];
+    slaves.hole_first = 5;
+    slaves.hole_last  = 9;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request, data, 10));
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+    TEST_ASSERT_EQUAL_UINT16(1, ((const mb_profile_image_t *)image)->count);
+
+    // Restart: the same bytes, read back into a fresh table
+    memcpy(restarted, image, sizeof(image));
+    memset(&profiles, 0, sizeof(profiles));
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_profiles_attach(&profiles, restarted, sizeof(restarted), CHAR_US));
+    TEST_ASSERT_EQUAL_UINT16(1, profiles.count);
+
+    line.requests = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request, data, 10));
+    TEST_ASSERT_EQUAL_UINT16(2, line.requests);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 10);
+}
+
+void test_damaged_image_is_rejected(void) {
+    static uint32_t image[IMAGE_WORDS];
+    mb_profile_image_t *header = (mb_profile_image_t *)image;
+    mb_profiles_format(&profiles, image, sizeof(image), CHAR_US);
+    mb_profile_acquire(&profiles, 3);
+    mb_profile_acquire(&profiles, 7);
+
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_profiles_attach(&profiles, (uint8_t *)image + 1, sizeof(image) - 4,
+                                         CHAR_US));
+    TEST_ASSERT_EQUAL(MB_ERROR_BUFFER_TOO_SMALL, mb_profiles_attach(&profiles, image, 8, CHAR_US));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_FRAME,
+                      mb_profiles_attach(&profiles, image, sizeof(image) - 4, CHAR_US));
+
+    header->record_size++;
+    TEST_ASSERT_EQUAL(MB_ERROR_NOT_SUPPORTED,
+                      mb_profiles_attach(&profiles, image, sizeof(image), CHAR_US));
+    header->record_size--;
+
+    // Duplicate slave IDs
+    mb_slave_profile_t *records = (mb_slave_profile_t *)(void *)(header + 1);
+    records[1].slave_id         = 3;
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_FRAME,
+                      mb_profiles_attach(&profiles, image, sizeof(image), CHAR_US));
+    records[1].slave_id = 7;
+
+    header->magic = 0x4D425046u;  // Other byte order
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_FRAME,
+                      mb_profiles_attach(&profiles, image, sizeof(image), CHAR_US));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_fit_separates_latency_from_char_time);
+    RUN_TEST(test_constant_length_assumes_nominal_char_time);
+    RUN_TEST(test_fallback_until_enough_samples);
+    RUN_TEST(test_timeout_tracks_turnaround_and_backs_off);
+    RUN_TEST(test_learned_timeout_is_passed_to_transport);
+    RUN_TEST(test_dead_slave_goes_offline_and_is_probed);
+    RUN_TEST(test_table_is_sorted_and_bounded);
+    RUN_TEST(test_slow_slave_learns_aggressive_merging);
+    RUN_TEST(test_holes_are_joined_and_bounded);
+    RUN_TEST(test_exception_learns_hole_and_replans);
+    RUN_TEST(test_poll_plan_is_refreshed_after_exception);
+    RUN_TEST(test_illegal_value_halves_quantity);
+    RUN_TEST(test_image_survives_restart);
+    RUN_TEST(test_damaged_image_is_rejected);
+
+    return UNITY_END();
+}
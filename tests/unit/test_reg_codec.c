@@ -0,0 +1,126 @@
+/**
+ * @file test_reg_codec.c
+ * @brief Unit tests for register decoding and typed value assembly
+ */
+
+#include "unity.h"
+#include "utils/reg_codec.h"
+
+#include <string.h>
+
+static uint8_t payload[512];
+
+void setUp(void) {
+    uint32_t state = 0x9E3779B9u;
+    for (size_t i = 0; i < sizeof(payload); i++) {
+        state      = state * 1103515245u + 12345u;
+        payload[i] = (uint8_t)(state >> 16);
+    }
+}
+
+void tearDown(void) {
+    (void)mb_regs_use_simd(true);
+}
+
+void test_decode_matches_scalar_for_every_length_and_alignment(void) {
+    const bool kernels[] = {false, true};
+
+    for (size_t k = 0; k < 2; k++) {
+        (void)mb_regs_use_simd(kernels[k]);
+
+        for (size_t start = 0; start < 3; start++) {
+            for (size_t count = 0; count <= 40; count++) {
+                uint16_t regs[48];
+                memset(regs, 0xCC, sizeof(regs));
+
+                mb_regs_decode(&regs[1], &payload[start], count);
+
+                TEST_ASSERT_EQUAL_HEX16(0xCCCC, regs[0]);
+                for (size_t i = 0; i < count; i++) {
+                    uint16_t expected = (uint16_t)(((uint16_t)payload[start + i * 2] << 8) |
+                                                   payload[start + i * 2 + 1]);
+                    TEST_ASSERT_EQUAL_HEX16(expected, regs[1 + i]);
+                }
+                TEST_ASSERT_EQUAL_HEX16(0xCCCC, regs[1 + count]);
+            }
+        }
+    }
+}
+
+void test_value_registers(void) {
+    TEST_ASSERT_EQUAL_UINT8(1, mb_value_registers(MB_VALUE_INT16));
+    TEST_ASSERT_EQUAL_UINT8(2, mb_value_registers(MB_VALUE_FLOAT32));
+    TEST_ASSERT_EQUAL_UINT8(4, mb_value_registers(MB_VALUE_FLOAT64));
+    TEST_ASSERT_EQUAL_UINT8(0, mb_value_registers((mb_value_type_t)42));
+}
+
+/**
+ * @brief Store the registers of a 32-bit value in the given wire order
+ */
+static uint32_t store_u32(mb_word_order_t order, uint16_t first, uint16_t second) {
+    uint32_t value = 0;
+    // Registers may arrive in any order
+    mb_value_store_register(&value, MB_VALUE_UINT32, order, 1, second);
+    mb_value_store_register(&value, MB_VALUE_UINT32, order, 0, first);
+    return value;
+}
+
+void test_word_orders_of_32_bit_values(void) {
+    // 0xAABBCCDD in each layout
+    TEST_ASSERT_EQUAL_HEX32(0xAABBCCDD, store_u32(MB_ORDER_ABCD, 0xAABB, 0xCCDD));
+    TEST_ASSERT_EQUAL_HEX32(0xAABBCCDD, store_u32(MB_ORDER_CDAB, 0xCCDD, 0xAABB));
+    TEST_ASSERT_EQUAL_HEX32(0xAABBCCDD, store_u32(MB_ORDER_BADC, 0xBBAA, 0xDDCC));
+    TEST_ASSERT_EQUAL_HEX32(0xAABBCCDD, store_u32(MB_ORDER_DCBA, 0xDDCC, 0xBBAA));
+}
+
+void test_signed_and_float_values(void) {
+    int16_t i16 = 0;
+    mb_value_store_register(&i16, MB_VALUE_INT16, MB_ORDER_ABCD, 0, 0xFFFE);
+    TEST_ASSERT_EQUAL_INT16(-2, i16);
+
+    int32_t i32 = 0;
+    mb_value_store_register(&i32, MB_VALUE_INT32, MB_ORDER_ABCD, 0, 0xFFFF);
+    mb_value_store_register(&i32, MB_VALUE_INT32, MB_ORDER_ABCD, 1, 0xFF85);
+    TEST_ASSERT_EQUAL_INT32(-123, i32);
+
+    // 1.5f = 0x3FC00000, low word first
+    float f32 = 0.0f;
+    mb_value_store_register(&f32, MB_VALUE_FLOAT32, MB_ORDER_CDAB, 0, 0x0000);
+    mb_value_store_register(&f32, MB_VALUE_FLOAT32, MB_ORDER_CDAB, 1, 0x3FC0);
+    TEST_ASSERT_TRUE(f32 == 1.5f);
+
+    // -2.25 = 0xC002000000000000, big-endian
+    double f64        = 0.0;
+    const uint16_t w[] = {0xC002, 0x0000, 0x0000, 0x0000};
+    for (uint8_t i = 0; i < 4; i++) {
+        mb_value_store_register(&f64, MB_VALUE_FLOAT64, MB_ORDER_ABCD, i, w[i]);
+    }
+    TEST_ASSERT_TRUE(f64 == -2.25);
+
+    // Little-endian wire bytes 11 22 33 .. 88
+    uint64_t u64        = 0;
+    const uint16_t le[] = {0x1122, 0x3344, 0x5566, 0x7788};
+    for (uint8_t i = 0; i < 4; i++) {
+        mb_value_store_register(&u64, MB_VALUE_UINT64, MB_ORDER_DCBA, i, le[i]);
+    }
+    TEST_ASSERT_TRUE(u64 == 0x8877665544332211ULL);
+}
+
+void test_store_ignores_words_beyond_the_value(void) {
+    uint32_t guard[2] = {0x11111111u, 0x22222222u};
+    mb_value_store_register(&guard[0], MB_VALUE_UINT32, MB_ORDER_ABCD, 2, 0xFFFF);
+    TEST_ASSERT_EQUAL_HEX32(0x11111111u, guard[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x22222222u, guard[1]);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_decode_matches_scalar_for_every_length_and_alignment);
+    RUN_TEST(test_value_registers);
+    RUN_TEST(test_word_orders_of_32_bit_values);
+    RUN_TEST(test_signed_and_float_values);
+    RUN_TEST(test_store_ignores_words_beyond_the_value);
+
+    return UNITY_END();
+}
@@ -0,0 +1,390 @@
+/**
+ * @file test_request_optimizer.c
+ * @brief Unit tests for the request optimization pipeline and scatter map
+ */
+
+#include "unity.h"
+#include "core/char_model.h"
+#include "master/request_optimizer.h"
+#include "smartmodbus/mb_error.h"
+
+#include <string.h>
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_optimize_merges_small_gap_into_one_plan(void) {
+    uint16_t addresses[] = {100, 101, 102, 105, 106, 107};
+    mb_read_request_t request = {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                 .addresses = addresses, .address_count = 6};
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    mb_request_plan_t plans[4];
+    mb_scatter_entry_t scatter[6];
+    uint16_t plan_count = 0;
+
+    int ret = mb_optimize_request(&request, &config, plans, 4, &plan_count, scatter, NULL);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_UINT16(1, plan_count);
+    TEST_ASSERT_EQUAL_UINT16(100, plans[0].start_address);
+    TEST_ASSERT_EQUAL_UINT16(8, plans[0].quantity);
+    TEST_ASSERT_EQUAL_UINT16(0, plans[0].scatter_first);
+    TEST_ASSERT_EQUAL_UINT16(6, plans[0].scatter_count);
+
+    // Gap registers 103/104 are not in the map
+    const uint16_t expected_offsets[] = {0, 1, 2, 5, 6, 7};
+    for (uint16_t i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_UINT16(0, scatter[i].plan_index);
+        TEST_ASSERT_EQUAL_UINT16(expected_offsets[i], scatter[i].offset);
+        TEST_ASSERT_EQUAL_UINT16(i, scatter[i].dest_index);
+    }
+}
+
+void test_scatter_map_groups_unsorted_request_by_plan(void) {
+    // Request order deliberately interleaves two far-apart regions
+    uint16_t addresses[] = {900, 10, 901, 11};
+    mb_read_request_t request = {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                 .addresses = addresses, .address_count = 4};
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    mb_request_plan_t plans[4];
+    mb_scatter_entry_t scatter[4];
+    uint16_t plan_count = 0;
+
+    int ret = mb_optimize_request(&request, &config, plans, 4, &plan_count, scatter, NULL);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_UINT16(2, plan_count);
+    TEST_ASSERT_EQUAL_UINT16(10, plans[0].start_address);
+    TEST_ASSERT_EQUAL_UINT16(900, plans[1].start_address);
+
+    // Plan 0 entries first, request order kept within the plan
+    TEST_ASSERT_EQUAL_UINT16(2, plans[0].scatter_count);
+    TEST_ASSERT_EQUAL_UINT16(1, scatter[0].dest_index);
+    TEST_ASSERT_EQUAL_UINT16(3, scatter[1].dest_index);
+    TEST_ASSERT_EQUAL_UINT16(2, plans[1].scatter_first);
+    TEST_ASSERT_EQUAL_UINT16(0, scatter[2].dest_index);
+    TEST_ASSERT_EQUAL_UINT16(2, scatter[3].dest_index);
+    TEST_ASSERT_EQUAL_UINT16(1, scatter[3].offset);
+}
+
+void test_scatter_map_rejects_uncovered_address(void) {
+    mb_request_plan_t plans[1] = {{.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                   .start_address = 10, .quantity = 5}};
+    uint16_t addresses[] = {12, 20};
+    mb_scatter_entry_t scatter[2];
+
+    int ret = mb_build_scatter_map(addresses, 2, plans, 1, scatter);
+
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_ADDRESS, ret);
+}
+
+void test_batch_groups_by_slave_and_fc_and_interleaves_slaves(void) {
+    // Slave 2 has two FC groups, slave 1 has one; FC03 and FC04 never merge
+    mb_tag_t tags[] = {
+        {.slave_id = 2, .function_code = MB_FC_READ_INPUT_REGISTERS, .address = 10},
+        {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS, .address = 101},
+        {.slave_id = 2, .function_code = MB_FC_READ_HOLDING_REGISTERS, .address = 10},
+        {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS, .address = 100},
+        {.slave_id = 2, .function_code = MB_FC_READ_INPUT_REGISTERS, .address = 11},
+    };
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    mb_request_plan_t plans[8];
+    mb_scatter_entry_t scatter[5];
+    uint16_t plan_count = 0;
+
+    int ret = mb_optimize_batch(tags, 5, &config, plans, 8, &plan_count, scatter, NULL);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_UINT16(3, plan_count);
+
+    // Round-robin: slave 1, slave 2 (FC03), then slave 2 (FC04)
+    TEST_ASSERT_EQUAL_UINT8(1, plans[0].slave_id);
+    TEST_ASSERT_EQUAL_UINT16(100, plans[0].start_address);
+    TEST_ASSERT_EQUAL_UINT16(2, plans[0].quantity);
+    TEST_ASSERT_EQUAL_UINT8(2, plans[1].slave_id);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_READ_HOLDING_REGISTERS, plans[1].function_code);
+    TEST_ASSERT_EQUAL_UINT8(2, plans[2].slave_id);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_READ_INPUT_REGISTERS, plans[2].function_code);
+    TEST_ASSERT_EQUAL_UINT16(2, plans[2].quantity);
+
+    // Every tag maps back through its own plan to its own slot
+    bool seen[5] = {false};
+    for (uint16_t p = 0; p < plan_count; p++) {
+        for (uint16_t k = 0; k < plans[p].scatter_count; k++) {
+            const mb_scatter_entry_t *entry = &scatter[plans[p].scatter_first + k];
+            const mb_tag_t *tag = &tags[entry->dest_index];
+
+            TEST_ASSERT_EQUAL_UINT16(p, entry->plan_index);
+            TEST_ASSERT_EQUAL_UINT8(tag->slave_id, plans[p].slave_id);
+            TEST_ASSERT_EQUAL_UINT8(tag->function_code, plans[p].function_code);
+            TEST_ASSERT_EQUAL_UINT16(tag->address, plans[p].start_address + entry->offset);
+            seen[entry->dest_index] = true;
+        }
+    }
+    for (uint16_t i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE(seen[i]);
+    }
+}
+
+void test_batch_reports_too_many_plans(void) {
+    mb_tag_t tags[] = {
+        {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS, .address = 0},
+        {.slave_id = 2, .function_code = MB_FC_READ_HOLDING_REGISTERS, .address = 0},
+    };
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    mb_request_plan_t plans[1];
+    uint16_t plan_count = 0;
+
+    int ret = mb_optimize_batch(tags, 2, &config, plans, 1, &plan_count, NULL, NULL);
+
+    TEST_ASSERT_EQUAL(MB_ERROR_TOO_MANY_PLANS, ret);
+    TEST_ASSERT_EQUAL_UINT16(0, plan_count);
+}
+
+void test_window_streams_request_beyond_plan_storage(void) {
+    // 1000 contiguous registers, in reverse order: 8 full PDUs
+    static uint16_t addresses[1000];
+    static mb_scatter_entry_t scatter[1000];
+    for (uint16_t i = 0; i < 1000; i++) {
+        addresses[i] = (uint16_t)(1999 - i);
+    }
+    mb_read_request_t request = {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                 .addresses = addresses, .address_count = 1000};
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    mb_request_plan_t plans[3];
+    uint16_t plan_count = 0;
+
+    // In one piece the request needs more plans (and, static, more pool) than given
+    TEST_ASSERT_NOT_EQUAL(MB_SUCCESS,
+                          mb_optimize_request(&request, &config, plans, 3, &plan_count, NULL, NULL));
+
+    uint32_t cursor      = 0;
+    uint16_t expected    = 1000;
+    uint16_t windows     = 0;
+    uint32_t total_plans = 0;
+    while (cursor < MB_WINDOW_END) {
+        uint16_t scatter_count = 0;
+        TEST_ASSERT_EQUAL(MB_SUCCESS,
+                          mb_optimize_request_window(&request, &config, &cursor, plans, 3,
+                                                     &plan_count, scatter, 16, &scatter_count,
+                                                     NULL));
+        total_plans += plan_count;
+        windows++;
+
+        // Every entry lands on the value it was requested for
+        for (uint16_t i = 0; i < scatter_count; i++) {
+            const mb_scatter_entry_t *entry = &scatter[i];
+            TEST_ASSERT_EQUAL_UINT16(addresses[entry->dest_index],
+                                     plans[entry->plan_index].start_address + entry->offset);
+            TEST_ASSERT_TRUE(plans[entry->plan_index].quantity <= 125);
+        }
+        TEST_ASSERT_TRUE(scatter_count <= 16);
+        expected = (uint16_t)(expected - scatter_count);
+    }
+
+    TEST_ASSERT_EQUAL_UINT16(0, expected);
+    TEST_ASSERT_EQUAL_UINT16(63, windows);  // 16 addresses per window
+    TEST_ASSERT_EQUAL_UINT32(63, total_plans);
+}
+
+void test_link_timing_merges_cheap_socket_gaps(void) {
+    uint16_t addresses[] = {0, 100};
+    mb_read_request_t request = {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                 .addresses = addresses, .address_count = 2};
+    mb_config_t config = mb_config_default(MB_MODE_TCP);
+    mb_request_plan_t plans[4];
+    mb_scatter_entry_t scatter[2];
+    uint16_t plan_count = 0;
+    config.planner      = MB_PLANNER_OPTIMAL;
+
+    // Counted in characters the 99-register gap outweighs a round-trip
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_optimize_request(&request, &config, plans, 4, &plan_count, scatter, NULL));
+    TEST_ASSERT_EQUAL_UINT16(2, plan_count);
+
+    // On a 100 Mbit/s link with a 2 ms round-trip it costs 16 us
+    config.link = (mb_link_t){.bit_rate = 100000000, .latency_us = 2000};
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_optimize_request(&request, &config, plans, 4, &plan_count, scatter, NULL));
+    TEST_ASSERT_EQUAL_UINT16(1, plan_count);
+    TEST_ASSERT_EQUAL_UINT16(101, plans[0].quantity);
+}
+
+/**
+ * @brief Plan a request and weigh the plans at their full round-trip cost
+ */
+static uint32_t plan_full_cost(const mb_read_request_t *request,
+                               mb_mode_t mode,
+                               mb_planner_t planner,
+                               uint16_t *rounds) {
+    static mb_request_plan_t plans[64];
+    static mb_scatter_entry_t scatter[512];
+    mb_config_t config = mb_config_default(mode);
+    config.planner     = planner;
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_optimize_request(request, &config, plans, 64, rounds, scatter, NULL));
+
+    mb_cost_params_t params;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_init_cost_params(mode, request->function_code,
+                                                      config.latency_chars, &params));
+    uint32_t cost = 0;
+    for (uint16_t p = 0; p < *rounds; p++) {
+        cost += mb_calc_full_round_trip_cost(&params, (uint32_t)plans[p].quantity * 2);
+    }
+    return cost;
+}
+
+void test_optimal_never_takes_more_rounds_at_no_lower_cost(void) {
+    // Power meter, drive and PLC data block register maps
+    static uint16_t meter[] = {
+        3000, 3001, 3002, 3003, 3004, 3005, 3010, 3011, 3020, 3021, 3022, 3023, 3024, 3025,
+        3028, 3029, 3036, 3037, 3054, 3055, 3056, 3057, 3058, 3059, 3060, 3061, 3076, 3077,
+        3084, 3085, 3110, 3111, 3204, 3205, 3206, 3207, 3208, 3209, 3210, 3211, 3220, 3221};
+    static uint16_t drive[] = {0,   1,   2,   3,   4,   5,   8,   9,   100, 101,
+                               102, 103, 104, 105, 110, 200, 201, 202, 203, 204,
+                               205, 206, 207, 220, 221, 222, 223, 224, 225, 226};
+    static uint16_t plc[127];
+    uint16_t plc_count = 0;
+    for (uint16_t offset = 0; offset < 130; offset++) {
+        if (offset % 37 != 36) {
+            plc[plc_count++] = offset;
+        }
+    }
+
+    const mb_read_request_t requests[] = {
+        {1, MB_FC_READ_HOLDING_REGISTERS, meter, sizeof(meter) / sizeof(meter[0])},
+        {2, MB_FC_READ_INPUT_REGISTERS, drive, sizeof(drive) / sizeof(drive[0])},
+        {3, MB_FC_READ_HOLDING_REGISTERS, plc, plc_count}};
+    const mb_mode_t modes[] = {MB_MODE_RTU, MB_MODE_TCP};
+
+    for (size_t r = 0; r < sizeof(requests) / sizeof(requests[0]); r++) {
+        for (size_t m = 0; m < 2; m++) {
+            uint16_t greedy_rounds  = 0;
+            uint16_t optimal_rounds = 0;
+            uint32_t greedy  = plan_full_cost(&requests[r], modes[m], MB_PLANNER_GREEDY,
+                                              &greedy_rounds);
+            uint32_t optimal = plan_full_cost(&requests[r], modes[m], MB_PLANNER_OPTIMAL,
+                                              &optimal_rounds);
+
+            // An extra round-trip must pay for itself
+            TEST_ASSERT_TRUE(optimal <= greedy);
+            TEST_ASSERT_TRUE(optimal_rounds <= greedy_rounds || optimal < greedy);
+        }
+    }
+}
+
+/**
+ * @brief 96 tags over 8 slaves, shuffled: FC03 on every slave, FC01 on the even ones
+ */
+static uint16_t build_plant(mb_tag_t *tags) {
+    uint16_t count = 0;
+    for (uint8_t slave = 1; slave <= 8; slave++) {
+        for (uint16_t i = 0; i < 8; i++) {
+            tags[count++] = (mb_tag_t){.slave_id = slave,
+                                       .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                       .address = (uint16_t)(i * 9 + slave)};
+        }
+        if (slave % 2 == 0) {
+            for (uint16_t i = 0; i < 8; i++) {
+                tags[count++] = (mb_tag_t){.slave_id = slave, .function_code = MB_FC_READ_COILS,
+                                           .address = (uint16_t)(i * 3)};
+            }
+        }
+    }
+
+    // Deterministic shuffle so groups are scattered through the list
+    for (uint16_t i = count - 1; i > 0; i--) {
+        uint16_t j = (uint16_t)((i * 7919u) % (i + 1u));
+        mb_tag_t t = tags[i];
+        tags[i]    = tags[j];
+        tags[j]    = t;
+    }
+    return count;
+}
+
+static void assert_same_batch(const mb_request_plan_t *expected_plans,
+                              const mb_scatter_entry_t *expected_scatter,
+                              uint16_t expected_count,
+                              const mb_request_plan_t *plans,
+                              const mb_scatter_entry_t *scatter,
+                              uint16_t plan_count,
+                              uint16_t tag_count) {
+    TEST_ASSERT_EQUAL_UINT16(expected_count, plan_count);
+    for (uint16_t p = 0; p < plan_count; p++) {
+        TEST_ASSERT_EQUAL_UINT8(expected_plans[p].slave_id, plans[p].slave_id);
+        TEST_ASSERT_EQUAL_UINT8(expected_plans[p].function_code, plans[p].function_code);
+        TEST_ASSERT_EQUAL_UINT16(expected_plans[p].start_address, plans[p].start_address);
+        TEST_ASSERT_EQUAL_UINT16(expected_plans[p].quantity, plans[p].quantity);
+        TEST_ASSERT_EQUAL_UINT16(expected_plans[p].scatter_first, plans[p].scatter_first);
+        TEST_ASSERT_EQUAL_UINT16(expected_plans[p].scatter_count, plans[p].scatter_count);
+    }
+    for (uint16_t i = 0; i < tag_count; i++) {
+        TEST_ASSERT_EQUAL_UINT16(expected_scatter[i].plan_index, scatter[i].plan_index);
+        TEST_ASSERT_EQUAL_UINT16(expected_scatter[i].offset, scatter[i].offset);
+        TEST_ASSERT_EQUAL_UINT16(expected_scatter[i].dest_index, scatter[i].dest_index);
+    }
+}
+
+void test_batch_workers_match_serial_plans(void) {
+    static mb_tag_t tags[96];
+    static mb_request_plan_t serial_plans[16];
+    static mb_request_plan_t plans[16];
+    static mb_scatter_entry_t serial_scatter[96];
+    static mb_scatter_entry_t scatter[96];
+    uint16_t tag_count    = build_plant(tags);
+    uint16_t serial_count = 0;
+    uint16_t plan_count   = 0;
+
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_optimize_batch(tags, tag_count, &config, serial_plans, 16,
+                                                    &serial_count, serial_scatter, NULL));
+    TEST_ASSERT_EQUAL_UINT16(12, serial_count);
+
+    // Same output whatever the worker count (static builds stay serial)
+    for (uint8_t threads = 2; threads <= 8; threads = (uint8_t)(threads * 2)) {
+        config.planner_threads = threads;
+        memset(scatter, 0xFF, sizeof(scatter));
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_optimize_batch(tags, tag_count, &config, plans, 16,
+                                                        &plan_count, scatter, NULL));
+        assert_same_batch(serial_plans, serial_scatter, serial_count, plans, scatter, plan_count,
+                          tag_count);
+    }
+
+    // An arena sized for the serial planner still plans the batch
+    static uint8_t arena[16384];
+    size_t arena_size = mb_optimize_batch_scratch_size(tag_count);
+    TEST_ASSERT_TRUE(arena_size <= sizeof(arena));
+    for (int pass = 0; pass < 2; pass++) {
+        mb_scratch_t scratch;
+        mb_scratch_init(&scratch, arena, pass == 0 ? arena_size : sizeof(arena));
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_optimize_batch(tags, tag_count, &config, plans, 16,
+                                                        &plan_count, scatter, &scratch));
+        assert_same_batch(serial_plans, serial_scatter, serial_count, plans, scatter, plan_count,
+                          tag_count);
+        TEST_ASSERT_EQUAL(0, scratch.used);
+    }
+
+    // Errors are those of the serial loop
+    TEST_ASSERT_EQUAL(MB_ERROR_TOO_MANY_PLANS,
+                      mb_optimize_batch(tags, tag_count, &config, plans, 11, &plan_count, scatter,
+                                        NULL));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_optimize_merges_small_gap_into_one_plan);
+    RUN_TEST(test_scatter_map_groups_unsorted_request_by_plan);
+    RUN_TEST(test_scatter_map_rejects_uncovered_address);
+    RUN_TEST(test_batch_groups_by_slave_and_fc_and_interleaves_slaves);
+    RUN_TEST(test_batch_reports_too_many_plans);
+    RUN_TEST(test_window_streams_request_beyond_plan_storage);
+    RUN_TEST(test_link_timing_merges_cheap_socket_gaps);
+    RUN_TEST(test_optimal_never_takes_more_rounds_at_no_lower_cost);
+    RUN_TEST(test_batch_workers_match_serial_plans);
+
+    return UNITY_END();
+}
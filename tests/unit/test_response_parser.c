@@ -57,6 +57,68 @@ void test_parse_read_response_exception(void) {
     TEST_ASSERT_EQUAL(MB_ERROR_EXCEPTION_RESPONSE, ret);
 }
 
+void test_parse_read_registers_scatter(void) {
+    // Merged read of 4 registers; only offsets 3 and 0 were requested
+    uint8_t pdu[] = {0x08, 0x00, 0x0A, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x0D};
+    mb_scatter_entry_t entries[] = {{.plan_index = 0, .offset = 3, .dest_index = 0},
+                                    {.plan_index = 0, .offset = 0, .dest_index = 1}};
+    uint16_t data[2] = {0, 0};
+
+    int ret = mb_parse_read_response_scatter(MB_FC_READ_HOLDING_REGISTERS, pdu, 9, 4, entries, 2,
+                                             data);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_UINT16(0x000D, data[0]);
+    TEST_ASSERT_EQUAL_UINT16(0x000A, data[1]);
+}
+
+void test_parse_read_bits_scatter(void) {
+    // 13 coils: 0xCD = 1100 1101, 0x6B = 0110 1011 (LSB first)
+    uint8_t pdu[] = {0x02, 0xCD, 0x6B};
+    mb_scatter_entry_t entries[] = {{.plan_index = 0, .offset = 0, .dest_index = 0},
+                                    {.plan_index = 0, .offset = 1, .dest_index = 1},
+                                    {.plan_index = 0, .offset = 9, .dest_index = 2}};
+    uint16_t data[3];
+
+    int ret = mb_parse_read_response_scatter(MB_FC_READ_COILS, pdu, 3, 13, entries, 3, data);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_UINT16(1, data[0]);
+    TEST_ASSERT_EQUAL_UINT16(0, data[1]);
+    TEST_ASSERT_EQUAL_UINT16(1, data[2]);
+}
+
+void test_parse_read_scatter_offset_out_of_range(void) {
+    uint8_t pdu[] = {0x02, 0x00, 0x01};
+    mb_scatter_entry_t entries[] = {{.plan_index = 0, .offset = 1, .dest_index = 0}};
+    uint16_t data[1];
+
+    int ret = mb_parse_read_response_scatter(MB_FC_READ_HOLDING_REGISTERS, pdu, 3, 1, entries, 1,
+                                             data);
+
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_ADDRESS, ret);
+}
+
+void test_scatter_rejects_response_to_another_function(void) {
+    // Plausible FC04 answer to an FC03 plan
+    uint8_t pdu[]              = {0x02, 0x12, 0x34};
+    mb_request_plan_t plan     = {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                  .start_address = 0, .quantity = 1, .scatter_count = 1};
+    mb_scatter_entry_t entry[] = {{.plan_index = 0, .offset = 0, .dest_index = 0}};
+    uint16_t data[1]           = {0};
+    mb_scatter_ctx_t ctx       = {.plans = &plan, .scatter = entry, .data_buffer = data};
+
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_FRAME,
+                      mb_scatter_plan_response(&ctx, 0, MB_FC_READ_INPUT_REGISTERS, pdu, 3));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_FRAME,
+                      mb_scatter_plan_response(&ctx, 0, MB_FC_READ_INPUT_REGISTERS | 0x80, pdu, 1));
+    TEST_ASSERT_EQUAL_UINT16(0, data[0]);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_scatter_plan_response(&ctx, 0, MB_FC_READ_HOLDING_REGISTERS, pdu, 3));
+    TEST_ASSERT_EQUAL_UINT16(0x1234, data[0]);
+}
+
 void test_parse_write_single_coil_response(void) {
     // Echo response: address=0x00AC, value=0xFF00
     uint8_t pdu[] = {0x00, 0xAC, 0xFF, 0x00};
@@ -107,6 +169,10 @@ int main(void) {
     RUN_TEST(test_parse_read_registers_response);
     RUN_TEST(test_parse_read_response_invalid_byte_count);
     RUN_TEST(test_parse_read_response_exception);
+    RUN_TEST(test_parse_read_registers_scatter);
+    RUN_TEST(test_parse_read_bits_scatter);
+    RUN_TEST(test_parse_read_scatter_offset_out_of_range);
+    RUN_TEST(test_scatter_rejects_response_to_another_function);
     RUN_TEST(test_parse_write_single_coil_response);
     RUN_TEST(test_parse_write_single_register_response);
     RUN_TEST(test_parse_write_multiple_registers_response);
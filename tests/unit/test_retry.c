@@ -0,0 +1,261 @@
+/**
+ * @file test_retry.c
+ * @brief Unit tests for plan retries, block splitting and value quality
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+#include "mock_line.h"
+
+#include <string.h>
+
+/**
+ * @brief Faults injected on the line to a slave with holding registers
+ *        0-999 (value 1000 + address)
+ */
+typedef struct {
+    uint32_t corrupt;       /**< Bit n: corrupt the CRC of request n */
+    uint32_t drop;          /**< Bit n: no response to request n */
+    uint16_t corrupt_above; /**< Corrupt every response to more registers (0 = off) */
+    uint16_t delays[8];
+    uint16_t delay_count;
+} faults_t;
+
+static mock_line_t line;
+static faults_t faults;
+static MB_SLAVE_ALIGNED uint16_t holding[1000];
+static mb_slave_t slave;
+static mb_master_t master;
+
+static bool serve(mock_line_t *l, const uint8_t *frame, size_t len) {
+    uint8_t request[260];
+    memcpy(request, frame, len);
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_slave_process_frame(&slave, MB_MODE_RTU, request, (uint16_t)len,
+                                             l->response, sizeof(l->response),
+                                             &l->response_length));
+    return true;
+}
+
+static void inject(mock_line_t *l, size_t len) {
+    (void)len;
+    uint16_t n = (uint16_t)(l->requests - 1);
+    if (n < 32 && (faults.drop >> n) & 1u) {
+        l->response_length = 0;
+    } else if ((n < 32 && (faults.corrupt >> n) & 1u) ||
+               (faults.corrupt_above > 0 && l->quantity > faults.corrupt_above)) {
+        l->response[l->response_length - 1] ^= 0xFF;
+    }
+}
+
+static void mock_delay(void *ctx, uint16_t chars) {
+    (void)ctx;
+    if (faults.delay_count < 8) {
+        faults.delays[faults.delay_count++] = chars;
+    }
+}
+
+static void init_master(mb_retry_policy_t retry) {
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    mock_line_attach(&line, &config);
+    config.transport.delay_chars = mock_delay;
+    config.retry                 = retry;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+}
+
+void setUp(void) {
+    memset(&line, 0, sizeof(line));
+    line.respond = serve;
+    line.sent    = inject;
+    memset(&faults, 0, sizeof(faults));
+    for (uint16_t i = 0; i < 1000; i++) {
+        holding[i] = (uint16_t)(1000 + i);
+    }
+
+    mb_slave_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.unit_id = 1;
+    config.holding = (mb_slave_regs_t){holding, 0, 1000};
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_slave_init(&slave, &config));
+
+    mb_retry_policy_t none;
+    memset(&none, 0, sizeof(none));
+    init_master(none);
+}
+
+void tearDown(void) {}
+
+// Three plans, far apart: {0, 1}, {300, 301}, {600, 601}
+static uint16_t spread[]          = {0, 1, 300, 301, 600, 601};
+static mb_read_request_t request3 = {1, MB_FC_READ_HOLDING_REGISTERS, spread, 6};
+
+static void assert_spread_values(const uint16_t *data) {
+    for (uint16_t i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_UINT16(1000 + spread[i], data[i]);
+    }
+}
+
+void test_default_policy_fails_fast(void) {
+    uint16_t data[6] = {0};
+    faults.corrupt   = 1u << 1;
+
+    TEST_ASSERT_EQUAL(MB_ERROR_CRC_MISMATCH,
+                      mb_master_read_optimized(&master, &request3, data, 6));
+    TEST_ASSERT_EQUAL_UINT16(2, line.requests);
+    TEST_ASSERT_EQUAL_UINT32(0, master.stats.retries);
+}
+
+void test_retry_resends_only_the_failed_plan(void) {
+    init_master((mb_retry_policy_t){1, false, 0, 0});
+    uint16_t data[6] = {0};
+    faults.corrupt   = 1u << 1;
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request3, data, 6));
+    assert_spread_values(data);
+    TEST_ASSERT_EQUAL_UINT16(4, line.requests);
+    TEST_ASSERT_EQUAL_UINT32(1, master.stats.retries);
+    TEST_ASSERT_EQUAL_UINT16(0, faults.delay_count);
+}
+
+void test_backoff_doubles_up_to_the_limit(void) {
+    init_master((mb_retry_policy_t){3, false, 10, 25});
+    uint16_t data[6] = {0};
+    faults.drop      = (1u << 0) | (1u << 1) | (1u << 2);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request3, data, 6));
+    assert_spread_values(data);
+    TEST_ASSERT_EQUAL_UINT16(3, faults.delay_count);
+    TEST_ASSERT_EQUAL_UINT16(10, faults.delays[0]);
+    TEST_ASSERT_EQUAL_UINT16(20, faults.delays[1]);
+    TEST_ASSERT_EQUAL_UINT16(25, faults.delays[2]);
+}
+
+void test_exhausted_retries_keep_the_other_plans(void) {
+    init_master((mb_retry_policy_t){1, false, 0, 0});
+    uint16_t data[6] = {0};
+    faults.drop      = (1u << 1) | (1u << 2);
+
+    // The plain call reads what it can and reports the plan error
+    TEST_ASSERT_EQUAL(MB_ERROR_TIMEOUT, mb_master_read_optimized(&master, &request3, data, 6));
+    TEST_ASSERT_EQUAL_UINT16(1000, data[0]);
+    TEST_ASSERT_EQUAL_UINT16(0, data[2]);
+    TEST_ASSERT_EQUAL_UINT16(1601, data[5]);
+    TEST_ASSERT_EQUAL_UINT16(4, line.requests);
+}
+
+void test_quality_marks_failed_values(void) {
+    uint8_t quality[6];
+    uint16_t data[6] = {0};
+    faults.corrupt   = 1u << 1;
+
+    // No retries configured: the failed plan is given up, the others read
+    TEST_ASSERT_EQUAL(MB_ERROR_PARTIAL_RESULT,
+                      mb_master_read_optimized_quality(&master, &request3, data, 6, quality));
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+    TEST_ASSERT_EQUAL_UINT8(MB_QUALITY_GOOD, quality[0]);
+    TEST_ASSERT_EQUAL_UINT8(MB_QUALITY_GOOD, quality[1]);
+    TEST_ASSERT_EQUAL_UINT8(MB_QUALITY_COMM_ERROR, quality[2]);
+    TEST_ASSERT_EQUAL_UINT8(MB_QUALITY_COMM_ERROR, quality[3]);
+    TEST_ASSERT_EQUAL_UINT8(MB_QUALITY_GOOD, quality[4]);
+    TEST_ASSERT_EQUAL_UINT16(1601, data[5]);
+}
+
+void test_quality_all_good(void) {
+    uint8_t quality[6];
+    uint16_t data[6] = {0};
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_master_read_optimized_quality(&master, &request3, data, 6, quality));
+    for (uint16_t i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_UINT8(MB_QUALITY_GOOD, quality[i]);
+    }
+}
+
+void test_quality_nothing_read_returns_the_error(void) {
+    uint8_t quality[6];
+    uint16_t data[6] = {0};
+    faults.drop      = 0xFFFFFFFFu;
+
+    TEST_ASSERT_EQUAL(MB_ERROR_TIMEOUT,
+                      mb_master_read_optimized_quality(&master, &request3, data, 6, quality));
+    for (uint16_t i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_UINT8(MB_QUALITY_TIMEOUT, quality[i]);
+    }
+}
+
+void test_split_isolates_the_bad_block(void) {
+    init_master((mb_retry_policy_t){0, true, 0, 0});
+
+    // 996-997 and 999-1001 merge into one plan that runs past the table
+    uint16_t addresses[]      = {996, 997, 999, 1000, 1001};
+    mb_read_request_t request = {1, MB_FC_READ_HOLDING_REGISTERS, addresses, 5};
+    uint8_t quality[5];
+    uint16_t data[5] = {0};
+
+    TEST_ASSERT_EQUAL(MB_ERROR_PARTIAL_RESULT,
+                      mb_master_read_optimized_quality(&master, &request, data, 5, quality));
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+    TEST_ASSERT_EQUAL_UINT32(1, master.stats.split_plans);
+    TEST_ASSERT_EQUAL_UINT16(1996, data[0]);
+    TEST_ASSERT_EQUAL_UINT16(1997, data[1]);
+    TEST_ASSERT_EQUAL_UINT8(MB_QUALITY_GOOD, quality[0]);
+    TEST_ASSERT_EQUAL_UINT8(MB_QUALITY_GOOD, quality[1]);
+    TEST_ASSERT_EQUAL_UINT8(MB_QUALITY_EXCEPTION, quality[2]);
+    TEST_ASSERT_EQUAL_UINT8(MB_QUALITY_EXCEPTION, quality[4]);
+}
+
+void test_split_recovers_a_noisy_merged_plan(void) {
+    init_master((mb_retry_policy_t){1, true, 0, 0});
+
+    // Addresses out of order; the merged 10-15 plan never gets through
+    uint16_t addresses[]      = {15, 10, 11, 14};
+    mb_read_request_t request = {1, MB_FC_READ_HOLDING_REGISTERS, addresses, 4};
+    uint16_t data[4]          = {0};
+    faults.corrupt_above      = 2;
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request, data, 4));
+    TEST_ASSERT_EQUAL_UINT16(1015, data[0]);
+    TEST_ASSERT_EQUAL_UINT16(1010, data[1]);
+    TEST_ASSERT_EQUAL_UINT16(1011, data[2]);
+    TEST_ASSERT_EQUAL_UINT16(1014, data[3]);
+    TEST_ASSERT_EQUAL_UINT32(1, master.stats.split_plans);
+
+    // Merged plan twice (one retry), then one request per block
+    TEST_ASSERT_EQUAL_UINT16(4, line.requests);
+}
+
+void test_split_single_block_is_not_split(void) {
+    init_master((mb_retry_policy_t){0, true, 0, 0});
+    uint8_t quality[6];
+    uint16_t data[6] = {0};
+    faults.corrupt   = 1u << 0;
+
+    TEST_ASSERT_EQUAL(MB_ERROR_PARTIAL_RESULT,
+                      mb_master_read_optimized_quality(&master, &request3, data, 6, quality));
+    TEST_ASSERT_EQUAL_UINT32(0, master.stats.split_plans);
+    TEST_ASSERT_EQUAL_UINT8(MB_QUALITY_COMM_ERROR, quality[0]);
+    TEST_ASSERT_EQUAL_UINT8(MB_QUALITY_GOOD, quality[2]);
+}
+
+void test_quality_invalid_param(void) {
+    uint16_t data[6];
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_master_read_optimized_quality(&master, &request3, data, 6, NULL));
+    TEST_ASSERT_EQUAL_STRING("Partial result", mb_error_to_string(MB_ERROR_PARTIAL_RESULT));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_default_policy_fails_fast);
+    RUN_TEST(test_retry_resends_only_the_failed_plan);
+    RUN_TEST(test_backoff_doubles_up_to_the_limit);
+    RUN_TEST(test_exhausted_retries_keep_the_other_plans);
+    RUN_TEST(test_quality_marks_failed_values);
+    RUN_TEST(test_quality_all_good);
+    RUN_TEST(test_quality_nothing_read_returns_the_error);
+    RUN_TEST(test_split_isolates_the_bad_block);
+    RUN_TEST(test_split_recovers_a_noisy_merged_plan);
+    RUN_TEST(test_split_single_block_is_not_split);
+    RUN_TEST(test_quality_invalid_param);
+    return UNITY_END();
+}
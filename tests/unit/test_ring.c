@@ -0,0 +1,242 @@
+/**
+ * @file test_ring.c
+ * @brief Unit tests for the request/completion rings (single thread)
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+#include "mock_line.h"
+
+#include <string.h>
+
+static mock_line_t line;
+static mb_ring_t *urgent_at_first; /**< Urgent write pushed during the first request */
+static mb_master_t master;
+
+static mb_ring_cell_t submit_cells[8];
+static mb_ring_cell_t reply_cells[2];
+static mb_ring_t submit;
+static mb_ring_t reply;
+
+static mb_ring_cell_t urgent_cells[2];
+static mb_ring_t urgent;
+static uint16_t urgent_value = 7;
+
+static void push_urgent_write(mock_line_t *l, size_t len) {
+    (void)len;
+    if (l->requests == 1 && urgent_at_first != NULL) {
+        mb_ring_request_t write;
+        memset(&write, 0, sizeof(write));
+        write.slave_id      = 1;
+        write.function_code = MB_FC_WRITE_SINGLE_REGISTER;
+        write.address       = 500;
+        write.quantity      = 1;
+        write.data          = &urgent_value;
+        write.reply         = &reply;
+        TEST_ASSERT_TRUE(mb_ring_push(urgent_at_first, &write));
+    }
+}
+
+void setUp(void) {
+    memset(&line, 0, sizeof(line));
+    line.sent       = push_urgent_write;
+    urgent_at_first = NULL;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_ring_init(&submit, submit_cells, 8, true));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_ring_init(&reply, reply_cells, 2, false));
+
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    mock_line_attach(&line, &config);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+}
+
+void tearDown(void) {
+    mb_master_cleanup(&master);
+}
+
+static mb_ring_request_t make_request(uint16_t address) {
+    mb_ring_request_t request;
+    memset(&request, 0, sizeof(request));
+    request.slave_id      = 1;
+    request.function_code = MB_FC_READ_HOLDING_REGISTERS;
+    request.address       = address;
+    request.quantity      = 1;
+    return request;
+}
+
+void test_init_rejects_bad_capacity(void) {
+    mb_ring_t ring;
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_ring_init(&ring, submit_cells, 6, false));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_ring_init(&ring, submit_cells, 1, false));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_ring_init(&ring, NULL, 8, false));
+}
+
+void test_push_pop_in_order_across_many_laps(void) {
+    mb_ring_request_t out;
+    TEST_ASSERT_FALSE(mb_ring_pop(&submit, &out));
+    TEST_ASSERT_NULL(mb_ring_peek(&submit));
+
+    uint16_t pushed = 0;
+    uint16_t popped = 0;
+    for (int lap = 0; lap < 100; lap++) {
+        // Fill to capacity, then drain part of it
+        while (true) {
+            mb_ring_request_t request = make_request(pushed);
+            if (!mb_ring_push(&submit, &request)) {
+                break;
+            }
+            pushed++;
+        }
+        TEST_ASSERT_EQUAL_UINT16(8, pushed - popped);
+
+        for (int i = 0; i < 5; i++) {
+            TEST_ASSERT_EQUAL_UINT16(popped, mb_ring_peek(&submit)->address);
+            TEST_ASSERT_TRUE(mb_ring_pop(&submit, &out));
+            TEST_ASSERT_EQUAL_UINT16(popped, out.address);
+            popped++;
+        }
+    }
+}
+
+void test_service_executes_and_completes(void) {
+    uint16_t value  = 0;
+    uint16_t setpnt = 1234;
+
+    mb_ring_request_t read = make_request(42);
+    read.data              = &value;
+    read.reply             = &reply;
+    read.user              = &value;
+
+    mb_ring_request_t write = make_request(7);
+    write.function_code     = MB_FC_WRITE_SINGLE_REGISTER;
+    write.data              = &setpnt;
+
+    TEST_ASSERT_TRUE(mb_ring_push(&submit, &read));
+    TEST_ASSERT_TRUE(mb_ring_push(&submit, &write));
+
+    uint16_t serviced = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_ring_service(&master, &submit, 0, &serviced));
+    TEST_ASSERT_EQUAL_UINT16(2, serviced);
+    TEST_ASSERT_EQUAL_UINT16(2, line.requests);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_WRITE_SINGLE_REGISTER, line.fc);
+
+    mb_ring_request_t done;
+    TEST_ASSERT_TRUE(mb_ring_pop(&reply, &done));
+    TEST_ASSERT_EQUAL_INT(MB_SUCCESS, done.result);
+    TEST_ASSERT_EQUAL_PTR(&value, done.user);
+    TEST_ASSERT_EQUAL_UINT16(42, value);
+
+    // The write had no completion ring
+    TEST_ASSERT_FALSE(mb_ring_pop(&reply, &done));
+}
+
+void test_full_completion_ring_holds_requests_back(void) {
+    uint16_t values[4];
+    for (uint16_t i = 0; i < 4; i++) {
+        mb_ring_request_t request = make_request(i);
+        request.data              = &values[i];
+        request.reply             = &reply;
+        TEST_ASSERT_TRUE(mb_ring_push(&submit, &request));
+    }
+
+    uint16_t serviced = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_ring_service(&master, &submit, 0, &serviced));
+    TEST_ASSERT_EQUAL_UINT16(2, serviced);
+    TEST_ASSERT_EQUAL_UINT16(2, line.requests);
+
+    mb_ring_request_t done;
+    TEST_ASSERT_TRUE(mb_ring_pop(&reply, &done));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_ring_service(&master, &submit, 0, &serviced));
+    TEST_ASSERT_EQUAL_UINT16(1, serviced);
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+
+    for (uint16_t address = 1; address <= 2; address++) {
+        TEST_ASSERT_TRUE(mb_ring_pop(&reply, &done));
+        TEST_ASSERT_EQUAL_UINT16(address, done.address);
+    }
+    TEST_ASSERT_EQUAL_UINT16(3, mb_ring_peek(&submit)->address);
+}
+
+void test_failed_request_reports_its_error(void) {
+    uint16_t value            = 0;
+    mb_ring_request_t request = make_request(0);
+    request.function_code     = 0x2B;
+    request.data              = &value;
+    request.reply             = &reply;
+    TEST_ASSERT_TRUE(mb_ring_push(&submit, &request));
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_ring_service(&master, &submit, 1, NULL));
+    mb_ring_request_t done;
+    TEST_ASSERT_TRUE(mb_ring_pop(&reply, &done));
+    TEST_ASSERT_EQUAL_INT(MB_ERROR_INVALID_FC, done.result);
+    TEST_ASSERT_EQUAL_UINT16(0, line.requests);
+}
+
+void test_urgent_write_runs_between_plans_of_a_read(void) {
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_ring_init(&urgent, urgent_cells, 2, false));
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    mock_line_attach(&line, &config);
+    config.urgent            = &urgent;
+    mb_master_cleanup(&master);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+    urgent_at_first = &urgent;
+
+    // Three addresses too far apart to merge: three plans
+    uint16_t addresses[]      = {0, 1000, 2000};
+    mb_read_request_t request = {.slave_id      = 1,
+                                 .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                 .addresses     = addresses,
+                                 .address_count = 3};
+    uint16_t data[3];
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request, data, 3));
+    TEST_ASSERT_EQUAL_UINT16(2000, data[2]);
+
+    // The write went out right after the plan it arrived during
+    TEST_ASSERT_EQUAL_UINT16(4, line.requests);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_READ_HOLDING_REGISTERS, line.fcs[0]);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_WRITE_SINGLE_REGISTER, line.fcs[1]);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_READ_HOLDING_REGISTERS, line.fcs[2]);
+    TEST_ASSERT_EQUAL_UINT32(1, master.stats.preemptions);
+
+    mb_ring_request_t done;
+    TEST_ASSERT_TRUE(mb_ring_pop(&reply, &done));
+    TEST_ASSERT_EQUAL_INT(MB_SUCCESS, done.result);
+    TEST_ASSERT_EQUAL_UINT16(500, done.address);
+    TEST_ASSERT_NULL(mb_ring_peek(&urgent));
+}
+
+void test_urgent_ring_goes_before_other_ring_requests(void) {
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_ring_init(&urgent, urgent_cells, 2, false));
+    master.config.urgent = &urgent;
+
+    uint16_t values[2];
+    for (uint16_t i = 0; i < 2; i++) {
+        mb_ring_request_t request = make_request((uint16_t)(10 + i));
+        request.data              = &values[i];
+        TEST_ASSERT_TRUE(mb_ring_push(&submit, &request));
+    }
+    mb_ring_request_t write = make_request(500);
+    write.function_code     = MB_FC_WRITE_SINGLE_REGISTER;
+    write.data              = &urgent_value;
+    TEST_ASSERT_TRUE(mb_ring_push(&urgent, &write));
+
+    uint16_t serviced = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_ring_service(&master, &submit, 0, &serviced));
+    TEST_ASSERT_EQUAL_UINT16(2, serviced);
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_WRITE_SINGLE_REGISTER, line.fcs[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, master.stats.preemptions);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_init_rejects_bad_capacity);
+    RUN_TEST(test_push_pop_in_order_across_many_laps);
+    RUN_TEST(test_service_executes_and_completes);
+    RUN_TEST(test_full_completion_ring_holds_requests_back);
+    RUN_TEST(test_failed_request_reports_its_error);
+    RUN_TEST(test_urgent_write_runs_between_plans_of_a_read);
+    RUN_TEST(test_urgent_ring_goes_before_other_ring_requests);
+
+    return UNITY_END();
+}
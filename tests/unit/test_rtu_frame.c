@@ -7,6 +7,8 @@
 #include "protocol/rtu_frame.h"
 #include "smartmodbus/mb_error.h"
 
+#include <string.h>
+
 void setUp(void) {
 }
 
@@ -105,6 +107,37 @@ void test_rtu_calc_frame_length_max(void) {
     TEST_ASSERT_EQUAL_UINT16(256, length);
 }
 
+void test_rtu_encode_inplace_matches_build(void) {
+    uint8_t pdu[] = {0x00, 0x6B, 0x00, 0x03};
+    uint8_t expected[16];
+    uint8_t frame[16];
+
+    int built = mb_rtu_build_frame(0x11, 0x03, pdu, 4, expected, sizeof(expected));
+
+    memcpy(&frame[MB_RTU_PDU_OFFSET], pdu, 4);
+    int encoded = mb_rtu_encode_inplace(0x11, 0x03, 4, frame, sizeof(frame));
+
+    TEST_ASSERT_EQUAL(built, encoded);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, frame, (size_t)built);
+}
+
+void test_rtu_parse_view_points_into_frame(void) {
+    uint8_t frame[] = {0x01, 0x03, 0x00, 0x00, 0x00, 0x02, 0xC4, 0x0B};
+    uint8_t slave_id, fc;
+    const uint8_t *pdu = NULL;
+    uint16_t pdu_length;
+
+    int result = mb_rtu_parse_view(frame, sizeof(frame), &slave_id, &fc, &pdu, &pdu_length);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, result);
+    TEST_ASSERT_EQUAL_PTR(&frame[2], pdu);
+    TEST_ASSERT_EQUAL_UINT16(4, pdu_length);
+
+    frame[7] ^= 0x01;
+    TEST_ASSERT_EQUAL(MB_ERROR_CRC_MISMATCH,
+                      mb_rtu_parse_view(frame, sizeof(frame), &slave_id, &fc, &pdu, &pdu_length));
+}
+
 int main(void) {
     UNITY_BEGIN();
 
@@ -117,6 +150,8 @@ int main(void) {
     RUN_TEST(test_rtu_calc_frame_length);
     RUN_TEST(test_rtu_calc_frame_length_zero);
     RUN_TEST(test_rtu_calc_frame_length_max);
+    RUN_TEST(test_rtu_encode_inplace_matches_build);
+    RUN_TEST(test_rtu_parse_view_points_into_frame);
 
     return UNITY_END();
 }
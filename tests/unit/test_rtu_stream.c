@@ -0,0 +1,117 @@
+/**
+ * @file test_rtu_stream.c
+ * @brief Unit tests for the streaming RTU receiver
+ */
+
+#include "unity.h"
+#include "protocol/rtu_stream.h"
+#include "smartmodbus/mb_error.h"
+
+#include <string.h>
+
+// Response: slave 1, FC03, 2 registers 0x0001 0x0002
+static const uint8_t response[] = {0x01, 0x03, 0x04, 0x00, 0x01, 0x00, 0x02, 0x2A, 0x32};
+
+static mb_rtu_stream_t stream;
+
+void setUp(void) {
+    mb_rtu_stream_reset(&stream);
+}
+
+void tearDown(void) {
+}
+
+void test_stream_byte_by_byte(void) {
+    for (size_t i = 0; i < sizeof(response); i++) {
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_rtu_stream_push(&stream, &response[i], 1));
+    }
+
+    TEST_ASSERT_EQUAL(sizeof(response), mb_rtu_stream_end(&stream));
+
+    uint8_t slave_id = 0;
+    uint8_t fc       = 0;
+    uint8_t pdu[8];
+    uint16_t pdu_length = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_rtu_stream_parse(&stream, &slave_id, &fc, pdu, &pdu_length));
+    TEST_ASSERT_EQUAL_UINT8(1, slave_id);
+    TEST_ASSERT_EQUAL_UINT8(0x03, fc);
+    TEST_ASSERT_EQUAL_UINT16(5, pdu_length);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(&response[2], pdu, 5);
+}
+
+void test_stream_dma_halves(void) {
+    size_t space  = 0;
+    uint8_t *tail = mb_rtu_stream_tail(&stream, &space);
+    TEST_ASSERT_EQUAL(MB_RTU_MAX_ADU, space);
+
+    memcpy(tail, response, 4);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_rtu_stream_commit(&stream, 4));
+
+    tail = mb_rtu_stream_tail(&stream, &space);
+    memcpy(tail, &response[4], sizeof(response) - 4);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_rtu_stream_commit(&stream, sizeof(response) - 4));
+
+    TEST_ASSERT_EQUAL(sizeof(response), mb_rtu_stream_end(&stream));
+}
+
+void test_stream_knows_expected_length(void) {
+    static const uint8_t exception[] = {0x01, 0x83, 0x02, 0xC0, 0xF1};
+    static const uint8_t write[]     = {0x01, 0x10, 0x00, 0x0A, 0x00, 0x02, 0x21, 0xCA};
+
+    TEST_ASSERT_EQUAL(0, mb_rtu_stream_expected(&stream));
+    mb_rtu_stream_push(&stream, response, 2);
+    TEST_ASSERT_EQUAL(0, mb_rtu_stream_expected(&stream));
+    mb_rtu_stream_push(&stream, &response[2], 1);
+    TEST_ASSERT_EQUAL(sizeof(response), mb_rtu_stream_expected(&stream));
+
+    mb_rtu_stream_reset(&stream);
+    mb_rtu_stream_push(&stream, exception, 2);
+    TEST_ASSERT_EQUAL(sizeof(exception), mb_rtu_stream_expected(&stream));
+
+    mb_rtu_stream_reset(&stream);
+    mb_rtu_stream_push(&stream, write, 2);
+    TEST_ASSERT_EQUAL(sizeof(write), mb_rtu_stream_expected(&stream));
+
+    // Diagnostics (FC08) responses end at the silence
+    static const uint8_t diagnostics[] = {0x01, 0x08};
+    mb_rtu_stream_reset(&stream);
+    mb_rtu_stream_push(&stream, diagnostics, 2);
+    TEST_ASSERT_EQUAL(MB_ERROR_NOT_SUPPORTED, mb_rtu_stream_expected(&stream));
+}
+
+void test_stream_detects_corruption(void) {
+    uint8_t corrupted[sizeof(response)];
+    memcpy(corrupted, response, sizeof(response));
+    corrupted[4] ^= 0x10;
+
+    mb_rtu_stream_push(&stream, corrupted, sizeof(corrupted));
+    TEST_ASSERT_EQUAL(MB_ERROR_CRC_MISMATCH, mb_rtu_stream_end(&stream));
+
+    mb_rtu_stream_reset(&stream);
+    mb_rtu_stream_push(&stream, response, 3);
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_FRAME, mb_rtu_stream_end(&stream));
+}
+
+void test_stream_overflow(void) {
+    static uint8_t noise[MB_RTU_MAX_ADU + 1];
+
+    TEST_ASSERT_EQUAL(MB_ERROR_BUFFER_TOO_SMALL, mb_rtu_stream_push(&stream, noise, sizeof(noise)));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_FRAME, mb_rtu_stream_end(&stream));
+
+    // Reset recovers for the next frame
+    mb_rtu_stream_reset(&stream);
+    mb_rtu_stream_push(&stream, response, sizeof(response));
+    TEST_ASSERT_EQUAL(sizeof(response), mb_rtu_stream_end(&stream));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_stream_byte_by_byte);
+    RUN_TEST(test_stream_dma_halves);
+    RUN_TEST(test_stream_knows_expected_length);
+    RUN_TEST(test_stream_detects_corruption);
+    RUN_TEST(test_stream_overflow);
+
+    return UNITY_END();
+}
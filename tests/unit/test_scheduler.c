@@ -0,0 +1,209 @@
+/**
+ * @file test_scheduler.c
+ * @brief Unit tests for the multi-connection poll scheduler
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+#include "mock_line.h"
+
+#include <string.h>
+
+#define DEVICE_COUNT 5
+
+/**
+ * @brief Non-blocking TCP slave answering reads with register value == address
+ *
+ * Responses are handed out one frame per recv() call, so several requests
+ * can be outstanding; max_outstanding records the deepest pipeline seen.
+ */
+typedef struct {
+    mock_line_t line; // First, so the hooks can cast back
+    uint16_t delivered;
+    uint16_t max_outstanding;
+} mock_device_t;
+
+static void track_outstanding(mock_line_t *l, size_t len) {
+    mock_device_t *d = (mock_device_t *)l;
+    (void)len;
+
+    uint16_t outstanding = (uint16_t)(l->requests - d->delivered);
+    if (outstanding > d->max_outstanding) {
+        d->max_outstanding = outstanding;
+    }
+}
+
+static void count_delivered(mock_line_t *l, size_t len) {
+    if (len > 0) {
+        ((mock_device_t *)l)->delivered++;
+    }
+}
+
+static mock_device_t mocks[DEVICE_COUNT];
+static mb_master_t masters[DEVICE_COUNT];
+static mb_poll_plan_t polls[DEVICE_COUNT];
+static uint16_t data[DEVICE_COUNT][6];
+static mb_sched_device_t devices[DEVICE_COUNT];
+static mb_scheduler_t sched;
+
+static mb_sched_cycle_t reports[4];
+static int report_count;
+static bool restart_from_callback;
+
+static void on_cycle(void *ctx, const mb_sched_cycle_t *report) {
+    TEST_ASSERT_EQUAL_PTR(&sched, ctx);
+    reports[report_count++] = *report;
+    if (restart_from_callback) {
+        restart_from_callback = false;
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_scheduler_begin_cycle(&sched, report->finished_ms));
+    }
+}
+
+static uint16_t addresses[] = {2000, 1, 0, 1000, 1001, 2};
+static const mb_read_request_t request = {.slave_id      = 1,
+                                          .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                          .addresses     = addresses,
+                                          .address_count = 6};
+
+static void add_devices(uint16_t shard_count, uint8_t max_in_flight) {
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_scheduler_init(&sched, devices, DEVICE_COUNT, shard_count, on_cycle, &sched));
+
+    for (int i = 0; i < DEVICE_COUNT; i++) {
+        mock_line_t *line  = &mocks[i].line;
+        line->mode         = MB_MODE_TCP;
+        line->queue        = true;
+        line->split_frames = true;
+        line->nonblocking  = true;
+        line->sent         = track_outstanding;
+        line->received     = count_delivered;
+
+        mb_config_t config = mb_config_default(MB_MODE_TCP);
+        mock_line_attach(line, &config);
+        config.timeout_ms = 100;
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&masters[i], &config));
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile(&masters[i], &request, &polls[i]));
+        TEST_ASSERT_EQUAL(i, mb_scheduler_add(&sched, &masters[i], &polls[i], data[i], 6,
+                                              max_in_flight));
+    }
+}
+
+/**
+ * @brief Run all shards round-robin from one thread, advancing the clock
+ */
+static void run_shards(uint32_t step_ms) {
+    uint32_t now = 0;
+    for (int round = 0; round < 100; round++) {
+        int busy = 0;
+        for (uint16_t s = 0; s < sched.shard_count; s++) {
+            int result = mb_scheduler_run_shard(&sched, s, now);
+            TEST_ASSERT_TRUE(result >= 0);
+            busy += result;
+        }
+        if (busy == 0 && sched.remaining == 0) {
+            return;
+        }
+        now += step_ms;
+    }
+    TEST_FAIL_MESSAGE("scheduler did not finish");
+}
+
+void setUp(void) {
+    memset(mocks, 0, sizeof(mocks));
+    memset(data, 0, sizeof(data));
+    memset(reports, 0, sizeof(reports));
+    report_count          = 0;
+    restart_from_callback = false;
+}
+
+void tearDown(void) {
+    for (int i = 0; i < DEVICE_COUNT; i++) {
+        mb_poll_plan_free(&polls[i]);
+    }
+}
+
+void test_cycle_polls_every_device_and_reports_once(void) {
+    add_devices(2, 4);
+    restart_from_callback = true;
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_scheduler_begin_cycle(&sched, 0));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_scheduler_begin_cycle(&sched, 0));
+    run_shards(1);
+
+    // The callback started cycle 2, which ran to completion as well
+    TEST_ASSERT_EQUAL(2, report_count);
+    TEST_ASSERT_EQUAL_UINT32(1, reports[0].cycle);
+    TEST_ASSERT_EQUAL_UINT32(2, reports[1].cycle);
+    TEST_ASSERT_EQUAL_UINT16(DEVICE_COUNT, reports[0].devices);
+    TEST_ASSERT_EQUAL_UINT16(0, reports[0].failed);
+
+    for (int i = 0; i < DEVICE_COUNT; i++) {
+        TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data[i], 6);
+        TEST_ASSERT_EQUAL(MB_SUCCESS, devices[i].last_result);
+        TEST_ASSERT_EQUAL(6, mocks[i].line.requests);
+    }
+}
+
+void test_in_flight_is_capped_per_device(void) {
+    add_devices(1, 2);
+    TEST_ASSERT_EQUAL_UINT16(3, polls[0].plan_count);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_scheduler_begin_cycle(&sched, 0));
+    run_shards(1);
+
+    TEST_ASSERT_EQUAL(1, report_count);
+    for (int i = 0; i < DEVICE_COUNT; i++) {
+        TEST_ASSERT_EQUAL(3, mocks[i].line.requests);
+        TEST_ASSERT_EQUAL(2, mocks[i].max_outstanding);
+        TEST_ASSERT_EQUAL_UINT8(2, masters[i].config.max_in_flight);
+    }
+}
+
+void test_balance_spreads_round_trips_over_shards(void) {
+    add_devices(2, 1);
+
+    // Weights 6,3,3,3,1
+    devices[4].weight = 1;
+    devices[0].weight = 6;
+    mb_scheduler_balance(&sched);
+
+    uint32_t load[2] = {0, 0};
+    for (int i = 0; i < DEVICE_COUNT; i++) {
+        TEST_ASSERT_TRUE(devices[i].shard < 2);
+        load[devices[i].shard] += devices[i].weight;
+    }
+
+    // 6 | 3 | 3 | then 3 joins the heavy shard and 1 the other: 9 | 7
+    TEST_ASSERT_EQUAL_UINT32(9, load[devices[0].shard]);
+    TEST_ASSERT_EQUAL_UINT32(7, load[1 - devices[0].shard]);
+    TEST_ASSERT_TRUE(devices[0].shard != devices[4].shard);
+}
+
+void test_failed_device_is_reported_with_cycle(void) {
+    add_devices(3, 4);
+    mocks[2].line.silent = true;
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_scheduler_begin_cycle(&sched, 0));
+
+    uint32_t deadline = 0;
+    TEST_ASSERT_FALSE(mb_scheduler_next_deadline(&sched, devices[2].shard, &deadline));
+    run_shards(10);
+
+    TEST_ASSERT_EQUAL(1, report_count);
+    TEST_ASSERT_EQUAL_UINT16(1, reports[0].failed);
+    TEST_ASSERT_EQUAL(MB_ERROR_TIMEOUT, devices[2].last_result);
+    TEST_ASSERT_EQUAL_UINT32(100, reports[0].finished_ms);
+    TEST_ASSERT_EQUAL_UINT32(100, devices[2].duration_ms);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, devices[0].last_result);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_cycle_polls_every_device_and_reports_once);
+    RUN_TEST(test_in_flight_is_capped_per_device);
+    RUN_TEST(test_balance_spreads_round_trips_over_shards);
+    RUN_TEST(test_failed_device_is_reported_with_cycle);
+
+    return UNITY_END();
+}
@@ -0,0 +1,125 @@
+/**
+ * @file test_scratch.c
+ * @brief Unit tests for the scratch arena and allocation-free optimized reads
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+#include "utils/scratch.h"
+#include "mock_line.h"
+
+#include <string.h>
+
+static mock_line_t line;
+static mb_master_t master;
+
+void setUp(void) {
+    memset(&line, 0, sizeof(line));
+
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    mock_line_attach(&line, &config);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+}
+
+void tearDown(void) {
+}
+
+void test_arena_aligns_and_reports_exhaustion(void) {
+    static uint8_t buffer[64];
+    mb_scratch_t scratch;
+    mb_scratch_init(&scratch, buffer + 1, 32);
+
+    uint8_t *a = (uint8_t *)mb_scratch_acquire(&scratch, 3);
+    uint8_t *b = (uint8_t *)mb_scratch_acquire(&scratch, 8);
+
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_EQUAL(0, (uintptr_t)a % MB_SCRATCH_ALIGN);
+    TEST_ASSERT_EQUAL(0, (uintptr_t)b % MB_SCRATCH_ALIGN);
+    TEST_ASSERT_NULL(mb_scratch_acquire(&scratch, 32));
+}
+
+void test_arena_rewinds_to_mark(void) {
+    static uint64_t buffer[8];
+    mb_scratch_t scratch;
+    mb_scratch_init(&scratch, buffer, sizeof(buffer));
+
+    size_t mark = mb_scratch_mark(&scratch);
+    TEST_ASSERT_NOT_NULL(mb_scratch_acquire(&scratch, 40));
+    mb_scratch_rewind(&scratch, mark);
+
+    TEST_ASSERT_EQUAL(0, scratch.used);
+    TEST_ASSERT_EQUAL(40, scratch.high_water);
+    TEST_ASSERT_NOT_NULL(mb_scratch_acquire(&scratch, 64));
+}
+
+void test_optimized_read_draws_from_arena(void) {
+    static uint64_t arena[1024];
+    uint16_t addresses[] = {300, 2, 1, 0, 150, 151};
+    mb_read_request_t request = {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                 .addresses = addresses, .address_count = 6};
+
+    TEST_ASSERT_TRUE(mb_scratch_size(6) <= sizeof(arena));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_set_scratch(&master, arena, mb_scratch_size(6)));
+
+    for (int cycle = 0; cycle < 3; cycle++) {
+        uint16_t data[6];
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request, data, 6));
+        TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 6);
+        TEST_ASSERT_EQUAL(0, master.scratch.used);
+    }
+
+#ifndef MB_USE_STATIC_MEMORY
+    TEST_ASSERT_TRUE(master.scratch.high_water > 0);
+#endif
+    TEST_ASSERT_TRUE(master.scratch.high_water <= mb_scratch_size(6));
+}
+
+void test_batch_read_fits_reported_size(void) {
+    static uint64_t arena[1024];
+    mb_tag_t tags[] = {
+        {.slave_id = 2, .function_code = MB_FC_READ_HOLDING_REGISTERS, .address = 9},
+        {.slave_id = 1, .function_code = MB_FC_READ_INPUT_REGISTERS, .address = 4},
+        {.slave_id = 1, .function_code = MB_FC_READ_INPUT_REGISTERS, .address = 5},
+    };
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_set_scratch(&master, arena, mb_scratch_size(3)));
+
+    uint16_t data[3];
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_batch(&master, tags, 3, data, 3));
+    TEST_ASSERT_EQUAL_UINT16(9, data[0]);
+    TEST_ASSERT_EQUAL_UINT16(4, data[1]);
+    TEST_ASSERT_EQUAL_UINT16(5, data[2]);
+    TEST_ASSERT_EQUAL(0, master.scratch.used);
+    TEST_ASSERT_TRUE(master.scratch.high_water <= mb_scratch_size(3));
+}
+
+void test_undersized_arena_fails_without_heap_fallback(void) {
+#ifndef MB_USE_STATIC_MEMORY
+    static uint64_t arena[2];
+    uint16_t addresses[] = {0, 1, 2, 100};
+    mb_read_request_t request = {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                 .addresses = addresses, .address_count = 4};
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_set_scratch(&master, arena, sizeof(arena)));
+
+    uint16_t data[4];
+    TEST_ASSERT_EQUAL(MB_ERROR_NO_MEMORY, mb_master_read_optimized(&master, &request, data, 4));
+    TEST_ASSERT_EQUAL(0, master.scratch.used);
+#endif
+
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_master_set_scratch(&master, NULL, 16));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_set_scratch(&master, NULL, 0));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_arena_aligns_and_reports_exhaustion);
+    RUN_TEST(test_arena_rewinds_to_mark);
+    RUN_TEST(test_optimized_read_draws_from_arena);
+    RUN_TEST(test_batch_read_fits_reported_size);
+    RUN_TEST(test_undersized_arena_fails_without_heap_fallback);
+
+    return UNITY_END();
+}
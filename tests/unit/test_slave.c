@@ -0,0 +1,443 @@
+/**
+ * @file test_slave.c
+ * @brief Unit tests for the slave register store, request execution and TCP server
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+#include "protocol/frame_builder.h"
+
+#include <string.h>
+
+#ifdef MB_ENABLE_SLAVE_SERVER
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+static MB_SLAVE_ALIGNED uint32_t coils[MB_SLAVE_BIT_WORDS(100)];
+static MB_SLAVE_ALIGNED uint32_t inputs[MB_SLAVE_BIT_WORDS(64)];
+static MB_SLAVE_ALIGNED uint16_t holding[200];
+static MB_SLAVE_ALIGNED uint16_t input_regs[50];
+
+static mb_slave_t slave;
+
+/**
+ * @brief Last write notification
+ */
+static struct {
+    uint16_t calls;
+    uint8_t fc;
+    uint16_t address;
+    uint16_t quantity;
+} written;
+
+static void on_write(void *ctx, uint8_t fc, uint16_t address, uint16_t quantity) {
+    (void)ctx;
+    written.calls++;
+    written.fc       = fc;
+    written.address  = address;
+    written.quantity = quantity;
+}
+
+void setUp(void) {
+    memset(&written, 0, sizeof(written));
+    memset(coils, 0, sizeof(coils));
+    memset(inputs, 0, sizeof(inputs));
+
+    // Coils 1000..1099: odd addresses set; inputs 0..63: bit i = i % 3 == 0
+    for (uint32_t i = 0; i < 100; i++) {
+        if ((1000 + i) & 1) {
+            coils[i / 32] |= 1u << (i % 32);
+        }
+    }
+    for (uint32_t i = 0; i < 64; i++) {
+        if (i % 3 == 0) {
+            inputs[i / 32] |= 1u << (i % 32);
+        }
+    }
+    for (uint16_t i = 0; i < 200; i++) {
+        holding[i] = (uint16_t)(40000 + i);
+    }
+    for (uint16_t i = 0; i < 50; i++) {
+        input_regs[i] = (uint16_t)(0x3000 + i);
+    }
+
+    mb_slave_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.unit_id         = 7;
+    config.coils           = (mb_slave_bits_t){coils, 1000, 100};
+    config.discrete_inputs = (mb_slave_bits_t){inputs, 0, 64};
+    config.holding         = (mb_slave_regs_t){holding, 100, 200};
+    config.input           = (mb_slave_regs_t){input_regs, 0, 50};
+    config.on_write        = on_write;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_slave_init(&slave, &config));
+}
+
+void tearDown(void) {}
+
+static uint8_t request(uint8_t fc,
+                       const uint8_t *pdu,
+                       uint16_t pdu_length,
+                       uint8_t *response,
+                       uint16_t *response_length) {
+    uint8_t response_fc = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_slave_process_pdu(&slave, fc, pdu, pdu_length, &response_fc,
+                                                       response, response_length));
+    return response_fc;
+}
+
+void test_init_rejects_wrapping_table(void) {
+    mb_slave_config_t config = slave.config;
+    config.holding.base      = 0xFFC0;
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_slave_init(&slave, &config));
+}
+
+void test_tables_are_cache_line_aligned(void) {
+    TEST_ASSERT_EQUAL_UINT32(0, (uintptr_t)holding % MB_SLAVE_CACHE_LINE);
+    TEST_ASSERT_EQUAL_UINT32(0, (uintptr_t)coils % MB_SLAVE_CACHE_LINE);
+}
+
+void test_read_holding_registers(void) {
+    const uint8_t pdu[] = {0x00, 0x6E, 0x00, 0x03};  // 110, 3
+    uint8_t out[252];
+    uint16_t length = 0;
+
+    TEST_ASSERT_EQUAL_HEX8(MB_FC_READ_HOLDING_REGISTERS,
+                           request(MB_FC_READ_HOLDING_REGISTERS, pdu, 4, out, &length));
+    const uint8_t expected[] = {6, 0x9C, 0x4A, 0x9C, 0x4B, 0x9C, 0x4C};  // 40010..40012
+    TEST_ASSERT_EQUAL_UINT16(sizeof(expected), length);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, out, sizeof(expected));
+}
+
+void test_read_input_registers_at_table_end(void) {
+    const uint8_t pdu[] = {0x00, 0x2E, 0x00, 0x04};  // 46..49
+    uint8_t out[252];
+    uint16_t length = 0;
+
+    TEST_ASSERT_EQUAL_HEX8(MB_FC_READ_INPUT_REGISTERS,
+                           request(MB_FC_READ_INPUT_REGISTERS, pdu, 4, out, &length));
+    TEST_ASSERT_EQUAL_UINT16(9, length);
+    TEST_ASSERT_EQUAL_HEX8(0x30, out[7]);
+    TEST_ASSERT_EQUAL_HEX8(0x31, out[8]);
+}
+
+void test_read_coils_at_unaligned_offsets(void) {
+    uint8_t out[252];
+    uint16_t length = 0;
+
+    // 1003..1021 (offset 3, 19 coils): odd addresses set -> 1, 0, 1, 0, ...
+    const uint8_t pdu[] = {0x03, 0xEB, 0x00, 0x13};
+    TEST_ASSERT_EQUAL_HEX8(MB_FC_READ_COILS, request(MB_FC_READ_COILS, pdu, 4, out, &length));
+    TEST_ASSERT_EQUAL_UINT16(4, length);
+    TEST_ASSERT_EQUAL_UINT8(3, out[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x55, out[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x55, out[2]);
+    TEST_ASSERT_EQUAL_HEX8(0x05, out[3]);
+
+    // Across the word boundary at offset 32: 1030..1039
+    const uint8_t across[] = {0x04, 0x06, 0x00, 0x0A};
+    TEST_ASSERT_EQUAL_HEX8(MB_FC_READ_COILS, request(MB_FC_READ_COILS, across, 4, out, &length));
+    TEST_ASSERT_EQUAL_HEX8(0xAA, out[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x02, out[2]);
+}
+
+void test_read_discrete_inputs(void) {
+    const uint8_t pdu[] = {0x00, 0x1E, 0x00, 0x08};  // 30..37: 30, 33, 36 set
+    uint8_t out[252];
+    uint16_t length = 0;
+
+    TEST_ASSERT_EQUAL_HEX8(MB_FC_READ_DISCRETE_INPUTS,
+                           request(MB_FC_READ_DISCRETE_INPUTS, pdu, 4, out, &length));
+    TEST_ASSERT_EQUAL_UINT16(2, length);
+    TEST_ASSERT_EQUAL_HEX8(0x49, out[1]);
+}
+
+void test_write_single_coil_and_register(void) {
+    uint8_t out[252];
+    uint16_t length = 0;
+
+    const uint8_t coil[] = {0x03, 0xE8, 0xFF, 0x00};  // 1000 on
+    TEST_ASSERT_EQUAL_HEX8(MB_FC_WRITE_SINGLE_COIL,
+                           request(MB_FC_WRITE_SINGLE_COIL, coil, 4, out, &length));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(coil, out, 4);
+    TEST_ASSERT_EQUAL_HEX32(1, coils[0] & 1);
+    TEST_ASSERT_EQUAL_UINT16(1, written.calls);
+
+    const uint8_t reg[] = {0x00, 0x64, 0x12, 0x34};  // 100 = 0x1234
+    TEST_ASSERT_EQUAL_HEX8(MB_FC_WRITE_SINGLE_REGISTER,
+                           request(MB_FC_WRITE_SINGLE_REGISTER, reg, 4, out, &length));
+    TEST_ASSERT_EQUAL_HEX16(0x1234, holding[0]);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_WRITE_SINGLE_REGISTER, written.fc);
+    TEST_ASSERT_EQUAL_UINT16(100, written.address);
+
+    const uint8_t bad[] = {0x03, 0xE8, 0x12, 0x34};
+    TEST_ASSERT_EQUAL_HEX8(0x85, request(MB_FC_WRITE_SINGLE_COIL, bad, 4, out, &length));
+    TEST_ASSERT_EQUAL_HEX8(MB_EX_ILLEGAL_DATA_VALUE, out[0]);
+}
+
+void test_write_multiple_coils_keeps_neighbours(void) {
+    // 1005..1014 (10 coils) = all ones
+    const uint8_t pdu[] = {0x03, 0xED, 0x00, 0x0A, 0x02, 0xFF, 0x03};
+    uint8_t out[252];
+    uint16_t length = 0;
+
+    TEST_ASSERT_EQUAL_HEX8(MB_FC_WRITE_MULTIPLE_COILS,
+                           request(MB_FC_WRITE_MULTIPLE_COILS, pdu, sizeof(pdu), out, &length));
+    TEST_ASSERT_EQUAL_UINT16(4, length);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(pdu, out, 4);
+
+    // Offsets 5..14 set; 1001 and 1003 (offsets 1, 3) still set, 1016 still clear
+    TEST_ASSERT_EQUAL_HEX32(0x0000AAAA | 0x7FE0, coils[0] & 0xFFFF);
+    TEST_ASSERT_EQUAL_UINT16(10, written.quantity);
+}
+
+void test_write_multiple_registers(void) {
+    const uint8_t pdu[] = {0x01, 0x2B, 0x00, 0x02, 0x04, 0xAB, 0xCD, 0x00, 0x01};  // 299, 2
+    uint8_t out[252];
+    uint16_t length = 0;
+
+    // 299 is the last register: two do not fit
+    TEST_ASSERT_EQUAL_HEX8(0x90,
+                           request(MB_FC_WRITE_MULTIPLE_REGISTERS, pdu, sizeof(pdu), out, &length));
+    TEST_ASSERT_EQUAL_HEX8(MB_EX_ILLEGAL_DATA_ADDRESS, out[0]);
+    TEST_ASSERT_EQUAL_UINT16(0, written.calls);
+
+    const uint8_t fits[] = {0x01, 0x2A, 0x00, 0x02, 0x04, 0xAB, 0xCD, 0x00, 0x01};  // 298, 2
+    TEST_ASSERT_EQUAL_HEX8(MB_FC_WRITE_MULTIPLE_REGISTERS,
+                           request(MB_FC_WRITE_MULTIPLE_REGISTERS, fits, sizeof(fits), out,
+                                   &length));
+    TEST_ASSERT_EQUAL_HEX16(0xABCD, holding[198]);
+    TEST_ASSERT_EQUAL_HEX16(0x0001, holding[199]);
+
+    // Byte count disagreeing with the quantity
+    uint8_t wrong[sizeof(fits)];
+    memcpy(wrong, fits, sizeof(fits));
+    wrong[4] = 3;
+    TEST_ASSERT_EQUAL_HEX8(0x90, request(MB_FC_WRITE_MULTIPLE_REGISTERS, wrong, sizeof(wrong), out,
+                                         &length));
+    TEST_ASSERT_EQUAL_HEX8(MB_EX_ILLEGAL_DATA_VALUE, out[0]);
+}
+
+void test_read_write_registers_writes_first(void) {
+    // Read 100..101, write 101 = 0x0042
+    const uint8_t pdu[] = {0x00, 0x64, 0x00, 0x02, 0x00, 0x65, 0x00, 0x01, 0x02, 0x00, 0x42};
+    uint8_t out[252];
+    uint16_t length = 0;
+
+    TEST_ASSERT_EQUAL_HEX8(MB_FC_READ_WRITE_MULTIPLE_REGISTERS,
+                           request(MB_FC_READ_WRITE_MULTIPLE_REGISTERS, pdu, sizeof(pdu), out,
+                                   &length));
+    const uint8_t expected[] = {4, 0x9C, 0x40, 0x00, 0x42};
+    TEST_ASSERT_EQUAL_UINT16(sizeof(expected), length);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, out, sizeof(expected));
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_READ_WRITE_MULTIPLE_REGISTERS, written.fc);
+}
+
+void test_exceptions(void) {
+    uint8_t out[252];
+    uint16_t length = 0;
+
+    const uint8_t any[] = {0x00, 0x00, 0x00, 0x01};
+    TEST_ASSERT_EQUAL_HEX8(0xAB, request(0x2B, any, 4, out, &length));
+    TEST_ASSERT_EQUAL_HEX8(MB_EX_ILLEGAL_FUNCTION, out[0]);
+    TEST_ASSERT_EQUAL_UINT16(1, length);
+
+    // Below the table base
+    TEST_ASSERT_EQUAL_HEX8(0x83, request(MB_FC_READ_HOLDING_REGISTERS, any, 4, out, &length));
+    TEST_ASSERT_EQUAL_HEX8(MB_EX_ILLEGAL_DATA_ADDRESS, out[0]);
+
+    const uint8_t too_many[] = {0x00, 0x64, 0x00, 0x7E};  // 126 registers
+    TEST_ASSERT_EQUAL_HEX8(0x83, request(MB_FC_READ_HOLDING_REGISTERS, too_many, 4, out, &length));
+    TEST_ASSERT_EQUAL_HEX8(MB_EX_ILLEGAL_DATA_VALUE, out[0]);
+
+    TEST_ASSERT_EQUAL_HEX8(0x83, request(MB_FC_READ_HOLDING_REGISTERS, any, 2, out, &length));
+    TEST_ASSERT_EQUAL_HEX8(MB_EX_ILLEGAL_DATA_VALUE, out[0]);
+
+    TEST_ASSERT_EQUAL_UINT32(4, slave.stats.exceptions);
+    TEST_ASSERT_EQUAL_UINT32(4, slave.stats.requests);
+}
+
+#ifdef MB_ENABLE_RTU
+void test_rtu_frames(void) {
+    const uint8_t pdu[] = {0x00, 0x00, 0x00, 0x02};
+    uint8_t frame[16];
+    uint16_t frame_length = 0;
+    uint8_t response[260];
+    uint16_t response_length = 0;
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_build_frame(7, MB_FC_READ_INPUT_REGISTERS, pdu, 4, MB_MODE_RTU,
+                                                 0, frame, sizeof(frame), &frame_length));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_slave_process_frame(&slave, MB_MODE_RTU, frame, frame_length,
+                                                         response, sizeof(response),
+                                                         &response_length));
+    const uint8_t expected[] = {7, 0x04, 4, 0x30, 0x00, 0x30, 0x01};
+    TEST_ASSERT_EQUAL_UINT16(sizeof(expected) + 2, response_length);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, response, sizeof(expected));
+
+    // Another unit's request is not answered
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_build_frame(8, MB_FC_READ_INPUT_REGISTERS, pdu, 4, MB_MODE_RTU,
+                                                 0, frame, sizeof(frame), &frame_length));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_slave_process_frame(&slave, MB_MODE_RTU, frame, frame_length,
+                                                         response, sizeof(response),
+                                                         &response_length));
+    TEST_ASSERT_EQUAL_UINT16(0, response_length);
+
+    // Neither is a corrupted one
+    frame[2] ^= 0x01;
+    TEST_ASSERT_EQUAL(MB_ERROR_CRC_MISMATCH,
+                      mb_slave_process_frame(&slave, MB_MODE_RTU, frame, frame_length, response,
+                                             sizeof(response), &response_length));
+    TEST_ASSERT_EQUAL_UINT16(0, response_length);
+    TEST_ASSERT_EQUAL_UINT32(2, slave.stats.ignored);
+}
+
+void test_rtu_broadcast_write_is_executed_silently(void) {
+    const uint8_t pdu[] = {0x00, 0x65, 0x00, 0x07};  // 101 = 7
+    uint8_t frame[16];
+    uint16_t frame_length = 0;
+    uint8_t response[260];
+    uint16_t response_length = 0;
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_build_frame(0, MB_FC_WRITE_SINGLE_REGISTER, pdu, 4,
+                                                 MB_MODE_RTU, 0, frame, sizeof(frame),
+                                                 &frame_length));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_slave_process_frame(&slave, MB_MODE_RTU, frame, frame_length,
+                                                         response, sizeof(response),
+                                                         &response_length));
+    TEST_ASSERT_EQUAL_UINT16(0, response_length);
+    TEST_ASSERT_EQUAL_UINT16(7, holding[1]);
+}
+#endif
+
+#ifdef MB_ENABLE_TCP
+void test_tcp_frames_echo_transaction_id(void) {
+    const uint8_t pdu[] = {0x00, 0x64, 0x00, 0x01};
+    uint8_t frame[16];
+    uint16_t frame_length = 0;
+    uint8_t response[260];
+    uint16_t response_length = 0;
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_build_frame(7, MB_FC_READ_HOLDING_REGISTERS, pdu, 4,
+                                                 MB_MODE_TCP, 0xBEEF, frame, sizeof(frame),
+                                                 &frame_length));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_slave_process_frame(&slave, MB_MODE_TCP, frame, frame_length,
+                                                         response, sizeof(response),
+                                                         &response_length));
+    const uint8_t expected[] = {0xBE, 0xEF, 0, 0, 0, 5, 7, 0x03, 2, 0x9C, 0x40};
+    TEST_ASSERT_EQUAL_UINT16(sizeof(expected), response_length);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, response, sizeof(expected));
+
+    TEST_ASSERT_EQUAL(MB_ERROR_BUFFER_TOO_SMALL,
+                      mb_slave_process_frame(&slave, MB_MODE_TCP, frame, frame_length, response,
+                                             100, &response_length));
+}
+#endif
+
+#ifdef MB_ENABLE_SLAVE_SERVER
+static mb_slave_connection_t connections[2];
+static mb_slave_server_t server;
+
+static int connect_client(void) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    TEST_ASSERT_TRUE(fd >= 0);
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port   = htons(server.port);
+    TEST_ASSERT_EQUAL(1, inet_pton(AF_INET, "127.0.0.1", &address.sin_addr));
+    TEST_ASSERT_EQUAL(0, connect(fd, (struct sockaddr *)&address, sizeof(address)));
+    return fd;
+}
+
+/**
+ * @brief Poll the server until it has answered count requests
+ */
+static void serve(int count) {
+    int served = 0;
+    for (int i = 0; i < 100 && served < count; i++) {
+        int result = mb_slave_server_poll(&server, 10);
+        TEST_ASSERT_TRUE(result >= 0);
+        served += result;
+    }
+    TEST_ASSERT_EQUAL(count, served);
+}
+
+void test_server_answers_pipelined_and_split_requests(void) {
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_slave_server_open(&server, &slave, "127.0.0.1", 0, connections, 2));
+    TEST_ASSERT_TRUE(server.port != 0);
+    int fd = connect_client();
+
+    // Two requests in one segment, then one split across two
+    uint8_t stream[48];
+    uint16_t length = 0;
+    uint16_t total  = 0;
+    for (uint16_t tid = 1; tid <= 3; tid++) {
+        const uint8_t pdu[] = {0x00, (uint8_t)(0x63 + tid), 0x00, 0x01};
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_build_frame(7, MB_FC_READ_HOLDING_REGISTERS, pdu, 4,
+                                                     MB_MODE_TCP, tid, &stream[total], 16,
+                                                     &length));
+        total = (uint16_t)(total + length);
+    }
+
+    TEST_ASSERT_EQUAL(2 * length + 5, send(fd, stream, 2 * length + 5, 0));
+    serve(2);
+    TEST_ASSERT_EQUAL(length - 5, send(fd, &stream[2 * length + 5], length - 5, 0));
+    serve(1);
+
+    uint8_t response[64];
+    size_t received = 0;
+    while (received < 3 * 11) {
+        ssize_t n = recv(fd, &response[received], sizeof(response) - received, 0);
+        TEST_ASSERT_TRUE(n > 0);
+        received += (size_t)n;
+    }
+    for (uint16_t tid = 1; tid <= 3; tid++) {
+        const uint8_t *frame = &response[(tid - 1) * 11];
+        TEST_ASSERT_EQUAL_UINT8(tid, frame[1]);
+        TEST_ASSERT_EQUAL_UINT16(40000 + tid - 1, (uint16_t)((frame[9] << 8) | frame[10]));
+    }
+
+    // A non-Modbus stream is dropped
+    TEST_ASSERT_EQUAL(8, send(fd, "GET / HT", 8, 0));
+    for (int i = 0; i < 10 && server.open > 0; i++) {
+        TEST_ASSERT_TRUE(mb_slave_server_poll(&server, 10) >= 0);
+    }
+    TEST_ASSERT_EQUAL_UINT16(0, server.open);
+    TEST_ASSERT_EQUAL_UINT32(1, server.accepted);
+
+    (void)close(fd);
+    mb_slave_server_close(&server);
+}
+#endif
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_init_rejects_wrapping_table);
+    RUN_TEST(test_tables_are_cache_line_aligned);
+    RUN_TEST(test_read_holding_registers);
+    RUN_TEST(test_read_input_registers_at_table_end);
+    RUN_TEST(test_read_coils_at_unaligned_offsets);
+    RUN_TEST(test_read_discrete_inputs);
+    RUN_TEST(test_write_single_coil_and_register);
+    RUN_TEST(test_write_multiple_coils_keeps_neighbours);
+    RUN_TEST(test_write_multiple_registers);
+    RUN_TEST(test_read_write_registers_writes_first);
+    RUN_TEST(test_exceptions);
+#ifdef MB_ENABLE_RTU
+    RUN_TEST(test_rtu_frames);
+    RUN_TEST(test_rtu_broadcast_write_is_executed_silently);
+#endif
+#ifdef MB_ENABLE_TCP
+    RUN_TEST(test_tcp_frames_echo_transaction_id);
+#endif
+#ifdef MB_ENABLE_SLAVE_SERVER
+    RUN_TEST(test_server_answers_pipelined_and_split_requests);
+#endif
+
+    return UNITY_END();
+}
@@ -0,0 +1,249 @@
+/**
+ * @file test_static_poll.cpp
+ * @brief Unit tests for compile-time poll plans (mb_static_poll.hpp)
+ */
+
+#include "unity.h"
+#include "smartmodbus/mb_static_poll.hpp"
+#include "protocol/crc16.h"
+#include "protocol/frame_builder.h"
+
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief Synchronous slave in any mode: register value == address
+ */
+struct MockSlave {
+    mb_mode_t mode = MB_MODE_RTU;
+    uint16_t requests = 0;
+    uint8_t out[600];
+    size_t out_length = 0;
+
+    static int send(void *ctx, const uint8_t *data, size_t len) {
+        auto *self = static_cast<MockSlave *>(ctx);
+
+        uint16_t tid = 0;
+        uint8_t unit = 0;
+        uint8_t fc   = 0;
+        uint8_t pdu[252];
+        uint16_t pdu_length = 0;
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_parse_frame(data, static_cast<uint16_t>(len), self->mode,
+                                                     &tid, &unit, &fc, pdu, &pdu_length));
+        self->requests++;
+
+        uint16_t start = static_cast<uint16_t>((pdu[0] << 8) | pdu[1]);
+        uint16_t qty   = static_cast<uint16_t>((pdu[2] << 8) | pdu[3]);
+        uint8_t resp[252];
+        uint16_t pos = 0;
+        resp[pos++]  = static_cast<uint8_t>(qty * 2);
+        for (uint16_t i = 0; i < qty; i++) {
+            uint16_t value = static_cast<uint16_t>(start + i);
+            resp[pos++]    = static_cast<uint8_t>(value >> 8);
+            resp[pos++]    = static_cast<uint8_t>(value & 0xFF);
+        }
+
+        uint16_t length = 0;
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_build_frame(unit, fc, resp, pos, self->mode, tid,
+                                                     self->out, sizeof(self->out), &length));
+        self->out_length = length;
+        return static_cast<int>(len);
+    }
+
+    static int recv(void *ctx, uint8_t *buffer, size_t max_len, size_t *received) {
+        auto *self = static_cast<MockSlave *>(ctx);
+        size_t n   = self->out_length < max_len ? self->out_length : max_len;
+        std::memcpy(buffer, self->out, n);
+        self->out_length -= n;
+        std::memmove(self->out, &self->out[n], self->out_length);
+        *received = n;
+        return 0;
+    }
+};
+
+MockSlave slave;
+mb_master_t master;
+
+void init_master(mb_mode_t mode) {
+    slave                    = MockSlave{};
+    slave.mode               = mode;
+    mb_config_t config       = mb_config_default(mode);
+    config.transport.send    = &MockSlave::send;
+    config.transport.recv    = &MockSlave::recv;
+    config.transport.context = &slave;
+    config.timeout_ms        = 100;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+}
+
+constexpr uint16_t meter_registers[] = {2000, 1, 0, 1000, 1001, 2, 7, 20, 21, 22, 1001};
+constexpr uint16_t coil_addresses[]  = {0, 5, 40, 41, 100, 3000, 130};
+
+// Runs of four registers, four apart: one merged block split into full
+// PDUs. Small enough for the runtime planner's static memory limits.
+constexpr std::array<uint16_t, 120> spread_registers = [] {
+    std::array<uint16_t, 120> addresses{};
+    for (std::size_t i = 0; i < addresses.size(); i++) {
+        addresses[i] = static_cast<uint16_t>((i / 4) * 8 + i % 4);
+    }
+    return addresses;
+}();
+
+constexpr auto meter_rtu   = smartmodbus::compile_poll(1, MB_FC_READ_HOLDING_REGISTERS,
+                                                       meter_registers, MB_MODE_RTU);
+constexpr auto meter_ascii = smartmodbus::compile_poll(1, MB_FC_READ_HOLDING_REGISTERS,
+                                                       meter_registers, MB_MODE_ASCII);
+constexpr auto meter_tcp   = smartmodbus::compile_poll(1, MB_FC_READ_HOLDING_REGISTERS,
+                                                       meter_registers, MB_MODE_TCP);
+constexpr auto coils_rtu   = smartmodbus::compile_poll(9, MB_FC_READ_COILS, coil_addresses,
+                                                       MB_MODE_RTU);
+constexpr auto spread_rtu  = smartmodbus::compile_poll(3, MB_FC_READ_INPUT_REGISTERS,
+                                                       spread_registers, MB_MODE_RTU);
+constexpr auto small_pdus  = smartmodbus::compile_poll(1, MB_FC_READ_HOLDING_REGISTERS,
+                                                       meter_registers, MB_MODE_RTU,
+                                                       smartmodbus::PollOptions{0, 8});
+
+// Planned entirely by the compiler
+static_assert(meter_rtu.plan_count == 3);
+static_assert(spread_rtu.plan_count == 2);
+
+/**
+ * @brief Static plan must match what mb_poll_plan_compile() builds at run time
+ */
+template <const auto &Image>
+void expect_runtime_plan(uint8_t slave_id, uint8_t fc, const uint16_t *addresses, uint16_t count,
+                         int latency_chars = -1, uint16_t max_pdu_chars = 0) {
+    init_master(Image.mode);
+    if (latency_chars >= 0) {
+        master.config.latency_chars = static_cast<uint8_t>(latency_chars);
+        master.config.max_pdu_chars = max_pdu_chars;
+    }
+
+    mb_read_request_t request = {slave_id, fc, const_cast<uint16_t *>(addresses), count};
+    mb_poll_plan_t runtime;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile(&master, &request, &runtime));
+
+    const mb_static_poll_t *poll = smartmodbus::StaticPoll<Image>::get();
+    TEST_ASSERT_EQUAL(runtime.mode, poll->mode);
+    TEST_ASSERT_EQUAL_UINT16(runtime.address_count, poll->address_count);
+    TEST_ASSERT_EQUAL_UINT16(runtime.plan_count, poll->plan_count);
+
+    for (uint16_t p = 0; p < poll->plan_count; p++) {
+        const mb_request_plan_t &expected = runtime.plans[p];
+        const mb_request_plan_t &actual   = poll->plans[p];
+        TEST_ASSERT_EQUAL_UINT8(expected.slave_id, actual.slave_id);
+        TEST_ASSERT_EQUAL_UINT8(expected.function_code, actual.function_code);
+        TEST_ASSERT_EQUAL_UINT16(expected.start_address, actual.start_address);
+        TEST_ASSERT_EQUAL_UINT16(expected.quantity, actual.quantity);
+        TEST_ASSERT_EQUAL_UINT16(expected.frame_length, actual.frame_length);
+        TEST_ASSERT_EQUAL_UINT16(expected.expected_response_length,
+                                 actual.expected_response_length);
+        TEST_ASSERT_EQUAL_UINT16(expected.scatter_first, actual.scatter_first);
+        TEST_ASSERT_EQUAL_UINT16(expected.scatter_count, actual.scatter_count);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected.frame_data, actual.frame_data,
+                                      expected.frame_length);
+    }
+    for (uint16_t i = 0; i < poll->address_count; i++) {
+        TEST_ASSERT_EQUAL_UINT16(runtime.scatter[i].plan_index, poll->scatter[i].plan_index);
+        TEST_ASSERT_EQUAL_UINT16(runtime.scatter[i].offset, poll->scatter[i].offset);
+        TEST_ASSERT_EQUAL_UINT16(runtime.scatter[i].dest_index, poll->scatter[i].dest_index);
+    }
+
+    mb_poll_plan_free(&runtime);
+    mb_master_cleanup(&master);
+}
+
+}  // namespace
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_matches_runtime_planner_in_every_mode(void) {
+    constexpr uint16_t count = sizeof(meter_registers) / sizeof(meter_registers[0]);
+    expect_runtime_plan<meter_rtu>(1, MB_FC_READ_HOLDING_REGISTERS, meter_registers, count);
+    expect_runtime_plan<meter_ascii>(1, MB_FC_READ_HOLDING_REGISTERS, meter_registers, count);
+    expect_runtime_plan<meter_tcp>(1, MB_FC_READ_HOLDING_REGISTERS, meter_registers, count);
+}
+
+void test_matches_runtime_planner_for_coils_and_long_runs(void) {
+    expect_runtime_plan<coils_rtu>(9, MB_FC_READ_COILS, coil_addresses,
+                                   sizeof(coil_addresses) / sizeof(coil_addresses[0]));
+    expect_runtime_plan<spread_rtu>(3, MB_FC_READ_INPUT_REGISTERS, spread_registers.data(),
+                                    static_cast<uint16_t>(spread_registers.size()));
+}
+
+void test_options_match_runtime_config(void) {
+    expect_runtime_plan<small_pdus>(1, MB_FC_READ_HOLDING_REGISTERS, meter_registers,
+                                    sizeof(meter_registers) / sizeof(meter_registers[0]), 0, 8);
+}
+
+void test_rtu_frames_are_constant_data(void) {
+    using Poll                   = smartmodbus::StaticPoll<meter_rtu>;
+    const mb_static_poll_t *poll = Poll::get();
+    static_assert(Poll::plan_count == 3 && Poll::address_count == 11);
+
+    // 01 03 0000 0017 + CRC, CRC low byte first
+    const uint8_t *frame = poll->plans[0].frame_data;
+    const uint8_t head[] = {0x01, 0x03, 0x00, 0x00, 0x00, 0x17};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(head, frame, sizeof(head));
+    uint16_t crc = mb_crc16(frame, sizeof(head));
+    TEST_ASSERT_EQUAL_HEX8(crc & 0xFF, frame[6]);
+    TEST_ASSERT_EQUAL_HEX8(crc >> 8, frame[7]);
+    TEST_ASSERT_EQUAL_UINT16(8, poll->plans[0].frame_length);
+}
+
+void test_execute_scatters_values(void) {
+    init_master(MB_MODE_RTU);
+    uint16_t data[11] = {0};
+
+    for (int cycle = 0; cycle < 2; cycle++) {
+        TEST_ASSERT_EQUAL(MB_SUCCESS,
+                          smartmodbus::StaticPoll<meter_rtu>::execute(master, data, 11));
+        TEST_ASSERT_EQUAL_UINT16_ARRAY(meter_registers, data, 11);
+    }
+    TEST_ASSERT_EQUAL_UINT16(6, slave.requests);
+    TEST_ASSERT_EQUAL_UINT32(16, master.stats.blocks_merged);
+    mb_master_cleanup(&master);
+}
+
+void test_execute_tcp_patches_transaction_id(void) {
+    init_master(MB_MODE_TCP);
+    uint16_t data[11] = {0};
+
+    for (int cycle = 0; cycle < 3; cycle++) {
+        TEST_ASSERT_EQUAL(MB_SUCCESS,
+                          smartmodbus::StaticPoll<meter_tcp>::execute(master, data, 11));
+        TEST_ASSERT_EQUAL_UINT16_ARRAY(meter_registers, data, 11);
+    }
+    TEST_ASSERT_EQUAL_UINT16(9, slave.requests);
+    mb_master_cleanup(&master);
+}
+
+void test_execute_rejects_mismatches(void) {
+    init_master(MB_MODE_TCP);
+    uint16_t data[11];
+
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      smartmodbus::StaticPoll<meter_rtu>::execute(master, data, 11));
+    TEST_ASSERT_EQUAL(MB_ERROR_BUFFER_TOO_SMALL,
+                      smartmodbus::StaticPoll<meter_tcp>::execute(master, data, 10));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_master_execute_static_poll(&master, nullptr, data, 11));
+    TEST_ASSERT_EQUAL_UINT16(0, slave.requests);
+    mb_master_cleanup(&master);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_matches_runtime_planner_in_every_mode);
+    RUN_TEST(test_matches_runtime_planner_for_coils_and_long_runs);
+    RUN_TEST(test_options_match_runtime_config);
+    RUN_TEST(test_rtu_frames_are_constant_data);
+    RUN_TEST(test_execute_scatters_values);
+    RUN_TEST(test_execute_tcp_patches_transaction_id);
+    RUN_TEST(test_execute_rejects_mismatches);
+
+    return UNITY_END();
+}
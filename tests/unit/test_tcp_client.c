@@ -0,0 +1,251 @@
+/**
+ * @file test_tcp_client.c
+ * @brief Unit tests for the reference Linux TCP client transport
+ *
+ * The server side is the other end of a socketpair: responses are written
+ * into it before the master reads, and requests are read back from it
+ * afterwards.
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define PAIRS 3
+
+static int peers[PAIRS];
+static mb_tcp_client_t clients[PAIRS];
+static mb_master_t master;
+
+// Three far-apart blocks: plans of 3, 2 and 1 registers with TIDs 0, 1, 2
+static uint16_t addresses[] = {0, 1, 2, 1000, 1001, 2000};
+static const mb_read_request_t request = {.slave_id      = 1,
+                                          .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                          .addresses     = addresses,
+                                          .address_count = 6};
+
+static void open_pairs(uint32_t timeout_ms) {
+    for (int i = 0; i < PAIRS; i++) {
+        int fds[2];
+        TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        mb_tcp_client_adopt(&clients[i], fds[0], timeout_ms);
+        peers[i] = fds[1];
+    }
+}
+
+/**
+ * @brief Queue an FC03 response (value == address) on the server side
+ */
+static void write_response(int peer, uint16_t tid, uint16_t start, uint16_t quantity) {
+    uint8_t frame[64];
+    uint16_t length = (uint16_t)(3 + 2 * quantity);
+    frame[0]        = (uint8_t)(tid >> 8);
+    frame[1]        = (uint8_t)tid;
+    frame[2]        = 0;
+    frame[3]        = 0;
+    frame[4]        = (uint8_t)(length >> 8);
+    frame[5]        = (uint8_t)length;
+    frame[6]        = 1;
+    frame[7]        = MB_FC_READ_HOLDING_REGISTERS;
+    frame[8]        = (uint8_t)(2 * quantity);
+    for (uint16_t i = 0; i < quantity; i++) {
+        frame[9 + 2 * i]  = (uint8_t)((start + i) >> 8);
+        frame[10 + 2 * i] = (uint8_t)(start + i);
+    }
+    TEST_ASSERT_EQUAL_INT(6 + length, (int)write(peer, frame, (size_t)(6 + length)));
+}
+
+static void write_responses(int peer) {
+    write_response(peer, 0, 0, 3);
+    write_response(peer, 1, 1000, 2);
+    write_response(peer, 2, 2000, 1);
+}
+
+/**
+ * @brief Read every request the client sent and check its transaction IDs
+ */
+static void expect_requests(int peer, uint16_t count) {
+    uint8_t stream[256];
+    ssize_t got = recv(peer, stream, sizeof(stream), MSG_DONTWAIT);
+    TEST_ASSERT_EQUAL_INT(count * 12, (int)got);
+    for (uint16_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL_UINT16(i, (uint16_t)(stream[12 * i] << 8 | stream[12 * i + 1]));
+        TEST_ASSERT_EQUAL_UINT8(MB_FC_READ_HOLDING_REGISTERS, stream[12 * i + 7]);
+    }
+}
+
+static void init_master(mb_tcp_client_t *client, uint8_t max_in_flight) {
+    mb_config_t config = mb_config_default(MB_MODE_TCP);
+    mb_tcp_client_transport(client, &config.transport);
+    config.max_in_flight = max_in_flight;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+}
+
+void setUp(void) {
+    memset(clients, 0, sizeof(clients));
+    for (int i = 0; i < PAIRS; i++) {
+        clients[i].fd = -1;
+        peers[i]      = -1;
+    }
+}
+
+void tearDown(void) {
+    for (int i = 0; i < PAIRS; i++) {
+        mb_tcp_client_close(&clients[i]);
+        if (peers[i] >= 0) {
+            (void)close(peers[i]);
+        }
+    }
+}
+
+void test_pipelined_window_leaves_in_one_sendmsg(void) {
+    open_pairs(1000);
+    write_responses(peers[0]);
+    init_master(&clients[0], 4);
+
+    uint16_t data[6];
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request, data, 6));
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 6);
+    TEST_ASSERT_EQUAL_UINT32(1, clients[0].send_calls);
+    expect_requests(peers[0], 3);
+
+    // Window of 2: the first fill leaves together, the refill on its own
+    clients[0].send_calls = 0;
+    init_master(&clients[0], 2);
+    write_responses(peers[0]);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request, data, 6));
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 6);
+    TEST_ASSERT_EQUAL_UINT32(2, clients[0].send_calls);
+    expect_requests(peers[0], 3);
+}
+
+void test_recv_times_out_and_reports_closed_peer(void) {
+    open_pairs(10);
+    mb_transport_t transport;
+    mb_tcp_client_transport(&clients[0], &transport);
+
+    uint8_t buffer[16];
+    size_t received = 1;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, transport.recv(&clients[0], buffer, sizeof(buffer), &received));
+    TEST_ASSERT_EQUAL_size_t(0, received);
+
+    // Non-blocking clients return at once
+    transport.set_timeout(&clients[0], 0);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, transport.recv(&clients[0], buffer, sizeof(buffer), &received));
+    TEST_ASSERT_EQUAL_size_t(0, received);
+
+    (void)close(peers[0]);
+    peers[0] = -1;
+    TEST_ASSERT_EQUAL(MB_ERROR_TRANSPORT,
+                      transport.recv(&clients[0], buffer, sizeof(buffer), &received));
+    TEST_ASSERT_EQUAL(MB_ERROR_TRANSPORT, transport.send(&clients[0], buffer, 12));
+
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_tcp_client_open(&clients[1], "not-an-ip", 502, 0));
+}
+
+#ifdef MB_ENABLE_TCP_URING
+
+static mb_tcp_uring_t ring;
+
+static void init_ring(void) {
+    int result = mb_tcp_uring_init(&ring);
+    if (result == MB_ERROR_NOT_SUPPORTED) {
+        TEST_IGNORE_MESSAGE("io_uring not available");
+    }
+    TEST_ASSERT_EQUAL(MB_SUCCESS, result);
+}
+
+void test_ring_sends_every_client_in_one_submit(void) {
+    init_ring();
+    open_pairs(0);
+
+    static const uint8_t frame[12] = {0, 0, 0, 0, 0, 6, 1, 3, 0, 0, 0, 1};
+    mb_transport_t transport;
+    for (int i = 0; i < PAIRS; i++) {
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_tcp_uring_attach(&ring, &clients[i]));
+        mb_tcp_client_transport(&clients[i], &transport);
+
+        mb_frame_vec_t frames[2] = {{frame, sizeof(frame)}, {frame, sizeof(frame)}};
+        TEST_ASSERT_EQUAL(MB_SUCCESS, transport.send_frames(&clients[i], frames, 2));
+        TEST_ASSERT_EQUAL_INT(12, transport.send(&clients[i], frame, sizeof(frame)));
+    }
+
+    // Nothing leaves before the submit
+    uint8_t stream[64];
+    for (int i = 0; i < PAIRS; i++) {
+        TEST_ASSERT_EQUAL_INT(-1, (int)recv(peers[i], stream, sizeof(stream), MSG_DONTWAIT));
+        TEST_ASSERT_EQUAL_INT(EAGAIN, errno);
+        TEST_ASSERT_EQUAL_UINT32(0, clients[i].send_calls);
+    }
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_tcp_uring_submit(&ring));
+    TEST_ASSERT_EQUAL_UINT32(1, ring.submits);
+    for (int i = 0; i < PAIRS; i++) {
+        TEST_ASSERT_EQUAL_INT(36, (int)recv(peers[i], stream, sizeof(stream), MSG_DONTWAIT));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(frame, &stream[24], sizeof(frame));
+        TEST_ASSERT_EQUAL_UINT16(0, clients[i].tx_length);
+    }
+
+    // Empty submits cost nothing
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_tcp_uring_submit(&ring));
+    TEST_ASSERT_EQUAL_UINT32(1, ring.submits);
+
+    for (int i = 0; i < PAIRS; i++) {
+        mb_tcp_client_close(&clients[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT16(0, ring.attached);
+    mb_tcp_uring_close(&ring);
+}
+
+void test_blocking_read_submits_its_own_requests(void) {
+    init_ring();
+    open_pairs(1000);
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_tcp_uring_attach(&ring, &clients[0]));
+    write_responses(peers[0]);
+    init_master(&clients[0], 4);
+
+    uint16_t data[6];
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request, data, 6));
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 6);
+    TEST_ASSERT_EQUAL_UINT32(0, clients[0].send_calls);
+    TEST_ASSERT_EQUAL_UINT32(1, ring.submits);
+    expect_requests(peers[0], 3);
+
+    // A queued client whose socket has failed is reported, the others still send
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_tcp_uring_attach(&ring, &clients[1]));
+    (void)close(peers[0]);
+    peers[0] = -1;
+    static const uint8_t frame[12] = {0, 9, 0, 0, 0, 6, 1, 3, 0, 0, 0, 1};
+    mb_transport_t transport;
+    mb_tcp_client_transport(&clients[0], &transport);
+    TEST_ASSERT_EQUAL_INT(12, transport.send(&clients[0], frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_INT(12, transport.send(&clients[1], frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL(MB_ERROR_TRANSPORT, mb_tcp_uring_submit(&ring));
+
+    uint8_t stream[16];
+    TEST_ASSERT_EQUAL_INT(12, (int)recv(peers[1], stream, sizeof(stream), MSG_DONTWAIT));
+    TEST_ASSERT_EQUAL_UINT16(0, ring.queued);
+
+    mb_tcp_client_close(&clients[0]);
+    mb_tcp_client_close(&clients[1]);
+    mb_tcp_uring_close(&ring);
+}
+
+#endif  // MB_ENABLE_TCP_URING
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_pipelined_window_leaves_in_one_sendmsg);
+    RUN_TEST(test_recv_times_out_and_reports_closed_peer);
+#ifdef MB_ENABLE_TCP_URING
+    RUN_TEST(test_ring_sends_every_client_in_one_submit);
+    RUN_TEST(test_blocking_read_submits_its_own_requests);
+#endif
+
+    return UNITY_END();
+}
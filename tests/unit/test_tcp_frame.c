@@ -7,6 +7,8 @@
 #include "protocol/tcp_frame.h"
 #include "smartmodbus/mb_error.h"
 
+#include <string.h>
+
 void setUp(void) {
 }
 
@@ -64,6 +66,30 @@ void test_tcp_calc_frame_length(void) {
     TEST_ASSERT_EQUAL_UINT16(12, length);
 }
 
+void test_tcp_encode_inplace_and_view(void) {
+    uint8_t pdu[] = {0x00, 0x00, 0x00, 0x0A};
+    uint8_t expected[16];
+    uint8_t frame[16];
+
+    int built = mb_tcp_build_frame(0x1234, 1, 0x03, pdu, 4, expected, sizeof(expected));
+
+    memcpy(&frame[MB_TCP_PDU_OFFSET], pdu, 4);
+    int encoded = mb_tcp_encode_inplace(0x1234, 1, 0x03, 4, frame, sizeof(frame));
+
+    TEST_ASSERT_EQUAL(built, encoded);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, frame, (size_t)built);
+
+    uint16_t tid;
+    uint8_t unit_id, fc;
+    const uint8_t *view = NULL;
+    uint16_t pdu_length;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_tcp_parse_view(frame, (uint16_t)encoded, &tid, &unit_id, &fc,
+                                                    &view, &pdu_length));
+    TEST_ASSERT_EQUAL_HEX16(0x1234, tid);
+    TEST_ASSERT_EQUAL_PTR(&frame[MB_TCP_PDU_OFFSET], view);
+    TEST_ASSERT_EQUAL_UINT16(4, pdu_length);
+}
+
 int main(void) {
     UNITY_BEGIN();
 
@@ -71,6 +97,7 @@ int main(void) {
     RUN_TEST(test_tcp_parse_frame_valid);
     RUN_TEST(test_tcp_parse_frame_invalid_protocol_id);
     RUN_TEST(test_tcp_calc_frame_length);
+    RUN_TEST(test_tcp_encode_inplace_and_view);
 
     return UNITY_END();
 }
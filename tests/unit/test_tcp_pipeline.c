@@ -0,0 +1,423 @@
+/**
+ * @file test_tcp_pipeline.c
+ * @brief Unit tests for pipelined Modbus TCP plan execution
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+#include "master/transaction.h"
+#include "mock_line.h"
+
+#include <string.h>
+
+/**
+ * @brief Pipelining quirks of the mock TCP slave behind the shared line
+ *
+ * Responses are held on send and released once recv() has drained the
+ * stream, optionally in reverse order (out of order).
+ */
+typedef struct {
+    uint8_t held[16][260];
+    uint16_t held_lengths[16];
+    uint16_t held_count;
+    bool reverse_order;
+    uint16_t sends_before_first_recv;
+    bool recv_seen;
+    uint16_t fail_send_at; /**< 1-based send that fails (0 = none) */
+    uint8_t reply_unit;    /**< Unit ID put in responses (0 = the request's) */
+} pipeline_t;
+
+static mock_line_t line;
+static pipeline_t slave;
+
+static void hold_response(mock_line_t *l, size_t len) {
+    (void)len;
+    if (!slave.recv_seen) {
+        slave.sends_before_first_recv++;
+    }
+    if (slave.reply_unit != 0) {
+        l->response[6] = slave.reply_unit;  // MBAP unit ID
+    }
+    memcpy(slave.held[slave.held_count], l->response, l->response_length);
+    slave.held_lengths[slave.held_count++] = l->response_length;
+    l->response_length                     = 0;
+}
+
+static void release_responses(mock_line_t *l, size_t max_len) {
+    (void)max_len;
+    slave.recv_seen = true;
+    if (l->rx_length > 0) {
+        return;
+    }
+    for (uint16_t n = 0; n < slave.held_count; n++) {
+        uint16_t i = slave.reverse_order ? (uint16_t)(slave.held_count - 1 - n) : n;
+        mock_line_deliver(l, slave.held[i], slave.held_lengths[i]);
+    }
+    slave.held_count = 0;
+}
+
+static int mock_send(void *ctx, const uint8_t *data, size_t len) {
+    if (slave.fail_send_at > 0 && line.requests + 1 == slave.fail_send_at) {
+        slave.fail_send_at = 0;
+        return -1;
+    }
+    return mock_line_send(ctx, data, len);
+}
+
+static uint16_t vector_calls;
+static bool vector_fails;
+
+// Vectored send: each frame goes through the single-frame mock
+static int mock_send_frames(void *ctx, const mb_frame_vec_t *frames, size_t count) {
+    vector_calls++;
+    if (vector_fails) {
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        (void)mock_send(ctx, frames[i].data, frames[i].len);
+    }
+    return 0;
+}
+
+static mb_master_t master;
+
+static void init_master(uint8_t max_in_flight) {
+    mb_config_t config = mb_config_default(MB_MODE_TCP);
+    mock_line_attach(&line, &config);
+    config.transport.send = mock_send;
+    config.max_in_flight  = max_in_flight;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+}
+
+static void reset_line(void) {
+    memset(&line, 0, sizeof(line));
+    line.mode      = MB_MODE_TCP;
+    line.queue     = true;
+    line.sent      = hold_response;
+    line.receiving = release_responses;
+    memset(&slave, 0, sizeof(slave));
+}
+
+void setUp(void) {
+    reset_line();
+    vector_calls = 0;
+    vector_fails = false;
+}
+
+void tearDown(void) {
+}
+
+// Three far-apart blocks of distinct size so plan order is deterministic
+static uint16_t addresses[] = {0, 1, 2, 1000, 1001, 2000};
+static const mb_read_request_t request = {.slave_id      = 1,
+                                          .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                          .addresses     = addresses,
+                                          .address_count = 6};
+
+void test_pipelined_sends_full_window_before_receiving(void) {
+    init_master(4);
+    slave.reverse_order = true;
+
+    uint16_t data[6];
+    int ret = mb_master_read_optimized(&master, &request, data, 6);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+    TEST_ASSERT_EQUAL_UINT16(3, slave.sends_before_first_recv);
+    TEST_ASSERT_EQUAL_UINT16(0, line.tids[0]);
+    TEST_ASSERT_EQUAL_UINT16(1, line.tids[1]);
+    TEST_ASSERT_EQUAL_UINT16(2, line.tids[2]);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 6);
+}
+
+void test_pipelined_window_limits_outstanding_requests(void) {
+    init_master(2);
+    slave.reverse_order = true;
+
+    uint16_t data[6];
+    int ret = mb_master_read_optimized(&master, &request, data, 6);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+    TEST_ASSERT_EQUAL_UINT16(2, slave.sends_before_first_recv);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 6);
+}
+
+void test_pipelined_reassembles_chunked_stream(void) {
+    init_master(4);
+    slave.reverse_order = true;
+    line.chunk          = 5;
+
+    uint16_t data[6];
+    int ret = mb_master_read_optimized(&master, &request, data, 6);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 6);
+}
+
+void test_pipelined_results_follow_request_order(void) {
+    init_master(4);
+    slave.reverse_order = true;
+
+    // Unsorted request with a small gap (3..4) that gets merged away
+    uint16_t unsorted[] = {2000, 5, 0, 1000};
+    mb_read_request_t req = {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                             .addresses = unsorted, .address_count = 4};
+
+    uint16_t data[4];
+    int ret = mb_master_read_optimized(&master, &req, data, 4);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(unsorted, data, 4);
+}
+
+void test_stop_and_wait_by_default(void) {
+    init_master(1);
+
+    uint16_t data[6];
+    int ret = mb_master_read_optimized(&master, &request, data, 6);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+    TEST_ASSERT_EQUAL_UINT16(1, slave.sends_before_first_recv);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(addresses, data, 6);
+}
+
+void test_transaction_id_increments_per_request(void) {
+    init_master(1);
+
+    uint16_t data[2];
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_master_read_single(&master, 1, MB_FC_READ_HOLDING_REGISTERS, 10, 2, data));
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_master_read_single(&master, 1, MB_FC_READ_HOLDING_REGISTERS, 20, 2, data));
+
+    TEST_ASSERT_EQUAL_UINT16(2, line.requests);
+    TEST_ASSERT_EQUAL_UINT16(0, line.tids[0]);
+    TEST_ASSERT_EQUAL_UINT16(1, line.tids[1]);
+    TEST_ASSERT_EQUAL_UINT16(20, data[0]);
+    TEST_ASSERT_EQUAL_UINT16(21, data[1]);
+}
+
+void test_stale_response_is_discarded(void) {
+    init_master(1);
+
+    // Pre-load a response for a transaction that is no longer outstanding
+    const uint8_t stale[] = {0x12, 0x34, 0x00, 0x00, 0x00, 0x05, 0x01, 0x03, 0x02, 0xDE, 0xAD};
+    mock_line_deliver(&line, stale, sizeof(stale));
+
+    uint16_t data[1];
+    int ret = mb_master_read_single(&master, 1, MB_FC_READ_HOLDING_REGISTERS, 7, 1, data);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_UINT16(7, data[0]);
+}
+
+void test_batch_read_spans_slaves_and_function_codes(void) {
+    init_master(4);
+    slave.reverse_order = true;
+
+    mb_tag_t tags[] = {
+        {.slave_id = 2, .function_code = MB_FC_READ_INPUT_REGISTERS, .address = 30},
+        {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS, .address = 11},
+        {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS, .address = 10},
+        {.slave_id = 2, .function_code = MB_FC_READ_HOLDING_REGISTERS, .address = 500},
+    };
+
+    uint16_t data[4];
+    int ret = mb_master_read_batch(&master, tags, 4, data, 4);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, ret);
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+    TEST_ASSERT_EQUAL_UINT16(30, data[0]);
+    TEST_ASSERT_EQUAL_UINT16(11, data[1]);
+    TEST_ASSERT_EQUAL_UINT16(10, data[2]);
+    TEST_ASSERT_EQUAL_UINT16(500, data[3]);
+}
+
+void test_vectored_send_hands_over_each_window_fill_at_once(void) {
+    init_master(4);
+    master.config.transport.send_frames = mock_send_frames;
+
+    uint16_t data[6];
+    uint16_t expected[6] = {0, 1, 2, 1000, 1001, 2000};
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request, data, 6));
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, data, 6);
+    TEST_ASSERT_EQUAL_UINT16(1, vector_calls);
+    TEST_ASSERT_EQUAL_UINT16(3, slave.sends_before_first_recv);
+    TEST_ASSERT_EQUAL_UINT32(3, master.stats.total_requests);
+
+    // Window of 2: the first fill carries two requests, the refills one each
+    reset_line();
+    vector_calls                 = 0;
+    master.config.max_in_flight  = 2;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request, data, 6));
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, data, 6);
+    TEST_ASSERT_EQUAL_UINT16(2, vector_calls);
+    TEST_ASSERT_EQUAL_UINT16(2, slave.sends_before_first_recv);
+}
+
+void test_vectored_send_of_compiled_poll_patches_transaction_ids(void) {
+    init_master(4);
+    master.config.transport.send_frames = mock_send_frames;
+
+    static mb_poll_plan_t poll;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_poll_plan_compile(&master, &request, &poll));
+
+    uint16_t data[6];
+    for (int cycle = 0; cycle < 2; cycle++) {
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_execute_poll(&master, &poll, data, 6));
+    }
+    TEST_ASSERT_EQUAL_UINT16(2, vector_calls);
+    TEST_ASSERT_EQUAL_UINT16(6, line.requests);
+    for (uint16_t i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_UINT16(i, line.tids[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT16(2000, data[5]);
+
+    mb_poll_plan_free(&poll);
+}
+
+void test_failed_send_abandons_the_window(void) {
+    static mb_metrics_series_t series[2];
+    static mb_metrics_t metrics;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_metrics_init(&metrics, series, 2));
+    init_master(4);
+    master.config.metrics = &metrics;
+    slave.fail_send_at    = 2;
+
+    uint16_t data[6];
+    TEST_ASSERT_NOT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request, data, 6));
+
+    // The request already on the wire is accounted as failed, not left open
+    mb_metrics_series_t *s = mb_metrics_find(&metrics, 1, MB_FC_READ_HOLDING_REGISTERS);
+    TEST_ASSERT_NOT_NULL(s);
+    TEST_ASSERT_EQUAL_UINT32(1, s->requests);
+    TEST_ASSERT_EQUAL_UINT32(1, s->frame_errors);
+    TEST_ASSERT_EQUAL_UINT32(0, s->responses);
+}
+
+void test_failed_vectored_send_abandons_the_window(void) {
+    static mb_metrics_series_t series[2];
+    static mb_metrics_t metrics;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_metrics_init(&metrics, series, 2));
+    init_master(4);
+    master.config.transport.send_frames = mock_send_frames;
+    master.config.metrics               = &metrics;
+    vector_fails                        = true;
+
+    uint16_t data[6];
+    TEST_ASSERT_EQUAL(MB_ERROR_TRANSPORT, mb_master_read_optimized(&master, &request, data, 6));
+
+    // Every request of the failed fill is accounted as failed
+    mb_metrics_series_t *s = mb_metrics_find(&metrics, 1, MB_FC_READ_HOLDING_REGISTERS);
+    TEST_ASSERT_NOT_NULL(s);
+    TEST_ASSERT_EQUAL_UINT32(0, s->requests);
+    TEST_ASSERT_EQUAL_UINT32(3, s->frame_errors);
+    TEST_ASSERT_EQUAL_UINT16(1, vector_calls);
+}
+
+void test_mismatched_unit_abandons_the_window(void) {
+    static mb_metrics_series_t series[2];
+    static mb_metrics_t metrics;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_metrics_init(&metrics, series, 2));
+    init_master(4);
+    master.config.metrics = &metrics;
+    slave.reply_unit      = 9;
+
+    uint16_t data[6];
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_FRAME,
+                      mb_master_read_optimized(&master, &request, data, 6));
+
+    // The mismatched response and the two requests still outstanding
+    mb_metrics_series_t *s = mb_metrics_find(&metrics, 1, MB_FC_READ_HOLDING_REGISTERS);
+    TEST_ASSERT_NOT_NULL(s);
+    TEST_ASSERT_EQUAL_UINT32(3, s->requests);
+    TEST_ASSERT_EQUAL_UINT32(3, s->frame_errors);
+}
+
+static uint16_t handled;
+
+static int fail_first_response(void *ctx,
+                               uint16_t plan_index,
+                               uint8_t fc,
+                               const uint8_t *pdu_data,
+                               uint16_t pdu_length) {
+    (void)ctx;
+    (void)plan_index;
+    (void)fc;
+    (void)pdu_data;
+    (void)pdu_length;
+    handled++;
+    return MB_ERROR_INVALID_FRAME;
+}
+
+void test_failed_handler_abandons_the_window(void) {
+    static mb_metrics_series_t series[2];
+    static mb_metrics_t metrics;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_metrics_init(&metrics, series, 2));
+    init_master(4);
+    master.config.metrics = &metrics;
+    slave.reverse_order   = true;
+    handled               = 0;
+
+    const mb_request_plan_t plans[] = {{1, MB_FC_READ_HOLDING_REGISTERS, 0, 3},
+                                       {1, MB_FC_READ_HOLDING_REGISTERS, 1000, 2},
+                                       {1, MB_FC_READ_HOLDING_REGISTERS, 2000, 1}};
+    mb_plans_report_t report;
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_FRAME,
+                      mb_transaction_execute_plans_report(&master, plans, 3, fail_first_response,
+                                                          NULL, &report));
+
+    // The last plan answered first and failed; the two outstanding are accounted too
+    TEST_ASSERT_EQUAL_UINT16(1, handled);
+    TEST_ASSERT_EQUAL_UINT16(2, report.failed_plan);
+    TEST_ASSERT_EQUAL_UINT16(3, report.attempted);
+    mb_metrics_series_t *s = mb_metrics_find(&metrics, 1, MB_FC_READ_HOLDING_REGISTERS);
+    TEST_ASSERT_NOT_NULL(s);
+    TEST_ASSERT_EQUAL_UINT32(3, s->requests);
+    TEST_ASSERT_EQUAL_UINT32(1, s->responses);
+    TEST_ASSERT_EQUAL_UINT32(2, s->frame_errors);
+}
+
+void test_recovery_charges_the_failed_attempt_to_the_failing_plan(void) {
+    init_master(4);
+    slave.fail_send_at = 2;
+
+    uint16_t data[6]   = {0};
+    uint8_t quality[6] = {0};
+    int ret            = mb_master_read_optimized_quality(&master, &request, data, 6, quality);
+
+    // The second plan failed to send; the first, abandoned outstanding, is read again
+    TEST_ASSERT_EQUAL(MB_ERROR_PARTIAL_RESULT, ret);
+    TEST_ASSERT_EQUAL_HEX8(MB_QUALITY_GOOD, quality[0]);
+    TEST_ASSERT_EQUAL_HEX8(MB_QUALITY_GOOD, quality[2]);
+    TEST_ASSERT_EQUAL_HEX8(MB_QUALITY_COMM_ERROR, quality[3]);
+    TEST_ASSERT_EQUAL_HEX8(MB_QUALITY_COMM_ERROR, quality[4]);
+    TEST_ASSERT_EQUAL_HEX8(MB_QUALITY_GOOD, quality[5]);
+    TEST_ASSERT_EQUAL_UINT16(2, data[2]);
+    TEST_ASSERT_EQUAL_UINT16(2000, data[5]);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_pipelined_sends_full_window_before_receiving);
+    RUN_TEST(test_pipelined_window_limits_outstanding_requests);
+    RUN_TEST(test_pipelined_reassembles_chunked_stream);
+    RUN_TEST(test_pipelined_results_follow_request_order);
+    RUN_TEST(test_stop_and_wait_by_default);
+    RUN_TEST(test_transaction_id_increments_per_request);
+    RUN_TEST(test_stale_response_is_discarded);
+    RUN_TEST(test_batch_read_spans_slaves_and_function_codes);
+    RUN_TEST(test_vectored_send_hands_over_each_window_fill_at_once);
+    RUN_TEST(test_vectored_send_of_compiled_poll_patches_transaction_ids);
+    RUN_TEST(test_failed_send_abandons_the_window);
+    RUN_TEST(test_failed_vectored_send_abandons_the_window);
+    RUN_TEST(test_mismatched_unit_abandons_the_window);
+    RUN_TEST(test_failed_handler_abandons_the_window);
+    RUN_TEST(test_recovery_charges_the_failed_attempt_to_the_failing_plan);
+
+    return UNITY_END();
+}
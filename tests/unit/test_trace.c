@@ -0,0 +1,157 @@
+/**
+ * @file test_trace.c
+ * @brief Unit tests for hot-path trace hooks (MB_ENABLE_TRACE builds)
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+#include "mock_line.h"
+
+#include <string.h>
+
+#define SEND_US       100u
+#define TURNAROUND_US 1000u
+
+typedef struct {
+    mb_trace_record_t records[64];
+    uint16_t count;
+    uint32_t own_clock;
+} trace_log_t;
+
+static mock_line_t line;
+static trace_log_t trace_log;
+static mb_master_t master;
+
+// send() takes SEND_US, the response takes TURNAROUND_US to arrive
+static void send_time(mock_line_t *l, size_t len) {
+    (void)len;
+    l->clock_us += SEND_US;
+}
+
+static void turnaround(mock_line_t *l, size_t len) {
+    (void)len;
+    l->clock_us += TURNAROUND_US;
+}
+
+static void trace_hook(void *ctx, const mb_trace_record_t *record) {
+    trace_log_t *log = (trace_log_t *)ctx;
+    if (log->count < 64) {
+        log->records[log->count++] = *record;
+    }
+}
+
+static uint32_t trace_clock(void *ctx) {
+    return ++((trace_log_t *)ctx)->own_clock;
+}
+
+static void init_master(bool own_clock) {
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    mock_line_attach(&line, &config);
+    config.transport.clock_us = mock_line_clock;
+    config.trace.hook         = trace_hook;
+    config.trace.clock_us     = own_clock ? trace_clock : NULL;
+    config.trace.context      = &trace_log;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+}
+
+static const mb_trace_record_t *find_event(mb_trace_event_t event, uint16_t nth) {
+    for (uint16_t i = 0; i < trace_log.count; i++) {
+        if (trace_log.records[i].event == event && nth-- == 0) {
+            return &trace_log.records[i];
+        }
+    }
+    return NULL;
+}
+
+void setUp(void) {
+    memset(&line, 0, sizeof(line));
+    line.sent     = send_time;
+    line.received = turnaround;
+    memset(&trace_log, 0, sizeof(trace_log));
+}
+
+void tearDown(void) {
+    mb_master_cleanup(&master);
+}
+
+void test_optimized_read_traces_every_phase_in_order(void) {
+    init_master(false);
+
+    uint16_t addresses[] = {10, 11, 12};
+    uint16_t data[3];
+    mb_read_request_t request = {
+        .slave_id      = 7,
+        .function_code = MB_FC_READ_HOLDING_REGISTERS,
+        .addresses     = addresses,
+        .address_count = 3,
+    };
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request, data, 3));
+
+    const mb_trace_event_t expected[] = {
+        MB_TRACE_OPTIMIZE_BEGIN, MB_TRACE_OPTIMIZE_END, MB_TRACE_BUILD_BEGIN,
+        MB_TRACE_BUILD_END,      MB_TRACE_SEND_BEGIN,   MB_TRACE_SEND_END,
+        MB_TRACE_RECV_FIRST,     MB_TRACE_RECV_LAST,    MB_TRACE_PARSE_BEGIN,
+        MB_TRACE_PARSE_END,      MB_TRACE_SCATTER_BEGIN, MB_TRACE_SCATTER_END,
+    };
+    TEST_ASSERT_EQUAL_UINT16(sizeof(expected) / sizeof(expected[0]), trace_log.count);
+    for (uint16_t i = 0; i < trace_log.count; i++) {
+        TEST_ASSERT_EQUAL_INT(expected[i], trace_log.records[i].event);
+        TEST_ASSERT_EQUAL_UINT8(7, trace_log.records[i].slave_id);
+        TEST_ASSERT_EQUAL_UINT8(MB_FC_READ_HOLDING_REGISTERS, trace_log.records[i].function_code);
+        TEST_ASSERT_EQUAL_INT(MB_SUCCESS, trace_log.records[i].result);
+    }
+
+    TEST_ASSERT_EQUAL_UINT16(1, find_event(MB_TRACE_OPTIMIZE_END, 0)->chars);
+    TEST_ASSERT_EQUAL_UINT16(8, find_event(MB_TRACE_SEND_BEGIN, 0)->chars);
+    TEST_ASSERT_EQUAL_UINT16(11, find_event(MB_TRACE_RECV_LAST, 0)->chars);
+}
+
+void test_timestamps_separate_send_and_device_time(void) {
+    init_master(false);
+
+    uint16_t data[2];
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_single(&master, 1, 3, 0, 2, data));
+
+    uint32_t send_begin = find_event(MB_TRACE_SEND_BEGIN, 0)->timestamp_us;
+    uint32_t send_end   = find_event(MB_TRACE_SEND_END, 0)->timestamp_us;
+    uint32_t first      = find_event(MB_TRACE_RECV_FIRST, 0)->timestamp_us;
+    uint32_t parse_end  = find_event(MB_TRACE_PARSE_END, 0)->timestamp_us;
+
+    TEST_ASSERT_EQUAL_UINT32(SEND_US, send_end - send_begin);
+    TEST_ASSERT_EQUAL_UINT32(TURNAROUND_US, first - send_end);
+    TEST_ASSERT_EQUAL_UINT32(first, parse_end);
+}
+
+void test_own_clock_overrides_transport_clock(void) {
+    init_master(true);
+
+    uint16_t data[1];
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_single(&master, 1, 3, 0, 1, data));
+
+    TEST_ASSERT_TRUE(trace_log.count > 0);
+    for (uint16_t i = 0; i < trace_log.count; i++) {
+        TEST_ASSERT_EQUAL_UINT32(i + 1u, trace_log.records[i].timestamp_us);
+    }
+}
+
+void test_failed_receive_ends_the_trace(void) {
+    init_master(false);
+    master.config.transport.recv = NULL;
+
+    uint16_t data[1];
+    TEST_ASSERT_EQUAL(MB_ERROR_TRANSPORT, mb_master_read_single(&master, 1, 3, 0, 1, data));
+    TEST_ASSERT_NOT_NULL(find_event(MB_TRACE_SEND_END, 0));
+    TEST_ASSERT_NULL(find_event(MB_TRACE_RECV_FIRST, 0));
+    TEST_ASSERT_NULL(find_event(MB_TRACE_PARSE_BEGIN, 0));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_optimized_read_traces_every_phase_in_order);
+    RUN_TEST(test_timestamps_separate_send_and_device_time);
+    RUN_TEST(test_own_clock_overrides_transport_clock);
+    RUN_TEST(test_failed_receive_ends_the_trace);
+
+    return UNITY_END();
+}
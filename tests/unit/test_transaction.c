@@ -0,0 +1,319 @@
+/**
+ * @file test_transaction.c
+ * @brief Unit tests for zero-copy transport buffers in the transaction engine
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+#include "mock_line.h"
+
+#include <string.h>
+
+/**
+ * @brief Transport owning its own TX buffer, and lending the line's RX stream
+ *
+ * The slave answers reads with register value == address + 1, coil a set
+ * when a is a multiple of 3, and echoes writes.
+ */
+typedef struct {
+    uint8_t tx[300];
+    size_t truncate;   // Bytes missing from the end of each response
+    uint8_t exception; // Exception code to answer with (0 = none)
+    size_t reads[8];   // max_len of each recv()
+    int recvs;
+    const uint8_t *last_sent;
+} lending_transport_t;
+
+static mock_line_t line;
+static lending_transport_t transport;
+static mb_master_t master;
+
+static uint16_t slave_value(mock_line_t *l, uint16_t address) {
+    return l->fc == MB_FC_READ_COILS ? (uint16_t)(address % 3 == 0) : (uint16_t)(address + 1);
+}
+
+static bool record_request(mock_line_t *l, const uint8_t *frame, size_t len) {
+    (void)len;
+    transport.last_sent = frame;
+    if (transport.exception == 0) {
+        return false;
+    }
+    mock_line_exception(l, transport.exception);
+    return true;
+}
+
+static void truncate_response(mock_line_t *l, size_t len) {
+    (void)len;
+    l->response_length = (uint16_t)(l->response_length - transport.truncate);
+}
+
+static void record_read(mock_line_t *l, size_t max_len) {
+    (void)l;
+    if (transport.recvs < 8) {
+        transport.reads[transport.recvs] = max_len;
+    }
+    transport.recvs++;
+}
+
+static uint8_t *mock_tx_buffer(void *ctx, size_t *size) {
+    (void)ctx;
+    *size = sizeof(transport.tx);
+    return transport.tx;
+}
+
+static int mock_recv_view(void *ctx, uint8_t **data, size_t *received) {
+    mock_line_t *l = (mock_line_t *)ctx;
+
+    *data          = l->rx;
+    *received      = l->rx_length;
+    l->rx_length   = 0;
+    l->frame_count = 0;
+    return *received > 0 ? 0 : MB_ERROR_TIMEOUT;
+}
+
+static void init_master(mb_mode_t mode, bool lend_rx) {
+    memset(&line, 0, sizeof(line));
+    memset(&transport, 0, sizeof(transport));
+    line.mode      = mode;
+    line.value     = slave_value;
+    line.respond   = record_request;
+    line.sent      = truncate_response;
+    line.receiving = record_read;
+
+    mb_config_t config = mb_config_default(mode);
+    mock_line_attach(&line, &config);
+    config.transport.tx_buffer = mock_tx_buffer;
+    config.transport.recv_view = lend_rx ? mock_recv_view : NULL;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_single_read_encodes_into_lent_buffer(void) {
+    const mb_mode_t modes[] = {MB_MODE_RTU, MB_MODE_ASCII, MB_MODE_TCP};
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        init_master(modes[m], false);
+
+        uint16_t data[3] = {0};
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_single(&master, 1,
+                                                            MB_FC_READ_HOLDING_REGISTERS, 10, 3,
+                                                            data));
+        TEST_ASSERT_EQUAL_PTR(transport.tx, transport.last_sent);
+        TEST_ASSERT_EQUAL_UINT16(11, data[0]);
+        TEST_ASSERT_EQUAL_UINT16(13, data[2]);
+    }
+}
+
+void test_serial_response_parsed_in_transport_buffer(void) {
+    const mb_mode_t modes[] = {MB_MODE_RTU, MB_MODE_ASCII};
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        init_master(modes[m], true);
+
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_write_single_register(&master, 1, 7, 0xBEEF));
+        TEST_ASSERT_EQUAL_PTR(transport.tx, transport.last_sent);
+
+        uint16_t data[2] = {0};
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_single(&master, 1,
+                                                            MB_FC_READ_HOLDING_REGISTERS, 0, 2,
+                                                            data));
+        TEST_ASSERT_EQUAL_UINT16(1, data[0]);
+        TEST_ASSERT_EQUAL_UINT16(2, data[1]);
+    }
+}
+
+void test_optimized_read_uses_lent_buffers(void) {
+    init_master(MB_MODE_RTU, true);
+
+    uint16_t addresses[] = {0, 1, 200};
+    mb_read_request_t request = {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                 .addresses = addresses, .address_count = 3};
+    uint16_t data[3] = {0};
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request, data, 3));
+    TEST_ASSERT_EQUAL(2, line.requests);
+    TEST_ASSERT_EQUAL_PTR(transport.tx, transport.last_sent);
+    TEST_ASSERT_EQUAL_UINT16(1, data[0]);
+    TEST_ASSERT_EQUAL_UINT16(2, data[1]);
+    TEST_ASSERT_EQUAL_UINT16(201, data[2]);
+}
+
+void test_optimized_read_snapshots_whole_device(void) {
+    init_master(MB_MODE_RTU, false);
+
+    static uint16_t addresses[3000];
+    static uint16_t data[3000];
+    for (uint16_t i = 0; i < 3000; i++) {
+        addresses[i] = (uint16_t)(1000 + i);
+    }
+    mb_read_request_t request = {.slave_id = 1, .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                 .addresses = addresses, .address_count = 3000};
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized(&master, &request, data, 3000));
+    for (uint16_t i = 0; i < 3000; i++) {
+        TEST_ASSERT_EQUAL_UINT16(addresses[i] + 1, data[i]);
+    }
+
+#ifndef MB_USE_STATIC_MEMORY
+    // 24 full PDUs over two windows of plans
+    TEST_ASSERT_EQUAL(24, line.requests);
+#endif
+}
+
+void test_optimized_bit_read_fills_packed_bitset(void) {
+    init_master(MB_MODE_TCP, false);
+
+    // Every other coil of 0..3999, in descending order
+    static uint16_t addresses[2000];
+    static uint32_t bits[2000 / 32 + 1];
+    for (uint16_t i = 0; i < 2000; i++) {
+        addresses[i] = (uint16_t)(3998 - 2 * i);
+    }
+    mb_read_request_t request = {.slave_id = 1, .function_code = MB_FC_READ_COILS,
+                                 .addresses = addresses, .address_count = 2000};
+
+    memset(bits, 0xFF, sizeof(bits));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_optimized_bits(&master, &request, bits, 2000));
+    for (uint16_t i = 0; i < 2000; i++) {
+        uint32_t expected = addresses[i] % 3 == 0 ? 1u : 0u;
+        TEST_ASSERT_EQUAL_UINT32(expected, (bits[i / 32] >> (i % 32)) & 1u);
+    }
+
+    // Bits past the request are not touched
+    TEST_ASSERT_EQUAL_HEX32(0xFFFF0000u, bits[2000 / 32] & 0xFFFF0000u);
+
+    TEST_ASSERT_EQUAL(MB_ERROR_BUFFER_TOO_SMALL,
+                      mb_master_read_optimized_bits(&master, &request, bits, 1999));
+    request.function_code = MB_FC_READ_HOLDING_REGISTERS;
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_FC,
+                      mb_master_read_optimized_bits(&master, &request, bits, 2000));
+}
+
+void test_typed_read_converts_into_tag_values(void) {
+    init_master(MB_MODE_TCP, false);
+
+    // Register a holds a + 1
+    uint32_t high_first = 0;
+    uint32_t low_first  = 0;
+    uint64_t wide       = 0;
+    int16_t single      = 0;
+    uint16_t overlap    = 0;
+    mb_typed_tag_t tags[] = {
+        {.address = 100, .type = MB_VALUE_UINT32, .order = MB_ORDER_ABCD, .value = &high_first},
+        {.address = 200, .type = MB_VALUE_UINT32, .order = MB_ORDER_CDAB, .value = &low_first},
+        {.address = 300, .type = MB_VALUE_UINT64, .order = MB_ORDER_ABCD, .value = &wide},
+        {.address = 9000, .type = MB_VALUE_INT16, .order = MB_ORDER_ABCD, .value = &single},
+        {.address = 101, .type = MB_VALUE_UINT16, .order = MB_ORDER_ABCD, .value = &overlap},
+    };
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_master_read_typed(&master, 1, MB_FC_READ_HOLDING_REGISTERS, tags, 5));
+    TEST_ASSERT_EQUAL_HEX32(0x00650066u, high_first);
+    TEST_ASSERT_EQUAL_HEX32(0x00CA00C9u, low_first);
+    TEST_ASSERT_TRUE(wide == 0x012D012E012F0130ULL);
+    TEST_ASSERT_EQUAL_INT16(9001, single);
+    TEST_ASSERT_EQUAL_UINT16(102, overlap);
+
+    tags[0].type = 42;
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM,
+                      mb_master_read_typed(&master, 1, MB_FC_READ_HOLDING_REGISTERS, tags, 5));
+    tags[0].type    = MB_VALUE_UINT32;
+    tags[0].address = 0xFFFF;
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_ADDRESS,
+                      mb_master_read_typed(&master, 1, MB_FC_READ_HOLDING_REGISTERS, tags, 5));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_FC,
+                      mb_master_read_typed(&master, 1, MB_FC_READ_COILS, tags, 5));
+}
+
+void test_rtu_response_assembled_from_chunks(void) {
+    init_master(MB_MODE_RTU, false);
+    line.chunk = 4;
+
+    uint16_t data[10] = {0};
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_single(&master, 1, MB_FC_READ_HOLDING_REGISTERS,
+                                                        0, 10, data));
+    TEST_ASSERT_EQUAL_UINT16(1, data[0]);
+    TEST_ASSERT_EQUAL_UINT16(10, data[9]);
+
+    // 25 bytes in chunks of 4, and no read waiting for the timeout after them
+    TEST_ASSERT_EQUAL(7, transport.recvs);
+}
+
+void test_rtu_exact_reads_stop_at_frame_end(void) {
+    init_master(MB_MODE_RTU, false);
+    master.config.transport.recv_exact = true;
+    line.chunk                         = sizeof(line.rx);
+
+    uint16_t data[10] = {0};
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_single(&master, 1, MB_FC_READ_HOLDING_REGISTERS,
+                                                        0, 10, data));
+    TEST_ASSERT_EQUAL_UINT16(10, data[9]);
+
+    // Header, then exactly the 20 data bytes and the CRC
+    TEST_ASSERT_EQUAL(2, transport.recvs);
+    TEST_ASSERT_EQUAL(3, transport.reads[0]);
+    TEST_ASSERT_EQUAL(22, transport.reads[1]);
+
+    // A write response is known to be 8 bytes from its function code
+    transport.recvs = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_write_single_register(&master, 1, 5, 0x1234));
+    TEST_ASSERT_EQUAL(2, transport.recvs);
+    TEST_ASSERT_EQUAL(5, transport.reads[1]);
+}
+
+void test_rtu_exception_ends_at_its_own_length(void) {
+    init_master(MB_MODE_RTU, false);
+    master.config.transport.recv_exact = true;
+    line.chunk                         = sizeof(line.rx);
+    transport.exception                = MB_EX_ILLEGAL_DATA_ADDRESS;
+
+    // Header, then the 2 CRC bytes: no read for the 25-byte response asked for
+    uint16_t data[10] = {0};
+    TEST_ASSERT_EQUAL(MB_ERROR_EXCEPTION_RESPONSE,
+                      mb_master_read_single(&master, 1, MB_FC_READ_HOLDING_REGISTERS, 0, 10, data));
+    TEST_ASSERT_EQUAL(2, transport.recvs);
+    TEST_ASSERT_EQUAL(3, transport.reads[0]);
+    TEST_ASSERT_EQUAL(2, transport.reads[1]);
+
+    // Without exact reads the frame closes on its fifth byte, not at the timeout
+    master.config.transport.recv_exact = false;
+    line.chunk                         = 2;
+    transport.recvs                    = 0;
+    TEST_ASSERT_EQUAL(MB_ERROR_EXCEPTION_RESPONSE,
+                      mb_master_read_single(&master, 1, MB_FC_READ_HOLDING_REGISTERS, 0, 10, data));
+    TEST_ASSERT_EQUAL(3, transport.recvs);
+}
+
+void test_rtu_truncated_response_is_rejected(void) {
+    init_master(MB_MODE_RTU, false);
+    line.chunk         = 4;
+    transport.truncate = 3;
+
+    // The line goes silent mid-frame: the partial frame fails validation
+    // instead of being reported as a missing response
+    uint16_t data[10] = {0};
+    TEST_ASSERT_EQUAL(MB_ERROR_CRC_MISMATCH,
+                      mb_master_read_single(&master, 1, MB_FC_READ_HOLDING_REGISTERS, 0, 10, data));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_single_read_encodes_into_lent_buffer);
+    RUN_TEST(test_serial_response_parsed_in_transport_buffer);
+    RUN_TEST(test_optimized_read_uses_lent_buffers);
+    RUN_TEST(test_optimized_read_snapshots_whole_device);
+    RUN_TEST(test_optimized_bit_read_fills_packed_bitset);
+    RUN_TEST(test_typed_read_converts_into_tag_values);
+    RUN_TEST(test_rtu_response_assembled_from_chunks);
+    RUN_TEST(test_rtu_exact_reads_stop_at_frame_end);
+    RUN_TEST(test_rtu_exception_ends_at_its_own_length);
+    RUN_TEST(test_rtu_truncated_response_is_rejected);
+
+    return UNITY_END();
+}
@@ -0,0 +1,91 @@
+/**
+ * @file test_work_pool.c
+ * @brief Unit tests for the work-stealing pool
+ */
+
+#include "unity.h"
+#include "utils/work_pool.h"
+#include "smartmodbus/mb_error.h"
+
+#include <string.h>
+
+#define JOBS 1000
+
+static int runs[JOBS];
+static uint8_t ran_on[JOBS];
+
+void setUp(void) {
+    memset(runs, 0, sizeof(runs));
+    memset(ran_on, 0, sizeof(ran_on));
+}
+
+void tearDown(void) {
+}
+
+static int count_job(void *context, uint8_t worker, uint32_t job) {
+    (void)context;
+    runs[job]++;
+    ran_on[job] = worker;
+
+    // Uneven jobs: the first range is far longer than the others
+    volatile uint32_t spin = job < JOBS / 4 ? 20000u : 10u;
+    while (spin > 0) {
+        spin--;
+    }
+    return MB_SUCCESS;
+}
+
+static int fail_job(void *context, uint8_t worker, uint32_t job) {
+    (void)worker;
+    const uint32_t *failing = (const uint32_t *)context;
+    runs[job]++;
+    if (job == failing[0]) {
+        return MB_ERROR_TIMEOUT;
+    }
+    if (job == failing[1]) {
+        return MB_ERROR_NO_MEMORY;
+    }
+    return MB_SUCCESS;
+}
+
+void test_every_job_runs_exactly_once(void) {
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_work_run(JOBS, 4, count_job, NULL));
+
+    for (uint32_t i = 0; i < JOBS; i++) {
+        TEST_ASSERT_EQUAL_INT(1, runs[i]);
+        TEST_ASSERT_TRUE(ran_on[i] < 4);
+    }
+}
+
+void test_more_workers_than_jobs(void) {
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_work_run(3, 16, count_job, NULL));
+    TEST_ASSERT_EQUAL_INT(1, runs[0]);
+    TEST_ASSERT_EQUAL_INT(1, runs[1]);
+    TEST_ASSERT_EQUAL_INT(1, runs[2]);
+    TEST_ASSERT_EQUAL_INT(0, runs[3]);
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_work_run(0, 4, count_job, NULL));
+}
+
+void test_lowest_failed_job_is_reported(void) {
+    // Job 900 fails first in time on another worker, job 10 is lower
+    uint32_t failing[2] = {900, 10};
+    TEST_ASSERT_EQUAL(MB_ERROR_NO_MEMORY, mb_work_run(JOBS, 4, fail_job, failing));
+
+    // Serial runs stop at the first failure
+    memset(runs, 0, sizeof(runs));
+    TEST_ASSERT_EQUAL(MB_ERROR_NO_MEMORY, mb_work_run(JOBS, 1, fail_job, failing));
+    TEST_ASSERT_EQUAL_INT(0, runs[11]);
+
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_work_run(JOBS, 4, NULL, NULL));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_every_job_runs_exactly_once);
+    RUN_TEST(test_more_workers_than_jobs);
+    RUN_TEST(test_lowest_failed_job_is_reported);
+
+    return UNITY_END();
+}
@@ -0,0 +1,392 @@
+/**
+ * @file test_write_queue.c
+ * @brief Unit tests for the coalescing write queue
+ */
+
+#include "unity.h"
+#include "smartmodbus/smartmodbus.h"
+#include "mock_line.h"
+
+#include <string.h>
+
+/**
+ * @brief RTU slaves applying FC05/06/15/16 writes to their own memory
+ *
+ * FC03 and FC23 read that memory back through the line's value() hook. The
+ * slave listed in failing_slave answers with SLAVE DEVICE FAILURE, and FC23
+ * is refused with ILLEGAL FUNCTION while reject_fc23 is set. A write to
+ * unit 0 is applied by slaves 1 and 2 without an answer; turnaround sums
+ * the delay_chars waits.
+ */
+typedef struct {
+    uint16_t registers[3][400];
+    bool coils[3][200];
+    uint16_t log_quantity[16]; /**< Quantity of each request (1 for FC05/06) */
+    uint8_t failing_slave;
+    bool reject_fc23;
+    uint32_t turnaround;
+} mock_bus_t;
+
+static mock_line_t line;
+static mock_bus_t bus;
+
+static void apply_write(mock_bus_t *b, uint8_t unit, uint8_t fc, const uint8_t *pdu, uint16_t qty) {
+    uint16_t address = (uint16_t)((pdu[0] << 8) | pdu[1]);
+    uint16_t word    = (uint16_t)((pdu[2] << 8) | pdu[3]);
+
+    switch (fc) {
+    case MB_FC_WRITE_SINGLE_COIL:
+        b->coils[unit][address] = word == 0xFF00;
+        break;
+    case MB_FC_WRITE_SINGLE_REGISTER:
+        b->registers[unit][address] = word;
+        break;
+    case MB_FC_WRITE_MULTIPLE_COILS:
+        TEST_ASSERT_EQUAL_UINT8((qty + 7) / 8, pdu[4]);
+        for (uint16_t i = 0; i < qty; i++) {
+            b->coils[unit][address + i] = (pdu[5 + i / 8] >> (i % 8)) & 1;
+        }
+        break;
+    case MB_FC_WRITE_MULTIPLE_REGISTERS:
+        TEST_ASSERT_EQUAL_UINT8(qty * 2, pdu[4]);
+        for (uint16_t i = 0; i < qty; i++) {
+            b->registers[unit][address + i] = (uint16_t)((pdu[5 + 2 * i] << 8) | pdu[6 + 2 * i]);
+        }
+        break;
+    default:
+        TEST_FAIL_MESSAGE("unexpected function code");
+    }
+}
+
+static uint16_t read_memory(mock_line_t *l, uint16_t address) {
+    return bus.registers[l->unit][address];
+}
+
+static bool serve(mock_line_t *l, const uint8_t *frame, size_t len) {
+    (void)frame;
+    (void)len;
+    TEST_ASSERT_TRUE(l->unit < 3);
+
+    uint8_t fc   = l->fc;
+    uint16_t qty = (fc == MB_FC_WRITE_SINGLE_COIL || fc == MB_FC_WRITE_SINGLE_REGISTER)
+                       ? 1
+                       : l->quantity;
+    if (l->requests <= 16) {
+        bus.log_quantity[l->requests - 1] = qty;
+    }
+
+    if (l->unit == bus.failing_slave) {
+        mock_line_exception(l, MB_EX_SLAVE_DEVICE_FAILURE);
+        return true;
+    }
+    if (fc == MB_FC_READ_WRITE_MULTIPLE_REGISTERS && bus.reject_fc23) {
+        mock_line_exception(l, MB_EX_ILLEGAL_FUNCTION);
+        return true;
+    }
+
+    if (l->unit == 0) {
+        TEST_ASSERT_TRUE(fc != MB_FC_READ_HOLDING_REGISTERS &&
+                         fc != MB_FC_READ_WRITE_MULTIPLE_REGISTERS);
+        apply_write(&bus, 1, fc, l->pdu, qty);
+        apply_write(&bus, 2, fc, l->pdu, qty);
+        return true;
+    }
+
+    if (fc == MB_FC_READ_WRITE_MULTIPLE_REGISTERS) {
+        // Write range first; the line then answers the read
+        const uint8_t *pdu     = l->pdu;
+        uint16_t write_address = (uint16_t)((pdu[4] << 8) | pdu[5]);
+        uint16_t write_qty     = (uint16_t)((pdu[6] << 8) | pdu[7]);
+        TEST_ASSERT_EQUAL_UINT8(write_qty * 2, pdu[8]);
+        for (uint16_t i = 0; i < write_qty; i++) {
+            bus.registers[l->unit][write_address + i] =
+                (uint16_t)((pdu[9 + 2 * i] << 8) | pdu[10 + 2 * i]);
+        }
+    } else if (fc != MB_FC_READ_HOLDING_REGISTERS) {
+        apply_write(&bus, l->unit, fc, l->pdu, qty);
+    }
+    return false;
+}
+
+static void mock_delay(void *ctx, uint16_t chars) {
+    (void)ctx;
+    bus.turnaround += chars;
+}
+
+static mb_master_t master;
+static mb_write_entry_t entries[320];
+static mb_write_queue_t queue;
+static mb_slave_profile_t profile_entries[4];
+static mb_profile_table_t profiles;
+
+void setUp(void) {
+    memset(&line, 0, sizeof(line));
+    memset(&bus, 0, sizeof(bus));
+    line.value        = read_memory;
+    line.respond      = serve;
+    bus.failing_slave = 0xFF;
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_profiles_init(&profiles, profile_entries, 4, 573));
+
+    mb_config_t config = mb_config_default(MB_MODE_RTU);
+    mock_line_attach(&line, &config);
+    config.transport.delay_chars = mock_delay;
+    config.profiles              = &profiles;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_init(&master, &config));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_write_queue_init(&queue, entries, 320));
+}
+
+void tearDown(void) {
+}
+
+void test_contiguous_writes_share_a_frame(void) {
+    mb_write_queue_register(&queue, 1, 12, 3);
+    mb_write_queue_register(&queue, 1, 10, 1);
+    mb_write_queue_register(&queue, 2, 10, 7);
+    mb_write_queue_register(&queue, 1, 11, 2);
+    mb_write_queue_register(&queue, 1, 14, 5);
+    mb_write_queue_register(&queue, 1, 11, 20);  // Last write wins
+
+    uint16_t frames = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_flush_writes(&master, &queue, &frames));
+    TEST_ASSERT_EQUAL_UINT16(3, frames);
+    TEST_ASSERT_EQUAL_UINT16(0, queue.count);
+
+    // 10-12 as one FC16, the lone 14 as FC06, then slave 2
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_WRITE_MULTIPLE_REGISTERS, line.fcs[0]);
+    TEST_ASSERT_EQUAL_UINT16(3, bus.log_quantity[0]);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_WRITE_SINGLE_REGISTER, line.fcs[1]);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_WRITE_SINGLE_REGISTER, line.fcs[2]);
+
+    TEST_ASSERT_EQUAL_UINT16(1, bus.registers[1][10]);
+    TEST_ASSERT_EQUAL_UINT16(20, bus.registers[1][11]);
+    TEST_ASSERT_EQUAL_UINT16(3, bus.registers[1][12]);
+    TEST_ASSERT_EQUAL_UINT16(0, bus.registers[1][13]);
+    TEST_ASSERT_EQUAL_UINT16(5, bus.registers[1][14]);
+    TEST_ASSERT_EQUAL_UINT16(7, bus.registers[2][10]);
+}
+
+void test_long_runs_split_at_the_fc16_limit(void) {
+    for (uint16_t i = 0; i < 300; i++) {
+        TEST_ASSERT_EQUAL(MB_SUCCESS, mb_write_queue_register(&queue, 1, i, (uint16_t)(i * 3)));
+    }
+
+    uint16_t frames = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_flush_writes(&master, &queue, &frames));
+    TEST_ASSERT_EQUAL_UINT16(3, frames);
+    TEST_ASSERT_EQUAL_UINT16(123, bus.log_quantity[0]);
+    TEST_ASSERT_EQUAL_UINT16(123, bus.log_quantity[1]);
+    TEST_ASSERT_EQUAL_UINT16(54, bus.log_quantity[2]);
+    for (uint16_t i = 0; i < 300; i++) {
+        TEST_ASSERT_EQUAL_UINT16(i * 3, bus.registers[1][i]);
+    }
+}
+
+void test_coils_pack_into_fc15(void) {
+    for (uint16_t i = 0; i < 20; i++) {
+        mb_write_queue_coil(&queue, 1, (uint16_t)(40 + i), (i % 3) == 0);
+    }
+    mb_write_queue_coil(&queue, 1, 100, true);
+    mb_write_queue_register(&queue, 1, 40, 9);  // Separate address space
+
+    uint16_t frames = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_flush_writes(&master, &queue, &frames));
+    TEST_ASSERT_EQUAL_UINT16(3, frames);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_WRITE_MULTIPLE_COILS, line.fcs[0]);
+    TEST_ASSERT_EQUAL_UINT16(20, bus.log_quantity[0]);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_WRITE_SINGLE_COIL, line.fcs[1]);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_WRITE_SINGLE_REGISTER, line.fcs[2]);
+
+    for (uint16_t i = 0; i < 20; i++) {
+        TEST_ASSERT_EQUAL((i % 3) == 0, bus.coils[1][40 + i]);
+    }
+    TEST_ASSERT_TRUE(bus.coils[1][100]);
+    TEST_ASSERT_EQUAL_UINT16(9, bus.registers[1][40]);
+}
+
+void test_failed_frame_keeps_unsent_writes(void) {
+    mb_write_queue_register(&queue, 2, 5, 50);
+    mb_write_queue_register(&queue, 1, 5, 10);
+    mb_write_queue_register(&queue, 2, 6, 60);
+    bus.failing_slave = 2;
+
+    uint16_t frames = 0;
+    TEST_ASSERT_EQUAL(MB_ERROR_EXCEPTION_RESPONSE, mb_master_flush_writes(&master, &queue, &frames));
+    TEST_ASSERT_EQUAL_UINT16(1, frames);
+    TEST_ASSERT_EQUAL_UINT16(2, queue.count);
+    TEST_ASSERT_EQUAL_UINT8(2, entries[0].slave_id);
+
+    bus.failing_slave = 0xFF;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_flush_writes(&master, &queue, &frames));
+    TEST_ASSERT_EQUAL_UINT16(1, frames);
+    TEST_ASSERT_EQUAL_UINT16(50, bus.registers[2][5]);
+    TEST_ASSERT_EQUAL_UINT16(60, bus.registers[2][6]);
+}
+
+void test_queue_limits(void) {
+    mb_write_queue_t small;
+    mb_write_entry_t storage[2];
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_write_queue_init(&small, storage, 2));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_write_queue_register(&small, 1, 0, 0));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_write_queue_coil(&small, 1, 0, true));
+    TEST_ASSERT_EQUAL(MB_ERROR_TOO_MANY_BLOCKS, mb_write_queue_register(&small, 1, 1, 0));
+    mb_write_queue_clear(&small);
+    TEST_ASSERT_EQUAL_UINT16(0, small.count);
+
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_write_queue_init(NULL, storage, 2));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_PARAM, mb_master_flush_writes(&master, NULL, NULL));
+
+    // Nothing queued: nothing sent
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_flush_writes(&master, &queue, NULL));
+    TEST_ASSERT_EQUAL_UINT16(0, line.requests);
+}
+
+void test_write_multiple_coils(void) {
+    bool values[10] = {true, false, true, true, false, false, false, false, true, true};
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_write_multiple_coils(&master, 1, 3, 10, values));
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_WRITE_MULTIPLE_COILS, line.fcs[0]);
+    for (uint16_t i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL(values[i], bus.coils[1][3 + i]);
+    }
+
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_QUANTITY,
+                      mb_master_write_multiple_coils(&master, 1, 0, 0, values));
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_QUANTITY,
+                      mb_master_write_multiple_coils(&master, 1, 0, 1969, values));
+}
+
+static uint16_t cycle_addresses[] = {100, 101, 102, 103, 104, 110};
+static const mb_read_request_t cycle_read = {.slave_id      = 1,
+                                             .function_code = MB_FC_READ_HOLDING_REGISTERS,
+                                             .addresses     = cycle_addresses,
+                                             .address_count = 6};
+
+static void queue_setpoints(void) {
+    for (uint16_t i = 0; i < 3; i++) {
+        mb_write_queue_register(&queue, 1, (uint16_t)(101 + i), (uint16_t)(1000 + i));
+    }
+}
+
+void test_write_read_fuses_into_fc23(void) {
+    uint16_t data[6];
+    bus.registers[1][110] = 77;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_profile_set_fc23(&profiles, 1, MB_FC23_SUPPORTED));
+
+    queue_setpoints();
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_write_read(&master, &queue, &cycle_read, data, 6));
+    TEST_ASSERT_EQUAL_UINT16(1, line.requests);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_READ_WRITE_MULTIPLE_REGISTERS, line.fcs[0]);
+    TEST_ASSERT_EQUAL_UINT16(0, queue.count);
+
+    // The read sees the values just written
+    uint16_t expected[] = {0, 1000, 1001, 1002, 0, 77};
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, data, 6);
+}
+
+void test_rejected_fc23_falls_back_and_is_learned(void) {
+    uint16_t data[6];
+    mb_profile_set_fc23(&profiles, 1, MB_FC23_SUPPORTED);
+    bus.reject_fc23 = true;
+
+    queue_setpoints();
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_write_read(&master, &queue, &cycle_read, data, 6));
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_WRITE_MULTIPLE_REGISTERS, line.fcs[1]);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_READ_HOLDING_REGISTERS, line.fcs[2]);
+    TEST_ASSERT_EQUAL_UINT16(1001, data[2]);
+    TEST_ASSERT_EQUAL(MB_FC23_UNSUPPORTED, mb_profile_fc23(&profiles, 1));
+
+    // Next cycle: no more attempts
+    line.requests = 0;
+    queue_setpoints();
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_write_read(&master, &queue, &cycle_read, data, 6));
+    TEST_ASSERT_EQUAL_UINT16(2, line.requests);
+}
+
+void test_unknown_slaves_are_not_fused(void) {
+    uint16_t data[6];
+    queue_setpoints();
+    mb_write_queue_register(&queue, 2, 101, 5);  // Other slave: plain FC06
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_write_read(&master, &queue, &cycle_read, data, 6));
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_WRITE_MULTIPLE_REGISTERS, line.fcs[0]);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_WRITE_SINGLE_REGISTER, line.fcs[1]);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_READ_HOLDING_REGISTERS, line.fcs[2]);
+    TEST_ASSERT_EQUAL(MB_FC23_UNKNOWN, mb_profile_fc23(&profiles, 1));
+}
+
+void test_broadcast_write_is_not_awaited(void) {
+    uint16_t values[3] = {7, 8, 9};
+
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_master_write_single_register(&master, MB_BROADCAST_ID, 10, 77));
+    TEST_ASSERT_EQUAL(MB_SUCCESS,
+                      mb_master_write_multiple_registers(&master, MB_BROADCAST_ID, 20, 3, values));
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_write_single_coil(&master, MB_BROADCAST_ID, 5, true));
+
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+    for (uint8_t unit = 1; unit <= 2; unit++) {
+        TEST_ASSERT_EQUAL_UINT16(77, bus.registers[unit][10]);
+        TEST_ASSERT_EQUAL_UINT16_ARRAY(values, &bus.registers[unit][20], 3);
+        TEST_ASSERT_TRUE(bus.coils[unit][5]);
+    }
+
+    // Each broadcast held the line for the turnaround and nothing was received
+    mb_stats_t stats;
+    mb_master_get_stats(&master, &stats);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.broadcasts);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.total_chars_recv);
+    TEST_ASSERT_EQUAL_UINT32(3 * 175, bus.turnaround);
+}
+
+void test_broadcast_queue_verified_by_batch_read(void) {
+    mb_write_queue_register(&queue, MB_BROADCAST_ID, 100, 1);
+    mb_write_queue_register(&queue, MB_BROADCAST_ID, 101, 2);
+    mb_write_queue_register(&queue, MB_BROADCAST_ID, 102, 3);
+
+    uint16_t frames = 0;
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_flush_writes(&master, &queue, &frames));
+    TEST_ASSERT_EQUAL_UINT16(1, frames);
+    TEST_ASSERT_EQUAL_UINT8(MB_FC_WRITE_MULTIPLE_REGISTERS, line.fcs[0]);
+
+    // Read back later: one FC03 per slave for the whole setpoint group
+    mb_tag_t tags[6];
+    for (uint16_t i = 0; i < 6; i++) {
+        tags[i] = (mb_tag_t){(uint8_t)(1 + i / 3), MB_FC_READ_HOLDING_REGISTERS,
+                             (uint16_t)(100 + i % 3)};
+    }
+    uint16_t data[6];
+    uint16_t expected[6] = {1, 2, 3, 1, 2, 3};
+    TEST_ASSERT_EQUAL(MB_SUCCESS, mb_master_read_batch(&master, tags, 6, data, 6));
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(expected, data, 6);
+    TEST_ASSERT_EQUAL_UINT16(3, line.requests);
+}
+
+void test_broadcast_reads_are_rejected(void) {
+    uint16_t value = 0;
+
+    TEST_ASSERT_EQUAL(MB_ERROR_INVALID_ADDRESS,
+                      mb_master_read_single(&master, MB_BROADCAST_ID, MB_FC_READ_HOLDING_REGISTERS,
+                                            0, 1, &value));
+    TEST_ASSERT_EQUAL_UINT16(0, line.requests);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_contiguous_writes_share_a_frame);
+    RUN_TEST(test_long_runs_split_at_the_fc16_limit);
+    RUN_TEST(test_coils_pack_into_fc15);
+    RUN_TEST(test_failed_frame_keeps_unsent_writes);
+    RUN_TEST(test_queue_limits);
+    RUN_TEST(test_write_multiple_coils);
+    RUN_TEST(test_write_read_fuses_into_fc23);
+    RUN_TEST(test_rejected_fc23_falls_back_and_is_learned);
+    RUN_TEST(test_unknown_slaves_are_not_fused);
+    RUN_TEST(test_broadcast_write_is_not_awaited);
+    RUN_TEST(test_broadcast_queue_verified_by_batch_read);
+    RUN_TEST(test_broadcast_reads_are_rejected);
+
+    return UNITY_END();
+}